@@ -194,6 +194,8 @@ koverReport {
 
 // Compile GLSL shaders to SPIR-V and generate a C++ header with arrays used by renderer_vulkan
 val generateVulkanShaders = tasks.register("generateVulkanShaders") {
+    inputs.dir("src/main/assets/shaders/vulkan")
+    outputs.dir("src/main/cpp/generated")
     doLast {
         val ndk = android.ndkPath ?: System.getenv("ANDROID_NDK")
         if (ndk == null) {
@@ -204,13 +206,31 @@ val generateVulkanShaders = tasks.register("generateVulkanShaders") {
         val outDir = file("src/main/cpp/generated")
         outDir.mkdirs()
 
-        val vertIn = file(shaderDir.toString() + "/passthrough.vert")
-        val fragIn = file(shaderDir.toString() + "/chromatic_aberration.frag")
-        val vertSpv = file(outDir.toString() + "/passthrough.vert.spv")
-        val fragSpv = file(outDir.toString() + "/chromatic_aberration.frag.spv")
-
-        project.exec { commandLine = listOf(glslc, vertIn.absolutePath, "-o", vertSpv.absolutePath) }
-        project.exec { commandLine = listOf(glslc, fragIn.absolutePath, "-o", fragSpv.absolutePath) }
+        // Shader source -> VulkanRenderer static member holding its SPIR-V, plus any
+        // preprocessor defines for variants built from the same source
+        val shaders = listOf(
+            Triple("passthrough.vert", "VulkanRenderer::kVertSpv", emptyList<String>()),
+            Triple("effect_chain.frag", "VulkanRenderer::kFragSpv", emptyList()),
+            Triple("effect_chain.frag", "VulkanRenderer::kChainSubpassFragSpv", listOf("SUBPASS_INPUT")),
+            Triple("soften.frag", "VulkanRenderer::kBlurFragSpv", emptyList()),
+            Triple("chromatic_aberration.frag", "VulkanRenderer::kChromaticFragSpv", emptyList()),
+            Triple("sharpen.frag", "VulkanRenderer::kSharpenFragSpv", emptyList()),
+            Triple("analysis.frag", "VulkanRenderer::kAnalysisFragSpv", emptyList()),
+            Triple("blur_down.frag", "VulkanRenderer::kBlurDownFragSpv", emptyList()),
+            Triple("blur_down.frag", "VulkanRenderer::kBloomPrefilterFragSpv", listOf("BLOOM_PREFILTER")),
+            Triple("blur_up.frag", "VulkanRenderer::kBlurUpFragSpv", emptyList()),
+            Triple("glass.frag", "VulkanRenderer::kGlassFragSpv", emptyList())
+        )
+        val compiled = shaders.map { (source, symbol, defines) ->
+            val input = file(shaderDir.toString() + "/" + source)
+            val stem = if (defines.isEmpty()) source else symbol.substringAfter("::")
+            val spv = file(outDir.toString() + "/" + stem + ".spv")
+            project.exec {
+                commandLine = listOf(glslc) + defines.map { "-D$it" } +
+                    listOf(input.absolutePath, "-o", spv.absolutePath)
+            }
+            Triple(symbol, source, spv)
+        }
 
         fun writeArray(name: String, spv: File): String {
             val bytes = spv.readBytes()
@@ -232,14 +252,121 @@ val generateVulkanShaders = tasks.register("generateVulkanShaders") {
 
         val header = File(outDir, "shaders_generated.h")
         header.writeText("#pragma once\n#include <array>\n#include <cstdint>\n\n")
-        header.appendText(writeArray("VulkanRenderer::kVertSpv", vertSpv))
-        header.appendText(writeArray("VulkanRenderer::kFragSpv", fragSpv))
+        compiled.forEach { (symbol, _, spv) -> header.appendText(writeArray(symbol, spv)) }
+
+        // Uniform and push-constant blocks as the compiler laid them out, for the
+        // compile-time checks on the C++ structs that mirror them (gpu_layout.h).
+        fun reflectBlocks(spv: File): List<String> {
+            val bytes = spv.readBytes()
+            val words = IntArray(bytes.size / 4) { i ->
+                (bytes[i * 4].toInt() and 0xFF) or
+                    ((bytes[i * 4 + 1].toInt() and 0xFF) shl 8) or
+                    ((bytes[i * 4 + 2].toInt() and 0xFF) shl 16) or
+                    ((bytes[i * 4 + 3].toInt() and 0xFF) shl 24)
+            }
+            // Nul-terminated UTF-8 packed four bytes to a word.
+            fun literal(from: Int, end: Int): String {
+                val sb = StringBuilder()
+                for (w in from until end) for (b in 0 until 4) {
+                    val c = (words[w] ushr (8 * b)) and 0xFF
+                    if (c == 0) return sb.toString()
+                    sb.append(c.toChar())
+                }
+                return sb.toString()
+            }
+
+            val names = mutableMapOf<Int, String>()
+            val memberNames = mutableMapOf<Pair<Int, Int>, String>()
+            val offsets = mutableMapOf<Pair<Int, Int>, Int>()
+            val strides = mutableMapOf<Int, Int>()
+            val blocks = mutableSetOf<Int>()
+            val types = mutableMapOf<Int, IntArray>()
+            val constants = mutableMapOf<Int, Int>()
+            val variables = mutableListOf<Pair<Int, Int>>()
+            var at = 5 // past the module header
+            while (at < words.size) {
+                val count = words[at] ushr 16
+                val end = at + count
+                when (words[at] and 0xFFFF) {
+                    5 -> names[words[at + 1]] = literal(at + 2, end)                          // OpName
+                    6 -> memberNames[words[at + 1] to words[at + 2]] = literal(at + 3, end)   // OpMemberName
+                    71 -> when (words[at + 2]) {                                              // OpDecorate
+                        2 -> blocks.add(words[at + 1])                                        // Block
+                        6 -> strides[words[at + 1]] = words[at + 3]                           // ArrayStride
+                    }
+                    72 -> if (words[at + 3] == 35) offsets[words[at + 1] to words[at + 2]] = words[at + 4] // Offset
+                    in 20..32 -> types[words[at + 1]] = words.copyOfRange(at, end)             // OpTypeBool..OpTypePointer
+                    43 -> constants[words[at + 2]] = words[at + 3]                             // OpConstant
+                    59 -> variables.add(words[at + 1] to words[at + 3])                        // OpVariable
+                }
+                if (count == 0) break
+                at = end
+            }
+
+            fun opOf(type: Int) = types.getValue(type)[0] and 0xFFFF
+            fun sizeOf(type: Int): Int {
+                val t = types.getValue(type)
+                return when (opOf(type)) {
+                    20 -> 4
+                    21, 22 -> t[2] / 8
+                    23 -> t[3] * sizeOf(t[2])
+                    24 -> t[3] * 16
+                    28 -> constants.getValue(t[3]) * (strides[type] ?: sizeOf(t[2]))
+                    30 -> if (t.size == 2) 0 else offsets.getValue(type to t.size - 3) + sizeOf(t[t.size - 1])
+                    else -> 0
+                }
+            }
+
+            val out = mutableListOf<String>()
+            val emitted = mutableSetOf<Int>()
+            fun emit(struct: Int) {
+                if (!emitted.add(struct)) return
+                val t = types.getValue(struct)
+                val memberCount = t.size - 2
+                // Nested structs first, so the header reads top-down.
+                for (m in 0 until memberCount) {
+                    var element = t[2 + m]
+                    while (opOf(element) == 28) element = types.getValue(element)[2]
+                    if (opOf(element) == 30) emit(element)
+                }
+                val members = (0 until memberCount).joinToString("\n") { m ->
+                    val type = t[2 + m]
+                    val stride = if (opOf(type) == 28) strides[type] ?: 0 else 0
+                    "    {\"${memberNames[struct to m]}\", ${offsets[struct to m]}, ${sizeOf(type)}, $stride},"
+                }
+                val name = names.getValue(struct)
+                out.add("constexpr BlockLayout<$memberCount> $name{\"$name\", ${sizeOf(struct)}, {{\n$members\n}}};\n")
+            }
+            for ((pointer, storage) in variables) {
+                if (storage != 2 && storage != 9) continue // Uniform, PushConstant
+                val pointee = types.getValue(pointer)[3]
+                if (pointee in blocks) emit(pointee)
+            }
+            return out
+        }
+
+        val layouts = StringBuilder()
+        layouts.append("// Reflected from the SPIR-V by generateVulkanShaders; do not edit.\n")
+        layouts.append("#pragma once\n#include \"gpu_layout.h\"\n\nnamespace lumina::shader_layout {\n")
+        compiled.distinctBy { it.second }.forEach { (_, source, spv) ->
+            val blocks = reflectBlocks(spv)
+            if (blocks.isEmpty()) return@forEach
+            layouts.append("\nnamespace ${source.substringBefore('.')} {\n")
+            blocks.forEach { layouts.append(it) }
+            layouts.append("} // namespace ${source.substringBefore('.')}\n")
+        }
+        layouts.append("\n} // namespace lumina::shader_layout\n")
+        File(outDir, "shader_layouts_generated.h").writeText(layouts.toString())
     }
 }
 
-// Ensure shader generation runs before native build (externalNativeBuild tasks)
+// Shader generation (SPIR-V and reflected layouts) runs before the native build:
+// renderer_vulkan.cpp does not compile without its headers, which are not checked in.
+// CMake configure and compile are tasks of their own that externalNativeBuild only
+// depends on, so each is ordered explicitly.
 tasks.whenTaskAdded {
-    if (name.startsWith("externalNativeBuild")) {
+    if (name.startsWith("externalNativeBuild") || name.startsWith("configureCMake") ||
+        name.startsWith("buildCMake")) {
         dependsOn(generateVulkanShaders)
     }
 }
@@ -24,6 +24,12 @@
     native <methods>;
 }
 
+# Called from native code by name
+-keep interface com.lumina.engine.NativeEngine$ReadyListener { *; }
+-keepclassmembers class * implements com.lumina.engine.NativeEngine$ReadyListener {
+    void onEngineReady(boolean);
+}
+
 # Chaquopy Python
 -keep class com.chaquo.python.** { *; }
 -dontwarn com.chaquo.python.**
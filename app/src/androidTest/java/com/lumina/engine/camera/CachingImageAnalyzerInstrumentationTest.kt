@@ -3,12 +3,10 @@ package com.lumina.engine.camera
 import androidx.camera.testing.fakes.FakeImageInfo
 import androidx.camera.testing.fakes.FakeImageProxy
 import androidx.test.ext.junit.runners.AndroidJUnit4
-import androidx.test.platform.app.InstrumentationRegistry
-import com.lumina.engine.DirectBufferPool
-import com.lumina.engine.INativeEngine
 import com.lumina.engine.CachingImageAnalyzer
-import org.junit.Assert.assertSame
-import org.junit.Assert.assertNotSame
+import com.lumina.engine.FrameSlotPool
+import org.junit.Assert.assertEquals
+import org.junit.Assert.assertNull
 import org.junit.Assert.assertTrue
 import org.junit.Test
 import org.junit.runner.RunWith
@@ -16,63 +14,83 @@ import java.nio.ByteBuffer
 
 @RunWith(AndroidJUnit4::class)
 class CachingImageAnalyzerInstrumentationTest {
-    class FakeNativeEngine : INativeEngine {
-        var lastBuffer: ByteBuffer? = null
-        var lastWidth: Int = 0
-        var lastHeight: Int = 0
-        override fun getVideoTextureId(): Int = 0
-        override fun uploadCameraFrame(buffer: ByteBuffer, width: Int, height: Int) {
-            lastBuffer = buffer
-            lastWidth = width
-            lastHeight = height
+    /** Stands in for lumina::FramePool; submitted slots stay out until [completeUploads]. */
+    class FakeBackend : FrameSlotPool.Backend {
+        var buffers = emptyList<ByteBuffer>()
+        val acquired = mutableSetOf<Int>()
+        val uploading = mutableListOf<Int>()
+        val submitted = mutableListOf<Triple<Int, Int, Int>>()
+
+        override fun configure(slotCount: Int, slotBytes: Int): Boolean {
+            if (acquired.isNotEmpty()) return false
+            buffers = List(slotCount) { ByteBuffer.allocateDirect(slotBytes) }
+            return true
         }
-    }
 
-    @Test
-    fun poolingReusesBufferForSameSize() {
-        val native = FakeNativeEngine()
-        val analyzer = CachingImageAnalyzer { buffer, w, h -> native.uploadCameraFrame(buffer, w, h) }
+        override fun acquire(): Int {
+            val index = buffers.indices.firstOrNull { it !in acquired } ?: return -1
+            acquired += index
+            return index
+        }
 
-        val width = 64
-        val height = 64
-        val byteCount = width * height * 4
+        override fun buffer(index: Int): ByteBuffer? = buffers.getOrNull(index)
 
-        // ensure there's an initial pooled buffer
-        val poolBuf1 = DirectBufferPool.getDirectBuffer(byteCount)
+        override fun submit(index: Int, size: Int, width: Int, height: Int) {
+            submitted += Triple(index, size, width * height)
+            uploading += index
+        }
+
+        override fun release(index: Int) {
+            acquired -= index
+        }
 
+        fun completeUploads() {
+            acquired -= uploading.toSet()
+            uploading.clear()
+        }
+    }
+
+    private fun frame(width: Int, height: Int, timestamp: Long = 1L): FakeImageProxy {
+        val byteCount = width * height * 4
         val buffer = ByteBuffer.allocate(byteCount)
         for (i in 0 until byteCount) buffer.put(i.toByte())
         buffer.rewind()
-
-        val img = FakeImageProxy(buffer, width, height, FakeImageInfo(1L, 0L))
-        analyzer.analyze(img)
-
-        val poolBuf2 = DirectBufferPool.getDirectBuffer(byteCount)
-        // verify pool buffer hadn't reallocated
-        assertSame(poolBuf1, poolBuf2)
+        return FakeImageProxy(buffer, width, height, FakeImageInfo(timestamp, 0L))
     }
 
     @Test
-    fun poolingExpandsOnLargerSize() {
-        val native = FakeNativeEngine()
-        val analyzer = CachingImageAnalyzer { buffer, w, h -> native.uploadCameraFrame(buffer, w, h) }
+    fun rgbaFramesAreSubmittedFromFrameSlots() {
+        val backend = FakeBackend()
+        var captured = false
+        val analyzer = CachingImageAnalyzer(framePool = FrameSlotPool(backend, slotCount = 2)) { _, _, _ ->
+            captured = true
+        }
 
-        val width = 64
-        val height = 64
-        val smallSize = width * height * 4
-        val bigSize = 256 * 256 * 4
+        analyzer.analyze(frame(64, 64))
 
-        val poolSmall = DirectBufferPool.getDirectBuffer(smallSize)
+        assertEquals(false, captured)
+        assertEquals(1, backend.submitted.size)
+        val (index, size, pixels) = backend.submitted.first()
+        assertEquals(64 * 64 * 4, size)
+        assertEquals(64 * 64, pixels)
+        assertEquals(3.toByte(), backend.buffers[index].get(3))
+    }
 
-        val bigBuf = ByteBuffer.allocate(bigSize)
-        for (i in 0 until bigSize) bigBuf.put(i.toByte())
-        bigBuf.rewind()
+    @Test
+    fun framesAreDroppedWhileEverySlotIsUploading() {
+        val backend = FakeBackend()
+        val pool = FrameSlotPool(backend, slotCount = 2)
+        val analyzer = CachingImageAnalyzer(framePool = pool) { _, _, _ -> }
 
-        val img = FakeImageProxy(bigBuf, 256, 256, FakeImageInfo(1L, 0L))
-        analyzer.analyze(img)
+        analyzer.analyze(frame(16, 16, 1L))
+        analyzer.analyze(frame(16, 16, 2L))
+        analyzer.analyze(frame(16, 16, 3L))
+        assertEquals(2, backend.submitted.size)
+        assertNull(pool.acquire(16 * 16 * 4))
 
-        val poolBig = DirectBufferPool.getDirectBuffer(bigSize)
-        assertTrue(poolBig.capacity() >= bigSize)
-        assertNotSame(poolSmall, poolBig)
+        backend.completeUploads()
+        analyzer.analyze(frame(16, 16, 4L))
+        assertEquals(3, backend.submitted.size)
+        assertTrue(backend.submitted.last().first in backend.buffers.indices)
     }
 }
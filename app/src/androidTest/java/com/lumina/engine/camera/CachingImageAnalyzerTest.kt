@@ -55,4 +55,25 @@ class CachingImageAnalyzerTest {
         assertEquals(height, native.lastHeight)
         assertEquals(byteCount, native.lastBuffer?.capacity())
     }
+
+    @Test
+    fun analyzerFallsBackToBufferWhenNoHardwareBuffer() {
+        val native = FakeNativeEngine()
+        var hardwareBufferOffered = false
+        val analyzer: ImageAnalysis.Analyzer = CachingImageAnalyzer(
+            onHardwareBuffer = { hardwareBufferOffered = true; 1L }
+        ) { buf, w, h -> native.upload(buf, w, h) }
+
+        val width = 8
+        val height = 4
+        val byteCount = width * height * 4
+        val buffer = ByteBuffer.allocate(byteCount)
+        val img = FakeImageProxy(buffer, width, height, FakeImageInfo(1L, 0L))
+        analyzer.analyze(img)
+
+        // FakeImageProxy has no backing android.media.Image, so the copy path must run
+        assertEquals(false, hardwareBufferOffered)
+        assertEquals(width, native.lastWidth)
+        assertEquals(byteCount, native.lastBuffer?.capacity())
+    }
 }
@@ -0,0 +1,43 @@
+#version 450
+layout(location = 0) out vec4 outColor;
+layout(set = 0, binding = 0) uniform sampler2D uTexture;
+
+// Mirrors VulkanRenderer::AnalysisPushConstants.
+layout(push_constant) uniform PushConstants {
+    vec2 size;   // analysis frame in pixels
+    uint gray;
+} pushConstants;
+
+// The camera drawn into a target each of whose RGBA8 texels holds four consecutive
+// bytes of the packed RGB or luma frame (see analysis_frame.h), top row first, so the
+// buffer copy comes back ready to hand to the ML side.
+
+// Four bilinear taps approximate a box filter over the pixel's source footprint.
+vec3 fetchPixel(float x, float row) {
+    vec2 uv = vec2(x + 0.5, row + 0.5) / pushConstants.size;
+    vec2 q = 0.25 / pushConstants.size;
+    return 0.25 * (texture(uTexture, uv + vec2(-q.x, -q.y)).rgb + texture(uTexture, uv + vec2(q.x, -q.y)).rgb +
+                   texture(uTexture, uv + vec2(-q.x, q.y)).rgb + texture(uTexture, uv + vec2(q.x, q.y)).rgb);
+}
+
+float luma(vec3 c) {
+    return dot(c, vec3(0.299, 0.587, 0.114));
+}
+
+void main() {
+    float texel = floor(gl_FragCoord.x);
+    float row = floor(gl_FragCoord.y);
+    if (pushConstants.gray != 0u) {
+        float x = texel * 4.0;
+        outColor = vec4(luma(fetchPixel(x, row)), luma(fetchPixel(x + 1.0, row)),
+                        luma(fetchPixel(x + 2.0, row)), luma(fetchPixel(x + 3.0, row)));
+        return;
+    }
+    // Bytes 4t..4t+3 start (4t mod 3) = (t mod 3) bytes into pixel floor(4t / 3).
+    vec3 a = fetchPixel(floor(texel * 4.0 / 3.0), row);
+    vec3 b = fetchPixel(floor(texel * 4.0 / 3.0) + 1.0, row);
+    uint phase = uint(texel) % 3u;
+    if (phase == 0u) outColor = vec4(a, b.r);
+    else if (phase == 1u) outColor = vec4(a.gb, b.rg);
+    else outColor = vec4(a.b, b);
+}
@@ -0,0 +1,30 @@
+#version 450
+layout(location = 0) in vec2 vTexCoord;
+layout(location = 0) out vec4 outColor;
+layout(set = 0, binding = 0) uniform sampler2D uTexture;
+
+// Mirrors VulkanRenderer::PyramidPushConstants.
+layout(push_constant) uniform PushConstants {
+    float offset;
+    float threshold;
+} pushConstants;
+
+// 5-tap dual-filter downsample into the next pyramid level (blur_pyramid.h). Built a
+// second time with BLOOM_PREFILTER for the first bloom level, which keeps only what
+// lies above the threshold so just the highlights spread.
+vec3 fetch(vec2 uv) {
+    vec3 c = texture(uTexture, uv).rgb;
+#ifdef BLOOM_PREFILTER
+    float peak = max(c.r, max(c.g, c.b));
+    c *= max(peak - pushConstants.threshold, 0.0) / max(peak, 1e-4);
+#endif
+    return c;
+}
+
+void main() {
+    vec2 h = pushConstants.offset / vec2(textureSize(uTexture, 0));
+    vec3 sum = fetch(vTexCoord) * 4.0;
+    sum += fetch(vTexCoord - h) + fetch(vTexCoord + h) +
+           fetch(vTexCoord + vec2(h.x, -h.y)) + fetch(vTexCoord + vec2(-h.x, h.y));
+    outColor = vec4(sum / 8.0, 1.0);
+}
@@ -0,0 +1,18 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+layout(location = 0) in vec2 vTexCoord;
+layout(location = 0) out vec4 outColor;
+layout(set = 0, binding = 0) uniform sampler2D uTexture;
+
+// Mirrors VulkanRenderer::PyramidPushConstants.
+layout(push_constant) uniform PushConstants {
+    float offset;
+    float threshold;
+} pushConstants;
+
+#include "lumina_common.glsl"
+
+// One pyramid level up; the pass consuming the blur does the last step itself.
+void main() {
+    outColor = vec4(dualFilterUp(uTexture, vTexCoord, pushConstants.offset), 1.0);
+}
@@ -1,13 +1,14 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 layout(location = 0) in vec2 vTexCoord;
 layout(location = 0) out vec4 outColor;
 layout(binding = 0) uniform sampler2D uTexture;
-layout(push_constant) uniform PushConstants {
-    float intensity;
-} pushConstants;
+#include "lumina_params.glsl"
+
+#include "lumina_common.glsl"
 
 void main() {
-    float offset = 0.002 + 0.004 * pushConstants.intensity;
+    float offset = 0.002 + 0.004 * passEffect().intensity;
     vec2 centered = vTexCoord - 0.5;
     vec2 dir = normalize(centered + 0.0001) * offset;
 
@@ -15,5 +16,5 @@ void main() {
     float g = texture(uTexture, vTexCoord).g;
     float b = texture(uTexture, vTexCoord + dir).b;
     
-    outColor = vec4(r, g, b, 1.0);
+    outColor = vec4(stylize(vec3(r, g, b), vTexCoord, pushConstants.time, pushConstants.exposure, pushConstants.resolution), 1.0);
 }
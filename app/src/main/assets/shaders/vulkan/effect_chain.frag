@@ -0,0 +1,72 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+layout(location = 0) in vec2 vTexCoord;
+layout(location = 0) out vec4 outColor;
+// Built twice: sampling a texture, and with SUBPASS_INPUT defined as the second subpass
+// of the merged tail pass, reading the previous pass's pixel straight from tile memory.
+#ifdef SUBPASS_INPUT
+layout(input_attachment_index = 0, set = 0, binding = 0) uniform subpassInput uInput;
+#else
+layout(set = 0, binding = 0) uniform sampler2D uTexture;
+// Level 0 of the pass's blur pyramid (blur_pyramid.h), read by BLOOM.
+layout(set = 2, binding = 0) uniform sampler2D uPyramid;
+#endif
+
+#include "lumina_params.glsl"
+
+// The op sequence is baked into each pipeline variant, so the driver folds the
+// per-op dispatch away; opCount/opSlots only select the parameter blocks.
+layout(constant_id = 0) const uint OP_COUNT = 0u;
+layout(constant_id = 1) const uint OP_TYPE0 = 0u;
+layout(constant_id = 2) const uint OP_TYPE1 = 0u;
+layout(constant_id = 3) const uint OP_TYPE2 = 0u;
+layout(constant_id = 4) const uint OP_TYPE3 = 0u;
+
+#include "lumina_common.glsl"
+
+float hash(vec2 p) {
+    p = fract(p * vec2(123.34, 456.21));
+    p += dot(p, p + 45.32);
+    return fract(p.x * p.y);
+}
+
+vec2 effectSpace(Effect e) {
+    vec2 centered = (vTexCoord - e.center.xy) * e.scale.xy;
+    centered.x *= pushConstants.resolution.x / max(pushConstants.resolution.y, 1.0);
+    return centered;
+}
+
+vec3 applyOp(uint type, uint index, vec3 color) {
+    Effect e = chain.effects[(pushConstants.opSlots >> (8u * index)) & 0xFFu];
+    if (type == 2u) { // BLOOM
+#ifndef SUBPASS_INPUT
+        if (pushConstants.pyramidOffset > 0.0) {
+            color += dualFilterUp(uPyramid, vTexCoord, pushConstants.pyramidOffset) * e.intensity;
+        }
+#endif
+    } else if (type == 3u) { // COLOR_GRADE
+        color = mix(color, e.tintColor.rgb, e.intensity);
+    } else if (type == 4u) { // VIGNETTE
+        float dist = length(vTexCoord - 0.5);
+        color *= 1.0 - smoothstep(0.2, 0.7, dist) * e.intensity;
+    } else if (type == 6u) { // NOISE
+        color += (hash(vTexCoord + pushConstants.time) - 0.5) * 0.2 * e.intensity;
+    }
+    return color;
+}
+
+void main() {
+#ifdef SUBPASS_INPUT
+    vec3 color = subpassLoad(uInput).rgb;
+#else
+    vec3 color = texture(uTexture, vTexCoord).rgb;
+#endif
+
+    if (OP_COUNT > 0u) color = applyOp(OP_TYPE0, 0u, color);
+    if (OP_COUNT > 1u) color = applyOp(OP_TYPE1, 1u, color);
+    if (OP_COUNT > 2u) color = applyOp(OP_TYPE2, 2u, color);
+    if (OP_COUNT > 3u) color = applyOp(OP_TYPE3, 3u, color);
+
+    outColor = vec4(stylize(color, vTexCoord, pushConstants.time, pushConstants.exposure,
+                            pushConstants.resolution), 1.0);
+}
@@ -0,0 +1,36 @@
+#version 450
+#extension GL_GOOGLE_include_directive : require
+layout(location = 0) in vec2 vTexCoord;
+layout(location = 0) out vec4 outColor;
+layout(set = 0, binding = 0) uniform sampler2D uTexture;
+
+// Mirrors VulkanRenderer::GlassPushConstants.
+layout(push_constant) uniform PushConstants {
+    vec4 rect;          // panel in display pixels, origin top-left
+    vec2 resolution;    // display size
+    vec2 framebuffer;   // swapchain image size, pre-rotated
+    float cornerRadius;
+    float offset;       // tap spread of the last upsample
+    float saturation;
+    float brightness;
+} pushConstants;
+
+#include "lumina_common.glsl"
+
+// Glass panel backdrop (glass_panels.h): the last upsample of the pyramid built from
+// the finished frame, toned by the UI style and masked to the panel's rounded
+// rectangle. The pyramid was copied from the pre-rotated image and is sampled the way
+// it lies there; the mask works in the display's own orientation.
+void main() {
+    vec3 c = dualFilterUp(uTexture, gl_FragCoord.xy / pushConstants.framebuffer, pushConstants.offset);
+    float luma = dot(c, vec3(0.299, 0.587, 0.114));
+    c = mix(vec3(luma), c, pushConstants.saturation) * pushConstants.brightness;
+
+    // Signed distance to the rounded rectangle, antialiased over one pixel.
+    vec4 rect = pushConstants.rect;
+    float r = pushConstants.cornerRadius;
+    vec2 p = vTexCoord * pushConstants.resolution;
+    vec2 q = abs(p - 0.5 * (rect.xy + rect.zw)) - 0.5 * (rect.zw - rect.xy) + r;
+    float d = length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - r;
+    outColor = vec4(c, clamp(0.5 - d, 0.0, 1.0));
+}
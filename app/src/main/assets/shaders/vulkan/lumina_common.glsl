@@ -0,0 +1,27 @@
+// Shared by the Vulkan effect shaders (glslc #include).
+
+// Pipeline variants are specialized per render mode and per pass position.
+layout(constant_id = 5) const uint RENDER_MODE = 0u;   // lumina::RenderMode
+layout(constant_id = 6) const bool LAST_PASS = true;
+
+const uint RENDER_MODE_STYLIZED = 1u;
+
+// Stylized look applied once, by whichever pass writes the surface.
+vec3 stylize(vec3 color, vec2 uv, float time, float exposure, vec2 resolution) {
+    if (RENDER_MODE != RENDER_MODE_STYLIZED || !LAST_PASS) return color;
+    color += 0.04 * sin(time * 1.5 + uv.x * 6.28318);
+    vec2 centered = uv - 0.5;
+    centered.x *= resolution.x / max(resolution.y, 1.0);
+    float vignette = smoothstep(0.95, 0.45, length(centered));
+    return mix(color * 0.9, color, vignette) * exposure;
+}
+
+// 8-tap dual-filter upsample (blur_pyramid.h); `offset` spreads the taps in texels of `level`.
+vec3 dualFilterUp(sampler2D level, vec2 uv, float offset) {
+    vec2 h = offset / vec2(textureSize(level, 0));
+    vec3 sum = texture(level, uv + vec2(-2.0 * h.x, 0.0)).rgb + texture(level, uv + vec2(2.0 * h.x, 0.0)).rgb +
+               texture(level, uv + vec2(0.0, -2.0 * h.y)).rgb + texture(level, uv + vec2(0.0, 2.0 * h.y)).rgb;
+    sum += 2.0 * (texture(level, uv + vec2(-h.x, h.y)).rgb + texture(level, uv + h).rgb +
+                  texture(level, uv + vec2(h.x, -h.y)).rgb + texture(level, uv - h).rgb);
+    return sum / 12.0;
+}
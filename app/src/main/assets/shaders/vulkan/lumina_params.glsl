@@ -0,0 +1,34 @@
+// Parameter blocks shared by every effect pass. The build reflects them back out of the
+// SPIR-V into shader_layouts_generated.h, which renderer_vulkan.cpp checks its mirror
+// structs against, so edit them here and the C++ side together.
+
+// Mirrors lumina::EffectParams (std140).
+struct Effect {
+    uint type;
+    float intensity;
+    float param1;
+    float param2;
+    vec4 tintColor;
+    vec4 center;
+    vec4 scale;
+};
+
+// LuminaState::effects as-is, one frame's copy per uniform ring slot.
+layout(std140, set = 1, binding = 0) uniform EffectChain {
+    Effect effects[4];
+} chain;
+
+// Mirrors VulkanRenderer::PassPushConstants. opSlots packs one effects[] index per byte,
+// applied in order; single-effect passes read their parameters from the low byte.
+layout(push_constant) uniform PushConstants {
+    float time;
+    uint opCount;
+    uint opSlots;
+    float exposure;
+    vec2 resolution;
+    float pyramidOffset;   // 0 when the pass has no pyramid
+} pushConstants;
+
+Effect passEffect() {
+    return chain.effects[pushConstants.opSlots & 0xFFu];
+}
@@ -1,8 +0,0 @@
-#version 450
-layout(location = 0) in vec2 vTexCoord;
-layout(location = 0) out vec4 outColor;
-layout(binding = 0) uniform sampler2D uTexture;
-
-void main() {
-    outColor = texture(uTexture, vTexCoord);
-}
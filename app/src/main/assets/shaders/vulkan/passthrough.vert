@@ -1,10 +1,17 @@
 #version 450
-layout(location = 0) in vec2 aPosition;
-layout(location = 1) in vec2 aTexCoord;
-
 layout(location = 0) out vec2 vTexCoord;
 
+// Quarter turns clockwise the swapchain's preTransform asks for. Only passes that write
+// the surface set it, so the frame reaches the display already rotated.
+layout(constant_id = 7) const uint PRE_ROTATION = 0u;
+
+// Full-screen triangle strip generated from gl_VertexIndex; no vertex buffer is bound.
 void main() {
-    gl_Position = vec4(aPosition, 0.0, 1.0);
-    vTexCoord = aTexCoord;
+    vec2 pos = vec2(float(gl_VertexIndex & 1), float(gl_VertexIndex >> 1)) * 2.0 - 1.0;
+    vTexCoord = pos * 0.5 + 0.5;
+    // Clockwise in framebuffer space, where y points down.
+    if (PRE_ROTATION == 1u) pos = vec2(-pos.y, pos.x);
+    else if (PRE_ROTATION == 2u) pos = -pos;
+    else if (PRE_ROTATION == 3u) pos = vec2(pos.y, -pos.x);
+    gl_Position = vec4(pos, 0.0, 1.0);
 }
@@ -1,11 +1,11 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 layout(location = 0) in vec2 vTexCoord;
 layout(location = 0) out vec4 outColor;
 layout(binding = 0) uniform sampler2D uTexture;
-layout(push_constant) uniform PushConstants {
-    float intensity;
-    vec2 resolution;
-} pushConstants;
+#include "lumina_params.glsl"
+
+#include "lumina_common.glsl"
 
 void main() {
     vec2 texelSize = 1.0 / pushConstants.resolution;
@@ -18,5 +18,6 @@ void main() {
     sum += texture(uTexture, vTexCoord + texelSize).rgb * -1.0;
     sum += originalColor * 4.0;
     
-    outColor = vec4(mix(originalColor, originalColor + sum, pushConstants.intensity), 1.0);
+    vec3 sharpened = mix(originalColor, originalColor + sum, passEffect().intensity);
+    outColor = vec4(stylize(sharpened, vTexCoord, pushConstants.time, pushConstants.exposure, pushConstants.resolution), 1.0);
 }
@@ -1,25 +1,21 @@
 #version 450
+#extension GL_GOOGLE_include_directive : require
 layout(location = 0) in vec2 vTexCoord;
 layout(location = 0) out vec4 outColor;
 layout(binding = 0) uniform sampler2D uTexture;
-layout(push_constant) uniform PushConstants {
-    float intensity;
-    vec2 resolution;
-} pushConstants;
+layout(set = 2, binding = 0) uniform sampler2D uPyramid;
+#include "lumina_params.glsl"
 
+#include "lumina_common.glsl"
+
+// The blur itself comes from the pyramid (blur_pyramid.h) built from this pass's input
+// at the radius from param1 or the UI glass style; pyramidOffset is its tap offset, 0 when
+// the pyramid is empty and the input passes through.
 void main() {
-    vec2 texelSize = 1.0 / pushConstants.resolution;
-    vec3 color = vec3(0.0);
-    float totalWeight = 0.0;
-    
-    // Simple 3x3 box blur
-    for (float y = -1.0; y <= 1.0; y++) {
-        for (float x = -1.0; x <= 1.0; x++) {
-            vec2 offset = vec2(x, y) * texelSize * pushConstants.intensity;
-            color += texture(uTexture, vTexCoord + offset).rgb;
-            totalWeight += 1.0;
-        }
+    vec3 color = texture(uTexture, vTexCoord).rgb;
+    if (pushConstants.pyramidOffset > 0.0) {
+        vec3 blurred = dualFilterUp(uPyramid, vTexCoord, pushConstants.pyramidOffset);
+        color = mix(color, blurred, clamp(passEffect().intensity, 0.0, 1.0));
     }
-    
-    outColor = vec4(color / totalWeight, 1.0);
+    outColor = vec4(stylize(color, vTexCoord, pushConstants.time, pushConstants.exposure, pushConstants.resolution), 1.0);
 }
@@ -0,0 +1,59 @@
+#include "analysis_frame.h"
+
+#include <cstring>
+
+namespace lumina {
+
+bool isValidAnalysisConfig(const AnalysisConfig& config) {
+    if (!config.enabled()) return config.width == 0 && config.height == 0;
+    if (config.format != AnalysisFormat::RGB && config.format != AnalysisFormat::GRAY) return false;
+    return config.width >= 4 && config.width <= kMaxAnalysisExtent && config.width % 4 == 0 &&
+           config.height >= 4 && config.height <= kMaxAnalysisExtent;
+}
+
+size_t analysisBytesPerPixel(AnalysisFormat format) {
+    return format == AnalysisFormat::GRAY ? 1 : 3;
+}
+
+size_t analysisFrameBytes(const AnalysisConfig& config) {
+    return static_cast<size_t>(config.width) * config.height * analysisBytesPerPixel(config.format);
+}
+
+uint32_t analysisTargetWidth(const AnalysisConfig& config) {
+    // Widths are multiples of 4, so RGB rows (3 * width bytes) fill whole texels too.
+    return static_cast<uint32_t>(config.width * analysisBytesPerPixel(config.format) / 4);
+}
+
+uint8_t* AnalysisFrameExchange::beginFrame(const AnalysisConfig& config) {
+    Frame& frame = frames_.back();
+    frame.pixels.resize(analysisFrameBytes(config));
+    frame.info.config = config;
+    return frame.pixels.data();
+}
+
+void AnalysisFrameExchange::publish(uint64_t frameNumber, int64_t timestampNs) {
+    Frame& frame = frames_.back();
+    frame.info.frameNumber = frameNumber;
+    frame.info.timestampNs = timestampNs;
+    frame.sequence = ++published_;
+    frames_.publish();
+}
+
+size_t AnalysisFrameExchange::readLatest(uint8_t* dst, size_t capacity, AnalysisFrameInfo* info) {
+    std::lock_guard<std::mutex> lock(readMutex_);
+    const Frame& frame = frames_.acquire();
+    if (info) *info = frame.info;
+    if (frame.sequence <= lastRead_ || !dst || frame.pixels.size() > capacity) return 0;
+    std::memcpy(dst, frame.pixels.data(), frame.pixels.size());
+    lastRead_ = frame.sequence;
+    return frame.pixels.size();
+}
+
+void AnalysisFrameExchange::reset() {
+    std::lock_guard<std::mutex> lock(readMutex_);
+    frames_.reset(Frame{});
+    published_ = 0;
+    lastRead_ = 0;
+}
+
+} // namespace lumina
@@ -0,0 +1,93 @@
+#ifndef LUMINA_ANALYSIS_FRAME_H
+#define LUMINA_ANALYSIS_FRAME_H
+
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#include "state_snapshot.h"
+
+/**
+ * Lumina Virtual Studio - Downsampled analysis frames
+ *
+ * Besides the display chain, the renderers can draw the raw camera input into a small
+ * (e.g. 256x256) target and read it back asynchronously for the ML orchestrator. The
+ * GPU writes the pixels tightly packed, row-major and top row first, as RGB (3 bytes)
+ * or BT.601 luma (1 byte): each RGBA8 texel of the target carries four consecutive
+ * bytes of the frame, so what comes back from the readback needs no CPU repacking.
+ *
+ * The render thread publishes frames through a triple buffer: it never waits for a
+ * reader, and a reader always gets the newest complete frame.
+ */
+
+namespace lumina {
+
+enum class AnalysisFormat : uint32_t {
+    RGB = 0,
+    GRAY = 1,
+};
+
+struct AnalysisConfig {
+    uint32_t width = 0;   // 0 disables the analysis branch
+    uint32_t height = 0;
+    AnalysisFormat format = AnalysisFormat::RGB;
+
+    bool enabled() const { return width != 0 && height != 0; }
+    bool operator==(const AnalysisConfig& o) const {
+        return width == o.width && height == o.height && format == o.format;
+    }
+    bool operator!=(const AnalysisConfig& o) const { return !(*this == o); }
+};
+
+constexpr uint32_t kMaxAnalysisExtent = 1024;
+
+/** Disabled, or 4..kMaxAnalysisExtent on both axes with a width divisible by 4. */
+bool isValidAnalysisConfig(const AnalysisConfig& config);
+
+size_t analysisBytesPerPixel(AnalysisFormat format);
+size_t analysisFrameBytes(const AnalysisConfig& config);
+
+/** Width in RGBA8 texels of the render target that holds one packed row. */
+uint32_t analysisTargetWidth(const AnalysisConfig& config);
+
+struct AnalysisFrameInfo {
+    AnalysisConfig config;
+    uint64_t frameNumber = 0;  // render frame that produced it; 0 before the first frame
+    int64_t timestampNs = 0;   // CLOCK_MONOTONIC when that frame was submitted
+};
+
+class AnalysisFrameExchange {
+public:
+    // Producer (render thread): fill beginFrame()'s analysisFrameBytes(config) bytes,
+    // then publish(). Storage is only reallocated when the config grows.
+    uint8_t* beginFrame(const AnalysisConfig& config);
+    void publish(uint64_t frameNumber, int64_t timestampNs);
+
+    /**
+     * Copies the newest frame into `dst` when it is newer than the last one read.
+     * Returns the number of bytes copied, or 0 when there is no new frame or it does
+     * not fit in `capacity`; `info` (may be null) describes the newest frame either
+     * way, so callers can size their buffer. Readers are serialised internally.
+     */
+    size_t readLatest(uint8_t* dst, size_t capacity, AnalysisFrameInfo* info);
+
+    // Not thread-safe; call while the render thread is not producing.
+    void reset();
+
+private:
+    struct Frame {
+        std::vector<uint8_t> pixels;
+        AnalysisFrameInfo info;
+        uint64_t sequence = 0;  // publish order; frame numbers restart with the renderer
+    };
+
+    TripleBuffer<Frame> frames_;
+    uint64_t published_ = 0;    // producer-owned
+    std::mutex readMutex_;
+    uint64_t lastRead_ = 0;     // sequence of the last frame copied out
+};
+
+} // namespace lumina
+
+#endif // LUMINA_ANALYSIS_FRAME_H
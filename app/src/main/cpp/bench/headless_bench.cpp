@@ -0,0 +1,241 @@
+// Device-side render benchmark: drives VulkanRenderer (offscreen targets) and
+// GLRenderer (EGL pbuffer) without a window, rendering N frames of every EffectType
+// at each requested resolution. One JSON object per run goes to stdout, carrying
+// the wall-clock frame time plus the FrameStats percentiles (CPU stages, GPU passes).
+//
+// Built as lumina_headless with -DLUMINA_BUILD_BENCHMARKS=ON, then for example:
+//   adb push lumina_headless /data/local/tmp
+//   adb shell /data/local/tmp/lumina_headless --api all --frames 300 --size 1920x1080 --upload
+
+#include <EGL/egl.h>
+#include <GLES3/gl3.h>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "engine_structs.h"
+#include "frame_stats.h"
+#include "renderer_gles.h"
+#include "renderer_vulkan.h"
+
+namespace {
+
+using lumina::EffectType;
+
+constexpr EffectType kEffects[] = {
+    EffectType::NONE, EffectType::BLUR, EffectType::BLOOM, EffectType::COLOR_GRADE,
+    EffectType::VIGNETTE, EffectType::CHROMATIC_ABERRATION, EffectType::NOISE, EffectType::SHARPEN,
+};
+
+const char* effectName(EffectType type) {
+    switch (type) {
+        case EffectType::NONE: return "NONE";
+        case EffectType::BLUR: return "BLUR";
+        case EffectType::BLOOM: return "BLOOM";
+        case EffectType::COLOR_GRADE: return "COLOR_GRADE";
+        case EffectType::VIGNETTE: return "VIGNETTE";
+        case EffectType::CHROMATIC_ABERRATION: return "CHROMATIC_ABERRATION";
+        case EffectType::NOISE: return "NOISE";
+        case EffectType::SHARPEN: return "SHARPEN";
+    }
+    return "UNKNOWN";
+}
+
+struct Size {
+    uint32_t width;
+    uint32_t height;
+};
+
+struct Options {
+    bool vulkan = true;
+    bool gles = true;
+    int frames = 300;
+    int warmup = 30;
+    bool upload = false;  // Vulkan: stage a synthetic RGBA camera frame every frame
+    std::vector<Size> sizes;
+};
+
+bool parseOptions(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        const char* arg = argv[i];
+        const char* value = (i + 1 < argc) ? argv[i + 1] : nullptr;
+        if (std::strcmp(arg, "--api") == 0 && value) {
+            options.vulkan = std::strcmp(value, "vulkan") == 0 || std::strcmp(value, "all") == 0;
+            options.gles = std::strcmp(value, "gles") == 0 || std::strcmp(value, "all") == 0;
+            ++i;
+        } else if (std::strcmp(arg, "--frames") == 0 && value) {
+            options.frames = std::max(1, std::atoi(value));
+            ++i;
+        } else if (std::strcmp(arg, "--warmup") == 0 && value) {
+            options.warmup = std::max(0, std::atoi(value));
+            ++i;
+        } else if (std::strcmp(arg, "--size") == 0 && value) {
+            unsigned width = 0, height = 0;
+            if (std::sscanf(value, "%ux%u", &width, &height) != 2 || width == 0 || height == 0) return false;
+            options.sizes.push_back({width, height});
+            ++i;
+        } else if (std::strcmp(arg, "--upload") == 0) {
+            options.upload = true;
+        } else {
+            return false;
+        }
+    }
+    if (options.sizes.empty()) options.sizes = {{1280, 720}, {1920, 1080}};
+    return options.vulkan || options.gles;
+}
+
+lumina::LuminaState stateFor(EffectType type, uint32_t width, uint32_t height) {
+    lumina::LuminaState state;
+    state.setDimensions(width, height);
+    if (type != EffectType::NONE) {
+        state.effects[0].type = type;
+        state.effects[0].intensity = 1.0f;
+        state.effects[0].param1 = 0.5f;
+        state.activeEffectCount = 1;
+    }
+    return state;
+}
+
+void report(const char* api, EffectType type, Size size, int frames, double wallMs,
+            const lumina::FrameStats& stats) {
+    std::printf(R"({"api":"%s","effect":"%s","width":%u,"height":%u,"frames":%d,"frameMs":%.4f,"stats":%s})"
+                "\n",
+                api, effectName(type), size.width, size.height, frames, wallMs / frames, stats.toJson().c_str());
+    std::fflush(stdout);
+}
+
+template <typename RenderFn, typename DrainFn>
+void runEffect(const char* api, EffectType type, Size size, const Options& options, lumina::FrameStats& stats,
+               RenderFn&& renderOne, DrainFn&& drain) {
+    lumina::LuminaState state = stateFor(type, size.width, size.height);
+    for (int i = 0; i < options.warmup; ++i) renderOne(state);
+    drain();
+    stats.reset();
+
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    for (int i = 0; i < options.frames; ++i) {
+        state.timing.frameCount = static_cast<uint64_t>(i);
+        state.timing.totalTime = static_cast<float>(i) / 60.0f;
+        lumina::ScopedStageTimer frameTimer(&stats, lumina::FrameStage::CpuFrame);
+        renderOne(state);
+    }
+    drain();
+    report(api, type, size, options.frames, std::chrono::duration<double, std::milli>(Clock::now() - start).count(),
+           stats);
+}
+
+bool runVulkan(Size size, const Options& options) {
+    lumina::FrameStats stats;
+    VulkanRenderer renderer;
+    renderer.setFrameStats(&stats);
+    if (!renderer.initializeHeadless(size.width, size.height)) {
+        std::fprintf(stderr, "vulkan: headless init failed at %ux%u\n", size.width, size.height);
+        return false;
+    }
+
+    std::vector<uint8_t> camera;
+    if (options.upload) camera.assign(static_cast<size_t>(size.width) * size.height * 4, 0x80);
+
+    for (EffectType type : kEffects) {
+        runEffect("vulkan", type, size, options, stats,
+                  [&](const lumina::LuminaState& state) {
+                      if (!camera.empty()) {
+                          lumina::ScopedStageTimer uploadTimer(&stats, lumina::FrameStage::Upload);
+                          renderer.uploadTexture(camera.data(), camera.size(), size.width, size.height);
+                      }
+                      renderer.render(state);
+                  },
+                  [&] { renderer.waitIdle(); });
+    }
+    renderer.destroy();
+    return true;
+}
+
+bool runGles(Size size, const Options& options) {
+    EGLDisplay display = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display == EGL_NO_DISPLAY || !eglInitialize(display, nullptr, nullptr)) {
+        std::fprintf(stderr, "gles: eglInitialize failed\n");
+        return false;
+    }
+
+    const EGLint configAttribs[] = {
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT,
+        EGL_SURFACE_TYPE, EGL_PBUFFER_BIT,
+        EGL_RED_SIZE, 8, EGL_GREEN_SIZE, 8, EGL_BLUE_SIZE, 8, EGL_ALPHA_SIZE, 8,
+        EGL_NONE
+    };
+    EGLConfig config = nullptr;
+    EGLint numConfigs = 0;
+    const EGLint contextAttribs[] = { EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE };
+    const EGLint pbufferAttribs[] = {
+        EGL_WIDTH, static_cast<EGLint>(size.width), EGL_HEIGHT, static_cast<EGLint>(size.height), EGL_NONE
+    };
+    EGLContext context = EGL_NO_CONTEXT;
+    EGLSurface surface = EGL_NO_SURFACE;
+    if (eglChooseConfig(display, configAttribs, &config, 1, &numConfigs) && numConfigs > 0) {
+        context = eglCreateContext(display, config, EGL_NO_CONTEXT, contextAttribs);
+        surface = eglCreatePbufferSurface(display, config, pbufferAttribs);
+    }
+    if (context == EGL_NO_CONTEXT || surface == EGL_NO_SURFACE ||
+        !eglMakeCurrent(display, surface, surface, context)) {
+        std::fprintf(stderr, "gles: pbuffer context failed at %ux%u: 0x%x\n", size.width, size.height, eglGetError());
+        if (surface != EGL_NO_SURFACE) eglDestroySurface(display, surface);
+        if (context != EGL_NO_CONTEXT) eglDestroyContext(display, context);
+        eglTerminate(display);
+        return false;
+    }
+
+    bool ok = true;
+    {
+        lumina::FrameStats stats;
+        GLRenderer renderer;
+        renderer.setFrameStats(&stats);
+        renderer.initialize();
+        renderer.onSurfaceSize(static_cast<int>(size.width), static_cast<int>(size.height));
+
+        for (EffectType type : kEffects) {
+            runEffect("gles", type, size, options, stats,
+                      [&](const lumina::LuminaState& state) {
+                          {
+                              lumina::ScopedStageTimer recordTimer(&stats, lumina::FrameStage::Record);
+                              ok = renderer.render(state) && ok;
+                          }
+                          lumina::ScopedStageTimer submitTimer(&stats, lumina::FrameStage::Submit);
+                          eglSwapBuffers(display, surface);
+                      },
+                      [] { glFinish(); });
+        }
+        renderer.destroy(); // needs the context current
+    }
+
+    eglMakeCurrent(display, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    eglDestroySurface(display, surface);
+    eglDestroyContext(display, context);
+    eglTerminate(display);
+    return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseOptions(argc, argv, options)) {
+        std::fprintf(stderr,
+                     "usage: %s [--api vulkan|gles|all] [--frames N] [--warmup N] [--size WxH]... [--upload]\n",
+                     argv[0]);
+        return 2;
+    }
+
+    bool ok = true;
+    for (const Size& size : options.sizes) {
+        if (options.vulkan) ok = runVulkan(size, options) && ok;
+        if (options.gles) ok = runGles(size, options) && ok;
+    }
+    return ok ? 0 : 1;
+}
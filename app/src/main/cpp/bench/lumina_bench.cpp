@@ -0,0 +1,233 @@
+// Host/device microbenchmarks (Google Benchmark) for the engine's CPU hot paths:
+// state JSON parsing and ingest, binary packets, the render-thread hand-off, effect
+// graph planning and the CPU side of camera uploads (staging copy, YUV conversion).
+// GPU frame cost is covered by lumina_headless (headless_bench.cpp). The JSON parsers
+// are compared against nlohmann/json when CMake finds it (find_package(nlohmann_json)).
+//
+//   cmake -S app/src/main/cpp -B build-host -DCMAKE_BUILD_TYPE=Release
+//   cmake --build build-host --target lumina_bench && build-host/lumina_bench
+
+#include <benchmark/benchmark.h>
+
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+
+#include "effect_graph.h"
+#include "json_parser.h"
+#include "pixel_convert.h"
+#include "state_json.h"
+#include "state_packet.h"
+#include "state_snapshot.h"
+
+#ifdef LUMINA_BENCH_NLOHMANN
+#include <nlohmann/json.hpp>
+#endif
+
+namespace {
+
+using lumina::EffectType;
+
+// Shape of a typical updateStateFromJson() payload with four active effects.
+const char* kStateJson = R"({
+  "width": 1920, "height": 1080, "renderMode": 1, "processingState": 2,
+  "touchState": 1, "touchPressure": 0.75,
+  "touchPosition": {"x": 0.42, "y": 0.58}, "touchDelta": {"x": -0.01, "y": 0.02},
+  "activeEffectCount": 4,
+  "effects": [
+    {"type": 1, "intensity": 0.8, "param1": 1.5, "param2": 0.0,
+     "tintColor": {"r": 1.0, "g": 0.9, "b": 0.8, "a": 1.0}, "center": {"x": 0.5, "y": 0.5}, "scale": {"x": 1.0, "y": 1.0}},
+    {"type": 3, "intensity": 0.5, "param1": 0.25, "param2": 2.0,
+     "tintColor": {"r": 1.0, "g": 1.0, "b": 1.0, "a": 1.0}, "center": {"x": 0.5, "y": 0.5}, "scale": {"x": 1.0, "y": 1.0}},
+    {"type": 5, "intensity": 0.3, "param1": 0.0, "param2": 0.0,
+     "tintColor": {"r": 0.7, "g": 0.8, "b": 1.0, "a": 1.0}, "center": {"x": 0.3, "y": 0.7}, "scale": {"x": 2.0, "y": 2.0}},
+    {"type": 6, "intensity": 1.0, "param1": 0.1, "param2": 0.9,
+     "tintColor": {"r": 1.0, "g": 1.0, "b": 1.0, "a": 0.5}, "center": {"x": 0.5, "y": 0.5}, "scale": {"x": 1.0, "y": 1.0}}
+  ],
+  "uiStyle": {"backgroundColor": {"r": 0.2, "g": 0.4, "b": 0.9, "a": 1.0}, "blurRadius": 12.0, "cornerRadius": 8.0},
+  "camera": {"fov": 60.0, "nearPlane": 0.1, "farPlane": 100.0}
+})";
+
+struct CountingHandler : lumina::json::JsonHandler {
+    double sum = 0.0;
+    bool onNumber(double value) override { sum += value; return true; }
+};
+
+lumina::LuminaState stackOf(std::initializer_list<EffectType> types) {
+    lumina::LuminaState state;
+    for (EffectType type : types) {
+        state.effects[state.activeEffectCount].type = type;
+        state.effects[state.activeEffectCount].intensity = 1.0f;
+        ++state.activeEffectCount;
+    }
+    return state;
+}
+
+void BM_JsonParserTree(benchmark::State& st) {
+    const std::string text = kStateJson;
+    for (auto _ : st) {
+        lumina::json::JsonParser parser(text);
+        benchmark::DoNotOptimize(parser.parse());
+    }
+    st.SetBytesProcessed(static_cast<int64_t>(st.iterations()) * static_cast<int64_t>(text.size()));
+}
+BENCHMARK(BM_JsonParserTree);
+
+void BM_JsonDocumentParse(benchmark::State& st) {
+    const std::string text = kStateJson;
+    lumina::json::JsonDocument doc;
+    for (auto _ : st) {
+        benchmark::DoNotOptimize(doc.parse(text));
+    }
+    st.SetBytesProcessed(static_cast<int64_t>(st.iterations()) * static_cast<int64_t>(text.size()));
+}
+BENCHMARK(BM_JsonDocumentParse);
+
+void BM_JsonSaxParse(benchmark::State& st) {
+    const std::string text = kStateJson;
+    lumina::json::SaxParser sax;
+    for (auto _ : st) {
+        CountingHandler handler;
+        benchmark::DoNotOptimize(sax.parse(text, handler));
+        benchmark::DoNotOptimize(handler.sum);
+    }
+    st.SetBytesProcessed(static_cast<int64_t>(st.iterations()) * static_cast<int64_t>(text.size()));
+}
+BENCHMARK(BM_JsonSaxParse);
+
+#ifdef LUMINA_BENCH_NLOHMANN
+// The same payload through nlohmann/json's DOM, the baseline the parsers above replace.
+void BM_NlohmannParse(benchmark::State& st) {
+    const std::string text = kStateJson;
+    for (auto _ : st) {
+        benchmark::DoNotOptimize(nlohmann::json::parse(text));
+    }
+    st.SetBytesProcessed(static_cast<int64_t>(st.iterations()) * static_cast<int64_t>(text.size()));
+}
+BENCHMARK(BM_NlohmannParse);
+#endif
+
+// Parse plus field dispatch: everything updateStateFromJson() does under its lock.
+void BM_ApplyStateJson(benchmark::State& st) {
+    const std::string text = kStateJson;
+    lumina::json::JsonDocument doc;
+    lumina::LuminaState state;
+    for (auto _ : st) {
+        benchmark::DoNotOptimize(lumina::applyStateJson(doc, text, state));
+    }
+}
+BENCHMARK(BM_ApplyStateJson);
+
+void BM_ApplyStatePacket(benchmark::State& st) {
+    lumina::StatePacket packet{};
+    packet.version = lumina::kStatePacketVersion;
+    packet.dirtyMask = lumina::kDirtyAll;
+    packet.width = 1920;
+    packet.height = 1080;
+    packet.activeEffectCount = 4;
+    for (uint32_t i = 0; i < 4; ++i) {
+        packet.effects[i].type = i + 1;
+        packet.effects[i].intensity = 0.5f;
+    }
+    lumina::LuminaState state;
+    for (auto _ : st) {
+        benchmark::DoNotOptimize(lumina::applyStatePacket(&packet, sizeof(packet), state));
+    }
+}
+BENCHMARK(BM_ApplyStatePacket);
+
+// Writer publish + render-thread acquire of a full LuminaState snapshot.
+void BM_TripleBufferHandOff(benchmark::State& st) {
+    lumina::TripleBuffer<lumina::LuminaState> snapshots;
+    lumina::LuminaState state = stackOf({EffectType::BLUR, EffectType::VIGNETTE});
+    for (auto _ : st) {
+        state.incrementStateId();
+        snapshots.publish(state);
+        benchmark::DoNotOptimize(snapshots.acquire().stateId);
+    }
+}
+BENCHMARK(BM_TripleBufferHandOff);
+
+// Effect-param mapping: pass planning plus one variant key per pass, as each
+// renderer does per frame before touching the GPU.
+void BM_BuildEffectGraph(benchmark::State& st) {
+    static const lumina::LuminaState kStacks[] = {
+        stackOf({}),
+        stackOf({EffectType::COLOR_GRADE, EffectType::VIGNETTE}),
+        stackOf({EffectType::BLUR, EffectType::COLOR_GRADE, EffectType::SHARPEN, EffectType::NOISE}),
+    };
+    const lumina::LuminaState& state = kStacks[st.range(0)];
+    lumina::EffectGraphOptions options;
+    options.fuseIntoSampling = st.range(1) != 0;
+    for (auto _ : st) {
+        const lumina::EffectGraph graph = lumina::buildEffectGraph(state, options);
+        uint64_t keys = 0;
+        for (uint32_t p = 0; p < graph.passCount; ++p) {
+            const uint32_t flags = (p + 1 == graph.passCount) ? lumina::kVariantLastPass : 0;
+            keys ^= lumina::effectVariantKey(graph.passes[p], state.effects, state.renderMode, flags, 0);
+        }
+        benchmark::DoNotOptimize(keys);
+    }
+}
+BENCHMARK(BM_BuildEffectGraph)->ArgsProduct({{0, 1, 2}, {0, 1}})->ArgNames({"stack", "fuse"});
+
+// CPU side of VulkanRenderer::uploadTexture(): one RGBA frame into mapped staging memory.
+void BM_UploadStagingCopy(benchmark::State& st) {
+    const size_t width = static_cast<size_t>(st.range(0));
+    const size_t height = static_cast<size_t>(st.range(1));
+    const size_t bytes = width * height * 4;
+    std::unique_ptr<uint8_t[]> camera(new uint8_t[bytes]);
+    std::memset(camera.get(), 0x80, bytes);
+    // Mapped device memory is at least minMemoryMapAlignment (64) aligned.
+    struct AlignedFree { void operator()(void* p) const { std::free(p); } };
+    std::unique_ptr<void, AlignedFree> staging(std::aligned_alloc(64, (bytes + 63) / 64 * 64));
+    for (auto _ : st) {
+        std::memcpy(staging.get(), camera.get(), bytes);
+        benchmark::ClobberMemory();
+    }
+    st.SetBytesProcessed(static_cast<int64_t>(st.iterations()) * static_cast<int64_t>(bytes));
+}
+BENCHMARK(BM_UploadStagingCopy)->Args({1280, 720})->Args({1920, 1080})->Args({3840, 2160});
+
+// CPU side of VulkanRenderer::uploadYuv(): an NV21 camera frame converted (and
+// optionally downscaled) straight into staging memory. Compare against
+// BM_UploadStagingCopy, which still needs a separate YUV -> RGBA pass before it.
+void BM_YuvToRgba(benchmark::State& st) {
+    const uint32_t width = static_cast<uint32_t>(st.range(0));
+    const uint32_t height = static_cast<uint32_t>(st.range(1));
+    const uint32_t downscale = static_cast<uint32_t>(st.range(2));
+    std::unique_ptr<uint8_t[]> luma(new uint8_t[static_cast<size_t>(width) * height]);
+    std::unique_ptr<uint8_t[]> chroma(new uint8_t[static_cast<size_t>(width) * height / 2]);
+    std::memset(luma.get(), 0x70, static_cast<size_t>(width) * height);
+    std::memset(chroma.get(), 0x80, static_cast<size_t>(width) * height / 2);
+
+    lumina::YuvPlanes planes;
+    planes.y = luma.get();
+    planes.v = chroma.get();
+    planes.u = chroma.get() + 1;
+    planes.yRowStride = width;
+    planes.uvRowStride = width;
+    planes.uvPixelStride = 2;
+    planes.width = width;
+    planes.height = height;
+
+    const size_t dstStride = static_cast<size_t>(lumina::downscaledExtent(width, downscale)) * 4;
+    const size_t bytes = dstStride * lumina::downscaledExtent(height, downscale);
+    struct AlignedFree { void operator()(void* p) const { std::free(p); } };
+    std::unique_ptr<void, AlignedFree> staging(std::aligned_alloc(64, (bytes + 63) / 64 * 64));
+    for (auto _ : st) {
+        benchmark::DoNotOptimize(
+            lumina::convertYuvToRgba(planes, static_cast<uint8_t*>(staging.get()), dstStride, downscale));
+        benchmark::ClobberMemory();
+    }
+    st.SetBytesProcessed(static_cast<int64_t>(st.iterations()) * static_cast<int64_t>(width) * height * 3 / 2);
+}
+BENCHMARK(BM_YuvToRgba)
+    ->Args({1280, 720, 1})->Args({1920, 1080, 1})->Args({1920, 1080, 2})->Args({1920, 1080, 4})
+    ->Args({3840, 2160, 1})->Args({3840, 2160, 4})
+    ->ArgNames({"width", "height", "downscale"});
+
+} // namespace
+
+BENCHMARK_MAIN();
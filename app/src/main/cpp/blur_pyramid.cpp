@@ -0,0 +1,66 @@
+#include "blur_pyramid.h"
+
+#include <algorithm>
+
+namespace lumina {
+
+namespace {
+
+// The taps of n levels reach about offset * 2^(n + 1) pixels of the input. Past this
+// spread the 5- and 8-tap kernels start to show as rings, so add a level instead.
+constexpr float kMaxOffset = 1.5f;
+constexpr float kMinOffset = 0.25f;
+constexpr uint32_t kMinLevelSize = 2;
+
+} // namespace
+
+BlurPlan planBlur(float radius, uint32_t width, uint32_t height) {
+    BlurPlan plan;
+    if (!(radius >= 1.0f)) return plan;
+
+    uint32_t w = width;
+    uint32_t h = height;
+    float reach = 2.0f;   // 2^(levels + 1) before the level is added
+    while (plan.levels < kMaxBlurLevels) {
+        const uint32_t nextW = (w + 1) / 2;
+        const uint32_t nextH = (h + 1) / 2;
+        if (nextW < kMinLevelSize || nextH < kMinLevelSize) break;
+        plan.widths[plan.levels] = w = nextW;
+        plan.heights[plan.levels] = h = nextH;
+        ++plan.levels;
+        reach *= 2.0f;
+        if (radius <= reach * kMaxOffset) break;
+    }
+    if (plan.levels == 0) return plan;
+    plan.offset = std::clamp(radius / reach, kMinOffset, kMaxOffset);
+    return plan;
+}
+
+float effectBlurRadius(const EffectParams& effect, const GlassmorphicParams& style) {
+    switch (effect.type) {
+        case EffectType::BLUR:
+            return effect.param1 > 0.0f ? effect.param1 : style.blurRadius;
+        case EffectType::BLOOM:
+            return effect.param1 > 0.0f ? effect.param1 : kDefaultBloomRadius;
+        default:
+            return 0.0f;
+    }
+}
+
+float bloomThreshold(const EffectParams& effect) {
+    return effect.param2 > 0.0f ? effect.param2 : kDefaultBloomThreshold;
+}
+
+bool usesBlurPyramid(EffectType type) {
+    return type == EffectType::BLUR || type == EffectType::BLOOM;
+}
+
+uint64_t pyramidVariantKey(PyramidStage stage, uint32_t flags, uint32_t format) {
+    uint64_t key = 1ull << 31;
+    key |= flags & 0x7u;
+    key |= (static_cast<uint64_t>(stage) & 0xFu) << 3;
+    key |= static_cast<uint64_t>(format) << 32;
+    return key;
+}
+
+} // namespace lumina
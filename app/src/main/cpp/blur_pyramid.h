@@ -0,0 +1,67 @@
+#ifndef LUMINA_BLUR_PYRAMID_H
+#define LUMINA_BLUR_PYRAMID_H
+
+#include <array>
+#include <cstdint>
+
+#include "engine_structs.h"
+
+/**
+ * Lumina Virtual Studio - Blur pyramid
+ *
+ * BLUR and BLOOM run a dual-filter pyramid (Bjørge, SIGGRAPH 2015) over their pass
+ * input: each level is a 5-tap downsample of the one above it at half the size, then
+ * 8-tap upsamples walk back up to level 1, and the pass that consumes the result does
+ * the last upsample to its own size. Every tap is a bilinear fetch, so the cost per
+ * output pixel stays flat while the radius doubles with each level; `offset` spreads
+ * the taps to land between those steps. Bloom thresholds its first downsample so only
+ * highlights spread.
+ */
+
+namespace lumina {
+
+constexpr uint32_t kMaxBlurLevels = 6;
+
+struct BlurPlan {
+    uint32_t levels = 0;     // downsampled levels; 0 leaves the input as it is
+    float offset = 1.0f;     // tap spread in texels of the level sampled, for every pass
+    std::array<uint32_t, kMaxBlurLevels> widths{};
+    std::array<uint32_t, kMaxBlurLevels> heights{};
+};
+
+/**
+ * Levels and tap offset for a blur of about `radius` pixels over a `width` x `height`
+ * input. Levels stop before they would get narrower than 2 pixels.
+ */
+BlurPlan planBlur(float radius, uint32_t width, uint32_t height);
+
+/**
+ * Radius in surface pixels: param1 when set, otherwise the glass blur radius from the
+ * UI style for BLUR and kDefaultBloomRadius for BLOOM. 0 for other effects.
+ */
+float effectBlurRadius(const EffectParams& effect, const GlassmorphicParams& style);
+
+constexpr float kDefaultBloomRadius = 48.0f;
+constexpr float kDefaultBloomThreshold = 0.8f;
+
+/** Brightness above which BLOOM spreads: param2 when set. */
+float bloomThreshold(const EffectParams& effect);
+
+/** True for effects that read a blur pyramid built from their pass input. */
+bool usesBlurPyramid(EffectType type);
+
+enum class PyramidStage : uint32_t {
+    Down = 0,       // 5-tap downsample
+    Prefilter = 1,  // first bloom downsample, thresholded
+    Up = 2,         // 8-tap upsample
+};
+
+/**
+ * Variant key for a pyramid stage, disjoint from effectVariantKey() (bit 31 is never
+ * set there) so both can share one pipeline or program cache.
+ */
+uint64_t pyramidVariantKey(PyramidStage stage, uint32_t flags, uint32_t format);
+
+} // namespace lumina
+
+#endif // LUMINA_BLUR_PYRAMID_H
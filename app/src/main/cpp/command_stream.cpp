@@ -0,0 +1,113 @@
+#include "command_stream.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace lumina {
+
+namespace {
+
+template <typename T>
+T readPayload(const uint8_t* payload) {
+    // Direct buffers carry no alignment guarantee.
+    T value;
+    std::memcpy(&value, payload, sizeof(T));
+    return value;
+}
+
+// Walks the records, calling `visit(header, payload)` for each; false if one overruns.
+template <typename Visit>
+bool forEachRecord(const uint8_t* bytes, size_t size, Visit&& visit) {
+    size_t offset = sizeof(uint32_t);
+    while (offset < size) {
+        if (size - offset < sizeof(CommandHeader)) return false;
+        const auto header = readPayload<CommandHeader>(bytes + offset);
+        offset += sizeof(CommandHeader);
+        if ((header.size & 3u) != 0 || header.size > size - offset) return false;
+        visit(header, bytes + offset);
+        offset += header.size;
+    }
+    return true;
+}
+
+bool applyRecord(const CommandHeader& header, const uint8_t* payload, LuminaState& state,
+                 CommandOutcome& outcome) {
+    switch (static_cast<CommandType>(header.type)) {
+        case CommandType::SetRenderMode:
+            if (header.size != sizeof(uint32_t)) return false;
+            state.renderMode = static_cast<RenderMode>(std::min(readPayload<uint32_t>(payload), 4u));
+            outcome.stateChanged = true;
+            return true;
+        case CommandType::SetProcessing:
+            if (header.size != sizeof(uint32_t)) return false;
+            state.processingState = static_cast<ProcessingState>(std::min(readPayload<uint32_t>(payload), 3u));
+            outcome.stateChanged = true;
+            return true;
+        case CommandType::SetDimensions: {
+            if (header.size != 2 * sizeof(uint32_t)) return false;
+            const uint32_t width = readPayload<uint32_t>(payload);
+            const uint32_t height = readPayload<uint32_t>(payload + sizeof(uint32_t));
+            if (width == 0 || height == 0) return false;
+            state.setDimensions(width, height);
+            outcome.stateChanged = true;
+            return true;
+        }
+        case CommandType::SetTouch: {
+            if (header.size != sizeof(CommandTouch)) return false;
+            const auto touch = readPayload<CommandTouch>(payload);
+            state.touchState = std::min(touch.touchState, 3u);
+            state.touchPressure = touch.touchPressure;
+            state.touchPosition = Vec2(touch.touchPosition[0], touch.touchPosition[1]);
+            state.touchDelta = Vec2(touch.touchDelta[0], touch.touchDelta[1]);
+            outcome.stateChanged = true;
+            return true;
+        }
+        case CommandType::SetEffect: {
+            if (header.size != sizeof(CommandEffect)) return false;
+            const auto command = readPayload<CommandEffect>(payload);
+            if (command.index >= state.effects.size()) return false;
+            applyPacketEffect(command.effect, state.effects[command.index]);
+            outcome.stateChanged = true;
+            return true;
+        }
+        case CommandType::SetEffectCount: {
+            if (header.size != sizeof(uint32_t)) return false;
+            const uint32_t count = std::min(readPayload<uint32_t>(payload), static_cast<uint32_t>(state.effects.size()));
+            for (uint32_t i = count; i < state.effects.size(); ++i) state.effects[i] = EffectParams();
+            state.activeEffectCount = count;
+            outcome.stateChanged = true;
+            return true;
+        }
+        case CommandType::RequestFrame:
+            if (header.size != 0) return false;
+            outcome.frameRequested = true;
+            return true;
+        case CommandType::ReadTiming:
+            if (header.size != 0) return false;
+            outcome.timingRequested = true;
+            return true;
+    }
+    return false;
+}
+
+} // namespace
+
+CommandOutcome applyCommands(const void* data, size_t size, LuminaState& state) {
+    CommandOutcome outcome;
+    if (!data || size < sizeof(uint32_t)) return outcome;
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    if (readPayload<uint32_t>(bytes) != kCommandStreamVersion) return outcome;
+    if (!forEachRecord(bytes, size, [](const CommandHeader&, const uint8_t*) {})) return outcome;
+
+    outcome.valid = true;
+    forEachRecord(bytes, size, [&](const CommandHeader& header, const uint8_t* payload) {
+        if (applyRecord(header, payload, state, outcome)) {
+            ++outcome.applied;
+        } else {
+            ++outcome.rejected;
+        }
+    });
+    return outcome;
+}
+
+} // namespace lumina
@@ -0,0 +1,95 @@
+#ifndef LUMINA_COMMAND_STREAM_H
+#define LUMINA_COMMAND_STREAM_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "engine_structs.h"
+#include "state_packet.h"
+
+/**
+ * Lumina Virtual Studio - Command stream
+ *
+ * Kotlin queues typed commands into a direct ByteBuffer and submits the lot with one
+ * JNI call, so a burst of touch moves, effect edits and a stats poll costs one
+ * transition and one stateMutex_ acquisition instead of one each. The stream is a
+ * version word followed by records, each a CommandHeader and `size` payload bytes
+ * (a multiple of 4). State commands apply in order and publish once; anything that
+ * reads back lands in a caller-provided CommandResults buffer rather than a new
+ * jstring per poll.
+ *
+ * Mirrors com.lumina.engine.CommandBuffer - keep both in sync and bump the version
+ * on any layout change.
+ */
+
+namespace lumina {
+
+constexpr uint32_t kCommandStreamVersion = 1;
+
+enum class CommandType : uint32_t {
+    SetRenderMode = 1,   // uint32 mode
+    SetProcessing = 2,   // uint32 processingState
+    SetDimensions = 3,   // uint32 width, height
+    SetTouch = 4,        // CommandTouch
+    SetEffect = 5,       // uint32 index, PacketEffect
+    SetEffectCount = 6,  // uint32 count; slots past it are cleared
+    RequestFrame = 7,    // no payload; draw at the next vsync even if nothing changed
+    ReadTiming = 8,      // no payload; fills CommandResults::timing
+};
+
+struct CommandHeader {
+    uint32_t type;
+    uint32_t size;  // payload bytes after this header
+};
+
+struct CommandTouch {
+    uint32_t touchState;
+    float touchPressure;
+    float touchPosition[2];
+    float touchDelta[2];
+};
+
+struct CommandEffect {
+    uint32_t index;
+    PacketEffect effect;
+};
+
+enum CommandResultFlags : uint32_t {
+    kResultTiming = 1u << 0,
+};
+
+struct LUMINA_ALIGN(16) CommandResults {
+    uint32_t version;
+    uint32_t applied;    // records applied
+    uint32_t rejected;   // unknown types or payload sizes, skipped
+    uint32_t flags;      // CommandResultFlags for the sections filled in
+    FrameTiming timing;
+};
+
+static_assert(sizeof(CommandHeader) == 8, "CommandHeader layout changed");
+static_assert(sizeof(CommandTouch) == 24, "CommandTouch layout changed");
+static_assert(sizeof(CommandEffect) == 52, "CommandEffect layout changed");
+static_assert(offsetof(CommandResults, timing) == 16, "CommandResults layout changed");
+static_assert(sizeof(CommandResults) == 64, "CommandResults layout changed");
+
+struct CommandOutcome {
+    bool valid = false;          // version matched and every record fit the buffer
+    bool stateChanged = false;
+    bool frameRequested = false;
+    bool timingRequested = false;
+    uint32_t applied = 0;
+    uint32_t rejected = 0;
+};
+
+/**
+ * Applies the state commands in `data` to `state`, clamping enums and counts like
+ * the packet path, and reports the rest for the caller. A record of unknown type or
+ * the wrong payload size is skipped and counted. A wrong version, or a record that
+ * runs past `size`, rejects the whole stream (valid = false) before anything is
+ * applied. Does not touch stateId.
+ */
+CommandOutcome applyCommands(const void* data, size_t size, LuminaState& state);
+
+} // namespace lumina
+
+#endif // LUMINA_COMMAND_STREAM_H
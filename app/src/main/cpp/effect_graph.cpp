@@ -0,0 +1,98 @@
+#include "effect_graph.h"
+
+#include <algorithm>
+
+#include "blur_pyramid.h"
+
+namespace lumina {
+
+bool isSamplingEffect(EffectType type) {
+    switch (type) {
+        case EffectType::BLUR:
+        case EffectType::CHROMATIC_ABERRATION:
+        case EffectType::SHARPEN:
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool hasPointwiseTail(const EffectGraph& graph) {
+    if (graph.passCount < 2) return false;
+    const EffectPass& last = graph.passes[graph.passCount - 1];
+    return last.head == EffectType::NONE && last.pyramidSlot == kNoPyramid;
+}
+
+uint64_t effectVariantKey(const EffectPass& pass, const std::array<EffectParams, kMaxEffects>& effects,
+                          RenderMode mode, uint32_t flags, uint32_t format, uint32_t quarterTurns) {
+    // bits 0-2 flags, 3-6 head, 7-9 op count, 10-25 op types, 26-28 mode, 29-30 rotation,
+    // 32-63 format; bit 31 stays clear for pyramidVariantKey()
+    uint64_t key = flags & 0x7u;
+    key |= (static_cast<uint64_t>(pass.head) & 0xFu) << 3;
+    key |= (static_cast<uint64_t>(pass.opCount) & 0x7u) << 7;
+    for (uint8_t i = 0; i < pass.opCount && i < kMaxEffects; ++i) {
+        const EffectType type = effects[pass.ops[i] % kMaxEffects].type;
+        key |= (static_cast<uint64_t>(type) & 0xFu) << (10 + 4 * i);
+    }
+    key |= (static_cast<uint64_t>(mode) & 0x7u) << 26;
+    key |= (static_cast<uint64_t>(quarterTurns) & 0x3u) << 29;
+    key |= static_cast<uint64_t>(format) << 32;
+    return key;
+}
+
+EffectGraph buildEffectGraph(const LuminaState& state, const EffectGraphOptions& options) {
+    EffectGraph graph;
+    auto push = [&graph](EffectType head, uint8_t slot) -> EffectPass& {
+        EffectPass& pass = graph.passes[graph.passCount++];
+        pass = EffectPass{};
+        pass.head = head;
+        pass.headSlot = slot;
+        return pass;
+    };
+
+    const uint32_t count = std::min(state.activeEffectCount, kMaxEffects);
+    for (uint32_t i = 0; i < count; ++i) {
+        const EffectType type = state.effects[i].type;
+        if (type == EffectType::NONE || static_cast<uint32_t>(type) > static_cast<uint32_t>(EffectType::SHARPEN)) {
+            continue;
+        }
+        const uint8_t slot = static_cast<uint8_t>(i);
+
+        const bool pyramid = usesBlurPyramid(type);
+        if (isSamplingEffect(type)) {
+            if (graph.passCount == 0 && options.plainFetchFirst) push(EffectType::NONE, 0);
+            EffectPass& pass = push(type, slot);
+            if (pyramid) pass.pyramidSlot = slot;
+            continue;
+        }
+
+        // A pointwise op with a pyramid (BLOOM) needs a pass whose input it may sample
+        // and that has no pyramid yet.
+        if (pyramid && graph.passCount == 0 && options.plainFetchFirst) push(EffectType::NONE, 0);
+        const EffectPass* last = graph.passCount > 0 ? &graph.passes[graph.passCount - 1] : nullptr;
+        if (!last || (!options.fuseIntoSampling && last->head != EffectType::NONE) ||
+            (pyramid && (last->pyramidSlot != kNoPyramid || (options.plainFetchFirst && graph.passCount == 1)))) {
+            push(EffectType::NONE, 0);
+        }
+        EffectPass& pass = graph.passes[graph.passCount - 1];
+        if (pyramid) pass.pyramidSlot = slot;
+        pass.ops[pass.opCount++] = slot;
+    }
+
+    if (graph.passCount == 0) push(EffectType::NONE, 0);
+    return graph;
+}
+
+std::vector<LuminaState> warmupStates() {
+    constexpr uint32_t kLastType = static_cast<uint32_t>(EffectType::SHARPEN);
+    std::vector<LuminaState> states(kLastType + 1);
+    for (uint32_t type = 1; type <= kLastType; ++type) {
+        LuminaState& state = states[type];
+        state.effects[0].type = static_cast<EffectType>(type);
+        state.effects[0].intensity = 1.0f;
+        state.activeEffectCount = 1;
+    }
+    return states;
+}
+
+} // namespace lumina
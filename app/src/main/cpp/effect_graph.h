@@ -0,0 +1,92 @@
+#ifndef LUMINA_EFFECT_GRAPH_H
+#define LUMINA_EFFECT_GRAPH_H
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+#include "engine_structs.h"
+
+/**
+ * Lumina Virtual Studio - Effect Graph
+ *
+ * Turns the stacked effects of a LuminaState into an ordered list of render passes.
+ * Pointwise effects (per-pixel colour maths) are fused into the pass before them;
+ * effects that sample neighbouring texels need the previous result resolved into a
+ * texture and therefore start a new pass. Renderers ping-pong between two
+ * intermediate targets and write the final pass straight to the surface. BLUR and
+ * BLOOM also read a blur pyramid (blur_pyramid.h) the renderer builds from the pass
+ * input first; a pass holds at most one.
+ */
+
+namespace lumina {
+
+constexpr uint32_t kMaxEffects = 4; // LuminaState::effects capacity
+constexpr uint32_t kMaxEffectPasses = kMaxEffects + 1;
+constexpr uint8_t kNoPyramid = 0xFF;
+
+/**
+ * A single full-screen pass. The pass reads its input through `head` (a plain fetch
+ * when NONE), then applies `ops` in order. Slots index into LuminaState::effects;
+ * `pyramidSlot` is the head or op whose pyramid the pass reads, if any.
+ */
+struct EffectPass {
+    EffectType head = EffectType::NONE;
+    uint8_t headSlot = 0;
+    uint8_t opCount = 0;
+    std::array<uint8_t, kMaxEffects> ops{};
+    uint8_t pyramidSlot = kNoPyramid;
+};
+
+struct EffectGraph {
+    std::array<EffectPass, kMaxEffectPasses> passes{};
+    uint32_t passCount = 0;
+};
+
+struct EffectGraphOptions {
+    // Append pointwise ops to a sampling pass (GLES composes shader source). Backends
+    // with fixed per-effect shaders give pointwise ops their own pass instead.
+    bool fuseIntoSampling = true;
+    // The input can only be read by a plain-fetch pass (e.g. YCbCr camera images
+    // bound through an immutable sampler), so neither a sampling effect nor a blur
+    // pyramid ever reads it directly.
+    bool plainFetchFirst = false;
+};
+
+// Flags folded into an effect variant key.
+constexpr uint32_t kVariantLastPass = 1u << 0;      // writes the surface
+constexpr uint32_t kVariantExternalInput = 1u << 1; // reads an external/YCbCr camera image
+constexpr uint32_t kVariantSubpass = 1u << 2;       // runs inside the merged tail render pass
+
+/**
+ * Identifies a specialized shader variant: the pass shape (head effect and the types of
+ * its fused ops, not their parameters), the render mode, the flags above, the
+ * backend's target format and the quarter turns a surface pass pre-rotates by.
+ * Renderers cache one pipeline or program per key.
+ */
+uint64_t effectVariantKey(const EffectPass& pass, const std::array<EffectParams, kMaxEffects>& effects,
+                          RenderMode mode, uint32_t flags, uint32_t format, uint32_t quarterTurns = 0);
+
+/** True for effects that read neighbouring texels of their input. */
+bool isSamplingEffect(EffectType type);
+
+/**
+ * True when the last pass is a plain-fetch pass reading the pass before it and no
+ * pyramid of it. It only reads its own pixel, so a tiler can run both as subpasses of one render pass and
+ * keep the intermediate on chip instead of writing it out and sampling it back.
+ */
+bool hasPointwiseTail(const EffectGraph& graph);
+
+/** Plans the passes for the active effects; always yields at least one pass. */
+EffectGraph buildEffectGraph(const LuminaState& state, const EffectGraphOptions& options = {});
+
+/**
+ * The chains renderers build variants for ahead of the first frame: no effect, then
+ * each effect type alone, in the default render mode. Picking one effect then never
+ * stalls on shader compilation; longer stacks still build theirs on first use.
+ */
+std::vector<LuminaState> warmupStates();
+
+} // namespace lumina
+
+#endif // LUMINA_EFFECT_GRAPH_H
@@ -234,8 +234,8 @@ struct LUMINA_ALIGN(16) FrameTiming {
     float totalTime;
     uint64_t frameCount;
     float fps;
-    float gpuTime;
-    float cpuTime;
+    float gpuTime;   // seconds; newest resolved GPU frame (timestamp queries)
+    float cpuTime;   // seconds; previous render-thread frame
     float _padding[2];
 
     FrameTiming()
@@ -250,7 +250,8 @@ struct LUMINA_ALIGN(16) FrameTiming {
 
 /**
  * Main Lumina State - Central data contract
- * This structure is shared between Kotlin, C++, and Python layers
+ * This structure is shared between Kotlin, C++, and Python layers, byte for byte
+ * through the ring in shared_state.h, so layout changes bump kSharedStateVersion
  * 
  * Total size should be a multiple of 256 bytes for optimal GPU buffer alignment
  */
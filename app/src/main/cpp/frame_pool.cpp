@@ -0,0 +1,96 @@
+#include "frame_pool.h"
+
+#include <algorithm>
+
+namespace lumina {
+
+bool FramePool::configure(uint32_t slotCount, size_t slotBytes) {
+    if (slotCount == 0 || slotCount > kMaxSlots || slotBytes == 0) return false;
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    const bool busy = std::any_of(slots_.begin(), slots_.end(), [](const Slot& s) { return s.acquired; });
+    if (busy) return false;
+
+    const size_t rounded = (slotBytes + kSlotAlignment - 1) / kSlotAlignment * kSlotAlignment;
+    std::vector<Slot> slots(slotCount);
+    for (Slot& slot : slots) {
+        slot.memory.reset(static_cast<uint8_t*>(std::aligned_alloc(kSlotAlignment, rounded)));
+        if (!slot.memory) return false;
+    }
+    slots_ = std::move(slots);
+    slotBytes_ = rounded;
+    next_ = 0;
+    return true;
+}
+
+int FramePool::acquire() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    const uint32_t count = static_cast<uint32_t>(slots_.size());
+    for (uint32_t i = 0; i < count; ++i) {
+        const uint32_t index = (next_ + i) % count;
+        if (slots_[index].acquired) continue;
+        slots_[index].acquired = true;
+        next_ = (index + 1) % count;
+        return static_cast<int>(index);
+    }
+    return -1;
+}
+
+bool FramePool::release(int index) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!held(index)) return false;
+    slots_[index].acquired = false;
+    return true;
+}
+
+bool FramePool::retire(int index, uint64_t readyValue) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (readyValue == 0 || !held(index)) return false;
+    slots_[index].readyValue = readyValue;
+    return true;
+}
+
+uint32_t FramePool::collect(uint64_t completedValue) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    uint32_t collected = 0;
+    for (Slot& slot : slots_) {
+        if (slot.readyValue == 0 || slot.readyValue > completedValue) continue;
+        slot.readyValue = 0;
+        slot.acquired = false;
+        ++collected;
+    }
+    return collected;
+}
+
+uint32_t FramePool::retiredCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<uint32_t>(std::count_if(slots_.begin(), slots_.end(), [](const Slot& s) { return s.readyValue != 0; }));
+}
+
+uint8_t* FramePool::data(int index) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!held(index)) return nullptr;
+    return slots_[index].memory.get();
+}
+
+bool FramePool::held(int index) const {
+    return index >= 0 && static_cast<size_t>(index) < slots_.size() && slots_[index].acquired &&
+           slots_[index].readyValue == 0;
+}
+
+uint32_t FramePool::slotCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<uint32_t>(slots_.size());
+}
+
+size_t FramePool::slotBytes() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return slotBytes_;
+}
+
+uint32_t FramePool::acquiredCount() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return static_cast<uint32_t>(std::count_if(slots_.begin(), slots_.end(), [](const Slot& s) { return s.acquired; }));
+}
+
+} // namespace lumina
@@ -0,0 +1,86 @@
+#ifndef LUMINA_FRAME_POOL_H
+#define LUMINA_FRAME_POOL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+/**
+ * Lumina Virtual Studio - Camera frame pool
+ *
+ * A fixed set of equally sized CPU frame slots owned by native code. Kotlin wraps
+ * each slot once with NewDirectByteBuffer and keeps the wrapper, so steady-state
+ * camera ingest allocates nothing. A slot is handed to exactly one producer by
+ * acquire() and only comes back through release(), or through retire() and a later
+ * collect() once the upload that read it has executed on the GPU: the producer can
+ * never overwrite a frame that is still being consumed, and the camera can run at most
+ * slotCount() frames ahead.
+ *
+ * Slot memory is only reallocated by configure(), which refuses while any slot is
+ * out; callers must drop their wrappers before reconfiguring.
+ */
+
+namespace lumina {
+
+class FramePool {
+public:
+    static constexpr uint32_t kMaxSlots = 8;
+    static constexpr size_t kSlotAlignment = 64;  // cache line; NEON / memcpy friendly
+
+    /**
+     * (Re)allocates `slotCount` slots of `slotBytes` each. Returns false, keeping the
+     * current slots, when the arguments are out of range or any slot is acquired.
+     */
+    bool configure(uint32_t slotCount, size_t slotBytes);
+
+    /** Hands out a free slot, or returns -1 when every slot is in use. */
+    int acquire();
+
+    /** Returns `index` to the pool; false if it was not acquired or is retired. */
+    bool release(int index);
+
+    /**
+     * The producer is done with `index`, which an upload signalling `readyValue` reads:
+     * the slot stays out until collect() reaches that value. False if it was not
+     * acquired, already retired, or `readyValue` is 0.
+     */
+    bool retire(int index, uint64_t readyValue);
+
+    /** Returns every retired slot whose upload value is at most `completedValue`. */
+    uint32_t collect(uint64_t completedValue);
+
+    /** Slots retired but not yet collected. */
+    uint32_t retiredCount() const;
+
+    /** Slot memory for an acquired index the producer still holds; null otherwise. */
+    uint8_t* data(int index) const;
+
+    uint32_t slotCount() const;
+    size_t slotBytes() const;
+    uint32_t acquiredCount() const;
+
+private:
+    struct AlignedFree {
+        void operator()(uint8_t* p) const { std::free(p); }
+    };
+    struct Slot {
+        std::unique_ptr<uint8_t, AlignedFree> memory;
+        bool acquired = false;
+        uint64_t readyValue = 0;  // non-zero while retired
+    };
+
+    // Acquired and not retired; callers hold mutex_.
+    bool held(int index) const;
+
+    mutable std::mutex mutex_;
+    std::vector<Slot> slots_;
+    size_t slotBytes_ = 0;
+    uint32_t next_ = 0;  // round-robin start, so consecutive frames use different slots
+};
+
+} // namespace lumina
+
+#endif // LUMINA_FRAME_POOL_H
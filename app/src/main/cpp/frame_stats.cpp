@@ -0,0 +1,137 @@
+#include "frame_stats.h"
+
+#include <algorithm>
+#include <cstdio>
+
+namespace lumina {
+
+namespace {
+
+constexpr const char* kStageNames[] = {"ingest", "upload", "record", "submit", "cpuFrame", "gpuFrame"};
+static_assert(sizeof(kStageNames) / sizeof(kStageNames[0]) == static_cast<size_t>(FrameStage::Count),
+              "kStageNames must cover every FrameStage");
+
+// Nearest-rank percentile over an already partially ordered copy.
+float rank(std::array<float, kStatsWindow>& sorted, size_t count, float fraction) {
+    const size_t index = std::min(count - 1, static_cast<size_t>(fraction * static_cast<float>(count)));
+    std::nth_element(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(index),
+                     sorted.begin() + static_cast<std::ptrdiff_t>(count));
+    return sorted[index];
+}
+
+void appendPercentiles(std::string& out, const Percentiles& p) {
+    char buffer[128];
+    std::snprintf(buffer, sizeof(buffer), R"({"p50":%.3f,"p95":%.3f,"p99":%.3f,"samples":%u})",
+                  p.p50, p.p95, p.p99, p.samples);
+    out += buffer;
+}
+
+} // namespace
+
+void RollingHistogram::add(float value) {
+    samples_[next_] = value;
+    next_ = (next_ + 1) % kStatsWindow;
+    count_ = std::min(count_ + 1, kStatsWindow);
+    last_ = value;
+}
+
+Percentiles RollingHistogram::percentiles() const {
+    Percentiles result;
+    result.samples = static_cast<uint32_t>(count_);
+    if (count_ == 0) return result;
+    std::array<float, kStatsWindow> sorted = samples_;
+    result.p50 = rank(sorted, count_, 0.50f);
+    result.p95 = rank(sorted, count_, 0.95f);
+    result.p99 = rank(sorted, count_, 0.99f);
+    return result;
+}
+
+void RollingHistogram::reset() {
+    next_ = count_ = 0;
+    last_ = 0.0f;
+}
+
+void FrameStats::record(FrameStage stage, float milliseconds) {
+    if (stage == FrameStage::Count) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    stages_[static_cast<size_t>(stage)].add(milliseconds);
+}
+
+void FrameStats::recordGpuPasses(const float* passMilliseconds, uint32_t passCount) {
+    passCount = std::min<uint32_t>(passCount, kMaxEffectPasses);
+    float total = 0.0f;
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (uint32_t i = 0; i < passCount; ++i) {
+        passes_[i].add(passMilliseconds[i]);
+        total += passMilliseconds[i];
+    }
+    passCount_ = std::max(passCount_, passCount);
+    stages_[static_cast<size_t>(FrameStage::GpuFrame)].add(total);
+}
+
+void FrameStats::recordGpuMemory(const GpuMemoryUsage& usage) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    gpuMemory_ = usage;
+}
+
+GpuMemoryUsage FrameStats::gpuMemory() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return gpuMemory_;
+}
+
+Percentiles FrameStats::percentiles(FrameStage stage) const {
+    if (stage == FrameStage::Count) return {};
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stages_[static_cast<size_t>(stage)].percentiles();
+}
+
+Percentiles FrameStats::passPercentiles(uint32_t pass) const {
+    if (pass >= kMaxEffectPasses) return {};
+    std::lock_guard<std::mutex> lock(mutex_);
+    return passes_[pass].percentiles();
+}
+
+float FrameStats::last(FrameStage stage) const {
+    if (stage == FrameStage::Count) return 0.0f;
+    std::lock_guard<std::mutex> lock(mutex_);
+    return stages_[static_cast<size_t>(stage)].last();
+}
+
+void FrameStats::reset() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto& stage : stages_) stage.reset();
+    for (auto& pass : passes_) pass.reset();
+    passCount_ = 0;
+}
+
+std::string FrameStats::toJson() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::string out = "{";
+    for (size_t i = 0; i < stages_.size(); ++i) {
+        out += '"';
+        out += kStageNames[i];
+        out += "\":";
+        appendPercentiles(out, stages_[i].percentiles());
+        out += ',';
+    }
+    out += "\"gpuMemory\":{";
+    char buffer[128];
+    for (size_t i = 0; i < kGpuMemoryCategoryCount; ++i) {
+        std::snprintf(buffer, sizeof(buffer), "\"%s\":%llu,",
+                      gpuMemoryCategoryName(static_cast<GpuMemoryCategory>(i)),
+                      static_cast<unsigned long long>(gpuMemory_.used[i]));
+        out += buffer;
+    }
+    std::snprintf(buffer, sizeof(buffer), R"("reserved":%llu,"allocations":%u,"blocks":%u},)",
+                  static_cast<unsigned long long>(gpuMemory_.reserved), gpuMemory_.allocations, gpuMemory_.blocks);
+    out += buffer;
+    out += "\"passes\":[";
+    for (uint32_t i = 0; i < passCount_; ++i) {
+        if (i > 0) out += ',';
+        appendPercentiles(out, passes_[i].percentiles());
+    }
+    out += "]}";
+    return out;
+}
+
+} // namespace lumina
@@ -0,0 +1,115 @@
+#ifndef LUMINA_FRAME_STATS_H
+#define LUMINA_FRAME_STATS_H
+
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+
+#include "effect_graph.h"
+#include "gpu_memory.h"
+
+/**
+ * Lumina Virtual Studio - Frame Statistics
+ *
+ * Rolling per-stage timings for the hot path. CPU stages are timed with
+ * ScopedStageTimer where the work happens (state ingest on JNI threads, camera
+ * uploads on the camera thread, record/submit on the render thread); GPU pass times
+ * come back from timestamp queries a few frames later. Each stage keeps the last
+ * kStatsWindow samples and reports p50/p95/p99 on demand.
+ *
+ * GPU memory is a gauge rather than a window: the renderer reports its current
+ * usage whenever it allocates or frees, and reset() leaves it alone.
+ *
+ * Samples are recorded from several threads; the lock only covers a ring-buffer
+ * store, so it is never held across real work.
+ */
+
+namespace lumina {
+
+enum class FrameStage : uint8_t {
+    Ingest,    // JSON / packet state updates
+    Upload,    // camera frame uploads and imports
+    Record,    // command recording (Vulkan) or GL command issue
+    Submit,    // queue submit + present, or eglSwapBuffers
+    CpuFrame,  // whole render-thread frame
+    GpuFrame,  // sum of GPU pass times
+    Count
+};
+
+constexpr size_t kStatsWindow = 240;  // ~2 s at 120 Hz
+
+struct Percentiles {
+    float p50 = 0.0f;
+    float p95 = 0.0f;
+    float p99 = 0.0f;
+    uint32_t samples = 0;
+};
+
+class RollingHistogram {
+public:
+    void add(float value);
+    Percentiles percentiles() const;
+    float last() const { return last_; }
+    void reset();
+
+private:
+    std::array<float, kStatsWindow> samples_{};
+    size_t next_ = 0;
+    size_t count_ = 0;
+    float last_ = 0.0f;
+};
+
+class FrameStats {
+public:
+    void record(FrameStage stage, float milliseconds);
+
+    // One resolved GPU frame: per-pass times in milliseconds. Also feeds GpuFrame.
+    void recordGpuPasses(const float* passMilliseconds, uint32_t passCount);
+
+    // Current device memory usage, replacing the previous report.
+    void recordGpuMemory(const GpuMemoryUsage& usage);
+    GpuMemoryUsage gpuMemory() const;
+
+    Percentiles percentiles(FrameStage stage) const;
+    Percentiles passPercentiles(uint32_t pass) const;
+    float last(FrameStage stage) const;
+    void reset();
+
+    // {"cpuFrame":{"p50":..,"p95":..,"p99":..,"samples":..},...,
+    //  "gpuMemory":{"textures":bytes,...,"reserved":bytes,"allocations":n,"blocks":n},"passes":[...]}
+    std::string toJson() const;
+
+private:
+    mutable std::mutex mutex_;
+    std::array<RollingHistogram, static_cast<size_t>(FrameStage::Count)> stages_{};
+    std::array<RollingHistogram, kMaxEffectPasses> passes_{};
+    uint32_t passCount_ = 0;
+    GpuMemoryUsage gpuMemory_{};
+};
+
+/** Records the lifetime of the scope as one sample of `stage`; no-op when stats is null. */
+class ScopedStageTimer {
+public:
+    ScopedStageTimer(FrameStats* stats, FrameStage stage)
+        : stats_(stats), stage_(stage), start_(std::chrono::steady_clock::now()) {}
+    ~ScopedStageTimer() {
+        if (!stats_) return;
+        const auto elapsed = std::chrono::steady_clock::now() - start_;
+        stats_->record(stage_, std::chrono::duration<float, std::milli>(elapsed).count());
+    }
+
+    ScopedStageTimer(const ScopedStageTimer&) = delete;
+    ScopedStageTimer& operator=(const ScopedStageTimer&) = delete;
+
+private:
+    FrameStats* stats_;
+    FrameStage stage_;
+    std::chrono::steady_clock::time_point start_;
+};
+
+} // namespace lumina
+
+#endif // LUMINA_FRAME_STATS_H
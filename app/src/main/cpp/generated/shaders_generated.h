@@ -1,6 +0,0 @@
-#pragma once
-#include <array>
-#include <cstdint>
-
-const std::vector<uint32_t> VulkanRenderer::kVertSpv = {119734787, 65536, 851978, 31, 0, 131089, 1, 393227, 1, 1280527431, 1685353262, 808793134, 0, 196622, 0, 1, 589839, 0, 4, 1852399981, 0, 13, 18, 28, 29, 196611, 2, 450, 655364, 1197427783, 1279741775, 1885560645, 1953718128, 1600482425, 1701734764, 1919509599, 1769235301, 25974, 524292, 1197427783, 1279741775, 1852399429, 1685417059, 1768185701, 1952671090, 6649449, 262149, 4, 1852399981, 0, 393221, 11, 1348430951, 1700164197, 2019914866, 0, 393222, 11, 0, 1348430951, 1953067887, 7237481, 458758, 11, 1, 1348430951, 1953393007, 1702521171, 0, 458758, 11, 2, 1130327143, 1148217708, 1635021673, 6644590, 458758, 11, 3, 1130327143, 1147956341, 1635021673, 6644590, 196613, 13, 0, 327685, 18, 1936674913, 1869182057, 110, 327685, 28, 2019906678, 1919905603, 100, 327685, 29, 2019906657, 1919905603, 100, 327752, 11, 0, 11, 0, 327752, 11, 1, 11, 1, 327752, 11, 2, 11, 3, 327752, 11, 3, 11, 4, 196679, 11, 2, 262215, 18, 30, 0, 262215, 28, 30, 0, 262215, 29, 30, 1, 131091, 2, 196641, 3, 2, 196630, 6, 32, 262167, 7, 6, 4, 262165, 8, 32, 0, 262187, 8, 9, 1, 262172, 10, 6, 9, 393246, 11, 7, 6, 10, 10, 262176, 12, 3, 11, 262203, 12, 13, 3, 262165, 14, 32, 1, 262187, 14, 15, 0, 262167, 16, 6, 2, 262176, 17, 1, 16, 262203, 17, 18, 1, 262187, 6, 20, 0, 262187, 6, 21, 1065353216, 262176, 25, 3, 7, 262176, 27, 3, 16, 262203, 27, 28, 3, 262203, 17, 29, 1, 327734, 2, 4, 0, 3, 131320, 5, 262205, 16, 19, 18, 327761, 6, 22, 19, 0, 327761, 6, 23, 19, 1, 458832, 7, 24, 22, 23, 20, 21, 327745, 25, 26, 13, 15, 196670, 26, 24, 262205, 16, 30, 29, 196670, 28, 30, 65789, 65592};
-const std::vector<uint32_t> VulkanRenderer::kFragSpv = {119734787, 65536, 851978, 73, 0, 131089, 1, 393227, 1, 1280527431, 1685353262, 808793134, 0, 196622, 0, 1, 458767, 4, 4, 1852399981, 0, 25, 67, 196624, 4, 7, 196611, 2, 450, 655364, 1197427783, 1279741775, 1885560645, 1953718128, 1600482425, 1701734764, 1919509599, 1769235301, 25974, 524292, 1197427783, 1279741775, 1852399429, 1685417059, 1768185701, 1952671090, 6649449, 262149, 4, 1852399981, 0, 262149, 8, 1936090735, 29797, 393221, 11, 1752397136, 1936617283, 1953390964, 115, 393222, 11, 0, 1702129257, 1953067886, 121, 393221, 13, 1752397168, 1936617283, 1953390964, 115, 327685, 23, 1953391971, 1684370021, 0, 327685, 25, 2019906678, 1919905603, 100, 196613, 30, 7498084, 196613, 38, 114, 327685, 42, 2019906677, 1701999988, 0, 196613, 52, 103, 196613, 58, 98, 327685, 67, 1131705711, 1919904879, 0, 327752, 11, 0, 35, 0, 196679, 11, 2, 262215, 25, 30, 0, 262215, 42, 34, 0, 262215, 42, 33, 0, 262215, 67, 30, 0, 131091, 2, 196641, 3, 2, 196630, 6, 32, 262176, 7, 7, 6, 262187, 6, 9, 990057071, 262187, 6, 10, 998445679, 196638, 11, 6, 262176, 12, 9, 11, 262203, 12, 13, 9, 262165, 14, 32, 1, 262187, 14, 15, 0, 262176, 16, 9, 6, 262167, 21, 6, 2, 262176, 22, 7, 21, 262176, 24, 1, 21, 262203, 24, 25, 1, 262187, 6, 27, 1056964608, 262187, 6, 32, 953267991, 589849, 39, 6, 1, 0, 0, 0, 1, 0, 196635, 40, 39, 262176, 41, 0, 40, 262203, 41, 42, 0, 262167, 47, 6, 4, 262165, 49, 32, 0, 262187, 49, 50, 0, 262187, 49, 56, 1, 262187, 49, 64, 2, 262176, 66, 3, 47, 262203, 66, 67, 3, 262187, 6, 71, 1065353216, 327734, 2, 4, 0, 3, 131320, 5, 262203, 7, 8, 7, 262203, 22, 23, 7, 262203, 22, 30, 7, 262203, 7, 38, 7, 262203, 7, 52, 7, 262203, 7, 58, 7, 327745, 16, 17, 13, 15, 262205, 6, 18, 17, 327813, 6, 19, 10, 18, 327809, 6, 20, 9, 19, 196670, 8, 20, 262205, 21, 26, 25, 327760, 21, 28, 27, 27, 327811, 21, 29, 26, 28, 196670, 23, 29, 262205, 21, 31, 23, 327760, 21, 33, 32, 32, 327809, 21, 34, 31, 33, 393228, 21, 35, 1, 69, 34, 262205, 6, 36, 8, 327822, 21, 37, 35, 36, 196670, 30, 37, 262205, 40, 43, 42, 262205, 21, 44, 25, 262205, 21, 45, 30, 327811, 21, 46, 44, 45, 327767, 47, 48, 43, 46, 327761, 6, 51, 48, 0, 196670, 38, 51, 262205, 40, 53, 42, 262205, 21, 54, 25, 327767, 47, 55, 53, 54, 327761, 6, 57, 55, 1, 196670, 52, 57, 262205, 40, 59, 42, 262205, 21, 60, 25, 262205, 21, 61, 30, 327809, 21, 62, 60, 61, 327767, 47, 63, 59, 62, 327761, 6, 65, 63, 2, 196670, 58, 65, 262205, 6, 68, 38, 262205, 6, 69, 52, 262205, 6, 70, 58, 458832, 47, 72, 68, 69, 70, 71, 196670, 67, 72, 65789, 65592};
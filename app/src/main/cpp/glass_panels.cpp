@@ -0,0 +1,88 @@
+#include "glass_panels.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace lumina {
+
+namespace {
+
+// pyramidVariantKey() keeps the stage in bits 3-6 and only uses the first few values.
+// The variant flags (bits 0-2) stay clear, as the glass pass reads no camera input.
+constexpr uint64_t kGlassStage = 0xFu;
+
+} // namespace
+
+GlassLayout makeGlassLayout(const float* values, size_t count) {
+    GlassLayout layout;
+    if (!values) return layout;
+    for (size_t i = 0; i + kGlassPanelFloats <= count && layout.count < kMaxGlassPanels;
+         i += kGlassPanelFloats) {
+        const float* v = values + i;
+        if (!std::all_of(v, v + kGlassPanelFloats, [](float f) { return std::isfinite(f); })) continue;
+
+        GlassPanel panel;
+        panel.left = std::clamp(v[0], 0.0f, 1.0f);
+        panel.top = std::clamp(v[1], 0.0f, 1.0f);
+        panel.right = std::clamp(v[2], 0.0f, 1.0f);
+        panel.bottom = std::clamp(v[3], 0.0f, 1.0f);
+        panel.cornerRadius = std::max(v[4], 0.0f);
+        if (panel.right <= panel.left || panel.bottom <= panel.top) continue;
+        layout.panels[layout.count++] = panel;
+    }
+    return layout;
+}
+
+PixelRect glassScissor(const GlassPanel& panel, uint32_t quarterTurns,
+                       uint32_t fbWidth, uint32_t fbHeight) {
+    // Display (u, v) lands on framebuffer (1 - v, u) after one clockwise turn.
+    float left = panel.left, top = panel.top, right = panel.right, bottom = panel.bottom;
+    switch (quarterTurns % 4) {
+        case 1:
+            left = 1.0f - panel.bottom; right = 1.0f - panel.top;
+            top = panel.left; bottom = panel.right;
+            break;
+        case 2:
+            left = 1.0f - panel.right; right = 1.0f - panel.left;
+            top = 1.0f - panel.bottom; bottom = 1.0f - panel.top;
+            break;
+        case 3:
+            left = panel.top; right = panel.bottom;
+            top = 1.0f - panel.right; bottom = 1.0f - panel.left;
+            break;
+        default:
+            break;
+    }
+
+    const auto edge = [](float f, uint32_t size, bool up) {
+        const float px = up ? std::ceil(f * size) : std::floor(f * size);
+        return static_cast<uint32_t>(std::clamp(px, 0.0f, static_cast<float>(size)));
+    };
+    const uint32_t x0 = edge(left, fbWidth, false);
+    const uint32_t y0 = edge(top, fbHeight, false);
+    const uint32_t x1 = edge(right, fbWidth, true);
+    const uint32_t y1 = edge(bottom, fbHeight, true);
+
+    PixelRect rect;
+    rect.x = static_cast<int32_t>(x0);
+    rect.y = static_cast<int32_t>(y0);
+    rect.width = x1 > x0 ? x1 - x0 : 0;
+    rect.height = y1 > y0 ? y1 - y0 : 0;
+    return rect;
+}
+
+float glassCornerRadius(const GlassPanel& panel, uint32_t width, uint32_t height) {
+    const float w = (panel.right - panel.left) * width;
+    const float h = (panel.bottom - panel.top) * height;
+    return std::clamp(panel.cornerRadius * width, 0.0f, 0.5f * std::min(w, h));
+}
+
+uint64_t glassVariantKey(uint32_t quarterTurns, uint32_t format) {
+    uint64_t key = 1ull << 31;
+    key |= kGlassStage << 3;
+    key |= (static_cast<uint64_t>(quarterTurns) & 0x3u) << 29;
+    key |= static_cast<uint64_t>(format) << 32;
+    return key;
+}
+
+} // namespace lumina
@@ -0,0 +1,76 @@
+#ifndef LUMINA_GLASS_PANELS_H
+#define LUMINA_GLASS_PANELS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Lumina Virtual Studio - Glass panels
+ *
+ * The UI's frosted panels blur what lies behind them on the GPU rather than in
+ * Compose: the UI reports where each panel sits, and once the frame is finished, and
+ * copied to the encoder, the renderer runs the same dual-filter pyramid as BLUR
+ * (blur_pyramid.h) over it and draws the blurred frame back inside every panel's
+ * rounded rectangle. The glass radius, saturation and brightness come from the UI
+ * style (GlassmorphicParams); recordings never see the panels.
+ */
+
+namespace lumina {
+
+constexpr uint32_t kMaxGlassPanels = 16;
+
+/** Floats per panel in a makeGlassLayout() array: left, top, right, bottom, corner radius. */
+constexpr size_t kGlassPanelFloats = 5;
+
+struct GlassPanel {
+    // Fractions of the displayed surface, origin top-left.
+    float left = 0.0f;
+    float top = 0.0f;
+    float right = 0.0f;
+    float bottom = 0.0f;
+    float cornerRadius = 0.0f;  // fraction of the surface width
+};
+
+struct GlassLayout {
+    std::array<GlassPanel, kMaxGlassPanels> panels{};
+    uint32_t count = 0;
+};
+
+/**
+ * Layout from `count` floats, kGlassPanelFloats per panel. Edges are clamped to the
+ * surface; panels left empty or holding non-finite values are dropped, and panels
+ * past kMaxGlassPanels are ignored.
+ */
+GlassLayout makeGlassLayout(const float* values, size_t count);
+
+struct PixelRect {
+    int32_t x = 0;       // origin top-left
+    int32_t y = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+};
+
+/**
+ * Framebuffer pixels covering `panel`, grown to whole pixels. `quarterTurns` is the
+ * clockwise pre-rotation between the displayed surface and a `fbWidth` x `fbHeight`
+ * framebuffer in its native orientation (0 when they match).
+ */
+PixelRect glassScissor(const GlassPanel& panel, uint32_t quarterTurns,
+                       uint32_t fbWidth, uint32_t fbHeight);
+
+/**
+ * Corner radius of `panel` in pixels of a `width` x `height` display, no larger than
+ * half its shorter side.
+ */
+float glassCornerRadius(const GlassPanel& panel, uint32_t width, uint32_t height);
+
+/**
+ * Variant key of the glass pipeline, disjoint from effectVariantKey() and from every
+ * pyramidVariantKey() stage so it can share their cache.
+ */
+uint64_t glassVariantKey(uint32_t quarterTurns, uint32_t format);
+
+} // namespace lumina
+
+#endif // LUMINA_GLASS_PANELS_H
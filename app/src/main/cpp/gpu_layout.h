@@ -0,0 +1,64 @@
+#ifndef LUMINA_GPU_LAYOUT_H
+#define LUMINA_GPU_LAYOUT_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+/**
+ * Lumina Virtual Studio - Reflected shader block layouts
+ *
+ * The Gradle shader task reads the uniform and push-constant blocks back out of each
+ * compiled SPIR-V module and writes them to generated/shader_layouts_generated.h as
+ * constexpr BlockLayouts, one namespace per shader under lumina::shader_layout. C++
+ * structs that are copied into those blocks as raw bytes (lumina::EffectParams into
+ * EffectChain, the renderer's push constants) are then checked member by member at
+ * compile time, so a GLSL edit that moves a field fails the build instead of the frame.
+ *
+ * Offsets and sizes are in bytes as the compiler laid them out (std140 for uniform
+ * blocks, std430 for push constants). Member names are the GLSL ones; the mirrors use
+ * the same names so the checks can be written per field.
+ */
+
+namespace lumina {
+
+struct BlockMember {
+    std::string_view name;
+    uint32_t offset;
+    uint32_t size;         // whole member; arrays include every element
+    uint32_t arrayStride;  // 0 unless the member is an array
+};
+
+template <size_t N>
+struct BlockLayout {
+    std::string_view name;
+    uint32_t size;  // end of the last member
+    std::array<BlockMember, N> members;
+
+    constexpr const BlockMember* find(std::string_view member) const {
+        for (const BlockMember& m : members) {
+            if (m.name == member) return &m;
+        }
+        return nullptr;
+    }
+
+    // True when `member` exists and sits at `offset` with `size` bytes.
+    constexpr bool matches(std::string_view member, size_t offset, size_t size) const {
+        const BlockMember* m = find(member);
+        return m != nullptr && m->offset == offset && m->size == size;
+    }
+};
+
+} // namespace lumina
+
+// Checks that Type::field lines up with the like-named member of a reflected block.
+#define LUMINA_ASSERT_BLOCK_MEMBER(block, Type, field)                                     \
+    static_assert((block).matches(#field, offsetof(Type, field), sizeof(Type::field)),     \
+                  #Type "::" #field " does not match shader block member " #field)
+
+// Checks that Type covers the block exactly, so no member was added on one side only.
+#define LUMINA_ASSERT_BLOCK_SIZE(block, Type) \
+    static_assert((block).size == sizeof(Type), #Type " does not match the size of its shader block")
+
+#endif // LUMINA_GPU_LAYOUT_H
@@ -0,0 +1,68 @@
+#include "gpu_memory.h"
+
+#include <iterator>
+
+namespace lumina {
+
+namespace {
+
+constexpr const char* kCategoryNames[] = {"textures", "targets", "staging", "readback", "uniforms"};
+static_assert(sizeof(kCategoryNames) / sizeof(kCategoryNames[0]) == kGpuMemoryCategoryCount,
+              "kCategoryNames must cover every GpuMemoryCategory");
+
+} // namespace
+
+const char* gpuMemoryCategoryName(GpuMemoryCategory category) {
+    const size_t index = static_cast<size_t>(category);
+    return index < kGpuMemoryCategoryCount ? kCategoryNames[index] : "unknown";
+}
+
+BlockSuballocator::BlockSuballocator(uint64_t size) : size_(size) {
+    if (size_ > 0) free_.emplace(0, size_);
+}
+
+std::optional<uint64_t> BlockSuballocator::allocate(uint64_t size, uint64_t alignment) {
+    if (size == 0 || alignment == 0 || (alignment & (alignment - 1)) != 0) return std::nullopt;
+    for (auto it = free_.begin(); it != free_.end(); ++it) {
+        const uint64_t start = it->first;
+        const uint64_t end = start + it->second;
+        const uint64_t offset = (start + alignment - 1) & ~(alignment - 1);
+        if (offset >= end || end - offset < size) continue;
+
+        free_.erase(it);
+        if (offset > start) free_.emplace(start, offset - start);
+        if (offset + size < end) free_.emplace(offset + size, end - offset - size);
+        allocated_.emplace(offset, size);
+        used_ += size;
+        return offset;
+    }
+    return std::nullopt;
+}
+
+bool BlockSuballocator::release(uint64_t offset) {
+    const auto found = allocated_.find(offset);
+    if (found == allocated_.end()) return false;
+    uint64_t start = offset;
+    uint64_t size = found->second;
+    used_ -= size;
+    allocated_.erase(found);
+
+    // Merge with the free range that ends here and the one that starts right after.
+    auto next = free_.lower_bound(start);
+    if (next != free_.begin()) {
+        const auto prev = std::prev(next);
+        if (prev->first + prev->second == start) {
+            start = prev->first;
+            size += prev->second;
+            free_.erase(prev);
+        }
+    }
+    if (next != free_.end() && start + size == next->first) {
+        size += next->second;
+        free_.erase(next);
+    }
+    free_.emplace(start, size);
+    return true;
+}
+
+} // namespace lumina
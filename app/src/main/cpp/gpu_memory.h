@@ -0,0 +1,80 @@
+#ifndef LUMINA_GPU_MEMORY_H
+#define LUMINA_GPU_MEMORY_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <optional>
+
+/**
+ * Lumina Virtual Studio - GPU memory sub-allocation
+ *
+ * The Vulkan renderer takes device memory in large blocks and places images and
+ * buffers inside them, so steady-state resizes, render-scale changes and upload slots
+ * reuse a handful of allocations instead of growing towards maxMemoryAllocationCount.
+ * This is the API-free part: the offset bookkeeping for one block and the usage
+ * figures reported through FrameStats. Device memory itself stays in the renderer.
+ *
+ * Not thread-safe; the renderer is only driven under the engine lock.
+ */
+
+namespace lumina {
+
+// Block size for sub-allocated memory types; big enough for a few 1080p RGBA targets.
+constexpr uint64_t kGpuMemoryBlockSize = 32ull << 20;
+
+// Requests above this get device memory of their own rather than half a block.
+constexpr uint64_t kGpuDedicatedThreshold = kGpuMemoryBlockSize / 2;
+
+enum class GpuMemoryCategory : uint8_t {
+    Textures,  // camera upload images and the placeholder
+    Targets,   // effect, blur pyramid, merged tail, analysis and headless targets
+    Staging,   // upload staging buffers
+    Readback,  // analysis readback buffers
+    Uniforms,  // effect chain uniform buffer
+    Count
+};
+
+constexpr size_t kGpuMemoryCategoryCount = static_cast<size_t>(GpuMemoryCategory::Count);
+
+const char* gpuMemoryCategoryName(GpuMemoryCategory category);
+
+struct GpuMemoryUsage {
+    std::array<uint64_t, kGpuMemoryCategoryCount> used{};  // bytes bound to resources
+    uint64_t reserved = 0;     // device memory held, block slack included
+    uint32_t allocations = 0;  // live device memory objects
+    uint32_t blocks = 0;       // of which shared blocks
+};
+
+/**
+ * First-fit offset allocator over one block of `size` bytes. Free ranges are kept
+ * sorted and merged with their neighbours on release, so a block that empties out is
+ * one range again. Offsets are handed out aligned; the padding in front of an aligned
+ * offset stays free.
+ */
+class BlockSuballocator {
+public:
+    explicit BlockSuballocator(uint64_t size);
+
+    /** Offset of `size` bytes aligned to `alignment` (a power of two), or nullopt when full. */
+    std::optional<uint64_t> allocate(uint64_t size, uint64_t alignment);
+
+    /** Returns the range allocated at `offset`; false if there is none. */
+    bool release(uint64_t offset);
+
+    uint64_t size() const { return size_; }
+    uint64_t used() const { return used_; }
+    bool empty() const { return allocated_.empty(); }
+    size_t freeRangeCount() const { return free_.size(); }
+
+private:
+    uint64_t size_;
+    uint64_t used_ = 0;
+    std::map<uint64_t, uint64_t> free_;       // offset -> size
+    std::map<uint64_t, uint64_t> allocated_;  // offset -> size
+};
+
+} // namespace lumina
+
+#endif // LUMINA_GPU_MEMORY_H
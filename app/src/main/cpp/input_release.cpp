@@ -0,0 +1,36 @@
+#include "input_release.h"
+
+namespace lumina {
+
+uint64_t InputReleaseTracker::attach() {
+    detach();
+    current_.token = nextToken_++;
+    return current_.token;
+}
+
+void InputReleaseTracker::detach() {
+    if (current_.token != 0) replaced_.push_back(current_);
+    current_ = Input{};
+}
+
+void InputReleaseTracker::sampled(uint64_t frame) {
+    if (current_.token == 0) return;
+    current_.lastFrame = frame;
+    current_.sampled = true;
+}
+
+void InputReleaseTracker::collect(uint64_t completedFrames) {
+    // A buffer replaced before any frame drew it has nothing to wait for.
+    while (!replaced_.empty() && (!replaced_.front().sampled || replaced_.front().lastFrame < completedFrames)) {
+        released_ = replaced_.front().token;
+        replaced_.pop_front();
+    }
+}
+
+void InputReleaseTracker::releaseAll() {
+    detach();
+    if (!replaced_.empty()) released_ = replaced_.back().token;
+    replaced_.clear();
+}
+
+} // namespace lumina
@@ -0,0 +1,64 @@
+#ifndef LUMINA_INPUT_RELEASE_H
+#define LUMINA_INPUT_RELEASE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+
+/**
+ * Lumina Virtual Studio - Producer buffer hand-back
+ *
+ * A zero-copy camera frame is an AHardwareBuffer the renderer samples in place. Taking
+ * a reference keeps the memory alive but not the contents: once CameraX gets its Image
+ * back it queues the buffer for the camera to fill again. The producer therefore keeps
+ * each imported Image open until every GPU frame that read it has finished.
+ *
+ * This tracker hands out a token per imported buffer and reports the newest token whose
+ * buffer the renderer is done with. Inputs are replaced in order and frames complete in
+ * order, so one watermark covers every earlier token as well. Frame indices are the
+ * renderer's own submission count: a frame `f` has finished once `f < completedFrames`.
+ *
+ * Not thread-safe; the engine drives it under its lock.
+ */
+
+namespace lumina {
+
+class InputReleaseTracker {
+public:
+    /** A producer-owned buffer is the renderer's input from now on; returns its token (never 0). */
+    uint64_t attach();
+
+    /** The renderer samples something it owns instead: a CPU upload, a decoded video frame. */
+    void detach();
+
+    /** Frame `frame` was recorded reading the current input. */
+    void sampled(uint64_t frame);
+
+    /** Frames below `completedFrames` have finished; hands back the inputs they were last to read. */
+    void collect(uint64_t completedFrames);
+
+    /** Nothing recorded can still run and the input is gone, e.g. the renderer was destroyed. */
+    void releaseAll();
+
+    /** Newest token whose buffer may go back to its producer; 0 before the first. */
+    uint64_t released() const { return released_; }
+
+    /** Inputs replaced but possibly still read by frames in flight. */
+    size_t pending() const { return replaced_.size(); }
+
+private:
+    struct Input {
+        uint64_t token = 0;       // 0: the renderer's input is not a held buffer
+        uint64_t lastFrame = 0;
+        bool sampled = false;
+    };
+
+    uint64_t nextToken_ = 1;
+    uint64_t released_ = 0;
+    Input current_;
+    std::deque<Input> replaced_;  // oldest first
+};
+
+} // namespace lumina
+
+#endif // LUMINA_INPUT_RELEASE_H
@@ -1,7 +1,9 @@
 #include "json_parser.h"
 
 #include <cctype>
+#include <charconv>
 #include <cstdlib>
+#include <cstring>
 
 namespace lumina::json {
 
@@ -77,6 +79,13 @@ std::optional<JsonValue> JsonParser::parseString() {
     ++pos_;
     std::string result;
     while (pos_ < text_.size()) {
+        // Copy unescaped runs in one go rather than byte by byte.
+        const size_t runEnd = text_.find_first_of("\"\\", pos_);
+        const size_t stop = (runEnd == std::string::npos) ? text_.size() : runEnd;
+        result.append(text_, pos_, stop - pos_);
+        pos_ = stop;
+        if (pos_ >= text_.size()) break;
+
         char c = text_[pos_++];
         if (c == '"') break;
         if (c == '\\') {
@@ -126,7 +135,9 @@ std::optional<JsonValue> JsonParser::parseObject() {
         if (pos_ < text_.size() && text_[pos_] == ',') { ++pos_; continue; }
         if (pos_ < text_.size() && text_[pos_] == '}') { ++pos_; break; }
     }
-    return JsonValue(std::move(object));
+    // Built in place: moving a temporary JsonValue into the optional trips GCC 12's
+    // -Wmaybe-uninitialized on the variant's inactive members.
+    return std::optional<JsonValue>(std::in_place, std::move(object));
 }
 
 std::optional<JsonValue> JsonParser::parseArray() {
@@ -194,4 +205,362 @@ lumina::ColorRGBA parseColor(const JsonValue::object_t& obj, const char* key, co
     return fallback;
 }
 
+// ---------------------------------------------------------------------------
+// SaxParser
+// ---------------------------------------------------------------------------
+
+namespace {
+
+bool isJsonSpace(char c) {
+    return c == ' ' || c == '\n' || c == '\r' || c == '\t';
+}
+
+int hexDigit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+bool readHex4(std::string_view text, size_t pos, uint32_t& out) {
+    if (pos + 4 > text.size()) return false;
+    out = 0;
+    for (size_t i = 0; i < 4; ++i) {
+        const int d = hexDigit(text[pos + i]);
+        if (d < 0) return false;
+        out = (out << 4) | static_cast<uint32_t>(d);
+    }
+    return true;
+}
+
+void appendUtf8(std::string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out.push_back(static_cast<char>(cp));
+    } else if (cp < 0x800) {
+        out.push_back(static_cast<char>(0xC0 | (cp >> 6)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else if (cp < 0x10000) {
+        out.push_back(static_cast<char>(0xE0 | (cp >> 12)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    } else {
+        out.push_back(static_cast<char>(0xF0 | (cp >> 18)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 12) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | ((cp >> 6) & 0x3F)));
+        out.push_back(static_cast<char>(0x80 | (cp & 0x3F)));
+    }
+}
+
+} // namespace
+
+bool SaxParser::parse(std::string_view text, JsonHandler& handler) {
+    text_ = text;
+    pos_ = 0;
+    skipWhitespace();
+    return parseValue(handler, 0);
+}
+
+void SaxParser::skipWhitespace() {
+    while (pos_ < text_.size() && isJsonSpace(text_[pos_])) ++pos_;
+}
+
+bool SaxParser::matchLiteral(std::string_view literal) {
+    if (text_.compare(pos_, literal.size(), literal) != 0) return false;
+    pos_ += literal.size();
+    return true;
+}
+
+bool SaxParser::parseValue(JsonHandler& handler, int depth) {
+    skipWhitespace();
+    if (pos_ >= text_.size()) return false;
+
+    switch (text_[pos_]) {
+        case '{': return depth < kMaxDepth && parseObject(handler, depth + 1);
+        case '[': return depth < kMaxDepth && parseArray(handler, depth + 1);
+        case '"': {
+            std::string_view str;
+            return parseString(str) && handler.onString(str);
+        }
+        case 't': return matchLiteral("true") && handler.onBool(true);
+        case 'f': return matchLiteral("false") && handler.onBool(false);
+        case 'n': return matchLiteral("null") && handler.onNull();
+        default: {
+            double number = 0.0;
+            return parseNumber(number) && handler.onNumber(number);
+        }
+    }
+}
+
+bool SaxParser::parseObject(JsonHandler& handler, int depth) {
+    ++pos_; // '{'
+    if (!handler.onStartObject()) return false;
+    skipWhitespace();
+    if (pos_ < text_.size() && text_[pos_] == '}') {
+        ++pos_;
+        return handler.onEndObject();
+    }
+
+    while (true) {
+        skipWhitespace();
+        std::string_view key;
+        if (pos_ >= text_.size() || text_[pos_] != '"' || !parseString(key)) return false;
+        if (!handler.onKey(key)) return false;
+        skipWhitespace();
+        if (pos_ >= text_.size() || text_[pos_] != ':') return false;
+        ++pos_;
+        if (!parseValue(handler, depth)) return false;
+
+        skipWhitespace();
+        if (pos_ >= text_.size()) return false;
+        const char c = text_[pos_++];
+        if (c == ',') continue;
+        if (c == '}') return handler.onEndObject();
+        return false;
+    }
+}
+
+bool SaxParser::parseArray(JsonHandler& handler, int depth) {
+    ++pos_; // '['
+    if (!handler.onStartArray()) return false;
+    skipWhitespace();
+    if (pos_ < text_.size() && text_[pos_] == ']') {
+        ++pos_;
+        return handler.onEndArray();
+    }
+
+    while (true) {
+        if (!parseValue(handler, depth)) return false;
+        skipWhitespace();
+        if (pos_ >= text_.size()) return false;
+        const char c = text_[pos_++];
+        if (c == ',') continue;
+        if (c == ']') return handler.onEndArray();
+        return false;
+    }
+}
+
+bool SaxParser::parseString(std::string_view& out) {
+    ++pos_; // opening quote
+    const size_t start = pos_;
+    while (pos_ < text_.size() && text_[pos_] != '"' && text_[pos_] != '\\') ++pos_;
+    if (pos_ >= text_.size()) return false;
+    if (text_[pos_] == '"') {
+        out = text_.substr(start, pos_ - start);
+        ++pos_;
+        return true;
+    }
+
+    // Escapes: decode into scratch, reusing its capacity.
+    scratch_.assign(text_.data() + start, pos_ - start);
+    while (pos_ < text_.size()) {
+        const char c = text_[pos_++];
+        if (c == '"') {
+            out = scratch_;
+            return true;
+        }
+        if (c != '\\') {
+            scratch_.push_back(c);
+            continue;
+        }
+        if (pos_ >= text_.size()) return false;
+        const char esc = text_[pos_++];
+        switch (esc) {
+            case '"': scratch_.push_back('"'); break;
+            case '\\': scratch_.push_back('\\'); break;
+            case '/': scratch_.push_back('/'); break;
+            case 'b': scratch_.push_back('\b'); break;
+            case 'f': scratch_.push_back('\f'); break;
+            case 'n': scratch_.push_back('\n'); break;
+            case 'r': scratch_.push_back('\r'); break;
+            case 't': scratch_.push_back('\t'); break;
+            case 'u': {
+                uint32_t cp = 0;
+                if (!readHex4(text_, pos_, cp)) return false;
+                pos_ += 4;
+                uint32_t low = 0;
+                if (cp >= 0xD800 && cp < 0xDC00 && text_.compare(pos_, 2, "\\u") == 0 &&
+                    readHex4(text_, pos_ + 2, low) && low >= 0xDC00 && low < 0xE000) {
+                    cp = 0x10000 + ((cp - 0xD800) << 10) + (low - 0xDC00);
+                    pos_ += 6;
+                }
+                appendUtf8(scratch_, cp);
+                break;
+            }
+            default: return false;
+        }
+    }
+    return false;
+}
+
+bool SaxParser::parseNumber(double& out) {
+    const size_t start = pos_;
+    if (pos_ < text_.size() && text_[pos_] == '-') ++pos_;
+    const size_t digitsStart = pos_;
+    while (pos_ < text_.size() && text_[pos_] >= '0' && text_[pos_] <= '9') ++pos_;
+    if (pos_ == digitsStart) return false;
+    if (pos_ < text_.size() && text_[pos_] == '.') {
+        ++pos_;
+        while (pos_ < text_.size() && text_[pos_] >= '0' && text_[pos_] <= '9') ++pos_;
+    }
+    if (pos_ < text_.size() && (text_[pos_] == 'e' || text_[pos_] == 'E')) {
+        ++pos_;
+        if (pos_ < text_.size() && (text_[pos_] == '+' || text_[pos_] == '-')) ++pos_;
+        while (pos_ < text_.size() && text_[pos_] >= '0' && text_[pos_] <= '9') ++pos_;
+    }
+
+    const char* first = text_.data() + start;
+    const char* last = text_.data() + pos_;
+#if defined(__cpp_lib_to_chars) && __cpp_lib_to_chars >= 201611L
+    const auto result = std::from_chars(first, last, out);
+    return result.ec == std::errc() && result.ptr == last;
+#else
+    // Older libc++ lacks floating-point from_chars; the view is not NUL-terminated.
+    char buf[64];
+    const size_t len = static_cast<size_t>(last - first);
+    if (len >= sizeof(buf)) return false;
+    std::memcpy(buf, first, len);
+    buf[len] = '\0';
+    out = std::strtod(buf, nullptr);
+    return true;
+#endif
+}
+
+// ---------------------------------------------------------------------------
+// JsonDocument
+// ---------------------------------------------------------------------------
+
+class DocumentBuilder final : public JsonHandler {
+public:
+    explicit DocumentBuilder(JsonDocument& doc) : doc_(doc) {}
+
+    bool onNull() override { push(JsonValue::Type::Null, true); return true; }
+    bool onBool(bool value) override {
+        doc_.nodes_[push(JsonValue::Type::Bool, true)].boolean = value;
+        return true;
+    }
+    bool onNumber(double value) override {
+        doc_.nodes_[push(JsonValue::Type::Number, true)].number = value;
+        return true;
+    }
+    bool onString(std::string_view value) override {
+        setString(push(JsonValue::Type::String, true), value);
+        return true;
+    }
+    bool onKey(std::string_view key) override {
+        setString(push(JsonValue::Type::String, false), key);
+        doc_.nodes_[doc_.stack_.back()].count++;
+        return true;
+    }
+    bool onStartObject() override { return open(JsonValue::Type::Object); }
+    bool onEndObject() override { return close(); }
+    bool onStartArray() override { return open(JsonValue::Type::Array); }
+    bool onEndArray() override { return close(); }
+
+private:
+    // Array elements count towards their parent here; object members count on their key.
+    uint32_t push(JsonValue::Type type, bool isValue) {
+        const uint32_t index = static_cast<uint32_t>(doc_.nodes_.size());
+        if (isValue && !doc_.stack_.empty()) {
+            JsonNode& parent = doc_.nodes_[doc_.stack_.back()];
+            if (parent.type == JsonValue::Type::Array) parent.count++;
+        }
+        doc_.nodes_.emplace_back();
+        JsonNode& node = doc_.nodes_.back();
+        node.type = type;
+        node.end = index + 1;
+        return index;
+    }
+
+    bool open(JsonValue::Type type) {
+        doc_.stack_.push_back(push(type, true));
+        return true;
+    }
+
+    bool close() {
+        if (doc_.stack_.empty()) return false;
+        doc_.nodes_[doc_.stack_.back()].end = static_cast<uint32_t>(doc_.nodes_.size());
+        doc_.stack_.pop_back();
+        return true;
+    }
+
+    void setString(uint32_t index, std::string_view value) {
+        JsonNode& node = doc_.nodes_[index];
+        const char* text = doc_.text_.data();
+        if (value.data() >= text && value.data() + value.size() <= text + doc_.text_.size()) {
+            node.strOffset = static_cast<uint32_t>(value.data() - text);
+        } else {
+            node.ownedString = true;
+            node.strOffset = static_cast<uint32_t>(doc_.strings_.size());
+            doc_.strings_.append(value);
+        }
+        node.strLength = static_cast<uint32_t>(value.size());
+    }
+
+    JsonDocument& doc_;
+};
+
+bool JsonDocument::parse(std::string_view text) {
+    text_ = text;
+    nodes_.clear();
+    stack_.clear();
+    strings_.clear();
+
+    DocumentBuilder builder(*this);
+    const bool ok = sax_.parse(text, builder) && stack_.empty();
+    if (!ok) nodes_.clear();
+    return ok;
+}
+
+JsonValue::Type JsonRef::type() const {
+    return doc_ ? doc_->node(index_).type : JsonValue::Type::Null;
+}
+
+double JsonRef::asNumber(double fallback) const {
+    return isNumber() ? doc_->node(index_).number : fallback;
+}
+
+bool JsonRef::asBool(bool fallback) const {
+    return isBool() ? doc_->node(index_).boolean : fallback;
+}
+
+std::string_view JsonRef::asString() const {
+    return isString() ? doc_->string(doc_->node(index_)) : std::string_view();
+}
+
+uint32_t JsonRef::size() const {
+    return (isObject() || isArray()) ? doc_->node(index_).count : 0;
+}
+
+JsonRef JsonRef::operator[](std::string_view key) const {
+    if (!isObject()) return JsonRef();
+    const uint32_t end = doc_->node(index_).end;
+    for (uint32_t i = index_ + 1; i < end;) {
+        const uint32_t valueIndex = i + 1;
+        if (doc_->string(doc_->node(i)) == key) return JsonRef(doc_, valueIndex);
+        i = doc_->node(valueIndex).end;
+    }
+    return JsonRef();
+}
+
+lumina::Vec2 readVec2(JsonRef value, const lumina::Vec2& fallback) {
+    if (!value.isObject()) return fallback;
+    return lumina::Vec2(static_cast<float>(value.number("x", fallback.x)),
+                        static_cast<float>(value.number("y", fallback.y)));
+}
+
+lumina::Vec3 readVec3(JsonRef value, const lumina::Vec3& fallback) {
+    if (!value.isObject()) return fallback;
+    return lumina::Vec3(static_cast<float>(value.number("x", fallback.x)),
+                        static_cast<float>(value.number("y", fallback.y)),
+                        static_cast<float>(value.number("z", fallback.z)));
+}
+
+lumina::ColorRGBA readColor(JsonRef value, const lumina::ColorRGBA& fallback) {
+    if (!value.isObject()) return fallback;
+    return lumina::ColorRGBA(static_cast<float>(value.number("r", fallback.r)),
+                             static_cast<float>(value.number("g", fallback.g)),
+                             static_cast<float>(value.number("b", fallback.b)),
+                             static_cast<float>(value.number("a", fallback.a)));
+}
+
 } // namespace lumina::json
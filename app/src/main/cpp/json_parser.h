@@ -1,9 +1,11 @@
 #ifndef LUMINA_JSON_PARSER_H
 #define LUMINA_JSON_PARSER_H
 
+#include <cstdint>
 #include <map>
 #include <optional>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
@@ -76,6 +78,151 @@ lumina::Vec2 parseVec2(const JsonValue::object_t& obj, const char* key, const lu
 lumina::Vec3 parseVec3(const JsonValue::object_t& obj, const char* key, const lumina::Vec3& fallback);
 lumina::ColorRGBA parseColor(const JsonValue::object_t& obj, const char* key, const lumina::ColorRGBA& fallback);
 
+// ---------------------------------------------------------------------------
+// Streaming (SAX) interface
+//
+// Walks the input once without building a tree. String and key views point into
+// the input unless they contain escapes; then they point at parser-owned scratch
+// that stays valid only until the next callback. Returning false from a callback
+// stops the parse.
+// ---------------------------------------------------------------------------
+
+class JsonHandler {
+public:
+    virtual ~JsonHandler() = default;
+    virtual bool onNull() { return true; }
+    virtual bool onBool(bool) { return true; }
+    virtual bool onNumber(double) { return true; }
+    virtual bool onString(std::string_view) { return true; }
+    virtual bool onKey(std::string_view) { return true; }
+    virtual bool onStartObject() { return true; }
+    virtual bool onEndObject() { return true; }
+    virtual bool onStartArray() { return true; }
+    virtual bool onEndArray() { return true; }
+};
+
+class SaxParser {
+public:
+    static constexpr int kMaxDepth = 64;
+
+    // Reusable: scratch storage is kept between calls.
+    bool parse(std::string_view text, JsonHandler& handler);
+
+private:
+    std::string_view text_;
+    size_t pos_ = 0;
+    std::string scratch_;
+
+    void skipWhitespace();
+    bool parseValue(JsonHandler& handler, int depth);
+    bool parseObject(JsonHandler& handler, int depth);
+    bool parseArray(JsonHandler& handler, int depth);
+    bool parseString(std::string_view& out);
+    bool parseNumber(double& out);
+    bool matchLiteral(std::string_view literal);
+};
+
+// ---------------------------------------------------------------------------
+// Arena DOM
+//
+// A flat array of nodes in document order. Containers record one-past-the-end of
+// their subtree, so children are found by skipping, not by pointers; object members
+// are stored as a key node followed by the value's subtree. Keys and strings are
+// views into the input text (or into document storage when they had escapes), so
+// the input must outlive the document. Node and string storage is reused across
+// parse() calls; steady-state parsing does not allocate.
+// ---------------------------------------------------------------------------
+
+class JsonDocument;
+
+struct JsonNode {
+    JsonValue::Type type = JsonValue::Type::Null;
+    bool ownedString = false;   // string lives in JsonDocument storage
+    bool boolean = false;
+    uint32_t end = 0;           // index one past this node's subtree
+    uint32_t count = 0;         // object members or array elements
+    uint32_t strOffset = 0;
+    uint32_t strLength = 0;
+    double number = 0.0;
+};
+
+class JsonRef {
+public:
+    JsonRef() = default;
+    JsonRef(const JsonDocument* doc, uint32_t index) : doc_(doc), index_(index) {}
+
+    explicit operator bool() const { return doc_ != nullptr; }
+    JsonValue::Type type() const;
+    bool isObject() const { return doc_ && type() == JsonValue::Type::Object; }
+    bool isArray() const { return doc_ && type() == JsonValue::Type::Array; }
+    bool isNumber() const { return doc_ && type() == JsonValue::Type::Number; }
+    bool isString() const { return doc_ && type() == JsonValue::Type::String; }
+    bool isBool() const { return doc_ && type() == JsonValue::Type::Bool; }
+
+    double asNumber(double fallback) const;
+    bool asBool(bool fallback) const;
+    std::string_view asString() const;
+    uint32_t size() const;
+
+    // Member lookup (linear over the object's members).
+    JsonRef operator[](std::string_view key) const;
+    double number(std::string_view key, double fallback) const { return (*this)[key].asNumber(fallback); }
+
+    template <typename Fn> void forEachMember(Fn&& fn) const;   // fn(std::string_view key, JsonRef value)
+    template <typename Fn> void forEachElement(Fn&& fn) const;  // fn(uint32_t i, JsonRef value)
+
+private:
+    const JsonDocument* doc_ = nullptr;
+    uint32_t index_ = 0;
+};
+
+class JsonDocument {
+public:
+    bool parse(std::string_view text);
+    JsonRef root() const { return nodes_.empty() ? JsonRef() : JsonRef(this, 0); }
+
+private:
+    friend class JsonRef;
+    friend class DocumentBuilder;
+
+    const JsonNode& node(uint32_t index) const { return nodes_[index]; }
+    std::string_view string(const JsonNode& n) const {
+        const char* base = n.ownedString ? strings_.data() : text_.data();
+        return std::string_view(base + n.strOffset, n.strLength);
+    }
+
+    std::string_view text_;
+    std::vector<JsonNode> nodes_;
+    std::vector<uint32_t> stack_;
+    std::string strings_;
+    SaxParser sax_;
+};
+
+template <typename Fn>
+void JsonRef::forEachMember(Fn&& fn) const {
+    if (!isObject()) return;
+    const uint32_t end = doc_->node(index_).end;
+    for (uint32_t i = index_ + 1; i < end;) {
+        const uint32_t valueIndex = i + 1;
+        fn(doc_->string(doc_->node(i)), JsonRef(doc_, valueIndex));
+        i = doc_->node(valueIndex).end;
+    }
+}
+
+template <typename Fn>
+void JsonRef::forEachElement(Fn&& fn) const {
+    if (!isArray()) return;
+    const uint32_t end = doc_->node(index_).end;
+    uint32_t n = 0;
+    for (uint32_t i = index_ + 1; i < end; i = doc_->node(i).end) {
+        fn(n++, JsonRef(doc_, i));
+    }
+}
+
+lumina::Vec2 readVec2(JsonRef value, const lumina::Vec2& fallback);
+lumina::Vec3 readVec3(JsonRef value, const lumina::Vec3& fallback);
+lumina::ColorRGBA readColor(JsonRef value, const lumina::ColorRGBA& fallback);
+
 } // namespace lumina::json
 
 #endif // LUMINA_JSON_PARSER_H
@@ -4,11 +4,27 @@
 #include <GLES3/gl3.h>
 #include <android/log.h>
 #include <android/native_window_jni.h>
+#include <android/sharedmem.h>
+#include <sys/mman.h>
+#include <unistd.h>
 #include <algorithm>
-
+#include <cmath>
+#include <cstring>
+#include <future>
+#include <iterator>
+#include <memory>
+#include <utility>
+
+#include "effect_graph.h"
 #include "json_parser.h"
+#include "state_json.h"
+#include "state_packet.h"
 #include "renderer_gles.h"
 #include "renderer_vulkan.h"
+#include "trace.h"
+#include "video_decoder.h"
+#include "video_encoder.h"
+#include "video_exporter.h"
 
 #define LOG_TAG "LuminaEngine"
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
@@ -26,44 +42,201 @@ LuminaEngineCore& LuminaEngineCore::getInstance() {
 LuminaEngineCore::LuminaEngineCore() = default;
 LuminaEngineCore::~LuminaEngineCore() { shutdown(); }
 
-bool LuminaEngineCore::initialize(JNIEnv* env, jobject assetManager) {
-    std::lock_guard<std::mutex> lock(mutex_);
+bool LuminaEngineCore::initialize(JNIEnv* env, jobject assetManager, const std::string& shaderCacheDir) {
+    auto ready = std::make_shared<std::promise<bool>>();
+    std::future<bool> outcome = ready->get_future();
+    if (!initializeAsync(env, assetManager, shaderCacheDir, [ready](bool ok) { ready->set_value(ok); })) {
+        return false;
+    }
+    return outcome.get();
+}
 
-    if (initialized_) {
+bool LuminaEngineCore::initializeAsync(JNIEnv* env, jobject assetManager, const std::string& shaderCacheDir,
+                                       ReadyCallback onReady) {
+    bool alreadyReady = false;
+    {
+        std::lock_guard<std::mutex> initLock(initMutex_);
+        const InitStatus status = initStatus_.load(std::memory_order_relaxed);
+        alreadyReady = status == InitStatus::Ready;
+        if (!alreadyReady) {
+            readyCallbacks_.push_back(std::move(onReady));
+            if (status == InitStatus::Pending) return true;
+            initStatus_.store(InitStatus::Pending, std::memory_order_release);
+        }
+    }
+    if (alreadyReady) {
         LOGW("Engine already initialized");
+        if (onReady) onReady(true);
         return true;
     }
 
     LOGI("Initializing Lumina Engine Core v%d.%d.%d", LUMINA_VERSION_MAJOR, LUMINA_VERSION_MINOR, LUMINA_VERSION_PATCH);
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (assetManager_) env->DeleteGlobalRef(assetManager_);  // left by a failed start-up
+        assetManager_ = env->NewGlobalRef(assetManager);
+        shaderCacheDir_ = shaderCacheDir;
+        {
+            // No frame draws before initialized_ is set, so resetting the buffers is safe.
+            std::lock_guard<std::mutex> stateLock(stateMutex_);
+            state_ = lumina::LuminaState();
+            stateSnapshots_.reset(state_);
+            sharedState_.publish(state_);
+        }
+        timing_ = lumina::FrameTiming();
+        frameStats_.reset();
+        renderScale_.reset();
+        lastThermalPollNs_ = 0;
+        thermalHeadroom_ = -1.0f;
+        redraw_.invalidate();
+        inputSeq_ = 0;
+        videoPtsUs_ = -1;
+        timingSnapshot_.store(timing_);
+        stateWidth_ = stateHeight_ = 0;
+    }
 
-    assetManager_ = env->NewGlobalRef(assetManager);
-    state_ = std::make_unique<lumina::LuminaState>();
+    if (!renderThread_.start([this](int64_t frameTimeNanos, int64_t presentTimeNanos) {
+            drawFrame(frameTimeNanos, presentTimeNanos);
+        })) {
+        LOGW("Render thread unavailable; frames will be drawn by renderFrame() callers");
+    }
+    // Graphics objects belong to the render thread from the start; without one this
+    // runs here and the callbacks fire before returning.
+    renderThread_.post([this] { completeInitialize(); });
+    return true;
+}
 
-    if (!initializeGraphics()) {
-        LOGE("Failed to initialize graphics");
-        return false;
+void LuminaEngineCore::completeInitialize() {
+    LUMINA_TRACE_SCOPE("Lumina::completeInitialize");
+    bool ready = false;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (initializeGraphics()) {
+            glRenderer_ = std::make_unique<GLRenderer>();
+            glRenderer_->setCacheDirectory(shaderCacheDir_);
+            // Only the GL renderer that presents reports pass times.
+            glRenderer_->setFrameStats(useVulkan_ ? nullptr : &frameStats_);
+            glRenderer_->initialize();
+
+            // Only the presenting renderer produces analysis frames.
+            analysisFrames_.reset();
+            if (useVulkan_) {
+                vkRenderer_->setAnalysisOutput(analysisConfig_, &analysisFrames_);
+                vkRenderer_->setGlassLayout(glassLayout_);
+            } else {
+                glRenderer_->setAnalysisOutput(analysisConfig_, &analysisFrames_);
+                glRenderer_->setGlassLayout(glassLayout_);
+                const char* extensions = eglQueryString(eglDisplay_, EGL_EXTENSIONS);
+                if (extensions && std::strstr(extensions, "EGL_ANDROID_presentation_time")) {
+                    eglPresentationTime_ = reinterpret_cast<PFNEGLPRESENTATIONTIMEANDROIDPROC>(
+                        eglGetProcAddress("eglPresentationTimeANDROID"));
+                }
+            }
+            warmUpPipelines();
+            if (!useVulkan_) {
+                // Frames bind the context themselves (makeContextCurrent()).
+                eglMakeCurrent(eglDisplay_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+            }
+            initialized_ = true;
+            ready = true;
+        } else {
+            LOGE("Failed to initialize graphics");
+        }
     }
 
-    glRenderer_ = std::make_unique<GLRenderer>();
-    glRenderer_->initialize();
+    std::vector<ReadyCallback> callbacks;
+    ANativeWindow* window = nullptr;
+    bool windowPending = false;
+    {
+        std::lock_guard<std::mutex> initLock(initMutex_);
+        initStatus_.store(ready ? InitStatus::Ready : InitStatus::Failed, std::memory_order_release);
+        callbacks.swap(readyCallbacks_);
+        std::swap(window, pendingWindow_);
+        std::swap(windowPending, windowPending_);
+    }
 
-    initialized_ = true;
-    LOGI("Engine initialized successfully");
-    return true;
+    // Later setSurfaceWindow() calls queue behind this task, so the order holds.
+    if (windowPending) {
+        if (ready) {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                applySurfaceWindow(window);
+            }
+            renderThread_.setContinuous(window != nullptr);
+        } else if (window) {
+            ANativeWindow_release(window);
+        }
+    }
+
+    if (ready) LOGI("Engine initialized successfully (%s)", useVulkan_ ? "Vulkan" : "GLES 3");
+    for (auto& callback : callbacks) {
+        if (callback) callback(ready);
+    }
 }
 
 void LuminaEngineCore::shutdown(JNIEnv* env) {
-    std::lock_guard<std::mutex> lock(mutex_);
-
-    if (!initialized_) return;
+    // A start-up still running on the render thread finishes first.
+    if (initStatus() == InitStatus::Pending) renderThread_.runSync([] {});
+    if (!initialized_.exchange(false)) {
+        // A failed start-up has no graphics to tear down, but its render thread and
+        // asset manager reference are still held.
+        {
+            std::lock_guard<std::mutex> initLock(initMutex_);
+            if (initStatus_.load(std::memory_order_relaxed) != InitStatus::Failed) return;
+            initStatus_.store(InitStatus::Idle, std::memory_order_release);
+        }
+        renderThread_.stop();
+        std::lock_guard<std::mutex> lock(mutex_);
+        releaseAssetManager(env);
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> initLock(initMutex_);
+        initStatus_.store(InitStatus::Idle, std::memory_order_release);
+    }
 
     LOGI("Shutting down Lumina Engine");
 
-    if (nativeWindow_) {
-        ANativeWindow_release(nativeWindow_);
-        nativeWindow_ = nullptr;
+    // Graphics objects belong to the render thread; tear them down there, then stop it.
+    renderThread_.setContinuous(false);
+    renderThread_.runSync([this] {
+        std::lock_guard<std::mutex> lock(mutex_);
+        applyEncoderWindow(nullptr);
+        shutdownGraphics();
+        // The device is idle or the context gone: every camera buffer can go back.
+        releaseCameraHolds();
+        glRenderer_.reset();
+        if (thermal_) {
+            if (__builtin_available(android 30, *)) AThermal_releaseManager(thermal_);
+            thermal_ = nullptr;
+        }
+        if (nativeWindow_) {
+            ANativeWindow_release(nativeWindow_);
+            nativeWindow_ = nullptr;
+        }
+    });
+    renderThread_.stop();
+
+    {
+        std::lock_guard<std::mutex> exportLock(exportMutex_);
+        exporter_.reset();
     }
+    {
+        std::lock_guard<std::mutex> recordingLock(recordingMutex_);
+        if (encoder_) {
+            encoder_->stop();
+            encoder_.reset();
+        }
+    }
+
+    detachSharedState();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    decoder_.reset();
+    releaseAssetManager(env);
+}
 
+void LuminaEngineCore::releaseAssetManager(JNIEnv* env) {
     if (assetManager_) {
         bool didAttach = false;
         if (!env && g_vm) {
@@ -85,165 +258,240 @@ void LuminaEngineCore::shutdown(JNIEnv* env) {
             g_vm->DetachCurrentThread();
         }
     }
-
-    shutdownGraphics();
-    glRenderer_.reset();
-    state_.reset();
-    initialized_ = false;
 }
 
 bool LuminaEngineCore::updateStateFromJson(const std::string& json) {
-    std::lock_guard<std::mutex> lock(mutex_);
+    LUMINA_TRACE_SCOPE("Lumina::updateStateFromJson");
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    lumina::ScopedStageTimer timer(&frameStats_, lumina::FrameStage::Ingest);
 
     if (!initialized_) {
         LOGE("Cannot update state - engine not initialized");
         return false;
     }
 
-    lumina::json::JsonParser parser(json);
-    auto rootOpt = parser.parse();
-    if (!rootOpt || !rootOpt->isObject()) {
+    if (!lumina::applyStateJson(jsonDoc_, json, state_)) {
         LOGE("Failed to parse state JSON");
         return false;
     }
 
-    const auto& rootObj = *rootOpt->asObject();
-
-    auto getNumber = [&](const char* key, double fallback) {
-        auto it = rootObj.find(key);
-        if (it != rootObj.end()) {
-            if (auto n = it->second.asNumber()) return *n;
-        }
-        return fallback;
-    };
-
-    auto getObj = [&](const char* key) -> const lumina::json::JsonValue* {
-        auto it = rootObj.find(key);
-        if (it != rootObj.end() && it->second.isObject()) return &it->second;
-        return nullptr;
-    };
-
-    auto getArray = [&](const char* key) -> const lumina::json::JsonValue::array_t* {
-        auto it = rootObj.find(key);
-        if (it != rootObj.end() && it->second.isArray()) return it->second.asArray();
-        return nullptr;
-    };
+    publishState();
+    LOGD("State updated: renderMode=%d, size=%ux%u, effects=%u", static_cast<int>(state_.renderMode), state_.width, state_.height, state_.activeEffectCount);
+    return true;
+}
 
-    auto clampUInt = [](int value, int minV, int maxV) {
-        return static_cast<uint32_t>(std::max(minV, std::min(value, maxV)));
-    };
+bool LuminaEngineCore::updateStateFromPacket(const void* data, size_t size) {
+    LUMINA_TRACE_SCOPE("Lumina::updateStateFromPacket");
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    lumina::ScopedStageTimer timer(&frameStats_, lumina::FrameStage::Ingest);
 
-    int width = static_cast<int>(getNumber("width", state_->width));
-    int height = static_cast<int>(getNumber("height", state_->height));
-    if (width > 0 && height > 0) {
-        state_->setDimensions(static_cast<uint32_t>(width), static_cast<uint32_t>(height));
-        surfaceWidth_ = width;
-        surfaceHeight_ = height;
-        if (glRenderer_) glRenderer_->onSurfaceSize(width, height);
+    if (!initialized_) {
+        LOGE("Cannot update state - engine not initialized");
+        return false;
     }
+    if (!lumina::applyStatePacket(data, size, state_)) {
+        LOGE("Rejected state packet (%zu bytes)", size);
+        return false;
+    }
+    publishState();
+    return true;
+}
 
-    state_->renderMode = static_cast<lumina::RenderMode>(
-        clampUInt(static_cast<int>(getNumber("renderMode", static_cast<int>(state_->renderMode))), 0, 4));
+bool LuminaEngineCore::submitCommands(const void* data, size_t size, void* results, size_t resultsSize) {
+    LUMINA_TRACE_SCOPE("Lumina::submitCommands");
+    lumina::CommandOutcome outcome;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        lumina::ScopedStageTimer timer(&frameStats_, lumina::FrameStage::Ingest);
+        if (!initialized_) {
+            LOGE("Cannot submit commands - engine not initialized");
+            return false;
+        }
+        outcome = lumina::applyCommands(data, size, state_);
+        if (!outcome.valid) {
+            LOGE("Rejected command stream (%zu bytes)", size);
+            return false;
+        }
+        if (outcome.stateChanged) {
+            state_.incrementStateId();
+            publishState();
+        }
+    }
+    if (outcome.rejected > 0) LOGW("Skipped %u unknown or malformed commands", outcome.rejected);
+    if (outcome.frameRequested) renderFrame();
+
+    if (results && resultsSize >= sizeof(lumina::CommandResults)) {
+        lumina::CommandResults out{};
+        out.version = lumina::kCommandStreamVersion;
+        out.applied = outcome.applied;
+        out.rejected = outcome.rejected;
+        if (outcome.timingRequested) {
+            out.flags |= lumina::kResultTiming;
+            out.timing = timingSnapshot_.load();
+        }
+        // The results buffer is a Java direct buffer with no alignment guarantee.
+        std::memcpy(results, &out, sizeof(out));
+    }
+    return true;
+}
 
-    state_->processingState = static_cast<lumina::ProcessingState>(
-        clampUInt(static_cast<int>(getNumber("processingState", static_cast<int>(state_->processingState))), 0, 3));
+void LuminaEngineCore::setRenderMode(int mode) {
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    if (!initialized_) return;
+    // Clamped like the packet, command and JSON paths; the mode keys pipeline variants.
+    state_.renderMode = static_cast<lumina::RenderMode>(std::min(static_cast<uint32_t>(mode), 4u));
+    state_.incrementStateId();
+    publishState();
+    LOGI("Render mode set to: %u", static_cast<uint32_t>(state_.renderMode));
+}
 
-    uint32_t requestedEffectCount = clampUInt(static_cast<int>(getNumber("activeEffectCount", state_->activeEffectCount)), 0, 4);
-    uint32_t parsedEffects = 0;
+void LuminaEngineCore::publishState() {
+    // Caller holds stateMutex_, which makes this the single producer of both.
+    stateSnapshots_.publish(state_);
+    sharedState_.publish(state_);
+}
 
-    if (auto touchObj = getObj("touchPosition")) {
-        const auto* o = touchObj->asObject();
-        if (o) {
-            float x = static_cast<float>(lumina::json::getNumberField(*o, "x", 0.0));
-            float y = static_cast<float>(lumina::json::getNumberField(*o, "y", 0.0));
-            state_->touchPosition = lumina::Vec2(x, y);
-        }
+bool LuminaEngineCore::attachSharedState(int fd) {
+    if (fd < 0) return false;
+    const size_t size = ASharedMemory_getSize(fd);
+    void* mapping = size >= lumina::kSharedStateSize
+        ? mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)
+        : MAP_FAILED;
+    if (mapping == MAP_FAILED) {
+        LOGE("Cannot map shared state block (%zu bytes, need %zu)", size, lumina::kSharedStateSize);
+        close(fd);
+        return false;
     }
 
-    if (auto deltaObj = getObj("touchDelta")) {
-        const auto* o = deltaObj->asObject();
-        if (o) {
-            float x = static_cast<float>(lumina::json::getNumberField(*o, "x", 0.0));
-            float y = static_cast<float>(lumina::json::getNumberField(*o, "y", 0.0));
-            state_->touchDelta = lumina::Vec2(x, y);
+    // The old mapping may show the same pages, so it is dropped before the new layout
+    // goes in, all under the lock the state writers take.
+    void* oldMapping = mapping;
+    size_t oldSize = size;
+    int oldFd = fd;
+    bool attached = false;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        sharedState_.reset();
+        lumina::SharedStateBlock block;
+        if (block.create(mapping, size)) {
+            std::swap(oldMapping, sharedStateMapping_);
+            std::swap(oldSize, sharedStateSize_);
+            std::swap(oldFd, sharedStateFd_);
+            sharedState_ = block;
+            sharedState_.publish(state_);
+            attached = true;
         }
     }
+    if (oldMapping) munmap(oldMapping, oldSize);
+    if (oldFd >= 0) close(oldFd);
+    if (!attached) {
+        LOGE("Shared state block mapping rejected");
+        return false;
+    }
+    LOGI("Shared state block attached (%zu bytes)", size);
+    return true;
+}
 
-    state_->touchPressure = static_cast<float>(getNumber("touchPressure", state_->touchPressure));
-    state_->touchState = clampUInt(static_cast<int>(getNumber("touchState", state_->touchState)), 0, 3);
-
-    if (auto effects = getArray("effects")) {
-        for (size_t i = 0; i < effects->size() && i < 4; ++i) {
-            const auto& val = (*effects)[i];
-            if (!val.isObject()) continue;
-            const auto* obj = val.asObject();
-            lumina::EffectParams params;
-            params.type = static_cast<lumina::EffectType>(
-                clampUInt(static_cast<int>(lumina::json::getNumberField(*obj, "type", static_cast<int>(params.type))), 0, 7));
-            params.intensity = static_cast<float>(lumina::json::getNumberField(*obj, "intensity", params.intensity));
-            params.param1 = static_cast<float>(lumina::json::getNumberField(*obj, "param1", params.param1));
-            params.param2 = static_cast<float>(lumina::json::getNumberField(*obj, "param2", params.param2));
-            params.tintColor = lumina::json::parseColor(*obj, "tintColor", params.tintColor);
-            params.center = lumina::json::parseVec2(*obj, "center", params.center);
-            params.scale = lumina::json::parseVec2(*obj, "scale", params.scale);
-            state_->effects[i] = params;
-            parsedEffects++;
-        }
+void LuminaEngineCore::detachSharedState() {
+    void* mapping = nullptr;
+    size_t size = 0;
+    int fd = -1;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        sharedState_.reset();
+        std::swap(mapping, sharedStateMapping_);
+        std::swap(size, sharedStateSize_);
+        std::swap(fd, sharedStateFd_);
     }
+    if (mapping) munmap(mapping, size);
+    if (fd >= 0) close(fd);
+}
 
-    state_->activeEffectCount = std::min(requestedEffectCount, parsedEffects);
+bool LuminaEngineCore::commitSharedIntents() {
+    LUMINA_TRACE_SCOPE("Lumina::commitSharedIntents");
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    if (!initialized_ || !sharedState_.valid()) return false;
+    sharedState_.applyIntents(state_);
+    state_.incrementStateId();
+    publishState();
+    LOGD("Intent committed: %s -> %s", state_.currentIntent.action, state_.currentIntent.target);
+    return true;
+}
 
-    if (auto uiObj = getObj("uiStyle")) {
-        if (const auto* o = uiObj->asObject()) {
-            state_->uiStyle.backgroundColor = lumina::json::parseColor(*o, "backgroundColor", state_->uiStyle.backgroundColor);
-            state_->uiStyle.borderColor = lumina::json::parseColor(*o, "borderColor", state_->uiStyle.borderColor);
-            state_->uiStyle.blurRadius = static_cast<float>(lumina::json::getNumberField(*o, "blurRadius", state_->uiStyle.blurRadius));
-            state_->uiStyle.transparency = static_cast<float>(lumina::json::getNumberField(*o, "transparency", state_->uiStyle.transparency));
-            state_->uiStyle.borderWidth = static_cast<float>(lumina::json::getNumberField(*o, "borderWidth", state_->uiStyle.borderWidth));
-            state_->uiStyle.cornerRadius = static_cast<float>(lumina::json::getNumberField(*o, "cornerRadius", state_->uiStyle.cornerRadius));
-            state_->uiStyle.saturation = static_cast<float>(lumina::json::getNumberField(*o, "saturation", state_->uiStyle.saturation));
-            state_->uiStyle.brightness = static_cast<float>(lumina::json::getNumberField(*o, "brightness", state_->uiStyle.brightness));
-        }
-    }
+int LuminaEngineCore::dupSharedStateFd() const {
+    std::lock_guard<std::mutex> lock(stateMutex_);
+    return sharedStateFd_ >= 0 ? dup(sharedStateFd_) : -1;
+}
 
-    if (auto camObj = getObj("camera")) {
-        if (const auto* o = camObj->asObject()) {
-            state_->camera.position = lumina::json::parseVec3(*o, "position", state_->camera.position);
-            state_->camera.lookAt = lumina::json::parseVec3(*o, "lookAt", state_->camera.lookAt);
-            state_->camera.fov = static_cast<float>(lumina::json::getNumberField(*o, "fov", state_->camera.fov));
-            state_->camera.nearPlane = static_cast<float>(lumina::json::getNumberField(*o, "nearPlane", state_->camera.nearPlane));
-            state_->camera.farPlane = static_cast<float>(lumina::json::getNumberField(*o, "farPlane", state_->camera.farPlane));
+void LuminaEngineCore::setSurfaceWindow(ANativeWindow* window) {
+    {
+        // Until the device is up the window waits; completeInitialize() attaches it.
+        std::lock_guard<std::mutex> initLock(initMutex_);
+        if (initStatus_.load(std::memory_order_relaxed) == InitStatus::Pending) {
+            if (pendingWindow_) ANativeWindow_release(pendingWindow_);
+            pendingWindow_ = window;
+            windowPending_ = true;
+            return;
         }
     }
+    renderThread_.runSync([this, window] {
+        std::lock_guard<std::mutex> lock(mutex_);
+        applySurfaceWindow(window);
+    });
+    renderThread_.setContinuous(window != nullptr);
+}
 
-    state_->incrementStateId();
-    LOGD("State updated: renderMode=%d, size=%ux%u, effects=%u", static_cast<int>(state_->renderMode), state_->width, state_->height, state_->activeEffectCount);
-    return true;
+void LuminaEngineCore::setTargetFrameRate(int fps) {
+    fps = std::clamp(fps, 0, 240);
+    renderThread_.setTargetFrameRate(fps);
+    renderThread_.runSync([this] {
+        std::lock_guard<std::mutex> lock(mutex_);
+        applyFrameRateHint();
+    });
+    LOGI("Target frame rate set to: %d", fps);
 }
 
-void LuminaEngineCore::setRenderMode(int mode) {
-    std::lock_guard<std::mutex> lock(mutex_);
-    if (!initialized_) return;
-    state_->renderMode = static_cast<lumina::RenderMode>(mode);
-    LOGI("Render mode set to: %d", mode);
+void LuminaEngineCore::setAdaptiveResolution(bool enabled) {
+    renderThread_.runSync([this, enabled] {
+        std::lock_guard<std::mutex> lock(mutex_);
+        adaptiveResolution_ = enabled;
+        if (!enabled) {
+            renderScale_.reset();
+            applyRenderScale(renderScale_.scale());
+        }
+    });
+    LOGI("Adaptive resolution %s", enabled ? "enabled" : "disabled");
 }
 
-void LuminaEngineCore::setSurfaceWindow(ANativeWindow* window) {
-    std::lock_guard<std::mutex> lock(mutex_);
+void LuminaEngineCore::applyFrameRateHint() {
+    // Lets the display switch modes (e.g. to 90 Hz) instead of judder-pacing on 120 Hz.
+    if (!nativeWindow_) return;
+    if (__builtin_available(android 30, *)) {
+        ANativeWindow_setFrameRate(nativeWindow_, static_cast<float>(renderThread_.targetFrameRate()),
+                                   ANATIVEWINDOW_FRAME_RATE_COMPATIBILITY_DEFAULT);
+    }
+}
 
+void LuminaEngineCore::applySurfaceWindow(ANativeWindow* window) {
     if (nativeWindow_) {
         ANativeWindow_release(nativeWindow_);
     }
 
     nativeWindow_ = window;
+    redraw_.invalidate();
 
     if (window) {
         int width = ANativeWindow_getWidth(window);
         int height = ANativeWindow_getHeight(window);
-        state_->setDimensions(width, height);
+        {
+            std::lock_guard<std::mutex> stateLock(stateMutex_);
+            state_.setDimensions(width, height);
+            publishState();
+        }
         surfaceWidth_ = width;
         surfaceHeight_ = height;
         LOGI("Surface set: %dx%d", width, height);
+        applyFrameRateHint();
         if (useVulkan_) {
             if (vkRenderer_) vkRenderer_->recreate(window);
         } else {
@@ -251,7 +499,7 @@ void LuminaEngineCore::setSurfaceWindow(ANativeWindow* window) {
         }
     } else {
         if (useVulkan_) {
-            if (vkRenderer_) vkRenderer_->destroy();
+            if (vkRenderer_) vkRenderer_->detachSurface();
         } else {
             if (glRenderer_) glRenderer_->onContextLost();
             if (eglSurface_ != EGL_NO_SURFACE && eglDisplay_ != EGL_NO_DISPLAY) {
@@ -263,60 +511,546 @@ void LuminaEngineCore::setSurfaceWindow(ANativeWindow* window) {
     }
 }
 
+bool LuminaEngineCore::startRecording(const std::string& path, const lumina::RecordingConfig& config) {
+    std::lock_guard<std::mutex> recordingLock(recordingMutex_);
+    if (!initialized_) return false;
+    bool attached = encoder_ != nullptr;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        attached = attached || encoderWindow_ != nullptr;
+    }
+    if (attached) {
+        LOGW("startRecording: an encoder is already attached");
+        return false;
+    }
+
+    auto encoder = std::make_unique<VideoEncoder>();
+    if (!encoder->start(path, config)) return false;
+    ANativeWindow* window = encoder->inputWindow();
+    ANativeWindow_acquire(window);
+    encoder_ = std::move(encoder);
+    attachEncoderWindow(window);
+    return true;
+}
+
+bool LuminaEngineCore::stopRecording() {
+    std::lock_guard<std::mutex> recordingLock(recordingMutex_);
+    if (!encoder_) return false;
+
+    // Detached on the render thread first: nothing may reach the codec after end of stream.
+    attachEncoderWindow(nullptr);
+    const bool finished = encoder_->stop();
+    encoder_.reset();
+    return finished;
+}
+
+bool LuminaEngineCore::setEncoderWindow(ANativeWindow* window) {
+    std::lock_guard<std::mutex> recordingLock(recordingMutex_);
+    if (encoder_ || (window && !initialized_)) {
+        LOGW("setEncoderWindow: %s", encoder_ ? "native recording in progress" : "engine not initialized");
+        if (window) ANativeWindow_release(window);
+        return false;
+    }
+    attachEncoderWindow(window);
+    return true;
+}
+
+void LuminaEngineCore::attachEncoderWindow(ANativeWindow* window) {
+    renderThread_.runSync([this, window] {
+        std::lock_guard<std::mutex> lock(mutex_);
+        applyEncoderWindow(window);
+    });
+}
+
+void LuminaEngineCore::applyEncoderWindow(ANativeWindow* window) {
+    if (window && window == encoderWindow_) {
+        ANativeWindow_release(window);  // already holding a reference
+        return;
+    }
+
+    // The renderer lets go of the old window before its reference is dropped.
+    if (useVulkan_) {
+        if (vkRenderer_) vkRenderer_->setEncoderWindow(window);
+    } else {
+        destroyEncoderSurface();
+    }
+    if (encoderWindow_) ANativeWindow_release(encoderWindow_);
+    encoderWindow_ = window;
+    recordingClock_.reset();
+
+    if (!window) {
+        LOGI("Encoder detached");
+        return;
+    }
+    if (!useVulkan_) createEncoderSurface();
+    LOGI("Encoder attached: %dx%d", ANativeWindow_getWidth(window), ANativeWindow_getHeight(window));
+}
+
+bool LuminaEngineCore::createEncoderSurface() {
+    if (eglDisplay_ == EGL_NO_DISPLAY || !encoderWindow_) return false;
+    encoderSurface_ = eglCreateWindowSurface(eglDisplay_, eglConfig_, encoderWindow_, nullptr);
+    if (encoderSurface_ == EGL_NO_SURFACE) {
+        LOGE("eglCreateWindowSurface (encoder) failed: 0x%x", eglGetError());
+        return false;
+    }
+    encoderWidth_ = ANativeWindow_getWidth(encoderWindow_);
+    encoderHeight_ = ANativeWindow_getHeight(encoderWindow_);
+    return true;
+}
+
+void LuminaEngineCore::destroyEncoderSurface() {
+    if (encoderSurface_ != EGL_NO_SURFACE && eglDisplay_ != EGL_NO_DISPLAY) {
+        eglDestroySurface(eglDisplay_, encoderSurface_);
+    }
+    encoderSurface_ = EGL_NO_SURFACE;
+    encoderWidth_ = encoderHeight_ = 0;
+}
+
+void LuminaEngineCore::presentToEncoder(int64_t timestampNs) {
+    LUMINA_TRACE_SCOPE("Lumina::presentToEncoder");
+    // Draw into the encoder while reading from the preview's back buffer: one scaled
+    // blit of the finished frame rather than running the effect chain twice.
+    if (!eglMakeCurrent(eglDisplay_, encoderSurface_, eglSurface_, eglContext_)) {
+        LOGE("eglMakeCurrent (encoder) failed: 0x%x", eglGetError());
+        eglMakeCurrent(eglDisplay_, eglSurface_, eglSurface_, eglContext_);
+        return;
+    }
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, 0);
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, 0);
+    glBlitFramebuffer(0, 0, surfaceWidth_, surfaceHeight_, 0, 0, encoderWidth_, encoderHeight_,
+                      GL_COLOR_BUFFER_BIT, GL_LINEAR);
+    // The encoder takes this as the frame's timestamp in the recording.
+    if (eglPresentationTime_) {
+        eglPresentationTime_(eglDisplay_, encoderSurface_, static_cast<EGLnsecsANDROID>(timestampNs));
+    }
+    if (!eglSwapBuffers(eglDisplay_, encoderSurface_)) {
+        LOGW("eglSwapBuffers (encoder) failed: 0x%x", eglGetError());
+    }
+    // The preview's back buffer is untouched and still due for its own swap.
+    eglMakeCurrent(eglDisplay_, eglSurface_, eglSurface_, eglContext_);
+}
+
 void LuminaEngineCore::renderFrame() {
-    std::lock_guard<std::mutex> lock(mutex_);
+    if (!initialized_) return;
+    redrawRequested_ = true;
+    if (renderThread_.isRunning()) {
+        renderThread_.requestFrame();
+        return;
+    }
+    const auto now = std::chrono::steady_clock::now().time_since_epoch();
+    drawFrame(std::chrono::duration_cast<std::chrono::nanoseconds>(now).count(), 0);
+}
+
+bool LuminaEngineCore::makeContextCurrent() {
+    if (eglSurface_ == EGL_NO_SURFACE) {
+        if (!recreateWindowSurface()) return false;
+    }
+    if (!eglMakeCurrent(eglDisplay_, eglSurface_, eglSurface_, eglContext_)) {
+        EGLint err = eglGetError();
+        LOGE("eglMakeCurrent failed: 0x%x", err);
+        if (err == EGL_CONTEXT_LOST || err == EGL_BAD_CONTEXT) {
+            return recoverEglContext();
+        }
+        return false;
+    }
+    return true;
+}
+
+void LuminaEngineCore::drawFrame(int64_t frameTimeNanos, int64_t presentTimeNanos) {
+    LUMINA_TRACE_SCOPE("Lumina::drawFrame");
+    std::unique_lock<std::mutex> lock(mutex_, std::defer_lock);
+    {
+        // A long slice here is a frame blocked by an upload or surface change, not the GPU.
+        LUMINA_TRACE_SCOPE("Lumina::waitEngineLock");
+        lock.lock();
+    }
 
     if (!initialized_ || !nativeWindow_) return;
 
-    if (!useVulkan_) {
-        if (eglSurface_ == EGL_NO_SURFACE) {
-            if (!recreateWindowSurface()) return;
-        }
-        if (!eglMakeCurrent(eglDisplay_, eglSurface_, eglSurface_, eglContext_)) {
-            EGLint err = eglGetError();
-            LOGE("eglMakeCurrent failed: 0x%x", err);
-            if (err == EGL_CONTEXT_LOST || err == EGL_BAD_CONTEXT) {
-                if (!recoverEglContext()) return;
-            } else {
-                return;
-            }
+    // Newest published state; this slot stays ours until the next acquire().
+    lumina::LuminaState& frame = stateSnapshots_.acquire();
+    AHardwareBuffer* video = decoder_ ? nextVideoFrame(frameTimeNanos) : nullptr;
+
+    // Nothing new to show: skip the frame before any GL or Vulkan work, leaving the
+    // last image on screen. A recording keeps drawing so the encoder sees a steady rate.
+    const bool forced = redrawRequested_.exchange(false);
+    if (!forced && !encoderWindow_ &&
+        !redraw_.needsRedraw(frame.stateId, inputSeq_, lumina::usesFrameTime(frame))) {
+        // The next drawn frame measures its delta from here, not across the idle stretch.
+        lastFrameTime_ = std::chrono::high_resolution_clock::now();
+        // Frames already submitted keep finishing and freeing camera buffers. GL stays
+        // current on this thread between frames; if it is not, the next drawn frame collects.
+        if (cameraHolds_.pending() > 0 && (useVulkan_ || eglGetCurrentContext() == eglContext_)) {
+            collectCameraHolds();
         }
+        collectFrameSlots();
+        return;
     }
 
-    updateFrameTiming();
-    performRender();
+    if (!useVulkan_ && !makeContextCurrent()) return;
+    if (!useVulkan_) bindPendingCameraBuffer();
+    lumina::ScopedStageTimer frameTimer(&frameStats_, lumina::FrameStage::CpuFrame);
+    applyStateDimensions(frame);
+    updateFrameTiming(frame);
+
+    // Recorded frames are stamped with when they are meant to be seen.
+    int64_t recordTime = 0;
+    const bool record = encoderWindow_ &&
+        recordingClock_.next(presentTimeNanos > 0 ? presentTimeNanos : frameTimeNanos, &recordTime);
+    if (useVulkan_ && vkRenderer_) {
+        vkRenderer_->setDesiredPresentTime(static_cast<uint64_t>(presentTimeNanos));
+        vkRenderer_->setEncoderTimestamp(record ? recordTime : 0);
+    }
+    if (video) applyVideoFrame(video);
+    if (adaptiveResolution_) updateRenderScale(frameTimeNanos);
+    const uint64_t frameIndex = useVulkan_ ? (vkRenderer_ ? vkRenderer_->submittedFrames() : 0)
+                                           : (glRenderer_ ? glRenderer_->submittedFrames() : 0);
+    bool presented = performRender(frame);
+    // Counted whether or not the frame succeeded: it may have read the buffer before failing.
+    cameraHolds_.sampled(frameIndex);
+    collectCameraHolds();
+    collectFrameSlots();
 
     if (!useVulkan_) {
+        if (record && encoderSurface_ != EGL_NO_SURFACE) presentToEncoder(recordTime);
+        // After the encoder copy, so recordings carry the frame without the UI's glass.
+        if (presented && glRenderer_) glRenderer_->renderGlass(frame.uiStyle);
+        // Swappy-style pacing: without this a frame rendered early for a 30 fps slot
+        // would be shown at the next 60 Hz vsync.
+        if (eglPresentationTime_ && presentTimeNanos > 0) {
+            eglPresentationTime_(eglDisplay_, eglSurface_, static_cast<EGLnsecsANDROID>(presentTimeNanos));
+        }
+        lumina::ScopedStageTimer submitTimer(&frameStats_, lumina::FrameStage::Submit);
+        LUMINA_TRACE_SCOPE("eglSwapBuffers");
         if (!eglSwapBuffers(eglDisplay_, eglSurface_)) {
             EGLint err = eglGetError();
             LOGE("eglSwapBuffers failed: 0x%x", err);
+            presented = false;
             if (err == EGL_BAD_SURFACE || err == EGL_CONTEXT_LOST) {
                 recoverEglContext();
             }
         }
     }
+    // A failed frame leaves the tracker as it was, so the next vsync tries again.
+    if (presented) redraw_.presented(frame.stateId, inputSeq_);
+}
+
+bool LuminaEngineCore::isFrameDirty() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!initialized_ || !nativeWindow_) return false;
+    if (redrawRequested_ || encoderWindow_ || (decoder_ && playback_.playing())) return true;
+    std::lock_guard<std::mutex> stateLock(stateMutex_);
+    return redraw_.needsRedraw(state_.stateId, inputSeq_, lumina::usesFrameTime(state_));
 }
 
 lumina::FrameTiming LuminaEngineCore::getFrameTiming() const {
-    return state_ ? state_->timing : lumina::FrameTiming();
+    return timingSnapshot_.load();
 }
 
-const lumina::LuminaState* LuminaEngineCore::getState() const {
-    return state_.get();
+lumina::LuminaState LuminaEngineCore::getState() const {
+    lumina::LuminaState copy;
+    {
+        std::lock_guard<std::mutex> lock(stateMutex_);
+        copy = state_;
+    }
+    copy.timing = timingSnapshot_.load();
+    return copy;
 }
 
-GLuint LuminaEngineCore::getVideoTextureId() const {
-    return glRenderer_ ? glRenderer_->getInputTextureId() : 0;
+GLuint LuminaEngineCore::getVideoTextureId() {
+    GLuint textureId = 0;
+    renderThread_.runSync([this, &textureId] {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (!glRenderer_) return;
+        // The texture must be created in the render thread's context.
+        if (!useVulkan_ && eglContext_ != EGL_NO_CONTEXT && nativeWindow_) makeContextCurrent();
+        textureId = glRenderer_->getInputTextureId();
+    });
+    return textureId;
 }
 
-void LuminaEngineCore::uploadCameraFrame(const uint8_t* data, size_t size, uint32_t width, uint32_t height) {
+uint64_t LuminaEngineCore::uploadCameraFrame(const uint8_t* data, size_t size, uint32_t width, uint32_t height) {
+    LUMINA_TRACE_SCOPE("Lumina::uploadCameraFrame");
     std::lock_guard<std::mutex> lock(mutex_);
-    if (!initialized_ || !data || size == 0 || width == 0 || height == 0) return;
+    if (!initialized_ || decoder_ || !data || size == 0 || width == 0 || height == 0) return 0;
+
+    lumina::ScopedStageTimer timer(&frameStats_, lumina::FrameStage::Upload);
+    // GLES takes the camera through its external texture, so there is nothing to upload
+    // and nothing new to draw. A failed upload leaves the previous frame on screen.
+    if (!useVulkan_ || !vkRenderer_ || !vkRenderer_->uploadTexture(data, size, width, height)) return 0;
+    ++inputSeq_;
+    cameraHolds_.detach();
+    return vkRenderer_->lastUploadValue();
+}
 
+uint64_t LuminaEngineCore::uploadCameraFrame(AHardwareBuffer* buffer) {
+    LUMINA_TRACE_SCOPE("Lumina::uploadCameraHardwareBuffer");
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!initialized_ || decoder_ || !buffer) return 0;
+
+    lumina::ScopedStageTimer timer(&frameStats_, lumina::FrameStage::Upload);
     if (useVulkan_) {
-        if (vkRenderer_) vkRenderer_->uploadTexture(data, size, width, height);
+        if (!vkRenderer_ || !vkRenderer_->importHardwareBuffer(buffer)) return 0;
     } else {
-        // GLES path uses external textures; no CPU upload here.
+        if (!glRenderer_) return 0;
+        // The EGLImage needs the render thread's context. A buffer replaced before
+        // drawFrame() got to it was never sampled and goes straight back.
+        AHardwareBuffer_acquire(buffer);
+        if (pendingCameraBuffer_) AHardwareBuffer_release(pendingCameraBuffer_);
+        pendingCameraBuffer_ = buffer;
+    }
+    ++inputSeq_;
+    return cameraHolds_.attach();
+}
+
+void LuminaEngineCore::bindPendingCameraBuffer() {
+    if (!pendingCameraBuffer_) return;
+    if (glRenderer_ && !glRenderer_->setInputHardwareBuffer(pendingCameraBuffer_)) {
+        // Back to the camera texture; nothing will read the buffer.
+        glRenderer_->setInputHardwareBuffer(nullptr);
+        cameraHolds_.detach();
+    }
+    // The renderer keeps its own reference to buffers it imported.
+    AHardwareBuffer_release(pendingCameraBuffer_);
+    pendingCameraBuffer_ = nullptr;
+}
+
+void LuminaEngineCore::collectCameraHolds() {
+    if (useVulkan_ && vkRenderer_) {
+        cameraHolds_.collect(vkRenderer_->completedFrames());
+    } else if (!useVulkan_ && glRenderer_) {
+        cameraHolds_.collect(glRenderer_->completedFrames());
+    }
+    releasedCameraFrames_.store(cameraHolds_.released(), std::memory_order_release);
+}
+
+void LuminaEngineCore::releaseCameraHolds() {
+    if (pendingCameraBuffer_) {
+        AHardwareBuffer_release(pendingCameraBuffer_);
+        pendingCameraBuffer_ = nullptr;
+    }
+    cameraHolds_.releaseAll();
+    releasedCameraFrames_.store(cameraHolds_.released(), std::memory_order_release);
+    // Upload values restart with the next renderer; nothing can read a retired slot now.
+    framePool_.collect(UINT64_MAX);
+}
+
+void LuminaEngineCore::collectFrameSlots() {
+    if (useVulkan_ && vkRenderer_ && framePool_.retiredCount() > 0) {
+        framePool_.collect(vkRenderer_->completedUploads());
+    }
+}
+
+int LuminaEngineCore::acquireFrameSlot() {
+    const int index = framePool_.acquire();
+    if (index >= 0 || framePool_.retiredCount() == 0) return index;
+    {
+        // Uploads finish whether or not frames are drawn; take back what they are done with.
+        std::lock_guard<std::mutex> lock(mutex_);
+        collectFrameSlots();
+    }
+    return framePool_.acquire();
+}
+
+void LuminaEngineCore::submitFrameSlot(int index, size_t size, uint32_t width, uint32_t height) {
+    const uint8_t* data = framePool_.data(index);
+    if (!data) {
+        LOGW("submitFrameSlot: slot %d was not acquired", index);
+        return;
+    }
+    // The slot stays out until the upload that read it has executed on the GPU.
+    const uint64_t readyValue = uploadCameraFrame(data, std::min(size, framePool_.slotBytes()), width, height);
+    if (readyValue == 0 || !framePool_.retire(index, readyValue)) framePool_.release(index);
+}
+
+bool LuminaEngineCore::uploadCameraFrame(const lumina::YuvPlanes& planes, uint32_t downscale) {
+    LUMINA_TRACE_SCOPE("Lumina::uploadCameraYuv");
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!initialized_ || decoder_) return false;
+
+    lumina::ScopedStageTimer timer(&frameStats_, lumina::FrameStage::Upload);
+    if (useVulkan_ && vkRenderer_ && vkRenderer_->uploadYuv(planes, downscale)) {
+        ++inputSeq_;
+        cameraHolds_.detach();
+        return true;
+    }
+    return false;
+}
+
+bool LuminaEngineCore::setAnalysisOutput(const lumina::AnalysisConfig& config) {
+    if (!lumina::isValidAnalysisConfig(config)) {
+        LOGE("Invalid analysis output %ux%u (format %u)", config.width, config.height,
+             static_cast<uint32_t>(config.format));
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    analysisConfig_ = config;
+    if (useVulkan_ && vkRenderer_) {
+        vkRenderer_->setAnalysisOutput(config, &analysisFrames_);
+    } else if (!useVulkan_ && glRenderer_) {
+        glRenderer_->setAnalysisOutput(config, &analysisFrames_);
+    }
+    // Analysis frames come out of drawn frames; draw one for the new config.
+    redraw_.invalidate();
+    LOGI("Analysis output set to %ux%u %s", config.width, config.height,
+         config.format == lumina::AnalysisFormat::GRAY ? "gray" : "rgb");
+    return true;
+}
+
+void LuminaEngineCore::setGlassPanels(const lumina::GlassLayout& layout) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    glassLayout_ = layout;
+    if (useVulkan_ && vkRenderer_) {
+        vkRenderer_->setGlassLayout(layout);
+    } else if (!useVulkan_ && glRenderer_) {
+        glRenderer_->setGlassLayout(layout);
+    }
+    redraw_.invalidate();
+}
+
+bool LuminaEngineCore::openVideo(int fd, int64_t offset, int64_t length) {
+    if (!initialized_) return false;
+
+    // Codec start-up takes tens of milliseconds; keep it off the engine lock.
+    auto decoder = std::make_unique<VideoDecoder>();
+    if (!decoder->open(fd, offset, length)) return false;
+    const VideoDecoder::Info info = decoder->info();
+
+    std::unique_ptr<VideoDecoder> previous;  // closed below, outside the lock
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        previous = std::move(decoder_);
+        decoder_ = std::move(decoder);
+        playback_ = lumina::PlaybackClock();
+        videoPtsUs_ = -1;
+        if (glRenderer_) glRenderer_->setInputHardwareBuffer(nullptr);
+        if (pendingCameraBuffer_) {
+            AHardwareBuffer_release(pendingCameraBuffer_);
+            pendingCameraBuffer_ = nullptr;
+        }
+        cameraHolds_.detach();
+    }
+    LOGI("Video source %dx%d, %lld ms", info.width, info.height,
+         static_cast<long long>(info.durationUs / 1000));
+    return true;
+}
+
+void LuminaEngineCore::closeVideo() {
+    std::unique_ptr<VideoDecoder> decoder;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        decoder = std::move(decoder_);
+        // Back to the camera; the renderers keep their own references to the last
+        // decoded buffers until they are replaced.
+        if (glRenderer_) glRenderer_->setInputHardwareBuffer(nullptr);
+        ++inputSeq_;
+    }
+    if (decoder) LOGI("Video source closed");
+}
+
+void LuminaEngineCore::setVideoPlaying(bool playing) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!decoder_) return;
+    if (playing && decoder_->finished()) {
+        // Play at the end starts over.
+        playback_.seek(0);
+        decoder_->seek(0);
+    }
+    playback_.setPlaying(playing);
+}
+
+void LuminaEngineCore::seekVideo(int64_t timeUs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!decoder_) return;
+    timeUs = std::clamp<int64_t>(timeUs, 0, std::max<int64_t>(decoder_->info().durationUs, 0));
+    playback_.seek(timeUs);
+    decoder_->seek(timeUs);
+}
+
+lumina::SourceMode LuminaEngineCore::getSourceMode() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return decoder_ ? lumina::SourceMode::VIDEO : lumina::SourceMode::CAMERA;
+}
+
+bool LuminaEngineCore::getVideoInfo(lumina::VideoSourceInfo* info) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!decoder_ || !info) return false;
+    info->width = decoder_->info().width;
+    info->height = decoder_->info().height;
+    info->durationUs = decoder_->info().durationUs;
+    info->positionUs = playback_.positionUs();
+    info->playing = playback_.playing();
+    info->ended = decoder_->finished();
+    return true;
+}
+
+bool LuminaEngineCore::startExport(int fd, int64_t offset, int64_t length, const std::string& path,
+                                   const lumina::RecordingConfig& config) {
+    if (!initialized_) return false;
+    std::lock_guard<std::mutex> lock(exportMutex_);
+    if (exporter_ && exporter_->progress().running) {
+        LOGW("An export is already running");
+        return false;
+    }
+    auto exporter = std::make_unique<VideoExporter>();
+    if (!exporter->start(fd, offset, length, getState(), path, config)) return false;
+    exporter_ = std::move(exporter);
+    LOGI("Exporting to %s", path.c_str());
+    return true;
+}
+
+bool LuminaEngineCore::startExport(int fd, int64_t offset, int64_t length, ANativeWindow* window) {
+    if (!initialized_ || !window) {
+        if (window) ANativeWindow_release(window);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(exportMutex_);
+    if (exporter_ && exporter_->progress().running) {
+        LOGW("An export is already running");
+        ANativeWindow_release(window);
+        return false;
+    }
+    auto exporter = std::make_unique<VideoExporter>();
+    if (!exporter->start(fd, offset, length, getState(), window)) return false;
+    exporter_ = std::move(exporter);
+    return true;
+}
+
+void LuminaEngineCore::cancelExport() {
+    std::lock_guard<std::mutex> lock(exportMutex_);
+    if (exporter_) exporter_->cancel();
+}
+
+bool LuminaEngineCore::getExportProgress(lumina::ExportProgress* progress) const {
+    std::lock_guard<std::mutex> lock(exportMutex_);
+    if (!exporter_ || !progress) return false;
+    *progress = exporter_->progress();
+    return true;
+}
+
+AHardwareBuffer* LuminaEngineCore::nextVideoFrame(int64_t frameTimeNanos) {
+    int64_t ptsUs = -1;
+    AHardwareBuffer* buffer = decoder_->frameAt(playback_.mediaTimeUs(frameTimeNanos), &ptsUs);
+    if (playback_.playing() && decoder_->finished()) playback_.setPlaying(false);
+    if (!buffer) return nullptr;
+    // A paused clip keeps returning the frame already on screen.
+    if (ptsUs != videoPtsUs_) {
+        videoPtsUs_ = ptsUs;
+        ++inputSeq_;
+    }
+    return buffer;
+}
+
+void LuminaEngineCore::applyVideoFrame(AHardwareBuffer* buffer) {
+    LUMINA_TRACE_SCOPE("Lumina::applyVideoFrame");
+    lumina::ScopedStageTimer timer(&frameStats_, lumina::FrameStage::Upload);
+    cameraHolds_.detach();
+    // Re-importing the current frame is a cache hit in either renderer.
+    if (useVulkan_ && vkRenderer_) {
+        vkRenderer_->importHardwareBuffer(buffer);
+    } else if (!useVulkan_ && glRenderer_) {
+        glRenderer_->setInputHardwareBuffer(buffer);
     }
 }
 
@@ -338,13 +1072,27 @@ bool LuminaEngineCore::initializeGraphics() {
         LOGI("GLES 3 initialized");
         return true;
     }
+    // Whatever EGL objects came up before the failing step.
+    destroyEgl();
 
     LOGE("Failed to initialize any graphics API");
     return false;
 }
 
+void LuminaEngineCore::warmUpPipelines() {
+    LUMINA_TRACE_SCOPE("Lumina::warmUpPipelines");
+    const std::vector<lumina::LuminaState> states = lumina::warmupStates();
+    const bool warmed = useVulkan_ ? (vkRenderer_ && vkRenderer_->warmUp(states))
+                                   : (glRenderer_ && glRenderer_->warmUp(states));
+    // Not fatal: whatever failed here is built (or fails) again at first use.
+    if (!warmed) LOGW("Pipeline warm-up incomplete");
+}
+
 bool LuminaEngineCore::initializeVulkan() {
     vkRenderer_ = std::make_unique<VulkanRenderer>();
+    vkRenderer_->setCacheDirectory(shaderCacheDir_);
+    vkRenderer_->setFrameStats(&frameStats_);
+    // Usually no window yet: the device comes up alone and the surface attaches later.
     if (!vkRenderer_->initialize(nativeWindow_)) {
         vkRenderer_.reset();
         return false;
@@ -366,7 +1114,9 @@ bool LuminaEngineCore::initializeGLES() {
         return false;
     }
 
-    const EGLint attribs[] = {
+    // Recordable so the same context can draw into encoder input surfaces; dropped
+    // again (the last two entries) if no such config exists.
+    EGLint attribs[] = {
         EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT,
         EGL_SURFACE_TYPE, EGL_WINDOW_BIT | EGL_PBUFFER_BIT,
         EGL_BLUE_SIZE, 8,
@@ -375,13 +1125,18 @@ bool LuminaEngineCore::initializeGLES() {
         EGL_ALPHA_SIZE, 8,
         EGL_DEPTH_SIZE, 24,
         EGL_STENCIL_SIZE, 8,
+        EGL_RECORDABLE_ANDROID, EGL_TRUE,
         EGL_NONE
     };
 
     EGLint numConfigs = 0;
     if (!eglChooseConfig(eglDisplay_, attribs, &eglConfig_, 1, &numConfigs) || numConfigs < 1) {
-        LOGE("eglChooseConfig failed: 0x%x", eglGetError());
-        return false;
+        LOGW("No recordable EGL config; recording may be unavailable");
+        attribs[std::size(attribs) - 3] = EGL_NONE;
+        if (!eglChooseConfig(eglDisplay_, attribs, &eglConfig_, 1, &numConfigs) || numConfigs < 1) {
+            LOGE("eglChooseConfig failed: 0x%x", eglGetError());
+            return false;
+        }
     }
 
     const EGLint contextAttribs[] = { EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE };
@@ -419,23 +1174,32 @@ void LuminaEngineCore::shutdownGraphics() {
         if (vkRenderer_) vkRenderer_->destroy();
     }
     if (!useVulkan_) {
-        if (glRenderer_) glRenderer_->destroy();
-        if (eglDisplay_ != EGL_NO_DISPLAY) {
-            if (eglSurface_ != EGL_NO_SURFACE) {
-                eglDestroySurface(eglDisplay_, eglSurface_);
-                eglSurface_ = EGL_NO_SURFACE;
-            }
-            if (eglContext_ != EGL_NO_CONTEXT) {
-                eglDestroyContext(eglDisplay_, eglContext_);
-                eglContext_ = EGL_NO_CONTEXT;
-            }
-            eglTerminate(eglDisplay_);
-            eglDisplay_ = EGL_NO_DISPLAY;
+        if (eglContext_ != EGL_NO_CONTEXT) {
+            eglMakeCurrent(eglDisplay_, eglSurface_, eglSurface_, eglContext_);
         }
+        if (glRenderer_) glRenderer_->destroy();
+        destroyEncoderSurface();
+        destroyEgl();
     }
 }
 
+void LuminaEngineCore::destroyEgl() {
+    if (eglDisplay_ == EGL_NO_DISPLAY) return;
+    eglMakeCurrent(eglDisplay_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+    if (eglSurface_ != EGL_NO_SURFACE) {
+        eglDestroySurface(eglDisplay_, eglSurface_);
+        eglSurface_ = EGL_NO_SURFACE;
+    }
+    if (eglContext_ != EGL_NO_CONTEXT) {
+        eglDestroyContext(eglDisplay_, eglContext_);
+        eglContext_ = EGL_NO_CONTEXT;
+    }
+    eglTerminate(eglDisplay_);
+    eglDisplay_ = EGL_NO_DISPLAY;
+}
+
 bool LuminaEngineCore::recreateWindowSurface() {
+    redraw_.invalidate();
     if (useVulkan_) {
         // Vulkan swapchain recreation will be handled inside the renderer when needed.
         return true;
@@ -479,6 +1243,8 @@ bool LuminaEngineCore::recoverEglContext() {
     LOGW("Recovering EGL context");
 
     if (glRenderer_) glRenderer_->onContextLost();
+    // Nothing issued on the lost context runs any more.
+    releaseCameraHolds();
 
     if (eglSurface_ != EGL_NO_SURFACE) {
         eglDestroySurface(eglDisplay_, eglSurface_);
@@ -525,27 +1291,88 @@ bool LuminaEngineCore::recoverEglContext() {
     return recreateWindowSurface();
 }
 
-void LuminaEngineCore::updateFrameTiming() {
+void LuminaEngineCore::applyStateDimensions(const lumina::LuminaState& state) {
+    // Writers only record the size; the renderer hears about changes here, on the render thread.
+    const int width = static_cast<int>(state.width);
+    const int height = static_cast<int>(state.height);
+    if (width == stateWidth_ && height == stateHeight_) return;
+    stateWidth_ = width;
+    stateHeight_ = height;
+    if (width > 0 && height > 0 && (width != surfaceWidth_ || height != surfaceHeight_)) {
+        surfaceWidth_ = width;
+        surfaceHeight_ = height;
+        if (glRenderer_) glRenderer_->onSurfaceSize(width, height);
+    }
+}
+
+void LuminaEngineCore::updateFrameTiming(lumina::LuminaState& frame) {
     auto now = std::chrono::high_resolution_clock::now();
     auto duration = std::chrono::duration<float>(now - lastFrameTime_);
 
-    state_->timing.deltaTime = duration.count();
-    state_->timing.totalTime += state_->timing.deltaTime;
-    state_->timing.frameCount++;
+    timing_.deltaTime = duration.count();
+    timing_.totalTime += timing_.deltaTime;
+    timing_.frameCount++;
 
-    if (state_->timing.deltaTime > 0) {
-        float instantFps = 1.0f / state_->timing.deltaTime;
-        state_->timing.fps = state_->timing.fps * 0.9f + instantFps * 0.1f;
+    if (timing_.deltaTime > 0) {
+        float instantFps = 1.0f / timing_.deltaTime;
+        timing_.fps = timing_.fps * 0.9f + instantFps * 0.1f;
     }
 
+    // Newest resolved samples: the CPU time of the previous frame, and GPU time from
+    // queries that completed a few frames back. Seconds, like deltaTime.
+    timing_.cpuTime = frameStats_.last(lumina::FrameStage::CpuFrame) * 1e-3f;
+    timing_.gpuTime = frameStats_.last(lumina::FrameStage::GpuFrame) * 1e-3f;
+
     lastFrameTime_ = now;
+    frame.timing = timing_;
+    timingSnapshot_.store(timing_);
+}
+
+void LuminaEngineCore::updateRenderScale(int64_t frameTimeNanos) {
+    // The headroom forecast is rate-limited by the platform; once a second is plenty.
+    constexpr int64_t kThermalPollNanos = 1000000000;
+    if (frameTimeNanos - lastThermalPollNs_ >= kThermalPollNanos) {
+        lastThermalPollNs_ = frameTimeNanos;
+        if (__builtin_available(android 30, *)) {
+            if (!thermal_) thermal_ = AThermal_acquireManager();
+        }
+        if (__builtin_available(android 31, *)) {
+            if (thermal_) {
+                // Forecast 10 s ahead; NaN (unsupported or polled too often) reads as unknown.
+                const float headroom = AThermal_getThermalHeadroom(thermal_, 10);
+                thermalHeadroom_ = std::isnan(headroom) ? -1.0f : headroom;
+            }
+        }
+    }
+
+    const int fps = renderThread_.targetFrameRate();
+    const int64_t vsync = renderThread_.vsyncPeriodNanos();
+    const int64_t budget = fps > 0 ? std::max<int64_t>(1000000000 / fps, vsync) : vsync;
+    const float gpuMs = frameStats_.last(lumina::FrameStage::GpuFrame);
+    if (renderScale_.update(gpuMs, static_cast<float>(budget) * 1e-6f, thermalHeadroom_)) {
+        LOGI("Render scale %.3f (GPU %.2f ms, headroom %.2f)", renderScale_.scale(), gpuMs,
+             thermalHeadroom_);
+        applyRenderScale(renderScale_.scale());
+    }
 }
 
-void LuminaEngineCore::performRender() {
+void LuminaEngineCore::applyRenderScale(float scale) {
+    redraw_.invalidate();
     if (useVulkan_) {
-        // [FIX] Pass the dereferenced state object
-        if (vkRenderer_) vkRenderer_->render(*state_);
-    } else {
-        if (glRenderer_) glRenderer_->render(*state_);
+        if (vkRenderer_) vkRenderer_->setRenderScale(scale);
+    } else if (glRenderer_) {
+        glRenderer_->setRenderScale(scale);
     }
-}
\ No newline at end of file
+}
+
+bool LuminaEngineCore::performRender(const lumina::LuminaState& frame) {
+    if (useVulkan_) {
+        if (!vkRenderer_) return false;
+        const uint64_t submitted = vkRenderer_->submittedFrames();
+        return vkRenderer_->render(frame) && vkRenderer_->submittedFrames() != submitted;
+    }
+    if (!glRenderer_) return false;
+    // Vulkan splits record/submit itself; for GL, issuing the commands is the record stage.
+    lumina::ScopedStageTimer recordTimer(&frameStats_, lumina::FrameStage::Record);
+    return glRenderer_->render(frame);
+}
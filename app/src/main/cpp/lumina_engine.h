@@ -4,35 +4,187 @@
 #include <jni.h>
 #include <string>
 #include <android/native_window.h>
+#include <android/hardware_buffer.h>
+#include <android/thermal.h>
+#include <atomic>
 #include <chrono>
+#include <functional>
 #include <memory>
 #include <mutex>
+#include <vector>
 #include <EGL/egl.h>
+#include <EGL/eglext.h>
 #include <GLES3/gl3.h>
 
+#include "analysis_frame.h"
+#include "command_stream.h"
 #include "engine_structs.h"
+#include "frame_pool.h"
+#include "frame_stats.h"
+#include "glass_panels.h"
+#include "input_release.h"
+#include "json_parser.h"
+#include "pixel_convert.h"
+#include "recording.h"
+#include "redraw_tracker.h"
+#include "render_scale.h"
+#include "render_thread.h"
+#include "shared_state.h"
+#include "state_snapshot.h"
+#include "video_source.h"
 
 class GLRenderer;
+class VideoDecoder;
+class VideoEncoder;
+class VideoExporter;
 class VulkanRenderer;
 
 class LuminaEngineCore {
 public:
     static LuminaEngineCore& getInstance();
 
-    bool initialize(JNIEnv* env, jobject assetManager);
+    enum class InitStatus { Idle, Pending, Ready, Failed };
+    using ReadyCallback = std::function<void(bool ready)>;
+
+    // Staged start-up. The caller only resets state and starts the render thread;
+    // instance and device creation, the GLES fallback and a pipeline warm-up of every
+    // single-effect variant (effect_graph.h) then run on the render thread, which
+    // reports the outcome through `onReady`. A surface passed to setSurfaceWindow()
+    // meanwhile is attached once the device is up. A call while a start-up is pending
+    // adds its callback to it. shaderCacheDir holds persisted pipeline caches and
+    // program binaries (may be empty).
+    bool initializeAsync(JNIEnv* env, jobject assetManager, const std::string& shaderCacheDir,
+                         ReadyCallback onReady);
+
+    // initializeAsync() and wait for the outcome.
+    bool initialize(JNIEnv* env, jobject assetManager, const std::string& shaderCacheDir = std::string());
+    InitStatus initStatus() const { return initStatus_.load(std::memory_order_acquire); }
     void shutdown(JNIEnv* env = nullptr);
 
     bool updateStateFromJson(const std::string& json);
+
+    // Hot-path update from a lumina::StatePacket (see state_packet.h); no parsing or allocation.
+    bool updateStateFromPacket(const void* data, size_t size);
     void setRenderMode(int mode);
+
+    // Command stream (command_stream.h): the state commands in `data` apply under one
+    // stateMutex_ acquisition and publish once. `results` may be null; otherwise it
+    // receives a lumina::CommandResults when it is at least that large.
+    bool submitCommands(const void* data, size_t size, void* results, size_t resultsSize);
+
+    // Shared state block (shared_state.h) in SharedMemory that Kotlin allocated; `fd`
+    // is taken over and the block is laid out afresh. From then on every published
+    // state is mirrored into its ring, and commitSharedIntents() applies the intent
+    // records the orchestrator or Kotlin wrote in place. Detached by shutdown().
+    bool attachSharedState(int fd);
+    void detachSharedState();
+    bool commitSharedIntents();
+
+    // Duplicate of the block's descriptor for another mapping (Python mmap), or -1.
+    int dupSharedStateFd() const;
     void setSurfaceWindow(ANativeWindow* window);
+
+    // Frames are drawn on the engine's render thread, paced by the display, while a
+    // surface is attached, but only when something on screen changed (redraw_tracker.h):
+    // the state, the camera or video frame, or effects animated by time. Otherwise the
+    // last image stays up. renderFrame() forces a frame at the next vsync.
     void renderFrame();
-    GLuint getVideoTextureId() const;
+
+    // True when the next paced vsync will draw a frame.
+    bool isFrameDirty() const;
+
+    // 0 follows the display; otherwise e.g. 30/60/90/120 to match the camera sensor.
+    void setTargetFrameRate(int fps);
+
+    // Adaptive render scale (render_scale.h), on by default: multi-pass stacks render
+    // their intermediate passes smaller while the GPU runs over budget or the device
+    // nears thermal throttling. Disabling restores full resolution.
+    void setAdaptiveResolution(bool enabled);
+    GLuint getVideoTextureId();
 
     // Upload an RGBA8 camera frame (e.g., after AHardwareBuffer readback) into the active renderer.
-    void uploadCameraFrame(const uint8_t* data, size_t size, uint32_t width, uint32_t height);
+    // Returns the upload's completion value (VulkanRenderer::completedUploads()), or 0
+    // when nothing was uploaded and nothing will read `data` again.
+    uint64_t uploadCameraFrame(const uint8_t* data, size_t size, uint32_t width, uint32_t height);
+
+    // Zero-copy variant: the renderer samples the camera's AHardwareBuffer in place. Returns
+    // a token for the buffer, or 0 when it cannot be imported and callers fall back to the
+    // RGBA path. The producer keeps the buffer's Image open until releasedCameraFrames()
+    // reaches the token; handing it back earlier lets the camera overwrite a frame the GPU
+    // is still reading. GLES binds the buffer at the next drawFrame(), on the render thread.
+    uint64_t uploadCameraFrame(AHardwareBuffer* buffer);
+
+    // Newest uploadCameraFrame(AHardwareBuffer*) token whose buffer the renderer is done
+    // with; every earlier token is done as well. Lock-free.
+    uint64_t releasedCameraFrames() const { return releasedCameraFrames_.load(std::memory_order_acquire); }
+
+    // YUV_420_888 planes straight from the camera, converted on the CPU into the Vulkan
+    // staging buffer (downscale 1, 2 or 4). Returns false when unsupported (GLES).
+    bool uploadCameraFrame(const lumina::YuvPlanes& planes, uint32_t downscale);
+
+    // Native-owned camera frame slots (frame_pool.h). The producer fills an acquired
+    // slot and submits it; the slot goes back to the pool once the upload that read it
+    // has executed, or straight away when nothing was uploaded. The pool outlives
+    // shutdown() so Java wrappers around slot memory stay valid for the life of the process.
+    lumina::FramePool& framePool() { return framePool_; }
+    int acquireFrameSlot();
+    void submitFrameSlot(int index, size_t size, uint32_t width, uint32_t height);
+
+    // Downsampled, packed copies of the camera input for the ML side (analysis_frame.h),
+    // read back asynchronously by the presenting renderer. A zero width turns the branch
+    // off; a new config takes effect at the next frame.
+    bool setAnalysisOutput(const lumina::AnalysisConfig& config);
 
+    // Where the UI's frosted panels sit over the surface (glass_panels.h). The presenting
+    // renderer blurs the frame behind each one with the uiStyle glass radius and tone,
+    // after the frame went to any recording. Takes effect at the next frame.
+    void setGlassPanels(const lumina::GlassLayout& layout);
+
+    // Copies the newest analysis frame not read yet; see AnalysisFrameExchange::readLatest().
+    size_t readAnalysisFrame(uint8_t* dst, size_t capacity, lumina::AnalysisFrameInfo* info) {
+        return analysisFrames_.readLatest(dst, capacity, info);
+    }
+
+    // Recording (recording.h): while an encoder window is attached every frame is also
+    // drawn into it, from GPU memory and timestamped with its presentation time.
+    // startRecording() encodes H.264 into an MP4 at `path` with the native encoder
+    // (video_encoder.h); stopRecording() detaches it and finalizes the file, returning
+    // false if nothing usable was written. setEncoderWindow() attaches a caller-owned
+    // input surface instead (e.g. MediaCodec.createInputSurface()); it takes over the
+    // reference, null detaches, and it refuses while a native recording runs.
+    bool startRecording(const std::string& path, const lumina::RecordingConfig& config);
+    bool stopRecording();
+    bool setEncoderWindow(ANativeWindow* window);
+
+    // Video source (video_source.h): openVideo() decodes a clip natively (video_decoder.h)
+    // and the renderers sample its frames in place of the camera until closeVideo();
+    // camera uploads are ignored meanwhile. The clip opens paused on its first frame and,
+    // while playing, advances with the display's frame times. `fd` is duplicated.
+    bool openVideo(int fd, int64_t offset, int64_t length);
+    void closeVideo();
+    void setVideoPlaying(bool playing);
+    void seekVideo(int64_t timeUs);
+    lumina::SourceMode getSourceMode() const;
+    // False while the camera is the source.
+    bool getVideoInfo(lumina::VideoSourceInfo* info) const;
+
+    // Offline export (video_exporter.h): renders every frame of the clip in `fd` through
+    // the current effect state, unthrottled, on a thread and GL context of its own,
+    // into an MP4 at `path` or into a caller-owned `window` (reference taken over). The
+    // preview carries on meanwhile. One export at a time; its progress stays readable
+    // until the next one starts.
+    bool startExport(int fd, int64_t offset, int64_t length, const std::string& path,
+                     const lumina::RecordingConfig& config);
+    bool startExport(int fd, int64_t offset, int64_t length, ANativeWindow* window);
+    void cancelExport();
+    bool getExportProgress(lumina::ExportProgress* progress) const;
+
+    // Safe from any thread; neither call waits on the render thread.
     lumina::FrameTiming getFrameTiming() const;
-    const lumina::LuminaState* getState() const;
+    lumina::LuminaState getState() const;
+
+    // Rolling p50/p95/p99 per stage and per GPU pass, in milliseconds (see frame_stats.h).
+    std::string getFrameStatsJson() const { return frameStats_.toJson(); }
 
 private:
     LuminaEngineCore();
@@ -41,41 +193,136 @@ private:
     LuminaEngineCore(const LuminaEngineCore&) = delete;
     LuminaEngineCore& operator=(const LuminaEngineCore&) = delete;
 
+    void completeInitialize();
+    void warmUpPipelines();
     bool initializeGraphics();
     bool initializeVulkan();
     bool initializeGLES();
+    void destroyEgl();
     void shutdownGraphics();
+    void releaseAssetManager(JNIEnv* env);
+    void bindPendingCameraBuffer();
+    void collectCameraHolds();
+    void releaseCameraHolds();
+    void collectFrameSlots();
 
+    void applySurfaceWindow(ANativeWindow* window);
+    void attachEncoderWindow(ANativeWindow* window);
+    void applyEncoderWindow(ANativeWindow* window);
+    bool createEncoderSurface();
+    void destroyEncoderSurface();
+    void presentToEncoder(int64_t timestampNs);
+    void applyFrameRateHint();
+    void drawFrame(int64_t frameTimeNanos, int64_t presentTimeNanos);
+    bool makeContextCurrent();
     bool recreateWindowSurface();
     bool recoverEglContext();
-    void updateFrameTiming();
-    void performRender();
+    void publishState();
+    void applyStateDimensions(const lumina::LuminaState& state);
+    void updateFrameTiming(lumina::LuminaState& frame);
+    bool performRender(const lumina::LuminaState& frame);
+    AHardwareBuffer* nextVideoFrame(int64_t frameTimeNanos);
+    void applyVideoFrame(AHardwareBuffer* buffer);
+    void updateRenderScale(int64_t frameTimeNanos);
+    void applyRenderScale(float scale);
 
     // Members
-    std::unique_ptr<lumina::LuminaState> state_;
-    bool initialized_ = false;
+    // State writers (JSON, packets, render mode, surface size) edit state_ under stateMutex_
+    // and publish a copy; renderFrame() picks up the newest copy without taking that lock.
+    lumina::LuminaState state_;
+    lumina::json::JsonDocument jsonDoc_; // reused so steady-state updates do not allocate
+    lumina::TripleBuffer<lumina::LuminaState> stateSnapshots_;
+    lumina::SeqLock<lumina::FrameTiming> timingSnapshot_;
+    lumina::SharedStateBlock sharedState_; // mapping of sharedStateFd_, under stateMutex_
+    void* sharedStateMapping_ = nullptr;
+    size_t sharedStateSize_ = 0;
+    int sharedStateFd_ = -1;
+    lumina::FrameTiming timing_;         // render thread only
+    lumina::FrameStats frameStats_;      // fed from JNI, camera and render threads
+    lumina::FramePool framePool_;        // camera CPU frames, internally locked
+    lumina::AnalysisFrameExchange analysisFrames_; // render thread -> ML readers
+    lumina::AnalysisConfig analysisConfig_;        // guarded by mutex_; survives re-initialization
+    lumina::GlassLayout glassLayout_;              // guarded by mutex_; survives re-initialization
+    int stateWidth_ = 0;                 // last dimensions seen in a snapshot (render thread)
+    int stateHeight_ = 0;
+    std::atomic<bool> initialized_{false};   // graphics up; set by completeInitialize()
+
+    // Staged start-up, under initMutex_ (never held with mutex_ or stateMutex_). A
+    // surface set while Pending waits in pendingWindow_ with its reference.
+    std::mutex initMutex_;
+    std::atomic<InitStatus> initStatus_{InitStatus::Idle};
+    std::vector<ReadyCallback> readyCallbacks_;
+    ANativeWindow* pendingWindow_ = nullptr;
+    bool windowPending_ = false;
     bool useVulkan_ = false;
 
     jobject assetManager_ = nullptr;
+    std::string shaderCacheDir_;
     ANativeWindow* nativeWindow_ = nullptr;
 
+    // Recording; the window and surface belong to the render thread, under mutex_.
+    ANativeWindow* encoderWindow_ = nullptr;
+    std::unique_ptr<VideoEncoder> encoder_;  // native encoder, when startRecording() made the window
+    std::mutex recordingMutex_;              // serialises start/stop; never taken on the render thread
+    lumina::RecordingClock recordingClock_;
+
+    // Offline export; exportMutex_ is never held together with mutex_.
+    std::unique_ptr<VideoExporter> exporter_;
+    mutable std::mutex exportMutex_;
+
+    // Video source, under mutex_; the camera is the source while decoder_ is null.
+    std::unique_ptr<VideoDecoder> decoder_;
+    lumina::PlaybackClock playback_;
+
     // EGL
     EGLDisplay eglDisplay_ = EGL_NO_DISPLAY;
     EGLConfig eglConfig_ = nullptr;
     EGLContext eglContext_ = EGL_NO_CONTEXT;
     EGLSurface eglSurface_ = EGL_NO_SURFACE;
+    EGLSurface encoderSurface_ = EGL_NO_SURFACE;
     int surfaceWidth_ = 0;
     int surfaceHeight_ = 0;
+    int encoderWidth_ = 0;
+    int encoderHeight_ = 0;
+    PFNEGLPRESENTATIONTIMEANDROIDPROC eglPresentationTime_ = nullptr;
 
     // Rendering
     std::unique_ptr<class GLRenderer> glRenderer_;
     std::unique_ptr<class VulkanRenderer> vkRenderer_;
 
+    // Adaptive resolution, render thread under mutex_. thermalHeadroom_ is negative
+    // until AThermal_getThermalHeadroom() (API 31) reports a value.
+    lumina::RenderScaleController renderScale_;
+    bool adaptiveResolution_ = true;
+    AThermalManager* thermal_ = nullptr;
+    int64_t lastThermalPollNs_ = 0;
+    float thermalHeadroom_ = -1.0f;
+
+    // Redraw tracking, under mutex_. inputSeq_ counts camera and video frames handed to
+    // the renderers; renderFrame() sets redrawRequested_ without taking the lock.
+    lumina::RedrawTracker redraw_;
+    uint64_t inputSeq_ = 0;
+    int64_t videoPtsUs_ = -1;
+    std::atomic<bool> redrawRequested_{false};
+
+    // Zero-copy camera buffers, under mutex_. cameraHolds_ outlives re-initialization so
+    // tokens keep increasing; releasedCameraFrames_ mirrors its watermark for the camera
+    // thread. pendingCameraBuffer_ holds a reference until drawFrame() binds it (GLES).
+    lumina::InputReleaseTracker cameraHolds_;
+    std::atomic<uint64_t> releasedCameraFrames_{0};
+    AHardwareBuffer* pendingCameraBuffer_ = nullptr;
+
     // Timing
     std::chrono::high_resolution_clock::time_point lastFrameTime_ =
         std::chrono::high_resolution_clock::now();
 
+    // mutex_ guards the graphics objects (render, surface, uploads); stateMutex_ guards
+    // state_ and jsonDoc_. Lock order is mutex_ then stateMutex_. Never hold either
+    // across renderThread_.runSync().
     mutable std::mutex mutex_;
+    mutable std::mutex stateMutex_;
+
+    RenderThread renderThread_;
 };
 
 #endif // LUMINA_ENGINE_H
@@ -6,18 +6,65 @@
 #include <cstdlib>
 #include <algorithm>
 #include <cctype>
+#include <vector>
 #include <jni.h>
 #include <android/native_window_jni.h>
+#include <android/hardware_buffer_jni.h>
+#include <android/sharedmem_jni.h>
 #include <cstdio>
 #include <android/log.h>
 
 #include "lumina_engine.h"
+#include "trace.h"
 
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, "LuminaJNI", __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, "LuminaJNI", __VA_ARGS__)
 
 extern JavaVM* g_vm;
 
+namespace {
+
+std::string cacheDirFrom(JNIEnv* env, jstring shaderCacheDir) {
+    std::string cacheDir;
+    if (shaderCacheDir) {
+        const char* dir = env->GetStringUTFChars(shaderCacheDir, nullptr);
+        cacheDir = dir;
+        env->ReleaseStringUTFChars(shaderCacheDir, dir);
+    }
+    return cacheDir;
+}
+
+// Calls listener.onEngineReady(ready) and drops the global reference. Runs on the
+// render thread, which is attached to the VM for the call only.
+void notifyEngineReady(jobject listener, bool ready) {
+    if (!g_vm) return;
+    JNIEnv* env = nullptr;
+    bool didAttach = false;
+    if (g_vm->GetEnv(reinterpret_cast<void**>(&env), JNI_VERSION_1_6) != JNI_OK) {
+        if (g_vm->AttachCurrentThread(&env, nullptr) != JNI_OK) {
+            LOGE("notifyEngineReady: cannot attach to the VM");
+            return;
+        }
+        didAttach = true;
+    }
+
+    jclass cls = env->GetObjectClass(listener);
+    jmethodID onReady = env->GetMethodID(cls, "onEngineReady", "(Z)V");
+    if (onReady) {
+        env->CallVoidMethod(listener, onReady, ready ? JNI_TRUE : JNI_FALSE);
+    }
+    if (env->ExceptionCheck()) {
+        // Nothing on this thread can handle it.
+        env->ExceptionDescribe();
+        env->ExceptionClear();
+    }
+    env->DeleteLocalRef(cls);
+    env->DeleteGlobalRef(listener);
+    if (didAttach) g_vm->DetachCurrentThread();
+}
+
+} // namespace
+
 extern "C" {
 
 
@@ -33,24 +80,127 @@ JNIEXPORT jboolean JNICALL
 Java_com_lumina_engine_NativeEngine_nativeInit(
     JNIEnv* env,
     jobject /* this */,
-    jobject assetManager
+    jobject assetManager,
+    jstring shaderCacheDir
 ) {
-    bool ok = LuminaEngineCore::getInstance().initialize(env, assetManager);
+    bool ok = LuminaEngineCore::getInstance().initialize(env, assetManager, cacheDirFrom(env, shaderCacheDir));
     return ok ? JNI_TRUE : JNI_FALSE;
 }
 
+JNIEXPORT jboolean JNICALL
+Java_com_lumina_engine_NativeEngine_nativeInitAsync(
+    JNIEnv* env,
+    jobject /* this */,
+    jobject assetManager,
+    jstring shaderCacheDir,
+    jobject listener
+) {
+    jobject callback = listener ? env->NewGlobalRef(listener) : nullptr;
+    bool started = LuminaEngineCore::getInstance().initializeAsync(
+        env, assetManager, cacheDirFrom(env, shaderCacheDir), [callback](bool ready) {
+            if (callback) notifyEngineReady(callback, ready);
+        });
+    if (!started && callback) env->DeleteGlobalRef(callback);
+    return started ? JNI_TRUE : JNI_FALSE;
+}
+
 JNIEXPORT jboolean JNICALL
 Java_com_lumina_engine_NativeEngine_nativeUpdateState(
     JNIEnv* env,
     jobject /* this */,
     jstring jsonState
 ) {
+    // JNI slices bracket the engine slices; the gap between them is marshalling cost.
+    LUMINA_TRACE_SCOPE("JNI::nativeUpdateState");
     const char* json = env->GetStringUTFChars(jsonState, nullptr);
     bool result = LuminaEngineCore::getInstance().updateStateFromJson(json);
     env->ReleaseStringUTFChars(jsonState, json);
     return result ? JNI_TRUE : JNI_FALSE;
 }
 
+JNIEXPORT jboolean JNICALL
+Java_com_lumina_engine_NativeEngine_nativeUpdateStateBinary(
+    JNIEnv* env,
+    jobject /* this */,
+    jobject buffer,
+    jint size
+) {
+    LUMINA_TRACE_SCOPE("JNI::nativeUpdateStateBinary");
+    if (!buffer) return JNI_FALSE;
+    void* ptr = env->GetDirectBufferAddress(buffer);
+    jlong capacity = env->GetDirectBufferCapacity(buffer);
+    if (!ptr || size <= 0 || capacity < size) {
+        LOGE("nativeUpdateStateBinary: buffer not direct or too small");
+        return JNI_FALSE;
+    }
+    bool result = LuminaEngineCore::getInstance().updateStateFromPacket(ptr, static_cast<size_t>(size));
+    return result ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_lumina_engine_NativeEngine_nativeSubmitCommands(
+    JNIEnv* env,
+    jobject /* this */,
+    jobject commands,
+    jint size,
+    jobject results
+) {
+    LUMINA_TRACE_SCOPE("JNI::nativeSubmitCommands");
+    if (!commands) return JNI_FALSE;
+    void* ptr = env->GetDirectBufferAddress(commands);
+    jlong capacity = env->GetDirectBufferCapacity(commands);
+    if (!ptr || size <= 0 || capacity < size) {
+        LOGE("nativeSubmitCommands: buffer not direct or too small");
+        return JNI_FALSE;
+    }
+    void* out = results ? env->GetDirectBufferAddress(results) : nullptr;
+    const jlong outCapacity = out ? env->GetDirectBufferCapacity(results) : 0;
+    bool result = LuminaEngineCore::getInstance().submitCommands(
+        ptr, static_cast<size_t>(size), out, static_cast<size_t>(std::max<jlong>(outCapacity, 0)));
+    return result ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_lumina_engine_NativeEngine_nativeAttachSharedState(
+    JNIEnv* env,
+    jobject /* this */,
+    jobject sharedMemory
+) {
+    if (!sharedMemory) return JNI_FALSE;
+    // The duplicate belongs to the engine; Kotlin keeps and closes its own.
+    const int fd = ASharedMemory_dupFromJava(env, sharedMemory);
+    if (fd < 0) {
+        LOGE("nativeAttachSharedState: cannot duplicate SharedMemory descriptor");
+        return JNI_FALSE;
+    }
+    return LuminaEngineCore::getInstance().attachSharedState(fd) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_lumina_engine_NativeEngine_nativeDetachSharedState(
+    JNIEnv* /* env */,
+    jobject /* this */
+) {
+    LuminaEngineCore::getInstance().detachSharedState();
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_lumina_engine_NativeEngine_nativeCommitSharedIntents(
+    JNIEnv* /* env */,
+    jobject /* this */
+) {
+    LUMINA_TRACE_SCOPE("JNI::nativeCommitSharedIntents");
+    return LuminaEngineCore::getInstance().commitSharedIntents() ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_lumina_engine_NativeEngine_nativeDupSharedStateFd(
+    JNIEnv* /* env */,
+    jobject /* this */
+) {
+    return LuminaEngineCore::getInstance().dupSharedStateFd();
+}
+
 JNIEXPORT void JNICALL
 Java_com_lumina_engine_NativeEngine_nativeSetRenderMode(
     JNIEnv* /* env */,
@@ -70,6 +220,24 @@ Java_com_lumina_engine_NativeEngine_nativeSetSurface(
     LuminaEngineCore::getInstance().setSurfaceWindow(window);
 }
 
+JNIEXPORT void JNICALL
+Java_com_lumina_engine_NativeEngine_nativeSetTargetFrameRate(
+    JNIEnv* /* env */,
+    jobject /* this */,
+    jint fps
+) {
+    LuminaEngineCore::getInstance().setTargetFrameRate(fps);
+}
+
+JNIEXPORT void JNICALL
+Java_com_lumina_engine_NativeEngine_nativeSetAdaptiveResolution(
+    JNIEnv* /* env */,
+    jobject /* this */,
+    jboolean enabled
+) {
+    LuminaEngineCore::getInstance().setAdaptiveResolution(enabled == JNI_TRUE);
+}
+
 JNIEXPORT void JNICALL
 Java_com_lumina_engine_NativeEngine_nativeRenderFrame(
     JNIEnv* /* env */,
@@ -78,6 +246,14 @@ Java_com_lumina_engine_NativeEngine_nativeRenderFrame(
     LuminaEngineCore::getInstance().renderFrame();
 }
 
+JNIEXPORT jboolean JNICALL
+Java_com_lumina_engine_NativeEngine_nativeIsFrameDirty(
+    JNIEnv* /* env */,
+    jobject /* this */
+) {
+    return LuminaEngineCore::getInstance().isFrameDirty() ? JNI_TRUE : JNI_FALSE;
+}
+
 JNIEXPORT jstring JNICALL
 Java_com_lumina_engine_NativeEngine_nativeGetFrameTimingJson(
     JNIEnv* env,
@@ -88,7 +264,7 @@ Java_com_lumina_engine_NativeEngine_nativeGetFrameTimingJson(
     // Build JSON manually (replace with proper JSON library in production)
     char buffer[256];
     snprintf(buffer, sizeof(buffer),
-        R"({"deltaTime":%.6f,"totalTime":%.2f,"frameCount":%llu,"fps":%.1f,"gpuTime":%.3f,"cpuTime":%.3f})",
+        R"({"deltaTime":%.6f,"totalTime":%.2f,"frameCount":%llu,"fps":%.1f,"gpuTime":%.6f,"cpuTime":%.6f})",
         timing.deltaTime,
         timing.totalTime,
         static_cast<unsigned long long>(timing.frameCount),
@@ -100,6 +276,15 @@ Java_com_lumina_engine_NativeEngine_nativeGetFrameTimingJson(
     return env->NewStringUTF(buffer);
 }
 
+JNIEXPORT jstring JNICALL
+Java_com_lumina_engine_NativeEngine_nativeGetFrameStatsJson(
+    JNIEnv* env,
+    jobject /* this */
+) {
+    const std::string stats = LuminaEngineCore::getInstance().getFrameStatsJson();
+    return env->NewStringUTF(stats.c_str());
+}
+
 JNIEXPORT jstring JNICALL
 Java_com_lumina_engine_NativeEngine_nativeGetVersion(
     JNIEnv* env,
@@ -127,6 +312,7 @@ Java_com_lumina_engine_NativeEngine_nativeUploadCameraFrame(
     jint width,
     jint height
 ) {
+    LUMINA_TRACE_SCOPE("JNI::nativeUploadCameraFrame");
     if (!buffer) return;
     void* ptr = env->GetDirectBufferAddress(buffer);
     jlong capacity = env->GetDirectBufferCapacity(buffer);
@@ -137,6 +323,373 @@ Java_com_lumina_engine_NativeEngine_nativeUploadCameraFrame(
     LuminaEngineCore::getInstance().uploadCameraFrame(static_cast<uint8_t*>(ptr), static_cast<size_t>(capacity), static_cast<uint32_t>(width), static_cast<uint32_t>(height));
 }
 
+JNIEXPORT jlong JNICALL
+Java_com_lumina_engine_NativeEngine_nativeUploadCameraHardwareBuffer(
+    JNIEnv* env,
+    jobject /* this */,
+    jobject hardwareBuffer
+) {
+    LUMINA_TRACE_SCOPE("JNI::nativeUploadCameraHardwareBuffer");
+    if (!hardwareBuffer) return 0;
+    // The renderer's reference keeps the memory alive, so the Java HardwareBuffer may be
+    // closed after this call. The Image it came from may not: closing that hands the
+    // buffer back to the camera, so it stays open until nativeReleasedCameraFrames()
+    // reaches the returned token.
+    AHardwareBuffer* buffer = AHardwareBuffer_fromHardwareBuffer(env, hardwareBuffer);
+    if (!buffer) {
+        LOGE("nativeUploadCameraHardwareBuffer: invalid HardwareBuffer");
+        return 0;
+    }
+    return static_cast<jlong>(LuminaEngineCore::getInstance().uploadCameraFrame(buffer));
+}
+
+JNIEXPORT jlong JNICALL
+Java_com_lumina_engine_NativeEngine_nativeReleasedCameraFrames(
+    JNIEnv* /* env */,
+    jobject /* this */
+) {
+    return static_cast<jlong>(LuminaEngineCore::getInstance().releasedCameraFrames());
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_lumina_engine_NativeEngine_nativeUploadCameraYuv(
+    JNIEnv* env,
+    jobject /* this */,
+    jobject yPlane,
+    jobject uPlane,
+    jobject vPlane,
+    jint yRowStride,
+    jint uvRowStride,
+    jint uvPixelStride,
+    jint width,
+    jint height,
+    jint downscale
+) {
+    LUMINA_TRACE_SCOPE("JNI::nativeUploadCameraYuv");
+    if (!yPlane || !uPlane || !vPlane || width <= 0 || height <= 0 ||
+        yRowStride <= 0 || uvRowStride <= 0 || uvPixelStride <= 0) {
+        return JNI_FALSE;
+    }
+
+    lumina::YuvPlanes planes;
+    planes.y = static_cast<const uint8_t*>(env->GetDirectBufferAddress(yPlane));
+    planes.u = static_cast<const uint8_t*>(env->GetDirectBufferAddress(uPlane));
+    planes.v = static_cast<const uint8_t*>(env->GetDirectBufferAddress(vPlane));
+    planes.yRowStride = static_cast<uint32_t>(yRowStride);
+    planes.uvRowStride = static_cast<uint32_t>(uvRowStride);
+    planes.uvPixelStride = static_cast<uint32_t>(uvPixelStride);
+    planes.width = static_cast<uint32_t>(width);
+    planes.height = static_cast<uint32_t>(height);
+    if (!planes.y || !planes.u || !planes.v) {
+        LOGE("nativeUploadCameraYuv: planes must be direct buffers");
+        return JNI_FALSE;
+    }
+
+    // Plane buffers are read in place, so they must cover every sample the strides address.
+    const jlong yBytes = env->GetDirectBufferCapacity(yPlane);
+    const jlong uBytes = env->GetDirectBufferCapacity(uPlane);
+    const jlong vBytes = env->GetDirectBufferCapacity(vPlane);
+    const size_t chromaBytes = lumina::yuvChromaBytes(planes);
+    if (yBytes < 0 || static_cast<size_t>(yBytes) < lumina::yuvLumaBytes(planes) ||
+        uBytes < 0 || static_cast<size_t>(uBytes) < chromaBytes ||
+        vBytes < 0 || static_cast<size_t>(vBytes) < chromaBytes) {
+        LOGE("nativeUploadCameraYuv: planes too small for %dx%d (strides %d/%d/%d)",
+             width, height, yRowStride, uvRowStride, uvPixelStride);
+        return JNI_FALSE;
+    }
+
+    return LuminaEngineCore::getInstance().uploadCameraFrame(planes, static_cast<uint32_t>(downscale))
+        ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_lumina_engine_NativeEngine_nativeConfigureFramePool(
+    JNIEnv* /* env */,
+    jobject /* this */,
+    jint slotCount,
+    jint slotBytes
+) {
+    if (slotCount <= 0 || slotBytes <= 0) return JNI_FALSE;
+    return LuminaEngineCore::getInstance().framePool().configure(
+        static_cast<uint32_t>(slotCount), static_cast<size_t>(slotBytes)) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_lumina_engine_NativeEngine_nativeAcquireFrameSlot(
+    JNIEnv* /* env */,
+    jobject /* this */
+) {
+    return static_cast<jint>(LuminaEngineCore::getInstance().acquireFrameSlot());
+}
+
+JNIEXPORT jobject JNICALL
+Java_com_lumina_engine_NativeEngine_nativeGetFrameSlotBuffer(
+    JNIEnv* env,
+    jobject /* this */,
+    jint index
+) {
+    // Only valid for an acquired slot; Kotlin caches the wrapper until the pool is reconfigured.
+    lumina::FramePool& pool = LuminaEngineCore::getInstance().framePool();
+    uint8_t* data = pool.data(index);
+    if (!data) return nullptr;
+    return env->NewDirectByteBuffer(data, static_cast<jlong>(pool.slotBytes()));
+}
+
+JNIEXPORT void JNICALL
+Java_com_lumina_engine_NativeEngine_nativeSubmitFrameSlot(
+    JNIEnv* /* env */,
+    jobject /* this */,
+    jint index,
+    jint size,
+    jint width,
+    jint height
+) {
+    LUMINA_TRACE_SCOPE("JNI::nativeSubmitFrameSlot");
+    LuminaEngineCore& engine = LuminaEngineCore::getInstance();
+    if (size <= 0 || width <= 0 || height <= 0) {
+        engine.framePool().release(index);
+        return;
+    }
+    engine.submitFrameSlot(index, static_cast<size_t>(size), static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+}
+
+JNIEXPORT void JNICALL
+Java_com_lumina_engine_NativeEngine_nativeReleaseFrameSlot(
+    JNIEnv* /* env */,
+    jobject /* this */,
+    jint index
+) {
+    LuminaEngineCore::getInstance().framePool().release(index);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_lumina_engine_NativeEngine_nativeSetAnalysisOutput(
+    JNIEnv* /* env */,
+    jobject /* this */,
+    jint width,
+    jint height,
+    jboolean grayscale
+) {
+    if (width < 0 || height < 0) return JNI_FALSE;
+    lumina::AnalysisConfig config;
+    config.width = static_cast<uint32_t>(width);
+    config.height = static_cast<uint32_t>(height);
+    config.format = grayscale ? lumina::AnalysisFormat::GRAY : lumina::AnalysisFormat::RGB;
+    return LuminaEngineCore::getInstance().setAnalysisOutput(config) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jint JNICALL
+Java_com_lumina_engine_NativeEngine_nativeReadAnalysisFrame(
+    JNIEnv* env,
+    jobject /* this */,
+    jobject buffer,
+    jlongArray info
+) {
+    // A null or too small buffer still reports the frame size through `info`.
+    uint8_t* dst = buffer ? static_cast<uint8_t*>(env->GetDirectBufferAddress(buffer)) : nullptr;
+    const jlong capacity = dst ? env->GetDirectBufferCapacity(buffer) : 0;
+    lumina::AnalysisFrameInfo frame;
+    const size_t copied = LuminaEngineCore::getInstance().readAnalysisFrame(
+        dst, capacity > 0 ? static_cast<size_t>(capacity) : 0, &frame);
+
+    if (info && env->GetArrayLength(info) >= 5) {
+        const jlong values[5] = {
+            static_cast<jlong>(frame.config.width),
+            static_cast<jlong>(frame.config.height),
+            static_cast<jlong>(frame.config.format),
+            static_cast<jlong>(frame.frameNumber),
+            static_cast<jlong>(frame.timestampNs),
+        };
+        env->SetLongArrayRegion(info, 0, 5, values);
+    }
+    return static_cast<jint>(copied);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_lumina_engine_NativeEngine_nativeStartRecording(
+    JNIEnv* env,
+    jobject /* this */,
+    jstring path,
+    jint width,
+    jint height,
+    jint frameRate,
+    jint bitRate
+) {
+    if (!path) return JNI_FALSE;
+    const char* chars = env->GetStringUTFChars(path, nullptr);
+    const std::string file(chars);
+    env->ReleaseStringUTFChars(path, chars);
+
+    lumina::RecordingConfig config;
+    config.width = width;
+    config.height = height;
+    config.frameRate = frameRate;
+    config.bitRate = bitRate;
+    return LuminaEngineCore::getInstance().startRecording(file, config) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_lumina_engine_NativeEngine_nativeStopRecording(
+    JNIEnv* /* env */,
+    jobject /* this */
+) {
+    return LuminaEngineCore::getInstance().stopRecording() ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_lumina_engine_NativeEngine_nativeSetEncoderSurface(
+    JNIEnv* env,
+    jobject /* this */,
+    jobject surface
+) {
+    ANativeWindow* window = surface ? ANativeWindow_fromSurface(env, surface) : nullptr;
+    if (surface && !window) return JNI_FALSE;
+    return LuminaEngineCore::getInstance().setEncoderWindow(window) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_lumina_engine_NativeEngine_nativeOpenVideo(
+    JNIEnv* /* env */,
+    jobject /* this */,
+    jint fd,
+    jlong offset,
+    jlong length
+) {
+    return LuminaEngineCore::getInstance().openVideo(fd, offset, length) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_lumina_engine_NativeEngine_nativeCloseVideo(
+    JNIEnv* /* env */,
+    jobject /* this */
+) {
+    LuminaEngineCore::getInstance().closeVideo();
+}
+
+JNIEXPORT void JNICALL
+Java_com_lumina_engine_NativeEngine_nativeSetVideoPlaying(
+    JNIEnv* /* env */,
+    jobject /* this */,
+    jboolean playing
+) {
+    LuminaEngineCore::getInstance().setVideoPlaying(playing == JNI_TRUE);
+}
+
+JNIEXPORT void JNICALL
+Java_com_lumina_engine_NativeEngine_nativeSeekVideo(
+    JNIEnv* /* env */,
+    jobject /* this */,
+    jlong timeUs
+) {
+    LuminaEngineCore::getInstance().seekVideo(timeUs);
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_lumina_engine_NativeEngine_nativeGetVideoInfo(
+    JNIEnv* env,
+    jobject /* this */,
+    jlongArray info
+) {
+    lumina::VideoSourceInfo video;
+    if (!info || env->GetArrayLength(info) < 6 || !LuminaEngineCore::getInstance().getVideoInfo(&video)) {
+        return JNI_FALSE;
+    }
+    const jlong values[6] = {
+        static_cast<jlong>(video.width),
+        static_cast<jlong>(video.height),
+        static_cast<jlong>(video.durationUs),
+        static_cast<jlong>(video.positionUs),
+        video.playing ? 1 : 0,
+        video.ended ? 1 : 0,
+    };
+    env->SetLongArrayRegion(info, 0, 6, values);
+    return JNI_TRUE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_lumina_engine_NativeEngine_nativeStartExport(
+    JNIEnv* env,
+    jobject /* this */,
+    jint fd,
+    jlong offset,
+    jlong length,
+    jstring path,
+    jint width,
+    jint height,
+    jint frameRate,
+    jint bitRate
+) {
+    if (!path) return JNI_FALSE;
+    const char* chars = env->GetStringUTFChars(path, nullptr);
+    if (!chars) return JNI_FALSE;
+    const std::string file(chars);
+    env->ReleaseStringUTFChars(path, chars);
+
+    lumina::RecordingConfig config;
+    config.width = width;
+    config.height = height;
+    config.frameRate = frameRate;
+    config.bitRate = bitRate;
+    return LuminaEngineCore::getInstance().startExport(fd, offset, length, file, config) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_lumina_engine_NativeEngine_nativeStartExportToSurface(
+    JNIEnv* env,
+    jobject /* this */,
+    jint fd,
+    jlong offset,
+    jlong length,
+    jobject surface
+) {
+    ANativeWindow* window = surface ? ANativeWindow_fromSurface(env, surface) : nullptr;
+    if (!window) return JNI_FALSE;
+    return LuminaEngineCore::getInstance().startExport(fd, offset, length, window) ? JNI_TRUE : JNI_FALSE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_lumina_engine_NativeEngine_nativeCancelExport(
+    JNIEnv* /* env */,
+    jobject /* this */
+) {
+    LuminaEngineCore::getInstance().cancelExport();
+}
+
+JNIEXPORT jboolean JNICALL
+Java_com_lumina_engine_NativeEngine_nativeGetExportProgress(
+    JNIEnv* env,
+    jobject /* this */,
+    jlongArray info
+) {
+    lumina::ExportProgress progress;
+    if (!info || env->GetArrayLength(info) < 5 || !LuminaEngineCore::getInstance().getExportProgress(&progress)) {
+        return JNI_FALSE;
+    }
+    const jlong values[5] = {
+        static_cast<jlong>(progress.framesRendered),
+        static_cast<jlong>(progress.positionUs),
+        static_cast<jlong>(progress.durationUs),
+        progress.running ? 1 : 0,
+        progress.succeeded ? 1 : 0,
+    };
+    env->SetLongArrayRegion(info, 0, 5, values);
+    return JNI_TRUE;
+}
+
+JNIEXPORT void JNICALL
+Java_com_lumina_engine_NativeEngine_nativeSetGlassPanels(
+    JNIEnv* env,
+    jobject /* this */,
+    jfloatArray panels
+) {
+    std::vector<float> values;
+    if (panels) {
+        values.resize(static_cast<size_t>(env->GetArrayLength(panels)));
+        env->GetFloatArrayRegion(panels, 0, static_cast<jsize>(values.size()), values.data());
+    }
+    LuminaEngineCore::getInstance().setGlassPanels(lumina::makeGlassLayout(values.data(), values.size()));
+}
+
 // JNI_OnLoad - Called when the library is loaded
 JNIEXPORT jint JNI_OnLoad(JavaVM* vm, void* /* reserved */) {
     LOGI("Lumina Engine JNI loaded");
@@ -0,0 +1,203 @@
+#include "pixel_convert.h"
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+namespace lumina {
+
+namespace {
+
+// BT.601 limited range in 6-bit fixed point. Every intermediate fits int16, which is
+// what lets the NEON path keep eight pixels per register; the scalar path does the
+// same integer math so both produce identical bytes.
+constexpr int32_t kYOffset = 16;
+constexpr int32_t kUvOffset = 128;
+constexpr int32_t kYScale = 74;   // 1.164
+constexpr int32_t kVToR = 102;    // 1.596
+constexpr int32_t kUToG = 25;     // 0.391
+constexpr int32_t kVToG = 52;     // 0.813
+constexpr int32_t kUToB = 129;    // 2.018
+
+uint8_t clampPixel(int32_t value) {
+    value = (value + 32) >> 6;
+    return static_cast<uint8_t>(value < 0 ? 0 : (value > 255 ? 255 : value));
+}
+
+void yuvToRgbaPixel(uint32_t y, uint32_t u, uint32_t v, uint8_t* out) {
+    const int32_t yy = (static_cast<int32_t>(y) - kYOffset) * kYScale;
+    const int32_t uu = static_cast<int32_t>(u) - kUvOffset;
+    const int32_t vv = static_cast<int32_t>(v) - kUvOffset;
+    out[0] = clampPixel(yy + kVToR * vv);
+    out[1] = clampPixel(yy - kUToG * uu - kVToG * vv);
+    out[2] = clampPixel(yy + kUToB * uu);
+    out[3] = 255;
+}
+
+uint32_t chromaWidth(const YuvPlanes& p) { return (p.width + 1) / 2; }
+uint32_t chromaHeight(const YuvPlanes& p) { return (p.height + 1) / 2; }
+
+uint32_t lumaAt(const YuvPlanes& p, uint32_t x, uint32_t y) {
+    return p.y[static_cast<size_t>(y) * p.yRowStride + x];
+}
+
+uint32_t chromaAt(const YuvPlanes& p, const uint8_t* plane, uint32_t cx, uint32_t cy) {
+    return plane[static_cast<size_t>(cy) * p.uvRowStride + static_cast<size_t>(cx) * p.uvPixelStride];
+}
+
+// Output pixels [x0, outWidth) of output row `oy`; the whole row without NEON, the
+// tail the vector loop leaves otherwise.
+void convertRowScalar(const YuvPlanes& p, uint32_t oy, uint32_t x0, uint32_t outWidth, uint32_t factor,
+                      uint8_t* out) {
+    for (uint32_t x = x0; x < outWidth; ++x) {
+        uint32_t y, u, v;
+        if (factor == 1) {
+            y = lumaAt(p, x, oy);
+            u = chromaAt(p, p.u, x / 2, oy / 2);
+            v = chromaAt(p, p.v, x / 2, oy / 2);
+        } else if (factor == 2) {
+            y = (lumaAt(p, 2 * x, 2 * oy) + lumaAt(p, 2 * x + 1, 2 * oy) +
+                 lumaAt(p, 2 * x, 2 * oy + 1) + lumaAt(p, 2 * x + 1, 2 * oy + 1) + 2) >> 2;
+            u = chromaAt(p, p.u, x, oy);
+            v = chromaAt(p, p.v, x, oy);
+        } else {
+            uint32_t sum = 0;
+            for (uint32_t dy = 0; dy < 4; ++dy) {
+                for (uint32_t dx = 0; dx < 4; ++dx) sum += lumaAt(p, 4 * x + dx, 4 * oy + dy);
+            }
+            y = (sum + 8) >> 4;
+            u = (chromaAt(p, p.u, 2 * x, 2 * oy) + chromaAt(p, p.u, 2 * x + 1, 2 * oy) +
+                 chromaAt(p, p.u, 2 * x, 2 * oy + 1) + chromaAt(p, p.u, 2 * x + 1, 2 * oy + 1) + 2) >> 2;
+            v = (chromaAt(p, p.v, 2 * x, 2 * oy) + chromaAt(p, p.v, 2 * x + 1, 2 * oy) +
+                 chromaAt(p, p.v, 2 * x, 2 * oy + 1) + chromaAt(p, p.v, 2 * x + 1, 2 * oy + 1) + 2) >> 2;
+        }
+        yuvToRgbaPixel(y, u, v, out + static_cast<size_t>(x) * 4);
+    }
+}
+
+#if defined(__ARM_NEON)
+
+// Eight RGBA pixels from eight Y/U/V samples, mirroring yuvToRgbaPixel(). The B sum
+// can exceed int16 only where the result clamps to 255 anyway, hence vqadd.
+void convert8(uint8x8_t y, uint8x8_t u, uint8x8_t v, uint8_t* out) {
+    const int16x8_t yy = vmulq_n_s16(vreinterpretq_s16_u16(vsubl_u8(y, vdup_n_u8(kYOffset))), kYScale);
+    const int16x8_t uu = vreinterpretq_s16_u16(vsubl_u8(u, vdup_n_u8(kUvOffset)));
+    const int16x8_t vv = vreinterpretq_s16_u16(vsubl_u8(v, vdup_n_u8(kUvOffset)));
+    const int16x8_t r = vqaddq_s16(yy, vmulq_n_s16(vv, kVToR));
+    const int16x8_t g = vqsubq_s16(yy, vmlaq_n_s16(vmulq_n_s16(uu, kUToG), vv, kVToG));
+    const int16x8_t b = vqaddq_s16(yy, vmulq_n_s16(uu, kUToB));
+    uint8x8x4_t rgba;
+    rgba.val[0] = vqrshrun_n_s16(r, 6);
+    rgba.val[1] = vqrshrun_n_s16(g, 6);
+    rgba.val[2] = vqrshrun_n_s16(b, 6);
+    rgba.val[3] = vdup_n_u8(255);
+    vst4_u8(out, rgba);
+}
+
+// Contiguous (I420) or every-other-byte (NV12/NV21 semi-planar) chroma samples.
+uint8x8_t loadChroma8(const uint8_t* p, uint32_t pixelStride) {
+    return pixelStride == 1 ? vld1_u8(p) : vld2_u8(p).val[0];
+}
+
+uint8x16_t loadChroma16(const uint8_t* p, uint32_t pixelStride) {
+    return pixelStride == 1 ? vld1q_u8(p) : vld2q_u8(p).val[0];
+}
+
+// Sums of four horizontally adjacent bytes across 32 bytes.
+uint16x8_t sumQuads(const uint8_t* p) {
+    const uint16x8_t lo = vpaddlq_u8(vld1q_u8(p));
+    const uint16x8_t hi = vpaddlq_u8(vld1q_u8(p + 16));
+    return vcombine_u16(vpadd_u16(vget_low_u16(lo), vget_high_u16(lo)),
+                        vpadd_u16(vget_low_u16(hi), vget_high_u16(hi)));
+}
+
+// Vector part of one output row; returns the first pixel left for the scalar tail.
+// Loops stop while at least one chroma column remains, so de-interleaving loads on a
+// semi-planar plane never read past the last sample of its final row.
+uint32_t convertRowNeon(const YuvPlanes& p, uint32_t oy, uint32_t outWidth, uint32_t factor, uint8_t* out) {
+    const uint32_t cw = chromaWidth(p);
+    const uint32_t ps = p.uvPixelStride;
+    uint32_t x = 0;
+    if (factor == 1) {
+        const uint8_t* yRow = p.y + static_cast<size_t>(oy) * p.yRowStride;
+        const size_t cOffset = static_cast<size_t>(oy / 2) * p.uvRowStride;
+        for (uint32_t c = 0; c + 8 < cw; c += 8, x += 16) {
+            const uint8x16_t y = vld1q_u8(yRow + x);
+            const uint8x8_t uc = loadChroma8(p.u + cOffset + static_cast<size_t>(c) * ps, ps);
+            const uint8x8_t vc = loadChroma8(p.v + cOffset + static_cast<size_t>(c) * ps, ps);
+            const uint8x8x2_t uPair = vzip_u8(uc, uc);
+            const uint8x8x2_t vPair = vzip_u8(vc, vc);
+            convert8(vget_low_u8(y), uPair.val[0], vPair.val[0], out + static_cast<size_t>(x) * 4);
+            convert8(vget_high_u8(y), uPair.val[1], vPair.val[1], out + static_cast<size_t>(x + 8) * 4);
+        }
+    } else if (factor == 2) {
+        const uint8_t* row0 = p.y + static_cast<size_t>(2 * oy) * p.yRowStride;
+        const uint8_t* row1 = row0 + p.yRowStride;
+        const size_t cOffset = static_cast<size_t>(oy) * p.uvRowStride;
+        for (; x + 8 <= outWidth && x + 8 < cw; x += 8) {
+            const uint16x8_t sum = vaddq_u16(vpaddlq_u8(vld1q_u8(row0 + 2 * x)), vpaddlq_u8(vld1q_u8(row1 + 2 * x)));
+            const uint8x8_t uc = loadChroma8(p.u + cOffset + static_cast<size_t>(x) * ps, ps);
+            const uint8x8_t vc = loadChroma8(p.v + cOffset + static_cast<size_t>(x) * ps, ps);
+            convert8(vrshrn_n_u16(sum, 2), uc, vc, out + static_cast<size_t>(x) * 4);
+        }
+    } else {
+        const uint8_t* row0 = p.y + static_cast<size_t>(4 * oy) * p.yRowStride;
+        const size_t stride = p.yRowStride;
+        const size_t cOffset0 = static_cast<size_t>(2 * oy) * p.uvRowStride;
+        const size_t cOffset1 = cOffset0 + p.uvRowStride;
+        for (; x + 8 <= outWidth && 2 * x + 16 < cw; x += 8) {
+            const uint8_t* yBlock = row0 + 4 * x;
+            uint16x8_t sum = vaddq_u16(sumQuads(yBlock), sumQuads(yBlock + stride));
+            sum = vaddq_u16(sum, vaddq_u16(sumQuads(yBlock + 2 * stride), sumQuads(yBlock + 3 * stride)));
+            const size_t cx = static_cast<size_t>(2 * x) * ps;
+            const uint16x8_t uSum = vaddq_u16(vpaddlq_u8(loadChroma16(p.u + cOffset0 + cx, ps)),
+                                              vpaddlq_u8(loadChroma16(p.u + cOffset1 + cx, ps)));
+            const uint16x8_t vSum = vaddq_u16(vpaddlq_u8(loadChroma16(p.v + cOffset0 + cx, ps)),
+                                              vpaddlq_u8(loadChroma16(p.v + cOffset1 + cx, ps)));
+            convert8(vrshrn_n_u16(sum, 4), vrshrn_n_u16(uSum, 2), vrshrn_n_u16(vSum, 2),
+                     out + static_cast<size_t>(x) * 4);
+        }
+    }
+    return x;
+}
+
+#endif // __ARM_NEON
+
+} // namespace
+
+size_t yuvLumaBytes(const YuvPlanes& planes) {
+    if (planes.width == 0 || planes.height == 0) return 0;
+    return static_cast<size_t>(planes.height - 1) * planes.yRowStride + planes.width;
+}
+
+size_t yuvChromaBytes(const YuvPlanes& planes) {
+    if (planes.width == 0 || planes.height == 0) return 0;
+    return static_cast<size_t>(chromaHeight(planes) - 1) * planes.uvRowStride +
+           static_cast<size_t>(chromaWidth(planes) - 1) * planes.uvPixelStride + 1;
+}
+
+bool convertYuvToRgba(const YuvPlanes& planes, uint8_t* dst, size_t dstStride, uint32_t downscale) {
+    if (downscale != 1 && downscale != 2 && downscale != 4) return false;
+    if (!planes.y || !planes.u || !planes.v || !dst) return false;
+    if (planes.width < downscale || planes.height < downscale) return false;
+    if (planes.uvPixelStride == 0 || planes.yRowStride < planes.width ||
+        planes.uvRowStride < (chromaWidth(planes) - 1) * planes.uvPixelStride + 1) {
+        return false;
+    }
+
+    const uint32_t outWidth = downscaledExtent(planes.width, downscale);
+    const uint32_t outHeight = downscaledExtent(planes.height, downscale);
+    if (dstStride < static_cast<size_t>(outWidth) * 4) return false;
+
+    for (uint32_t oy = 0; oy < outHeight; ++oy) {
+        uint8_t* out = dst + static_cast<size_t>(oy) * dstStride;
+        uint32_t x = 0;
+#if defined(__ARM_NEON)
+        if (planes.uvPixelStride <= 2) x = convertRowNeon(planes, oy, outWidth, downscale, out);
+#endif
+        convertRowScalar(planes, oy, x, outWidth, downscale, out);
+    }
+    return true;
+}
+
+} // namespace lumina
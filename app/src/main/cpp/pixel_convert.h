@@ -0,0 +1,56 @@
+#ifndef LUMINA_PIXEL_CONVERT_H
+#define LUMINA_PIXEL_CONVERT_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * Lumina Virtual Studio - CPU pixel conversion
+ *
+ * Camera ingest kernels for the staged upload path: YUV_420_888 planes straight from
+ * CameraX ImageProxy buffers to RGBA8888, optionally box-downscaled by 2 or 4, written
+ * directly into the destination (typically mapped staging memory) so no intermediate
+ * RGBA frame is ever materialised. NEON on arm64 / armv7 with NEON, scalar elsewhere;
+ * both paths share the same fixed-point math and produce identical output.
+ */
+
+namespace lumina {
+
+/**
+ * One YUV_420_888 frame as exposed by android.media.Image. Covers NV12 (V = U + 1,
+ * pixel stride 2), NV21 (U = V + 1, pixel stride 2) and I420 (pixel stride 1) as
+ * well as any padded row stride. Chroma planes are subsampled 2x2.
+ */
+struct YuvPlanes {
+    const uint8_t* y = nullptr;
+    const uint8_t* u = nullptr;
+    const uint8_t* v = nullptr;
+    uint32_t yRowStride = 0;
+    uint32_t uvRowStride = 0;
+    uint32_t uvPixelStride = 0;
+    uint32_t width = 0;
+    uint32_t height = 0;
+};
+
+/** Output size along one axis for a downscale factor (rounds down). */
+inline uint32_t downscaledExtent(uint32_t extent, uint32_t downscale) {
+    return downscale > 1 ? extent / downscale : extent;
+}
+
+/** Minimum plane sizes in bytes for `planes`, for validating caller-provided buffers. */
+size_t yuvLumaBytes(const YuvPlanes& planes);
+size_t yuvChromaBytes(const YuvPlanes& planes);
+
+/**
+ * Converts `planes` to RGBA8888 (BT.601 limited range, 6-bit fixed point, alpha 255)
+ * into `dst`, whose rows are `dstStride` bytes apart. `downscale` is 1, 2 or 4: luma
+ * is box-averaged over the factor and chroma over whatever the factor leaves of its
+ * 2x2 subsampling. Output is downscaledExtent(width|height, downscale) pixels.
+ * Returns false for unsupported factors, null planes, inconsistent strides, a frame
+ * smaller than the factor or a too-small `dstStride`.
+ */
+bool convertYuvToRgba(const YuvPlanes& planes, uint8_t* dst, size_t dstStride, uint32_t downscale);
+
+} // namespace lumina
+
+#endif // LUMINA_PIXEL_CONVERT_H
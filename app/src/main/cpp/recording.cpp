@@ -0,0 +1,34 @@
+#include "recording.h"
+
+#include <algorithm>
+
+namespace lumina {
+
+bool isValidRecordingConfig(const RecordingConfig& config) {
+    const auto validExtent = [](int32_t v) {
+        return v >= kMinRecordingExtent && v <= kMaxRecordingExtent && v % 2 == 0;
+    };
+    return validExtent(config.width) && validExtent(config.height) &&
+           config.frameRate >= 1 && config.frameRate <= 240 &&
+           config.bitRate >= 0 && config.keyFrameInterval >= 0;
+}
+
+int32_t defaultRecordingBitRate(int32_t width, int32_t height, int32_t frameRate) {
+    const int64_t bits = static_cast<int64_t>(width) * height * std::max(frameRate, 1) / 5;
+    return static_cast<int32_t>(std::clamp<int64_t>(bits, 500000, 100000000));
+}
+
+bool RecordingClock::next(int64_t frameTimeNs, int64_t* timestampNs) {
+    if (frameTimeNs <= last_) return false;
+    last_ = frameTimeNs;
+    if (timestampNs) *timestampNs = frameTimeNs;
+    return true;
+}
+
+float ExportProgress::fraction() const {
+    if (succeeded) return 1.0f;
+    if (durationUs <= 0) return 0.0f;
+    return std::clamp(static_cast<float>(positionUs) / static_cast<float>(durationUs), 0.0f, 1.0f);
+}
+
+} // namespace lumina
@@ -0,0 +1,67 @@
+#ifndef LUMINA_RECORDING_H
+#define LUMINA_RECORDING_H
+
+#include <cstdint>
+
+/**
+ * Lumina Virtual Studio - Recording parameters
+ *
+ * While a clip is recorded the renderers draw every frame into a second window, the
+ * input surface of a hardware encoder, as well as the preview: the encoder consumes
+ * the effected frames straight from GPU memory. This header holds the platform-free
+ * part of that path, shared by the engine and the native encoder (video_encoder.h).
+ */
+
+namespace lumina {
+
+struct RecordingConfig {
+    int32_t width = 0;
+    int32_t height = 0;
+    int32_t frameRate = 30;       // nominal rate the encoder plans its rate control for
+    int32_t bitRate = 0;          // bits per second; 0 picks defaultRecordingBitRate()
+    int32_t keyFrameInterval = 1; // seconds between sync frames
+};
+
+constexpr int32_t kMinRecordingExtent = 64;
+constexpr int32_t kMaxRecordingExtent = 4096;
+
+/** Even sizes within kMin/kMaxRecordingExtent, 1..240 fps and a non-negative bit rate. */
+bool isValidRecordingConfig(const RecordingConfig& config);
+
+/** About 0.2 bits per pixel per frame: roughly 12 Mbit/s for 1080p30. */
+int32_t defaultRecordingBitRate(int32_t width, int32_t height, int32_t frameRate);
+
+/**
+ * Turns render frame times into encoder timestamps. Encoders drop or reject frames
+ * whose timestamp does not increase, which a repeated vsync time or a clock switch
+ * would otherwise produce; such frames are skipped here instead.
+ */
+class RecordingClock {
+public:
+    /** True, with `timestampNs` set, if the frame should be encoded; false to skip it. */
+    bool next(int64_t frameTimeNs, int64_t* timestampNs);
+
+    void reset() { last_ = -1; }
+
+private:
+    int64_t last_ = -1;
+};
+
+/**
+ * Offline export (video_exporter.h): a decoded clip rendered through the effect chain
+ * into an encoder as fast as decoder, GPU and encoder allow, with no display pacing.
+ */
+struct ExportProgress {
+    int64_t framesRendered = 0;
+    int64_t positionUs = 0;      // media time of the last rendered frame
+    int64_t durationUs = 0;
+    bool running = false;
+    bool succeeded = false;      // finished every frame and, for files, the MP4 is usable
+
+    /** Share of the clip rendered, 0..1; 1 once it succeeded. */
+    float fraction() const;
+};
+
+} // namespace lumina
+
+#endif // LUMINA_RECORDING_H
@@ -0,0 +1,16 @@
+#include "redraw_tracker.h"
+
+#include <algorithm>
+
+namespace lumina {
+
+bool usesFrameTime(const LuminaState& state) {
+    if (state.renderMode == RenderMode::STYLIZED) return true;
+    const uint32_t count = std::min<uint32_t>(state.activeEffectCount, static_cast<uint32_t>(state.effects.size()));
+    for (uint32_t i = 0; i < count; ++i) {
+        if (state.effects[i].type == EffectType::NOISE && state.effects[i].intensity != 0.0f) return true;
+    }
+    return false;
+}
+
+} // namespace lumina
@@ -0,0 +1,51 @@
+#ifndef LUMINA_REDRAW_TRACKER_H
+#define LUMINA_REDRAW_TRACKER_H
+
+#include <cstdint>
+
+#include "engine_structs.h"
+
+/**
+ * Lumina Virtual Studio - Redraw tracking
+ *
+ * The render thread wakes on every paced vsync while a surface is attached, but a
+ * frame only needs drawing when something it shows has moved on: a new state
+ * (LuminaState::stateId), a new camera or video frame (an input sequence number the
+ * engine bumps per upload), or effects that animate with timing.totalTime. Otherwise
+ * the surface keeps the last presented image and the frame is skipped before anything
+ * is recorded, which is most of an editing session.
+ */
+
+namespace lumina {
+
+/** True when the image changes with timing.totalTime alone: NOISE grain, the stylized ripple. */
+bool usesFrameTime(const LuminaState& state);
+
+class RedrawTracker {
+public:
+    /** Whether a frame showing `stateId` over input `inputSeq` differs from the last one drawn. */
+    bool needsRedraw(uint32_t stateId, uint64_t inputSeq, bool animated) const {
+        return !valid_ || animated || stateId != stateId_ || inputSeq != inputSeq_;
+    }
+
+    /** The frame was drawn and presented. */
+    void presented(uint32_t stateId, uint64_t inputSeq) {
+        stateId_ = stateId;
+        inputSeq_ = inputSeq;
+        valid_ = true;
+    }
+
+    /** Forget the last frame, e.g. after a surface or renderer change; the next one is drawn. */
+    void invalidate() { valid_ = false; }
+
+    bool valid() const { return valid_; }
+
+private:
+    bool valid_ = false;
+    uint32_t stateId_ = 0;
+    uint64_t inputSeq_ = 0;
+};
+
+} // namespace lumina
+
+#endif // LUMINA_REDRAW_TRACKER_H
@@ -0,0 +1,76 @@
+#include "render_scale.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace lumina {
+
+namespace {
+
+constexpr float kSmoothing = 0.1f;
+// Stepping up needs the predicted load to clear the target by this margin, so the
+// scale does not flip between two neighbouring steps.
+constexpr float kRaiseMargin = 0.85f;
+// Headroom below this leaves the scale alone; at 1.0 it is held at minScale.
+constexpr float kThermalOnset = 0.7f;
+
+} // namespace
+
+bool RenderScaleController::update(float gpuMs, float budgetMs, float thermalHeadroom) {
+    if (!(budgetMs > 0.0f) || !(gpuMs >= 0.0f)) return false;
+    const float load = gpuMs / budgetMs;
+    load_ = samples_ == 0 ? load : load_ + (load - load_) * kSmoothing;
+    ++samples_;
+
+    const float cap = thermalCap(thermalHeadroom);
+    float next = scale_;
+    if (scale_ > cap) {
+        // Heat builds over minutes; shed load as soon as the forecast says so.
+        next = cap;
+    } else if (samples_ >= config_.settleFrames) {
+        if (load_ > config_.targetLoad) {
+            next = scale_ - config_.step;
+        } else {
+            // GPU cost follows the pixel count; the surface pass does not shrink, so
+            // this overestimates the raised load and errs towards staying put.
+            const float raised = std::min(scale_ + config_.step, cap);
+            const float predicted = load_ * (raised * raised) / (scale_ * scale_);
+            if (predicted < config_.targetLoad * kRaiseMargin) next = raised;
+        }
+    }
+
+    next = quantize(std::min(next, cap));
+    if (next == scale_) return false;
+    scale_ = next;
+    samples_ = 0;
+    return true;
+}
+
+void RenderScaleController::reset() {
+    scale_ = 1.0f;
+    load_ = 0.0f;
+    samples_ = 0;
+}
+
+float RenderScaleController::thermalCap(float headroom) const {
+    if (!(headroom > kThermalOnset)) return 1.0f;  // also unknown (negative or NaN)
+    const float t = std::min((headroom - kThermalOnset) / (1.0f - kThermalOnset), 1.0f);
+    return 1.0f - t * (1.0f - config_.minScale);
+}
+
+float RenderScaleController::quantize(float scale) const {
+    // Round down onto minScale + k * step so a thermal cap is never exceeded.
+    const float clamped = std::clamp(scale, config_.minScale, 1.0f);
+    if (config_.step <= 0.0f) return clamped;
+    const float steps = std::floor((clamped - config_.minScale) / config_.step + 1e-4f);
+    return std::min(config_.minScale + steps * config_.step, 1.0f);
+}
+
+uint32_t scaledExtent(uint32_t extent, float scale) {
+    if (scale >= 1.0f) return extent;
+    const float scaled = static_cast<float>(extent) * std::max(scale, 0.0f);
+    const uint32_t even = static_cast<uint32_t>(std::lround(scaled / 2.0f)) * 2u;
+    return std::clamp(even, std::min(2u, extent), extent);
+}
+
+} // namespace lumina
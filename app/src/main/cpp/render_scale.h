@@ -0,0 +1,55 @@
+#ifndef LUMINA_RENDER_SCALE_H
+#define LUMINA_RENDER_SCALE_H
+
+#include <cstdint>
+
+/**
+ * Lumina Virtual Studio - Adaptive render scale
+ *
+ * Multi-pass effect stacks render their intermediate passes at a fraction of the
+ * surface size; the pass that writes the surface samples them with linear filtering,
+ * so it doubles as the upscale. The controller picks that fraction from the measured
+ * GPU frame time against the frame budget, and caps it as the device's thermal
+ * headroom (AThermal_getThermalHeadroom) runs out, trading a little sharpness for a
+ * steady frame rate before the SoC starts throttling.
+ */
+
+namespace lumina {
+
+struct RenderScaleConfig {
+    float minScale = 0.5f;
+    float step = 0.125f;          // scales move on this grid so targets are rebuilt rarely
+    float targetLoad = 0.8f;      // share of the frame budget the GPU may use
+    uint32_t settleFrames = 30;   // samples at a scale before it may change again
+};
+
+class RenderScaleController {
+public:
+    explicit RenderScaleController(const RenderScaleConfig& config = {}) : config_(config) {}
+
+    /**
+     * One frame: its GPU time and the frame budget in milliseconds, and the thermal
+     * headroom (0 = cool, 1 = about to throttle; negative or NaN when unknown).
+     * Returns true when scale() changed.
+     */
+    bool update(float gpuMs, float budgetMs, float thermalHeadroom);
+
+    float scale() const { return scale_; }
+    void reset();
+
+private:
+    float thermalCap(float headroom) const;
+    float quantize(float scale) const;
+
+    RenderScaleConfig config_;
+    float scale_ = 1.0f;
+    float load_ = 0.0f;       // smoothed gpuMs / budgetMs at the current scale
+    uint32_t samples_ = 0;
+};
+
+/** `extent` scaled and rounded to an even size of at least 2; unchanged at scale 1. */
+uint32_t scaledExtent(uint32_t extent, float scale);
+
+} // namespace lumina
+
+#endif // LUMINA_RENDER_SCALE_H
@@ -0,0 +1,217 @@
+#include "render_thread.h"
+
+#include <android/log.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+#include <future>
+#include <memory>
+#include <utility>
+
+#define LOG_TAG "LuminaRenderThread"
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+constexpr int kWakeIdent = 1;
+constexpr int64_t kNanosPerSecond = 1000000000;
+
+void onRefreshRateChanged(int64_t vsyncPeriodNanos, void* data) {
+    static_cast<std::atomic<int64_t>*>(data)->store(vsyncPeriodNanos, std::memory_order_relaxed);
+}
+
+} // namespace
+
+RenderThread::~RenderThread() {
+    stop();
+}
+
+bool RenderThread::start(FrameCallback onFrame) {
+    if (isRunning()) return true;
+
+    wakeFd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (wakeFd_ < 0) {
+        LOGE("eventfd failed");
+        return false;
+    }
+
+    onFrame_ = std::move(onFrame);
+    quit_ = false;
+    callbackPending_ = false;
+    lastVsyncNanos_ = lastFrameNanos_ = 0;
+
+    std::promise<bool> ready;
+    std::future<bool> started = ready.get_future();
+    thread_ = std::thread([this, &ready] {
+        ALooper* looper = ALooper_prepare(0);
+        choreographer_ = AChoreographer_getInstance();
+        if (!looper || !choreographer_ ||
+            ALooper_addFd(looper, wakeFd_, kWakeIdent, ALOOPER_EVENT_INPUT, &RenderThread::onWakeEvent, this) != 1) {
+            ready.set_value(false);
+            return;
+        }
+        if (__builtin_available(android 30, *)) {
+            AChoreographer_registerRefreshRateCallback(choreographer_, onRefreshRateChanged, &vsyncPeriod_);
+            refreshCallbackRegistered_ = true;
+        }
+        threadId_ = std::this_thread::get_id();
+        running_ = true;
+        ready.set_value(true);
+        threadMain();
+        if (refreshCallbackRegistered_) {
+            if (__builtin_available(android 30, *)) {
+                AChoreographer_unregisterRefreshRateCallback(choreographer_, onRefreshRateChanged, &vsyncPeriod_);
+            }
+            refreshCallbackRegistered_ = false;
+        }
+        ALooper_removeFd(looper, wakeFd_);
+        choreographer_ = nullptr;
+    });
+
+    if (!started.get()) {
+        LOGE("Render thread failed to start (looper/choreographer unavailable)");
+        thread_.join();
+        close(wakeFd_);
+        wakeFd_ = -1;
+        return false;
+    }
+    LOGI("Render thread started");
+    return true;
+}
+
+void RenderThread::stop() {
+    if (!thread_.joinable()) return;
+    quit_ = true;
+    wake();
+    thread_.join();
+    running_ = false;
+    threadId_ = std::thread::id();
+    close(wakeFd_);
+    wakeFd_ = -1;
+    // Anything queued after the loop exited runs here, so runSync() callers never hang.
+    drainTasks();
+}
+
+void RenderThread::setContinuous(bool continuous) {
+    continuous_ = continuous;
+    wake();
+}
+
+void RenderThread::requestFrame() {
+    frameRequested_ = true;
+    wake();
+}
+
+void RenderThread::setTargetFrameRate(int fps) {
+    targetFps_ = fps > 0 ? fps : 0;
+}
+
+void RenderThread::runSync(const std::function<void()>& task) {
+    if (!isRunning() || isCurrentThread()) {
+        task();
+        return;
+    }
+    auto done = std::make_shared<std::promise<void>>();
+    std::future<void> finished = done->get_future();
+    {
+        std::lock_guard<std::mutex> lock(taskMutex_);
+        tasks_.emplace_back([&task, done] {
+            task();
+            done->set_value();
+        });
+    }
+    wake();
+    finished.wait();
+}
+
+void RenderThread::post(std::function<void()> task) {
+    if (!isRunning()) {
+        task();
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(taskMutex_);
+        tasks_.emplace_back(std::move(task));
+    }
+    wake();
+}
+
+void RenderThread::threadMain() {
+    while (!quit_.load(std::memory_order_acquire)) {
+        ALooper_pollOnce(-1, nullptr, nullptr, nullptr);
+    }
+    drainTasks();
+    running_ = false;
+}
+
+void RenderThread::wake() {
+    if (wakeFd_ < 0) return;
+    const uint64_t one = 1;
+    if (write(wakeFd_, &one, sizeof(one)) < 0) {
+        // EAGAIN means the counter is already non-zero, i.e. a wake-up is pending.
+    }
+}
+
+void RenderThread::drainTasks() {
+    std::vector<std::function<void()>> tasks;
+    {
+        std::lock_guard<std::mutex> lock(taskMutex_);
+        tasks.swap(tasks_);
+    }
+    for (auto& task : tasks) task();
+}
+
+void RenderThread::scheduleVsync() {
+    if (callbackPending_ || !choreographer_) return;
+    callbackPending_ = true;
+    AChoreographer_postFrameCallback64(choreographer_, &RenderThread::onFrameCallback, this);
+}
+
+int RenderThread::onWakeEvent(int fd, int /* events */, void* data) {
+    auto* self = static_cast<RenderThread*>(data);
+    uint64_t count = 0;
+    if (read(fd, &count, sizeof(count)) < 0) {
+        // Spurious wake-up; nothing to drain.
+    }
+    self->drainTasks();
+    if (!self->quit_ && (self->continuous_ || self->frameRequested_)) self->scheduleVsync();
+    return 1; // keep the fd registered
+}
+
+void RenderThread::onFrameCallback(int64_t frameTimeNanos, void* data) {
+    static_cast<RenderThread*>(data)->onVsync(frameTimeNanos);
+}
+
+void RenderThread::onVsync(int64_t frameTimeNanos) {
+    callbackPending_ = false;
+    if (quit_) return;
+
+    // Without the API 30 refresh-rate callback, estimate the period from back-to-back vsyncs.
+    int64_t period = vsyncPeriod_.load(std::memory_order_relaxed);
+    if (!refreshCallbackRegistered_ && lastVsyncNanos_ > 0) {
+        const int64_t delta = frameTimeNanos - lastVsyncNanos_;
+        if (delta > 0 && delta < period + period / 2) {
+            period = (period * 7 + delta) / 8;
+            vsyncPeriod_.store(period, std::memory_order_relaxed);
+        }
+    }
+    lastVsyncNanos_ = frameTimeNanos;
+
+    // Frames go out on the vsync nearest the target interval; half a period of slack
+    // keeps e.g. 30 fps on a 60 Hz panel from alternating between one and three vsyncs.
+    const int fps = targetFps_.load(std::memory_order_relaxed);
+    const int64_t interval = fps > 0 ? kNanosPerSecond / fps : period;
+    const bool due = lastFrameNanos_ == 0 || frameTimeNanos - lastFrameNanos_ >= interval - period / 2;
+    const bool wanted = continuous_ || frameRequested_;
+
+    if (wanted && due) {
+        frameRequested_ = false;
+        lastFrameNanos_ = frameTimeNanos;
+        // Hold the frame for its full slot so uneven GPU time does not show up as judder.
+        const int64_t slots = interval > period ? (interval + period / 2) / period : 1;
+        if (onFrame_) onFrame_(frameTimeNanos, frameTimeNanos + slots * period);
+    }
+
+    if (continuous_ || frameRequested_) scheduleVsync();
+}
@@ -0,0 +1,96 @@
+#ifndef LUMINA_RENDER_THREAD_H
+#define LUMINA_RENDER_THREAD_H
+
+#include <android/choreographer.h>
+#include <android/looper.h>
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Lumina Virtual Studio - Render thread
+ *
+ * Owns the thread that does all GPU submission. The thread runs an ALooper and is
+ * paced by AChoreographer vsync callbacks, so JNI callers and GC pauses on JVM
+ * threads never delay a frame. Work from other threads is handed over with
+ * runSync(); frames are produced while continuous mode is on, or once per
+ * requestFrame().
+ *
+ * With a target frame rate below the display rate, frames land on every Nth vsync
+ * and each frame reports the presentation time it should be held until, which the
+ * renderers forward to EGL_ANDROID_presentation_time / VK_GOOGLE_display_timing.
+ */
+
+class RenderThread {
+public:
+    // frameTimeNanos: vsync timestamp (CLOCK_MONOTONIC). presentTimeNanos: earliest
+    // time the frame should reach the display.
+    using FrameCallback = std::function<void(int64_t frameTimeNanos, int64_t presentTimeNanos)>;
+
+    RenderThread() = default;
+    ~RenderThread();
+
+    RenderThread(const RenderThread&) = delete;
+    RenderThread& operator=(const RenderThread&) = delete;
+
+    bool start(FrameCallback onFrame);
+    void stop();
+    bool isRunning() const { return running_.load(std::memory_order_acquire); }
+    bool isCurrentThread() const { return std::this_thread::get_id() == threadId_; }
+
+    // Produce a frame on every paced vsync while enabled (a surface is attached).
+    void setContinuous(bool continuous);
+    // Produce one frame at the next paced vsync.
+    void requestFrame();
+    // 0 follows the display; otherwise frames are spaced to the nearest vsync multiple.
+    void setTargetFrameRate(int fps);
+    int targetFrameRate() const { return targetFps_.load(std::memory_order_relaxed); }
+    int64_t vsyncPeriodNanos() const { return vsyncPeriod_.load(std::memory_order_relaxed); }
+
+    // Runs task on the render thread and waits for it. Runs inline when called from the
+    // render thread or when the thread is not running. Callers must not hold locks the
+    // task (or a frame) takes.
+    void runSync(const std::function<void()>& task);
+
+    // Queues task behind any pending ones and returns at once; runs inline when the
+    // thread is not running. Tasks run in order, so a later runSync() waits for it.
+    void post(std::function<void()> task);
+
+private:
+    void threadMain();
+    void wake();
+    void drainTasks();
+    void scheduleVsync();
+    void onVsync(int64_t frameTimeNanos);
+
+    static int onWakeEvent(int fd, int events, void* data);
+    static void onFrameCallback(int64_t frameTimeNanos, void* data);
+
+    FrameCallback onFrame_;
+    std::thread thread_;
+    std::thread::id threadId_;
+    int wakeFd_ = -1;
+
+    std::mutex taskMutex_;
+    std::vector<std::function<void()>> tasks_;
+
+    std::atomic<bool> running_{false};
+    std::atomic<bool> quit_{false};
+    std::atomic<bool> continuous_{false};
+    std::atomic<bool> frameRequested_{false};
+    std::atomic<int> targetFps_{0};
+    std::atomic<int64_t> vsyncPeriod_{16666667};
+
+    // Render thread only.
+    AChoreographer* choreographer_ = nullptr;
+    bool callbackPending_ = false;
+    bool refreshCallbackRegistered_ = false;
+    int64_t lastVsyncNanos_ = 0;
+    int64_t lastFrameNanos_ = 0;
+};
+
+#endif // LUMINA_RENDER_THREAD_H
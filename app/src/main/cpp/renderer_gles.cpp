@@ -1,8 +1,16 @@
 #include "renderer_gles.h"
 
+#include <android/hardware_buffer.h>
 #include <android/log.h>
 #include <GLES2/gl2ext.h>
 
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+#include "shader_cache.h"
+#include "trace.h"
+
 #define LOG_TAG "LuminaRenderer"
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
@@ -15,51 +23,195 @@ bool GLRenderer::initialize() {
     return true;
 }
 
+bool GLRenderer::warmUp(const std::vector<lumina::LuminaState>& states) {
+    LUMINA_TRACE_SCOPE("GL::warmUp");
+    if (!ensurePipeline()) return false;
+    for (const lumina::LuminaState& state : states) {
+        // Same programs render() picks: the camera feeds pass 0 and its pyramid's first stage.
+        const lumina::EffectGraph graph = lumina::buildEffectGraph(state);
+        for (uint32_t p = 0; p < graph.passCount; ++p) {
+            const lumina::EffectPass& pass = graph.passes[p];
+            const bool cameraInput = (p == 0);
+            if (pass.pyramidSlot != lumina::kNoPyramid) {
+                const bool bloom = state.effects[pass.pyramidSlot % lumina::kMaxEffects].type == lumina::EffectType::BLOOM;
+                if (!ensurePyramidProgram(bloom ? lumina::PyramidStage::Prefilter : lumina::PyramidStage::Down, cameraInput) ||
+                    !ensurePyramidProgram(lumina::PyramidStage::Down, false) ||
+                    !ensurePyramidProgram(lumina::PyramidStage::Up, false)) {
+                    return false;
+                }
+            }
+            if (!ensurePassProgram(pass, state, cameraInput, p + 1 == graph.passCount)) return false;
+        }
+    }
+    return true;
+}
+
 void GLRenderer::onSurfaceSize(int width, int height) {
+    // Only size-dependent state follows the surface: the viewport and resolution
+    // uniforms are set per frame and ensureTargets() reallocates the ping-pong targets.
+    // Programs, buffers and the camera texture live until onContextLost().
     surfaceWidth_ = width;
     surfaceHeight_ = height;
-    pipelineReady_ = false; // force pipeline rebuild after resize/context restore
 }
 
 bool GLRenderer::render(const lumina::LuminaState& state) {
     if (surfaceWidth_ <= 0 || surfaceHeight_ <= 0) return false;
-
-    glViewport(0, 0, surfaceWidth_, surfaceHeight_);
-    glDisable(GL_DEPTH_TEST);
-    glClearColor(0.05f, 0.05f, 0.08f, 1.0f);
-    glClear(GL_COLOR_BUFFER_BIT);
+    LUMINA_TRACE_SCOPE("GL::render");
 
     if (!ensurePipeline()) return false;
     if (!ensureExternalTexture()) return false;
 
-    glUseProgram(glProgram_);
-    const lumina::EffectParams* activeEffect = (state.activeEffectCount > 0) ? &state.effects[0] : nullptr;
-    float intensity = activeEffect ? activeEffect->intensity : 1.0f;
-    int effectType = activeEffect ? static_cast<int>(activeEffect->type) : 0;
+    const lumina::EffectGraph graph = lumina::buildEffectGraph(state);
+    if (graph.passCount > 1 && !ensureTargets()) return false;
 
-    if (uTimeLoc_ >= 0) glUniform1f(uTimeLoc_, state.timing.totalTime);
-    if (uIntensityLoc_ >= 0) glUniform1f(uIntensityLoc_, intensity);
-    if (uEffectTypeLoc_ >= 0) glUniform1i(uEffectTypeLoc_, effectType);
-    if (uTintLoc_ >= 0 && activeEffect) {
-        const auto& c = activeEffect->tintColor;
-        glUniform4f(uTintLoc_, c.r, c.g, c.b, c.a);
+    // This ring slot was issued kTimerLatency frames ago; read it back, then reuse it.
+    TimerFrame* timer = ensureTimerQueries() ? &timerFrames_[timerFrame_] : nullptr;
+    if (timer) {
+        collectTimerQueries(*timer);
+        timerFrame_ = (timerFrame_ + 1) % kTimerLatency;
     }
-    if (uCenterLoc_ >= 0 && activeEffect) glUniform2f(uCenterLoc_, activeEffect->center.x, activeEffect->center.y);
-    if (uScaleLoc_ >= 0 && activeEffect) glUniform2f(uScaleLoc_, activeEffect->scale.x, activeEffect->scale.y);
-    if (uParamsLoc_ >= 0 && activeEffect) glUniform2f(uParamsLoc_, activeEffect->param1, activeEffect->param2);
-    if (uResolutionLoc_ >= 0) glUniform2f(uResolutionLoc_, static_cast<float>(surfaceWidth_), static_cast<float>(surfaceHeight_));
-    if (uCameraTexLoc_ >= 0) glUniform1i(uCameraTexLoc_, 0);
 
-    glActiveTexture(GL_TEXTURE0);
-    glBindTexture(GL_TEXTURE_EXTERNAL_OES, externalTex_);
+    // The last pass goes to whatever framebuffer the caller bound (the window surface).
+    GLint surfaceFbo = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &surfaceFbo);
 
+    glDisable(GL_DEPTH_TEST);
     glBindVertexArray(glVao_);
-    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    glActiveTexture(GL_TEXTURE0);
+
+    // The analysis branch only reads the camera, so it goes first; the passes below
+    // set their own framebuffer and viewport.
+    ++frameNumber_;
+    if (analysisSink_) {
+        collectAnalysisReadbacks();
+        if (ensureAnalysisTarget()) renderAnalysis();
+    }
+
+    const lumina::EffectParams* firstEffect = (state.activeEffectCount > 0) ? &state.effects[0] : nullptr;
+    const float exposure = 0.8f + (firstEffect ? firstEffect->intensity : 1.0f) * 0.25f;
+
+    for (uint32_t p = 0; p < graph.passCount; ++p) {
+        const lumina::EffectPass& pass = graph.passes[p];
+        const bool cameraInput = (p == 0);
+        const bool lastPass = (p + 1 == graph.passCount);
+        // Intermediate passes run at the render scale; the surface pass upscales.
+        const GLsizei width = lastPass ? surfaceWidth_ : targetWidth_;
+        const GLsizei height = lastPass ? surfaceHeight_ : targetHeight_;
+
+        const PassProgram* prog = ensurePassProgram(pass, state, cameraInput, lastPass);
+        if (!prog) {
+            glBindVertexArray(0);
+            glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(surfaceFbo));
+            return false;
+        }
+
+        if (timer) glBeginQuery(GL_TIME_ELAPSED_EXT, timer->queries[p]);
+        // The pyramid draws into its own targets first; the pass then reads level 1.
+        float pyramidOffset = 0.0f;
+        if (pass.pyramidSlot != lumina::kNoPyramid) {
+            pyramidOffset = renderPyramid(pass, state, cameraInput ? GL_TEXTURE_EXTERNAL_OES : GL_TEXTURE_2D,
+                                          cameraInput ? inputTexture() : targets_[(p - 1) % 2].texture);
+        }
+        glBindFramebuffer(GL_FRAMEBUFFER, lastPass ? static_cast<GLuint>(surfaceFbo) : targets_[p % 2].fbo);
+        glViewport(0, 0, width, height);
+        if (lastPass) {
+            glClearColor(0.05f, 0.05f, 0.08f, 1.0f);
+            glClear(GL_COLOR_BUFFER_BIT);
+        }
+
+        // Gather the head and fused ops into pass-local uniform arrays.
+        GLfloat intensity[lumina::kMaxEffects] = {};
+        GLfloat tint[lumina::kMaxEffects * 4] = {};
+        GLfloat center[lumina::kMaxEffects * 2] = {};
+        GLfloat scale[lumina::kMaxEffects * 2] = {};
+        GLfloat params[lumina::kMaxEffects * 2] = {};
+        GLsizei count = 0;
+        auto gather = [&](const lumina::EffectParams& e) {
+            intensity[count] = e.intensity;
+            tint[count * 4 + 0] = e.tintColor.r;
+            tint[count * 4 + 1] = e.tintColor.g;
+            tint[count * 4 + 2] = e.tintColor.b;
+            tint[count * 4 + 3] = e.tintColor.a;
+            center[count * 2 + 0] = e.center.x;
+            center[count * 2 + 1] = e.center.y;
+            scale[count * 2 + 0] = e.scale.x;
+            scale[count * 2 + 1] = e.scale.y;
+            params[count * 2 + 0] = e.param1;
+            params[count * 2 + 1] = e.param2;
+            ++count;
+        };
+        if (pass.head != lumina::EffectType::NONE) gather(state.effects[pass.headSlot]);
+        for (uint8_t i = 0; i < pass.opCount; ++i) gather(state.effects[pass.ops[i]]);
+
+        glUseProgram(prog->program);
+        if (prog->uTimeLoc >= 0) glUniform1f(prog->uTimeLoc, state.timing.totalTime);
+        if (prog->uResolutionLoc >= 0) glUniform2f(prog->uResolutionLoc, static_cast<float>(width), static_cast<float>(height));
+        if (prog->uExposureLoc >= 0) glUniform1f(prog->uExposureLoc, exposure);
+        if (prog->uInputLoc >= 0) glUniform1i(prog->uInputLoc, 0);
+        if (prog->uPyramidOffsetLoc >= 0) glUniform1f(prog->uPyramidOffsetLoc, pyramidOffset);
+        if (prog->uPyramidLoc >= 0) {
+            glUniform1i(prog->uPyramidLoc, 1);
+            glActiveTexture(GL_TEXTURE1);
+            glBindTexture(GL_TEXTURE_2D, pyramidOffset > 0.0f ? pyramid_[0].texture : 0);
+            glActiveTexture(GL_TEXTURE0);
+        }
+        if (count > 0) {
+            if (prog->uIntensityLoc >= 0) glUniform1fv(prog->uIntensityLoc, count, intensity);
+            if (prog->uTintLoc >= 0) glUniform4fv(prog->uTintLoc, count, tint);
+            if (prog->uCenterLoc >= 0) glUniform2fv(prog->uCenterLoc, count, center);
+            if (prog->uScaleLoc >= 0) glUniform2fv(prog->uScaleLoc, count, scale);
+            if (prog->uParamsLoc >= 0) glUniform2fv(prog->uParamsLoc, count, params);
+        }
+
+        if (cameraInput) {
+            glBindTexture(GL_TEXTURE_EXTERNAL_OES, inputTexture());
+        } else {
+            glBindTexture(GL_TEXTURE_2D, targets_[(p - 1) % 2].texture);
+        }
+        glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        if (timer) glEndQuery(GL_TIME_ELAPSED_EXT);
+    }
+    if (timer) timer->passCount = graph.passCount;
+
+    glActiveTexture(GL_TEXTURE1);
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glActiveTexture(GL_TEXTURE0);
+    glBindTexture(GL_TEXTURE_2D, 0);
     glBindVertexArray(0);
 
+    // A slot still fenced means the GPU is kFrameFences frames behind; dropping that
+    // fence only delays completedFrames() to the next one.
+    FrameFence& frameFence = frameFences_[frameFenceNext_];
+    if (frameFence.fence) glDeleteSync(frameFence.fence);
+    frameFence.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    frameFence.frameNumber = frameNumber_;
+    frameFenceNext_ = (frameFenceNext_ + 1) % kFrameFences;
     return true;
 }
 
+uint64_t GLRenderer::completedFrames() {
+    for (size_t i = 0; i < kFrameFences; ++i) {
+        FrameFence& frameFence = frameFences_[(frameFenceNext_ + i) % kFrameFences];
+        if (!frameFence.fence) continue;
+        const GLenum status = glClientWaitSync(frameFence.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+        glDeleteSync(frameFence.fence);
+        frameFence.fence = nullptr;
+        // render() counts a frame before drawing it, so the fence covers frameNumber
+        // frames: indices 0 .. frameNumber - 1.
+        completedFrames_ = frameFence.frameNumber;
+    }
+    return completedFrames_;
+}
+
+void GLRenderer::destroyFrameFences() {
+    for (auto& frameFence : frameFences_) {
+        if (frameFence.fence) glDeleteSync(frameFence.fence);
+        frameFence = FrameFence{};
+    }
+    frameFenceNext_ = 0;
+}
+
 void GLRenderer::onContextLost() {
     destroyPipeline();
 }
@@ -73,11 +225,97 @@ GLuint GLRenderer::getInputTextureId() {
     return externalTex_;
 }
 
+bool GLRenderer::setInputHardwareBuffer(AHardwareBuffer* buffer) {
+    if (!buffer) {
+        activeInput_ = -1;
+        return true;
+    }
+    for (size_t i = 0; i < inputImages_.size(); ++i) {
+        if (inputImages_[i].buffer == buffer) {
+            activeInput_ = static_cast<int>(i);
+            inputImages_[i].lastUsed = frameNumber_;
+            return true;
+        }
+    }
+    if (!loadImageFunctions()) return false;
+
+    const EGLDisplay display = eglGetCurrentDisplay();
+    const EGLint attribs[] = {EGL_IMAGE_PRESERVED_KHR, EGL_TRUE, EGL_NONE};
+    const EGLImageKHR image = createImage_(display, EGL_NO_CONTEXT, EGL_NATIVE_BUFFER_ANDROID,
+                                           getNativeClientBuffer_(buffer), attribs);
+    if (image == EGL_NO_IMAGE_KHR) {
+        LOGE("eglCreateImageKHR failed for input buffer: 0x%x", eglGetError());
+        return false;
+    }
+    imageDisplay_ = display;
+
+    InputImage entry;
+    entry.buffer = buffer;
+    entry.image = image;
+    entry.lastUsed = frameNumber_;
+    glGenTextures(1, &entry.texture);
+    glBindTexture(GL_TEXTURE_EXTERNAL_OES, entry.texture);
+    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+    glTexParameteri(GL_TEXTURE_EXTERNAL_OES, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+    imageTargetTexture_(GL_TEXTURE_EXTERNAL_OES, static_cast<GLeglImageOES>(image));
+    glBindTexture(GL_TEXTURE_EXTERNAL_OES, 0);
+    AHardwareBuffer_acquire(buffer);
+
+    if (inputImages_.size() < kMaxInputImages) {
+        inputImages_.push_back(entry);
+        activeInput_ = static_cast<int>(inputImages_.size() - 1);
+        return true;
+    }
+    // Evict the least recently used; GL keeps the texture's storage alive for draws
+    // already submitted, so no sync is needed.
+    size_t victim = 0;
+    for (size_t i = 1; i < inputImages_.size(); ++i) {
+        if (inputImages_[i].lastUsed < inputImages_[victim].lastUsed) victim = i;
+    }
+    destroyInputImage(inputImages_[victim]);
+    inputImages_[victim] = entry;
+    activeInput_ = static_cast<int>(victim);
+    return true;
+}
+
+bool GLRenderer::loadImageFunctions() {
+    if (createImage_) return true;
+    getNativeClientBuffer_ = reinterpret_cast<PFNEGLGETNATIVECLIENTBUFFERANDROIDPROC>(
+        eglGetProcAddress("eglGetNativeClientBufferANDROID"));
+    createImage_ = reinterpret_cast<PFNEGLCREATEIMAGEKHRPROC>(eglGetProcAddress("eglCreateImageKHR"));
+    destroyImage_ = reinterpret_cast<PFNEGLDESTROYIMAGEKHRPROC>(eglGetProcAddress("eglDestroyImageKHR"));
+    imageTargetTexture_ = reinterpret_cast<PFNGLEGLIMAGETARGETTEXTURE2DOESPROC>(
+        eglGetProcAddress("glEGLImageTargetTexture2DOES"));
+    if (!getNativeClientBuffer_ || !createImage_ || !destroyImage_ || !imageTargetTexture_) {
+        LOGE("EGLImage import from hardware buffers is not available");
+        createImage_ = nullptr;
+        return false;
+    }
+    return true;
+}
+
+void GLRenderer::destroyInputImage(InputImage& entry) {
+    if (entry.texture) glDeleteTextures(1, &entry.texture);
+    if (entry.image != EGL_NO_IMAGE_KHR) destroyImage_(imageDisplay_, entry.image);
+    if (entry.buffer) AHardwareBuffer_release(entry.buffer);
+    entry = {};
+}
+
+void GLRenderer::destroyInputImages() {
+    for (InputImage& entry : inputImages_) destroyInputImage(entry);
+    inputImages_.clear();
+    activeInput_ = -1;
+}
+
+GLuint GLRenderer::inputTexture() const {
+    return activeInput_ >= 0 ? inputImages_[static_cast<size_t>(activeInput_)].texture : externalTex_;
+}
+
 bool GLRenderer::ensurePipeline() {
     if (pipelineReady_) return true;
 
-    destroyPipeline();
-
     const char* vsSrc = R"(#version 300 es
 layout(location = 0) in vec2 aPos;
 out vec2 vUv;
@@ -86,20 +324,45 @@ void main(){
     gl_Position = vec4(aPos, 0.0, 1.0);
 })";
 
-    const char* fsSrc = R"(#version 300 es
-#extension GL_OES_EGL_image_external_essl3 : require
-precision mediump float;
-in vec2 vUv;
+    // Shared by every pass program; fragment stages are composed per pass.
+    if (!compileShader(GL_VERTEX_SHADER, vsSrc, vertexShader_)) return false;
+    vertexSourceHash_ = lumina::fnv1a64(vsSrc, strlen(vsSrc));
+    loadProgramBinaries();
+
+    static const GLfloat quadVertices[] = {
+        -1.0f, -1.0f,
+         1.0f, -1.0f,
+        -1.0f,  1.0f,
+         1.0f,  1.0f,
+    };
+
+    glGenVertexArrays(1, &glVao_);
+    glGenBuffers(1, &glVbo_);
+    glBindVertexArray(glVao_);
+    glBindBuffer(GL_ARRAY_BUFFER, glVbo_);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
+    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (void*)0);
+    glEnableVertexAttribArray(0);
+    glBindVertexArray(0);
+
+    pipelineReady_ = true;
+    return true;
+}
+
+namespace {
+
+// Every pass program shares this body; buildPassSource() specializes it with #defines
+// so each variant only contains the head and ops it actually runs.
+const char* kPassFragmentBody = R"(in vec2 vUv;
 out vec4 fragColor;
 uniform float uTime;
-uniform float uIntensity;
-uniform int uEffectType;
-uniform vec4 uTintColor;
-uniform vec2 uEffectCenter;
-uniform vec2 uEffectScale;
-uniform vec2 uEffectParams;
 uniform vec2 uResolution;
-uniform samplerExternalOES uCameraTex;
+uniform float uExposure;
+uniform float uIntensity[4];
+uniform vec4 uTintColor[4];
+uniform vec2 uEffectCenter[4];
+uniform vec2 uEffectScale[4];
+uniform vec2 uEffectParams[4];
 
 float hash21(vec2 p){
     p = fract(p * vec2(234.34, 123.45));
@@ -107,108 +370,772 @@ float hash21(vec2 p){
     return fract(p.x * p.y);
 }
 
-void main(){
-    vec2 uv = vUv;
-    vec2 centered = (uv - uEffectCenter) * uEffectScale;
-    float aspect = uResolution.x / max(uResolution.y, 1.0);
-    centered.x *= aspect;
+vec2 effectSpace(vec2 uv, int i){
+    vec2 centered = (uv - uEffectCenter[i]) * uEffectScale[i];
+    centered.x *= uResolution.x / max(uResolution.y, 1.0);
+    return centered;
+}
+
+#if LUMINA_PYRAMID
+uniform sampler2D uPyramid;
+uniform float uPyramidOffset;
+
+// Last dual-filter upsample, from pyramid level 1 to this pass's size.
+vec3 pyramidUp(vec2 uv){
+    vec2 h = uPyramidOffset / vec2(textureSize(uPyramid, 0));
+    vec3 sum = texture(uPyramid, uv + vec2(-2.0 * h.x, 0.0)).rgb + texture(uPyramid, uv + vec2(2.0 * h.x, 0.0)).rgb +
+               texture(uPyramid, uv + vec2(0.0, -2.0 * h.y)).rgb + texture(uPyramid, uv + vec2(0.0, 2.0 * h.y)).rgb;
+    sum += 2.0 * (texture(uPyramid, uv + vec2(-h.x, h.y)).rgb + texture(uPyramid, uv + h).rgb +
+                  texture(uPyramid, uv + vec2(h.x, -h.y)).rgb + texture(uPyramid, uv - h).rgb);
+    return sum / 12.0;
+}
+#endif
+
+// Heads read the pass input; sampling heads read neighbouring texels.
+#if LUMINA_HEAD == 1
+// The pyramid holds the blur at the radius from param1 or the UI glass style.
+vec3 head(vec2 uv, int i){
+    vec3 original = texture(uInput, uv).rgb;
+    if (uPyramidOffset <= 0.0) return original;
+    return mix(original, pyramidUp(uv), clamp(uIntensity[i], 0.0, 1.0));
+}
+#elif LUMINA_HEAD == 5
+vec3 head(vec2 uv, int i){
+    float offset = 0.002 + 0.004 * uIntensity[i];
+    vec2 dir = normalize(uv - 0.5 + 0.0001) * offset;
+    return vec3(texture(uInput, uv - dir).r, texture(uInput, uv).g, texture(uInput, uv + dir).b);
+}
+#elif LUMINA_HEAD == 7
+vec3 head(vec2 uv, int i){
+    vec2 texel = 1.0 / uResolution;
+    vec3 original = texture(uInput, uv).rgb;
+    vec3 sum = original * 4.0;
+    sum -= texture(uInput, uv - texel).rgb;
+    sum -= texture(uInput, uv + vec2(-texel.x, texel.y)).rgb;
+    sum -= texture(uInput, uv + vec2(texel.x, -texel.y)).rgb;
+    sum -= texture(uInput, uv + texel).rgb;
+    return mix(original, original + sum, uIntensity[i]);
+}
+#else
+vec3 head(vec2 uv, int i){
+    return texture(uInput, uv).rgb;
+}
+#endif
+
+// Pointwise ops only depend on the current texel, so any number fuse into one pass.
+// Bloom adds the pass's pyramid of the input's highlights at the same texel.
+vec3 opBloom(vec3 color, vec2 uv, int i){
+#if LUMINA_PYRAMID
+    if (uPyramidOffset > 0.0) color += pyramidUp(uv) * uIntensity[i];
+#endif
+    return color;
+}
 
-    vec3 base = texture(uCameraTex, uv).rgb;
+vec3 opColorGrade(vec3 color, vec2 uv, int i){
+    color = mix(color, uTintColor[i].rgb, clamp(uIntensity[i], 0.0, 1.5));
+    return color * (1.0 + uEffectParams[i].x * 0.1);
+}
+
+vec3 opVignette(vec3 color, vec2 uv, int i){
+    float vig = smoothstep(0.8, 0.2, length(effectSpace(uv, i)));
+    return color * mix(1.0, vig, clamp(uIntensity[i], 0.0, 1.5));
+}
+
+vec3 opNoise(vec3 color, vec2 uv, int i){
+    float n = hash21(uv * uResolution + uTime * 0.5);
+    return color + (n - 0.5) * 0.18 * uIntensity[i];
+}
+
+vec3 opIdentity(vec3 color, vec2 uv, int i){
+    return color;
+}
+
+// Stylized look, applied once by the pass that writes the surface.
+vec3 stylize(vec3 base, vec2 uv){
     float ripple = 0.04 * sin(uTime * 1.5 + uv.x * 6.28318);
     base += ripple;
-
+    vec2 centered = uv - 0.5;
+    centered.x *= uResolution.x / max(uResolution.y, 1.0);
     float vignette = smoothstep(0.95, 0.45, length(centered));
-    base = mix(base * 0.9, base, vignette);
-
-    vec3 color = base;
-
-    if (uEffectType == 1) { // BLUR-ish soften (cheap)
-        float blurAmt = clamp(uIntensity, 0.0, 1.5) * 0.35;
-        color = mix(color, vec3(dot(color, vec3(0.333))), blurAmt);
-    } else if (uEffectType == 2) { // BLOOM halo
-        float halo = exp(-dot(centered, centered) * (4.0 + uEffectParams.x * 2.0));
-        color += halo * uIntensity * 0.6;
-    } else if (uEffectType == 3) { // COLOR_GRADE tint
-        color = mix(color, uTintColor.rgb, clamp(uIntensity, 0.0, 1.5));
-        color *= 1.0 + uEffectParams.x * 0.1;
-    } else if (uEffectType == 4) { // VIGNETTE
-        float vig = smoothstep(0.8, 0.2, length(centered));
-        color *= mix(1.0, vig, clamp(uIntensity, 0.0, 1.5));
-    } else if (uEffectType == 5) { // CHROMATIC_ABERRATION stylized
-        float offset = 0.002 + 0.004 * uIntensity;
-        vec2 dir = normalize(centered + 0.0001) * offset;
-        vec3 ca = vec3(
-            base.r + ripple,
-            base.g,
-            base.b - ripple
-        );
-        ca += vec3(hash21(uv + dir), hash21(uv - dir), hash21(uv + dir.yx)) * 0.02 * uIntensity;
-        color = mix(color, ca, 0.5);
-    } else if (uEffectType == 6) { // NOISE
-        float n = hash21(uv * uResolution + uTime * 0.5);
-        float grain = (n - 0.5) * 0.18 * uIntensity;
-        color += grain;
-    } else if (uEffectType == 7) { // SHARPEN/contrast
-        float c = dot(color, vec3(0.333));
-        color = mix(vec3(c), color * 1.2, clamp(0.5 + uIntensity * 0.5, 0.0, 1.5));
-    }
-
-    color *= (0.8 + uIntensity * 0.25);
+    return mix(base * 0.9, base, vignette) * uExposure;
+}
+
+void main(){
+    vec2 uv = vUv;
+    vec3 color = head(uv, 0);
+#if LUMINA_OP_COUNT > 0
+    color = LUMINA_OP0(color, uv, LUMINA_OP_BASE + 0);
+#endif
+#if LUMINA_OP_COUNT > 1
+    color = LUMINA_OP1(color, uv, LUMINA_OP_BASE + 1);
+#endif
+#if LUMINA_OP_COUNT > 2
+    color = LUMINA_OP2(color, uv, LUMINA_OP_BASE + 2);
+#endif
+#if LUMINA_OP_COUNT > 3
+    color = LUMINA_OP3(color, uv, LUMINA_OP_BASE + 3);
+#endif
+#if LUMINA_LAST_PASS && LUMINA_RENDER_MODE == 1
+    color = stylize(color, uv);
+#endif
     fragColor = vec4(color, 1.0);
-})";
+}
+)";
 
-    GLuint vs = 0, fs = 0;
-    if (!compileShader(GL_VERTEX_SHADER, vsSrc, vs)) return false;
-    if (!compileShader(GL_FRAGMENT_SHADER, fsSrc, fs)) { glDeleteShader(vs); return false; }
+// Draws the camera into a target analysisTargetWidth() texels wide, each RGBA8 texel
+// holding four consecutive bytes of the packed RGB or luma frame. Rows are flipped so
+// glReadPixels returns the top row first.
+const char* kAnalysisFragmentSource = R"(#version 300 es
+#extension GL_OES_EGL_image_external_essl3 : require
+precision highp float;
+uniform samplerExternalOES uInput;
+uniform vec2 uSize;   // analysis frame in pixels
+uniform int uGray;
+out vec4 fragColor;
 
-    glProgram_ = glCreateProgram();
-    glAttachShader(glProgram_, vs);
-    glAttachShader(glProgram_, fs);
-    glLinkProgram(glProgram_);
+// Four bilinear taps approximate a box filter over the pixel's source footprint.
+vec3 fetchPixel(float x, float row){
+    vec2 uv = vec2(x + 0.5, uSize.y - row - 0.5) / uSize;
+    vec2 q = 0.25 / uSize;
+    return 0.25 * (texture(uInput, uv + vec2(-q.x, -q.y)).rgb + texture(uInput, uv + vec2(q.x, -q.y)).rgb +
+                   texture(uInput, uv + vec2(-q.x, q.y)).rgb + texture(uInput, uv + vec2(q.x, q.y)).rgb);
+}
+
+float luma(vec3 c){
+    return dot(c, vec3(0.299, 0.587, 0.114));
+}
+
+void main(){
+    float texel = floor(gl_FragCoord.x);
+    float row = floor(gl_FragCoord.y);
+    if (uGray != 0) {
+        float x = texel * 4.0;
+        fragColor = vec4(luma(fetchPixel(x, row)), luma(fetchPixel(x + 1.0, row)),
+                         luma(fetchPixel(x + 2.0, row)), luma(fetchPixel(x + 3.0, row)));
+        return;
+    }
+    // Bytes 4t..4t+3 start (4t mod 3) = (t mod 3) bytes into pixel floor(4t / 3).
+    vec3 a = fetchPixel(floor(texel * 4.0 / 3.0), row);
+    vec3 b = fetchPixel(floor(texel * 4.0 / 3.0) + 1.0, row);
+    int phase = int(texel) % 3;
+    if (phase == 0) fragColor = vec4(a, b.r);
+    else if (phase == 1) fragColor = vec4(a.gb, b.rg);
+    else fragColor = vec4(a.b, b);
+}
+)";
+
+// Dual-filter pyramid stages (blur_pyramid.h): uTexel is the texel size of the level
+// read and uOffset the plan's tap spread. The bloom prefilter keeps only what exceeds
+// uThreshold, scaled so colours keep their hue.
+const char* kPyramidFragmentBody = R"(in vec2 vUv;
+out vec4 fragColor;
+uniform vec2 uTexel;
+uniform float uOffset;
+uniform float uThreshold;
+
+vec3 fetch(vec2 uv){
+    vec3 c = texture(uInput, uv).rgb;
+#if LUMINA_PYRAMID_STAGE == 1
+    float peak = max(c.r, max(c.g, c.b));
+    c *= max(peak - uThreshold, 0.0) / max(peak, 1e-4);
+#endif
+    return c;
+}
+
+void main(){
+    vec2 h = uTexel * uOffset;
+#if LUMINA_PYRAMID_STAGE == 2
+    vec3 sum = fetch(vUv + vec2(-2.0 * h.x, 0.0)) + fetch(vUv + vec2(2.0 * h.x, 0.0)) +
+               fetch(vUv + vec2(0.0, -2.0 * h.y)) + fetch(vUv + vec2(0.0, 2.0 * h.y));
+    sum += 2.0 * (fetch(vUv + vec2(-h.x, h.y)) + fetch(vUv + h) + fetch(vUv + vec2(h.x, -h.y)) + fetch(vUv - h));
+    fragColor = vec4(sum / 12.0, 1.0);
+#else
+    vec3 sum = fetch(vUv) * 4.0;
+    sum += fetch(vUv - h) + fetch(vUv + h) + fetch(vUv + vec2(h.x, -h.y)) + fetch(vUv + vec2(-h.x, h.y));
+    fragColor = vec4(sum / 8.0, 1.0);
+#endif
+}
+)";
 
+// Glass panel backdrop: the last 8-tap upsample of the pyramid built from the finished
+// frame, toned by the UI style and masked to the panel's rounded rectangle. uRect and
+// uRadius are in surface pixels with the origin top-left; uInput is pyramid level 1.
+const char* kGlassFragmentSource = R"(#version 300 es
+precision highp float;
+in vec2 vUv;
+out vec4 fragColor;
+uniform sampler2D uInput;
+uniform vec2 uTexel;
+uniform float uOffset;
+uniform vec4 uRect;
+uniform float uRadius;
+uniform vec2 uResolution;
+uniform float uSaturation;
+uniform float uBrightness;
+
+vec3 fetch(vec2 uv){
+    return texture(uInput, uv).rgb;
+}
+
+void main(){
+    vec2 h = uTexel * uOffset;
+    vec3 c = fetch(vUv + vec2(-2.0 * h.x, 0.0)) + fetch(vUv + vec2(2.0 * h.x, 0.0)) +
+             fetch(vUv + vec2(0.0, -2.0 * h.y)) + fetch(vUv + vec2(0.0, 2.0 * h.y));
+    c += 2.0 * (fetch(vUv + vec2(-h.x, h.y)) + fetch(vUv + h) + fetch(vUv + vec2(h.x, -h.y)) + fetch(vUv - h));
+    c /= 12.0;
+    float luma = dot(c, vec3(0.299, 0.587, 0.114));
+    c = mix(vec3(luma), c, uSaturation) * uBrightness;
+
+    // Signed distance to the rounded rectangle, antialiased over one pixel.
+    vec2 p = vec2(vUv.x, 1.0 - vUv.y) * uResolution;
+    vec2 q = abs(p - 0.5 * (uRect.xy + uRect.zw)) - 0.5 * (uRect.zw - uRect.xy) + uRadius;
+    float d = length(max(q, 0.0)) + min(max(q.x, q.y), 0.0) - uRadius;
+    fragColor = vec4(c, clamp(0.5 - d, 0.0, 1.0));
+}
+)";
+
+const char* opFunction(lumina::EffectType type) {
+    switch (type) {
+        case lumina::EffectType::BLOOM: return "opBloom";
+        case lumina::EffectType::COLOR_GRADE: return "opColorGrade";
+        case lumina::EffectType::VIGNETTE: return "opVignette";
+        case lumina::EffectType::NOISE: return "opNoise";
+        default: return "opIdentity";
+    }
+}
+}
+
+std::string GLRenderer::buildPassSource(const lumina::EffectPass& pass, const lumina::LuminaState& state,
+                                        bool cameraInput, bool lastPass) {
+    std::string src = "#version 300 es\n";
+    if (cameraInput) {
+        src += "#extension GL_OES_EGL_image_external_essl3 : require\n";
+    }
+    src += "#define LUMINA_HEAD " + std::to_string(static_cast<uint32_t>(pass.head)) + "\n";
+    src += "#define LUMINA_OP_BASE " + std::string(pass.head != lumina::EffectType::NONE ? "1" : "0") + "\n";
+    src += "#define LUMINA_OP_COUNT " + std::to_string(pass.opCount) + "\n";
+    for (uint8_t i = 0; i < pass.opCount; ++i) {
+        src += "#define LUMINA_OP" + std::to_string(i) + " " + opFunction(state.effects[pass.ops[i]].type) + "\n";
+    }
+    src += "#define LUMINA_RENDER_MODE " + std::to_string(static_cast<uint32_t>(state.renderMode)) + "\n";
+    src += std::string("#define LUMINA_LAST_PASS ") + (lastPass ? "1" : "0") + "\n";
+    src += std::string("#define LUMINA_PYRAMID ") + (pass.pyramidSlot != lumina::kNoPyramid ? "1" : "0") + "\n";
+    src += "precision mediump float;\n";
+    src += cameraInput ? "uniform samplerExternalOES uInput;\n" : "uniform sampler2D uInput;\n";
+    src += kPassFragmentBody;
+    return src;
+}
+
+const GLRenderer::PassProgram* GLRenderer::ensurePassProgram(const lumina::EffectPass& pass,
+                                                             const lumina::LuminaState& state,
+                                                             bool cameraInput, bool lastPass) {
+    // Intermediate passes write RGBA8 targets; 0 stands for the window surface.
+    const uint32_t flags = (lastPass ? lumina::kVariantLastPass : 0u) |
+                           (cameraInput ? lumina::kVariantExternalInput : 0u);
+    const uint64_t key = lumina::effectVariantKey(pass, state.effects, state.renderMode, flags,
+                                                  lastPass ? 0u : static_cast<uint32_t>(GL_RGBA8));
+    auto it = programs_.find(key);
+    if (it != programs_.end()) return &it->second;
+
+    const std::string fsSrc = buildPassSource(pass, state, cameraInput, lastPass);
+    PassProgram prog;
+    prog.program = linkProgram(fsSrc);
+    if (prog.program == 0) return nullptr;
+
+    prog.uTimeLoc = glGetUniformLocation(prog.program, "uTime");
+    prog.uResolutionLoc = glGetUniformLocation(prog.program, "uResolution");
+    prog.uExposureLoc = glGetUniformLocation(prog.program, "uExposure");
+    prog.uInputLoc = glGetUniformLocation(prog.program, "uInput");
+    prog.uIntensityLoc = glGetUniformLocation(prog.program, "uIntensity");
+    prog.uTintLoc = glGetUniformLocation(prog.program, "uTintColor");
+    prog.uCenterLoc = glGetUniformLocation(prog.program, "uEffectCenter");
+    prog.uScaleLoc = glGetUniformLocation(prog.program, "uEffectScale");
+    prog.uParamsLoc = glGetUniformLocation(prog.program, "uEffectParams");
+    prog.uPyramidLoc = glGetUniformLocation(prog.program, "uPyramid");
+    prog.uPyramidOffsetLoc = glGetUniformLocation(prog.program, "uPyramidOffset");
+
+    return &programs_.emplace(key, prog).first->second;
+}
+
+const GLRenderer::PassProgram* GLRenderer::ensurePyramidProgram(lumina::PyramidStage stage, bool cameraInput) {
+    const uint64_t key = lumina::pyramidVariantKey(stage, cameraInput ? lumina::kVariantExternalInput : 0u,
+                                                   static_cast<uint32_t>(GL_RGBA8));
+    auto it = programs_.find(key);
+    if (it != programs_.end()) return &it->second;
+
+    std::string src = "#version 300 es\n";
+    if (cameraInput) src += "#extension GL_OES_EGL_image_external_essl3 : require\n";
+    src += "#define LUMINA_PYRAMID_STAGE " + std::to_string(static_cast<uint32_t>(stage)) + "\n";
+    src += "precision mediump float;\n";
+    src += cameraInput ? "uniform samplerExternalOES uInput;\n" : "uniform sampler2D uInput;\n";
+    src += kPyramidFragmentBody;
+
+    PassProgram prog;
+    prog.program = linkProgram(src);
+    if (prog.program == 0) return nullptr;
+    prog.uInputLoc = glGetUniformLocation(prog.program, "uInput");
+    prog.uTexelLoc = glGetUniformLocation(prog.program, "uTexel");
+    prog.uOffsetLoc = glGetUniformLocation(prog.program, "uOffset");
+    prog.uThresholdLoc = glGetUniformLocation(prog.program, "uThreshold");
+    return &programs_.emplace(key, prog).first->second;
+}
+
+float GLRenderer::renderPyramid(const lumina::EffectPass& pass, const lumina::LuminaState& state,
+                                GLenum inputTarget, GLuint input) {
+    LUMINA_TRACE_SCOPE("GL::blurPyramid");
+    const lumina::EffectParams& effect = state.effects[pass.pyramidSlot % lumina::kMaxEffects];
+
+    // Radii are in surface pixels; the pyramid halves from the render scale's size.
+    const int width = static_cast<int>(lumina::scaledExtent(static_cast<uint32_t>(surfaceWidth_), renderScale_));
+    const int height = static_cast<int>(lumina::scaledExtent(static_cast<uint32_t>(surfaceHeight_), renderScale_));
+    const float radius = lumina::effectBlurRadius(effect, state.uiStyle) * static_cast<float>(width) /
+                         static_cast<float>(surfaceWidth_);
+    const lumina::BlurPlan plan = lumina::planBlur(radius, static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+    if (plan.levels == 0 || !ensurePyramid(width, height)) return 0.0f;
+    const uint32_t levels = std::min(plan.levels, pyramidLevels_);
+    const bool bloom = effect.type == lumina::EffectType::BLOOM;
+    const float threshold = lumina::bloomThreshold(effect);
+
+    // Down to the smallest level, then back up to level 1, which the pass upsamples.
+    const bool external = inputTarget == GL_TEXTURE_EXTERNAL_OES;
+    for (uint32_t k = 0; k < levels; ++k) {
+        const bool first = k == 0;
+        const lumina::PyramidStage stage = first && bloom ? lumina::PyramidStage::Prefilter : lumina::PyramidStage::Down;
+        if (!drawPyramidStage(stage, first && external, plan, k, first ? inputTarget : GL_TEXTURE_2D,
+                              first ? input : pyramid_[k - 1].texture,
+                              first ? static_cast<uint32_t>(width) : plan.widths[k - 1],
+                              first ? static_cast<uint32_t>(height) : plan.heights[k - 1], threshold)) {
+            return 0.0f;
+        }
+    }
+    for (uint32_t k = levels - 1; k > 0; --k) {
+        if (!drawPyramidStage(lumina::PyramidStage::Up, false, plan, k - 1, GL_TEXTURE_2D, pyramid_[k].texture,
+                              plan.widths[k], plan.heights[k], threshold)) {
+            return 0.0f;
+        }
+    }
+    return plan.offset;
+}
+
+bool GLRenderer::drawPyramidStage(lumina::PyramidStage stage, bool external, const lumina::BlurPlan& plan,
+                                  uint32_t dst, GLenum srcTarget, GLuint src, uint32_t srcWidth,
+                                  uint32_t srcHeight, float threshold) {
+    const PassProgram* prog = ensurePyramidProgram(stage, external);
+    if (!prog) return false;
+    glBindFramebuffer(GL_FRAMEBUFFER, pyramid_[dst].fbo);
+    glViewport(0, 0, static_cast<GLsizei>(plan.widths[dst]), static_cast<GLsizei>(plan.heights[dst]));
+    glUseProgram(prog->program);
+    if (prog->uInputLoc >= 0) glUniform1i(prog->uInputLoc, 0);
+    if (prog->uTexelLoc >= 0) glUniform2f(prog->uTexelLoc, 1.0f / srcWidth, 1.0f / srcHeight);
+    if (prog->uOffsetLoc >= 0) glUniform1f(prog->uOffsetLoc, plan.offset);
+    if (prog->uThresholdLoc >= 0) glUniform1f(prog->uThresholdLoc, threshold);
+    glBindTexture(srcTarget, src);
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+    return true;
+}
+
+void GLRenderer::renderGlass(const lumina::GlassmorphicParams& style) {
+    if (glassLayout_.count == 0 || !pipelineReady_ || surfaceWidth_ <= 0 || surfaceHeight_ <= 0) return;
+    LUMINA_TRACE_SCOPE("GL::glass");
+
+    // Same sizing as an effect pass's pyramid, so both share its levels.
+    const int width = static_cast<int>(lumina::scaledExtent(static_cast<uint32_t>(surfaceWidth_), renderScale_));
+    const int height = static_cast<int>(lumina::scaledExtent(static_cast<uint32_t>(surfaceHeight_), renderScale_));
+    const lumina::BlurPlan plan = lumina::planBlur(
+        style.blurRadius * static_cast<float>(width) / static_cast<float>(surfaceWidth_),
+        static_cast<uint32_t>(width), static_cast<uint32_t>(height));
+    if (plan.levels == 0 || !ensurePyramid(width, height) || !ensureGlassProgram()) return;
+    const uint32_t levels = std::min(plan.levels, pyramidLevels_);
+
+    GLint surfaceFbo = 0;
+    glGetIntegerv(GL_FRAMEBUFFER_BINDING, &surfaceFbo);
+
+    // The surface is no texture, so a filtered blit into level 1 stands in for the first
+    // downsample; the rest of the pyramid runs as for BLUR.
+    glBindFramebuffer(GL_READ_FRAMEBUFFER, static_cast<GLuint>(surfaceFbo));
+    glBindFramebuffer(GL_DRAW_FRAMEBUFFER, pyramid_[0].fbo);
+    glBlitFramebuffer(0, 0, surfaceWidth_, surfaceHeight_, 0, 0, static_cast<GLint>(plan.widths[0]),
+                      static_cast<GLint>(plan.heights[0]), GL_COLOR_BUFFER_BIT, GL_LINEAR);
+
+    glBindVertexArray(glVao_);
+    glActiveTexture(GL_TEXTURE0);
+    bool built = true;
+    for (uint32_t k = 1; k < levels && built; ++k) {
+        built = drawPyramidStage(lumina::PyramidStage::Down, false, plan, k, GL_TEXTURE_2D, pyramid_[k - 1].texture,
+                                 plan.widths[k - 1], plan.heights[k - 1], 0.0f);
+    }
+    for (uint32_t k = levels - 1; k > 0 && built; --k) {
+        built = drawPyramidStage(lumina::PyramidStage::Up, false, plan, k - 1, GL_TEXTURE_2D, pyramid_[k].texture,
+                                 plan.widths[k], plan.heights[k], 0.0f);
+    }
+
+    glBindFramebuffer(GL_FRAMEBUFFER, static_cast<GLuint>(surfaceFbo));
+    if (built) {
+        const uint32_t sw = static_cast<uint32_t>(surfaceWidth_);
+        const uint32_t sh = static_cast<uint32_t>(surfaceHeight_);
+        glViewport(0, 0, surfaceWidth_, surfaceHeight_);
+        glUseProgram(glassProgram_);
+        glUniform1i(glassInputLoc_, 0);
+        glUniform2f(glassTexelLoc_, 1.0f / plan.widths[0], 1.0f / plan.heights[0]);
+        glUniform1f(glassOffsetLoc_, plan.offset);
+        glUniform2f(glassResolutionLoc_, static_cast<float>(sw), static_cast<float>(sh));
+        glUniform1f(glassSaturationLoc_, style.saturation);
+        glUniform1f(glassBrightnessLoc_, style.brightness);
+        glBindTexture(GL_TEXTURE_2D, pyramid_[0].texture);
+
+        // Only the panels' pixels run the shader; the surface keeps its alpha.
+        glEnable(GL_SCISSOR_TEST);
+        glEnable(GL_BLEND);
+        glBlendFuncSeparate(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA, GL_ZERO, GL_ONE);
+        for (uint32_t i = 0; i < glassLayout_.count; ++i) {
+            const lumina::GlassPanel& panel = glassLayout_.panels[i];
+            const lumina::PixelRect rect = lumina::glassScissor(panel, 0, sw, sh);
+            if (rect.width == 0 || rect.height == 0) continue;
+            // GL scissors count rows from the bottom.
+            glScissor(rect.x, static_cast<GLint>(sh - rect.y - rect.height),
+                      static_cast<GLsizei>(rect.width), static_cast<GLsizei>(rect.height));
+            glUniform4f(glassRectLoc_, panel.left * sw, panel.top * sh, panel.right * sw, panel.bottom * sh);
+            glUniform1f(glassRadiusLoc_, lumina::glassCornerRadius(panel, sw, sh));
+            glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+        }
+        glDisable(GL_BLEND);
+        glDisable(GL_SCISSOR_TEST);
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    glBindVertexArray(0);
+}
+
+bool GLRenderer::ensureGlassProgram() {
+    if (glassProgram_ != 0) return true;
+    glassProgram_ = linkProgram(kGlassFragmentSource);
+    if (glassProgram_ == 0) {
+        LOGE("Glass program failed to link; glass panels stay unblurred");
+        glassLayout_ = lumina::GlassLayout{};
+        return false;
+    }
+    glassInputLoc_ = glGetUniformLocation(glassProgram_, "uInput");
+    glassTexelLoc_ = glGetUniformLocation(glassProgram_, "uTexel");
+    glassOffsetLoc_ = glGetUniformLocation(glassProgram_, "uOffset");
+    glassRectLoc_ = glGetUniformLocation(glassProgram_, "uRect");
+    glassRadiusLoc_ = glGetUniformLocation(glassProgram_, "uRadius");
+    glassResolutionLoc_ = glGetUniformLocation(glassProgram_, "uResolution");
+    glassSaturationLoc_ = glGetUniformLocation(glassProgram_, "uSaturation");
+    glassBrightnessLoc_ = glGetUniformLocation(glassProgram_, "uBrightness");
+    return true;
+}
+
+GLuint GLRenderer::linkProgram(const std::string& fsSrc) {
+    // Binaries are keyed by the exact shader sources, so edited shaders never hit stale entries.
+    const uint64_t sourceHash = lumina::fnv1a64(fsSrc.data(), fsSrc.size(), vertexSourceHash_);
     GLint linked = GL_FALSE;
-    glGetProgramiv(glProgram_, GL_LINK_STATUS, &linked);
-    glDeleteShader(vs);
+
+    auto cached = binaries_.find(sourceHash);
+    if (cached != binaries_.end()) {
+        GLuint program = glCreateProgram();
+        glProgramBinary(program, cached->second.format, cached->second.data.data(),
+                        static_cast<GLsizei>(cached->second.data.size()));
+        glGetProgramiv(program, GL_LINK_STATUS, &linked);
+        if (linked == GL_TRUE) return program;
+        // The driver may reject binaries after an update; fall back to source.
+        glDeleteProgram(program);
+        binaries_.erase(cached);
+        binariesDirty_ = true;
+    }
+
+    GLuint fs = 0;
+    if (!compileShader(GL_FRAGMENT_SHADER, fsSrc.c_str(), fs)) return 0;
+
+    GLuint program = glCreateProgram();
+    if (binarySupported_) glProgramParameteri(program, GL_PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+    glAttachShader(program, vertexShader_);
+    glAttachShader(program, fs);
+    glLinkProgram(program);
+
+    glGetProgramiv(program, GL_LINK_STATUS, &linked);
+    glDetachShader(program, vertexShader_);
     glDeleteShader(fs);
     if (linked != GL_TRUE) {
         char logBuf[512];
-        glGetProgramInfoLog(glProgram_, sizeof(logBuf), nullptr, logBuf);
+        glGetProgramInfoLog(program, sizeof(logBuf), nullptr, logBuf);
         LOGE("Program link failed: %s", logBuf);
-        glDeleteProgram(glProgram_);
-        glProgram_ = 0;
-        return false;
+        glDeleteProgram(program);
+        return 0;
     }
 
-    static const GLfloat quadVertices[] = {
-        -1.0f, -1.0f,
-         1.0f, -1.0f,
-        -1.0f,  1.0f,
-         1.0f,  1.0f,
+    if (binarySupported_) {
+        GLint length = 0;
+        glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &length);
+        if (length > 0) {
+            ProgramBinary binary;
+            binary.data.resize(static_cast<size_t>(length));
+            glGetProgramBinary(program, length, nullptr, &binary.format, binary.data.data());
+            binaries_[sourceHash] = std::move(binary);
+            binariesDirty_ = true;
+        }
+    }
+    return program;
+}
+
+void GLRenderer::loadProgramBinaries() {
+    GLint formats = 0;
+    glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formats);
+    binarySupported_ = formats > 0;
+    if (!binarySupported_) return;
+
+    // A binary is only valid for the driver build that produced it.
+    auto glString = [](GLenum name) {
+        const GLubyte* value = glGetString(name);
+        return value ? std::string(reinterpret_cast<const char*>(value)) : std::string();
     };
+    const std::string driverId = "gl:" + glString(GL_VENDOR) + "|" + glString(GL_RENDERER) + "|" + glString(GL_VERSION);
+    if (driverId == driverId_) return; // already loaded for this driver
+    driverId_ = driverId;
+    binaries_.clear();
+    binariesDirty_ = false;
+    if (cacheDir_.empty()) return;
 
-    glGenVertexArrays(1, &glVao_);
-    glGenBuffers(1, &glVbo_);
-    glBindVertexArray(glVao_);
-    glBindBuffer(GL_ARRAY_BUFFER, glVbo_);
-    glBufferData(GL_ARRAY_BUFFER, sizeof(quadVertices), quadVertices, GL_STATIC_DRAW);
-    glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 2 * sizeof(GLfloat), (void*)0);
-    glEnableVertexAttribArray(0);
-    glBindVertexArray(0);
+    // Payload: repeated { u64 source hash, u32 format, u32 size, size bytes }.
+    std::vector<uint8_t> payload;
+    if (!lumina::readCacheFile(cacheDir_ + "/gl_programs.bin", driverId_, payload)) return;
+    size_t offset = 0;
+    while (offset + 16 <= payload.size()) {
+        uint64_t hash = 0;
+        uint32_t format = 0;
+        uint32_t size = 0;
+        memcpy(&hash, payload.data() + offset, 8);
+        memcpy(&format, payload.data() + offset + 8, 4);
+        memcpy(&size, payload.data() + offset + 12, 4);
+        offset += 16;
+        if (size > payload.size() - offset) break;
+        ProgramBinary& binary = binaries_[hash];
+        binary.format = format;
+        binary.data.assign(payload.begin() + offset, payload.begin() + offset + size);
+        offset += size;
+    }
+}
 
-    uTimeLoc_ = glGetUniformLocation(glProgram_, "uTime");
-    uIntensityLoc_ = glGetUniformLocation(glProgram_, "uIntensity");
-    uEffectTypeLoc_ = glGetUniformLocation(glProgram_, "uEffectType");
-    uTintLoc_ = glGetUniformLocation(glProgram_, "uTintColor");
-    uCenterLoc_ = glGetUniformLocation(glProgram_, "uEffectCenter");
-    uScaleLoc_ = glGetUniformLocation(glProgram_, "uEffectScale");
-    uParamsLoc_ = glGetUniformLocation(glProgram_, "uEffectParams");
-    uResolutionLoc_ = glGetUniformLocation(glProgram_, "uResolution");
-    uCameraTexLoc_ = glGetUniformLocation(glProgram_, "uCameraTex");
+void GLRenderer::saveProgramBinaries() {
+    if (!binariesDirty_ || cacheDir_.empty() || driverId_.empty()) return;
 
-    pipelineReady_ = true;
+    std::vector<uint8_t> payload;
+    for (const auto& entry : binaries_) {
+        const uint32_t format = entry.second.format;
+        const uint32_t size = static_cast<uint32_t>(entry.second.data.size());
+        const size_t offset = payload.size();
+        payload.resize(offset + 16 + size);
+        memcpy(payload.data() + offset, &entry.first, 8);
+        memcpy(payload.data() + offset + 8, &format, 4);
+        memcpy(payload.data() + offset + 12, &size, 4);
+        memcpy(payload.data() + offset + 16, entry.second.data.data(), size);
+    }
+    if (lumina::writeCacheFile(cacheDir_ + "/gl_programs.bin", driverId_, payload.data(), payload.size())) {
+        binariesDirty_ = false;
+    } else {
+        LOGE("Failed to write program binaries to %s", cacheDir_.c_str());
+    }
+}
+
+bool GLRenderer::ensureTargets() {
+    const int width = static_cast<int>(lumina::scaledExtent(static_cast<uint32_t>(surfaceWidth_), renderScale_));
+    const int height = static_cast<int>(lumina::scaledExtent(static_cast<uint32_t>(surfaceHeight_), renderScale_));
+    if (targets_[0].fbo != 0 && targetWidth_ == width && targetHeight_ == height) return true;
+
+    destroyTargets();
+    for (auto& target : targets_) {
+        glGenTextures(1, &target.texture);
+        glBindTexture(GL_TEXTURE_2D, target.texture);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        glGenFramebuffers(1, &target.fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, target.fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, target.texture, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            LOGE("Effect pass framebuffer incomplete");
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+            glBindTexture(GL_TEXTURE_2D, 0);
+            destroyTargets();
+            return false;
+        }
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    targetWidth_ = width;
+    targetHeight_ = height;
     return true;
 }
 
+bool GLRenderer::ensurePyramid(int width, int height) {
+    if (pyramidLevels_ > 0 && pyramidWidth_ == width && pyramidHeight_ == height) return true;
+
+    destroyPyramid();
+    int w = width;
+    int h = height;
+    for (auto& level : pyramid_) {
+        w = (w + 1) / 2;
+        h = (h + 1) / 2;
+        if (w < 2 || h < 2) break;
+        glGenTextures(1, &level.texture);
+        glBindTexture(GL_TEXTURE_2D, level.texture);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, w, h);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+        glGenFramebuffers(1, &level.fbo);
+        glBindFramebuffer(GL_FRAMEBUFFER, level.fbo);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, level.texture, 0);
+        if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+            LOGE("Blur pyramid framebuffer incomplete");
+            glBindTexture(GL_TEXTURE_2D, 0);
+            destroyPyramid();
+            return false;
+        }
+        ++pyramidLevels_;
+    }
+    glBindTexture(GL_TEXTURE_2D, 0);
+    pyramidWidth_ = width;
+    pyramidHeight_ = height;
+    return pyramidLevels_ > 0;
+}
+
+void GLRenderer::destroyPyramid() {
+    for (auto& level : pyramid_) {
+        if (level.fbo) { glDeleteFramebuffers(1, &level.fbo); level.fbo = 0; }
+        if (level.texture) { glDeleteTextures(1, &level.texture); level.texture = 0; }
+    }
+    pyramidLevels_ = 0;
+    pyramidWidth_ = pyramidHeight_ = 0;
+}
+
+void GLRenderer::destroyTargets() {
+    for (auto& target : targets_) {
+        if (target.fbo) { glDeleteFramebuffers(1, &target.fbo); target.fbo = 0; }
+        if (target.texture) { glDeleteTextures(1, &target.texture); target.texture = 0; }
+    }
+    targetWidth_ = targetHeight_ = 0;
+}
+
+bool GLRenderer::ensureAnalysisTarget() {
+    if (analysisConfig_ != analysisTarget_) {
+        destroyAnalysis();
+        if (!analysisConfig_.enabled()) return false;
+
+        const GLsizei width = static_cast<GLsizei>(lumina::analysisTargetWidth(analysisConfig_));
+        const GLsizei height = static_cast<GLsizei>(analysisConfig_.height);
+        glGenTextures(1, &analysisTex_);
+        glBindTexture(GL_TEXTURE_2D, analysisTex_);
+        glTexStorage2D(GL_TEXTURE_2D, 1, GL_RGBA8, width, height);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+        glBindTexture(GL_TEXTURE_2D, 0);
+
+        glGenFramebuffers(1, &analysisFbo_);
+        glBindFramebuffer(GL_FRAMEBUFFER, analysisFbo_);
+        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, analysisTex_, 0);
+        const bool complete = glCheckFramebufferStatus(GL_FRAMEBUFFER) == GL_FRAMEBUFFER_COMPLETE;
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        if (!complete) {
+            LOGE("Analysis framebuffer incomplete; analysis output disabled");
+            destroyAnalysis();
+            analysisConfig_ = lumina::AnalysisConfig{};
+            return false;
+        }
+
+        const GLsizeiptr bytes = static_cast<GLsizeiptr>(lumina::analysisFrameBytes(analysisConfig_));
+        for (auto& readback : analysisReadbacks_) {
+            glGenBuffers(1, &readback.pbo);
+            glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+            glBufferData(GL_PIXEL_PACK_BUFFER, bytes, nullptr, GL_STREAM_READ);
+        }
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+        analysisTarget_ = analysisConfig_;
+    }
+    if (!analysisTarget_.enabled()) return false;
+
+    if (analysisProgram_ == 0) {
+        analysisProgram_ = linkProgram(kAnalysisFragmentSource);
+        if (analysisProgram_ == 0) {
+            LOGE("Analysis program failed to link; analysis output disabled");
+            destroyAnalysis();
+            analysisConfig_ = lumina::AnalysisConfig{};
+            return false;
+        }
+        analysisSizeLoc_ = glGetUniformLocation(analysisProgram_, "uSize");
+        analysisGrayLoc_ = glGetUniformLocation(analysisProgram_, "uGray");
+        analysisInputLoc_ = glGetUniformLocation(analysisProgram_, "uInput");
+    }
+    return true;
+}
+
+void GLRenderer::renderAnalysis() {
+    // Every buffer is still waiting on the GPU: drop this frame rather than stall.
+    AnalysisReadback& readback = analysisReadbacks_[analysisNext_];
+    if (readback.fence) return;
+
+    const GLsizei width = static_cast<GLsizei>(lumina::analysisTargetWidth(analysisTarget_));
+    const GLsizei height = static_cast<GLsizei>(analysisTarget_.height);
+    glBindFramebuffer(GL_FRAMEBUFFER, analysisFbo_);
+    glViewport(0, 0, width, height);
+    glUseProgram(analysisProgram_);
+    glUniform2f(analysisSizeLoc_, static_cast<float>(analysisTarget_.width), static_cast<float>(analysisTarget_.height));
+    glUniform1i(analysisGrayLoc_, analysisTarget_.format == lumina::AnalysisFormat::GRAY ? 1 : 0);
+    glUniform1i(analysisInputLoc_, 0);
+    glBindTexture(GL_TEXTURE_EXTERNAL_OES, inputTexture());
+    glDrawArrays(GL_TRIANGLE_STRIP, 0, 4);
+
+    // With a pack buffer bound, glReadPixels only queues the copy.
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, readback.pbo);
+    glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    readback.fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    readback.frameNumber = frameNumber_;
+    readback.timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+    analysisNext_ = (analysisNext_ + 1) % kAnalysisReadbacks;
+}
+
+void GLRenderer::collectAnalysisReadbacks() {
+    // Fences signal in issue order, oldest first from analysisNext_; copying out only
+    // the newest finished readback is enough.
+    AnalysisReadback* newest = nullptr;
+    for (size_t i = 0; i < kAnalysisReadbacks; ++i) {
+        AnalysisReadback& readback = analysisReadbacks_[(analysisNext_ + i) % kAnalysisReadbacks];
+        if (!readback.fence) continue;
+        const GLenum status = glClientWaitSync(readback.fence, 0, 0);
+        if (status != GL_ALREADY_SIGNALED && status != GL_CONDITION_SATISFIED) break;
+        glDeleteSync(readback.fence);
+        readback.fence = nullptr;
+        newest = &readback;
+    }
+    if (!newest) return;
+
+    const size_t bytes = lumina::analysisFrameBytes(analysisTarget_);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, newest->pbo);
+    const void* mapped = glMapBufferRange(GL_PIXEL_PACK_BUFFER, 0, static_cast<GLsizeiptr>(bytes), GL_MAP_READ_BIT);
+    if (mapped) {
+        memcpy(analysisSink_->beginFrame(analysisTarget_), mapped, bytes);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+        analysisSink_->publish(newest->frameNumber, newest->timestampNs);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+}
+
+void GLRenderer::destroyAnalysis() {
+    for (auto& readback : analysisReadbacks_) {
+        if (readback.fence) glDeleteSync(readback.fence);
+        if (readback.pbo) glDeleteBuffers(1, &readback.pbo);
+        readback = AnalysisReadback{};
+    }
+    analysisNext_ = 0;
+    if (analysisFbo_) { glDeleteFramebuffers(1, &analysisFbo_); analysisFbo_ = 0; }
+    if (analysisTex_) { glDeleteTextures(1, &analysisTex_); analysisTex_ = 0; }
+    analysisTarget_ = lumina::AnalysisConfig{};
+}
+
 bool GLRenderer::compileShader(GLenum type, const char* source, GLuint& shaderOut) {
     shaderOut = glCreateShader(type);
     glShaderSource(shaderOut, 1, &source, nullptr);
@@ -226,12 +1153,72 @@ bool GLRenderer::compileShader(GLenum type, const char* source, GLuint& shaderOu
     return true;
 }
 
+bool GLRenderer::ensureTimerQueries() {
+    if (!stats_) return false;
+    if (!timerChecked_) {
+        timerChecked_ = true;
+        const char* extensions = reinterpret_cast<const char*>(glGetString(GL_EXTENSIONS));
+        timerSupported_ = extensions && std::strstr(extensions, "GL_EXT_disjoint_timer_query");
+        if (timerSupported_) {
+            for (auto& frame : timerFrames_) {
+                glGenQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+                frame.passCount = 0;
+            }
+        }
+    }
+    return timerSupported_;
+}
+
+void GLRenderer::collectTimerQueries(TimerFrame& frame) {
+    const uint32_t passCount = frame.passCount;
+    frame.passCount = 0;
+    if (passCount == 0) return;
+
+    // Queries complete in order, so the last pass being ready means all of them are.
+    GLuint available = GL_FALSE;
+    glGetQueryObjectuiv(frame.queries[passCount - 1], GL_QUERY_RESULT_AVAILABLE, &available);
+    // A disjoint event (frequency change, context switch) invalidates in-flight results.
+    GLint disjoint = GL_FALSE;
+    glGetIntegerv(GL_GPU_DISJOINT_EXT, &disjoint);
+    if (!available || disjoint) return;
+
+    std::array<float, lumina::kMaxEffectPasses> passMs{};
+    for (uint32_t p = 0; p < passCount; ++p) {
+        GLuint elapsedNs = 0;
+        glGetQueryObjectuiv(frame.queries[p], GL_QUERY_RESULT, &elapsedNs);
+        passMs[p] = static_cast<float>(elapsedNs) * 1e-6f;
+    }
+    stats_->recordGpuPasses(passMs.data(), passCount);
+}
+
+void GLRenderer::destroyTimerQueries() {
+    if (timerSupported_) {
+        for (auto& frame : timerFrames_) {
+            glDeleteQueries(static_cast<GLsizei>(frame.queries.size()), frame.queries.data());
+            frame.queries.fill(0);
+            frame.passCount = 0;
+        }
+    }
+    timerChecked_ = timerSupported_ = false;
+    timerFrame_ = 0;
+}
+
 void GLRenderer::destroyPipeline() {
+    saveProgramBinaries();
+    destroyTimerQueries();
+    for (auto& entry : programs_) glDeleteProgram(entry.second.program);
+    programs_.clear();
+    destroyTargets();
+    destroyPyramid();
+    destroyAnalysis();
+    destroyFrameFences();
+    if (analysisProgram_) { glDeleteProgram(analysisProgram_); analysisProgram_ = 0; }
+    if (glassProgram_) { glDeleteProgram(glassProgram_); glassProgram_ = 0; }
     if (glVbo_) { glDeleteBuffers(1, &glVbo_); glVbo_ = 0; }
     if (glVao_) { glDeleteVertexArrays(1, &glVao_); glVao_ = 0; }
-    if (glProgram_) { glDeleteProgram(glProgram_); glProgram_ = 0; }
+    if (vertexShader_) { glDeleteShader(vertexShader_); vertexShader_ = 0; }
     if (externalTex_) { glDeleteTextures(1, &externalTex_); externalTex_ = 0; }
-    uTimeLoc_ = uIntensityLoc_ = uEffectTypeLoc_ = uTintLoc_ = uCenterLoc_ = uScaleLoc_ = uParamsLoc_ = uResolutionLoc_ = uCameraTexLoc_ = -1;
+    destroyInputImages();
     pipelineReady_ = false;
 }
 
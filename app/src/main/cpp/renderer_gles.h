@@ -1,9 +1,25 @@
 #ifndef LUMINA_RENDERER_GLES_H
 #define LUMINA_RENDERER_GLES_H
 
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
 #include <GLES3/gl3.h>
+#include <GLES2/gl2ext.h>
 
+#include <array>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "analysis_frame.h"
+#include "blur_pyramid.h"
 #include "engine_structs.h"
+#include "effect_graph.h"
+#include "frame_stats.h"
+#include "glass_panels.h"
+#include "render_scale.h"
+
+struct AHardwareBuffer;
 
 class GLRenderer {
 public:
@@ -18,28 +34,218 @@ public:
     void destroy();
     GLuint getInputTextureId();
 
+    // Samples `buffer` instead of the camera texture from the next render(), through an
+    // EGLImage cached per buffer; null goes back to the camera. False if the buffer
+    // cannot be imported (the previous input stays).
+    bool setInputHardwareBuffer(AHardwareBuffer* buffer);
+
+    // Frames render() has started so far.
+    uint64_t submittedFrames() const { return frameNumber_; }
+
+    // Frames below this index have finished on the GPU, polled without waiting through
+    // the fence each successful render() leaves behind. Needs the context current.
+    uint64_t completedFrames();
+
+    // Links the programs for the chains in `states` (effect_graph.h warmupStates()) so
+    // their first frame does not compile; needs the context current. False on a link
+    // failure, which render() would hit as well.
+    bool warmUp(const std::vector<lumina::LuminaState>& states);
+
+    // Directory for persisted program binaries; set before the first render().
+    void setCacheDirectory(const std::string& dir) { cacheDir_ = dir; }
+
+    // Receives per-pass GPU times from GL_EXT_disjoint_timer_query (may be null).
+    void setFrameStats(lumina::FrameStats* stats) { stats_ = stats; }
+
+    // Packed low-res copy of the camera input (analysis_frame.h), read back through a
+    // PBO ring and published to `sink` a few frames later. Applied at the next render().
+    void setAnalysisOutput(const lumina::AnalysisConfig& config, lumina::AnalysisFrameExchange* sink) {
+        analysisConfig_ = config;
+        analysisSink_ = sink;
+    }
+
+    // Fraction of the surface size the intermediate effect passes render at (see
+    // render_scale.h); the surface pass upscales. Applied at the next render().
+    void setRenderScale(float scale) { renderScale_ = scale; }
+
+    // Where the UI's glass panels sit (glass_panels.h); used by the next renderGlass().
+    void setGlassLayout(const lumina::GlassLayout& layout) { glassLayout_ = layout; }
+
+    // Blurs the finished frame in the bound surface behind each glass panel, through the
+    // blur pyramid, with the radius and tone of `style`. Called after render() and after
+    // the frame went to the encoder, so recordings leave the panels out.
+    void renderGlass(const lumina::GlassmorphicParams& style);
+
 private:
+    // One linked program per variant: pass shape, render mode and target (see effectVariantKey).
+    struct PassProgram {
+        GLuint program = 0;
+        GLint uTimeLoc = -1;
+        GLint uResolutionLoc = -1;
+        GLint uExposureLoc = -1;
+        GLint uInputLoc = -1;
+        GLint uIntensityLoc = -1;
+        GLint uTintLoc = -1;
+        GLint uCenterLoc = -1;
+        GLint uScaleLoc = -1;
+        GLint uParamsLoc = -1;
+        GLint uPyramidLoc = -1;        // level 1 of the pass's pyramid, texture unit 1
+        GLint uPyramidOffsetLoc = -1;  // 0 when there is nothing to blur
+        // Pyramid stages only.
+        GLint uTexelLoc = -1;
+        GLint uOffsetLoc = -1;
+        GLint uThresholdLoc = -1;
+    };
+
+    // Driver program binary, linked with glProgramBinary() on later launches.
+    struct ProgramBinary {
+        GLenum format = 0;
+        std::vector<uint8_t> data;
+    };
+
+    // One GL_TIME_ELAPSED_EXT query per pass, read back kTimerLatency frames later.
+    struct TimerFrame {
+        std::array<GLuint, lumina::kMaxEffectPasses> queries{};
+        uint32_t passCount = 0;
+    };
+    static constexpr size_t kTimerLatency = 3;
+
+    // Ping-pong colour target for intermediate passes.
+    struct RenderTarget {
+        GLuint fbo = 0;
+        GLuint texture = 0;
+    };
+
+    // One glReadPixels into a pixel pack buffer per analysis frame, fenced and mapped
+    // only once the GPU has passed the fence.
+    struct AnalysisReadback {
+        GLuint pbo = 0;
+        GLsync fence = nullptr;
+        uint64_t frameNumber = 0;
+        int64_t timestampNs = 0;
+    };
+    static constexpr size_t kAnalysisReadbacks = 3;
+
+    // End-of-frame fence; frames signal in order, so each one covers those before it.
+    struct FrameFence {
+        GLsync fence = nullptr;
+        uint64_t frameNumber = 0;
+    };
+    static constexpr size_t kFrameFences = 4;
+
+    // A decoder cycles through a fixed set of buffers, so each gets one EGLImage and
+    // texture for as long as it keeps coming back. Holds a buffer reference.
+    struct InputImage {
+        AHardwareBuffer* buffer = nullptr;
+        EGLImageKHR image = EGL_NO_IMAGE_KHR;
+        GLuint texture = 0;
+        uint64_t lastUsed = 0;
+    };
+    static constexpr size_t kMaxInputImages = 8;
+
     bool ensurePipeline();
     bool ensureExternalTexture();
+    bool ensureTargets();
+    bool ensurePyramid(int width, int height);
+    const PassProgram* ensurePyramidProgram(lumina::PyramidStage stage, bool cameraInput);
+    float renderPyramid(const lumina::EffectPass& pass, const lumina::LuminaState& state,
+                        GLenum inputTarget, GLuint input);
+    bool drawPyramidStage(lumina::PyramidStage stage, bool external, const lumina::BlurPlan& plan,
+                          uint32_t dst, GLenum srcTarget, GLuint src, uint32_t srcWidth, uint32_t srcHeight,
+                          float threshold);
+    bool ensureGlassProgram();
+    void destroyPyramid();
+    const PassProgram* ensurePassProgram(const lumina::EffectPass& pass, const lumina::LuminaState& state,
+                                         bool cameraInput, bool lastPass);
+    static std::string buildPassSource(const lumina::EffectPass& pass, const lumina::LuminaState& state,
+                                       bool cameraInput, bool lastPass);
+    GLuint linkProgram(const std::string& fsSrc);
+    void loadProgramBinaries();
+    void saveProgramBinaries();
     bool compileShader(GLenum type, const char* source, GLuint& shaderOut);
+    bool ensureTimerQueries();
+    void collectTimerQueries(TimerFrame& frame);
+    void destroyTimerQueries();
+    void destroyTargets();
+    bool ensureAnalysisTarget();
+    void renderAnalysis();
+    void collectAnalysisReadbacks();
+    void destroyAnalysis();
+    void destroyFrameFences();
     void destroyPipeline();
+    bool loadImageFunctions();
+    void destroyInputImage(InputImage& entry);
+    void destroyInputImages();
+    GLuint inputTexture() const;
 
-    GLuint glProgram_ = 0;
     GLuint glVbo_ = 0;
     GLuint glVao_ = 0;
+    GLuint vertexShader_ = 0;
     GLuint externalTex_ = 0;
-    GLint uTimeLoc_ = -1;
-    GLint uIntensityLoc_ = -1;
-    GLint uEffectTypeLoc_ = -1;
-    GLint uTintLoc_ = -1;
-    GLint uCenterLoc_ = -1;
-    GLint uScaleLoc_ = -1;
-    GLint uParamsLoc_ = -1;
-    GLint uResolutionLoc_ = -1;
-    GLint uCameraTexLoc_ = -1;
+    std::unordered_map<uint64_t, PassProgram> programs_;
+    std::array<RenderTarget, 2> targets_{};
+
+    // Blur pyramid levels 1..n, halving from the render scale's size; shared by every
+    // pass since each consumes its pyramid before the next one is built.
+    std::array<RenderTarget, lumina::kMaxBlurLevels> pyramid_{};
+    uint32_t pyramidLevels_ = 0;
+    int pyramidWidth_ = 0;    // the size level 1 halves
+    int pyramidHeight_ = 0;
+
+    // Loaded once per driver identity (GL_VENDOR/RENDERER/VERSION), keyed by source hash.
+    std::unordered_map<uint64_t, ProgramBinary> binaries_;
+    std::string cacheDir_;
+    std::string driverId_;
+    uint64_t vertexSourceHash_ = 0;
+    bool binarySupported_ = false;
+    bool binariesDirty_ = false;
+    int targetWidth_ = 0;
+    int targetHeight_ = 0;
     bool pipelineReady_ = false;
     int surfaceWidth_ = 0;
     int surfaceHeight_ = 0;
+    float renderScale_ = 1.0f;
+
+    lumina::FrameStats* stats_ = nullptr;
+    std::array<TimerFrame, kTimerLatency> timerFrames_{};
+    size_t timerFrame_ = 0;
+    bool timerChecked_ = false;
+    bool timerSupported_ = false;
+
+    lumina::GlassLayout glassLayout_;
+    GLuint glassProgram_ = 0;
+    GLint glassInputLoc_ = -1;
+    GLint glassTexelLoc_ = -1;
+    GLint glassOffsetLoc_ = -1;
+    GLint glassRectLoc_ = -1;
+    GLint glassRadiusLoc_ = -1;
+    GLint glassResolutionLoc_ = -1;
+    GLint glassSaturationLoc_ = -1;
+    GLint glassBrightnessLoc_ = -1;
+
+    lumina::AnalysisConfig analysisConfig_;   // requested
+    lumina::AnalysisConfig analysisTarget_;   // what analysisFbo_ and the PBOs are sized for
+    lumina::AnalysisFrameExchange* analysisSink_ = nullptr;
+    GLuint analysisProgram_ = 0;
+    GLint analysisSizeLoc_ = -1;
+    GLint analysisGrayLoc_ = -1;
+    GLint analysisInputLoc_ = -1;
+    GLuint analysisFbo_ = 0;
+    GLuint analysisTex_ = 0;
+    std::array<AnalysisReadback, kAnalysisReadbacks> analysisReadbacks_{};
+    size_t analysisNext_ = 0;   // ring slot of the next readback; also the oldest pending
+    uint64_t frameNumber_ = 0;
+    std::array<FrameFence, kFrameFences> frameFences_{};
+    size_t frameFenceNext_ = 0;   // ring slot of the next fence; also the oldest pending
+    uint64_t completedFrames_ = 0;
+
+    PFNEGLGETNATIVECLIENTBUFFERANDROIDPROC getNativeClientBuffer_ = nullptr;
+    PFNEGLCREATEIMAGEKHRPROC createImage_ = nullptr;
+    PFNEGLDESTROYIMAGEKHRPROC destroyImage_ = nullptr;
+    PFNGLEGLIMAGETARGETTEXTURE2DOESPROC imageTargetTexture_ = nullptr;
+    EGLDisplay imageDisplay_ = EGL_NO_DISPLAY;
+    std::vector<InputImage> inputImages_;
+    int activeInput_ = -1;   // index into inputImages_, -1 for the camera texture
 };
 
 #endif // LUMINA_RENDERER_GLES_H
@@ -1,10 +1,16 @@
 #include "renderer_vulkan.h"
+#include "shader_cache.h"
+#include "trace.h"
 
 #include <android/log.h>
 #include <vector>
 #include <array>
 #include <algorithm>
+#include <chrono>
 #include <cstring>
+#include <cstddef>
+#include <cstdio>
+#include <utility>
 
 #define LOG_TAG "LuminaVulkan"
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
@@ -12,7 +18,6 @@
 #define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
 
 namespace {
-// Single-flight semaphore/fence per swapchain image; no separate constant needed.
 
 template <typename T>
 T makeStruct(VkStructureType sType) {
@@ -27,131 +32,531 @@ bool hasExtension(const std::vector<VkExtensionProperties>& exts, const char* na
         return strcmp(e.extensionName, name) == 0;
     });
 }
+
+// effect_chain.frag declares LuminaState::effects with the same std140 layout.
+static_assert(sizeof(lumina::EffectParams) == 64, "EffectChain uniform block expects 64-byte effects");
+constexpr VkDeviceSize kChainBlockSize = sizeof(lumina::EffectParams) * lumina::kMaxEffects;
+
+// Specialization constants shared by every effect shader (see lumina_common.glsl).
+struct VariantConstants {
+    uint32_t opCount;
+    uint32_t opTypes[lumina::kMaxEffects];
+    uint32_t renderMode;
+    VkBool32 lastPass;
+};
+
+constexpr std::array<VkSpecializationMapEntry, 7> kVariantConstantMap = {{
+    {0, offsetof(VariantConstants, opCount), sizeof(uint32_t)},
+    {1, offsetof(VariantConstants, opTypes) + 0 * sizeof(uint32_t), sizeof(uint32_t)},
+    {2, offsetof(VariantConstants, opTypes) + 1 * sizeof(uint32_t), sizeof(uint32_t)},
+    {3, offsetof(VariantConstants, opTypes) + 2 * sizeof(uint32_t), sizeof(uint32_t)},
+    {4, offsetof(VariantConstants, opTypes) + 3 * sizeof(uint32_t), sizeof(uint32_t)},
+    {5, offsetof(VariantConstants, renderMode), sizeof(uint32_t)},
+    {6, offsetof(VariantConstants, lastPass), sizeof(VkBool32)},
+}};
+
+VkImageMemoryBarrier imageBarrier(VkImage image, VkAccessFlags srcAccess, VkAccessFlags dstAccess,
+                                  VkImageLayout oldLayout, VkImageLayout newLayout) {
+    auto b = makeStruct<VkImageMemoryBarrier>(VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER);
+    b.srcAccessMask = srcAccess;
+    b.dstAccessMask = dstAccess;
+    b.oldLayout = oldLayout;
+    b.newLayout = newLayout;
+    b.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    b.image = image;
+    b.subresourceRange = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1 };
+    return b;
 }
 
-// Prefer generated shader header if available (produced by the Gradle task)
-#if __has_include("generated/shaders_generated.h")
-#include "generated/shaders_generated.h"
+// Clockwise quarter turns of a preTransform; mirrored transforms are never chosen.
+uint32_t quarterTurnsOf(VkSurfaceTransformFlagBitsKHR transform) {
+    switch (transform) {
+        case VK_SURFACE_TRANSFORM_ROTATE_90_BIT_KHR: return 1;
+        case VK_SURFACE_TRANSFORM_ROTATE_180_BIT_KHR: return 2;
+        case VK_SURFACE_TRANSFORM_ROTATE_270_BIT_KHR: return 3;
+        default: return 0;
+    }
+}
+}
+
+// SPIR-V and the block layouts reflected from it (gpu_layout.h), both written by the
+// generateVulkanShaders Gradle task that every native build depends on.
+#if !__has_include("generated/shaders_generated.h") || !__has_include("generated/shader_layouts_generated.h")
+#error "Generated shader headers missing: run the generateVulkanShaders Gradle task"
 #endif
+#include "generated/shaders_generated.h"
+#include "generated/shader_layouts_generated.h"
+
+// The effect chain and the push constants are written as raw bytes, so every
+// mirrored member is checked against the shaders.
+
+namespace {
+namespace chain_layout = lumina::shader_layout::effect_chain;
+using Push = VulkanRenderer::PassPushConstants;
+
+LUMINA_ASSERT_BLOCK_MEMBER(chain_layout::Effect, lumina::EffectParams, type);
+LUMINA_ASSERT_BLOCK_MEMBER(chain_layout::Effect, lumina::EffectParams, intensity);
+LUMINA_ASSERT_BLOCK_MEMBER(chain_layout::Effect, lumina::EffectParams, param1);
+LUMINA_ASSERT_BLOCK_MEMBER(chain_layout::Effect, lumina::EffectParams, param2);
+LUMINA_ASSERT_BLOCK_MEMBER(chain_layout::Effect, lumina::EffectParams, tintColor);
+LUMINA_ASSERT_BLOCK_MEMBER(chain_layout::Effect, lumina::EffectParams, center);
+LUMINA_ASSERT_BLOCK_MEMBER(chain_layout::Effect, lumina::EffectParams, scale);
+LUMINA_ASSERT_BLOCK_SIZE(chain_layout::Effect, lumina::EffectParams);
+static_assert(chain_layout::EffectChain.matches("effects", 0, kChainBlockSize) &&
+              chain_layout::EffectChain.find("effects")->arrayStride == sizeof(lumina::EffectParams),
+              "EffectChain must hold LuminaState::effects as-is");
+
+LUMINA_ASSERT_BLOCK_MEMBER(chain_layout::PushConstants, Push, time);
+LUMINA_ASSERT_BLOCK_MEMBER(chain_layout::PushConstants, Push, opCount);
+LUMINA_ASSERT_BLOCK_MEMBER(chain_layout::PushConstants, Push, opSlots);
+LUMINA_ASSERT_BLOCK_MEMBER(chain_layout::PushConstants, Push, exposure);
+LUMINA_ASSERT_BLOCK_MEMBER(chain_layout::PushConstants, Push, resolution);
+LUMINA_ASSERT_BLOCK_MEMBER(chain_layout::PushConstants, Push, pyramidOffset);
+LUMINA_ASSERT_BLOCK_SIZE(chain_layout::PushConstants, Push);
+
+// The single-effect shaders share lumina_params.glsl; catch one that grew its own copy.
+LUMINA_ASSERT_BLOCK_SIZE(lumina::shader_layout::soften::PushConstants, Push);
+LUMINA_ASSERT_BLOCK_SIZE(lumina::shader_layout::sharpen::PushConstants, Push);
+LUMINA_ASSERT_BLOCK_SIZE(lumina::shader_layout::chromatic_aberration::PushConstants, Push);
+LUMINA_ASSERT_BLOCK_SIZE(lumina::shader_layout::blur_down::PushConstants, VulkanRenderer::PyramidPushConstants);
+LUMINA_ASSERT_BLOCK_SIZE(lumina::shader_layout::analysis::PushConstants, VulkanRenderer::AnalysisPushConstants);
+
+namespace glass_layout = lumina::shader_layout::glass;
+using GlassPush = VulkanRenderer::GlassPushConstants;
+LUMINA_ASSERT_BLOCK_MEMBER(glass_layout::PushConstants, GlassPush, rect);
+LUMINA_ASSERT_BLOCK_MEMBER(glass_layout::PushConstants, GlassPush, resolution);
+LUMINA_ASSERT_BLOCK_MEMBER(glass_layout::PushConstants, GlassPush, framebuffer);
+LUMINA_ASSERT_BLOCK_MEMBER(glass_layout::PushConstants, GlassPush, cornerRadius);
+LUMINA_ASSERT_BLOCK_MEMBER(glass_layout::PushConstants, GlassPush, offset);
+LUMINA_ASSERT_BLOCK_MEMBER(glass_layout::PushConstants, GlassPush, saturation);
+LUMINA_ASSERT_BLOCK_MEMBER(glass_layout::PushConstants, GlassPush, brightness);
+LUMINA_ASSERT_BLOCK_SIZE(glass_layout::PushConstants, GlassPush);
+} // namespace
 
 
 bool VulkanRenderer::initialize(ANativeWindow* window) {
     if (initialized_) return true;
 
+    headless_ = false;
+    if (!createInstance()) return false;
+    if (window && !createSurface(window)) return false;
+    return initializeDevice();
+}
+
+bool VulkanRenderer::initializeHeadless(uint32_t width, uint32_t height) {
+    if (initialized_) return true;
+    if (width == 0 || height == 0) {
+        LOGE("initializeHeadless: invalid size %ux%u", width, height);
+        return false;
+    }
+
+    headless_ = true;
+    headlessExtent_ = { width, height };
     if (!createInstance()) return false;
-    if (!createSurface(window)) return false;
+    return initializeDevice();
+}
+
+bool VulkanRenderer::initializeDevice() {
     if (!pickPhysicalDevice()) return false;
     if (!createDevice()) return false;
+    if (!createPipelineCache()) return false;
     if (!createCommandPool()) return false;
-    if (!createSwapchain()) return false;
-    if (!createRenderPass()) return false;
+    if (!createFrameResources()) return false;
     if (!createDescriptorSetLayout()) return false;
     if (!createPipelineLayout()) return false;
-    if (!createGraphicsPipeline()) return false;
-    if (!createFramebuffers()) return false;
     if (!createTextureResources()) return false;
     if (!createSampler()) return false;
+    if (!createEffectChainBuffer()) return false;
     if (!createDescriptorPoolAndSets()) return false;
+    if (!createImportDescriptorPool()) return false;
+    if (!createUploadResources()) return false;
+
+    // Without a window yet, the swapchain and everything sized by it wait for recreate().
+    // Render passes get the format createSwapchain() prefers so warmUp() can build
+    // pipelines that stay compatible with the real ones.
+    if (!headless_ && surface_ == VK_NULL_HANDLE) {
+        swapchain_.format = kPreferredSurfaceFormat;
+        if (!createRenderPass()) return false;
+        initialized_ = true;
+        return true;
+    }
+
+    if (!createSwapchain()) return false;
+    if (!createRenderPass()) return false;
+    if (!createGraphicsPipeline()) return false;
+    if (!createFramebuffers()) return false;
     if (!createSyncObjects()) return false;
-    if (!recordCommandBuffers()) return false;
 
     initialized_ = true;
     return true;
 }
-bool VulkanRenderer::render(const lumina::LuminaState& state) {
-    if (!initialized_) return false;
 
-    // [FIX] 1. Map High-Level State -> Low-Level GPU Struct
-    const lumina::EffectParams* active = (state.activeEffectCount > 0) ? &state.effects[0] : nullptr;
-
-    effectParams_.time = state.timing.totalTime;
-    effectParams_.intensity = active ? active->intensity : 0.0f;
-    effectParams_.effectType = active ? static_cast<int>(active->type) : 0;
-
-    // Manual copy for safety across JNI/ABI boundaries
-    if (active) {
-        effectParams_.tint[0] = active->tintColor.r;
-        effectParams_.tint[1] = active->tintColor.g;
-        effectParams_.tint[2] = active->tintColor.b;
-        effectParams_.tint[3] = active->tintColor.a;
-
-        effectParams_.center[0] = active->center.x;
-        effectParams_.center[1] = active->center.y;
+bool VulkanRenderer::warmUp(const std::vector<lumina::LuminaState>& states) {
+    if (!initialized_) return false;
+    LUMINA_TRACE_SCOPE("Vulkan::warmUp");
+    lumina::EffectGraphOptions graphOptions;
+    graphOptions.fuseIntoSampling = false;
+
+    // Mirrors render(): camera uploads (not YCbCr imports), merged tail when it applies.
+    const auto warmState = [&](const lumina::LuminaState& state) {
+        FrameResources frame;
+        frame.effects = state.effects;
+        frame.renderMode = state.renderMode;
+        const lumina::EffectGraph graph = lumina::buildEffectGraph(state, graphOptions);
+        const uint32_t passCount = std::max(graph.passCount, 1u);
+        for (uint32_t p = 0; p < passCount; ++p) {
+            const lumina::EffectPass& pass = graph.passes[p];
+            if (pass.pyramidSlot != lumina::kNoPyramid) {
+                if (pyramidPipeline(lumina::PyramidStage::Down) == VK_NULL_HANDLE ||
+                    pyramidPipeline(lumina::PyramidStage::Up) == VK_NULL_HANDLE ||
+                    (frame.effects[pass.pyramidSlot % lumina::kMaxEffects].type == lumina::EffectType::BLOOM &&
+                     pyramidPipeline(lumina::PyramidStage::Prefilter) == VK_NULL_HANDLE)) {
+                    return false;
+                }
+            }
+            if (pipelineVariant(frame, pass, p + 1 == passCount, false) == VK_NULL_HANDLE) return false;
+        }
+        if (mergedRenderPass_ != VK_NULL_HANDLE && lumina::hasPointwiseTail(graph)) {
+            if (pipelineVariant(frame, graph.passes[passCount - 2], false, false, true) == VK_NULL_HANDLE ||
+                pipelineVariant(frame, graph.passes[passCount - 1], true, false, true) == VK_NULL_HANDLE) {
+                return false;
+            }
+        }
+        return true;
+    };
 
-        effectParams_.scale[0] = active->scale.x;
-        effectParams_.scale[1] = active->scale.y;
+    // Surface passes draw pre-rotated, so they are built for every turn the display can
+    // report; rotating the device then only rebuilds the swapchain. The offscreen passes
+    // are shared and found in the map after the first turn.
+    const uint32_t surfaceTurns = swapchain_.quarterTurns;
+    bool warmed = true;
+    for (uint32_t turns = 0; turns < 4 && warmed; ++turns) {
+        swapchain_.quarterTurns = turns;
+        for (const lumina::LuminaState& state : states) {
+            if (!(warmed = warmState(state))) break;
+        }
+    }
+    swapchain_.quarterTurns = surfaceTurns;
+    if (!warmed) return false;
+    LOGI("Warmed up %zu pipeline variants", pipelineVariants_.size());
+    return true;
+}
+bool VulkanRenderer::render(const lumina::LuminaState& state) {
+    if (!initialized_ || (!headless_ && swapchain_.swapchain == VK_NULL_HANDLE)) return false;
+    LUMINA_TRACE_SCOPE("Vulkan::render");
+
+    // Frame slots cycle independently of the swapchain; waiting here bounds the CPU to
+    // kMaxFramesInFlight frames ahead of the GPU.
+    const uint32_t frameSlot = static_cast<uint32_t>(currentFrame_ % kMaxFramesInFlight);
+    FrameResources& frame = frames_[frameSlot];
+    {
+        // Time spent here means the GPU is the bottleneck.
+        LUMINA_TRACE_SCOPE("Vulkan::waitFrameSlot");
+        vkWaitForFences(device_, 1, &frame.inFlight, VK_TRUE, UINT64_MAX);
+    }
+    collectGpuTimings(frame);
+    collectAnalysisFrame(analysisTargets_[frameSlot]);
+    destroyRetired(false);
+    if (swapchain_.outOfDate && !recreate(window_)) return false;
+    const VkExtent2D surface = surfaceExtent();
+    // The glass pyramid follows the images, which a new pre-rotation can resize alone.
+    const bool glassStale = glassLevels_ > 0 &&
+        (lumina::scaledExtent(swapchain_.width, renderScale_) != glassExtent_.width ||
+         lumina::scaledExtent(swapchain_.height, renderScale_) != glassExtent_.height);
+    if (lumina::scaledExtent(surface.width, renderScale_) != renderExtent_.width ||
+        lumina::scaledExtent(surface.height, renderScale_) != renderExtent_.height || glassStale) {
+        if (!applyRenderScale()) return false;
+    }
+    const bool analysis = analysisSink_ && ensureAnalysisTargets();
+    const bool recording = !headless_ && encoderTimestamp_ != 0 && ensureEncoderOutput();
+
+    // Everything the command buffer reads is captured per frame before acquire, so a
+    // later render() cannot change what an in-flight frame records or samples.
+    frame.params = effectParams_;
+    frame.params.time = state.timing.totalTime;
+    frame.params.resolution[0] = static_cast<float>(surface.width);
+    frame.params.resolution[1] = static_cast<float>(surface.height);
+    frame.params.exposure = 0.8f + (state.activeEffectCount > 0 ? state.effects[0].intensity : 1.0f) * 0.25f;
+    frame.effects = state.effects;
+    frame.renderMode = state.renderMode;
+    frame.uiStyle = state.uiStyle;
+    frame.glass = glassLayout_;
+
+    // Plan the pass chain. Sampling shaders are fixed SPIR-V, so pointwise ops after
+    // them get their own fused pass; YCbCr imports can only be read by the chain pass.
+    lumina::EffectGraphOptions graphOptions;
+    graphOptions.fuseIntoSampling = false;
+    graphOptions.plainFetchFirst = activeImport_ >= 0 && imports_[static_cast<size_t>(activeImport_)].ycbcr;
+    frame.graph = lumina::buildEffectGraph(state, graphOptions);
+
+    // This slot's slice of the effect uniform buffer was last read by the frame whose
+    // fence we just waited on.
+    memcpy(static_cast<uint8_t*>(chainMapped_) + chainStride_ * frameSlot, state.effects.data(), kChainBlockSize);
+
+    using Clock = std::chrono::steady_clock;
+    const auto msBetween = [](Clock::time_point a, Clock::time_point b) {
+        return std::chrono::duration<float, std::milli>(b - a).count();
+    };
+    const auto recordStart = Clock::now();
 
-        effectParams_.params[0] = active->param1;
-        effectParams_.params[1] = active->param2;
-    } else {
-        // Defaults
-        effectParams_.tint[0] = 1.0f; effectParams_.tint[1] = 1.0f;
-        effectParams_.tint[2] = 1.0f; effectParams_.tint[3] = 1.0f;
-        effectParams_.center[0] = 0.5f; effectParams_.center[1] = 0.5f;
-        effectParams_.scale[0] = 1.0f; effectParams_.scale[1] = 1.0f;
+    // The pool holds only this frame's command buffer; resetting it wholesale is cheaper
+    // than per-buffer resets and lets the driver recycle the memory.
+    vkResetCommandPool(device_, frame.pool, 0);
+    auto bi = makeStruct<VkCommandBufferBeginInfo>(VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO);
+    bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    if (vkBeginCommandBuffer(frame.cmd, &bi) != VK_SUCCESS) {
+        LOGE("vkBeginCommandBuffer failed for frame slot %u", frameSlot);
+        return false;
     }
 
-    // Update resolution uniform
-    effectParams_.resolution[0] = static_cast<float>(swapchain_.width);
-    effectParams_.resolution[1] = static_cast<float>(swapchain_.height);
+    // Offscreen passes do not depend on the swapchain image; record them before acquire.
+    // A pointwise last pass shares the surface render pass with the pass before it,
+    // unless the effect passes run below surface size.
+    const uint32_t passCount = std::max(frame.graph.passCount, 1u);
+    const bool fullSize = renderExtent_.width == surface.width && renderExtent_.height == surface.height;
+    const bool mergedTail = mergedRenderPass_ != VK_NULL_HANDLE && fullSize && lumina::hasPointwiseTail(frame.graph);
+    const uint32_t surfacePasses = mergedTail ? 2 : 1;
+    {
+        LUMINA_TRACE_SCOPE("Vulkan::recordOffscreen");
+        beginFrameCommands(frame, frameSlot);
+        for (uint32_t p = 0; p + surfacePasses < passCount; ++p) {
+            if (!recordPass(frame, frameSlot, p, 0)) {
+                vkEndCommandBuffer(frame.cmd);
+                return false;
+            }
+        }
+    }
 
-    // [FIX] 2. Standard Vulkan Render Loop
-    const size_t frameIndex = currentFrame_ % swapchain_.images.size();
-    
-    // Wait for the fence to ensure we can write to this frame's resources
-    vkWaitForFences(device_, 1, &swapchain_.inFlightFences[frameIndex], VK_TRUE, UINT64_MAX);
+    // Lazily built pipelines are how recording fails; build the surface passes' now, while
+    // a failure still leaves no image acquired and no semaphore signalled.
+    if (!resolveSurfacePipelines(frame, mergedTail)) {
+        vkEndCommandBuffer(frame.cmd);
+        return false;
+    }
+    // Glass that cannot be drawn leaves the panels unblurred rather than failing the frame.
+    const bool glass = resolveGlassPipelines(frame);
 
+    const auto acquireStart = Clock::now();
     uint32_t imageIndex = 0;
-    VkResult acquire = vkAcquireNextImageKHR(device_, swapchain_.swapchain, UINT64_MAX, swapchain_.imageAvailable[frameIndex], VK_NULL_HANDLE, &imageIndex);
-    
-    if (acquire == VK_ERROR_OUT_OF_DATE_KHR) return recreate(window_);
-    if (acquire != VK_SUCCESS && acquire != VK_SUBOPTIMAL_KHR) return false;
+    VkResult acquire = VK_SUCCESS;
+    if (headless_) {
+        // One target per frame slot, so the slot fence already covers reuse.
+        imageIndex = frameSlot;
+    } else {
+        LUMINA_TRACE_SCOPE("Vulkan::acquire");
+        acquire = vkAcquireNextImageKHR(device_, swapchain_.swapchain, UINT64_MAX, frame.imageAvailable, VK_NULL_HANDLE, &imageIndex);
+    }
+    if (acquire == VK_ERROR_OUT_OF_DATE_KHR) {
+        vkEndCommandBuffer(frame.cmd);
+        return recreate(window_);
+    }
+    if (acquire != VK_SUCCESS && acquire != VK_SUBOPTIMAL_KHR) {
+        vkEndCommandBuffer(frame.cmd);
+        return false;
+    }
 
-    vkResetFences(device_, 1, &swapchain_.inFlightFences[frameIndex]);
+    // With more images than frame slots, an image can come back while the frame that
+    // last rendered it (from another slot) is still executing.
+    VkFence& imageFence = swapchain_.imagesInFlight[imageIndex];
+    if (imageFence != VK_NULL_HANDLE && imageFence != frame.inFlight) {
+        LUMINA_TRACE_SCOPE("Vulkan::waitImage");
+        vkWaitForFences(device_, 1, &imageFence, VK_TRUE, UINT64_MAX);
+    }
+    imageFence = frame.inFlight;
+
+    // Never hold the preview back for the encoder: when it still owns every image, this
+    // frame is simply not recorded.
+    uint32_t encoderIndex = 0;
+    bool encode = false;
+    if (recording) {
+        const VkResult acquired = vkAcquireNextImageKHR(device_, encoder_.swapchain, 0, encoder_.acquired[frameSlot],
+                                                        VK_NULL_HANDLE, &encoderIndex);
+        encode = acquired == VK_SUCCESS || acquired == VK_SUBOPTIMAL_KHR;
+        encoder_.outOfDate = acquired == VK_ERROR_OUT_OF_DATE_KHR || acquired == VK_ERROR_SURFACE_LOST_KHR;
+    }
+    const auto acquireEnd = Clock::now();
+
+    bool recorded = false;
+    bool analysisRecorded = false;
+    VkResult ended = VK_SUCCESS;
+    {
+        LUMINA_TRACE_SCOPE("Vulkan::recordPresentPass");
+        recorded = mergedTail ? recordMergedTail(frame, frameSlot, imageIndex)
+                              : recordPass(frame, frameSlot, passCount - 1, imageIndex);
+        // After the last timestamp, so neither copy counts towards pass times.
+        if (recorded && encode) recordEncoderBlit(frame.cmd, imageIndex, encoderIndex);
+        // After the encoder copy, so recordings carry the frame without the UI's glass.
+        if (recorded && glass) recordGlass(frame, imageIndex);
+        analysisRecorded = recorded && analysis && recordAnalysisPass(frame, frameSlot);
+        ended = vkEndCommandBuffer(frame.cmd);
+    }
+    if (ended != VK_SUCCESS || !recorded) {
+        LOGE("Failed to record frame slot %u", frameSlot);
+        abandonAcquiredFrame(frame, frameSlot, encode);
+        return false;
+    }
+    const auto recordEnd = Clock::now();
+    if (stats_) {
+        // Acquire and the image fence wait block on the GPU/compositor; they are not recording work.
+        stats_->record(lumina::FrameStage::Record,
+                       msBetween(recordStart, acquireStart) + msBetween(acquireEnd, recordEnd));
+    }
 
-    // [CRITICAL] Record commands *now* to capture the latest effectParams_
-    recordCommandBuffer(imageIndex);
+    vkResetFences(device_, 1, &frame.inFlight);
 
     VkSubmitInfo submitInfo{};
     submitInfo.sType = VK_STRUCTURE_TYPE_SUBMIT_INFO;
     
-    VkSemaphore waitSemaphores[] = {swapchain_.imageAvailable[frameIndex]};
-    VkPipelineStageFlags waitStages[] = {VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT};
-    submitInfo.waitSemaphoreCount = 1;
-    submitInfo.pWaitSemaphores = waitSemaphores;
-    submitInfo.pWaitDstStageMask = waitStages;
+    // Sampling waits on the upload that filled the displayed ring slot. Binary fallback
+    // semaphores are all consumed here so superseded uploads can be re-signalled later.
+    std::array<VkSemaphore, 2 + kUploadRingSize> waitSemaphores{};
+    std::array<VkPipelineStageFlags, 2 + kUploadRingSize> waitStages{};
+    std::array<uint64_t, 2 + kUploadRingSize> waitValues{};
+    uint32_t waitCount = 0;
+    if (!headless_) {
+        waitSemaphores[waitCount] = frame.imageAvailable;
+        waitStages[waitCount++] = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    }
+    if (encode) {
+        waitSemaphores[waitCount] = encoder_.acquired[frameSlot];
+        waitStages[waitCount++] = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    }
+    if (timelineSupported_) {
+        if (activeImport_ < 0 && readySlot_ >= 0) {
+            waitSemaphores[waitCount] = uploadTimeline_;
+            waitValues[waitCount] = uploadRing_[static_cast<size_t>(readySlot_)].readyValue;
+            waitStages[waitCount++] = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+        }
+    } else {
+        for (auto& slot : uploadRing_) {
+            if (!slot.pendingWait) continue;
+            waitSemaphores[waitCount] = slot.ready;
+            waitStages[waitCount++] = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+            slot.pendingWait = false;
+        }
+    }
+
+    auto timelineInfo = makeStruct<VkTimelineSemaphoreSubmitInfoKHR>(VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR);
+    timelineInfo.waitSemaphoreValueCount = waitCount;
+    timelineInfo.pWaitSemaphoreValues = waitValues.data();
+    submitInfo.pNext = timelineSupported_ ? &timelineInfo : nullptr;
+    submitInfo.waitSemaphoreCount = waitCount;
+    submitInfo.pWaitSemaphores = waitSemaphores.data();
+    submitInfo.pWaitDstStageMask = waitStages.data();
     submitInfo.commandBufferCount = 1;
-    submitInfo.pCommandBuffers = &swapchain_.commandBuffers[imageIndex];
+    submitInfo.pCommandBuffers = &frame.cmd;
     
-    VkSemaphore signalSemaphores[] = {swapchain_.renderFinished[frameIndex]};
-    submitInfo.signalSemaphoreCount = 1;
+    // Present waits are only known to be done when the image is acquired again, so the
+    // render-finished semaphore belongs to the image rather than the frame slot.
+    const uint32_t presentCount = headless_ ? 0 : (encode ? 2 : 1);
+    VkSemaphore signalSemaphores[] = {
+        headless_ ? VK_NULL_HANDLE : swapchain_.renderFinished[imageIndex],
+        encode ? encoder_.renderFinished[encoderIndex] : VK_NULL_HANDLE,
+    };
+    submitInfo.signalSemaphoreCount = presentCount;
     submitInfo.pSignalSemaphores = signalSemaphores;
 
-    if (vkQueueSubmit(graphicsQueue_, 1, &submitInfo, swapchain_.inFlightFences[frameIndex]) != VK_SUCCESS) {
+    VkResult submitted = VK_SUCCESS;
+    {
+        LUMINA_TRACE_SCOPE("Vulkan::submit");
+        submitted = vkQueueSubmit(graphicsQueue_, 1, &submitInfo, frame.inFlight);
+    }
+    if (submitted != VK_SUCCESS) {
         return false;
     }
+    LUMINA_TRACE_COUNTER("Lumina frames in flight", framesInFlight());
+    frame.timestampCount = frame.timestamps != VK_NULL_HANDLE ? passCount + 1 : 0;
+    if (analysisRecorded) {
+        AnalysisTarget& target = analysisTargets_[frameSlot];
+        target.pending = true;
+        target.frameNumber = currentFrame_ + 1;
+        target.timestampNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    if (headless_) {
+        if (stats_) stats_->record(lumina::FrameStage::Submit, msBetween(recordEnd, Clock::now()));
+        currentFrame_++;
+        return true;
+    }
 
+    // The display and the encoder image go out in one present.
     VkPresentInfoKHR presentInfo{};
     presentInfo.sType = VK_STRUCTURE_TYPE_PRESENT_INFO_KHR;
-    presentInfo.waitSemaphoreCount = 1;
+    presentInfo.waitSemaphoreCount = presentCount;
     presentInfo.pWaitSemaphores = signalSemaphores;
-    VkSwapchainKHR swapchains[] = {swapchain_.swapchain};
-    presentInfo.swapchainCount = 1;
+    VkSwapchainKHR swapchains[] = {swapchain_.swapchain, encoder_.swapchain};
+    uint32_t imageIndices[] = {imageIndex, encoderIndex};
+    VkResult results[] = {VK_SUCCESS, VK_SUCCESS};
+    presentInfo.swapchainCount = presentCount;
     presentInfo.pSwapchains = swapchains;
-    presentInfo.pImageIndices = &imageIndex;
+    presentInfo.pImageIndices = imageIndices;
+    presentInfo.pResults = results;
+
+    // On the encoder the present time becomes the buffer timestamp, i.e. the frame's
+    // position in the recording; without display timing it is the time of queueing.
+    VkPresentTimeGOOGLE presentTime[2]{};
+    auto presentTimes = makeStruct<VkPresentTimesInfoGOOGLE>(VK_STRUCTURE_TYPE_PRESENT_TIMES_INFO_GOOGLE);
+    if (displayTimingSupported_ && (desiredPresentTime_ != 0 || encode)) {
+        presentTime[0].presentID = presentTime[1].presentID = ++presentId_;
+        presentTime[0].desiredPresentTime = desiredPresentTime_;
+        presentTime[1].desiredPresentTime = static_cast<uint64_t>(encoderTimestamp_);
+        presentTimes.swapchainCount = presentCount;
+        presentTimes.pTimes = presentTime;
+        presentInfo.pNext = &presentTimes;
+    }
 
-    VkResult present = vkQueuePresentKHR(graphicsQueue_, &presentInfo);
-    if (present == VK_ERROR_OUT_OF_DATE_KHR || present == VK_SUBOPTIMAL_KHR) {
-        return recreate(window_);
+    {
+        LUMINA_TRACE_SCOPE("Vulkan::present");
+        vkQueuePresentKHR(graphicsQueue_, &presentInfo);
+    }
+    if (stats_) stats_->record(lumina::FrameStage::Submit, msBetween(recordEnd, Clock::now()));
+    if (encode && (results[1] == VK_ERROR_OUT_OF_DATE_KHR || results[1] == VK_ERROR_SURFACE_LOST_KHR)) {
+        encoder_.outOfDate = true;
     }
 
+    // The frame was submitted either way. SUBOPTIMAL also reports a preTransform the
+    // display has moved away from, unless the mismatch is ours (see presentTransform()).
     currentFrame_++;
+    if (results[0] == VK_ERROR_OUT_OF_DATE_KHR ||
+        (results[0] == VK_SUBOPTIMAL_KHR && swapchain_.transform == swapchain_.surfaceTransform)) {
+        return recreate(window_);
+    }
     return true;
 }
+void VulkanRenderer::waitIdle() {
+    if (device_ != VK_NULL_HANDLE) vkDeviceWaitIdle(device_);
+}
+
 void VulkanRenderer::setEffectParams(const EffectParams& params) {
     effectParams_ = params;
 }
+void VulkanRenderer::detachSurface() {
+    if (!initialized_) return;
+    vkDeviceWaitIdle(device_);
+    destroyEncoderOutput();
+    destroyRetired(true);
+    cleanupSwapchain();
+    if (surface_ != VK_NULL_HANDLE) {
+        vkDestroySurfaceKHR(instance_, surface_, nullptr);
+        surface_ = VK_NULL_HANDLE;
+    }
+    window_ = nullptr;
+}
+
 void VulkanRenderer::destroy() {
+    if (device_ != VK_NULL_HANDLE) vkDeviceWaitIdle(device_);
+
+    releaseImportedBuffers();
+    destroyYcbcrResources();
+    destroyEffectChainBuffer();
+    if (importDescriptorPool_ != VK_NULL_HANDLE) {
+        vkDestroyDescriptorPool(device_, importDescriptorPool_, nullptr);
+        importDescriptorPool_ = VK_NULL_HANDLE;
+    }
+    destroyUploadResources();
+
     // Destroy non-swapchain resources
     if (textureSampler_ != VK_NULL_HANDLE) {
         vkDestroySampler(device_, textureSampler_, nullptr);
@@ -165,18 +570,7 @@ void VulkanRenderer::destroy() {
         vkDestroyImage(device_, textureImage_, nullptr);
         textureImage_ = VK_NULL_HANDLE;
     }
-    if (textureMemory_ != VK_NULL_HANDLE) {
-        vkFreeMemory(device_, textureMemory_, nullptr);
-        textureMemory_ = VK_NULL_HANDLE;
-    }
-    if (staging_.buffer != VK_NULL_HANDLE) {
-        vkDestroyBuffer(device_, staging_.buffer, nullptr);
-        staging_.buffer = VK_NULL_HANDLE;
-    }
-    if (staging_.memory != VK_NULL_HANDLE) {
-        vkFreeMemory(device_, staging_.memory, nullptr);
-        staging_.memory = VK_NULL_HANDLE;
-    }
+    freeMemory(textureMemory_);
     if (descriptorPool_ != VK_NULL_HANDLE) {
         vkDestroyDescriptorPool(device_, descriptorPool_, nullptr);
         descriptorPool_ = VK_NULL_HANDLE;
@@ -185,26 +579,66 @@ void VulkanRenderer::destroy() {
         vkDestroyDescriptorSetLayout(device_, descriptorSetLayout_, nullptr);
         descriptorSetLayout_ = VK_NULL_HANDLE;
     }
-    if (graphicsPipeline_ != VK_NULL_HANDLE) {
-        vkDestroyPipeline(device_, graphicsPipeline_, nullptr);
-        graphicsPipeline_ = VK_NULL_HANDLE;
+    if (chainSetLayout_ != VK_NULL_HANDLE) {
+        vkDestroyDescriptorSetLayout(device_, chainSetLayout_, nullptr);
+        chainSetLayout_ = VK_NULL_HANDLE;
+    }
+    if (inputAttachmentLayout_ != VK_NULL_HANDLE) {
+        vkDestroyDescriptorSetLayout(device_, inputAttachmentLayout_, nullptr);
+        inputAttachmentLayout_ = VK_NULL_HANDLE;
+    }
+    destroyAnalysisTargets();
+    destroyEncoderOutput();
+    if (analysisPipeline_ != VK_NULL_HANDLE) {
+        vkDestroyPipeline(device_, analysisPipeline_, nullptr);
+        analysisPipeline_ = VK_NULL_HANDLE;
     }
+    if (analysisRenderPass_ != VK_NULL_HANDLE) {
+        vkDestroyRenderPass(device_, analysisRenderPass_, nullptr);
+        analysisRenderPass_ = VK_NULL_HANDLE;
+    }
+    destroyPipelineVariants(false);
+    destroyPipelineCache();
     if (pipelineLayout_ != VK_NULL_HANDLE) {
         vkDestroyPipelineLayout(device_, pipelineLayout_, nullptr);
         pipelineLayout_ = VK_NULL_HANDLE;
     }
+    if (subpassPipelineLayout_ != VK_NULL_HANDLE) {
+        vkDestroyPipelineLayout(device_, subpassPipelineLayout_, nullptr);
+        subpassPipelineLayout_ = VK_NULL_HANDLE;
+    }
+    if (glassPipelineLayout_ != VK_NULL_HANDLE) {
+        vkDestroyPipelineLayout(device_, glassPipelineLayout_, nullptr);
+        glassPipelineLayout_ = VK_NULL_HANDLE;
+    }
     if (renderPass_ != VK_NULL_HANDLE) {
         vkDestroyRenderPass(device_, renderPass_, nullptr);
         renderPass_ = VK_NULL_HANDLE;
     }
+    if (offscreenRenderPass_ != VK_NULL_HANDLE) {
+        vkDestroyRenderPass(device_, offscreenRenderPass_, nullptr);
+        offscreenRenderPass_ = VK_NULL_HANDLE;
+    }
+    if (mergedRenderPass_ != VK_NULL_HANDLE) {
+        vkDestroyRenderPass(device_, mergedRenderPass_, nullptr);
+        mergedRenderPass_ = VK_NULL_HANDLE;
+    }
+    if (glassRenderPass_ != VK_NULL_HANDLE) {
+        vkDestroyRenderPass(device_, glassRenderPass_, nullptr);
+        glassRenderPass_ = VK_NULL_HANDLE;
+    }
 
+    destroyRetired(true);
     cleanupSwapchain();
+    destroyFrameResources();
 
     if (commandPool_ != VK_NULL_HANDLE) {
         vkDestroyCommandPool(device_, commandPool_, nullptr);
         commandPool_ = VK_NULL_HANDLE;
     }
 
+    destroyMemoryBlocks();
+
     if (device_ != VK_NULL_HANDLE) {
         vkDeviceWaitIdle(device_);
         vkDestroyDevice(device_, nullptr);
@@ -225,239 +659,812 @@ void VulkanRenderer::destroy() {
 }
 
 bool VulkanRenderer::recreate(ANativeWindow* window) {
+    if (!initialized_) return false;
+    if (!headless_ && surface_ != VK_NULL_HANDLE && swapchain_.swapchain != VK_NULL_HANDLE &&
+        (!window || window == window_)) {
+        return resizeSwapchain();
+    }
+
+    // A new window needs a new surface, and the old one cannot go while its swapchain
+    // may still be presenting.
     vkDeviceWaitIdle(device_);
+    destroyRetired(true);
     cleanupSwapchain();
     if (window) window_ = window;
     if (!createSurface(window_)) return false;
+    // The queue family was picked before any surface existed.
+    VkBool32 presentSupport = VK_FALSE;
+    vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice_, graphicsQueueFamily_, surface_, &presentSupport);
+    if (!presentSupport) {
+        LOGE("Graphics queue family %u cannot present to this surface", graphicsQueueFamily_);
+        return false;
+    }
     if (!createSwapchain()) return false;
     if (!createRenderPass()) return false;
     if (!createGraphicsPipeline()) return false;
     if (!createFramebuffers()) return false;
-    if (!createDescriptorPoolAndSets()) return false;
     if (!createSyncObjects()) return false;
-    if (!recordCommandBuffers()) return false;
     return true;
 }
 
-// Removed legacy parameterless render() - use render(const LuminaState&) instead.
+bool VulkanRenderer::resizeSwapchain() {
+    LUMINA_TRACE_SCOPE("Vulkan::resizeSwapchain");
+    // Frames in flight keep presenting and rendering into the old images; everything of
+    // theirs is retired instead of waited for.
+    const VkFormat format = swapchain_.format;
+    RetiredResources retired;
+    retireSwapchainResources(retired);
+    const bool created = createSwapchain(retired.swapchain);  // retires the old one even on failure
+    retired_.push_back(std::move(retired));
+    if (!created) return false;
+
+    if (swapchain_.format != format) {
+        // Render passes and every target are built for the format. Surfaces practically
+        // never change it, so simply wait rather than retire those too.
+        vkDeviceWaitIdle(device_);
+        destroyRetired(true);
+        destroyIntermediateTargets();
+        if (!createRenderPass() || !createGraphicsPipeline()) return false;
+    }
+    if (!createFramebuffers() || !createSyncObjects()) return false;
+    LOGI("Swapchain resized to %ux%u (%u quarter turns)", swapchain_.width, swapchain_.height,
+         swapchain_.quarterTurns);
+    return true;
+}
 
-bool VulkanRenderer::recordCommandBuffer(uint32_t imageIndex) {
-        if (imageIndex >= swapchain_.commandBuffers.size()) return false;
+void VulkanRenderer::beginFrameCommands(FrameResources& frame, uint32_t frameSlot) {
+    if (frame.timestamps != VK_NULL_HANDLE) {
+        vkCmdResetQueryPool(frame.cmd, frame.timestamps, 0, kTimestampsPerFrame);
+        vkCmdWriteTimestamp(frame.cmd, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, frame.timestamps, 0);
+    }
 
-        VkCommandBuffer cmd = swapchain_.commandBuffers[imageIndex];
-        vkResetCommandBuffer(cmd, 0);
+    // Imported camera buffers are written by the camera HAL; acquire them from the
+    // foreign queue family before sampling.
+    ImportedBuffer* source = (activeImport_ >= 0) ? &imports_[static_cast<size_t>(activeImport_)] : nullptr;
+    if (source) {
+        auto acquire = makeStruct<VkImageMemoryBarrier>(VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER);
+        acquire.srcAccessMask = 0;
+        acquire.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+        acquire.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        acquire.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        acquire.srcQueueFamilyIndex = VK_QUEUE_FAMILY_FOREIGN_EXT;
+        acquire.dstQueueFamilyIndex = graphicsQueueFamily_;
+        acquire.image = source->image;
+        acquire.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        acquire.subresourceRange.levelCount = 1;
+        acquire.subresourceRange.layerCount = 1;
+        vkCmdPipelineBarrier(frame.cmd,
+                             VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                             VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                             0,
+                             0, nullptr,
+                             0, nullptr,
+                             1, &acquire);
+        source->lastUsedFrame = currentFrame_;
+    }
 
-        auto bi = makeStruct<VkCommandBufferBeginInfo>(VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO);
-        bi.flags = VK_COMMAND_BUFFER_USAGE_SIMULTANEOUS_USE_BIT;
-        if (vkBeginCommandBuffer(cmd, &bi) != VK_SUCCESS) {
-            LOGE("vkBeginCommandBuffer failed for idx %u", imageIndex);
-            return false;
-        }
+    // Otherwise sample the newest staged upload, or the placeholder before the first frame.
+    UploadSlot* staged = (!source && readySlot_ >= 0) ? &uploadRing_[static_cast<size_t>(readySlot_)] : nullptr;
+    if (staged) staged->lastUsedFrame = currentFrame_;
 
-        VkClearValue clear{};
-        clear.color = { {0.05f, 0.07f, 0.10f, 1.0f} };
-
-        auto rp = makeStruct<VkRenderPassBeginInfo>(VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO);
-        rp.renderPass = renderPass_;
-        rp.framebuffer = framebuffers_[imageIndex];
-        rp.renderArea.offset = {0, 0};
-        rp.renderArea.extent = { swapchain_.width, swapchain_.height };
-        rp.clearValueCount = 1;
-        rp.pClearValues = &clear;
-
-        vkCmdBeginRenderPass(cmd, &rp, VK_SUBPASS_CONTENTS_INLINE);
-        vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, graphicsPipeline_);
-
-        VkViewport viewport{};
-        viewport.x = 0;
-        viewport.y = 0;
-        viewport.width = static_cast<float>(swapchain_.width);
-        viewport.height = static_cast<float>(swapchain_.height);
-        viewport.minDepth = 0.f;
-        viewport.maxDepth = 1.f;
-        vkCmdSetViewport(cmd, 0, 1, &viewport);
-
-        VkRect2D scissor{ {0,0}, { swapchain_.width, swapchain_.height } };
-        vkCmdSetScissor(cmd, 0, 1, &scissor);
+    frame.ycbcrInput = source && source->ycbcr;
+    frame.input = source ? source->descriptorSet
+                : staged ? staged->descriptorSet
+                : descriptorSets_[frameSlot];
+}
 
-        vkCmdPushConstants(cmd, pipelineLayout_, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(EffectParams), &effectParams_);
+bool VulkanRenderer::recordPass(FrameResources& frame, uint32_t frameSlot, uint32_t p, uint32_t imageIndex) {
+    VkCommandBuffer cmd = frame.cmd;
+    const uint32_t passCount = std::max(frame.graph.passCount, 1u);
+    const lumina::EffectPass& pass = frame.graph.passes[p];
+    const bool lastPass = (p + 1 == passCount);
+    const IntermediateTarget& target = targets_[p % 2];
+
+    VkClearValue clear{};
+    clear.color = { {0.05f, 0.07f, 0.10f, 1.0f} };
+
+    // Each pass reads the previous one's target; the last pass writes the swapchain,
+    // upscaling when the targets are rendered at a reduced scale.
+    const VkExtent2D extent = lastPass ? VkExtent2D{ swapchain_.width, swapchain_.height } : renderExtent_;
+    const VkExtent2D resolution = lastPass ? surfaceExtent() : renderExtent_;
+    auto rp = makeStruct<VkRenderPassBeginInfo>(VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO);
+    rp.renderPass = lastPass ? renderPass_ : offscreenRenderPass_;
+    rp.framebuffer = lastPass ? framebuffers_[imageIndex] : target.framebuffer;
+    rp.renderArea.offset = {0, 0};
+    rp.renderArea.extent = extent;
+    rp.clearValueCount = lastPass ? 1 : 0;
+    rp.pClearValues = lastPass ? &clear : nullptr;
+
+    const bool ycbcrPass = frame.ycbcrInput && p == 0;
+    VkPipelineLayout layout = ycbcrPass ? ycbcr_.pipelineLayout : pipelineLayout_;
+    VkPipeline pipeline = pipelineVariant(frame, pass, lastPass, ycbcrPass);
+    if (pipeline == VK_NULL_HANDLE) return false;
+
+    VkDescriptorSet input = p == 0 ? frame.input : targets_[(p - 1) % 2].descriptorSet;
+    const float pyramidOffset = recordPyramid(frame, pass, input);
+
+    vkCmdBeginRenderPass(cmd, &rp, VK_SUBPASS_CONTENTS_INLINE);
+    drawPass(frame, frameSlot, pass, extent, resolution, layout, pipeline, input, pyramidOffset);
+    vkCmdEndRenderPass(cmd);
+    if (frame.timestamps != VK_NULL_HANDLE) {
+        vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.timestamps, p + 1);
+    }
+    return true;
+}
 
-        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout_, 0, 1, &descriptorSets_[imageIndex], 0, nullptr);
-        vkCmdDraw(cmd, 4, 1, 0, 0);
+bool VulkanRenderer::resolveSurfacePipelines(const FrameResources& frame, bool mergedTail) {
+    // The same variants recordPass() and recordMergedTail() look up after acquire.
+    const uint32_t passCount = std::max(frame.graph.passCount, 1u);
+    if (mergedTail) {
+        const uint32_t first = passCount - 2;
+        return pipelineVariant(frame, frame.graph.passes[first], false, frame.ycbcrInput && first == 0, true) != VK_NULL_HANDLE &&
+               pipelineVariant(frame, frame.graph.passes[passCount - 1], true, false, true) != VK_NULL_HANDLE;
+    }
+    const uint32_t last = passCount - 1;
+    return pipelineVariant(frame, frame.graph.passes[last], true, frame.ycbcrInput && last == 0) != VK_NULL_HANDLE;
+}
 
-        vkCmdEndRenderPass(cmd);
+void VulkanRenderer::abandonAcquiredFrame(FrameResources& frame, uint32_t frameSlot, bool encode) {
+    // An empty batch consumes the acquire semaphores so the next acquire on this slot
+    // cannot reuse a signalled one, and signals the slot fence render() waits on next.
+    // The images themselves cannot be released without presenting, so both swapchains
+    // are rebuilt before the next frame.
+    std::array<VkSemaphore, 2> waits{};
+    std::array<VkPipelineStageFlags, 2> stages{};
+    uint32_t waitCount = 0;
+    if (!headless_) {
+        waits[waitCount] = frame.imageAvailable;
+        stages[waitCount++] = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        swapchain_.outOfDate = true;
+    }
+    if (encode) {
+        waits[waitCount] = encoder_.acquired[frameSlot];
+        stages[waitCount++] = VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT;
+        encoder_.outOfDate = true;
+    }
+    vkResetFences(device_, 1, &frame.inFlight);
+    auto submit = makeStruct<VkSubmitInfo>(VK_STRUCTURE_TYPE_SUBMIT_INFO);
+    submit.waitSemaphoreCount = waitCount;
+    submit.pWaitSemaphores = waits.data();
+    submit.pWaitDstStageMask = stages.data();
+    if (vkQueueSubmit(graphicsQueue_, 1, &submit, frame.inFlight) != VK_SUCCESS) {
+        LOGE("Failed to submit the wait batch for abandoned frame slot %u", frameSlot);
+    }
+}
 
-        if (vkEndCommandBuffer(cmd) != VK_SUCCESS) {
-            LOGE("vkEndCommandBuffer failed for idx %u", imageIndex);
-            return false;
-        }
-        return true;
+bool VulkanRenderer::recordMergedTail(FrameResources& frame, uint32_t frameSlot, uint32_t imageIndex) {
+    VkCommandBuffer cmd = frame.cmd;
+    const uint32_t last = frame.graph.passCount - 1;
+    const uint32_t first = last - 1;
+    const IntermediateTarget& tile = mergedTargets_[imageIndex];
+
+    const bool ycbcrPass = frame.ycbcrInput && first == 0;
+    VkPipelineLayout firstLayout = ycbcrPass ? ycbcr_.pipelineLayout : pipelineLayout_;
+    VkPipeline firstPipeline = pipelineVariant(frame, frame.graph.passes[first], false, ycbcrPass, true);
+    VkPipeline lastPipeline = pipelineVariant(frame, frame.graph.passes[last], true, false, true);
+    if (firstPipeline == VK_NULL_HANDLE || lastPipeline == VK_NULL_HANDLE) return false;
+
+    // Attachment 0 is the on-chip intermediate (never loaded), 1 the surface.
+    std::array<VkClearValue, 2> clears{};
+    clears[1].color = { {0.05f, 0.07f, 0.10f, 1.0f} };
+
+    auto rp = makeStruct<VkRenderPassBeginInfo>(VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO);
+    rp.renderPass = mergedRenderPass_;
+    rp.framebuffer = tile.framebuffer;
+    rp.renderArea.offset = {0, 0};
+    rp.renderArea.extent = { swapchain_.width, swapchain_.height };
+    rp.clearValueCount = static_cast<uint32_t>(clears.size());
+    rp.pClearValues = clears.data();
+
+    VkDescriptorSet input = first == 0 ? frame.input : targets_[(first - 1) % 2].descriptorSet;
+    const float pyramidOffset = recordPyramid(frame, frame.graph.passes[first], input);
+    vkCmdBeginRenderPass(cmd, &rp, VK_SUBPASS_CONTENTS_INLINE);
+    const VkExtent2D resolution = surfaceExtent();
+    drawPass(frame, frameSlot, frame.graph.passes[first], rp.renderArea.extent, resolution, firstLayout,
+             firstPipeline, input, pyramidOffset);
+    vkCmdNextSubpass(cmd, VK_SUBPASS_CONTENTS_INLINE);
+    drawPass(frame, frameSlot, frame.graph.passes[last], rp.renderArea.extent, resolution, subpassPipelineLayout_,
+             lastPipeline, tile.descriptorSet);
+    vkCmdEndRenderPass(cmd);
+    if (frame.timestamps != VK_NULL_HANDLE) {
+        // Tilers interleave the subpasses per tile, so the pair is timed as one: the
+        // first pass reports the whole render pass and the second close to zero.
+        vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.timestamps, first + 1);
+        vkCmdWriteTimestamp(cmd, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, frame.timestamps, last + 1);
     }
+    return true;
+}
 
-bool VulkanRenderer::createInstance() {
-    uint32_t extCount = 0;
-    vkEnumerateInstanceExtensionProperties(nullptr, &extCount, nullptr);
-    std::vector<VkExtensionProperties> exts(extCount);
-    vkEnumerateInstanceExtensionProperties(nullptr, &extCount, exts.data());
+void VulkanRenderer::drawPass(FrameResources& frame, uint32_t frameSlot, const lumina::EffectPass& pass,
+                              VkExtent2D extent, VkExtent2D resolution, VkPipelineLayout layout,
+                              VkPipeline pipeline, VkDescriptorSet input, float pyramidOffset) {
+    VkCommandBuffer cmd = frame.cmd;
+    const uint32_t chainOffset = static_cast<uint32_t>(chainStride_ * frameSlot);
 
-    if (!hasExtension(exts, VK_KHR_SURFACE_EXTENSION_NAME) ||
-        !hasExtension(exts, VK_KHR_ANDROID_SURFACE_EXTENSION_NAME)) {
-        LOGE("Required Vulkan surface extensions not available");
-        return false;
+    VkViewport viewport{};
+    viewport.x = 0;
+    viewport.y = 0;
+    viewport.width = static_cast<float>(extent.width);
+    viewport.height = static_cast<float>(extent.height);
+    viewport.minDepth = 0.f;
+    viewport.maxDepth = 1.f;
+    VkRect2D scissor{ {0,0}, extent };
+
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
+    vkCmdSetScissor(cmd, 0, 1, &scissor);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 1, &input, 0, nullptr);
+    if (layout != subpassPipelineLayout_) {
+        // Shaders that can read the pyramid need set 2 bound even when this pass has
+        // none; the placeholder stands in and the zero offset keeps it unread.
+        VkDescriptorSet pyramid = pyramidOffset > 0.0f ? pyramid_[0].descriptorSet : descriptorSets_[frameSlot];
+        vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 2, 1, &pyramid, 0, nullptr);
     }
 
-    const char* requiredExts[] = {
-        VK_KHR_SURFACE_EXTENSION_NAME,
-        VK_KHR_ANDROID_SURFACE_EXTENSION_NAME
+    PassPushConstants push{};
+    push.time = frame.params.time;
+    if (pass.head == lumina::EffectType::NONE) {
+        push.opCount = pass.opCount;
+        for (uint8_t i = 0; i < pass.opCount; ++i) {
+            push.opSlots |= static_cast<uint32_t>(pass.ops[i]) << (8 * i);
+        }
+    } else {
+        push.opSlots = pass.headSlot;
+    }
+    push.exposure = frame.params.exposure;
+    // Texel offsets are in the pass's own pixels, which shrink with the render scale;
+    // a pre-rotated surface pass still counts them in the window's orientation.
+    push.resolution[0] = static_cast<float>(resolution.width);
+    push.resolution[1] = static_cast<float>(resolution.height);
+    push.pyramidOffset = pyramidOffset;
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 1, 1, &chainSet_, 1, &chainOffset);
+    vkCmdPushConstants(cmd, layout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(push), &push);
+
+    vkCmdDraw(cmd, 4, 1, 0, 0);
+}
+
+float VulkanRenderer::recordPyramid(FrameResources& frame, const lumina::EffectPass& pass, VkDescriptorSet input) {
+    if (pass.pyramidSlot == lumina::kNoPyramid) return 0.0f;
+    const lumina::EffectParams& effect = frame.effects[pass.pyramidSlot];
+    // Radii are in surface pixels; the pyramid starts at the render scale.
+    const float radius = lumina::effectBlurRadius(effect, frame.uiStyle) * static_cast<float>(renderExtent_.width) /
+                         static_cast<float>(std::max(surfaceExtent().width, 1u));
+    const lumina::BlurPlan plan = lumina::planBlur(radius, renderExtent_.width, renderExtent_.height);
+    const uint32_t levels = std::min(plan.levels, pyramidLevels_);
+    if (levels == 0) return 0.0f;
+
+    const bool bloom = effect.type == lumina::EffectType::BLOOM;
+    VkPipeline down = pyramidPipeline(lumina::PyramidStage::Down);
+    VkPipeline prefilter = bloom ? pyramidPipeline(lumina::PyramidStage::Prefilter) : down;
+    VkPipeline up = levels > 1 ? pyramidPipeline(lumina::PyramidStage::Up) : down;
+    if (down == VK_NULL_HANDLE || prefilter == VK_NULL_HANDLE || up == VK_NULL_HANDLE) return 0.0f;
+
+    // Every stage is its own offscreen render pass, whose dependencies order the write
+    // of a level before the next stage samples it.
+    VkCommandBuffer cmd = frame.cmd;
+    const PyramidPushConstants push{ plan.offset, lumina::bloomThreshold(effect) };
+    const auto stage = [&](VkPipeline pipeline, VkDescriptorSet source, const IntermediateTarget& target,
+                           uint32_t level) {
+        recordPyramidStage(cmd, pipeline, source, target, { plan.widths[level], plan.heights[level] }, push);
     };
 
-    auto app = makeStruct<VkApplicationInfo>(VK_STRUCTURE_TYPE_APPLICATION_INFO);
-    app.pApplicationName = "LuminaVS";
-    app.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
-    app.pEngineName = "LuminaEngine";
-    app.engineVersion = VK_MAKE_VERSION(1, 0, 0);
-    app.apiVersion = VK_API_VERSION_1_1;
+    stage(prefilter, input, pyramid_[0], 0);
+    for (uint32_t k = 1; k < levels; ++k) stage(down, pyramid_[k - 1].descriptorSet, pyramid_[k], k);
+    for (uint32_t k = levels - 1; k > 0; --k) stage(up, pyramid_[k].descriptorSet, pyramid_[k - 1], k - 1);
+    return plan.offset;
+}
 
-    auto ci = makeStruct<VkInstanceCreateInfo>(VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO);
-    ci.pApplicationInfo = &app;
-    ci.enabledExtensionCount = 2;
-    ci.ppEnabledExtensionNames = requiredExts;
+void VulkanRenderer::recordPyramidStage(VkCommandBuffer cmd, VkPipeline pipeline, VkDescriptorSet source,
+                                        const IntermediateTarget& target, VkExtent2D extent,
+                                        const PyramidPushConstants& push) {
+    auto rp = makeStruct<VkRenderPassBeginInfo>(VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO);
+    rp.renderPass = offscreenRenderPass_;
+    rp.framebuffer = target.framebuffer;
+    rp.renderArea.extent = extent;
 
-    VkResult res = vkCreateInstance(&ci, nullptr, &instance_);
-    if (res != VK_SUCCESS) {
-        LOGE("vkCreateInstance failed: %d", res);
-        return false;
-    }
-    return true;
+    VkViewport viewport{};
+    viewport.width = static_cast<float>(extent.width);
+    viewport.height = static_cast<float>(extent.height);
+    viewport.maxDepth = 1.f;
+    VkRect2D scissor{ {0, 0}, extent };
+
+    vkCmdBeginRenderPass(cmd, &rp, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
+    vkCmdSetScissor(cmd, 0, 1, &scissor);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipelineLayout_, 0, 1, &source, 0, nullptr);
+    vkCmdPushConstants(cmd, pipelineLayout_, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(push), &push);
+    vkCmdDraw(cmd, 4, 1, 0, 0);
+    vkCmdEndRenderPass(cmd);
 }
 
-bool VulkanRenderer::createSurface(ANativeWindow* window) {
-    if (surface_ != VK_NULL_HANDLE) {
-        vkDestroySurfaceKHR(instance_, surface_, nullptr);
-        surface_ = VK_NULL_HANDLE;
+VkPipeline VulkanRenderer::pyramidPipeline(lumina::PyramidStage stage) {
+    const uint64_t key = lumina::pyramidVariantKey(stage, 0, static_cast<uint32_t>(swapchain_.format));
+    auto it = pipelineVariants_.find(key);
+    if (it != pipelineVariants_.end()) return it->second;
+
+    const std::vector<uint32_t>& fragSpv = stage == lumina::PyramidStage::Up ? kBlurUpFragSpv
+                                         : stage == lumina::PyramidStage::Prefilter ? kBloomPrefilterFragSpv
+                                         : kBlurDownFragSpv;
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    if (!buildPipeline(pipelineLayout_, fragSpv, nullptr, pipeline, offscreenRenderPass_)) return VK_NULL_HANDLE;
+    pipelineVariants_.emplace(key, pipeline);
+    return pipeline;
+}
+
+bool VulkanRenderer::resolveGlassPipelines(const FrameResources& frame) {
+    if (headless_ || frame.glass.count == 0 || glassLevels_ == 0 || glassRenderPass_ == VK_NULL_HANDLE) return false;
+    return pyramidPipeline(lumina::PyramidStage::Down) != VK_NULL_HANDLE &&
+           pyramidPipeline(lumina::PyramidStage::Up) != VK_NULL_HANDLE && glassPipeline() != VK_NULL_HANDLE;
+}
+
+VkPipeline VulkanRenderer::glassPipeline() {
+    const uint64_t key = lumina::glassVariantKey(swapchain_.quarterTurns, static_cast<uint32_t>(swapchain_.format));
+    auto it = pipelineVariants_.find(key);
+    if (it != pipelineVariants_.end()) return it->second;
+
+    // Drawn over the surface image, pre-rotated like the surface pass.
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    if (!buildPipeline(glassPipelineLayout_, kGlassFragSpv, nullptr, pipeline, glassRenderPass_, 0,
+                       swapchain_.quarterTurns, true)) {
+        return VK_NULL_HANDLE;
     }
+    pipelineVariants_.emplace(key, pipeline);
+    return pipeline;
+}
 
-    if (!window) {
-        LOGW("No native window provided for surface creation" );
-        return false;
+void VulkanRenderer::recordGlass(FrameResources& frame, uint32_t imageIndex) {
+    // Radii are in surface pixels; the pyramid starts at the render scale.
+    const float radius = frame.uiStyle.blurRadius * static_cast<float>(glassExtent_.width) /
+                         static_cast<float>(std::max(swapchain_.width, 1u));
+    const lumina::BlurPlan plan = lumina::planBlur(radius, glassExtent_.width, glassExtent_.height);
+    const uint32_t levels = std::min(plan.levels, glassLevels_);
+    if (levels == 0) return;
+
+    VkCommandBuffer cmd = frame.cmd;
+    VkImage display = swapchain_.images[imageIndex];
+    VkImage base = glassPyramid_[0].image;
+
+    // The surface pass, or the encoder copy after it, left the image ready to present.
+    // Level 0 was last read by the previous frame's glass, and its old contents go.
+    const std::array<VkImageMemoryBarrier, 2> toTransfer = {
+        imageBarrier(display, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+                     VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL),
+        imageBarrier(base, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_TRANSFER_WRITE_BIT,
+                     VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL),
+    };
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT |
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr,
+                         static_cast<uint32_t>(toTransfer.size()), toTransfer.data());
+
+    // The filtered blit stands in for the first downsample; the rest runs as for BLUR.
+    VkImageBlit region{};
+    region.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    region.srcOffsets[1] = { static_cast<int32_t>(swapchain_.width), static_cast<int32_t>(swapchain_.height), 1 };
+    region.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    region.dstOffsets[1] = { static_cast<int32_t>(plan.widths[0]), static_cast<int32_t>(plan.heights[0]), 1 };
+    vkCmdBlitImage(cmd, display, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, base, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                   1, &region, glassFilter_);
+
+    const VkImageMemoryBarrier toSampled = imageBarrier(base, VK_ACCESS_TRANSFER_WRITE_BIT, VK_ACCESS_SHADER_READ_BIT,
+                                                        VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                                                        VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL);
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT, 0,
+                         0, nullptr, 0, nullptr, 1, &toSampled);
+
+    const PyramidPushConstants stagePush{ plan.offset, 0.0f };
+    VkPipeline down = pyramidPipeline(lumina::PyramidStage::Down);
+    VkPipeline up = pyramidPipeline(lumina::PyramidStage::Up);
+    for (uint32_t k = 1; k < levels; ++k) {
+        recordPyramidStage(cmd, down, glassPyramid_[k - 1].descriptorSet, glassPyramid_[k],
+                           { plan.widths[k], plan.heights[k] }, stagePush);
+    }
+    for (uint32_t k = levels - 1; k > 0; --k) {
+        recordPyramidStage(cmd, up, glassPyramid_[k].descriptorSet, glassPyramid_[k - 1],
+                           { plan.widths[k - 1], plan.heights[k - 1] }, stagePush);
     }
 
-    window_ = window;
+    // One draw per panel, scissored to it; the pass leaves the image ready to present.
+    const VkExtent2D extent{ swapchain_.width, swapchain_.height };
+    const VkExtent2D shown = surfaceExtent();
+    auto rp = makeStruct<VkRenderPassBeginInfo>(VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO);
+    rp.renderPass = glassRenderPass_;
+    rp.framebuffer = framebuffers_[imageIndex];
+    rp.renderArea.extent = extent;
 
-    auto ci = makeStruct<VkAndroidSurfaceCreateInfoKHR>(VK_STRUCTURE_TYPE_ANDROID_SURFACE_CREATE_INFO_KHR);
-    ci.window = window;
-    VkResult res = vkCreateAndroidSurfaceKHR(instance_, &ci, nullptr, &surface_);
-    if (res != VK_SUCCESS) {
-        LOGE("vkCreateAndroidSurfaceKHR failed: %d", res);
-        return false;
+    VkViewport viewport{};
+    viewport.width = static_cast<float>(extent.width);
+    viewport.height = static_cast<float>(extent.height);
+    viewport.maxDepth = 1.f;
+
+    GlassPushConstants push{};
+    push.resolution[0] = static_cast<float>(shown.width);
+    push.resolution[1] = static_cast<float>(shown.height);
+    push.framebuffer[0] = static_cast<float>(extent.width);
+    push.framebuffer[1] = static_cast<float>(extent.height);
+    push.offset = plan.offset;
+    push.saturation = frame.uiStyle.saturation;
+    push.brightness = frame.uiStyle.brightness;
+
+    vkCmdBeginRenderPass(cmd, &rp, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, glassPipeline());
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, glassPipelineLayout_, 0, 1,
+                            &glassPyramid_[0].descriptorSet, 0, nullptr);
+    for (uint32_t i = 0; i < frame.glass.count; ++i) {
+        const lumina::GlassPanel& panel = frame.glass.panels[i];
+        const lumina::PixelRect rect = lumina::glassScissor(panel, swapchain_.quarterTurns, extent.width, extent.height);
+        if (rect.width == 0 || rect.height == 0) continue;
+        const VkRect2D scissor{ { rect.x, rect.y }, { rect.width, rect.height } };
+        vkCmdSetScissor(cmd, 0, 1, &scissor);
+        push.rect[0] = panel.left * shown.width;
+        push.rect[1] = panel.top * shown.height;
+        push.rect[2] = panel.right * shown.width;
+        push.rect[3] = panel.bottom * shown.height;
+        push.cornerRadius = lumina::glassCornerRadius(panel, shown.width, shown.height);
+        vkCmdPushConstants(cmd, glassPipelineLayout_, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(push), &push);
+        vkCmdDraw(cmd, 4, 1, 0, 0);
     }
-    return true;
+    vkCmdEndRenderPass(cmd);
 }
 
-uint32_t VulkanRenderer::findGraphicsQueueFamily(VkPhysicalDevice device) {
-    uint32_t count = 0;
-    vkGetPhysicalDeviceQueueFamilyProperties(device, &count, nullptr);
-    std::vector<VkQueueFamilyProperties> props(count);
-    vkGetPhysicalDeviceQueueFamilyProperties(device, &count, props.data());
-    for (uint32_t i = 0; i < count; ++i) {
-        if (props[i].queueCount > 0 && (props[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
-            VkBool32 presentSupport = VK_FALSE;
-            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
-            if (presentSupport) return i;
-        }
+uint64_t VulkanRenderer::completedFrames() const {
+    // Everything frameRetired() already vouches for, then the frames still in flight
+    // whose fences have signalled since, oldest first.
+    uint64_t completed = currentFrame_ > kMaxFramesInFlight ? currentFrame_ - kMaxFramesInFlight : 0;
+    for (; completed < currentFrame_; ++completed) {
+        const VkFence fence = frames_[completed % kMaxFramesInFlight].inFlight;
+        if (fence == VK_NULL_HANDLE || vkGetFenceStatus(device_, fence) != VK_SUCCESS) break;
     }
-    return UINT32_MAX;
+    return completed;
 }
 
-bool VulkanRenderer::pickPhysicalDevice() {
-    uint32_t deviceCount = 0;
-    vkEnumeratePhysicalDevices(instance_, &deviceCount, nullptr);
-    if (deviceCount == 0) {
-        LOGE("No Vulkan physical devices found");
-        return false;
+uint64_t VulkanRenderer::completedUploads() const {
+    // Uploads execute in submission order on the transfer queue, so the newest slot whose
+    // fence has signalled vouches for every earlier value as well.
+    uint64_t completed = 0;
+    for (const auto& slot : uploadRing_) {
+        if (slot.fence == VK_NULL_HANDLE || slot.readyValue <= completed) continue;
+        if (vkGetFenceStatus(device_, slot.fence) == VK_SUCCESS) completed = slot.readyValue;
     }
-    std::vector<VkPhysicalDevice> devices(deviceCount);
-    vkEnumeratePhysicalDevices(instance_, &deviceCount, devices.data());
+    return completed;
+}
 
-    for (auto dev : devices) {
-        uint32_t q = findGraphicsQueueFamily(dev);
-        if (q != UINT32_MAX) {
-            physicalDevice_ = dev;
-            graphicsQueueFamily_ = q;
-            return true;
-        }
+uint32_t VulkanRenderer::framesInFlight() const {
+    uint32_t pending = 0;
+    for (const auto& frame : frames_) {
+        if (frame.inFlight != VK_NULL_HANDLE && vkGetFenceStatus(device_, frame.inFlight) == VK_NOT_READY) ++pending;
     }
-    LOGE("No suitable graphics+present queue family found");
-    return false;
+    return pending;
 }
 
-bool VulkanRenderer::createDevice() {
-    float priority = 1.0f;
-    auto qci = makeStruct<VkDeviceQueueCreateInfo>(VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO);
-    qci.queueFamilyIndex = graphicsQueueFamily_;
-    qci.queueCount = 1;
-    qci.pQueuePriorities = &priority;
+void VulkanRenderer::collectGpuTimings(FrameResources& frame) {
+    // Called after the slot's fence wait, so the results are already available.
+    const uint32_t count = frame.timestampCount;
+    frame.timestampCount = 0;
+    if (!stats_ || count < 2) return;
 
-    const char* deviceExts[] = { VK_KHR_SWAPCHAIN_EXTENSION_NAME };
+    std::array<uint64_t, kTimestampsPerFrame> ticks{};
+    if (vkGetQueryPoolResults(device_, frame.timestamps, 0, count, sizeof(ticks), ticks.data(),
+                              sizeof(uint64_t), VK_QUERY_RESULT_64_BIT) != VK_SUCCESS) {
+        return;
+    }
+    std::array<float, lumina::kMaxEffectPasses> passMs{};
+    for (uint32_t i = 0; i + 1 < count; ++i) {
+        const uint64_t delta = ((ticks[i + 1] & timestampMask_) - (ticks[i] & timestampMask_)) & timestampMask_;
+        passMs[i] = static_cast<float>(static_cast<double>(delta) * timestampPeriod_ * 1e-6);
+    }
+    stats_->recordGpuPasses(passMs.data(), count - 1);
+}
 
-    auto ci = makeStruct<VkDeviceCreateInfo>(VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO);
-    ci.queueCreateInfoCount = 1;
-    ci.pQueueCreateInfos = &qci;
-    ci.enabledExtensionCount = 1;
-    ci.ppEnabledExtensionNames = deviceExts;
+bool VulkanRenderer::ensureAnalysisTargets() {
+    if (analysisConfig_ != analysisTarget_) {
+        // Frames still in flight render into and copy out of the current targets.
+        vkQueueWaitIdle(graphicsQueue_);
+        destroyAnalysisTargets();
+        if (!analysisConfig_.enabled()) return false;
+
+        bool created = analysisRenderPass_ != VK_NULL_HANDLE || createAnalysisRenderPass();
+        analysisTarget_ = analysisConfig_;
+        for (auto& target : analysisTargets_) created = created && createAnalysisTarget(target);
+        if (!created) {
+            LOGE("Failed to create %ux%u analysis targets; analysis output disabled",
+                 analysisConfig_.width, analysisConfig_.height);
+            destroyAnalysisTargets();
+            analysisConfig_ = lumina::AnalysisConfig{};
+            return false;
+        }
+    }
+    return analysisTarget_.enabled();
+}
 
-    VkResult res = vkCreateDevice(physicalDevice_, &ci, nullptr, &device_);
+bool VulkanRenderer::createAnalysisRenderPass() {
+    VkAttachmentDescription colorAttach{};
+    colorAttach.format = VK_FORMAT_R8G8B8A8_UNORM;
+    colorAttach.samples = VK_SAMPLE_COUNT_1_BIT;
+    colorAttach.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE; // every texel is written
+    colorAttach.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    colorAttach.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    colorAttach.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    colorAttach.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    colorAttach.finalLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+    VkAttachmentReference colorRef{};
+    colorRef.attachment = 0;
+    colorRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &colorRef;
+
+    std::array<VkSubpassDependency, 2> deps{};
+    deps[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    deps[0].dstSubpass = 0;
+    deps[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    deps[0].srcAccessMask = 0;
+    deps[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    deps[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    deps[1].srcSubpass = 0;
+    deps[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+    deps[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    deps[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    deps[1].dstStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+    deps[1].dstAccessMask = VK_ACCESS_TRANSFER_READ_BIT;
+
+    auto ci = makeStruct<VkRenderPassCreateInfo>(VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO);
+    ci.attachmentCount = 1;
+    ci.pAttachments = &colorAttach;
+    ci.subpassCount = 1;
+    ci.pSubpasses = &subpass;
+    ci.dependencyCount = static_cast<uint32_t>(deps.size());
+    ci.pDependencies = deps.data();
+    VkResult res = vkCreateRenderPass(device_, &ci, nullptr, &analysisRenderPass_);
     if (res != VK_SUCCESS) {
-        LOGE("vkCreateDevice failed: %d", res);
+        LOGE("vkCreateRenderPass for analysis failed: %d", res);
+        analysisRenderPass_ = VK_NULL_HANDLE;
         return false;
     }
-    vkGetDeviceQueue(device_, graphicsQueueFamily_, 0, &graphicsQueue_);
     return true;
 }
 
-bool VulkanRenderer::createCommandPool() {
-    auto ci = makeStruct<VkCommandPoolCreateInfo>(VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO);
-    ci.queueFamilyIndex = graphicsQueueFamily_;
-    ci.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
-    VkResult res = vkCreateCommandPool(device_, &ci, nullptr, &commandPool_);
-    if (res != VK_SUCCESS) {
-        LOGE("vkCreateCommandPool failed: %d", res);
+bool VulkanRenderer::createAnalysisTarget(AnalysisTarget& target) {
+    const uint32_t width = lumina::analysisTargetWidth(analysisTarget_);
+    const uint32_t height = analysisTarget_.height;
+
+    auto ci = makeStruct<VkImageCreateInfo>(VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO);
+    ci.imageType = VK_IMAGE_TYPE_2D;
+    ci.extent = { width, height, 1 };
+    ci.mipLevels = 1;
+    ci.arrayLayers = 1;
+    ci.format = VK_FORMAT_R8G8B8A8_UNORM;
+    ci.tiling = VK_IMAGE_TILING_OPTIMAL;
+    ci.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    ci.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+    ci.samples = VK_SAMPLE_COUNT_1_BIT;
+    ci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateImage(device_, &ci, nullptr, &target.image) != VK_SUCCESS) return false;
+
+    if (!allocateImageMemory(target.image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0,
+                             lumina::GpuMemoryCategory::Targets, target.memory)) {
+        return false;
+    }
+
+    auto vi = makeStruct<VkImageViewCreateInfo>(VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO);
+    vi.image = target.image;
+    vi.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    vi.format = VK_FORMAT_R8G8B8A8_UNORM;
+    vi.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    vi.subresourceRange.levelCount = 1;
+    vi.subresourceRange.layerCount = 1;
+    if (vkCreateImageView(device_, &vi, nullptr, &target.view) != VK_SUCCESS) return false;
+
+    auto fi = makeStruct<VkFramebufferCreateInfo>(VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO);
+    fi.renderPass = analysisRenderPass_;
+    fi.attachmentCount = 1;
+    fi.pAttachments = &target.view;
+    fi.width = width;
+    fi.height = height;
+    fi.layers = 1;
+    if (vkCreateFramebuffer(device_, &fi, nullptr, &target.framebuffer) != VK_SUCCESS) return false;
+
+    auto bi = makeStruct<VkBufferCreateInfo>(VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO);
+    bi.size = lumina::analysisFrameBytes(analysisTarget_);
+    bi.usage = VK_BUFFER_USAGE_TRANSFER_DST_BIT;
+    bi.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(device_, &bi, nullptr, &target.readback) != VK_SUCCESS) return false;
+
+    // CPU reads of uncached (write-combined) memory are slow; prefer cached and
+    // invalidate before reading.
+    if (!allocateBufferMemory(target.readback, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT, VK_MEMORY_PROPERTY_HOST_CACHED_BIT,
+                              lumina::GpuMemoryCategory::Readback, target.readbackMemory)) {
+        return false;
+    }
+    target.mapped = target.readbackMemory.mapped;
+    return true;
+}
+
+void VulkanRenderer::destroyAnalysisTargets() {
+    for (auto& target : analysisTargets_) {
+        if (target.framebuffer != VK_NULL_HANDLE) vkDestroyFramebuffer(device_, target.framebuffer, nullptr);
+        if (target.view != VK_NULL_HANDLE) vkDestroyImageView(device_, target.view, nullptr);
+        if (target.image != VK_NULL_HANDLE) vkDestroyImage(device_, target.image, nullptr);
+        freeMemory(target.memory);
+        if (target.readback != VK_NULL_HANDLE) vkDestroyBuffer(device_, target.readback, nullptr);
+        freeMemory(target.readbackMemory);
+        target = AnalysisTarget{};
+    }
+    analysisTarget_ = lumina::AnalysisConfig{};
+}
+
+VkPipeline VulkanRenderer::analysisPipeline(bool ycbcr) {
+    static_assert(sizeof(AnalysisPushConstants) <= sizeof(PassPushConstants), "push range is sizeof(PassPushConstants)");
+    VkPipeline& pipeline = ycbcr ? ycbcr_.analysisPipeline : analysisPipeline_;
+    if (pipeline != VK_NULL_HANDLE) return pipeline;
+    VkPipelineLayout layout = ycbcr ? ycbcr_.pipelineLayout : pipelineLayout_;
+    if (layout == VK_NULL_HANDLE) return VK_NULL_HANDLE;
+    buildPipeline(layout, kAnalysisFragSpv, nullptr, pipeline, analysisRenderPass_);
+    return pipeline;
+}
+
+bool VulkanRenderer::recordAnalysisPass(FrameResources& frame, uint32_t frameSlot) {
+    // Samples the camera input (raw, before effects), like pass 0.
+    VkPipeline pipeline = analysisPipeline(frame.ycbcrInput);
+    if (pipeline == VK_NULL_HANDLE) return false;
+    VkPipelineLayout layout = frame.ycbcrInput ? ycbcr_.pipelineLayout : pipelineLayout_;
+    const AnalysisTarget& target = analysisTargets_[frameSlot];
+    const uint32_t width = lumina::analysisTargetWidth(analysisTarget_);
+    const uint32_t height = analysisTarget_.height;
+    VkCommandBuffer cmd = frame.cmd;
+
+    auto rp = makeStruct<VkRenderPassBeginInfo>(VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO);
+    rp.renderPass = analysisRenderPass_;
+    rp.framebuffer = target.framebuffer;
+    rp.renderArea.extent = { width, height };
+
+    VkViewport viewport{};
+    viewport.width = static_cast<float>(width);
+    viewport.height = static_cast<float>(height);
+    viewport.maxDepth = 1.f;
+    VkRect2D scissor{ {0, 0}, { width, height } };
+
+    AnalysisPushConstants push{};
+    push.size[0] = static_cast<float>(analysisTarget_.width);
+    push.size[1] = static_cast<float>(analysisTarget_.height);
+    push.gray = analysisTarget_.format == lumina::AnalysisFormat::GRAY ? 1u : 0u;
+
+    vkCmdBeginRenderPass(cmd, &rp, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
+    vkCmdSetScissor(cmd, 0, 1, &scissor);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 1, &frame.input, 0, nullptr);
+    vkCmdPushConstants(cmd, layout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(push), &push);
+    vkCmdDraw(cmd, 4, 1, 0, 0);
+    vkCmdEndRenderPass(cmd);
+
+    // Texels are already packed bytes, so the copy lands tightly packed, top row first.
+    VkBufferImageCopy region{};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = { width, height, 1 };
+    vkCmdCopyImageToBuffer(cmd, target.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, target.readback, 1, &region);
+
+    auto toHost = makeStruct<VkBufferMemoryBarrier>(VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER);
+    toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    toHost.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toHost.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toHost.buffer = target.readback;
+    toHost.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+                         0, nullptr, 1, &toHost, 0, nullptr);
+    return true;
+}
+
+void VulkanRenderer::collectAnalysisFrame(AnalysisTarget& target) {
+    // Called after the slot's fence wait, so the copy has landed.
+    if (!target.pending) return;
+    target.pending = false;
+    if (!analysisSink_ || !target.mapped) return;
+
+    const GpuAllocation& readback = target.readbackMemory;
+    if (!(readback.flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+        // Non-coherent allocations are whole atoms (see allocateMemory()), so this is legal
+        // even though the block goes on past it.
+        auto range = makeStruct<VkMappedMemoryRange>(VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE);
+        range.memory = readback.memory;
+        range.offset = readback.offset;
+        range.size = readback.size;
+        vkInvalidateMappedMemoryRanges(device_, 1, &range);
+    }
+    memcpy(analysisSink_->beginFrame(analysisTarget_), target.mapped, lumina::analysisFrameBytes(analysisTarget_));
+    analysisSink_->publish(target.frameNumber, target.timestampNs);
+}
+
+void VulkanRenderer::setEncoderWindow(ANativeWindow* window) {
+    if (window == encoder_.window) return;
+    // Frames in flight may still blit into or present the current encoder images.
+    waitIdle();
+    destroyEncoderOutput();
+    encoder_.window = window;
+    encoder_.failed = false;
+    if (swapchain_.swapchain != VK_NULL_HANDLE &&
+        presentTransform(swapchain_.surfaceTransform) != swapchain_.transform) {
+        swapchain_.outOfDate = true;
+    }
+}
+
+bool VulkanRenderer::ensureEncoderOutput() {
+    if (encoder_.outOfDate) {
+        vkQueueWaitIdle(graphicsQueue_);
+        destroyEncoderOutput();
+    }
+    if (!encoder_.window || encoder_.failed) return false;
+    if (encoder_.swapchain != VK_NULL_HANDLE) return true;
+
+    if (!createEncoderOutput()) {
+        LOGE("Encoder output unavailable; frames will not be recorded");
+        destroyEncoderOutput();
+        encoder_.failed = true;
         return false;
     }
     return true;
 }
 
-bool VulkanRenderer::createSwapchain() {
+bool VulkanRenderer::createEncoderOutput() {
+    if (!(swapchain_.usage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT)) {
+        LOGW("Swapchain images cannot be copied from");
+        return false;
+    }
+
+    auto si = makeStruct<VkAndroidSurfaceCreateInfoKHR>(VK_STRUCTURE_TYPE_ANDROID_SURFACE_CREATE_INFO_KHR);
+    si.window = encoder_.window;
+    VkResult res = vkCreateAndroidSurfaceKHR(instance_, &si, nullptr, &encoder_.surface);
+    if (res != VK_SUCCESS) {
+        LOGE("vkCreateAndroidSurfaceKHR (encoder) failed: %d", res);
+        return false;
+    }
+
+    VkBool32 presentable = VK_FALSE;
+    vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice_, graphicsQueueFamily_, encoder_.surface, &presentable);
     VkSurfaceCapabilitiesKHR caps{};
-    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice_, surface_, &caps);
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice_, encoder_.surface, &caps);
+    if (!presentable || !(caps.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT)) {
+        LOGE("Encoder surface cannot be presented to or copied into");
+        return false;
+    }
 
+    // Same format as the display when offered, so the blit is a straight scaled copy.
     uint32_t formatCount = 0;
-    vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice_, surface_, &formatCount, nullptr);
+    vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice_, encoder_.surface, &formatCount, nullptr);
     std::vector<VkSurfaceFormatKHR> formats(formatCount);
-    vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice_, surface_, &formatCount, formats.data());
-
-    uint32_t presentCount = 0;
-    vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice_, surface_, &presentCount, nullptr);
-    std::vector<VkPresentModeKHR> presents(presentCount);
-    vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice_, surface_, &presentCount, presents.data());
-
+    vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice_, encoder_.surface, &formatCount, formats.data());
+    if (formats.empty()) return false;
     VkSurfaceFormatKHR chosenFormat = formats[0];
     for (const auto& f : formats) {
-        if (f.format == VK_FORMAT_R8G8B8A8_UNORM && f.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
+        if (f.format == swapchain_.format) {
             chosenFormat = f;
             break;
         }
     }
 
-    VkPresentModeKHR chosenPresent = VK_PRESENT_MODE_FIFO_KHR;
-    for (const auto& pm : presents) {
-        if (pm == VK_PRESENT_MODE_MAILBOX_KHR) { chosenPresent = pm; break; }
+    VkFormatProperties src{};
+    VkFormatProperties dst{};
+    vkGetPhysicalDeviceFormatProperties(physicalDevice_, swapchain_.format, &src);
+    vkGetPhysicalDeviceFormatProperties(physicalDevice_, chosenFormat.format, &dst);
+    if (!(src.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_SRC_BIT) ||
+        !(dst.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT)) {
+        LOGE("Cannot blit format %d into encoder format %d", swapchain_.format, chosenFormat.format);
+        return false;
     }
+    encoder_.filter = (src.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)
+        ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
 
-    VkExtent2D extent = caps.currentExtent;
-    if (extent.width == UINT32_MAX) {
-        extent.width = 1280;
-        extent.height = 720;
+    encoder_.extent = caps.currentExtent;
+    if (encoder_.extent.width == UINT32_MAX) {
+        encoder_.extent.width = static_cast<uint32_t>(ANativeWindow_getWidth(encoder_.window));
+        encoder_.extent.height = static_cast<uint32_t>(ANativeWindow_getHeight(encoder_.window));
     }
 
     uint32_t imageCount = caps.minImageCount + 1;
@@ -465,281 +1472,2027 @@ bool VulkanRenderer::createSwapchain() {
         imageCount = caps.maxImageCount;
     }
 
+    // FIFO: the encoder must see every frame in order, never a replaced one.
     auto ci = makeStruct<VkSwapchainCreateInfoKHR>(VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR);
-    ci.surface = surface_;
+    ci.surface = encoder_.surface;
     ci.minImageCount = imageCount;
     ci.imageFormat = chosenFormat.format;
     ci.imageColorSpace = chosenFormat.colorSpace;
-    ci.imageExtent = extent;
+    ci.imageExtent = encoder_.extent;
     ci.imageArrayLayers = 1;
-    ci.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT;
+    ci.imageUsage = VK_IMAGE_USAGE_TRANSFER_DST_BIT;
     ci.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    ci.preTransform = caps.currentTransform;
+    ci.preTransform = (caps.supportedTransforms & VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR)
+        ? VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR : caps.currentTransform;
     ci.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
-    ci.presentMode = chosenPresent;
+    ci.presentMode = VK_PRESENT_MODE_FIFO_KHR;
     ci.clipped = VK_TRUE;
-    ci.oldSwapchain = VK_NULL_HANDLE;
-
-    VkResult res = vkCreateSwapchainKHR(device_, &ci, nullptr, &swapchain_.swapchain);
+    res = vkCreateSwapchainKHR(device_, &ci, nullptr, &encoder_.swapchain);
     if (res != VK_SUCCESS) {
-        LOGE("vkCreateSwapchainKHR failed: %d", res);
+        LOGE("vkCreateSwapchainKHR (encoder) failed: %d", res);
         return false;
     }
 
-    uint32_t scImageCount = 0;
-    vkGetSwapchainImagesKHR(device_, swapchain_.swapchain, &scImageCount, nullptr);
-    swapchain_.images.resize(scImageCount);
-    vkGetSwapchainImagesKHR(device_, swapchain_.swapchain, &scImageCount, swapchain_.images.data());
-
-    swapchain_.width = extent.width;
-    swapchain_.height = extent.height;
-    swapchain_.format = chosenFormat.format;
-
-    swapchain_.commandBuffers.resize(scImageCount);
-    auto alloc = makeStruct<VkCommandBufferAllocateInfo>(VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO);
-    alloc.commandPool = commandPool_;
-    alloc.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    alloc.commandBufferCount = scImageCount;
-    VkResult ares = vkAllocateCommandBuffers(device_, &alloc, swapchain_.commandBuffers.data());
-    if (ares != VK_SUCCESS) {
-        LOGE("vkAllocateCommandBuffers failed: %d", ares);
-        return false;
+    uint32_t count = 0;
+    vkGetSwapchainImagesKHR(device_, encoder_.swapchain, &count, nullptr);
+    encoder_.images.resize(count);
+    vkGetSwapchainImagesKHR(device_, encoder_.swapchain, &count, encoder_.images.data());
+
+    auto sci = makeStruct<VkSemaphoreCreateInfo>(VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO);
+    encoder_.renderFinished.assign(count, VK_NULL_HANDLE);
+    for (auto& semaphore : encoder_.renderFinished) {
+        if (vkCreateSemaphore(device_, &sci, nullptr, &semaphore) != VK_SUCCESS) return false;
+    }
+    for (auto& semaphore : encoder_.acquired) {
+        if (vkCreateSemaphore(device_, &sci, nullptr, &semaphore) != VK_SUCCESS) return false;
     }
 
+    LOGI("Encoder swapchain ready: %ux%u, %u images", encoder_.extent.width, encoder_.extent.height, count);
     return true;
 }
 
-bool VulkanRenderer::createRenderPass() {
-    VkAttachmentDescription colorAttach{};
-    colorAttach.format = swapchain_.format;
-    colorAttach.samples = VK_SAMPLE_COUNT_1_BIT;
-    colorAttach.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
-    colorAttach.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
-    colorAttach.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
-    colorAttach.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
-    colorAttach.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    colorAttach.finalLayout = VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
-
-    VkAttachmentReference colorRef{};
-    colorRef.attachment = 0;
-    colorRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+void VulkanRenderer::destroyEncoderOutput() {
+    if (device_ != VK_NULL_HANDLE) {
+        for (auto semaphore : encoder_.renderFinished) {
+            if (semaphore != VK_NULL_HANDLE) vkDestroySemaphore(device_, semaphore, nullptr);
+        }
+        for (auto semaphore : encoder_.acquired) {
+            if (semaphore != VK_NULL_HANDLE) vkDestroySemaphore(device_, semaphore, nullptr);
+        }
+        if (encoder_.swapchain != VK_NULL_HANDLE) vkDestroySwapchainKHR(device_, encoder_.swapchain, nullptr);
+    }
+    if (encoder_.surface != VK_NULL_HANDLE && instance_ != VK_NULL_HANDLE) {
+        vkDestroySurfaceKHR(instance_, encoder_.surface, nullptr);
+    }
+    // The window stays attached; the swapchain is rebuilt on demand.
+    ANativeWindow* window = encoder_.window;
+    const bool failed = encoder_.failed;
+    encoder_ = EncoderOutput{};
+    encoder_.window = window;
+    encoder_.failed = failed;
+}
 
-    VkSubpassDescription subpass{};
-    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
-    subpass.colorAttachmentCount = 1;
-    subpass.pColorAttachments = &colorRef;
+VkPipeline VulkanRenderer::analysisPipeline(bool ycbcr) {
+    static_assert(sizeof(AnalysisPushConstants) <= sizeof(PassPushConstants), "push range is sizeof(PassPushConstants)");
+    VkPipeline& pipeline = ycbcr ? ycbcr_.analysisPipeline : analysisPipeline_;
+    if (pipeline != VK_NULL_HANDLE) return pipeline;
+    VkPipelineLayout layout = ycbcr ? ycbcr_.pipelineLayout : pipelineLayout_;
+    if (layout == VK_NULL_HANDLE) return VK_NULL_HANDLE;
+    buildPipeline(layout, kAnalysisFragSpv, nullptr, pipeline, analysisRenderPass_);
+    return pipeline;
+}
 
-    VkSubpassDependency dep{};
-    dep.srcSubpass = VK_SUBPASS_EXTERNAL;
-    dep.dstSubpass = 0;
-    dep.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dep.srcAccessMask = 0;
-    dep.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
-    dep.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+bool VulkanRenderer::recordAnalysisPass(FrameResources& frame, uint32_t frameSlot) {
+    // Samples the camera input (raw, before effects), like pass 0.
+    VkPipeline pipeline = analysisPipeline(frame.ycbcrInput);
+    if (pipeline == VK_NULL_HANDLE) return false;
+    VkPipelineLayout layout = frame.ycbcrInput ? ycbcr_.pipelineLayout : pipelineLayout_;
+    const AnalysisTarget& target = analysisTargets_[frameSlot];
+    const uint32_t width = lumina::analysisTargetWidth(analysisTarget_);
+    const uint32_t height = analysisTarget_.height;
+    VkCommandBuffer cmd = frame.cmd;
+
+    auto rp = makeStruct<VkRenderPassBeginInfo>(VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO);
+    rp.renderPass = analysisRenderPass_;
+    rp.framebuffer = target.framebuffer;
+    rp.renderArea.extent = { width, height };
 
-    auto ci = makeStruct<VkRenderPassCreateInfo>(VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO);
-    ci.attachmentCount = 1;
-    ci.pAttachments = &colorAttach;
-    ci.subpassCount = 1;
-    ci.pSubpasses = &subpass;
-    ci.dependencyCount = 1;
-    ci.pDependencies = &dep;
+    VkViewport viewport{};
+    viewport.width = static_cast<float>(width);
+    viewport.height = static_cast<float>(height);
+    viewport.maxDepth = 1.f;
+    VkRect2D scissor{ {0, 0}, { width, height } };
+
+    AnalysisPushConstants push{};
+    push.size[0] = static_cast<float>(analysisTarget_.width);
+    push.size[1] = static_cast<float>(analysisTarget_.height);
+    push.gray = analysisTarget_.format == lumina::AnalysisFormat::GRAY ? 1u : 0u;
+
+    vkCmdBeginRenderPass(cmd, &rp, VK_SUBPASS_CONTENTS_INLINE);
+    vkCmdBindPipeline(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, pipeline);
+    vkCmdSetViewport(cmd, 0, 1, &viewport);
+    vkCmdSetScissor(cmd, 0, 1, &scissor);
+    vkCmdBindDescriptorSets(cmd, VK_PIPELINE_BIND_POINT_GRAPHICS, layout, 0, 1, &frame.input, 0, nullptr);
+    vkCmdPushConstants(cmd, layout, VK_SHADER_STAGE_FRAGMENT_BIT, 0, sizeof(push), &push);
+    vkCmdDraw(cmd, 4, 1, 0, 0);
+    vkCmdEndRenderPass(cmd);
+
+    // Texels are already packed bytes, so the copy lands tightly packed, top row first.
+    VkBufferImageCopy region{};
+    region.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    region.imageSubresource.layerCount = 1;
+    region.imageExtent = { width, height, 1 };
+    vkCmdCopyImageToBuffer(cmd, target.image, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, target.readback, 1, &region);
+
+    auto toHost = makeStruct<VkBufferMemoryBarrier>(VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER);
+    toHost.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toHost.dstAccessMask = VK_ACCESS_HOST_READ_BIT;
+    toHost.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toHost.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toHost.buffer = target.readback;
+    toHost.size = VK_WHOLE_SIZE;
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_HOST_BIT, 0,
+                         0, nullptr, 1, &toHost, 0, nullptr);
+    return true;
+}
 
-    if (renderPass_ != VK_NULL_HANDLE) vkDestroyRenderPass(device_, renderPass_, nullptr);
-    VkResult res = vkCreateRenderPass(device_, &ci, nullptr, &renderPass_);
-    if (res != VK_SUCCESS) {
-        LOGE("vkCreateRenderPass failed: %d", res);
-        return false;
+void VulkanRenderer::collectAnalysisFrame(AnalysisTarget& target) {
+    // Called after the slot's fence wait, so the copy has landed.
+    if (!target.pending) return;
+    target.pending = false;
+    if (!analysisSink_ || !target.mapped) return;
+
+    const GpuAllocation& readback = target.readbackMemory;
+    if (!(readback.flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+        // Non-coherent allocations are whole atoms (see allocateMemory()), so this is legal
+        // even though the block goes on past it.
+        auto range = makeStruct<VkMappedMemoryRange>(VK_STRUCTURE_TYPE_MAPPED_MEMORY_RANGE);
+        range.memory = readback.memory;
+        range.offset = readback.offset;
+        range.size = readback.size;
+        vkInvalidateMappedMemoryRanges(device_, 1, &range);
     }
-    return true;
+    memcpy(analysisSink_->beginFrame(analysisTarget_), target.mapped, lumina::analysisFrameBytes(analysisTarget_));
+    analysisSink_->publish(target.frameNumber, target.timestampNs);
 }
 
-bool VulkanRenderer::createDescriptorSetLayout() {
-    VkDescriptorSetLayoutBinding samplerBinding{};
-    samplerBinding.binding = 0;
-    samplerBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    samplerBinding.descriptorCount = 1;
-    samplerBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+void VulkanRenderer::setEncoderWindow(ANativeWindow* window) {
+    if (window == encoder_.window) return;
+    // Frames in flight may still blit into or present the current encoder images.
+    waitIdle();
+    destroyEncoderOutput();
+    encoder_.window = window;
+    encoder_.failed = false;
+    if (swapchain_.swapchain != VK_NULL_HANDLE &&
+        presentTransform(swapchain_.surfaceTransform) != swapchain_.transform) {
+        swapchain_.outOfDate = true;
+    }
+}
 
-    auto ci = makeStruct<VkDescriptorSetLayoutCreateInfo>(VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO);
-    ci.bindingCount = 1;
-    ci.pBindings = &samplerBinding;
+bool VulkanRenderer::ensureEncoderOutput() {
+    if (encoder_.outOfDate) {
+        vkQueueWaitIdle(graphicsQueue_);
+        destroyEncoderOutput();
+    }
+    if (!encoder_.window || encoder_.failed) return false;
+    if (encoder_.swapchain != VK_NULL_HANDLE) return true;
 
-    if (descriptorSetLayout_ != VK_NULL_HANDLE) vkDestroyDescriptorSetLayout(device_, descriptorSetLayout_, nullptr);
-    VkResult res = vkCreateDescriptorSetLayout(device_, &ci, nullptr, &descriptorSetLayout_);
-    if (res != VK_SUCCESS) {
-        LOGE("vkCreateDescriptorSetLayout failed: %d", res);
+    if (!createEncoderOutput()) {
+        LOGE("Encoder output unavailable; frames will not be recorded");
+        destroyEncoderOutput();
+        encoder_.failed = true;
         return false;
     }
     return true;
 }
 
-bool VulkanRenderer::createPipelineLayout() {
-    auto ci = makeStruct<VkPipelineLayoutCreateInfo>(VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO);
-    ci.setLayoutCount = 1;
-    ci.pSetLayouts = &descriptorSetLayout_;
-
-    VkPushConstantRange push{};
-    push.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
-    push.offset = 0;
-    push.size = sizeof(EffectParams);
-    ci.pushConstantRangeCount = 1;
-    ci.pPushConstantRanges = &push;
+bool VulkanRenderer::createEncoderOutput() {
+    if (!(swapchain_.usage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT)) {
+        LOGW("Swapchain images cannot be copied from");
+        return false;
+    }
 
-    if (pipelineLayout_ != VK_NULL_HANDLE) vkDestroyPipelineLayout(device_, pipelineLayout_, nullptr);
-    VkResult res = vkCreatePipelineLayout(device_, &ci, nullptr, &pipelineLayout_);
+    auto si = makeStruct<VkAndroidSurfaceCreateInfoKHR>(VK_STRUCTURE_TYPE_ANDROID_SURFACE_CREATE_INFO_KHR);
+    si.window = encoder_.window;
+    VkResult res = vkCreateAndroidSurfaceKHR(instance_, &si, nullptr, &encoder_.surface);
     if (res != VK_SUCCESS) {
-        LOGE("vkCreatePipelineLayout failed: %d", res);
+        LOGE("vkCreateAndroidSurfaceKHR (encoder) failed: %d", res);
         return false;
     }
-    return true;
-}
-
-bool VulkanRenderer::createGraphicsPipeline() {
-    auto createShaderModule = [&](const std::vector<uint32_t>& code, VkShaderModule& out) {
-        auto ci = makeStruct<VkShaderModuleCreateInfo>(VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO);
-        ci.codeSize = code.size() * sizeof(uint32_t);
-        ci.pCode = code.data();
-        return vkCreateShaderModule(device_, &ci, nullptr, &out) == VK_SUCCESS;
-    };
 
-    const std::vector<uint32_t> vs(kVertSpv.begin(), kVertSpv.end());
-    const std::vector<uint32_t> fs(kFragSpv.begin(), kFragSpv.end());
-    VkShaderModule vertModule = VK_NULL_HANDLE;
-    VkShaderModule fragModule = VK_NULL_HANDLE;
-    if (!createShaderModule(vs, vertModule) || !createShaderModule(fs, fragModule)) {
-        LOGE("Failed to create shader modules");
-        if (vertModule) vkDestroyShaderModule(device_, vertModule, nullptr);
-        if (fragModule) vkDestroyShaderModule(device_, fragModule, nullptr);
+    VkBool32 presentable = VK_FALSE;
+    vkGetPhysicalDeviceSurfaceSupportKHR(physicalDevice_, graphicsQueueFamily_, encoder_.surface, &presentable);
+    VkSurfaceCapabilitiesKHR caps{};
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice_, encoder_.surface, &caps);
+    if (!presentable || !(caps.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_DST_BIT)) {
+        LOGE("Encoder surface cannot be presented to or copied into");
         return false;
     }
 
-    VkPipelineShaderStageCreateInfo stages[2]{};
-    stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
-    stages[0].module = vertModule;
-    stages[0].pName = "main";
+    // Same format as the display when offered, so the blit is a straight scaled copy.
+    uint32_t formatCount = 0;
+    vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice_, encoder_.surface, &formatCount, nullptr);
+    std::vector<VkSurfaceFormatKHR> formats(formatCount);
+    vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice_, encoder_.surface, &formatCount, formats.data());
+    if (formats.empty()) return false;
+    VkSurfaceFormatKHR chosenFormat = formats[0];
+    for (const auto& f : formats) {
+        if (f.format == swapchain_.format) {
+            chosenFormat = f;
+            break;
+        }
+    }
 
-    stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
-    stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
-    stages[1].module = fragModule;
-    stages[1].pName = "main";
+    VkFormatProperties src{};
+    VkFormatProperties dst{};
+    vkGetPhysicalDeviceFormatProperties(physicalDevice_, swapchain_.format, &src);
+    vkGetPhysicalDeviceFormatProperties(physicalDevice_, chosenFormat.format, &dst);
+    if (!(src.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_SRC_BIT) ||
+        !(dst.optimalTilingFeatures & VK_FORMAT_FEATURE_BLIT_DST_BIT)) {
+        LOGE("Cannot blit format %d into encoder format %d", swapchain_.format, chosenFormat.format);
+        return false;
+    }
+    encoder_.filter = (src.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)
+        ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
 
-    auto vertexInput = makeStruct<VkPipelineVertexInputStateCreateInfo>(VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO);
-    auto inputAssembly = makeStruct<VkPipelineInputAssemblyStateCreateInfo>(VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO);
-    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
-    inputAssembly.primitiveRestartEnable = VK_FALSE;
+    encoder_.extent = caps.currentExtent;
+    if (encoder_.extent.width == UINT32_MAX) {
+        encoder_.extent.width = static_cast<uint32_t>(ANativeWindow_getWidth(encoder_.window));
+        encoder_.extent.height = static_cast<uint32_t>(ANativeWindow_getHeight(encoder_.window));
+    }
 
-    VkViewport viewport{};
-    viewport.x = 0;
-    viewport.y = 0;
-    viewport.width = static_cast<float>(swapchain_.width);
-    viewport.height = static_cast<float>(swapchain_.height);
-    viewport.minDepth = 0.f;
-    viewport.maxDepth = 1.f;
+    uint32_t imageCount = caps.minImageCount + 1;
+    if (caps.maxImageCount > 0 && imageCount > caps.maxImageCount) {
+        imageCount = caps.maxImageCount;
+    }
 
-    VkRect2D scissor{};
-    scissor.offset = {0, 0};
-    scissor.extent = {swapchain_.width, swapchain_.height};
+    // FIFO: the encoder must see every frame in order, never a replaced one.
+    auto ci = makeStruct<VkSwapchainCreateInfoKHR>(VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR);
+    ci.surface = encoder_.surface;
+    ci.minImageCount = imageCount;
+    ci.imageFormat = chosenFormat.format;
+    ci.imageColorSpace = chosenFormat.colorSpace;
+    ci.imageExtent = encoder_.extent;
+    ci.imageArrayLayers = 1;
+    ci.imageUsage = VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    ci.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    ci.preTransform = (caps.supportedTransforms & VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR)
+        ? VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR : caps.currentTransform;
+    ci.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    ci.presentMode = VK_PRESENT_MODE_FIFO_KHR;
+    ci.clipped = VK_TRUE;
+    res = vkCreateSwapchainKHR(device_, &ci, nullptr, &encoder_.swapchain);
+    if (res != VK_SUCCESS) {
+        LOGE("vkCreateSwapchainKHR (encoder) failed: %d", res);
+        return false;
+    }
+
+    uint32_t count = 0;
+    vkGetSwapchainImagesKHR(device_, encoder_.swapchain, &count, nullptr);
+    encoder_.images.resize(count);
+    vkGetSwapchainImagesKHR(device_, encoder_.swapchain, &count, encoder_.images.data());
+
+    auto sci = makeStruct<VkSemaphoreCreateInfo>(VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO);
+    encoder_.renderFinished.assign(count, VK_NULL_HANDLE);
+    for (auto& semaphore : encoder_.renderFinished) {
+        if (vkCreateSemaphore(device_, &sci, nullptr, &semaphore) != VK_SUCCESS) return false;
+    }
+    for (auto& semaphore : encoder_.acquired) {
+        if (vkCreateSemaphore(device_, &sci, nullptr, &semaphore) != VK_SUCCESS) return false;
+    }
+
+    LOGI("Encoder swapchain ready: %ux%u, %u images", encoder_.extent.width, encoder_.extent.height, count);
+    return true;
+}
+
+void VulkanRenderer::destroyEncoderOutput() {
+    if (device_ != VK_NULL_HANDLE) {
+        for (auto semaphore : encoder_.renderFinished) {
+            if (semaphore != VK_NULL_HANDLE) vkDestroySemaphore(device_, semaphore, nullptr);
+        }
+        for (auto semaphore : encoder_.acquired) {
+            if (semaphore != VK_NULL_HANDLE) vkDestroySemaphore(device_, semaphore, nullptr);
+        }
+        if (encoder_.swapchain != VK_NULL_HANDLE) vkDestroySwapchainKHR(device_, encoder_.swapchain, nullptr);
+    }
+    if (encoder_.surface != VK_NULL_HANDLE && instance_ != VK_NULL_HANDLE) {
+        vkDestroySurfaceKHR(instance_, encoder_.surface, nullptr);
+    }
+    // The window stays attached; the swapchain is rebuilt on demand.
+    ANativeWindow* window = encoder_.window;
+    const bool failed = encoder_.failed;
+    encoder_ = EncoderOutput{};
+    encoder_.window = window;
+    encoder_.failed = failed;
+}
+
+void VulkanRenderer::recordEncoderBlit(VkCommandBuffer cmd, uint32_t imageIndex, uint32_t encoderIndex) {
+    VkImage display = swapchain_.images[imageIndex];
+    VkImage encoded = encoder_.images[encoderIndex];
+
+    // The surface pass left the display image ready to present; the encoder image's
+    // old contents do not matter since the blit covers all of it.
+    const std::array<VkImageMemoryBarrier, 2> toTransfer = {
+        barrier(display, VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT, VK_ACCESS_TRANSFER_READ_BIT,
+                VK_IMAGE_LAYOUT_PRESENT_SRC_KHR, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL),
+        barrier(encoded, 0, VK_ACCESS_TRANSFER_WRITE_BIT,
+                VK_IMAGE_LAYOUT_UNDEFINED, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL),
+    };
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT, 0, 0, nullptr, 0, nullptr,
+                         static_cast<uint32_t>(toTransfer.size()), toTransfer.data());
+
+    // A half-turned display image is blitted back upright by swapping the corners.
+    const int32_t w = static_cast<int32_t>(swapchain_.width);
+    const int32_t h = static_cast<int32_t>(swapchain_.height);
+    const bool flipped = swapchain_.quarterTurns == 2;
+    VkImageBlit region{};
+    region.srcSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    region.srcOffsets[0] = { flipped ? w : 0, flipped ? h : 0, 0 };
+    region.srcOffsets[1] = { flipped ? 0 : w, flipped ? 0 : h, 1 };
+    region.dstSubresource = { VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1 };
+    region.dstOffsets[1] = { static_cast<int32_t>(encoder_.extent.width), static_cast<int32_t>(encoder_.extent.height), 1 };
+    vkCmdBlitImage(cmd, display, VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, encoded, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+                   1, &region, encoder_.filter);
+
+    const std::array<VkImageMemoryBarrier, 2> toPresent = {
+        barrier(display, VK_ACCESS_TRANSFER_READ_BIT, 0,
+                VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR),
+        barrier(encoded, VK_ACCESS_TRANSFER_WRITE_BIT, 0,
+                VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, VK_IMAGE_LAYOUT_PRESENT_SRC_KHR),
+    };
+    vkCmdPipelineBarrier(cmd, VK_PIPELINE_STAGE_TRANSFER_BIT, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, 0,
+                         0, nullptr, 0, nullptr, static_cast<uint32_t>(toPresent.size()), toPresent.data());
+}
+
+bool VulkanRenderer::createInstance() {
+    auto app = makeStruct<VkApplicationInfo>(VK_STRUCTURE_TYPE_APPLICATION_INFO);
+    app.pApplicationName = "LuminaVS";
+    app.applicationVersion = VK_MAKE_VERSION(1, 0, 0);
+    app.pEngineName = "LuminaEngine";
+    app.engineVersion = VK_MAKE_VERSION(1, 0, 0);
+    app.apiVersion = VK_API_VERSION_1_1;
+
+    auto ci = makeStruct<VkInstanceCreateInfo>(VK_STRUCTURE_TYPE_INSTANCE_CREATE_INFO);
+    ci.pApplicationInfo = &app;
+
+    if (headless_) {
+        // No surface, so no WSI extensions.
+        VkResult res = vkCreateInstance(&ci, nullptr, &instance_);
+        if (res != VK_SUCCESS) {
+            LOGE("vkCreateInstance (headless) failed: %d", res);
+            return false;
+        }
+        return true;
+    }
+
+    uint32_t extCount = 0;
+    vkEnumerateInstanceExtensionProperties(nullptr, &extCount, nullptr);
+    std::vector<VkExtensionProperties> exts(extCount);
+    vkEnumerateInstanceExtensionProperties(nullptr, &extCount, exts.data());
+
+    if (!hasExtension(exts, VK_KHR_SURFACE_EXTENSION_NAME) ||
+        !hasExtension(exts, VK_KHR_ANDROID_SURFACE_EXTENSION_NAME)) {
+        LOGE("Required Vulkan surface extensions not available");
+        return false;
+    }
+
+    const char* requiredExts[] = {
+        VK_KHR_SURFACE_EXTENSION_NAME,
+        VK_KHR_ANDROID_SURFACE_EXTENSION_NAME
+    };
+
+    ci.enabledExtensionCount = 2;
+    ci.ppEnabledExtensionNames = requiredExts;
+
+    VkResult res = vkCreateInstance(&ci, nullptr, &instance_);
+    if (res != VK_SUCCESS) {
+        LOGE("vkCreateInstance failed: %d", res);
+        return false;
+    }
+    return true;
+}
+
+bool VulkanRenderer::createSurface(ANativeWindow* window) {
+    if (surface_ != VK_NULL_HANDLE) {
+        vkDestroySurfaceKHR(instance_, surface_, nullptr);
+        surface_ = VK_NULL_HANDLE;
+    }
+
+    if (!window) {
+        LOGW("No native window provided for surface creation" );
+        return false;
+    }
+
+    window_ = window;
+
+    auto ci = makeStruct<VkAndroidSurfaceCreateInfoKHR>(VK_STRUCTURE_TYPE_ANDROID_SURFACE_CREATE_INFO_KHR);
+    ci.window = window;
+    VkResult res = vkCreateAndroidSurfaceKHR(instance_, &ci, nullptr, &surface_);
+    if (res != VK_SUCCESS) {
+        LOGE("vkCreateAndroidSurfaceKHR failed: %d", res);
+        return false;
+    }
+    return true;
+}
+
+uint32_t VulkanRenderer::findGraphicsQueueFamily(VkPhysicalDevice device) {
+    uint32_t count = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &count, nullptr);
+    std::vector<VkQueueFamilyProperties> props(count);
+    vkGetPhysicalDeviceQueueFamilyProperties(device, &count, props.data());
+    for (uint32_t i = 0; i < count; ++i) {
+        if (props[i].queueCount > 0 && (props[i].queueFlags & VK_QUEUE_GRAPHICS_BIT)) {
+            if (surface_ == VK_NULL_HANDLE) return i; // headless: nothing to present to
+            VkBool32 presentSupport = VK_FALSE;
+            vkGetPhysicalDeviceSurfaceSupportKHR(device, i, surface_, &presentSupport);
+            if (presentSupport) return i;
+        }
+    }
+    return UINT32_MAX;
+}
+
+bool VulkanRenderer::pickPhysicalDevice() {
+    uint32_t deviceCount = 0;
+    vkEnumeratePhysicalDevices(instance_, &deviceCount, nullptr);
+    if (deviceCount == 0) {
+        LOGE("No Vulkan physical devices found");
+        return false;
+    }
+    std::vector<VkPhysicalDevice> devices(deviceCount);
+    vkEnumeratePhysicalDevices(instance_, &deviceCount, devices.data());
+
+    for (auto dev : devices) {
+        uint32_t q = findGraphicsQueueFamily(dev);
+        if (q != UINT32_MAX) {
+            physicalDevice_ = dev;
+            graphicsQueueFamily_ = q;
+            return true;
+        }
+    }
+    LOGE("No suitable graphics+present queue family found");
+    return false;
+}
+
+bool VulkanRenderer::createDevice() {
+    // Prefer a transfer-only family (the DMA engine) for camera uploads so copies overlap
+    // with rendering instead of queueing behind it.
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice_, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice_, &familyCount, families.data());
+    transferQueueFamily_ = graphicsQueueFamily_;
+    for (uint32_t i = 0; i < familyCount; ++i) {
+        const VkQueueFlags flags = families[i].queueFlags;
+        if (families[i].queueCount > 0 && (flags & VK_QUEUE_TRANSFER_BIT) &&
+            !(flags & (VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT))) {
+            transferQueueFamily_ = i;
+            break;
+        }
+    }
+
+    float priority = 1.0f;
+    std::array<VkDeviceQueueCreateInfo, 2> qcis{};
+    uint32_t queueCreateCount = 1;
+    qcis[0] = makeStruct<VkDeviceQueueCreateInfo>(VK_STRUCTURE_TYPE_DEVICE_QUEUE_CREATE_INFO);
+    qcis[0].queueFamilyIndex = graphicsQueueFamily_;
+    qcis[0].queueCount = 1;
+    qcis[0].pQueuePriorities = &priority;
+    if (transferQueueFamily_ != graphicsQueueFamily_) {
+        qcis[1] = qcis[0];
+        qcis[1].queueFamilyIndex = transferQueueFamily_;
+        queueCreateCount = 2;
+    }
+
+    uint32_t extCount = 0;
+    vkEnumerateDeviceExtensionProperties(physicalDevice_, nullptr, &extCount, nullptr);
+    std::vector<VkExtensionProperties> exts(extCount);
+    vkEnumerateDeviceExtensionProperties(physicalDevice_, nullptr, &extCount, exts.data());
+
+    std::vector<const char*> deviceExts;
+    if (!headless_) deviceExts.push_back(VK_KHR_SWAPCHAIN_EXTENSION_NAME);
+
+    // AHardwareBuffer import needs Vulkan 1.1 (YCbCr conversion and external memory are
+    // core there) plus the Android extension and foreign-queue ownership transfers.
+    VkPhysicalDeviceProperties devProps{};
+    vkGetPhysicalDeviceProperties(physicalDevice_, &devProps);
+    vkGetPhysicalDeviceMemoryProperties(physicalDevice_, &memoryProperties_);
+    nonCoherentAtomSize_ = std::max<VkDeviceSize>(devProps.limits.nonCoherentAtomSize, 1);
+
+    auto ycbcrFeatures = makeStruct<VkPhysicalDeviceSamplerYcbcrConversionFeatures>(
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SAMPLER_YCBCR_CONVERSION_FEATURES);
+    auto timelineFeatures = makeStruct<VkPhysicalDeviceTimelineSemaphoreFeaturesKHR>(
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR);
+    const bool hasTimelineExt = hasExtension(exts, VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+    if (devProps.apiVersion >= VK_API_VERSION_1_1) {
+        auto features2 = makeStruct<VkPhysicalDeviceFeatures2>(VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2);
+        features2.pNext = &ycbcrFeatures;
+        if (hasTimelineExt) ycbcrFeatures.pNext = &timelineFeatures;
+        vkGetPhysicalDeviceFeatures2(physicalDevice_, &features2);
+        ycbcrFeatures.pNext = nullptr;
+    }
+
+    ahbSupported_ = devProps.apiVersion >= VK_API_VERSION_1_1 &&
+                    ycbcrFeatures.samplerYcbcrConversion == VK_TRUE &&
+                    hasExtension(exts, VK_ANDROID_EXTERNAL_MEMORY_ANDROID_HARDWARE_BUFFER_EXTENSION_NAME) &&
+                    hasExtension(exts, VK_EXT_QUEUE_FAMILY_FOREIGN_EXTENSION_NAME);
+    if (ahbSupported_) {
+        deviceExts.push_back(VK_ANDROID_EXTERNAL_MEMORY_ANDROID_HARDWARE_BUFFER_EXTENSION_NAME);
+        deviceExts.push_back(VK_EXT_QUEUE_FAMILY_FOREIGN_EXTENSION_NAME);
+        // Promoted to core in 1.1, but some drivers still list the AHB extension as
+        // depending on the KHR names; enabling them when advertised is harmless.
+        for (const char* dep : { VK_KHR_SAMPLER_YCBCR_CONVERSION_EXTENSION_NAME,
+                                 VK_KHR_EXTERNAL_MEMORY_EXTENSION_NAME,
+                                 VK_KHR_DEDICATED_ALLOCATION_EXTENSION_NAME,
+                                 VK_KHR_GET_MEMORY_REQUIREMENTS_2_EXTENSION_NAME,
+                                 VK_KHR_MAINTENANCE1_EXTENSION_NAME,
+                                 VK_KHR_BIND_MEMORY_2_EXTENSION_NAME }) {
+            if (hasExtension(exts, dep)) deviceExts.push_back(dep);
+        }
+    } else {
+        LOGW("AHardwareBuffer import unavailable; camera frames will use staged uploads");
+    }
+
+    // Timeline semaphores let render() wait on "upload N done" without a binary
+    // semaphore per upload; without them each ring slot carries its own semaphore.
+    timelineSupported_ = hasTimelineExt && timelineFeatures.timelineSemaphore == VK_TRUE;
+    if (timelineSupported_) deviceExts.push_back(VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+
+    // Lets the render thread hold a frame until its paced slot instead of the next vsync.
+    displayTimingSupported_ = !headless_ && hasExtension(exts, VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME);
+    if (displayTimingSupported_) deviceExts.push_back(VK_GOOGLE_DISPLAY_TIMING_EXTENSION_NAME);
+
+    const void* featureChain = nullptr;
+    timelineFeatures.pNext = nullptr;
+    if (timelineSupported_) featureChain = &timelineFeatures;
+    if (ahbSupported_) {
+        ycbcrFeatures.pNext = const_cast<void*>(featureChain);
+        featureChain = &ycbcrFeatures;
+    }
+
+    auto ci = makeStruct<VkDeviceCreateInfo>(VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO);
+    ci.pNext = featureChain;
+    ci.queueCreateInfoCount = queueCreateCount;
+    ci.pQueueCreateInfos = qcis.data();
+    ci.enabledExtensionCount = static_cast<uint32_t>(deviceExts.size());
+    ci.ppEnabledExtensionNames = deviceExts.data();
+
+    VkResult res = vkCreateDevice(physicalDevice_, &ci, nullptr, &device_);
+    if (res != VK_SUCCESS) {
+        LOGE("vkCreateDevice failed: %d", res);
+        return false;
+    }
+    vkGetDeviceQueue(device_, graphicsQueueFamily_, 0, &graphicsQueue_);
+    vkGetDeviceQueue(device_, transferQueueFamily_, 0, &transferQueue_);
+    return loadDeviceFunctions();
+}
+
+bool VulkanRenderer::loadDeviceFunctions() {
+    if (!ahbSupported_) return true;
+
+    pfnGetAhbProperties_ = reinterpret_cast<PFN_vkGetAndroidHardwareBufferPropertiesANDROID>(
+        vkGetDeviceProcAddr(device_, "vkGetAndroidHardwareBufferPropertiesANDROID"));
+    pfnCreateYcbcrConversion_ = reinterpret_cast<PFN_vkCreateSamplerYcbcrConversion>(
+        vkGetDeviceProcAddr(device_, "vkCreateSamplerYcbcrConversion"));
+    pfnDestroyYcbcrConversion_ = reinterpret_cast<PFN_vkDestroySamplerYcbcrConversion>(
+        vkGetDeviceProcAddr(device_, "vkDestroySamplerYcbcrConversion"));
+
+    if (!pfnGetAhbProperties_ || !pfnCreateYcbcrConversion_ || !pfnDestroyYcbcrConversion_) {
+        LOGW("AHardwareBuffer entry points missing; disabling zero-copy import");
+        ahbSupported_ = false;
+    }
+    return true;
+}
+
+bool VulkanRenderer::createCommandPool() {
+    auto ci = makeStruct<VkCommandPoolCreateInfo>(VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO);
+    ci.queueFamilyIndex = graphicsQueueFamily_;
+    ci.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    VkResult res = vkCreateCommandPool(device_, &ci, nullptr, &commandPool_);
+    if (res != VK_SUCCESS) {
+        LOGE("vkCreateCommandPool failed: %d", res);
+        return false;
+    }
+    return true;
+}
+
+bool VulkanRenderer::createSwapchain(VkSwapchainKHR oldSwapchain) {
+    if (headless_) return createHeadlessTargets();
+
+    VkSurfaceCapabilitiesKHR caps{};
+    vkGetPhysicalDeviceSurfaceCapabilitiesKHR(physicalDevice_, surface_, &caps);
+
+    uint32_t formatCount = 0;
+    vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice_, surface_, &formatCount, nullptr);
+    std::vector<VkSurfaceFormatKHR> formats(formatCount);
+    vkGetPhysicalDeviceSurfaceFormatsKHR(physicalDevice_, surface_, &formatCount, formats.data());
+
+    uint32_t presentCount = 0;
+    vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice_, surface_, &presentCount, nullptr);
+    std::vector<VkPresentModeKHR> presents(presentCount);
+    vkGetPhysicalDeviceSurfacePresentModesKHR(physicalDevice_, surface_, &presentCount, presents.data());
+
+    VkSurfaceFormatKHR chosenFormat = formats[0];
+    for (const auto& f : formats) {
+        if (f.format == kPreferredSurfaceFormat && f.colorSpace == VK_COLOR_SPACE_SRGB_NONLINEAR_KHR) {
+            chosenFormat = f;
+            break;
+        }
+    }
+
+    VkPresentModeKHR chosenPresent = VK_PRESENT_MODE_FIFO_KHR;
+    for (const auto& pm : presents) {
+        if (pm == VK_PRESENT_MODE_MAILBOX_KHR) { chosenPresent = pm; break; }
+    }
+
+    VkExtent2D extent = caps.currentExtent;
+    if (extent.width == UINT32_MAX) {
+        extent.width = 1280;
+        extent.height = 720;
+    }
+
+    // Drawing the surface pass rotated (passthrough.vert) saves the compositor a
+    // rotation pass on every frame. The images keep the display's natural orientation,
+    // while currentExtent is the window's.
+    VkSurfaceTransformFlagBitsKHR transform = presentTransform(caps.currentTransform);
+    if (!(caps.supportedTransforms & transform)) transform = caps.currentTransform;
+    const uint32_t quarterTurns = quarterTurnsOf(transform);
+    if (quarterTurns % 2 == 1) std::swap(extent.width, extent.height);
+
+    uint32_t imageCount = caps.minImageCount + 1;
+    if (caps.maxImageCount > 0 && imageCount > caps.maxImageCount) {
+        imageCount = caps.maxImageCount;
+    }
+
+    auto ci = makeStruct<VkSwapchainCreateInfoKHR>(VK_STRUCTURE_TYPE_SWAPCHAIN_CREATE_INFO_KHR);
+    ci.surface = surface_;
+    ci.minImageCount = imageCount;
+    ci.imageFormat = chosenFormat.format;
+    ci.imageColorSpace = chosenFormat.colorSpace;
+    ci.imageExtent = extent;
+    ci.imageArrayLayers = 1;
+    // Transfer source lets a recording copy the finished frame into the encoder.
+    ci.imageUsage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | (caps.supportedUsageFlags & VK_IMAGE_USAGE_TRANSFER_SRC_BIT);
+    ci.imageSharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    ci.preTransform = transform;
+    ci.compositeAlpha = VK_COMPOSITE_ALPHA_OPAQUE_BIT_KHR;
+    ci.presentMode = chosenPresent;
+    ci.clipped = VK_TRUE;
+    // Lets the driver hand over the old images' memory and keep presenting them in the
+    // meantime; the old swapchain itself is retired by the caller.
+    ci.oldSwapchain = oldSwapchain;
+
+    VkResult res = vkCreateSwapchainKHR(device_, &ci, nullptr, &swapchain_.swapchain);
+    if (res != VK_SUCCESS) {
+        LOGE("vkCreateSwapchainKHR failed: %d", res);
+        return false;
+    }
+
+    uint32_t scImageCount = 0;
+    vkGetSwapchainImagesKHR(device_, swapchain_.swapchain, &scImageCount, nullptr);
+    swapchain_.images.resize(scImageCount);
+    vkGetSwapchainImagesKHR(device_, swapchain_.swapchain, &scImageCount, swapchain_.images.data());
+
+    swapchain_.width = extent.width;
+    swapchain_.height = extent.height;
+    swapchain_.format = chosenFormat.format;
+    swapchain_.usage = ci.imageUsage;
+    swapchain_.transform = transform;
+    swapchain_.surfaceTransform = caps.currentTransform;
+    swapchain_.quarterTurns = quarterTurns;
+    swapchain_.outOfDate = false;
+
+    return true;
+}
+
+VkSurfaceTransformFlagBitsKHR VulkanRenderer::presentTransform(VkSurfaceTransformFlagBitsKHR current) const {
+    // A blit cannot turn a frame sideways, so while recording a quarter turn is left to
+    // the compositor to keep the encoder's copy upright. Half turns blit flipped.
+    switch (current) {
+        case VK_SURFACE_TRANSFORM_ROTATE_90_BIT_KHR:
+        case VK_SURFACE_TRANSFORM_ROTATE_270_BIT_KHR:
+            return encoder_.window ? VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR : current;
+        case VK_SURFACE_TRANSFORM_ROTATE_180_BIT_KHR:
+            return current;
+        default:
+            return VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+    }
+}
+
+VkExtent2D VulkanRenderer::surfaceExtent() const {
+    return swapchain_.quarterTurns % 2 == 1 ? VkExtent2D{ swapchain_.height, swapchain_.width }
+                                            : VkExtent2D{ swapchain_.width, swapchain_.height };
+}
+
+bool VulkanRenderer::createHeadlessTargets() {
+    // Stand-ins for swapchain images; TRANSFER_SRC so a harness can read results back.
+    swapchain_.width = headlessExtent_.width;
+    swapchain_.height = headlessExtent_.height;
+    swapchain_.format = VK_FORMAT_R8G8B8A8_UNORM;
+    swapchain_.images.assign(kMaxFramesInFlight, VK_NULL_HANDLE);
+    swapchain_.memory.assign(kMaxFramesInFlight, GpuAllocation{});
+
+    for (size_t i = 0; i < swapchain_.images.size(); ++i) {
+        auto ci = makeStruct<VkImageCreateInfo>(VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO);
+        ci.imageType = VK_IMAGE_TYPE_2D;
+        ci.extent = { swapchain_.width, swapchain_.height, 1 };
+        ci.mipLevels = 1;
+        ci.arrayLayers = 1;
+        ci.format = swapchain_.format;
+        ci.tiling = VK_IMAGE_TILING_OPTIMAL;
+        ci.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        ci.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_TRANSFER_SRC_BIT;
+        ci.samples = VK_SAMPLE_COUNT_1_BIT;
+        ci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        if (vkCreateImage(device_, &ci, nullptr, &swapchain_.images[i]) != VK_SUCCESS) {
+            LOGE("vkCreateImage for headless target %zu failed", i);
+            return false;
+        }
+
+        if (!allocateImageMemory(swapchain_.images[i], VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0,
+                                 lumina::GpuMemoryCategory::Targets, swapchain_.memory[i])) {
+            LOGE("Failed to allocate headless target memory");
+            return false;
+        }
+    }
+    return true;
+}
+
+bool VulkanRenderer::createRenderPass() {
+    VkAttachmentDescription colorAttach{};
+    colorAttach.format = swapchain_.format;
+    colorAttach.samples = VK_SAMPLE_COUNT_1_BIT;
+    colorAttach.loadOp = VK_ATTACHMENT_LOAD_OP_CLEAR;
+    colorAttach.storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+    colorAttach.stencilLoadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    colorAttach.stencilStoreOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    colorAttach.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    // PRESENT_SRC needs VK_KHR_swapchain, which headless devices do not enable.
+    colorAttach.finalLayout = headless_ ? VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL : VK_IMAGE_LAYOUT_PRESENT_SRC_KHR;
+    const VkAttachmentDescription surfaceAttach = colorAttach;
+
+    VkAttachmentReference colorRef{};
+    colorRef.attachment = 0;
+    colorRef.layout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+
+    VkSubpassDescription subpass{};
+    subpass.pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpass.colorAttachmentCount = 1;
+    subpass.pColorAttachments = &colorRef;
+
+    VkSubpassDependency dep{};
+    dep.srcSubpass = VK_SUBPASS_EXTERNAL;
+    dep.dstSubpass = 0;
+    dep.srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dep.srcAccessMask = 0;
+    dep.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    dep.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+    auto ci = makeStruct<VkRenderPassCreateInfo>(VK_STRUCTURE_TYPE_RENDER_PASS_CREATE_INFO);
+    ci.attachmentCount = 1;
+    ci.pAttachments = &colorAttach;
+    ci.subpassCount = 1;
+    ci.pSubpasses = &subpass;
+    ci.dependencyCount = 1;
+    ci.pDependencies = &dep;
+
+    if (renderPass_ != VK_NULL_HANDLE) vkDestroyRenderPass(device_, renderPass_, nullptr);
+    VkResult res = vkCreateRenderPass(device_, &ci, nullptr, &renderPass_);
+    if (res != VK_SUCCESS) {
+        LOGE("vkCreateRenderPass failed: %d", res);
+        return false;
+    }
+
+    // Intermediate effect passes: same format (so pipelines stay compatible), contents
+    // fully overwritten, left ready for the next pass to sample.
+    colorAttach.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    colorAttach.finalLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+
+    std::array<VkSubpassDependency, 2> offscreenDeps{};
+    offscreenDeps[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    offscreenDeps[0].dstSubpass = 0;
+    offscreenDeps[0].srcStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    offscreenDeps[0].srcAccessMask = 0;
+    offscreenDeps[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    offscreenDeps[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    offscreenDeps[1].srcSubpass = 0;
+    offscreenDeps[1].dstSubpass = VK_SUBPASS_EXTERNAL;
+    offscreenDeps[1].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    offscreenDeps[1].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    offscreenDeps[1].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    offscreenDeps[1].dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    ci.dependencyCount = static_cast<uint32_t>(offscreenDeps.size());
+    ci.pDependencies = offscreenDeps.data();
+
+    if (offscreenRenderPass_ != VK_NULL_HANDLE) vkDestroyRenderPass(device_, offscreenRenderPass_, nullptr);
+    res = vkCreateRenderPass(device_, &ci, nullptr, &offscreenRenderPass_);
+    if (res != VK_SUCCESS) {
+        LOGE("vkCreateRenderPass for effect passes failed: %d", res);
+        return false;
+    }
+
+    // Merged tail: subpass 0 writes the intermediate, subpass 1 reads it back at the
+    // same pixel and writes the surface. The intermediate is neither loaded nor stored.
+    VkAttachmentDescription tileAttach = surfaceAttach;
+    tileAttach.loadOp = VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+    tileAttach.storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+    tileAttach.finalLayout = VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL;
+    const std::array<VkAttachmentDescription, 2> mergedAttachments = { tileAttach, surfaceAttach };
+
+    const VkAttachmentReference tileWrite{ 0, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+    const VkAttachmentReference tileRead{ 0, VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL };
+    const VkAttachmentReference surfaceWrite{ 1, VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL };
+    std::array<VkSubpassDescription, 2> subpasses{};
+    subpasses[0].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpasses[0].colorAttachmentCount = 1;
+    subpasses[0].pColorAttachments = &tileWrite;
+    subpasses[1].pipelineBindPoint = VK_PIPELINE_BIND_POINT_GRAPHICS;
+    subpasses[1].inputAttachmentCount = 1;
+    subpasses[1].pInputAttachments = &tileRead;
+    subpasses[1].colorAttachmentCount = 1;
+    subpasses[1].pColorAttachments = &surfaceWrite;
+
+    std::array<VkSubpassDependency, 3> mergedDeps{};
+    mergedDeps[0].srcSubpass = VK_SUBPASS_EXTERNAL;
+    mergedDeps[0].dstSubpass = 0;
+    mergedDeps[0].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT | VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    mergedDeps[0].srcAccessMask = 0;
+    mergedDeps[0].dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    mergedDeps[0].dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    mergedDeps[1] = dep;  // surface, as in renderPass_
+    mergedDeps[1].dstSubpass = 1;
+    mergedDeps[2].srcSubpass = 0;
+    mergedDeps[2].dstSubpass = 1;
+    mergedDeps[2].srcStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+    mergedDeps[2].srcAccessMask = VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+    mergedDeps[2].dstStageMask = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
+    mergedDeps[2].dstAccessMask = VK_ACCESS_INPUT_ATTACHMENT_READ_BIT;
+    mergedDeps[2].dependencyFlags = VK_DEPENDENCY_BY_REGION_BIT;
+
+    ci.attachmentCount = static_cast<uint32_t>(mergedAttachments.size());
+    ci.pAttachments = mergedAttachments.data();
+    ci.subpassCount = static_cast<uint32_t>(subpasses.size());
+    ci.pSubpasses = subpasses.data();
+    ci.dependencyCount = static_cast<uint32_t>(mergedDeps.size());
+    ci.pDependencies = mergedDeps.data();
+
+    if (mergedRenderPass_ != VK_NULL_HANDLE) vkDestroyRenderPass(device_, mergedRenderPass_, nullptr);
+    res = vkCreateRenderPass(device_, &ci, nullptr, &mergedRenderPass_);
+    if (res != VK_SUCCESS) {
+        // Not fatal: the tail then runs as two render passes like any other.
+        LOGW("vkCreateRenderPass for the merged tail failed: %d", res);
+        mergedRenderPass_ = VK_NULL_HANDLE;
+    }
+
+    // Glass panels: the surface image again, loaded after the blit that fed their pyramid
+    // and left ready to present. Compatible with renderPass_, so framebuffers_ serve it.
+    if (glassRenderPass_ != VK_NULL_HANDLE) vkDestroyRenderPass(device_, glassRenderPass_, nullptr);
+    glassRenderPass_ = VK_NULL_HANDLE;
+    if (!headless_) {
+        VkAttachmentDescription glassAttach = surfaceAttach;
+        glassAttach.loadOp = VK_ATTACHMENT_LOAD_OP_LOAD;
+        glassAttach.initialLayout = VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL;
+
+        VkSubpassDependency glassDep{};
+        glassDep.srcSubpass = VK_SUBPASS_EXTERNAL;
+        glassDep.dstSubpass = 0;
+        glassDep.srcStageMask = VK_PIPELINE_STAGE_TRANSFER_BIT;
+        glassDep.srcAccessMask = 0;
+        glassDep.dstStageMask = VK_PIPELINE_STAGE_COLOR_ATTACHMENT_OUTPUT_BIT;
+        glassDep.dstAccessMask = VK_ACCESS_COLOR_ATTACHMENT_READ_BIT | VK_ACCESS_COLOR_ATTACHMENT_WRITE_BIT;
+
+        ci.attachmentCount = 1;
+        ci.pAttachments = &glassAttach;
+        ci.subpassCount = 1;
+        ci.pSubpasses = &subpass;
+        ci.dependencyCount = 1;
+        ci.pDependencies = &glassDep;
+        res = vkCreateRenderPass(device_, &ci, nullptr, &glassRenderPass_);
+        if (res != VK_SUCCESS) {
+            // Not fatal: the panels then stay unblurred.
+            LOGW("vkCreateRenderPass for the glass panels failed: %d", res);
+            glassRenderPass_ = VK_NULL_HANDLE;
+        }
+    }
+    return true;
+}
+
+bool VulkanRenderer::createDescriptorSetLayout() {
+    VkDescriptorSetLayoutBinding samplerBinding{};
+    samplerBinding.binding = 0;
+    samplerBinding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    samplerBinding.descriptorCount = 1;
+    samplerBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+
+    auto ci = makeStruct<VkDescriptorSetLayoutCreateInfo>(VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO);
+    ci.bindingCount = 1;
+    ci.pBindings = &samplerBinding;
+
+    if (descriptorSetLayout_ != VK_NULL_HANDLE) vkDestroyDescriptorSetLayout(device_, descriptorSetLayout_, nullptr);
+    VkResult res = vkCreateDescriptorSetLayout(device_, &ci, nullptr, &descriptorSetLayout_);
+    if (res != VK_SUCCESS) {
+        LOGE("vkCreateDescriptorSetLayout failed: %d", res);
+        return false;
+    }
+
+    // Set 1: per-frame effect parameters, selected with a dynamic offset.
+    VkDescriptorSetLayoutBinding chainBinding{};
+    chainBinding.binding = 0;
+    chainBinding.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    chainBinding.descriptorCount = 1;
+    chainBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    ci.pBindings = &chainBinding;
+
+    if (chainSetLayout_ != VK_NULL_HANDLE) vkDestroyDescriptorSetLayout(device_, chainSetLayout_, nullptr);
+    res = vkCreateDescriptorSetLayout(device_, &ci, nullptr, &chainSetLayout_);
+    if (res != VK_SUCCESS) {
+        LOGE("vkCreateDescriptorSetLayout for effect chain failed: %d", res);
+        return false;
+    }
+
+    // Set 0 of the merged tail's last pass: the previous subpass's output.
+    VkDescriptorSetLayoutBinding inputBinding{};
+    inputBinding.binding = 0;
+    inputBinding.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+    inputBinding.descriptorCount = 1;
+    inputBinding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    ci.pBindings = &inputBinding;
+
+    if (inputAttachmentLayout_ != VK_NULL_HANDLE) vkDestroyDescriptorSetLayout(device_, inputAttachmentLayout_, nullptr);
+    res = vkCreateDescriptorSetLayout(device_, &ci, nullptr, &inputAttachmentLayout_);
+    if (res != VK_SUCCESS) {
+        LOGE("vkCreateDescriptorSetLayout for input attachments failed: %d", res);
+        return false;
+    }
+    return true;
+}
+
+bool VulkanRenderer::createPipelineLayout() {
+    static_assert(sizeof(PyramidPushConstants) <= sizeof(PassPushConstants), "push range is sizeof(PassPushConstants)");
+    // Set 2 is the blur pyramid level read by BLUR and BLOOM (blur_pyramid.h).
+    const VkDescriptorSetLayout setLayouts[] = { descriptorSetLayout_, chainSetLayout_, descriptorSetLayout_ };
+    auto ci = makeStruct<VkPipelineLayoutCreateInfo>(VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO);
+    ci.setLayoutCount = 3;
+    ci.pSetLayouts = setLayouts;
+
+    VkPushConstantRange push{};
+    push.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    push.offset = 0;
+    push.size = sizeof(PassPushConstants);
+    ci.pushConstantRangeCount = 1;
+    ci.pPushConstantRanges = &push;
+
+    if (pipelineLayout_ != VK_NULL_HANDLE) vkDestroyPipelineLayout(device_, pipelineLayout_, nullptr);
+    VkResult res = vkCreatePipelineLayout(device_, &ci, nullptr, &pipelineLayout_);
+    if (res != VK_SUCCESS) {
+        LOGE("vkCreatePipelineLayout failed: %d", res);
+        return false;
+    }
+
+    const VkDescriptorSetLayout subpassLayouts[] = { inputAttachmentLayout_, chainSetLayout_ };
+    ci.setLayoutCount = 2;
+    ci.pSetLayouts = subpassLayouts;
+    if (subpassPipelineLayout_ != VK_NULL_HANDLE) vkDestroyPipelineLayout(device_, subpassPipelineLayout_, nullptr);
+    res = vkCreatePipelineLayout(device_, &ci, nullptr, &subpassPipelineLayout_);
+    if (res != VK_SUCCESS) {
+        LOGE("vkCreatePipelineLayout for the merged tail failed: %d", res);
+        return false;
+    }
+
+    // Glass panels: level 0 of their pyramid and a larger push block of their own.
+    push.size = sizeof(GlassPushConstants);
+    ci.setLayoutCount = 1;
+    ci.pSetLayouts = &descriptorSetLayout_;
+    if (glassPipelineLayout_ != VK_NULL_HANDLE) vkDestroyPipelineLayout(device_, glassPipelineLayout_, nullptr);
+    res = vkCreatePipelineLayout(device_, &ci, nullptr, &glassPipelineLayout_);
+    if (res != VK_SUCCESS) {
+        LOGE("vkCreatePipelineLayout for the glass panels failed: %d", res);
+        return false;
+    }
+    return true;
+}
+
+bool VulkanRenderer::createGraphicsPipeline() {
+    // Other variants are built lazily; warm the plain camera pass so the first frame
+    // does not stall on pipeline creation.
+    return pipelineVariant(FrameResources{}, lumina::EffectPass{}, true, false) != VK_NULL_HANDLE;
+}
+
+VkPipeline VulkanRenderer::pipelineVariant(const FrameResources& frame, const lumina::EffectPass& pass,
+                                           bool lastPass, bool ycbcr, bool merged) {
+    const uint32_t flags = (lastPass ? lumina::kVariantLastPass : 0u) |
+                           (ycbcr ? lumina::kVariantExternalInput : 0u) |
+                           (merged ? lumina::kVariantSubpass : 0u);
+    // Both subpasses of the merged tail are surface-sized, so both draw pre-rotated.
+    const uint32_t turns = (lastPass || merged) ? swapchain_.quarterTurns : 0u;
+    const uint64_t key = lumina::effectVariantKey(pass, frame.effects, frame.renderMode, flags,
+                                                  static_cast<uint32_t>(swapchain_.format), turns);
+    auto it = pipelineVariants_.find(key);
+    if (it != pipelineVariants_.end()) return it->second;
+
+    // The merged tail's last pass reads the previous subpass instead of a texture.
+    const bool tileInput = merged && lastPass;
+    const std::vector<uint32_t>* fragSpv = tileInput ? &kChainSubpassFragSpv : &kFragSpv;
+    switch (pass.head) {
+        case lumina::EffectType::BLUR: fragSpv = &kBlurFragSpv; break;
+        case lumina::EffectType::CHROMATIC_ABERRATION: fragSpv = &kChromaticFragSpv; break;
+        case lumina::EffectType::SHARPEN: fragSpv = &kSharpenFragSpv; break;
+        default: break;
+    }
+    VkPipelineLayout layout = ycbcr ? ycbcr_.pipelineLayout
+                            : tileInput ? subpassPipelineLayout_
+                            : pipelineLayout_;
+    if (layout == VK_NULL_HANDLE) return VK_NULL_HANDLE;
+
+    VariantConstants constants{};
+    constants.opCount = pass.opCount;
+    for (uint8_t i = 0; i < pass.opCount; ++i) {
+        constants.opTypes[i] = static_cast<uint32_t>(frame.effects[pass.ops[i]].type);
+    }
+    constants.renderMode = static_cast<uint32_t>(frame.renderMode);
+    constants.lastPass = lastPass ? VK_TRUE : VK_FALSE;
+
+    VkSpecializationInfo spec{};
+    spec.mapEntryCount = static_cast<uint32_t>(kVariantConstantMap.size());
+    spec.pMapEntries = kVariantConstantMap.data();
+    spec.dataSize = sizeof(constants);
+    spec.pData = &constants;
+
+    VkPipeline pipeline = VK_NULL_HANDLE;
+    if (!buildPipeline(layout, *fragSpv, &spec, pipeline, merged ? mergedRenderPass_ : VK_NULL_HANDLE,
+                       tileInput ? 1u : 0u, turns)) {
+        return VK_NULL_HANDLE;
+    }
+    pipelineVariants_.emplace(key, pipeline);
+    return pipeline;
+}
+
+void VulkanRenderer::destroyPipelineVariants(bool ycbcrOnly) {
+    for (auto it = pipelineVariants_.begin(); it != pipelineVariants_.end();) {
+        if (ycbcrOnly && (it->first & lumina::kVariantExternalInput) == 0) {
+            ++it;
+            continue;
+        }
+        vkDestroyPipeline(device_, it->second, nullptr);
+        it = pipelineVariants_.erase(it);
+    }
+}
+
+bool VulkanRenderer::createPipelineCache() {
+    // The driver validates its own header too, but some drivers misbehave on foreign
+    // data, so only hand back caches written by this exact device and driver build.
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(physicalDevice_, &props);
+    char id[128];
+    int len = snprintf(id, sizeof(id), "vk:%08x:%08x:%08x:", props.vendorID, props.deviceID, props.driverVersion);
+    driverId_.assign(id, static_cast<size_t>(len));
+    for (uint8_t byte : props.pipelineCacheUUID) {
+        snprintf(id, sizeof(id), "%02x", byte);
+        driverId_ += id;
+    }
+
+    std::vector<uint8_t> initialData;
+    if (!cacheDir_.empty() && lumina::readCacheFile(cacheDir_ + "/vulkan_pipelines.bin", driverId_, initialData)) {
+        LOGI("Loaded %zu byte pipeline cache", initialData.size());
+    }
+
+    auto ci = makeStruct<VkPipelineCacheCreateInfo>(VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO);
+    ci.initialDataSize = initialData.size();
+    ci.pInitialData = initialData.empty() ? nullptr : initialData.data();
+    VkResult res = vkCreatePipelineCache(device_, &ci, nullptr, &pipelineCache_);
+    if (res != VK_SUCCESS && !initialData.empty()) {
+        LOGW("Discarding rejected pipeline cache: %d", res);
+        ci.initialDataSize = 0;
+        ci.pInitialData = nullptr;
+        res = vkCreatePipelineCache(device_, &ci, nullptr, &pipelineCache_);
+    }
+    if (res != VK_SUCCESS) {
+        LOGE("vkCreatePipelineCache failed: %d", res);
+        return false;
+    }
+    pipelineCacheDirty_ = false;
+    return true;
+}
+
+void VulkanRenderer::savePipelineCache() {
+    if (pipelineCache_ == VK_NULL_HANDLE || !pipelineCacheDirty_ || cacheDir_.empty()) return;
+
+    size_t size = 0;
+    if (vkGetPipelineCacheData(device_, pipelineCache_, &size, nullptr) != VK_SUCCESS || size == 0) return;
+    std::vector<uint8_t> data(size);
+    if (vkGetPipelineCacheData(device_, pipelineCache_, &size, data.data()) != VK_SUCCESS) return;
+
+    if (lumina::writeCacheFile(cacheDir_ + "/vulkan_pipelines.bin", driverId_, data.data(), size)) {
+        pipelineCacheDirty_ = false;
+    } else {
+        LOGW("Failed to write pipeline cache to %s", cacheDir_.c_str());
+    }
+}
+
+void VulkanRenderer::destroyPipelineCache() {
+    savePipelineCache();
+    if (pipelineCache_ != VK_NULL_HANDLE) {
+        vkDestroyPipelineCache(device_, pipelineCache_, nullptr);
+        pipelineCache_ = VK_NULL_HANDLE;
+    }
+}
+
+bool VulkanRenderer::buildPipeline(VkPipelineLayout layout, const std::vector<uint32_t>& fragSpv,
+                                   const VkSpecializationInfo* specialization, VkPipeline& pipeline,
+                                   VkRenderPass renderPass, uint32_t subpass, uint32_t quarterTurns, bool blend) {
+    auto createShaderModule = [&](const std::vector<uint32_t>& code, VkShaderModule& out) {
+        auto ci = makeStruct<VkShaderModuleCreateInfo>(VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO);
+        ci.codeSize = code.size() * sizeof(uint32_t);
+        ci.pCode = code.data();
+        return vkCreateShaderModule(device_, &ci, nullptr, &out) == VK_SUCCESS;
+    };
+
+    const std::vector<uint32_t> vs(kVertSpv.begin(), kVertSpv.end());
+    const std::vector<uint32_t> fs(fragSpv.begin(), fragSpv.end());
+    VkShaderModule vertModule = VK_NULL_HANDLE;
+    VkShaderModule fragModule = VK_NULL_HANDLE;
+    if (!createShaderModule(vs, vertModule) || !createShaderModule(fs, fragModule)) {
+        LOGE("Failed to create shader modules");
+        if (vertModule) vkDestroyShaderModule(device_, vertModule, nullptr);
+        if (fragModule) vkDestroyShaderModule(device_, fragModule, nullptr);
+        return false;
+    }
+
+    VkPipelineShaderStageCreateInfo stages[2]{};
+    stages[0].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[0].stage = VK_SHADER_STAGE_VERTEX_BIT;
+    stages[0].module = vertModule;
+    stages[0].pName = "main";
+    // passthrough.vert PRE_ROTATION
+    const VkSpecializationMapEntry rotationEntry{ 7, 0, sizeof(uint32_t) };
+    const VkSpecializationInfo rotation{ 1, &rotationEntry, sizeof(uint32_t), &quarterTurns };
+    stages[0].pSpecializationInfo = quarterTurns != 0 ? &rotation : nullptr;
+
+    stages[1].sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
+    stages[1].stage = VK_SHADER_STAGE_FRAGMENT_BIT;
+    stages[1].module = fragModule;
+    stages[1].pName = "main";
+    stages[1].pSpecializationInfo = specialization;
+
+    auto vertexInput = makeStruct<VkPipelineVertexInputStateCreateInfo>(VK_STRUCTURE_TYPE_PIPELINE_VERTEX_INPUT_STATE_CREATE_INFO);
+    auto inputAssembly = makeStruct<VkPipelineInputAssemblyStateCreateInfo>(VK_STRUCTURE_TYPE_PIPELINE_INPUT_ASSEMBLY_STATE_CREATE_INFO);
+    inputAssembly.topology = VK_PRIMITIVE_TOPOLOGY_TRIANGLE_STRIP;
+    inputAssembly.primitiveRestartEnable = VK_FALSE;
+
+    VkViewport viewport{};
+    viewport.x = 0;
+    viewport.y = 0;
+    viewport.width = static_cast<float>(swapchain_.width);
+    viewport.height = static_cast<float>(swapchain_.height);
+    viewport.minDepth = 0.f;
+    viewport.maxDepth = 1.f;
+
+    VkRect2D scissor{};
+    scissor.offset = {0, 0};
+    scissor.extent = {swapchain_.width, swapchain_.height};
+
+    auto viewportState = makeStruct<VkPipelineViewportStateCreateInfo>(VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO);
+    viewportState.viewportCount = 1;
+    viewportState.pViewports = &viewport;
+    viewportState.scissorCount = 1;
+    viewportState.pScissors = &scissor;
+
+    auto raster = makeStruct<VkPipelineRasterizationStateCreateInfo>(VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO);
+    raster.depthClampEnable = VK_FALSE;
+    raster.rasterizerDiscardEnable = VK_FALSE;
+    raster.polygonMode = VK_POLYGON_MODE_FILL;
+    raster.cullMode = VK_CULL_MODE_NONE;
+    raster.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
+    raster.depthBiasEnable = VK_FALSE;
+    raster.lineWidth = 1.0f;
+
+    auto msaa = makeStruct<VkPipelineMultisampleStateCreateInfo>(VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO);
+    msaa.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+
+    VkPipelineColorBlendAttachmentState attachmentBlend{};
+    attachmentBlend.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
+    attachmentBlend.blendEnable = blend ? VK_TRUE : VK_FALSE;
+    // Alpha is coverage over what the attachment holds, which keeps its own alpha.
+    attachmentBlend.srcColorBlendFactor = VK_BLEND_FACTOR_SRC_ALPHA;
+    attachmentBlend.dstColorBlendFactor = VK_BLEND_FACTOR_ONE_MINUS_SRC_ALPHA;
+    attachmentBlend.colorBlendOp = VK_BLEND_OP_ADD;
+    attachmentBlend.srcAlphaBlendFactor = VK_BLEND_FACTOR_ZERO;
+    attachmentBlend.dstAlphaBlendFactor = VK_BLEND_FACTOR_ONE;
+    attachmentBlend.alphaBlendOp = VK_BLEND_OP_ADD;
+
+    auto blendState = makeStruct<VkPipelineColorBlendStateCreateInfo>(VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO);
+    blendState.attachmentCount = 1;
+    blendState.pAttachments = &attachmentBlend;
+
+    VkDynamicState dynamics[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
+    auto dyn = makeStruct<VkPipelineDynamicStateCreateInfo>(VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO);
+    dyn.dynamicStateCount = 2;
+    dyn.pDynamicStates = dynamics;
+
+    auto gp = makeStruct<VkGraphicsPipelineCreateInfo>(VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO);
+    gp.stageCount = 2;
+    gp.pStages = stages;
+    gp.pVertexInputState = &vertexInput;
+    gp.pInputAssemblyState = &inputAssembly;
+    gp.pViewportState = &viewportState;
+    gp.pRasterizationState = &raster;
+    gp.pMultisampleState = &msaa;
+    gp.pDepthStencilState = nullptr;
+    gp.pColorBlendState = &blendState;
+    gp.pDynamicState = &dyn;
+    gp.layout = layout;
+    gp.renderPass = renderPass != VK_NULL_HANDLE ? renderPass : renderPass_;
+    gp.subpass = subpass;
+
+    if (pipeline != VK_NULL_HANDLE) vkDestroyPipeline(device_, pipeline, nullptr);
+    pipeline = VK_NULL_HANDLE;
+    VkResult res = vkCreateGraphicsPipelines(device_, pipelineCache_, 1, &gp, nullptr, &pipeline);
+    pipelineCacheDirty_ = true;
+    vkDestroyShaderModule(device_, vertModule, nullptr);
+    vkDestroyShaderModule(device_, fragModule, nullptr);
+    if (res != VK_SUCCESS) {
+        LOGE("vkCreateGraphicsPipelines failed: %d", res);
+        return false;
+    }
+    return true;
+}
+
+bool VulkanRenderer::createFramebuffers() {
+    for (auto fb : framebuffers_) vkDestroyFramebuffer(device_, fb, nullptr);
+    framebuffers_.clear();
+    for (auto v : swapchain_.imageViews) if (v) vkDestroyImageView(device_, v, nullptr);
+    swapchain_.imageViews.clear();
+
+    framebuffers_.resize(swapchain_.images.size());
+    swapchain_.imageViews.resize(swapchain_.images.size());
+
+    for (size_t i = 0; i < swapchain_.images.size(); ++i) {
+        auto vi = makeStruct<VkImageViewCreateInfo>(VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO);
+        vi.image = swapchain_.images[i];
+        vi.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        vi.format = swapchain_.format;
+        vi.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        vi.subresourceRange.levelCount = 1;
+        vi.subresourceRange.layerCount = 1;
+        if (vkCreateImageView(device_, &vi, nullptr, &swapchain_.imageViews[i]) != VK_SUCCESS) {
+            LOGE("vkCreateImageView failed for swapchain image %zu", i);
+            return false;
+        }
+
+        VkImageView attachments[] = { swapchain_.imageViews[i] };
+        auto fi = makeStruct<VkFramebufferCreateInfo>(VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO);
+        fi.renderPass = renderPass_;
+        fi.attachmentCount = 1;
+        fi.pAttachments = attachments;
+        fi.width = swapchain_.width;
+        fi.height = swapchain_.height;
+        fi.layers = 1;
+        if (vkCreateFramebuffer(device_, &fi, nullptr, &framebuffers_[i]) != VK_SUCCESS) {
+            LOGE("vkCreateFramebuffer failed for idx %zu", i);
+            return false;
+        }
+    }
+    // The effect targets follow at the next render(), once it sees their size is off.
+    return createMergedTargets();
+}
+
+bool VulkanRenderer::createIntermediateTargets() {
+    destroyIntermediateTargets();
+
+    // One sampler set per ping-pong target and pyramid level, glass levels included.
+    const uint32_t sets = static_cast<uint32_t>(targets_.size() + pyramid_.size() + glassPyramid_.size());
+    VkDescriptorPoolSize poolSize{ VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER, sets };
+    auto pi = makeStruct<VkDescriptorPoolCreateInfo>(VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO);
+    pi.poolSizeCount = 1;
+    pi.pPoolSizes = &poolSize;
+    pi.maxSets = sets;
+    if (vkCreateDescriptorPool(device_, &pi, nullptr, &targetDescriptorPool_) != VK_SUCCESS) {
+        LOGE("vkCreateDescriptorPool for effect targets failed");
+        return false;
+    }
+    std::vector<VkDescriptorSetLayout> layouts(sets, descriptorSetLayout_);
+    std::vector<VkDescriptorSet> allocated(sets);
+    auto ai = makeStruct<VkDescriptorSetAllocateInfo>(VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO);
+    ai.descriptorPool = targetDescriptorPool_;
+    ai.descriptorSetCount = sets;
+    ai.pSetLayouts = layouts.data();
+    if (vkAllocateDescriptorSets(device_, &ai, allocated.data()) != VK_SUCCESS) {
+        LOGE("vkAllocateDescriptorSets for effect targets failed");
+        return false;
+    }
+
+    // Effect passes run in the window's orientation; only the surface pass is rotated.
+    const VkExtent2D surface = surfaceExtent();
+    renderExtent_ = { lumina::scaledExtent(surface.width, renderScale_),
+                      lumina::scaledExtent(surface.height, renderScale_) };
+    for (size_t i = 0; i < targets_.size(); ++i) {
+        if (!createTarget(targets_[i], renderExtent_)) return false;
+        targets_[i].descriptorSet = allocated[i];
+    }
+
+    // Pyramid levels for the largest blur planBlur() would ask for at this size.
+    const lumina::BlurPlan plan = lumina::planBlur(1e9f, renderExtent_.width, renderExtent_.height);
+    for (pyramidLevels_ = 0; pyramidLevels_ < plan.levels; ++pyramidLevels_) {
+        const VkExtent2D extent{ plan.widths[pyramidLevels_], plan.heights[pyramidLevels_] };
+        if (!createTarget(pyramid_[pyramidLevels_], extent)) return false;
+    }
+    for (size_t i = 0; i < pyramid_.size(); ++i) pyramid_[i].descriptorSet = allocated[targets_.size() + i];
+
+    // The glass pyramid starts from a blit of a swapchain image, so it takes the images'
+    // own orientation. Without it the panels stay unblurred; nothing else depends on it.
+    // Targets share the swapchain format, so the one format serves both ends of the blit.
+    VkFormatProperties props{};
+    vkGetPhysicalDeviceFormatProperties(physicalDevice_, swapchain_.format, &props);
+    const VkFormatFeatureFlags blit = VK_FORMAT_FEATURE_BLIT_SRC_BIT | VK_FORMAT_FEATURE_BLIT_DST_BIT;
+    if (!headless_ && (swapchain_.usage & VK_IMAGE_USAGE_TRANSFER_SRC_BIT) &&
+        (props.optimalTilingFeatures & blit) == blit) {
+        glassFilter_ = (props.optimalTilingFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_FILTER_LINEAR_BIT)
+            ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+        glassExtent_ = { lumina::scaledExtent(swapchain_.width, renderScale_),
+                         lumina::scaledExtent(swapchain_.height, renderScale_) };
+        const lumina::BlurPlan glassPlan = lumina::planBlur(1e9f, glassExtent_.width, glassExtent_.height);
+        for (glassLevels_ = 0; glassLevels_ < glassPlan.levels; ++glassLevels_) {
+            const VkExtent2D extent{ glassPlan.widths[glassLevels_], glassPlan.heights[glassLevels_] };
+            const VkImageUsageFlags usage = glassLevels_ == 0 ? VK_IMAGE_USAGE_TRANSFER_DST_BIT : 0;
+            if (!createTarget(glassPyramid_[glassLevels_], extent, usage)) {
+                LOGW("Glass pyramid unavailable; glass panels stay unblurred");
+                for (auto& level : glassPyramid_) destroyTarget(level);
+                glassLevels_ = 0;
+                break;
+            }
+        }
+    }
+    const size_t glassSets = targets_.size() + pyramid_.size();
+    for (size_t i = 0; i < glassPyramid_.size(); ++i) glassPyramid_[i].descriptorSet = allocated[glassSets + i];
+    writeTargetDescriptors();
+    return true;
+}
+
+bool VulkanRenderer::createTarget(IntermediateTarget& target, VkExtent2D extent, VkImageUsageFlags extraUsage) {
+    auto ci = makeStruct<VkImageCreateInfo>(VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO);
+    ci.imageType = VK_IMAGE_TYPE_2D;
+    ci.extent = { extent.width, extent.height, 1 };
+    ci.mipLevels = 1;
+    ci.arrayLayers = 1;
+    ci.format = swapchain_.format;
+    ci.tiling = VK_IMAGE_TILING_OPTIMAL;
+    ci.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    ci.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_SAMPLED_BIT | extraUsage;
+    ci.samples = VK_SAMPLE_COUNT_1_BIT;
+    ci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateImage(device_, &ci, nullptr, &target.image) != VK_SUCCESS) {
+        LOGE("vkCreateImage for effect target failed");
+        return false;
+    }
+
+    if (!allocateImageMemory(target.image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0,
+                             lumina::GpuMemoryCategory::Targets, target.memory)) {
+        LOGE("Failed to allocate effect target memory");
+        return false;
+    }
+
+    auto vi = makeStruct<VkImageViewCreateInfo>(VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO);
+    vi.image = target.image;
+    vi.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    vi.format = swapchain_.format;
+    vi.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    vi.subresourceRange.levelCount = 1;
+    vi.subresourceRange.layerCount = 1;
+    if (vkCreateImageView(device_, &vi, nullptr, &target.view) != VK_SUCCESS) {
+        LOGE("vkCreateImageView for effect target failed");
+        return false;
+    }
+
+    auto fi = makeStruct<VkFramebufferCreateInfo>(VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO);
+    fi.renderPass = offscreenRenderPass_;
+    fi.attachmentCount = 1;
+    fi.pAttachments = &target.view;
+    fi.width = extent.width;
+    fi.height = extent.height;
+    fi.layers = 1;
+    if (vkCreateFramebuffer(device_, &fi, nullptr, &target.framebuffer) != VK_SUCCESS) {
+        LOGE("vkCreateFramebuffer for effect target failed");
+        return false;
+    }
+    return true;
+}
+
+bool VulkanRenderer::createMergedTargets() {
+    destroyMergedTargets();
+    if (mergedRenderPass_ == VK_NULL_HANDLE || swapchain_.images.empty()) return true;
+
+    // One input attachment set per target, retired together with them.
+    const uint32_t sets = static_cast<uint32_t>(swapchain_.images.size());
+    VkDescriptorPoolSize poolSize{ VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT, sets };
+    auto pi = makeStruct<VkDescriptorPoolCreateInfo>(VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO);
+    pi.poolSizeCount = 1;
+    pi.pPoolSizes = &poolSize;
+    pi.maxSets = sets;
+    if (vkCreateDescriptorPool(device_, &pi, nullptr, &mergedDescriptorPool_) != VK_SUCCESS) {
+        LOGE("vkCreateDescriptorPool for the merged tail failed");
+        return false;
+    }
+    std::vector<VkDescriptorSetLayout> layouts(sets, inputAttachmentLayout_);
+    std::vector<VkDescriptorSet> allocated(sets);
+    auto ai = makeStruct<VkDescriptorSetAllocateInfo>(VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO);
+    ai.descriptorPool = mergedDescriptorPool_;
+    ai.descriptorSetCount = sets;
+    ai.pSetLayouts = layouts.data();
+    if (vkAllocateDescriptorSets(device_, &ai, allocated.data()) != VK_SUCCESS) {
+        LOGE("vkAllocateDescriptorSets for the merged tail failed");
+        return false;
+    }
+
+    mergedTargets_.resize(swapchain_.images.size());
+    for (size_t i = 0; i < mergedTargets_.size(); ++i) {
+        IntermediateTarget& target = mergedTargets_[i];
+        auto ci = makeStruct<VkImageCreateInfo>(VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO);
+        ci.imageType = VK_IMAGE_TYPE_2D;
+        ci.extent = { swapchain_.width, swapchain_.height, 1 };
+        ci.mipLevels = 1;
+        ci.arrayLayers = 1;
+        ci.format = swapchain_.format;
+        ci.tiling = VK_IMAGE_TILING_OPTIMAL;
+        ci.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+        ci.usage = VK_IMAGE_USAGE_COLOR_ATTACHMENT_BIT | VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT |
+                   VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT;
+        ci.samples = VK_SAMPLE_COUNT_1_BIT;
+        ci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+        if (vkCreateImage(device_, &ci, nullptr, &target.image) != VK_SUCCESS) {
+            LOGE("vkCreateImage for merged tail target failed");
+            return false;
+        }
+
+        // Lazily allocated memory is only committed if the driver has to spill the
+        // tile; desktop-style GPUs do not offer it and get ordinary device memory.
+        if (!allocateImageMemory(target.image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
+                                 VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT, lumina::GpuMemoryCategory::Targets,
+                                 target.memory)) {
+            LOGE("Failed to allocate merged tail target memory");
+            return false;
+        }
+
+        auto vi = makeStruct<VkImageViewCreateInfo>(VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO);
+        vi.image = target.image;
+        vi.viewType = VK_IMAGE_VIEW_TYPE_2D;
+        vi.format = swapchain_.format;
+        vi.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+        vi.subresourceRange.levelCount = 1;
+        vi.subresourceRange.layerCount = 1;
+        if (vkCreateImageView(device_, &vi, nullptr, &target.view) != VK_SUCCESS) {
+            LOGE("vkCreateImageView for merged tail target failed");
+            return false;
+        }
+
+        VkImageView attachments[] = { target.view, swapchain_.imageViews[i] };
+        auto fi = makeStruct<VkFramebufferCreateInfo>(VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO);
+        fi.renderPass = mergedRenderPass_;
+        fi.attachmentCount = 2;
+        fi.pAttachments = attachments;
+        fi.width = swapchain_.width;
+        fi.height = swapchain_.height;
+        fi.layers = 1;
+        if (vkCreateFramebuffer(device_, &fi, nullptr, &target.framebuffer) != VK_SUCCESS) {
+            LOGE("vkCreateFramebuffer for merged tail failed for idx %zu", i);
+            return false;
+        }
+
+        target.descriptorSet = allocated[i];
+        VkDescriptorImageInfo ii{};
+        ii.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        ii.imageView = target.view;
+
+        auto inputWrite = makeStruct<VkWriteDescriptorSet>(VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET);
+        inputWrite.dstSet = target.descriptorSet;
+        inputWrite.dstBinding = 0;
+        inputWrite.descriptorType = VK_DESCRIPTOR_TYPE_INPUT_ATTACHMENT;
+        inputWrite.descriptorCount = 1;
+        inputWrite.pImageInfo = &ii;
+        vkUpdateDescriptorSets(device_, 1, &inputWrite, 0, nullptr);
+    }
+    return true;
+}
+
+void VulkanRenderer::destroyTarget(IntermediateTarget& target) {
+    if (target.framebuffer != VK_NULL_HANDLE) vkDestroyFramebuffer(device_, target.framebuffer, nullptr);
+    if (target.view != VK_NULL_HANDLE) vkDestroyImageView(device_, target.view, nullptr);
+    if (target.image != VK_NULL_HANDLE) vkDestroyImage(device_, target.image, nullptr);
+    freeMemory(target.memory);
+    target = IntermediateTarget{}; // descriptor sets are owned by their pool
+}
+
+void VulkanRenderer::destroyIntermediateTargets() {
+    for (auto& target : targets_) destroyTarget(target);
+    for (auto& level : pyramid_) destroyTarget(level);
+    for (auto& level : glassPyramid_) destroyTarget(level);
+    pyramidLevels_ = 0;
+    glassLevels_ = 0;
+    renderExtent_ = {};
+    glassExtent_ = {};
+    if (targetDescriptorPool_ != VK_NULL_HANDLE) {
+        vkDestroyDescriptorPool(device_, targetDescriptorPool_, nullptr);
+        targetDescriptorPool_ = VK_NULL_HANDLE;
+    }
+}
+
+void VulkanRenderer::destroyMergedTargets() {
+    for (auto& target : mergedTargets_) destroyTarget(target);
+    mergedTargets_.clear();
+    if (mergedDescriptorPool_ != VK_NULL_HANDLE) {
+        vkDestroyDescriptorPool(device_, mergedDescriptorPool_, nullptr);
+        mergedDescriptorPool_ = VK_NULL_HANDLE;
+    }
+}
+
+bool VulkanRenderer::applyRenderScale() {
+    // Frames in flight still render into and sample the old targets.
+    RetiredResources retired;
+    retired.frame = currentFrame_;
+    retireIntermediateTargets(retired);
+    if (!retired.descriptorPools.empty()) retired_.push_back(std::move(retired));
+    if (!createIntermediateTargets()) return false;
+    LOGI("Effect passes now render at %ux%u", renderExtent_.width, renderExtent_.height);
+    return true;
+}
+
+void VulkanRenderer::writeTargetDescriptors() {
+    const auto write = [this](const IntermediateTarget& target) {
+        // Levels the current size has no room for keep whatever they held; they are never bound.
+        if (target.descriptorSet == VK_NULL_HANDLE || target.view == VK_NULL_HANDLE) return;
+        VkDescriptorImageInfo ii{};
+        ii.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        ii.imageView = target.view;
+        ii.sampler = textureSampler_;
+
+        auto w = makeStruct<VkWriteDescriptorSet>(VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET);
+        w.dstSet = target.descriptorSet;
+        w.dstBinding = 0;
+        w.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        w.descriptorCount = 1;
+        w.pImageInfo = &ii;
+        vkUpdateDescriptorSets(device_, 1, &w, 0, nullptr);
+    };
+    for (const auto& target : targets_) write(target);
+    for (const auto& level : pyramid_) write(level);
+    for (const auto& level : glassPyramid_) write(level);
+}
+
+bool VulkanRenderer::createEffectChainBuffer() {
+    destroyEffectChainBuffer();
+
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(physicalDevice_, &props);
+    const VkDeviceSize align = std::max<VkDeviceSize>(props.limits.minUniformBufferOffsetAlignment, 1);
+    chainStride_ = (kChainBlockSize + align - 1) / align * align;
+
+    auto bi = makeStruct<VkBufferCreateInfo>(VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO);
+    bi.size = chainStride_ * kMaxFramesInFlight;
+    bi.usage = VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT;
+    bi.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(device_, &bi, nullptr, &chainBuffer_) != VK_SUCCESS) {
+        LOGE("vkCreateBuffer for effect chain failed");
+        return false;
+    }
+
+    if (!allocateBufferMemory(chainBuffer_, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                              0, lumina::GpuMemoryCategory::Uniforms, chainMemory_)) {
+        LOGE("Failed to allocate effect chain memory");
+        return false;
+    }
+    chainMapped_ = chainMemory_.mapped;
+    memset(chainMapped_, 0, static_cast<size_t>(bi.size));
+    return true;
+}
+
+void VulkanRenderer::destroyEffectChainBuffer() {
+    if (chainBuffer_ != VK_NULL_HANDLE) {
+        vkDestroyBuffer(device_, chainBuffer_, nullptr);
+        chainBuffer_ = VK_NULL_HANDLE;
+    }
+    freeMemory(chainMemory_);
+    chainMapped_ = nullptr;
+}
+
+bool VulkanRenderer::createTextureResources() {
+    // 1x1 placeholder keeps the descriptors valid until the first camera upload lands in the ring.
+    uint32_t width = 1, height = 1;
+    auto ci = makeStruct<VkImageCreateInfo>(VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO);
+    ci.imageType = VK_IMAGE_TYPE_2D;
+    ci.extent = { width, height, 1 };
+    ci.mipLevels = 1;
+    ci.arrayLayers = 1;
+    ci.format = VK_FORMAT_R8G8B8A8_UNORM;
+    ci.tiling = VK_IMAGE_TILING_OPTIMAL;
+    ci.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    ci.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    ci.samples = VK_SAMPLE_COUNT_1_BIT;
+    ci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+
+    if (vkCreateImage(device_, &ci, nullptr, &textureImage_) != VK_SUCCESS) {
+        LOGE("vkCreateImage for texture failed");
+        return false;
+    }
+
+    if (!allocateImageMemory(textureImage_, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0,
+                             lumina::GpuMemoryCategory::Textures, textureMemory_)) {
+        LOGE("Failed to allocate texture memory");
+        return false;
+    }
+
+    // Transition to shader-read layout so descriptors are valid even before uploads.
+    auto cbAlloc = makeStruct<VkCommandBufferAllocateInfo>(VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO);
+    cbAlloc.commandPool = commandPool_;
+    cbAlloc.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    cbAlloc.commandBufferCount = 1;
+    VkCommandBuffer cmd;
+    if (vkAllocateCommandBuffers(device_, &cbAlloc, &cmd) != VK_SUCCESS) {
+        LOGE("Failed to allocate temp command buffer for texture layout transition");
+        return false;
+    }
+    auto bi = makeStruct<VkCommandBufferBeginInfo>(VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO);
+    bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(cmd, &bi);
+    auto barrier = makeStruct<VkImageMemoryBarrier>(VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER);
+    barrier.srcAccessMask = 0;
+    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
+    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = textureImage_;
+    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    barrier.subresourceRange.levelCount = 1;
+    barrier.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(cmd,
+                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
+                         0,
+                         0, nullptr,
+                         0, nullptr,
+                         1, &barrier);
+    vkEndCommandBuffer(cmd);
+    auto si = makeStruct<VkSubmitInfo>(VK_STRUCTURE_TYPE_SUBMIT_INFO);
+    si.commandBufferCount = 1;
+    si.pCommandBuffers = &cmd;
+    vkQueueSubmit(graphicsQueue_, 1, &si, VK_NULL_HANDLE);
+    vkQueueWaitIdle(graphicsQueue_);
+    vkFreeCommandBuffers(device_, commandPool_, 1, &cmd);
+
+    auto vi = makeStruct<VkImageViewCreateInfo>(VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO);
+    vi.image = textureImage_;
+    vi.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    vi.format = VK_FORMAT_R8G8B8A8_UNORM;
+    vi.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    vi.subresourceRange.levelCount = 1;
+    vi.subresourceRange.layerCount = 1;
+    if (vkCreateImageView(device_, &vi, nullptr, &textureView_) != VK_SUCCESS) {
+        LOGE("vkCreateImageView for texture failed");
+        return false;
+    }
+    return true;
+}
+
+bool VulkanRenderer::createSampler() {
+    auto ci = makeStruct<VkSamplerCreateInfo>(VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO);
+    ci.magFilter = VK_FILTER_LINEAR;
+    ci.minFilter = VK_FILTER_LINEAR;
+    ci.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    ci.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    ci.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    ci.anisotropyEnable = VK_FALSE;
+    ci.maxAnisotropy = 1.0f;
+    ci.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+    ci.unnormalizedCoordinates = VK_FALSE;
+    ci.compareEnable = VK_FALSE;
+    ci.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
+    if (vkCreateSampler(device_, &ci, nullptr, &textureSampler_) != VK_SUCCESS) {
+        LOGE("vkCreateSampler failed");
+        return false;
+    }
+    return true;
+}
+
+bool VulkanRenderer::createDescriptorPoolAndSets() {
+    if (descriptorPool_ != VK_NULL_HANDLE) {
+        vkDestroyDescriptorPool(device_, descriptorPool_, nullptr);
+        descriptorPool_ = VK_NULL_HANDLE;
+    }
+
+    // Placeholder camera sets, one per frame slot, and the chain set. Anything sized by
+    // the swapchain takes its sets from its own pool.
+    std::array<VkDescriptorPoolSize, 2> poolSizes{};
+    poolSizes[0].type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSizes[0].descriptorCount = kMaxFramesInFlight;
+    poolSizes[1].type = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    poolSizes[1].descriptorCount = 1;
+
+    auto pi = makeStruct<VkDescriptorPoolCreateInfo>(VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO);
+    pi.poolSizeCount = static_cast<uint32_t>(poolSizes.size());
+    pi.pPoolSizes = poolSizes.data();
+    pi.maxSets = kMaxFramesInFlight + 1;
+
+    if (vkCreateDescriptorPool(device_, &pi, nullptr, &descriptorPool_) != VK_SUCCESS) {
+        LOGE("vkCreateDescriptorPool failed");
+        return false;
+    }
+
+    std::vector<VkDescriptorSetLayout> layouts(kMaxFramesInFlight, descriptorSetLayout_);
+    auto ai = makeStruct<VkDescriptorSetAllocateInfo>(VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO);
+    ai.descriptorPool = descriptorPool_;
+    ai.descriptorSetCount = static_cast<uint32_t>(layouts.size());
+    ai.pSetLayouts = layouts.data();
+
+    descriptorSets_.resize(layouts.size());
+    if (vkAllocateDescriptorSets(device_, &ai, descriptorSets_.data()) != VK_SUCCESS) {
+        LOGE("vkAllocateDescriptorSets failed");
+        return false;
+    }
+
+    for (size_t i = 0; i < descriptorSets_.size(); ++i) {
+        VkDescriptorImageInfo ii{};
+        ii.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+        ii.imageView = textureView_;
+        ii.sampler = textureSampler_;
+
+        auto write = makeStruct<VkWriteDescriptorSet>(VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET);
+        write.dstSet = descriptorSets_[i];
+        write.dstBinding = 0;
+        write.dstArrayElement = 0;
+        write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+        write.descriptorCount = 1;
+        write.pImageInfo = &ii;
+        vkUpdateDescriptorSets(device_, 1, &write, 0, nullptr);
+    }
 
-    auto viewportState = makeStruct<VkPipelineViewportStateCreateInfo>(VK_STRUCTURE_TYPE_PIPELINE_VIEWPORT_STATE_CREATE_INFO);
-    viewportState.viewportCount = 1;
-    viewportState.pViewports = &viewport;
-    viewportState.scissorCount = 1;
-    viewportState.pScissors = &scissor;
+    ai.descriptorSetCount = 1;
+    ai.pSetLayouts = &chainSetLayout_;
+    if (vkAllocateDescriptorSets(device_, &ai, &chainSet_) != VK_SUCCESS) {
+        LOGE("vkAllocateDescriptorSets for the effect chain failed");
+        return false;
+    }
 
-    auto raster = makeStruct<VkPipelineRasterizationStateCreateInfo>(VK_STRUCTURE_TYPE_PIPELINE_RASTERIZATION_STATE_CREATE_INFO);
-    raster.depthClampEnable = VK_FALSE;
-    raster.rasterizerDiscardEnable = VK_FALSE;
-    raster.polygonMode = VK_POLYGON_MODE_FILL;
-    raster.cullMode = VK_CULL_MODE_NONE;
-    raster.frontFace = VK_FRONT_FACE_COUNTER_CLOCKWISE;
-    raster.depthBiasEnable = VK_FALSE;
-    raster.lineWidth = 1.0f;
+    VkDescriptorBufferInfo bufferInfo{};
+    bufferInfo.buffer = chainBuffer_;
+    bufferInfo.offset = 0;
+    bufferInfo.range = kChainBlockSize;
+
+    auto write = makeStruct<VkWriteDescriptorSet>(VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET);
+    write.dstSet = chainSet_;
+    write.dstBinding = 0;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER_DYNAMIC;
+    write.descriptorCount = 1;
+    write.pBufferInfo = &bufferInfo;
+    vkUpdateDescriptorSets(device_, 1, &write, 0, nullptr);
+    return true;
+}
 
-    auto msaa = makeStruct<VkPipelineMultisampleStateCreateInfo>(VK_STRUCTURE_TYPE_PIPELINE_MULTISAMPLE_STATE_CREATE_INFO);
-    msaa.rasterizationSamples = VK_SAMPLE_COUNT_1_BIT;
+bool VulkanRenderer::uploadTexture(const void* data, size_t size, uint32_t width, uint32_t height) {
+    LUMINA_TRACE_SCOPE("Vulkan::uploadTexture");
+    if (!data || size == 0 || width == 0 || height == 0) {
+        LOGE("uploadTexture invalid arguments");
+        return false;
+    }
 
-    VkPipelineColorBlendAttachmentState blend{};
-    blend.colorWriteMask = VK_COLOR_COMPONENT_R_BIT | VK_COLOR_COMPONENT_G_BIT | VK_COLOR_COMPONENT_B_BIT | VK_COLOR_COMPONENT_A_BIT;
-    blend.blendEnable = VK_FALSE;
+    const VkDeviceSize expected = static_cast<VkDeviceSize>(width) * static_cast<VkDeviceSize>(height) * 4;
+    if (size < expected) {
+        LOGE("uploadTexture size too small: got %zu, need at least %llu", size, static_cast<unsigned long long>(expected));
+        return false;
+    }
 
-    auto blendState = makeStruct<VkPipelineColorBlendStateCreateInfo>(VK_STRUCTURE_TYPE_PIPELINE_COLOR_BLEND_STATE_CREATE_INFO);
-    blendState.attachmentCount = 1;
-    blendState.pAttachments = &blend;
+    const int index = beginUpload(width, height);
+    if (index < 0) return false;
+    UploadSlot& slot = uploadRing_[static_cast<size_t>(index)];
 
-    VkDynamicState dynamics[] = { VK_DYNAMIC_STATE_VIEWPORT, VK_DYNAMIC_STATE_SCISSOR };
-    auto dyn = makeStruct<VkPipelineDynamicStateCreateInfo>(VK_STRUCTURE_TYPE_PIPELINE_DYNAMIC_STATE_CREATE_INFO);
-    dyn.dynamicStateCount = 2;
-    dyn.pDynamicStates = dynamics;
+    memcpy(slot.mapped, data, static_cast<size_t>(expected));
+    LUMINA_TRACE_COUNTER("Lumina upload bytes", expected);
+    return submitUpload(index);
+}
 
-    auto gp = makeStruct<VkGraphicsPipelineCreateInfo>(VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO);
-    gp.stageCount = 2;
-    gp.pStages = stages;
-    gp.pVertexInputState = &vertexInput;
-    gp.pInputAssemblyState = &inputAssembly;
-    gp.pViewportState = &viewportState;
-    gp.pRasterizationState = &raster;
-    gp.pMultisampleState = &msaa;
-    gp.pDepthStencilState = nullptr;
-    gp.pColorBlendState = &blendState;
-    gp.pDynamicState = &dyn;
-    gp.layout = pipelineLayout_;
-    gp.renderPass = renderPass_;
-    gp.subpass = 0;
+bool VulkanRenderer::uploadYuv(const lumina::YuvPlanes& planes, uint32_t downscale) {
+    LUMINA_TRACE_SCOPE("Vulkan::uploadYuv");
+    const uint32_t width = lumina::downscaledExtent(planes.width, downscale);
+    const uint32_t height = lumina::downscaledExtent(planes.height, downscale);
+    if (width == 0 || height == 0) {
+        LOGE("uploadYuv invalid frame %ux%u at 1/%u", planes.width, planes.height, downscale);
+        return false;
+    }
 
-    if (graphicsPipeline_ != VK_NULL_HANDLE) vkDestroyPipeline(device_, graphicsPipeline_, nullptr);
-    VkResult res = vkCreateGraphicsPipelines(device_, VK_NULL_HANDLE, 1, &gp, nullptr, &graphicsPipeline_);
-    vkDestroyShaderModule(device_, vertModule, nullptr);
-    vkDestroyShaderModule(device_, fragModule, nullptr);
-    if (res != VK_SUCCESS) {
-        LOGE("vkCreateGraphicsPipelines failed: %d", res);
+    const int index = beginUpload(width, height);
+    if (index < 0) return false;
+    UploadSlot& slot = uploadRing_[static_cast<size_t>(index)];
+
+    // Convert straight into the mapped staging buffer: the RGBA frame is written once,
+    // by the CPU, and read once, by the copy below.
+    {
+        LUMINA_TRACE_SCOPE("Vulkan::convertYuv");
+        if (!lumina::convertYuvToRgba(planes, static_cast<uint8_t*>(slot.mapped),
+                                      static_cast<size_t>(width) * 4, downscale)) {
+            LOGE("uploadYuv rejected planes (strides %u/%u/%u, 1/%u)",
+                 planes.yRowStride, planes.uvRowStride, planes.uvPixelStride, downscale);
+            return false;
+        }
+    }
+    LUMINA_TRACE_COUNTER("Lumina upload bytes", static_cast<uint64_t>(width) * height * 4);
+    return submitUpload(index);
+}
+
+int VulkanRenderer::beginUpload(uint32_t width, uint32_t height) {
+    // Every slot is still being sampled or awaiting its first draw: drop this frame
+    // rather than stall, the camera simply runs ahead of the display.
+    const int index = acquireUploadSlot();
+    if (index < 0) return -1;
+    UploadSlot& slot = uploadRing_[static_cast<size_t>(index)];
+
+    // The slot's previous copy must have executed before its staging memory is reused.
+    vkWaitForFences(device_, 1, &slot.fence, VK_TRUE, UINT64_MAX);
+
+    const VkDeviceSize size = static_cast<VkDeviceSize>(width) * static_cast<VkDeviceSize>(height) * 4;
+    if (slot.width != width || slot.height != height || slot.stagingSize < size) {
+        if (!allocateUploadSlot(slot, width, height, size)) return -1;
+    }
+    return index;
+}
+
+bool VulkanRenderer::submitUpload(int index) {
+    UploadSlot& slot = uploadRing_[static_cast<size_t>(index)];
+    const uint32_t width = slot.width;
+    const uint32_t height = slot.height;
+
+    vkResetCommandBuffer(slot.cmd, 0);
+    auto beginInfo = makeStruct<VkCommandBufferBeginInfo>(VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO);
+    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    vkBeginCommandBuffer(slot.cmd, &beginInfo);
+
+    // The whole image is overwritten, so the old contents can be discarded.
+    auto toTransfer = makeStruct<VkImageMemoryBarrier>(VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER);
+    toTransfer.srcAccessMask = 0;
+    toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toTransfer.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toTransfer.image = slot.image;
+    toTransfer.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    toTransfer.subresourceRange.levelCount = 1;
+    toTransfer.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(slot.cmd,
+                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         0,
+                         0, nullptr,
+                         0, nullptr,
+                         1, &toTransfer);
+
+    VkBufferImageCopy copy{};
+    copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    copy.imageSubresource.layerCount = 1;
+    copy.imageExtent = { width, height, 1 };
+    vkCmdCopyBufferToImage(slot.cmd, slot.staging, slot.image, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
+
+    // Visibility to the fragment shader comes from the semaphore wait in render(); the
+    // image is CONCURRENT across both families so no ownership transfer is needed.
+    auto toShader = makeStruct<VkImageMemoryBarrier>(VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER);
+    toShader.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    toShader.dstAccessMask = 0;
+    toShader.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
+    toShader.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    toShader.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toShader.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    toShader.image = slot.image;
+    toShader.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    toShader.subresourceRange.levelCount = 1;
+    toShader.subresourceRange.layerCount = 1;
+    vkCmdPipelineBarrier(slot.cmd,
+                         VK_PIPELINE_STAGE_TRANSFER_BIT,
+                         VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT,
+                         0,
+                         0, nullptr,
+                         0, nullptr,
+                         1, &toShader);
+
+    if (vkEndCommandBuffer(slot.cmd) != VK_SUCCESS) {
+        LOGE("vkEndCommandBuffer for upload failed");
+        return false;
+    }
+
+    const uint64_t signalValue = uploadTimelineValue_ + 1;
+    auto timelineInfo = makeStruct<VkTimelineSemaphoreSubmitInfoKHR>(VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR);
+    timelineInfo.signalSemaphoreValueCount = 1;
+    timelineInfo.pSignalSemaphoreValues = &signalValue;
+
+    auto si = makeStruct<VkSubmitInfo>(VK_STRUCTURE_TYPE_SUBMIT_INFO);
+    si.pNext = timelineSupported_ ? &timelineInfo : nullptr;
+    si.commandBufferCount = 1;
+    si.pCommandBuffers = &slot.cmd;
+    si.signalSemaphoreCount = 1;
+    si.pSignalSemaphores = timelineSupported_ ? &uploadTimeline_ : &slot.ready;
+
+    vkResetFences(device_, 1, &slot.fence);
+    if (vkQueueSubmit(transferQueue_, 1, &si, slot.fence) != VK_SUCCESS) {
+        LOGE("vkQueueSubmit for upload failed");
+        // Leave the fence signalled so the next wait on this slot does not hang.
+        vkQueueSubmit(transferQueue_, 0, nullptr, slot.fence);
         return false;
     }
+
+    uploadTimelineValue_ = signalValue;
+    slot.readyValue = signalValue;
+    slot.pendingWait = !timelineSupported_;
+    slot.lastUsedFrame = kNeverUsed;
+    readySlot_ = index;
+    activeImport_ = -1;
     return true;
 }
 
-bool VulkanRenderer::createFramebuffers() {
-    for (auto fb : framebuffers_) vkDestroyFramebuffer(device_, fb, nullptr);
-    framebuffers_.clear();
-    for (auto v : swapchain_.imageViews) if (v) vkDestroyImageView(device_, v, nullptr);
-    swapchain_.imageViews.clear();
+bool VulkanRenderer::createUploadResources() {
+    auto pci = makeStruct<VkCommandPoolCreateInfo>(VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO);
+    pci.queueFamilyIndex = transferQueueFamily_;
+    pci.flags = VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT;
+    if (vkCreateCommandPool(device_, &pci, nullptr, &transferCommandPool_) != VK_SUCCESS) {
+        LOGE("vkCreateCommandPool for uploads failed");
+        return false;
+    }
 
-    framebuffers_.resize(swapchain_.images.size());
-    swapchain_.imageViews.resize(swapchain_.images.size());
+    VkDescriptorPoolSize poolSize{};
+    poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    poolSize.descriptorCount = static_cast<uint32_t>(kUploadRingSize);
+
+    auto dpi = makeStruct<VkDescriptorPoolCreateInfo>(VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO);
+    dpi.poolSizeCount = 1;
+    dpi.pPoolSizes = &poolSize;
+    dpi.maxSets = static_cast<uint32_t>(kUploadRingSize);
+    if (vkCreateDescriptorPool(device_, &dpi, nullptr, &uploadDescriptorPool_) != VK_SUCCESS) {
+        LOGE("vkCreateDescriptorPool for uploads failed");
+        return false;
+    }
 
-    for (size_t i = 0; i < swapchain_.images.size(); ++i) {
-        auto vi = makeStruct<VkImageViewCreateInfo>(VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO);
-        vi.image = swapchain_.images[i];
-        vi.viewType = VK_IMAGE_VIEW_TYPE_2D;
-        vi.format = swapchain_.format;
-        vi.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-        vi.subresourceRange.levelCount = 1;
-        vi.subresourceRange.layerCount = 1;
-        if (vkCreateImageView(device_, &vi, nullptr, &swapchain_.imageViews[i]) != VK_SUCCESS) {
-            LOGE("vkCreateImageView failed for swapchain image %zu", i);
+    if (timelineSupported_) {
+        auto typeInfo = makeStruct<VkSemaphoreTypeCreateInfoKHR>(VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR);
+        typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+        typeInfo.initialValue = 0;
+        auto sci = makeStruct<VkSemaphoreCreateInfo>(VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO);
+        sci.pNext = &typeInfo;
+        if (vkCreateSemaphore(device_, &sci, nullptr, &uploadTimeline_) != VK_SUCCESS) {
+            LOGE("vkCreateSemaphore for upload timeline failed");
             return false;
         }
+        uploadTimelineValue_ = 0;
+    }
 
-        VkImageView attachments[] = { swapchain_.imageViews[i] };
-        auto fi = makeStruct<VkFramebufferCreateInfo>(VK_STRUCTURE_TYPE_FRAMEBUFFER_CREATE_INFO);
-        fi.renderPass = renderPass_;
-        fi.attachmentCount = 1;
-        fi.pAttachments = attachments;
-        fi.width = swapchain_.width;
-        fi.height = swapchain_.height;
-        fi.layers = 1;
-        if (vkCreateFramebuffer(device_, &fi, nullptr, &framebuffers_[i]) != VK_SUCCESS) {
-            LOGE("vkCreateFramebuffer failed for idx %zu", i);
+    auto cbai = makeStruct<VkCommandBufferAllocateInfo>(VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO);
+    cbai.commandPool = transferCommandPool_;
+    cbai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+    cbai.commandBufferCount = 1;
+
+    std::array<VkDescriptorSetLayout, kUploadRingSize> layouts;
+    layouts.fill(descriptorSetLayout_);
+    std::array<VkDescriptorSet, kUploadRingSize> sets{};
+    auto dsai = makeStruct<VkDescriptorSetAllocateInfo>(VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO);
+    dsai.descriptorPool = uploadDescriptorPool_;
+    dsai.descriptorSetCount = static_cast<uint32_t>(kUploadRingSize);
+    dsai.pSetLayouts = layouts.data();
+    if (vkAllocateDescriptorSets(device_, &dsai, sets.data()) != VK_SUCCESS) {
+        LOGE("vkAllocateDescriptorSets for uploads failed");
+        return false;
+    }
+
+    auto fci = makeStruct<VkFenceCreateInfo>(VK_STRUCTURE_TYPE_FENCE_CREATE_INFO);
+    fci.flags = VK_FENCE_CREATE_SIGNALED_BIT;
+    auto bsci = makeStruct<VkSemaphoreCreateInfo>(VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO);
+
+    for (size_t i = 0; i < kUploadRingSize; ++i) {
+        UploadSlot& slot = uploadRing_[i];
+        slot.descriptorSet = sets[i];
+        if (vkAllocateCommandBuffers(device_, &cbai, &slot.cmd) != VK_SUCCESS ||
+            vkCreateFence(device_, &fci, nullptr, &slot.fence) != VK_SUCCESS) {
+            LOGE("Failed to create upload slot %zu", i);
+            return false;
+        }
+        if (!timelineSupported_ && vkCreateSemaphore(device_, &bsci, nullptr, &slot.ready) != VK_SUCCESS) {
+            LOGE("Failed to create upload semaphore %zu", i);
             return false;
         }
     }
+    readySlot_ = -1;
     return true;
 }
 
-bool VulkanRenderer::createTextureResources() {
-    // For now, allocate a 1x1 texture to keep pipeline valid; real upload happens later.
-    uint32_t width = 1, height = 1;
+int VulkanRenderer::acquireUploadSlot() {
+    // Any slot other than the one render() currently shows whose last draw has retired.
+    // Binary semaphores must be consumed by a render submit before they can be re-signalled.
+    int best = -1;
+    for (size_t i = 0; i < kUploadRingSize; ++i) {
+        const UploadSlot& slot = uploadRing_[i];
+        if (static_cast<int>(i) == readySlot_ || slot.pendingWait || !frameRetired(slot.lastUsedFrame)) continue;
+        if (best < 0 || slot.readyValue < uploadRing_[static_cast<size_t>(best)].readyValue) {
+            best = static_cast<int>(i);
+        }
+    }
+    return best;
+}
+
+bool VulkanRenderer::allocateUploadSlot(UploadSlot& slot, uint32_t width, uint32_t height, VkDeviceSize size) {
+    releaseUploadSlot(slot);
+
+    auto bi = makeStruct<VkBufferCreateInfo>(VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO);
+    bi.size = size;
+    bi.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
+    bi.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (vkCreateBuffer(device_, &bi, nullptr, &slot.staging) != VK_SUCCESS) {
+        LOGE("vkCreateBuffer staging failed");
+        return false;
+    }
+    if (!allocateBufferMemory(slot.staging, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+                              0, lumina::GpuMemoryCategory::Staging, slot.stagingMemory)) {
+        LOGE("Failed to allocate and map staging memory");
+        releaseUploadSlot(slot);
+        return false;
+    }
+    slot.mapped = slot.stagingMemory.mapped;
+    slot.stagingSize = size;
+
+    // Written by the transfer queue, sampled by the graphics queue.
+    const uint32_t families[] = { graphicsQueueFamily_, transferQueueFamily_ };
     auto ci = makeStruct<VkImageCreateInfo>(VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO);
     ci.imageType = VK_IMAGE_TYPE_2D;
     ci.extent = { width, height, 1 };
@@ -748,422 +3501,751 @@ bool VulkanRenderer::createTextureResources() {
     ci.format = VK_FORMAT_R8G8B8A8_UNORM;
     ci.tiling = VK_IMAGE_TILING_OPTIMAL;
     ci.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    ci.usage = VK_IMAGE_USAGE_SAMPLED_BIT | VK_IMAGE_USAGE_TRANSFER_DST_BIT;
+    ci.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
     ci.samples = VK_SAMPLE_COUNT_1_BIT;
-    ci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    if (transferQueueFamily_ != graphicsQueueFamily_) {
+        ci.sharingMode = VK_SHARING_MODE_CONCURRENT;
+        ci.queueFamilyIndexCount = 2;
+        ci.pQueueFamilyIndices = families;
+    } else {
+        ci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    }
+    if (vkCreateImage(device_, &ci, nullptr, &slot.image) != VK_SUCCESS) {
+        LOGE("vkCreateImage texture failed");
+        releaseUploadSlot(slot);
+        return false;
+    }
+    if (!allocateImageMemory(slot.image, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT, 0,
+                             lumina::GpuMemoryCategory::Textures, slot.memory)) {
+        LOGE("Failed to allocate texture memory");
+        releaseUploadSlot(slot);
+        return false;
+    }
 
-    if (vkCreateImage(device_, &ci, nullptr, &textureImage_) != VK_SUCCESS) {
-        LOGE("vkCreateImage for texture failed");
+    auto vi = makeStruct<VkImageViewCreateInfo>(VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO);
+    vi.image = slot.image;
+    vi.viewType = VK_IMAGE_VIEW_TYPE_2D;
+    vi.format = VK_FORMAT_R8G8B8A8_UNORM;
+    vi.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
+    vi.subresourceRange.levelCount = 1;
+    vi.subresourceRange.layerCount = 1;
+    if (vkCreateImageView(device_, &vi, nullptr, &slot.view) != VK_SUCCESS) {
+        LOGE("vkCreateImageView texture failed");
+        releaseUploadSlot(slot);
         return false;
     }
 
-    VkMemoryRequirements memReq{};
-    vkGetImageMemoryRequirements(device_, textureImage_, &memReq);
+    // Each slot owns its descriptor set, so it is written once per allocation, not per frame.
+    VkDescriptorImageInfo ii{};
+    ii.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    ii.imageView = slot.view;
+    ii.sampler = textureSampler_;
+
+    auto write = makeStruct<VkWriteDescriptorSet>(VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET);
+    write.dstSet = slot.descriptorSet;
+    write.dstBinding = 0;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.descriptorCount = 1;
+    write.pImageInfo = &ii;
+    vkUpdateDescriptorSets(device_, 1, &write, 0, nullptr);
+
+    slot.width = width;
+    slot.height = height;
+    return true;
+}
 
-    auto ai = makeStruct<VkMemoryAllocateInfo>(VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO);
-    ai.allocationSize = memReq.size;
+void VulkanRenderer::releaseUploadSlot(UploadSlot& slot) {
+    if (slot.view != VK_NULL_HANDLE) {
+        vkDestroyImageView(device_, slot.view, nullptr);
+        slot.view = VK_NULL_HANDLE;
+    }
+    if (slot.image != VK_NULL_HANDLE) {
+        vkDestroyImage(device_, slot.image, nullptr);
+        slot.image = VK_NULL_HANDLE;
+    }
+    freeMemory(slot.memory);
+    if (slot.staging != VK_NULL_HANDLE) {
+        vkDestroyBuffer(device_, slot.staging, nullptr);
+        slot.staging = VK_NULL_HANDLE;
+    }
+    freeMemory(slot.stagingMemory);
+    slot.mapped = nullptr;
+    slot.stagingSize = 0;
+    slot.width = 0;
+    slot.height = 0;
+}
 
-    VkPhysicalDeviceMemoryProperties props{};
-    vkGetPhysicalDeviceMemoryProperties(physicalDevice_, &props);
-    uint32_t typeIndex = UINT32_MAX;
-    for (uint32_t i = 0; i < props.memoryTypeCount; ++i) {
-        if ((memReq.memoryTypeBits & (1 << i)) && (props.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT)) {
-            typeIndex = i;
-            break;
-        }
+void VulkanRenderer::destroyUploadResources() {
+    for (auto& slot : uploadRing_) {
+        releaseUploadSlot(slot);
+        if (slot.fence != VK_NULL_HANDLE) vkDestroyFence(device_, slot.fence, nullptr);
+        if (slot.ready != VK_NULL_HANDLE) vkDestroySemaphore(device_, slot.ready, nullptr);
+        slot = UploadSlot{};
     }
-    if (typeIndex == UINT32_MAX) {
-        LOGE("Failed to find device local memory for texture");
-        return false;
+    readySlot_ = -1;
+    if (uploadTimeline_ != VK_NULL_HANDLE) {
+        vkDestroySemaphore(device_, uploadTimeline_, nullptr);
+        uploadTimeline_ = VK_NULL_HANDLE;
     }
-    ai.memoryTypeIndex = typeIndex;
-    if (vkAllocateMemory(device_, &ai, nullptr, &textureMemory_) != VK_SUCCESS) {
-        LOGE("vkAllocateMemory for texture failed");
-        return false;
+    if (uploadDescriptorPool_ != VK_NULL_HANDLE) {
+        vkDestroyDescriptorPool(device_, uploadDescriptorPool_, nullptr);
+        uploadDescriptorPool_ = VK_NULL_HANDLE;
+    }
+    if (transferCommandPool_ != VK_NULL_HANDLE) {
+        vkDestroyCommandPool(device_, transferCommandPool_, nullptr); // frees slot command buffers
+        transferCommandPool_ = VK_NULL_HANDLE;
     }
-    vkBindImageMemory(device_, textureImage_, textureMemory_, 0);
+}
 
-    // Transition to shader-read layout so descriptors are valid even before uploads.
-    auto cbAlloc = makeStruct<VkCommandBufferAllocateInfo>(VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO);
-    cbAlloc.commandPool = commandPool_;
-    cbAlloc.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    cbAlloc.commandBufferCount = 1;
-    VkCommandBuffer cmd;
-    if (vkAllocateCommandBuffers(device_, &cbAlloc, &cmd) != VK_SUCCESS) {
-        LOGE("Failed to allocate temp command buffer for texture layout transition");
-        return false;
+bool VulkanRenderer::frameRetired(uint64_t frame) const {
+    // render() waits on the fence of frame F before recording frame F + kMaxFramesInFlight.
+    return frame == kNeverUsed || frame + kMaxFramesInFlight < currentFrame_;
+}
+
+std::optional<uint32_t> VulkanRenderer::findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags flags) const {
+    for (uint32_t i = 0; i < memoryProperties_.memoryTypeCount; ++i) {
+        if ((typeBits & (1u << i)) && (memoryProperties_.memoryTypes[i].propertyFlags & flags) == flags) {
+            return i;
+        }
+    }
+    return std::nullopt;
+}
+
+bool VulkanRenderer::allocateImageMemory(VkImage image, VkMemoryPropertyFlags required,
+                                         VkMemoryPropertyFlags preferred, lumina::GpuMemoryCategory category,
+                                         GpuAllocation& out) {
+    VkMemoryRequirements requirements{};
+    vkGetImageMemoryRequirements(device_, image, &requirements);
+    // On failure `out` may still hold the memory; the owner's destroy path frees it.
+    return allocateMemory(requirements, false, required, preferred, category, out) &&
+           vkBindImageMemory(device_, image, out.memory, out.offset) == VK_SUCCESS;
+}
+
+bool VulkanRenderer::allocateBufferMemory(VkBuffer buffer, VkMemoryPropertyFlags required,
+                                          VkMemoryPropertyFlags preferred, lumina::GpuMemoryCategory category,
+                                          GpuAllocation& out) {
+    VkMemoryRequirements requirements{};
+    vkGetBufferMemoryRequirements(device_, buffer, &requirements);
+    return allocateMemory(requirements, true, required, preferred, category, out) &&
+           vkBindBufferMemory(device_, buffer, out.memory, out.offset) == VK_SUCCESS;
+}
+
+bool VulkanRenderer::allocateMemory(const VkMemoryRequirements& requirements, bool linear,
+                                    VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred,
+                                    lumina::GpuMemoryCategory category, GpuAllocation& out) {
+    freeMemory(out);
+    auto typeIndex = findMemoryType(requirements.memoryTypeBits, required | preferred);
+    if (!typeIndex) typeIndex = findMemoryType(requirements.memoryTypeBits, required);
+    if (!typeIndex) {
+        LOGE("No memory type with properties 0x%x for %s", required, lumina::gpuMemoryCategoryName(category));
+        return false;
+    }
+    const VkMemoryPropertyFlags flags = memoryProperties_.memoryTypes[*typeIndex].propertyFlags;
+
+    // Mapped ranges of non-coherent memory are flushed and invalidated in whole atoms,
+    // so such allocations start and end on one and never share an atom.
+    VkDeviceSize alignment = std::max<VkDeviceSize>(requirements.alignment, 1);
+    VkDeviceSize size = requirements.size;
+    if ((flags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) && !(flags & VK_MEMORY_PROPERTY_HOST_COHERENT_BIT)) {
+        alignment = std::max(alignment, nonCoherentAtomSize_);
+        size = (size + nonCoherentAtomSize_ - 1) / nonCoherentAtomSize_ * nonCoherentAtomSize_;
     }
-    auto bi = makeStruct<VkCommandBufferBeginInfo>(VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO);
-    bi.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-    vkBeginCommandBuffer(cmd, &bi);
-    auto barrier = makeStruct<VkImageMemoryBarrier>(VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER);
-    barrier.srcAccessMask = 0;
-    barrier.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-    barrier.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    barrier.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    barrier.image = textureImage_;
-    barrier.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    barrier.subresourceRange.levelCount = 1;
-    barrier.subresourceRange.layerCount = 1;
-    vkCmdPipelineBarrier(cmd,
-                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                         0,
-                         0, nullptr,
-                         0, nullptr,
-                         1, &barrier);
-    vkEndCommandBuffer(cmd);
-    auto si = makeStruct<VkSubmitInfo>(VK_STRUCTURE_TYPE_SUBMIT_INFO);
-    si.commandBufferCount = 1;
-    si.pCommandBuffers = &cmd;
-    vkQueueSubmit(graphicsQueue_, 1, &si, VK_NULL_HANDLE);
-    vkQueueWaitIdle(graphicsQueue_);
-    vkFreeCommandBuffers(device_, commandPool_, 1, &cmd);
 
-    auto vi = makeStruct<VkImageViewCreateInfo>(VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO);
-    vi.image = textureImage_;
-    vi.viewType = VK_IMAGE_VIEW_TYPE_2D;
-    vi.format = VK_FORMAT_R8G8B8A8_UNORM;
-    vi.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    vi.subresourceRange.levelCount = 1;
-    vi.subresourceRange.layerCount = 1;
-    if (vkCreateImageView(device_, &vi, nullptr, &textureView_) != VK_SUCCESS) {
-        LOGE("vkCreateImageView for texture failed");
+    GpuAllocation allocation;
+    allocation.size = size;
+    allocation.flags = flags;
+    allocation.category = category;
+
+    // Large requests would mostly waste a block, and lazily allocated memory is only
+    // backed per object when the driver has to, so both get memory of their own.
+    const bool shared = size <= lumina::kGpuDedicatedThreshold && !(flags & VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT);
+    const auto place = [&](size_t index) {
+        MemoryBlock& block = memoryBlocks_[index];
+        const auto offset = block.ranges.allocate(size, alignment);
+        if (!offset) return false;
+        allocation.memory = block.memory;
+        allocation.offset = *offset;
+        allocation.mapped = block.mapped ? static_cast<uint8_t*>(block.mapped) + *offset : nullptr;
+        allocation.block = static_cast<int32_t>(index);
+        return true;
+    };
+    if (shared) {
+        for (size_t i = 0; i < memoryBlocks_.size() && allocation.memory == VK_NULL_HANDLE; ++i) {
+            const MemoryBlock& block = memoryBlocks_[i];
+            if (block.memory != VK_NULL_HANDLE && block.typeIndex == *typeIndex && block.linear == linear) place(i);
+        }
+    }
+    if (shared && allocation.memory == VK_NULL_HANDLE) {
+        MemoryBlock block;
+        block.typeIndex = *typeIndex;
+        block.linear = linear;
+        block.ranges = lumina::BlockSuballocator(lumina::kGpuMemoryBlockSize);
+        // A heap too tight for another block may still fit the request on its own.
+        if (allocateDedicated(*typeIndex, lumina::kGpuMemoryBlockSize, block.memory, block.mapped)) {
+            auto slot = std::find_if(memoryBlocks_.begin(), memoryBlocks_.end(),
+                                     [](const MemoryBlock& b) { return b.memory == VK_NULL_HANDLE; });
+            if (slot == memoryBlocks_.end()) slot = memoryBlocks_.insert(slot, MemoryBlock{});
+            *slot = block;
+            ++memoryUsage_.blocks;
+            place(static_cast<size_t>(slot - memoryBlocks_.begin()));
+            LOGI("GPU memory block for type %u %s allocated, %u in use", *typeIndex,
+                 linear ? "buffers" : "images", memoryUsage_.blocks);
+        }
+    }
+    if (allocation.memory == VK_NULL_HANDLE &&
+        !allocateDedicated(*typeIndex, size, allocation.memory, allocation.mapped)) {
+        LOGE("Failed to allocate %llu bytes of GPU memory for %s", static_cast<unsigned long long>(size),
+             lumina::gpuMemoryCategoryName(category));
         return false;
     }
+
+    memoryUsage_.used[static_cast<size_t>(category)] += size;
+    out = allocation;
+    reportMemoryUsage();
     return true;
 }
 
-bool VulkanRenderer::createSampler() {
-    auto ci = makeStruct<VkSamplerCreateInfo>(VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO);
-    ci.magFilter = VK_FILTER_LINEAR;
-    ci.minFilter = VK_FILTER_LINEAR;
-    ci.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    ci.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    ci.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
-    ci.anisotropyEnable = VK_FALSE;
-    ci.maxAnisotropy = 1.0f;
-    ci.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
-    ci.unnormalizedCoordinates = VK_FALSE;
-    ci.compareEnable = VK_FALSE;
-    ci.mipmapMode = VK_SAMPLER_MIPMAP_MODE_LINEAR;
-    if (vkCreateSampler(device_, &ci, nullptr, &textureSampler_) != VK_SUCCESS) {
-        LOGE("vkCreateSampler failed");
+bool VulkanRenderer::allocateDedicated(uint32_t typeIndex, VkDeviceSize size, VkDeviceMemory& memory, void*& mapped) {
+    auto ai = makeStruct<VkMemoryAllocateInfo>(VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO);
+    ai.allocationSize = size;
+    ai.memoryTypeIndex = typeIndex;
+    if (vkAllocateMemory(device_, &ai, nullptr, &memory) != VK_SUCCESS) {
+        memory = VK_NULL_HANDLE;
+        return false;
+    }
+    mapped = nullptr;
+    if ((memoryProperties_.memoryTypes[typeIndex].propertyFlags & VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT) &&
+        vkMapMemory(device_, memory, 0, VK_WHOLE_SIZE, 0, &mapped) != VK_SUCCESS) {
+        vkFreeMemory(device_, memory, nullptr);
+        memory = VK_NULL_HANDLE;
         return false;
     }
+    memoryUsage_.reserved += size;
+    ++memoryUsage_.allocations;
     return true;
 }
 
-bool VulkanRenderer::createDescriptorPoolAndSets() {
-    if (descriptorPool_ != VK_NULL_HANDLE) {
-        vkDestroyDescriptorPool(device_, descriptorPool_, nullptr);
-        descriptorPool_ = VK_NULL_HANDLE;
+void VulkanRenderer::freeMemory(GpuAllocation& allocation) {
+    if (allocation.memory == VK_NULL_HANDLE) return;
+    memoryUsage_.used[static_cast<size_t>(allocation.category)] -= allocation.size;
+
+    VkDeviceMemory release = allocation.memory;
+    VkDeviceSize released = allocation.size;
+    if (allocation.block >= 0) {
+        MemoryBlock& block = memoryBlocks_[static_cast<size_t>(allocation.block)];
+        block.ranges.release(allocation.offset);
+        // Keep one empty block per kind so a resize does not free and reallocate it.
+        const bool spare = block.ranges.empty() &&
+            std::none_of(memoryBlocks_.begin(), memoryBlocks_.end(), [&](const MemoryBlock& other) {
+                return &other != &block && other.memory != VK_NULL_HANDLE && other.typeIndex == block.typeIndex &&
+                       other.linear == block.linear && other.ranges.empty();
+            });
+        if (!block.ranges.empty() || spare) {
+            release = VK_NULL_HANDLE;
+        } else {
+            released = block.ranges.size();
+            block = MemoryBlock{};
+            --memoryUsage_.blocks;
+        }
+    }
+    if (release != VK_NULL_HANDLE) {
+        vkFreeMemory(device_, release, nullptr); // implicitly unmaps
+        memoryUsage_.reserved -= released;
+        --memoryUsage_.allocations;
+    }
+    allocation = GpuAllocation{};
+    reportMemoryUsage();
+}
+
+void VulkanRenderer::destroyMemoryBlocks() {
+    for (auto& block : memoryBlocks_) {
+        if (block.memory == VK_NULL_HANDLE) continue;
+        if (!block.ranges.empty()) {
+            LOGW("GPU memory block still holds %llu bytes at shutdown",
+                 static_cast<unsigned long long>(block.ranges.used()));
+        }
+        vkFreeMemory(device_, block.memory, nullptr);
     }
+    memoryBlocks_.clear();
+    memoryUsage_ = lumina::GpuMemoryUsage{};
+    reportMemoryUsage();
+}
 
+void VulkanRenderer::reportMemoryUsage() {
+    if (stats_) stats_->recordGpuMemory(memoryUsage_);
+}
+
+bool VulkanRenderer::createImportDescriptorPool() {
+    if (!ahbSupported_) return true;
+
+    // A YCbCr combined image sampler may consume up to one descriptor per plane.
     VkDescriptorPoolSize poolSize{};
     poolSize.type = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-    poolSize.descriptorCount = static_cast<uint32_t>(swapchain_.images.size());
+    poolSize.descriptorCount = static_cast<uint32_t>(kMaxImportedBuffers * 3);
 
     auto pi = makeStruct<VkDescriptorPoolCreateInfo>(VK_STRUCTURE_TYPE_DESCRIPTOR_POOL_CREATE_INFO);
+    pi.flags = VK_DESCRIPTOR_POOL_CREATE_FREE_DESCRIPTOR_SET_BIT;
     pi.poolSizeCount = 1;
     pi.pPoolSizes = &poolSize;
-    pi.maxSets = static_cast<uint32_t>(swapchain_.images.size());
+    pi.maxSets = static_cast<uint32_t>(kMaxImportedBuffers);
 
-    if (vkCreateDescriptorPool(device_, &pi, nullptr, &descriptorPool_) != VK_SUCCESS) {
-        LOGE("vkCreateDescriptorPool failed");
+    if (vkCreateDescriptorPool(device_, &pi, nullptr, &importDescriptorPool_) != VK_SUCCESS) {
+        LOGE("vkCreateDescriptorPool for imported buffers failed");
         return false;
     }
+    imports_.reserve(kMaxImportedBuffers);
+    return true;
+}
 
-    std::vector<VkDescriptorSetLayout> layouts(swapchain_.images.size(), descriptorSetLayout_);
-    auto ai = makeStruct<VkDescriptorSetAllocateInfo>(VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO);
-    ai.descriptorPool = descriptorPool_;
-    ai.descriptorSetCount = static_cast<uint32_t>(layouts.size());
-    ai.pSetLayouts = layouts.data();
-
-    descriptorSets_.resize(layouts.size());
-    if (vkAllocateDescriptorSets(device_, &ai, descriptorSets_.data()) != VK_SUCCESS) {
-        LOGE("vkAllocateDescriptorSets failed");
-        return false;
-    }
+bool VulkanRenderer::importHardwareBuffer(AHardwareBuffer* buffer) {
+    if (!initialized_ || !ahbSupported_ || !buffer) return false;
+    LUMINA_TRACE_SCOPE("Vulkan::importHardwareBuffer");
 
-    for (size_t i = 0; i < descriptorSets_.size(); ++i) {
-        VkDescriptorImageInfo ii{};
-        ii.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        ii.imageView = textureView_;
-        ii.sampler = textureSampler_;
+    ImportedBuffer* entry = findOrImportBuffer(buffer);
+    if (!entry) return false;
 
-        auto write = makeStruct<VkWriteDescriptorSet>(VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET);
-        write.dstSet = descriptorSets_[i];
-        write.dstBinding = 0;
-        write.dstArrayElement = 0;
-        write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        write.descriptorCount = 1;
-        write.pImageInfo = &ii;
-        vkUpdateDescriptorSets(device_, 1, &write, 0, nullptr);
-    }
+    activeImport_ = static_cast<int>(entry - imports_.data());
     return true;
 }
 
-bool VulkanRenderer::uploadTexture(const void* data, size_t size, uint32_t width, uint32_t height) {
-    if (!data || size == 0 || width == 0 || height == 0) {
-        LOGE("uploadTexture invalid arguments");
-        return false;
+VulkanRenderer::ImportedBuffer* VulkanRenderer::findOrImportBuffer(AHardwareBuffer* buffer) {
+    AHardwareBuffer_Desc desc{};
+    AHardwareBuffer_describe(buffer, &desc);
+    if ((desc.usage & AHARDWAREBUFFER_USAGE_GPU_SAMPLED_IMAGE) == 0) {
+        // CPU-only camera buffers cannot be bound as images; the caller falls back to a copy.
+        return nullptr;
     }
 
-    const VkDeviceSize expected = static_cast<VkDeviceSize>(width) * static_cast<VkDeviceSize>(height) * 4;
-    if (size < expected) {
-        LOGE("uploadTexture size too small: got %zu, need at least %llu", size, static_cast<unsigned long long>(expected));
-        return false;
+    // Cached entries hold a reference, so a cached pointer cannot be recycled for another buffer.
+    for (auto& e : imports_) {
+        if (e.buffer == buffer && e.width == desc.width && e.height == desc.height) return &e;
     }
 
-    auto findMemoryType = [&](uint32_t typeBits, VkMemoryPropertyFlags flags) -> std::optional<uint32_t> {
-        VkPhysicalDeviceMemoryProperties props{};
-        vkGetPhysicalDeviceMemoryProperties(physicalDevice_, &props);
-        for (uint32_t i = 0; i < props.memoryTypeCount; ++i) {
-            if ((typeBits & (1u << i)) && (props.memoryTypes[i].propertyFlags & flags) == flags) {
-                return i;
-            }
-        }
-        return std::nullopt;
-    };
+    auto formatProps = makeStruct<VkAndroidHardwareBufferFormatPropertiesANDROID>(
+        VK_STRUCTURE_TYPE_ANDROID_HARDWARE_BUFFER_FORMAT_PROPERTIES_ANDROID);
+    auto bufferProps = makeStruct<VkAndroidHardwareBufferPropertiesANDROID>(
+        VK_STRUCTURE_TYPE_ANDROID_HARDWARE_BUFFER_PROPERTIES_ANDROID);
+    bufferProps.pNext = &formatProps;
+    if (pfnGetAhbProperties_(device_, buffer, &bufferProps) != VK_SUCCESS) {
+        LOGE("vkGetAndroidHardwareBufferPropertiesANDROID failed");
+        return nullptr;
+    }
 
-    VkDeviceSize imageSize = static_cast<VkDeviceSize>(size);
-
-    // Recreate staging buffer if needed
-    if (staging_.buffer == VK_NULL_HANDLE || staging_.size < imageSize) {
-        if (staging_.buffer != VK_NULL_HANDLE) vkDestroyBuffer(device_, staging_.buffer, nullptr);
-        if (staging_.memory != VK_NULL_HANDLE) vkFreeMemory(device_, staging_.memory, nullptr);
-        staging_.buffer = VK_NULL_HANDLE;
-        staging_.memory = VK_NULL_HANDLE;
-
-        auto bi = makeStruct<VkBufferCreateInfo>(VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO);
-        bi.size = imageSize;
-        bi.usage = VK_BUFFER_USAGE_TRANSFER_SRC_BIT;
-        bi.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-        if (vkCreateBuffer(device_, &bi, nullptr, &staging_.buffer) != VK_SUCCESS) {
-            LOGE("vkCreateBuffer staging failed");
-            return false;
-        }
-        VkMemoryRequirements memReq{};
-        vkGetBufferMemoryRequirements(device_, staging_.buffer, &memReq);
-        auto typeIndex = findMemoryType(memReq.memoryTypeBits, VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT);
-        if (!typeIndex) {
-            LOGE("No suitable memory type for staging buffer");
-            return false;
-        }
-        auto ai = makeStruct<VkMemoryAllocateInfo>(VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO);
-        ai.allocationSize = memReq.size;
-        ai.memoryTypeIndex = *typeIndex;
-        if (vkAllocateMemory(device_, &ai, nullptr, &staging_.memory) != VK_SUCCESS) {
-            LOGE("vkAllocateMemory staging failed");
-            return false;
+    // Opaque vendor YUV layouts report VK_FORMAT_UNDEFINED plus an external format;
+    // explicit multi-planar formats also need a conversion to be sampled as RGB.
+    const bool external = formatProps.format == VK_FORMAT_UNDEFINED;
+    const bool ycbcr = external ||
+        (formatProps.format >= VK_FORMAT_G8B8G8R8_422_UNORM &&
+         formatProps.format <= VK_FORMAT_G16_B16_R16_3PLANE_444_UNORM);
+    if (ycbcr && !ensureYcbcrResources(formatProps)) return nullptr;
+
+    // Pick a slot: an unused one, or evict the least recently sampled import.
+    ImportedBuffer* slot = nullptr;
+    if (imports_.size() < kMaxImportedBuffers) {
+        imports_.emplace_back();
+        slot = &imports_.back();
+    } else {
+        slot = &*std::min_element(imports_.begin(), imports_.end(), [](const auto& a, const auto& b) {
+            // Empty slots (lastUsedFrame 0) go first; kNeverUsed entries sort last so
+            // a buffer that was just imported is not evicted before it is drawn.
+            return a.lastUsedFrame < b.lastUsedFrame;
+        });
+        if (!frameRetired(slot->lastUsedFrame)) {
+            vkQueueWaitIdle(graphicsQueue_);
         }
-        vkBindBufferMemory(device_, staging_.buffer, staging_.memory, 0);
-        staging_.size = memReq.size;
+        if (activeImport_ == static_cast<int>(slot - imports_.data())) activeImport_ = -1;
+        releaseImportedBuffer(*slot);
     }
 
-    // Upload data to staging
-    void* mapped = nullptr;
-    if (vkMapMemory(device_, staging_.memory, 0, imageSize, 0, &mapped) != VK_SUCCESS) {
-        LOGE("vkMapMemory staging failed");
-        return false;
-    }
-    memcpy(mapped, data, size);
-    vkUnmapMemory(device_, staging_.memory);
+    ImportedBuffer& e = *slot;
+    e = ImportedBuffer{};
+    auto fail = [&](const char* what) -> ImportedBuffer* {
+        LOGE("%s", what);
+        releaseImportedBuffer(e);
+        e.lastUsedFrame = 0; // leave an empty slot that is reused first
+        return nullptr;
+    };
 
-    // Recreate texture image if dimensions change
-    if (textureImage_ != VK_NULL_HANDLE) {
-        vkDestroyImageView(device_, textureView_, nullptr);
-        textureView_ = VK_NULL_HANDLE;
-        vkDestroyImage(device_, textureImage_, nullptr);
-        textureImage_ = VK_NULL_HANDLE;
-        vkFreeMemory(device_, textureMemory_, nullptr);
-        textureMemory_ = VK_NULL_HANDLE;
-    }
+    auto externalFormat = makeStruct<VkExternalFormatANDROID>(VK_STRUCTURE_TYPE_EXTERNAL_FORMAT_ANDROID);
+    externalFormat.externalFormat = external ? formatProps.externalFormat : 0;
+
+    auto externalInfo = makeStruct<VkExternalMemoryImageCreateInfo>(VK_STRUCTURE_TYPE_EXTERNAL_MEMORY_IMAGE_CREATE_INFO);
+    externalInfo.pNext = &externalFormat;
+    externalInfo.handleTypes = VK_EXTERNAL_MEMORY_HANDLE_TYPE_ANDROID_HARDWARE_BUFFER_BIT_ANDROID;
 
     auto ci = makeStruct<VkImageCreateInfo>(VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO);
+    ci.pNext = &externalInfo;
     ci.imageType = VK_IMAGE_TYPE_2D;
-    ci.extent = { width, height, 1 };
+    ci.format = formatProps.format;
+    ci.extent = { desc.width, desc.height, 1 };
     ci.mipLevels = 1;
-    ci.arrayLayers = 1;
-    ci.format = VK_FORMAT_R8G8B8A8_UNORM;
-    ci.tiling = VK_IMAGE_TILING_OPTIMAL;
-    ci.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    ci.usage = VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT;
+    ci.arrayLayers = std::max<uint32_t>(desc.layers, 1);
     ci.samples = VK_SAMPLE_COUNT_1_BIT;
+    ci.tiling = VK_IMAGE_TILING_OPTIMAL;
+    ci.usage = VK_IMAGE_USAGE_SAMPLED_BIT;
     ci.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    if (vkCreateImage(device_, &ci, nullptr, &textureImage_) != VK_SUCCESS) {
-        LOGE("vkCreateImage texture failed");
-        return false;
-    }
-    VkMemoryRequirements imgReq{};
-    vkGetImageMemoryRequirements(device_, textureImage_, &imgReq);
-    auto imgType = findMemoryType(imgReq.memoryTypeBits, VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT);
-    if (!imgType) {
-        LOGE("No suitable memory type for texture image");
-        return false;
-    }
-    auto imgAlloc = makeStruct<VkMemoryAllocateInfo>(VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO);
-    imgAlloc.allocationSize = imgReq.size;
-    imgAlloc.memoryTypeIndex = *imgType;
-    if (vkAllocateMemory(device_, &imgAlloc, nullptr, &textureMemory_) != VK_SUCCESS) {
-        LOGE("vkAllocateMemory texture failed");
-        return false;
+    ci.initialLayout = VK_IMAGE_LAYOUT_UNDEFINED;
+    if (vkCreateImage(device_, &ci, nullptr, &e.image) != VK_SUCCESS) {
+        return fail("vkCreateImage for AHardwareBuffer import failed");
     }
-    vkBindImageMemory(device_, textureImage_, textureMemory_, 0);
 
-    // One-time command buffer for copy and layout transitions
-    auto cbai = makeStruct<VkCommandBufferAllocateInfo>(VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO);
-    cbai.commandPool = commandPool_;
-    cbai.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
-    cbai.commandBufferCount = 1;
-    VkCommandBuffer cmd;
-    if (vkAllocateCommandBuffers(device_, &cbai, &cmd) != VK_SUCCESS) {
-        LOGE("vkAllocateCommandBuffers for upload failed");
-        return false;
+    uint32_t typeIndex = UINT32_MAX;
+    for (uint32_t i = 0; i < memoryProperties_.memoryTypeCount; ++i) {
+        if (bufferProps.memoryTypeBits & (1u << i)) {
+            typeIndex = i;
+            if (memoryProperties_.memoryTypes[i].propertyFlags & VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT) break;
+        }
     }
 
-    auto beginInfo = makeStruct<VkCommandBufferBeginInfo>(VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO);
-    beginInfo.flags = VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
-    vkBeginCommandBuffer(cmd, &beginInfo);
-
-    auto toTransfer = makeStruct<VkImageMemoryBarrier>(VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER);
-    toTransfer.srcAccessMask = 0;
-    toTransfer.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    toTransfer.oldLayout = VK_IMAGE_LAYOUT_UNDEFINED;
-    toTransfer.newLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-    toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    toTransfer.image = textureImage_;
-    toTransfer.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    toTransfer.subresourceRange.levelCount = 1;
-    toTransfer.subresourceRange.layerCount = 1;
-
-    vkCmdPipelineBarrier(cmd,
-                         VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
-                         VK_PIPELINE_STAGE_TRANSFER_BIT,
-                         0,
-                         0, nullptr,
-                         0, nullptr,
-                         1, &toTransfer);
-
-    VkBufferImageCopy copy{};
-    copy.imageSubresource.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    copy.imageSubresource.layerCount = 1;
-    copy.imageExtent = { width, height, 1 };
-    vkCmdCopyBufferToImage(cmd, staging_.buffer, textureImage_, VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL, 1, &copy);
-
-    auto toShader = makeStruct<VkImageMemoryBarrier>(VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER);
-    toShader.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
-    toShader.dstAccessMask = VK_ACCESS_SHADER_READ_BIT;
-    toShader.oldLayout = VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL;
-    toShader.newLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-    toShader.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    toShader.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
-    toShader.image = textureImage_;
-    toShader.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
-    toShader.subresourceRange.levelCount = 1;
-    toShader.subresourceRange.layerCount = 1;
+    auto dedicated = makeStruct<VkMemoryDedicatedAllocateInfo>(VK_STRUCTURE_TYPE_MEMORY_DEDICATED_ALLOCATE_INFO);
+    dedicated.image = e.image;
 
-    vkCmdPipelineBarrier(cmd,
-                         VK_PIPELINE_STAGE_TRANSFER_BIT,
-                         VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT,
-                         0,
-                         0, nullptr,
-                         0, nullptr,
-                         1, &toShader);
+    auto importInfo = makeStruct<VkImportAndroidHardwareBufferInfoANDROID>(
+        VK_STRUCTURE_TYPE_IMPORT_ANDROID_HARDWARE_BUFFER_INFO_ANDROID);
+    importInfo.pNext = &dedicated;
+    importInfo.buffer = buffer;
 
-    vkEndCommandBuffer(cmd);
+    auto ai = makeStruct<VkMemoryAllocateInfo>(VK_STRUCTURE_TYPE_MEMORY_ALLOCATE_INFO);
+    ai.pNext = &importInfo;
+    ai.allocationSize = bufferProps.allocationSize;
+    ai.memoryTypeIndex = typeIndex;
+    if (typeIndex == UINT32_MAX ||
+        vkAllocateMemory(device_, &ai, nullptr, &e.memory) != VK_SUCCESS ||
+        vkBindImageMemory(device_, e.image, e.memory, 0) != VK_SUCCESS) {
+        return fail("Failed to import AHardwareBuffer memory");
+    }
 
-    auto si = makeStruct<VkSubmitInfo>(VK_STRUCTURE_TYPE_SUBMIT_INFO);
-    si.commandBufferCount = 1;
-    si.pCommandBuffers = &cmd;
-    vkQueueSubmit(graphicsQueue_, 1, &si, VK_NULL_HANDLE);
-    vkQueueWaitIdle(graphicsQueue_);
-    vkFreeCommandBuffers(device_, commandPool_, 1, &cmd);
+    auto conversionInfo = makeStruct<VkSamplerYcbcrConversionInfo>(VK_STRUCTURE_TYPE_SAMPLER_YCBCR_CONVERSION_INFO);
+    conversionInfo.conversion = ycbcr_.conversion;
 
-    // Recreate image view
     auto vi = makeStruct<VkImageViewCreateInfo>(VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO);
-    vi.image = textureImage_;
+    vi.pNext = ycbcr ? &conversionInfo : nullptr;
+    vi.image = e.image;
     vi.viewType = VK_IMAGE_VIEW_TYPE_2D;
-    vi.format = VK_FORMAT_R8G8B8A8_UNORM;
+    vi.format = formatProps.format;
     vi.subresourceRange.aspectMask = VK_IMAGE_ASPECT_COLOR_BIT;
     vi.subresourceRange.levelCount = 1;
     vi.subresourceRange.layerCount = 1;
-    if (vkCreateImageView(device_, &vi, nullptr, &textureView_) != VK_SUCCESS) {
-        LOGE("vkCreateImageView texture failed");
+    if (vkCreateImageView(device_, &vi, nullptr, &e.view) != VK_SUCCESS) {
+        return fail("vkCreateImageView for AHardwareBuffer import failed");
+    }
+
+    auto dsai = makeStruct<VkDescriptorSetAllocateInfo>(VK_STRUCTURE_TYPE_DESCRIPTOR_SET_ALLOCATE_INFO);
+    dsai.descriptorPool = importDescriptorPool_;
+    dsai.descriptorSetCount = 1;
+    dsai.pSetLayouts = ycbcr ? &ycbcr_.setLayout : &descriptorSetLayout_;
+    if (vkAllocateDescriptorSets(device_, &dsai, &e.descriptorSet) != VK_SUCCESS) {
+        return fail("vkAllocateDescriptorSets for AHardwareBuffer import failed");
+    }
+
+    VkDescriptorImageInfo ii{};
+    ii.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
+    ii.imageView = e.view;
+    ii.sampler = ycbcr ? VK_NULL_HANDLE : textureSampler_; // YCbCr uses the immutable sampler
+
+    auto write = makeStruct<VkWriteDescriptorSet>(VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET);
+    write.dstSet = e.descriptorSet;
+    write.dstBinding = 0;
+    write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    write.descriptorCount = 1;
+    write.pImageInfo = &ii;
+    vkUpdateDescriptorSets(device_, 1, &write, 0, nullptr);
+
+    AHardwareBuffer_acquire(buffer);
+    e.buffer = buffer;
+    e.width = desc.width;
+    e.height = desc.height;
+    e.ycbcr = ycbcr;
+    return &e;
+}
+
+bool VulkanRenderer::ensureYcbcrResources(const VkAndroidHardwareBufferFormatPropertiesANDROID& formatProps) {
+    if (ycbcr_.conversion != VK_NULL_HANDLE &&
+        ycbcr_.externalFormat == formatProps.externalFormat &&
+        ycbcr_.format == formatProps.format) {
+        return true;
+    }
+
+    // A new camera format invalidates the immutable sampler and every YCbCr import built on it.
+    if (ycbcr_.conversion != VK_NULL_HANDLE) {
+        vkQueueWaitIdle(graphicsQueue_);
+        for (size_t i = 0; i < imports_.size();) {
+            if (imports_[i].ycbcr) {
+                releaseImportedBuffer(imports_[i]);
+                imports_.erase(imports_.begin() + static_cast<std::ptrdiff_t>(i));
+            } else {
+                ++i;
+            }
+        }
+        activeImport_ = -1;
+        destroyYcbcrResources();
+    }
+
+    const bool external = formatProps.format == VK_FORMAT_UNDEFINED;
+    auto externalFormat = makeStruct<VkExternalFormatANDROID>(VK_STRUCTURE_TYPE_EXTERNAL_FORMAT_ANDROID);
+    externalFormat.externalFormat = external ? formatProps.externalFormat : 0;
+
+    // Linear chroma reconstruction is optional; fall back to nearest when unsupported.
+    const bool linear = (formatProps.formatFeatures & VK_FORMAT_FEATURE_SAMPLED_IMAGE_YCBCR_CONVERSION_LINEAR_FILTER_BIT) != 0;
+    const VkFilter filter = linear ? VK_FILTER_LINEAR : VK_FILTER_NEAREST;
+
+    auto cci = makeStruct<VkSamplerYcbcrConversionCreateInfo>(VK_STRUCTURE_TYPE_SAMPLER_YCBCR_CONVERSION_CREATE_INFO);
+    cci.pNext = &externalFormat;
+    cci.format = formatProps.format;
+    cci.ycbcrModel = formatProps.suggestedYcbcrModel;
+    cci.ycbcrRange = formatProps.suggestedYcbcrRange;
+    cci.components = formatProps.samplerYcbcrConversionComponents;
+    cci.xChromaOffset = formatProps.suggestedXChromaOffset;
+    cci.yChromaOffset = formatProps.suggestedYChromaOffset;
+    cci.chromaFilter = filter;
+    cci.forceExplicitReconstruction = VK_FALSE;
+    if (pfnCreateYcbcrConversion_(device_, &cci, nullptr, &ycbcr_.conversion) != VK_SUCCESS) {
+        LOGE("vkCreateSamplerYcbcrConversion failed");
+        ycbcr_.conversion = VK_NULL_HANDLE;
+        return false;
+    }
+    ycbcr_.externalFormat = formatProps.externalFormat;
+    ycbcr_.format = formatProps.format;
+
+    auto conversionInfo = makeStruct<VkSamplerYcbcrConversionInfo>(VK_STRUCTURE_TYPE_SAMPLER_YCBCR_CONVERSION_INFO);
+    conversionInfo.conversion = ycbcr_.conversion;
+
+    auto sci = makeStruct<VkSamplerCreateInfo>(VK_STRUCTURE_TYPE_SAMPLER_CREATE_INFO);
+    sci.pNext = &conversionInfo;
+    sci.magFilter = filter;
+    sci.minFilter = filter;
+    sci.mipmapMode = VK_SAMPLER_MIPMAP_MODE_NEAREST;
+    sci.addressModeU = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sci.addressModeV = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sci.addressModeW = VK_SAMPLER_ADDRESS_MODE_CLAMP_TO_EDGE;
+    sci.anisotropyEnable = VK_FALSE;
+    sci.maxAnisotropy = 1.0f;
+    sci.compareEnable = VK_FALSE;
+    sci.borderColor = VK_BORDER_COLOR_INT_OPAQUE_BLACK;
+    sci.unnormalizedCoordinates = VK_FALSE;
+    if (vkCreateSampler(device_, &sci, nullptr, &ycbcr_.sampler) != VK_SUCCESS) {
+        LOGE("vkCreateSampler for YCbCr conversion failed");
+        destroyYcbcrResources();
         return false;
     }
 
-    // Update descriptors to point to new view
-    for (size_t i = 0; i < descriptorSets_.size(); ++i) {
-        VkDescriptorImageInfo ii{};
-        ii.imageLayout = VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL;
-        ii.imageView = textureView_;
-        ii.sampler = textureSampler_;
+    VkDescriptorSetLayoutBinding binding{};
+    binding.binding = 0;
+    binding.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
+    binding.descriptorCount = 1;
+    binding.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    binding.pImmutableSamplers = &ycbcr_.sampler;
+
+    auto lci = makeStruct<VkDescriptorSetLayoutCreateInfo>(VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO);
+    lci.bindingCount = 1;
+    lci.pBindings = &binding;
+    if (vkCreateDescriptorSetLayout(device_, &lci, nullptr, &ycbcr_.setLayout) != VK_SUCCESS) {
+        LOGE("vkCreateDescriptorSetLayout for YCbCr conversion failed");
+        destroyYcbcrResources();
+        return false;
+    }
 
-        auto write = makeStruct<VkWriteDescriptorSet>(VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET);
-        write.dstSet = descriptorSets_[i];
-        write.dstBinding = 0;
-        write.descriptorType = VK_DESCRIPTOR_TYPE_COMBINED_IMAGE_SAMPLER;
-        write.descriptorCount = 1;
-        write.pImageInfo = &ii;
-        vkUpdateDescriptorSets(device_, 1, &write, 0, nullptr);
+    VkPushConstantRange push{};
+    push.stageFlags = VK_SHADER_STAGE_FRAGMENT_BIT;
+    push.offset = 0;
+    push.size = sizeof(PassPushConstants);
+
+    const VkDescriptorSetLayout setLayouts[] = { ycbcr_.setLayout, chainSetLayout_, descriptorSetLayout_ };
+    auto pci = makeStruct<VkPipelineLayoutCreateInfo>(VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO);
+    pci.setLayoutCount = 3;
+    pci.pSetLayouts = setLayouts;
+    pci.pushConstantRangeCount = 1;
+    pci.pPushConstantRanges = &push;
+    if (vkCreatePipelineLayout(device_, &pci, nullptr, &ycbcr_.pipelineLayout) != VK_SUCCESS) {
+        LOGE("vkCreatePipelineLayout for YCbCr conversion failed");
+        destroyYcbcrResources();
+        return false;
     }
 
     return true;
 }
 
-bool VulkanRenderer::createSyncObjects() {
-    const size_t frames = swapchain_.images.size();
-    swapchain_.imageAvailable.resize(frames);
-    swapchain_.renderFinished.resize(frames);
-    swapchain_.inFlightFences.resize(frames);
+void VulkanRenderer::releaseImportedBuffer(ImportedBuffer& entry) {
+    if (entry.descriptorSet != VK_NULL_HANDLE) {
+        vkFreeDescriptorSets(device_, importDescriptorPool_, 1, &entry.descriptorSet);
+        entry.descriptorSet = VK_NULL_HANDLE;
+    }
+    if (entry.view != VK_NULL_HANDLE) {
+        vkDestroyImageView(device_, entry.view, nullptr);
+        entry.view = VK_NULL_HANDLE;
+    }
+    if (entry.image != VK_NULL_HANDLE) {
+        vkDestroyImage(device_, entry.image, nullptr);
+        entry.image = VK_NULL_HANDLE;
+    }
+    if (entry.memory != VK_NULL_HANDLE) {
+        vkFreeMemory(device_, entry.memory, nullptr);
+        entry.memory = VK_NULL_HANDLE;
+    }
+    if (entry.buffer) {
+        AHardwareBuffer_release(entry.buffer);
+        entry.buffer = nullptr;
+    }
+}
+
+void VulkanRenderer::releaseImportedBuffers() {
+    for (auto& e : imports_) releaseImportedBuffer(e);
+    imports_.clear();
+    activeImport_ = -1;
+}
+
+void VulkanRenderer::destroyYcbcrResources() {
+    destroyPipelineVariants(true);
+    if (ycbcr_.analysisPipeline != VK_NULL_HANDLE) vkDestroyPipeline(device_, ycbcr_.analysisPipeline, nullptr);
+    if (ycbcr_.pipelineLayout != VK_NULL_HANDLE) vkDestroyPipelineLayout(device_, ycbcr_.pipelineLayout, nullptr);
+    if (ycbcr_.setLayout != VK_NULL_HANDLE) vkDestroyDescriptorSetLayout(device_, ycbcr_.setLayout, nullptr);
+    if (ycbcr_.sampler != VK_NULL_HANDLE) vkDestroySampler(device_, ycbcr_.sampler, nullptr);
+    if (ycbcr_.conversion != VK_NULL_HANDLE && pfnDestroyYcbcrConversion_) {
+        pfnDestroyYcbcrConversion_(device_, ycbcr_.conversion, nullptr);
+    }
+    ycbcr_ = YcbcrResources{};
+}
 
+bool VulkanRenderer::createFrameResources() {
+    // Timestamps need graphics-queue support; timestampPeriod converts ticks to ns.
+    VkPhysicalDeviceProperties props{};
+    vkGetPhysicalDeviceProperties(physicalDevice_, &props);
+    uint32_t familyCount = 0;
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice_, &familyCount, nullptr);
+    std::vector<VkQueueFamilyProperties> families(familyCount);
+    vkGetPhysicalDeviceQueueFamilyProperties(physicalDevice_, &familyCount, families.data());
+    const uint32_t validBits = graphicsQueueFamily_ < familyCount ? families[graphicsQueueFamily_].timestampValidBits : 0;
+    timestampPeriod_ = validBits > 0 ? props.limits.timestampPeriod : 0.0f;
+    timestampMask_ = validBits >= 64 ? ~0ull : ((1ull << validBits) - 1);
+    if (timestampPeriod_ <= 0.0f) LOGW("GPU timestamps unavailable; gpuTime will stay 0");
+
+    auto qi = makeStruct<VkQueryPoolCreateInfo>(VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO);
+    qi.queryType = VK_QUERY_TYPE_TIMESTAMP;
+    qi.queryCount = kTimestampsPerFrame;
+
+    auto pi = makeStruct<VkCommandPoolCreateInfo>(VK_STRUCTURE_TYPE_COMMAND_POOL_CREATE_INFO);
+    pi.queueFamilyIndex = graphicsQueueFamily_;
+    pi.flags = VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
     auto si = makeStruct<VkSemaphoreCreateInfo>(VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO);
     auto fi = makeStruct<VkFenceCreateInfo>(VK_STRUCTURE_TYPE_FENCE_CREATE_INFO);
     fi.flags = VK_FENCE_CREATE_SIGNALED_BIT;
 
-    for (size_t i = 0; i < frames; ++i) {
-        if (vkCreateSemaphore(device_, &si, nullptr, &swapchain_.imageAvailable[i]) != VK_SUCCESS ||
-            vkCreateSemaphore(device_, &si, nullptr, &swapchain_.renderFinished[i]) != VK_SUCCESS ||
-            vkCreateFence(device_, &fi, nullptr, &swapchain_.inFlightFences[i]) != VK_SUCCESS) {
-            LOGE("Failed to create sync objects for frame %zu", i);
+    for (size_t i = 0; i < frames_.size(); ++i) {
+        FrameResources& frame = frames_[i];
+        if (vkCreateCommandPool(device_, &pi, nullptr, &frame.pool) != VK_SUCCESS) {
+            LOGE("Failed to create command pool for frame slot %zu", i);
             return false;
         }
+        auto alloc = makeStruct<VkCommandBufferAllocateInfo>(VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO);
+        alloc.commandPool = frame.pool;
+        alloc.level = VK_COMMAND_BUFFER_LEVEL_PRIMARY;
+        alloc.commandBufferCount = 1;
+        if (vkAllocateCommandBuffers(device_, &alloc, &frame.cmd) != VK_SUCCESS ||
+            vkCreateSemaphore(device_, &si, nullptr, &frame.imageAvailable) != VK_SUCCESS ||
+            vkCreateFence(device_, &fi, nullptr, &frame.inFlight) != VK_SUCCESS) {
+            LOGE("Failed to create sync objects for frame slot %zu", i);
+            return false;
+        }
+        if (timestampPeriod_ > 0.0f && vkCreateQueryPool(device_, &qi, nullptr, &frame.timestamps) != VK_SUCCESS) {
+            frame.timestamps = VK_NULL_HANDLE; // timing is optional
+        }
     }
     return true;
 }
 
-bool VulkanRenderer::recordCommandBuffers() {
-    for (size_t i = 0; i < swapchain_.images.size(); ++i) {
-        if (!recordCommandBuffer(static_cast<uint32_t>(i))) return false;
+void VulkanRenderer::destroyFrameResources() {
+    for (auto& frame : frames_) {
+        if (frame.timestamps != VK_NULL_HANDLE) vkDestroyQueryPool(device_, frame.timestamps, nullptr);
+        if (frame.inFlight != VK_NULL_HANDLE) vkDestroyFence(device_, frame.inFlight, nullptr);
+        if (frame.imageAvailable != VK_NULL_HANDLE) vkDestroySemaphore(device_, frame.imageAvailable, nullptr);
+        if (frame.pool != VK_NULL_HANDLE) vkDestroyCommandPool(device_, frame.pool, nullptr); // frees frame.cmd
+        frame = FrameResources{};
+    }
+}
+
+bool VulkanRenderer::createSyncObjects() {
+    const size_t images = swapchain_.images.size();
+    swapchain_.renderFinished.resize(images);
+    swapchain_.imagesInFlight.assign(images, VK_NULL_HANDLE);
+
+    auto si = makeStruct<VkSemaphoreCreateInfo>(VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO);
+    for (size_t i = 0; i < images; ++i) {
+        if (vkCreateSemaphore(device_, &si, nullptr, &swapchain_.renderFinished[i]) != VK_SUCCESS) {
+            LOGE("Failed to create sync objects for image %zu", i);
+            return false;
+        }
     }
     return true;
 }
 
 void VulkanRenderer::cleanupSwapchain() {
+    destroyIntermediateTargets();
+    destroyMergedTargets();
     for (auto fb : framebuffers_) if (fb) vkDestroyFramebuffer(device_, fb, nullptr);
     framebuffers_.clear();
-    for (auto f : swapchain_.inFlightFences) if (f) vkDestroyFence(device_, f, nullptr);
-    for (auto s : swapchain_.imageAvailable) if (s) vkDestroySemaphore(device_, s, nullptr);
     for (auto s : swapchain_.renderFinished) if (s) vkDestroySemaphore(device_, s, nullptr);
-    swapchain_.inFlightFences.clear();
-    swapchain_.imageAvailable.clear();
     swapchain_.renderFinished.clear();
-
-    if (commandPool_ != VK_NULL_HANDLE && !swapchain_.commandBuffers.empty()) {
-        vkFreeCommandBuffers(device_, commandPool_, static_cast<uint32_t>(swapchain_.commandBuffers.size()), swapchain_.commandBuffers.data());
-    }
-    swapchain_.commandBuffers.clear();
+    swapchain_.imagesInFlight.clear(); // fences belong to frames_
     for (auto v : swapchain_.imageViews) if (v) vkDestroyImageView(device_, v, nullptr);
     swapchain_.imageViews.clear();
+    if (headless_) {
+        for (auto image : swapchain_.images) if (image) vkDestroyImage(device_, image, nullptr);
+        for (auto& memory : swapchain_.memory) freeMemory(memory);
+    }
+    swapchain_.memory.clear();
     swapchain_.images.clear();
 
     if (swapchain_.swapchain != VK_NULL_HANDLE) {
         vkDestroySwapchainKHR(device_, swapchain_.swapchain, nullptr);
         swapchain_.swapchain = VK_NULL_HANDLE;
     }
+    swapchain_.outOfDate = false;
+}
+
+void VulkanRenderer::retireSwapchainResources(RetiredResources& retired) {
+    // Effect targets are sized by the window rather than the images; render() replaces
+    // them only if that size changed.
+    retired.frame = currentFrame_;
+    retired.swapchain = swapchain_.swapchain;
+    retired.imageViews.swap(swapchain_.imageViews);
+    retired.framebuffers.swap(framebuffers_);
+    retired.semaphores.swap(swapchain_.renderFinished);
+    retired.targets.insert(retired.targets.end(), mergedTargets_.begin(), mergedTargets_.end());
+    if (mergedDescriptorPool_ != VK_NULL_HANDLE) retired.descriptorPools.push_back(mergedDescriptorPool_);
+    mergedTargets_.clear();
+    mergedDescriptorPool_ = VK_NULL_HANDLE;
+    swapchain_.swapchain = VK_NULL_HANDLE;
+    swapchain_.images.clear();
+    swapchain_.imagesInFlight.clear(); // fences belong to frames_
+}
+
+void VulkanRenderer::retireIntermediateTargets(RetiredResources& retired) {
+    for (const auto& target : targets_) if (target.image) retired.targets.push_back(target);
+    for (const auto& level : pyramid_) if (level.image) retired.targets.push_back(level);
+    for (const auto& level : glassPyramid_) if (level.image) retired.targets.push_back(level);
+    if (targetDescriptorPool_ != VK_NULL_HANDLE) retired.descriptorPools.push_back(targetDescriptorPool_);
+    targets_ = {};
+    pyramid_ = {};
+    glassPyramid_ = {};
+    pyramidLevels_ = 0;
+    glassLevels_ = 0;
+    renderExtent_ = {};
+    glassExtent_ = {};
+    targetDescriptorPool_ = VK_NULL_HANDLE;
+}
+
+void VulkanRenderer::destroyRetired(bool all) {
+    for (auto it = retired_.begin(); it != retired_.end();) {
+        if (!all && !frameRetired(it->frame)) {
+            ++it;
+            continue;
+        }
+        for (auto fb : it->framebuffers) if (fb) vkDestroyFramebuffer(device_, fb, nullptr);
+        for (auto v : it->imageViews) if (v) vkDestroyImageView(device_, v, nullptr);
+        for (auto& target : it->targets) destroyTarget(target);
+        for (auto pool : it->descriptorPools) vkDestroyDescriptorPool(device_, pool, nullptr); // frees their sets
+        for (auto semaphore : it->semaphores) if (semaphore) vkDestroySemaphore(device_, semaphore, nullptr);
+        if (it->swapchain != VK_NULL_HANDLE) vkDestroySwapchainKHR(device_, it->swapchain, nullptr);
+        it = retired_.erase(it);
+    }
 }
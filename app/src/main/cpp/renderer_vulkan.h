@@ -3,32 +3,98 @@
 #include <vulkan/vulkan.h>
 #include <vulkan/vulkan_android.h>
 #include <android/native_window.h>
+#include <android/hardware_buffer.h>
 #include <vector>
 #include <optional>
 #include <array>
+#include <string>
+#include <unordered_map>
 
 // [FIX] Required for LuminaState definition
+#include "analysis_frame.h"
+#include "blur_pyramid.h"
 #include "engine_structs.h"
+#include "effect_graph.h"
+#include "frame_stats.h"
+#include "glass_panels.h"
+#include "gpu_memory.h"
+#include "pixel_convert.h"
+#include "render_scale.h"
 
 class VulkanRenderer {
 public:
+    // Null window: instance, device and everything not bound to a surface only; the
+    // first recreate() with a window adds the swapchain. render() fails until then.
     bool initialize(ANativeWindow* window);
+
+    // Offscreen mode for benchmarks and device-farm runs: renders into one device-local
+    // image per frame in flight instead of a swapchain, with no surface, acquire or
+    // present. Everything else (passes, uploads, timestamps) is the on-screen path.
+    bool initializeHeadless(uint32_t width, uint32_t height);
+    bool isHeadless() const { return headless_; }
     void destroy();
 
+    // Blocks until every submitted frame has finished executing.
+    void waitIdle();
+
     // [FIX] Update signature to accept state for effect processing
     bool render(const lumina::LuminaState& state);
     
+    // Same window (or null): hands the old swapchain to the new one and rebuilds only
+    // what is sized by it, retiring the old objects once the frames using them are done.
+    // The render passes, pipelines and descriptor sets stay unless the format changed.
+    // A different window waits for the GPU and rebuilds the surface as well.
     bool recreate(ANativeWindow* window);
+
+    // Drops the swapchain and surface but keeps the device, pipelines and uploads, so
+    // the next recreate() only rebuilds what the window owns.
+    void detachSurface();
+
+    // Builds the pipeline variants the chains in `states` need (effect_graph.h
+    // warmupStates()), into the persistent pipeline cache. Before any surface they
+    // target the preferred surface format; a surface in another format rebuilds lazily.
+    bool warmUp(const std::vector<lumina::LuminaState>& states);
+
+    // Frames submitted so far; render() can succeed without one, e.g. when it only
+    // recreated an out-of-date swapchain.
+    uint64_t submittedFrames() const { return currentFrame_; }
+
+    // Frames below this index have finished on the GPU, so inputs they sampled can go
+    // back to their producer. Polls the in-flight fences without waiting.
+    uint64_t completedFrames() const;
     
     // [FIX] Method to receive raw camera frames from Kotlin
     bool uploadTexture(const void* data, size_t size, uint32_t width, uint32_t height);
 
-    // Matches GLSL layout(push_constant) uniform block alignment (std140)
+    // Completion value of the newest uploadTexture() / uploadYuv(), and the newest value
+    // whose copy has executed; sources such as frame slots the copy read can go back to
+    // their producer once completedUploads() reaches the value. Polls without waiting.
+    uint64_t lastUploadValue() const { return uploadTimelineValue_; }
+    uint64_t completedUploads() const;
+
+    // Camera YUV_420_888 planes, converted to RGBA (downscaled by 1, 2 or 4) directly
+    // into the upload slot's staging memory. Same slot ring and hand-off as uploadTexture().
+    bool uploadYuv(const lumina::YuvPlanes& planes, uint32_t downscale);
+
+    // Zero-copy camera path: imports an AHardwareBuffer through
+    // VK_ANDROID_external_memory_android_hardware_buffer. Native YUV formats are
+    // sampled through a VkSamplerYcbcrConversion. Returns false when the device or
+    // the buffer cannot be imported so callers can fall back to uploadTexture().
+    bool importHardwareBuffer(AHardwareBuffer* buffer);
+    bool supportsHardwareBufferImport() const { return ahbSupported_; }
+
+    // Earliest CLOCK_MONOTONIC time the next present should reach the display, passed
+    // through VK_GOOGLE_display_timing when the device has it. 0 presents immediately.
+    void setDesiredPresentTime(uint64_t nanos) { desiredPresentTime_ = nanos; }
+
+    // Frame-wide values the effect passes start from; render() fills in time, exposure
+    // and resolution. Per-effect parameters reach the shaders through the EffectChain
+    // uniform block instead.
     struct EffectParams {
         float time;
         float intensity;
         int effectType;
-        float pad0;      // Padding for 16-byte alignment
+        float exposure;  // stylized look, applied by the surface pass
         float tint[4];
         float center[2];
         float scale[2];
@@ -36,30 +102,132 @@ public:
         float resolution[2];
     };
 
+    // Push constants for every effect pass (lumina_params.glsl). Op parameters come from
+    // a per-frame uniform buffer holding LuminaState::effects as-is; single-effect
+    // shaders read the slot in the low byte of opSlots.
+    struct PassPushConstants {
+        float time;
+        uint32_t opCount;
+        uint32_t opSlots;   // one effects[] index per byte
+        float exposure;
+        float resolution[2];
+        float pyramidOffset; // BLOOM's pyramid upsample; 0 when the pass has none
+    };
+
+    // Push constants for the blur pyramid stages (blur_down.frag, blur_up.frag).
+    struct PyramidPushConstants {
+        float offset;       // tap spread in texels of the level sampled
+        float threshold;    // bloom prefilter only
+    };
+
+    // Push constants for the glass panel pass (glass.frag).
+    struct GlassPushConstants {
+        float rect[4];          // panel in display pixels, origin top-left
+        float resolution[2];    // display size
+        float framebuffer[2];   // swapchain image size, pre-rotated
+        float cornerRadius;
+        float offset;           // tap spread of the last upsample
+        float saturation;
+        float brightness;
+    };
+
+    // Push constants for the analysis pass (analysis.frag).
+    struct AnalysisPushConstants {
+        float size[2];      // analysis frame in pixels
+        uint32_t gray;
+    };
+
     void setEffectParams(const EffectParams& params);
 
+    // Directory for the persistent pipeline cache; set before initialize().
+    void setCacheDirectory(const std::string& dir) { cacheDir_ = dir; }
+
+    // Receives record/submit CPU times, per-pass GPU times and device memory usage
+    // (may be null).
+    void setFrameStats(lumina::FrameStats* stats) {
+        stats_ = stats;
+        reportMemoryUsage();
+    }
+
+    // Device memory bound per category, and what the renderer holds to back it.
+    const lumina::GpuMemoryUsage& memoryUsage() const { return memoryUsage_; }
+
+    // Packed low-res copy of the camera input (analysis_frame.h): drawn after the
+    // surface pass, copied into a host-cached buffer and published to `sink` once the
+    // frame slot's fence has signalled. Applied at the next render().
+    void setAnalysisOutput(const lumina::AnalysisConfig& config, lumina::AnalysisFrameExchange* sink) {
+        analysisConfig_ = config;
+        analysisSink_ = sink;
+    }
+
+    // Recording output: each frame is blitted into a swapchain on `window` (an encoder's
+    // input surface) and presented together with the display image, so the encoder
+    // reads the finished frame straight from GPU memory. Null detaches; the swapchain
+    // is created at the next render(). The caller keeps `window` alive until detached.
+    void setEncoderWindow(ANativeWindow* window);
+
+    // CLOCK_MONOTONIC timestamp of the next frame in the recording, handed to the
+    // encoder as its VK_GOOGLE_display_timing present time. 0 leaves the frame out.
+    void setEncoderTimestamp(int64_t nanos) { encoderTimestamp_ = nanos; }
+
+    // Fraction of the surface size the intermediate effect passes render at (see
+    // render_scale.h); the surface pass upscales. Applied at the next render(); the old
+    // targets are retired rather than waited for.
+    void setRenderScale(float scale) { renderScale_ = scale; }
+
+    // Where the UI's glass panels sit (glass_panels.h). After the surface pass and the
+    // encoder copy, the finished image is copied into a blur pyramid and drawn back
+    // blurred inside each panel. Needs swapchain images that can be copied from.
+    void setGlassLayout(const lumina::GlassLayout& layout) { glassLayout_ = layout; }
+
 private:
+    static constexpr VkFormat kPreferredSurfaceFormat = VK_FORMAT_R8G8B8A8_UNORM;
+
+    // A range of device memory bound to one image or buffer: a slice of a shared block,
+    // or memory of its own (block < 0). Host-visible memory stays mapped for its lifetime.
+    struct GpuAllocation {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        VkDeviceSize offset = 0;
+        VkDeviceSize size = 0;
+        void* mapped = nullptr;
+        VkMemoryPropertyFlags flags = 0;   // of the memory type it landed in
+        int32_t block = -1;                // index into memoryBlocks_
+        lumina::GpuMemoryCategory category = lumina::GpuMemoryCategory::Targets;
+    };
+
     struct SwapchainResources {
         VkSwapchainKHR swapchain = VK_NULL_HANDLE;
         std::vector<VkImage> images;
         std::vector<VkImageView> imageViews;
-        std::vector<VkCommandBuffer> commandBuffers;
-        std::vector<VkSemaphore> imageAvailable;
-        std::vector<VkSemaphore> renderFinished;
-        std::vector<VkFence> inFlightFences;
+        std::vector<VkSemaphore> renderFinished;   // per image, signalled for present
+        std::vector<VkFence> imagesInFlight;       // fence of the frame last rendering each image
+        std::vector<GpuAllocation> memory;         // headless targets only; swapchain images are not ours
         uint32_t width = 0;
         uint32_t height = 0;
         VkFormat format = VK_FORMAT_UNDEFINED;
+        VkImageUsageFlags usage = 0;
+        // The surface pass draws rotated by quarterTurns so the compositor does not have
+        // to; width/height are the images' own, i.e. swapped from the window when odd.
+        VkSurfaceTransformFlagBitsKHR transform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+        VkSurfaceTransformFlagBitsKHR surfaceTransform = VK_SURFACE_TRANSFORM_IDENTITY_BIT_KHR;
+        uint32_t quarterTurns = 0;
+        bool outOfDate = false;    // rebuilt at the next render()
     };
 
+
+    bool initializeDevice();
     bool createInstance();
     bool createSurface(ANativeWindow* window);
     bool pickPhysicalDevice();
     bool createDevice();
+    bool loadDeviceFunctions();
     bool createCommandPool();
-    bool createSwapchain();
+    bool createSwapchain(VkSwapchainKHR oldSwapchain = VK_NULL_HANDLE);
+    bool resizeSwapchain();
+    VkSurfaceTransformFlagBitsKHR presentTransform(VkSurfaceTransformFlagBitsKHR current) const;
+    VkExtent2D surfaceExtent() const;  // the window's orientation, before pre-rotation
+    bool createHeadlessTargets();
     bool createSyncObjects();
-    bool recordCommandBuffers();
     bool createRenderPass();
     bool createDescriptorSetLayout();
     bool createPipelineLayout();
@@ -68,48 +236,390 @@ private:
     bool createTextureResources();
     bool createSampler();
     bool createDescriptorPoolAndSets();
-    bool recordCommandBuffer(uint32_t imageIndex);
+    struct FrameResources;
+    bool createFrameResources();
+    void destroyFrameResources();
+    void beginFrameCommands(FrameResources& frame, uint32_t frameSlot);
+    bool recordPass(FrameResources& frame, uint32_t frameSlot, uint32_t pass, uint32_t imageIndex);
+    bool recordMergedTail(FrameResources& frame, uint32_t frameSlot, uint32_t imageIndex);
+    bool resolveSurfacePipelines(const FrameResources& frame, bool mergedTail);
+    void abandonAcquiredFrame(FrameResources& frame, uint32_t frameSlot, bool encode);
+    void drawPass(FrameResources& frame, uint32_t frameSlot, const lumina::EffectPass& pass,
+                  VkExtent2D extent, VkExtent2D resolution, VkPipelineLayout layout, VkPipeline pipeline,
+                  VkDescriptorSet input, float pyramidOffset = 0.0f);
+    float recordPyramid(FrameResources& frame, const lumina::EffectPass& pass, VkDescriptorSet input);
+    VkPipeline pyramidPipeline(lumina::PyramidStage stage);
+    bool resolveGlassPipelines(const FrameResources& frame);
+    VkPipeline glassPipeline();
+    void recordGlass(FrameResources& frame, uint32_t imageIndex);
+    void collectGpuTimings(FrameResources& frame);
+    uint32_t framesInFlight() const;
     void cleanupSwapchain();
+    struct RetiredResources;
+    void retireSwapchainResources(RetiredResources& retired);
+    void retireIntermediateTargets(RetiredResources& retired);
+    void destroyRetired(bool all);
+    bool buildPipeline(VkPipelineLayout layout, const std::vector<uint32_t>& fragSpv,
+                       const VkSpecializationInfo* specialization, VkPipeline& pipeline,
+                       VkRenderPass renderPass = VK_NULL_HANDLE,  // null: renderPass_
+                       uint32_t subpass = 0, uint32_t quarterTurns = 0, bool blend = false);
+    VkPipeline pipelineVariant(const FrameResources& frame, const lumina::EffectPass& pass,
+                               bool lastPass, bool ycbcr, bool merged = false);
+    void destroyPipelineVariants(bool ycbcrOnly);
+    bool createPipelineCache();
+    void savePipelineCache();
+    void destroyPipelineCache();
+
+    // Effect graph helpers
+    struct IntermediateTarget;
+    void recordPyramidStage(VkCommandBuffer cmd, VkPipeline pipeline, VkDescriptorSet source,
+                            const IntermediateTarget& target, VkExtent2D extent, const PyramidPushConstants& push);
+    bool createIntermediateTargets();
+    bool createTarget(IntermediateTarget& target, VkExtent2D extent, VkImageUsageFlags extraUsage = 0);
+    bool createMergedTargets();
+    void destroyTarget(IntermediateTarget& target);
+    void destroyIntermediateTargets();
+    void destroyMergedTargets();
+    bool applyRenderScale();
+    void writeTargetDescriptors();
+    bool createEffectChainBuffer();
+    void destroyEffectChainBuffer();
+
+    // Analysis branch helpers
+    struct AnalysisTarget;
+    bool ensureAnalysisTargets();
+    bool createAnalysisRenderPass();
+    bool createAnalysisTarget(AnalysisTarget& target);
+    void destroyAnalysisTargets();
+    VkPipeline analysisPipeline(bool ycbcr);
+    void recordAnalysisPass(FrameResources& frame, uint32_t frameSlot);
+    void collectAnalysisFrame(AnalysisTarget& target);
+
+    // Recording output helpers
+    bool ensureEncoderOutput();
+    bool createEncoderOutput();
+    void destroyEncoderOutput();
+    void recordEncoderBlit(VkCommandBuffer cmd, uint32_t imageIndex, uint32_t encoderIndex);
+
+    // AHardwareBuffer import helpers
+    struct ImportedBuffer;
+    bool createImportDescriptorPool();
+    ImportedBuffer* findOrImportBuffer(AHardwareBuffer* buffer);
+    bool ensureYcbcrResources(const VkAndroidHardwareBufferFormatPropertiesANDROID& formatProps);
+    void releaseImportedBuffer(ImportedBuffer& entry);
+    void releaseImportedBuffers();
+    void destroyYcbcrResources();
+
+    // Staged upload ring helpers
+    struct UploadSlot;
+    bool createUploadResources();
+    int acquireUploadSlot();
+    int beginUpload(uint32_t width, uint32_t height);  // slot index with mapped staging, or -1
+    bool submitUpload(int index);                       // staging -> image copy, publishes the slot
+    bool allocateUploadSlot(UploadSlot& slot, uint32_t width, uint32_t height, VkDeviceSize size);
+    void releaseUploadSlot(UploadSlot& slot);
+    void destroyUploadResources();
+    bool frameRetired(uint64_t frame) const;
+    std::optional<uint32_t> findMemoryType(uint32_t typeBits, VkMemoryPropertyFlags flags) const;
+
+    // GPU memory (gpu_memory.h). Binds `image` / `buffer` to memory with every `required`
+    // property, in a type that also has `preferred` when there is one.
+    bool allocateImageMemory(VkImage image, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred,
+                             lumina::GpuMemoryCategory category, GpuAllocation& out);
+    bool allocateBufferMemory(VkBuffer buffer, VkMemoryPropertyFlags required, VkMemoryPropertyFlags preferred,
+                              lumina::GpuMemoryCategory category, GpuAllocation& out);
+    bool allocateMemory(const VkMemoryRequirements& requirements, bool linear, VkMemoryPropertyFlags required,
+                        VkMemoryPropertyFlags preferred, lumina::GpuMemoryCategory category, GpuAllocation& out);
+    bool allocateDedicated(uint32_t typeIndex, VkDeviceSize size, VkDeviceMemory& memory, void*& mapped);
+    void freeMemory(GpuAllocation& allocation);
+    void destroyMemoryBlocks();
+    void reportMemoryUsage();
 
     uint32_t findGraphicsQueueFamily(VkPhysicalDevice device);
 
     VkInstance instance_ = VK_NULL_HANDLE;
     VkSurfaceKHR surface_ = VK_NULL_HANDLE;
     VkPhysicalDevice physicalDevice_ = VK_NULL_HANDLE;
+    VkPhysicalDeviceMemoryProperties memoryProperties_{};  // cached by createDevice()
+    VkDeviceSize nonCoherentAtomSize_ = 1;
+
+    // Shared device memory, sub-allocated per memory type. Buffers and images never
+    // share a block, so bufferImageGranularity cannot apply; an emptied block is freed
+    // unless it is the only empty one of its kind. Freed entries are reused in place,
+    // keeping GpuAllocation::block valid.
+    struct MemoryBlock {
+        VkDeviceMemory memory = VK_NULL_HANDLE;
+        uint32_t typeIndex = 0;
+        bool linear = false;    // buffers
+        void* mapped = nullptr;
+        lumina::BlockSuballocator ranges{0};
+    };
+    std::vector<MemoryBlock> memoryBlocks_;
+    lumina::GpuMemoryUsage memoryUsage_{};
     VkDevice device_ = VK_NULL_HANDLE;
     VkQueue graphicsQueue_ = VK_NULL_HANDLE;
     uint32_t graphicsQueueFamily_ = 0;
     VkCommandPool commandPool_ = VK_NULL_HANDLE;
 
+    // Camera uploads run on a transfer-only queue family when the device exposes one,
+    // otherwise on a second handle to the graphics queue.
+    VkQueue transferQueue_ = VK_NULL_HANDLE;
+    uint32_t transferQueueFamily_ = 0;
+    VkCommandPool transferCommandPool_ = VK_NULL_HANDLE;
+
     VkRenderPass renderPass_ = VK_NULL_HANDLE;
     VkPipelineLayout pipelineLayout_ = VK_NULL_HANDLE;
-    VkPipeline graphicsPipeline_ = VK_NULL_HANDLE;
     std::vector<VkFramebuffer> framebuffers_;
 
+    // Intermediate passes render into two swapchain-format ping-pong targets through a
+    // render pass compatible with renderPass_, so every pipeline serves both.
+    struct IntermediateTarget {
+        VkImage image = VK_NULL_HANDLE;
+        GpuAllocation memory;
+        VkImageView view = VK_NULL_HANDLE;
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+    };
+    VkRenderPass offscreenRenderPass_ = VK_NULL_HANDLE;
+    // Sets for targets_ and pyramid_, reallocated with them so a resize never rewrites
+    // a set an in-flight frame has bound.
+    VkDescriptorPool targetDescriptorPool_ = VK_NULL_HANDLE;
+    std::array<IntermediateTarget, 2> targets_{};
+    float renderScale_ = 1.0f;      // requested
+    VkExtent2D renderExtent_{};     // what targets_ are sized for
+
+    // Levels of the BLUR/BLOOM dual-filter pyramid (blur_pyramid.h), each half the
+    // size of the one before, starting from renderExtent_. Passes that read it bind
+    // level 0 as set 2; pyramidLevels_ may be fewer than kMaxBlurLevels on small targets.
+    std::array<IntermediateTarget, lumina::kMaxBlurLevels> pyramid_{};
+    uint32_t pyramidLevels_ = 0;
+
+    // The glass panels' pyramid (glass_panels.h). It starts from a blit of the finished
+    // swapchain image, so it lies pre-rotated: level 0 halves glassExtent_, the image
+    // size at the render scale, and is also a transfer destination. The glass render
+    // pass loads the image after that blit and leaves it ready to present; framebuffers_
+    // serve it too. Empty when the images cannot be blitted from.
+    std::array<IntermediateTarget, lumina::kMaxBlurLevels> glassPyramid_{};
+    uint32_t glassLevels_ = 0;
+    VkExtent2D glassExtent_{};
+    VkFilter glassFilter_ = VK_FILTER_LINEAR;
+    VkRenderPass glassRenderPass_ = VK_NULL_HANDLE;
+    VkPipelineLayout glassPipelineLayout_ = VK_NULL_HANDLE;  // set 0 + GlassPushConstants
+    lumina::GlassLayout glassLayout_;
+
+    // A pointwise last pass (lumina::hasPointwiseTail) runs as subpass 1 of one render
+    // pass with the pass before it, reading its output as an input attachment. That
+    // intermediate is never loaded or stored, so on a tiler it stays in tile memory and
+    // its transient image is usually never backed (LAZILY_ALLOCATED where offered). One
+    // per swapchain image: each framebuffer pairs it with the image's view, and the
+    // descriptor set is its input attachment.
+    VkRenderPass mergedRenderPass_ = VK_NULL_HANDLE;
+    std::vector<IntermediateTarget> mergedTargets_;
+    VkDescriptorPool mergedDescriptorPool_ = VK_NULL_HANDLE;
+    VkDescriptorSetLayout inputAttachmentLayout_ = VK_NULL_HANDLE;
+    VkPipelineLayout subpassPipelineLayout_ = VK_NULL_HANDLE;  // input attachment + effect chain
+
+    // Pipelines are specialized per pass shape, render mode and swapchain format
+    // (lumina::effectVariantKey), built on first use. Render passes of the same format
+    // stay compatible, so variants survive swapchain recreation.
+    std::unordered_map<uint64_t, VkPipeline> pipelineVariants_;
+
+    // Serialized to cacheDir_ on destroy() and handed back to the driver at start-up.
+    VkPipelineCache pipelineCache_ = VK_NULL_HANDLE;
+    std::string cacheDir_;
+    std::string driverId_;
+    bool pipelineCacheDirty_ = false;
+
+    VkDescriptorSetLayout chainSetLayout_ = VK_NULL_HANDLE;
+    VkDescriptorSet chainSet_ = VK_NULL_HANDLE;
+    VkBuffer chainBuffer_ = VK_NULL_HANDLE;
+    GpuAllocation chainMemory_;
+    void* chainMapped_ = nullptr;
+    VkDeviceSize chainStride_ = 0;
+
     VkDescriptorSetLayout descriptorSetLayout_ = VK_NULL_HANDLE;
     VkDescriptorPool descriptorPool_ = VK_NULL_HANDLE;
     std::vector<VkDescriptorSet> descriptorSets_;
 
     VkImage textureImage_ = VK_NULL_HANDLE;
-    VkDeviceMemory textureMemory_ = VK_NULL_HANDLE;
+    GpuAllocation textureMemory_;
     VkImageView textureView_ = VK_NULL_HANDLE;
     VkSampler textureSampler_ = VK_NULL_HANDLE;
 
-    struct StagingBuffer {
-        VkBuffer buffer = VK_NULL_HANDLE;
+    // Camera buffers imported from AHardwareBuffers, keyed by buffer pointer. CameraX
+    // cycles through a small fixed set of buffers so a short cache avoids re-importing.
+    static constexpr size_t kMaxImportedBuffers = 8;
+    static constexpr uint64_t kNeverUsed = UINT64_MAX;
+
+    struct ImportedBuffer {
+        AHardwareBuffer* buffer = nullptr;
+        VkImage image = VK_NULL_HANDLE;
         VkDeviceMemory memory = VK_NULL_HANDLE;
-        VkDeviceSize size = 0;
-    } staging_;
+        VkImageView view = VK_NULL_HANDLE;
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        bool ycbcr = false;
+        uint64_t lastUsedFrame = kNeverUsed;
+    };
+
+    // Immutable-sampler state for external (YUV) formats. Rebuilt only if the camera's
+    // external format changes, which invalidates every cached YCbCr import.
+    struct YcbcrResources {
+        uint64_t externalFormat = 0;
+        VkFormat format = VK_FORMAT_UNDEFINED;
+        VkSamplerYcbcrConversion conversion = VK_NULL_HANDLE;
+        VkSampler sampler = VK_NULL_HANDLE;
+        VkDescriptorSetLayout setLayout = VK_NULL_HANDLE;
+        VkPipelineLayout pipelineLayout = VK_NULL_HANDLE;
+        VkPipeline analysisPipeline = VK_NULL_HANDLE;
+    } ycbcr_;
+
+    std::vector<ImportedBuffer> imports_;
+    int activeImport_ = -1;
+    VkDescriptorPool importDescriptorPool_ = VK_NULL_HANDLE;
+
+    bool ahbSupported_ = false;
+    PFN_vkGetAndroidHardwareBufferPropertiesANDROID pfnGetAhbProperties_ = nullptr;
+    PFN_vkCreateSamplerYcbcrConversion pfnCreateYcbcrConversion_ = nullptr;
+    PFN_vkDestroySamplerYcbcrConversion pfnDestroyYcbcrConversion_ = nullptr;
+
+    // Staged camera uploads: a small ring of persistently allocated images, each with a
+    // persistently mapped staging buffer, so frame N+1 can upload while frame N renders.
+    static constexpr size_t kUploadRingSize = 3;
+
+    struct UploadSlot {
+        VkImage image = VK_NULL_HANDLE;
+        GpuAllocation memory;
+        VkImageView view = VK_NULL_HANDLE;
+        VkBuffer staging = VK_NULL_HANDLE;
+        GpuAllocation stagingMemory;
+        void* mapped = nullptr;
+        VkDeviceSize stagingSize = 0;
+        VkCommandBuffer cmd = VK_NULL_HANDLE;
+        VkFence fence = VK_NULL_HANDLE;         // signalled when the copy has executed
+        VkSemaphore ready = VK_NULL_HANDLE;     // binary fallback when timelines are missing
+        VkDescriptorSet descriptorSet = VK_NULL_HANDLE;
+        uint32_t width = 0;
+        uint32_t height = 0;
+        uint64_t readyValue = 0;                // timeline value signalled by the last upload
+        uint64_t lastUsedFrame = kNeverUsed;
+        bool pendingWait = false;               // binary semaphore signalled but not yet waited
+    };
+
+    std::array<UploadSlot, kUploadRingSize> uploadRing_{};
+    int readySlot_ = -1;
+    VkDescriptorPool uploadDescriptorPool_ = VK_NULL_HANDLE;
+
+    bool displayTimingSupported_ = false;
+    uint64_t desiredPresentTime_ = 0;
+    uint32_t presentId_ = 0;
+
+    bool timelineSupported_ = false;
+    VkSemaphore uploadTimeline_ = VK_NULL_HANDLE;
+    uint64_t uploadTimelineValue_ = 0;
 
     EffectParams effectParams_{};
 
+    // CPU frames run up to kMaxFramesInFlight ahead of the GPU regardless of how many
+    // images the swapchain has. Each slot owns its command pool, acquire semaphore and
+    // fence, plus everything its command buffer reads (push constants, effect graph).
+    static constexpr uint32_t kMaxFramesInFlight = 2;
+
+    struct FrameResources {
+        VkCommandPool pool = VK_NULL_HANDLE;
+        VkCommandBuffer cmd = VK_NULL_HANDLE;
+        VkSemaphore imageAvailable = VK_NULL_HANDLE;
+        VkFence inFlight = VK_NULL_HANDLE;
+        EffectParams params{};
+        std::array<lumina::EffectParams, lumina::kMaxEffects> effects{};
+        lumina::EffectGraph graph{};
+        lumina::RenderMode renderMode = lumina::RenderMode::PASSTHROUGH;
+        lumina::GlassmorphicParams uiStyle{};   // fallback BLUR radius, glass blur and tone
+        lumina::GlassLayout glass{};
+        VkDescriptorSet input = VK_NULL_HANDLE;  // camera source for pass 0
+        bool ycbcrInput = false;
+        // Timestamp 0 at frame start, then one after each pass; read back once the
+        // slot's fence has signalled, so results never stall the CPU.
+        VkQueryPool timestamps = VK_NULL_HANDLE;
+        uint32_t timestampCount = 0;
+    };
+    std::array<FrameResources, kMaxFramesInFlight> frames_{};
+
+    // One analysis target and readback buffer per frame slot, so the copy a slot
+    // recorded is read on the CPU right after that slot's fence wait.
+    struct AnalysisTarget {
+        VkImage image = VK_NULL_HANDLE;
+        GpuAllocation memory;
+        VkImageView view = VK_NULL_HANDLE;
+        VkFramebuffer framebuffer = VK_NULL_HANDLE;
+        VkBuffer readback = VK_NULL_HANDLE;
+        GpuAllocation readbackMemory;      // host-cached where offered; may not be coherent
+        void* mapped = nullptr;
+        bool pending = false;         // copy recorded, not yet published
+        uint64_t frameNumber = 0;
+        int64_t timestampNs = 0;
+    };
+    std::array<AnalysisTarget, kMaxFramesInFlight> analysisTargets_{};
+    VkRenderPass analysisRenderPass_ = VK_NULL_HANDLE;
+    VkPipeline analysisPipeline_ = VK_NULL_HANDLE;
+    lumina::AnalysisConfig analysisConfig_;   // requested
+    lumina::AnalysisConfig analysisTarget_;   // what analysisTargets_ are sized for
+    lumina::AnalysisFrameExchange* analysisSink_ = nullptr;
+
+    // Encoder swapchain. Its images are only ever blit destinations; acquire semaphores
+    // are per frame slot like FrameResources::imageAvailable, present semaphores per image.
+    struct EncoderOutput {
+        ANativeWindow* window = nullptr;    // not owned
+        VkSurfaceKHR surface = VK_NULL_HANDLE;
+        VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+        std::vector<VkImage> images;
+        std::vector<VkSemaphore> renderFinished;
+        std::array<VkSemaphore, kMaxFramesInFlight> acquired{};
+        VkExtent2D extent{};
+        VkFilter filter = VK_FILTER_LINEAR;
+        bool outOfDate = false;             // rebuilt at the next render()
+        bool failed = false;                // unusable window; not retried until replaced
+    };
+    EncoderOutput encoder_{};
+    int64_t encoderTimestamp_ = 0;
+    static constexpr uint32_t kTimestampsPerFrame = lumina::kMaxEffectPasses + 1;
+    float timestampPeriod_ = 0.0f;  // ns per tick; 0 when timestamps are unsupported
+    uint64_t timestampMask_ = ~0ull;
+    lumina::FrameStats* stats_ = nullptr;
+
     SwapchainResources swapchain_{};
+
+    // Swapchain-sized objects replaced while frames in flight may still use them, kept
+    // until frameRetired(frame). Old present semaphores are only known to be free once
+    // their images come back, which a retired swapchain never does, so they wait too.
+    struct RetiredResources {
+        uint64_t frame = 0;
+        VkSwapchainKHR swapchain = VK_NULL_HANDLE;
+        std::vector<VkImageView> imageViews;
+        std::vector<VkFramebuffer> framebuffers;
+        std::vector<VkSemaphore> semaphores;
+        std::vector<IntermediateTarget> targets;
+        std::vector<VkDescriptorPool> descriptorPools;
+    };
+    std::vector<RetiredResources> retired_;
     size_t currentFrame_ = 0;
     ANativeWindow* window_ = nullptr;
 
     bool initialized_ = false;
+    bool headless_ = false;
+    VkExtent2D headlessExtent_{};
 
     // NOTE: The SPIR-V arrays are generated at build time and included via generated/shaders_generated.h
     static const std::vector<uint32_t> kVertSpv;
     static const std::vector<uint32_t> kFragSpv;
+    static const std::vector<uint32_t> kChainSubpassFragSpv;  // effect_chain.frag, SUBPASS_INPUT
+    static const std::vector<uint32_t> kBlurFragSpv;
+    static const std::vector<uint32_t> kChromaticFragSpv;
+    static const std::vector<uint32_t> kSharpenFragSpv;
+    static const std::vector<uint32_t> kAnalysisFragSpv;
+    static const std::vector<uint32_t> kBlurDownFragSpv;
+    static const std::vector<uint32_t> kBloomPrefilterFragSpv;  // blur_down.frag, BLOOM_PREFILTER
+    static const std::vector<uint32_t> kBlurUpFragSpv;
+    static const std::vector<uint32_t> kGlassFragSpv;
 };
@@ -0,0 +1,83 @@
+#include "shader_cache.h"
+
+#include <cstdio>
+#include <cstring>
+
+namespace lumina {
+
+namespace {
+constexpr uint32_t kCacheMagic = 0x43534d4c; // "LMSC"
+constexpr uint32_t kCacheVersion = 1;
+
+struct CacheHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t driverIdSize;
+    uint32_t reserved;
+    uint64_t payloadSize;
+    uint64_t payloadHash;
+};
+}
+
+uint64_t fnv1a64(const void* data, size_t size, uint64_t seed) {
+    const auto* bytes = static_cast<const uint8_t*>(data);
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; ++i) {
+        hash ^= bytes[i];
+        hash *= 0x100000001b3ull;
+    }
+    return hash;
+}
+
+bool readCacheFile(const std::string& path, const std::string& driverId, std::vector<uint8_t>& payload) {
+    payload.clear();
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+
+    CacheHeader header{};
+    std::string storedId;
+    bool ok = fread(&header, sizeof(header), 1, f) == 1 &&
+              header.magic == kCacheMagic &&
+              header.version == kCacheVersion &&
+              header.driverIdSize == driverId.size();
+    if (ok) {
+        storedId.resize(header.driverIdSize);
+        ok = (header.driverIdSize == 0 || fread(&storedId[0], 1, storedId.size(), f) == storedId.size()) &&
+             storedId == driverId;
+    }
+    if (ok) {
+        payload.resize(static_cast<size_t>(header.payloadSize));
+        ok = (payload.empty() || fread(payload.data(), 1, payload.size(), f) == payload.size()) &&
+             fnv1a64(payload.data(), payload.size()) == header.payloadHash;
+    }
+    fclose(f);
+
+    if (!ok) payload.clear();
+    return ok;
+}
+
+bool writeCacheFile(const std::string& path, const std::string& driverId, const void* data, size_t size) {
+    const std::string tmpPath = path + ".tmp";
+    FILE* f = fopen(tmpPath.c_str(), "wb");
+    if (!f) return false;
+
+    CacheHeader header{};
+    header.magic = kCacheMagic;
+    header.version = kCacheVersion;
+    header.driverIdSize = static_cast<uint32_t>(driverId.size());
+    header.payloadSize = size;
+    header.payloadHash = fnv1a64(data, size);
+
+    bool ok = fwrite(&header, sizeof(header), 1, f) == 1 &&
+              fwrite(driverId.data(), 1, driverId.size(), f) == driverId.size() &&
+              (size == 0 || fwrite(data, 1, size, f) == size);
+    ok = (fclose(f) == 0) && ok;
+
+    if (!ok || rename(tmpPath.c_str(), path.c_str()) != 0) {
+        remove(tmpPath.c_str());
+        return false;
+    }
+    return true;
+}
+
+} // namespace lumina
@@ -0,0 +1,33 @@
+#ifndef LUMINA_SHADER_CACHE_H
+#define LUMINA_SHADER_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * Lumina Virtual Studio - Shader Cache Files
+ *
+ * Persists driver-produced shader blobs (VkPipelineCache data, GL program binaries)
+ * between launches. Each file carries an identity string for the driver that wrote
+ * it; a different device, driver version or payload checksum reads as a miss, so a
+ * stale cache is simply rebuilt rather than handed to the driver.
+ */
+
+namespace lumina {
+
+constexpr uint64_t kFnvOffsetBasis = 0xcbf29ce484222325ull;
+
+/** 64-bit FNV-1a; stable across builds, unlike std::hash. */
+uint64_t fnv1a64(const void* data, size_t size, uint64_t seed = kFnvOffsetBasis);
+
+/** Reads the payload of `path` if it was written for `driverId`. */
+bool readCacheFile(const std::string& path, const std::string& driverId, std::vector<uint8_t>& payload);
+
+/** Writes `data` for `driverId` via a temporary file and rename, so readers never see a torn file. */
+bool writeCacheFile(const std::string& path, const std::string& driverId, const void* data, size_t size);
+
+} // namespace lumina
+
+#endif // LUMINA_SHADER_CACHE_H
@@ -0,0 +1,132 @@
+#include "shared_state.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <new>
+
+namespace lumina {
+
+namespace {
+
+// Past this many overtaken copies the reader gives up rather than spin on the writer.
+constexpr int kMaxReadAttempts = 4;
+
+bool fits(const void* base, size_t size) {
+    return base && size >= kSharedStateSize &&
+        reinterpret_cast<uintptr_t>(base) % alignof(SharedStateSlot) == 0;
+}
+
+void sanitize(AIIntent& intent) {
+    intent.action[AIIntent::MAX_ACTION_LENGTH - 1] = '\0';
+    intent.target[AIIntent::MAX_TARGET_LENGTH - 1] = '\0';
+    intent.parameters[AIIntent::MAX_PARAMS_LENGTH - 1] = '\0';
+    intent.confidence = std::isfinite(intent.confidence) ? std::clamp(intent.confidence, 0.0f, 1.0f) : 0.0f;
+    intent._padding[0] = intent._padding[1] = 0;
+}
+
+} // namespace
+
+bool SharedStateBlock::create(void* base, size_t size) {
+    if (!fits(base, size)) return false;
+    std::memset(base, 0, kSharedStateSize);
+
+    auto* header = new (base) SharedStateHeader();
+    header->magic = kSharedStateMagic;
+    header->version = kSharedStateVersion;
+    header->totalSize = static_cast<uint32_t>(kSharedStateSize);
+    header->intentOffset = static_cast<uint32_t>(kSharedIntentOffset);
+    header->slotsOffset = static_cast<uint32_t>(kSharedSlotsOffset);
+    header->slotStride = static_cast<uint32_t>(sizeof(SharedStateSlot));
+    header->slotCount = kSharedStateSlots;
+    header->stateOffset = static_cast<uint32_t>(offsetof(SharedStateSlot, state));
+    header->publishSeq.store(0, std::memory_order_relaxed);
+    header->intentSeq.store(0, std::memory_order_relaxed);
+
+    auto* bytes = static_cast<uint8_t*>(base);
+    new (bytes + kSharedIntentOffset) SharedIntentBlock();
+    for (uint32_t i = 0; i < kSharedStateSlots; ++i) {
+        new (bytes + kSharedSlotsOffset + i * sizeof(SharedStateSlot)) SharedStateSlot();
+    }
+    base_ = base;
+    return true;
+}
+
+bool SharedStateBlock::open(void* base, size_t size) {
+    if (!fits(base, size)) return false;
+    const auto* header = static_cast<const SharedStateHeader*>(base);
+    if (header->magic != kSharedStateMagic || header->version != kSharedStateVersion ||
+        header->totalSize != kSharedStateSize || header->slotCount != kSharedStateSlots ||
+        header->slotStride != sizeof(SharedStateSlot)) {
+        return false;
+    }
+    base_ = base;
+    return true;
+}
+
+SharedIntentBlock* SharedStateBlock::intents() const {
+    return reinterpret_cast<SharedIntentBlock*>(static_cast<uint8_t*>(base_) + kSharedIntentOffset);
+}
+
+SharedStateSlot* SharedStateBlock::slot(uint32_t index) const {
+    auto* bytes = static_cast<uint8_t*>(base_) + kSharedSlotsOffset;
+    return reinterpret_cast<SharedStateSlot*>(bytes + (index % kSharedStateSlots) * sizeof(SharedStateSlot));
+}
+
+void SharedStateBlock::publish(const LuminaState& state) {
+    if (!base_) return;
+    SharedStateHeader* h = header();
+    const uint32_t next = h->publishSeq.load(std::memory_order_relaxed);
+    SharedStateSlot* s = slot(next);
+
+    const uint32_t seq = s->seq.load(std::memory_order_relaxed);
+    s->seq.store(seq + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    std::memcpy(&s->state, &state, sizeof(LuminaState));
+    s->seq.store(seq + 2, std::memory_order_release);
+    h->publishSeq.store(next + 1, std::memory_order_release);
+}
+
+bool SharedStateBlock::readLatest(LuminaState& out) const {
+    if (!base_) return false;
+    for (int attempt = 0; attempt < kMaxReadAttempts; ++attempt) {
+        const uint32_t published = header()->publishSeq.load(std::memory_order_acquire);
+        if (published == 0) return false;
+        const SharedStateSlot* s = slot(published - 1);
+
+        const uint32_t before = s->seq.load(std::memory_order_acquire);
+        if (before & 1u) continue;
+        std::memcpy(&out, &s->state, sizeof(LuminaState));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (s->seq.load(std::memory_order_relaxed) == before) return true;
+    }
+    return false;
+}
+
+AIIntent* SharedStateBlock::currentIntent() {
+    return base_ ? &intents()->current : nullptr;
+}
+
+AIIntent* SharedStateBlock::pendingIntent() {
+    return base_ ? &intents()->pending : nullptr;
+}
+
+void SharedStateBlock::applyIntents(LuminaState& state) {
+    if (!base_) return;
+    const SharedIntentBlock* block = intents();
+    state.currentIntent = block->current;
+    state.pendingIntent = block->pending;
+    sanitize(state.currentIntent);
+    sanitize(state.pendingIntent);
+    header()->intentSeq.fetch_add(1, std::memory_order_release);
+}
+
+uint32_t SharedStateBlock::publishSeq() const {
+    return base_ ? header()->publishSeq.load(std::memory_order_acquire) : 0;
+}
+
+uint32_t SharedStateBlock::intentSeq() const {
+    return base_ ? header()->intentSeq.load(std::memory_order_acquire) : 0;
+}
+
+} // namespace lumina
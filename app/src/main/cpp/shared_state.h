@@ -0,0 +1,143 @@
+#ifndef LUMINA_SHARED_STATE_H
+#define LUMINA_SHARED_STATE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+
+#include "engine_structs.h"
+
+/**
+ * Lumina Virtual Studio - Shared state block
+ *
+ * One shared memory region (SharedMemory in Kotlin, ASharedMemory natively, mmap in
+ * Python) that all three layers read in place instead of re-serializing LuminaState:
+ *
+ *   [0]     SharedStateHeader   magic, version, offsets, sequence counters
+ *   [64]    SharedIntentBlock   current / pending AIIntent records
+ *   [1536]  SharedStateSlot[3]  ring of published LuminaState snapshots
+ *
+ * The engine is the only writer of the ring: every published state goes into the
+ * next slot under that slot's seqlock, then publishSeq names it as the newest.
+ * Readers copy the newest slot and retry if its sequence moved meanwhile; with three
+ * slots the engine would have to publish twice during one copy to force a retry.
+ *
+ * The intent records are written in place by the orchestrator (Python) or Kotlin,
+ * whichever produced the intent, and nothing reads them until the writer asks the
+ * engine to commit them from the writing thread or one ordered after it. The commit
+ * copies them into LuminaState, so the newest snapshot then carries them too.
+ *
+ * All fields are native byte order. Mirrors com.lumina.engine.SharedStateLayout and
+ * python/shared_state.py - keep the three in sync and bump the version on any
+ * layout change, including one in LuminaState.
+ */
+
+namespace lumina {
+
+constexpr uint32_t kSharedStateMagic = 0x4D48534C;  // "LSHM"
+constexpr uint32_t kSharedStateVersion = 1;
+constexpr uint32_t kSharedStateSlots = 3;
+
+struct LUMINA_ALIGN(64) SharedStateHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t totalSize;
+    uint32_t intentOffset;
+    uint32_t slotsOffset;
+    uint32_t slotStride;
+    uint32_t slotCount;
+    uint32_t stateOffset;                // of LuminaState within a slot
+    std::atomic<uint32_t> publishSeq;    // states published; the newest is slot (publishSeq - 1) % slotCount
+    std::atomic<uint32_t> intentSeq;     // intent commits applied
+    uint32_t _reserved[6];
+};
+
+struct LUMINA_ALIGN(16) SharedIntentBlock {
+    AIIntent current;
+    AIIntent pending;
+};
+
+struct LUMINA_ALIGN(256) SharedStateSlot {
+    std::atomic<uint32_t> seq;           // odd while the engine writes the slot
+    uint32_t _padding[63];
+    LuminaState state;
+};
+
+constexpr size_t kSharedIntentOffset = sizeof(SharedStateHeader);
+constexpr size_t kSharedSlotsOffset = 1536;  // intents rounded up to LuminaState alignment
+constexpr size_t kSharedStateSize = kSharedSlotsOffset + kSharedStateSlots * sizeof(SharedStateSlot);
+
+static_assert(std::atomic<uint32_t>::is_always_lock_free, "shared counters must be lock free");
+static_assert(sizeof(std::atomic<uint32_t>) == 4, "shared counters must be plain words");
+static_assert(std::is_trivially_copyable_v<LuminaState>, "LuminaState is copied byte for byte");
+static_assert(sizeof(SharedStateHeader) == 64, "SharedStateHeader must be 64 bytes");
+static_assert(offsetof(SharedStateHeader, publishSeq) == 32, "SharedStateHeader layout changed");
+static_assert(sizeof(AIIntent) == 720, "AIIntent layout changed");
+static_assert(offsetof(AIIntent, confidence) == 704, "AIIntent layout changed");
+static_assert(kSharedIntentOffset + sizeof(SharedIntentBlock) <= kSharedSlotsOffset, "intents overlap the ring");
+static_assert(kSharedSlotsOffset % alignof(SharedStateSlot) == 0, "slots must keep LuminaState aligned");
+static_assert(offsetof(SharedStateSlot, state) == 256, "SharedStateSlot layout changed");
+static_assert(sizeof(SharedStateSlot) == 2560, "SharedStateSlot layout changed");
+// The LuminaState fields the Kotlin and Python readers decode.
+static_assert(offsetof(LuminaState, stateId) == 4, "LuminaState layout changed");
+static_assert(offsetof(LuminaState, processingState) == 8, "LuminaState layout changed");
+static_assert(offsetof(LuminaState, renderMode) == 16, "LuminaState layout changed");
+static_assert(offsetof(LuminaState, width) == 20, "LuminaState layout changed");
+static_assert(offsetof(LuminaState, height) == 24, "LuminaState layout changed");
+static_assert(offsetof(LuminaState, activeEffectCount) == 464, "LuminaState layout changed");
+static_assert(offsetof(LuminaState, currentIntent) == 544, "LuminaState layout changed");
+static_assert(offsetof(LuminaState, pendingIntent) == 1264, "LuminaState layout changed");
+static_assert(sizeof(LuminaState) == 2304, "LuminaState layout changed");
+
+/**
+ * View of a shared state block mapped at some address. It owns neither the memory nor
+ * the mapping; the owner keeps both alive until reset() or destruction.
+ */
+class SharedStateBlock {
+public:
+    /**
+     * Lays out a new, empty block over `base` (at least kSharedStateSize bytes, 256-byte
+     * aligned - any mmap result is). Returns false without touching the memory otherwise.
+     */
+    bool create(void* base, size_t size);
+
+    /** Adopts a block another layer created; false when its header does not match this build. */
+    bool open(void* base, size_t size);
+
+    void reset() { base_ = nullptr; }
+    bool valid() const { return base_ != nullptr; }
+
+    /** Writes `state` into the next slot and makes it the newest. Single writer. */
+    void publish(const LuminaState& state);
+
+    /**
+     * Copies the newest snapshot into `out`. Returns false before the first publish, or
+     * when the writer kept overtaking the copy; `out` may be partly written then.
+     */
+    bool readLatest(LuminaState& out) const;
+
+    /** Records for writers that fill intents in place before calling applyIntents(). */
+    AIIntent* currentIntent();
+    AIIntent* pendingIntent();
+
+    /**
+     * Copies both intent records into `state`, terminating their strings and clamping
+     * confidence to [0, 1] since the writers are not trusted to, and counts the commit.
+     */
+    void applyIntents(LuminaState& state);
+
+    uint32_t publishSeq() const;
+    uint32_t intentSeq() const;
+
+private:
+    SharedStateHeader* header() const { return static_cast<SharedStateHeader*>(base_); }
+    SharedIntentBlock* intents() const;
+    SharedStateSlot* slot(uint32_t index) const;
+
+    void* base_ = nullptr;
+};
+
+} // namespace lumina
+
+#endif // LUMINA_SHARED_STATE_H
@@ -0,0 +1,125 @@
+#include "state_json.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace lumina {
+
+namespace {
+
+using json::JsonRef;
+
+// Scratch for one applyStateJson() call; some fields only apply once all are read.
+struct StateJsonUpdate {
+    LuminaState& state;
+    uint32_t requestedEffectCount;
+    uint32_t parsedEffects;
+    int width;
+    int height;
+};
+
+uint32_t clampUInt(double value, int minV, int maxV) {
+    return static_cast<uint32_t>(std::max(minV, std::min(static_cast<int>(value), maxV)));
+}
+
+void applyEffects(StateJsonUpdate& u, JsonRef effects) {
+    effects.forEachElement([&](uint32_t i, JsonRef obj) {
+        if (i >= u.state.effects.size() || !obj.isObject()) return;
+        EffectParams params;
+        params.type = static_cast<EffectType>(
+            clampUInt(obj.number("type", static_cast<int>(params.type)), 0, 7));
+        params.intensity = static_cast<float>(obj.number("intensity", params.intensity));
+        params.param1 = static_cast<float>(obj.number("param1", params.param1));
+        params.param2 = static_cast<float>(obj.number("param2", params.param2));
+        params.tintColor = json::readColor(obj["tintColor"], params.tintColor);
+        params.center = json::readVec2(obj["center"], params.center);
+        params.scale = json::readVec2(obj["scale"], params.scale);
+        u.state.effects[i] = params;
+        u.parsedEffects++;
+    });
+}
+
+void applyUiStyle(StateJsonUpdate& u, JsonRef o) {
+    if (!o.isObject()) return;
+    auto& style = u.state.uiStyle;
+    style.backgroundColor = json::readColor(o["backgroundColor"], style.backgroundColor);
+    style.borderColor = json::readColor(o["borderColor"], style.borderColor);
+    style.blurRadius = static_cast<float>(o.number("blurRadius", style.blurRadius));
+    style.transparency = static_cast<float>(o.number("transparency", style.transparency));
+    style.borderWidth = static_cast<float>(o.number("borderWidth", style.borderWidth));
+    style.cornerRadius = static_cast<float>(o.number("cornerRadius", style.cornerRadius));
+    style.saturation = static_cast<float>(o.number("saturation", style.saturation));
+    style.brightness = static_cast<float>(o.number("brightness", style.brightness));
+}
+
+void applyCamera(StateJsonUpdate& u, JsonRef o) {
+    if (!o.isObject()) return;
+    auto& camera = u.state.camera;
+    camera.position = json::readVec3(o["position"], camera.position);
+    camera.lookAt = json::readVec3(o["lookAt"], camera.lookAt);
+    camera.fov = static_cast<float>(o.number("fov", camera.fov));
+    camera.nearPlane = static_cast<float>(o.number("nearPlane", camera.nearPlane));
+    camera.farPlane = static_cast<float>(o.number("farPlane", camera.farPlane));
+}
+
+struct StateField {
+    std::string_view key;
+    void (*apply)(StateJsonUpdate&, JsonRef);
+};
+
+// Sorted by key; looked up with a binary search per root member.
+constexpr StateField kStateFields[] = {
+    {"activeEffectCount", [](StateJsonUpdate& u, JsonRef v) {
+        u.requestedEffectCount = clampUInt(v.asNumber(u.requestedEffectCount), 0, 4); }},
+    {"camera", applyCamera},
+    {"effects", applyEffects},
+    {"height", [](StateJsonUpdate& u, JsonRef v) { u.height = static_cast<int>(v.asNumber(u.height)); }},
+    {"processingState", [](StateJsonUpdate& u, JsonRef v) {
+        u.state.processingState = static_cast<ProcessingState>(
+            clampUInt(v.asNumber(static_cast<int>(u.state.processingState)), 0, 3)); }},
+    {"renderMode", [](StateJsonUpdate& u, JsonRef v) {
+        u.state.renderMode = static_cast<RenderMode>(
+            clampUInt(v.asNumber(static_cast<int>(u.state.renderMode)), 0, 4)); }},
+    {"touchDelta", [](StateJsonUpdate& u, JsonRef v) {
+        if (v.isObject()) u.state.touchDelta = json::readVec2(v, Vec2()); }},
+    {"touchPosition", [](StateJsonUpdate& u, JsonRef v) {
+        if (v.isObject()) u.state.touchPosition = json::readVec2(v, Vec2()); }},
+    {"touchPressure", [](StateJsonUpdate& u, JsonRef v) {
+        u.state.touchPressure = static_cast<float>(v.asNumber(u.state.touchPressure)); }},
+    {"touchState", [](StateJsonUpdate& u, JsonRef v) {
+        u.state.touchState = clampUInt(v.asNumber(u.state.touchState), 0, 3); }},
+    {"uiStyle", applyUiStyle},
+    {"width", [](StateJsonUpdate& u, JsonRef v) { u.width = static_cast<int>(v.asNumber(u.width)); }},
+};
+
+constexpr bool fieldsSorted() {
+    for (size_t i = 1; i < std::size(kStateFields); ++i) {
+        if (!(kStateFields[i - 1].key < kStateFields[i].key)) return false;
+    }
+    return true;
+}
+static_assert(fieldsSorted(), "kStateFields must stay sorted by key");
+
+} // namespace
+
+bool applyStateJson(json::JsonDocument& doc, std::string_view text, LuminaState& state) {
+    if (!doc.parse(text) || !doc.root().isObject()) return false;
+
+    // One pass over the root members, each dispatched through kStateFields.
+    StateJsonUpdate update{state, state.activeEffectCount, 0,
+                           static_cast<int>(state.width), static_cast<int>(state.height)};
+    doc.root().forEachMember([&](std::string_view key, JsonRef value) {
+        const auto* field = std::lower_bound(std::begin(kStateFields), std::end(kStateFields), key,
+                                             [](const StateField& f, std::string_view k) { return f.key < k; });
+        if (field != std::end(kStateFields) && field->key == key) field->apply(update, value);
+    });
+
+    if (update.width > 0 && update.height > 0) {
+        state.setDimensions(static_cast<uint32_t>(update.width), static_cast<uint32_t>(update.height));
+    }
+    state.activeEffectCount = std::min(update.requestedEffectCount, update.parsedEffects);
+    state.incrementStateId();
+    return true;
+}
+
+} // namespace lumina
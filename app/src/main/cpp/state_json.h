@@ -0,0 +1,28 @@
+#ifndef LUMINA_STATE_JSON_H
+#define LUMINA_STATE_JSON_H
+
+#include <string_view>
+
+#include "engine_structs.h"
+#include "json_parser.h"
+
+/**
+ * Lumina Virtual Studio - State JSON ingest
+ *
+ * The JSON counterpart of applyStatePacket(): root members are dispatched through a
+ * sorted field table in one pass over the arena document. Kept free of engine and
+ * platform state so host tests and lumina_bench exercise the same code as the app.
+ */
+
+namespace lumina {
+
+/**
+ * Parses `text` into `doc` (reusing its storage) and applies every recognised root
+ * member to `state`, clamping enums and counts like the packet path; unknown members
+ * are ignored. Returns false, leaving `state` unchanged, unless `text` is a JSON object.
+ */
+bool applyStateJson(json::JsonDocument& doc, std::string_view text, LuminaState& state);
+
+} // namespace lumina
+
+#endif // LUMINA_STATE_JSON_H
@@ -0,0 +1,61 @@
+#include "state_packet.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace lumina {
+
+void applyPacketEffect(const PacketEffect& src, EffectParams& dst) {
+    dst.type = static_cast<EffectType>(std::min(src.type, 7u));
+    dst.intensity = src.intensity;
+    dst.param1 = src.param1;
+    dst.param2 = src.param2;
+    dst.tintColor = ColorRGBA(src.tintColor[0], src.tintColor[1], src.tintColor[2], src.tintColor[3]);
+    dst.center = Vec2(src.center[0], src.center[1]);
+    dst.scale = Vec2(src.scale[0], src.scale[1]);
+}
+
+bool applyStatePacket(const void* data, size_t size, LuminaState& state) {
+    if (!data || size < sizeof(StatePacket)) return false;
+
+    // The source is a Java direct buffer with no alignment guarantee.
+    StatePacket packet;
+    std::memcpy(&packet, data, sizeof(packet));
+    if (packet.version != kStatePacketVersion) return false;
+
+    const uint32_t dirty = packet.dirtyMask;
+
+    if ((dirty & kDirtyDimensions) && packet.width > 0 && packet.height > 0) {
+        state.setDimensions(packet.width, packet.height);
+    }
+    if (dirty & kDirtyRenderMode) {
+        state.renderMode = static_cast<RenderMode>(std::min(packet.renderMode, 4u));
+    }
+    if (dirty & kDirtyProcessing) {
+        state.processingState = static_cast<ProcessingState>(std::min(packet.processingState, 3u));
+    }
+    if (dirty & kDirtyTouch) {
+        state.touchState = std::min(packet.touchState, 3u);
+        state.touchPressure = packet.touchPressure;
+        state.touchPosition = Vec2(packet.touchPosition[0], packet.touchPosition[1]);
+        state.touchDelta = Vec2(packet.touchDelta[0], packet.touchDelta[1]);
+    }
+    if (dirty & kDirtyEffects) {
+        const uint32_t count = std::min(packet.activeEffectCount, static_cast<uint32_t>(state.effects.size()));
+        for (uint32_t i = 0; i < state.effects.size(); ++i) {
+            const PacketEffect& src = packet.effects[i];
+            EffectParams& dst = state.effects[i];
+            if (i >= count) {
+                dst = EffectParams();
+                continue;
+            }
+            applyPacketEffect(src, dst);
+        }
+        state.activeEffectCount = count;
+    }
+
+    state.incrementStateId();
+    return true;
+}
+
+} // namespace lumina
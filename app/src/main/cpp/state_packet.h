@@ -0,0 +1,76 @@
+#ifndef LUMINA_STATE_PACKET_H
+#define LUMINA_STATE_PACKET_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "engine_structs.h"
+
+/**
+ * Lumina Virtual Studio - Binary State Packet
+ *
+ * Packed, versioned subset of LuminaState for high-rate updates (touch, sliders,
+ * effect stacks) written by Kotlin into a direct ByteBuffer in native byte order.
+ * Only the groups flagged in dirtyMask are applied; everything else in LuminaState
+ * is left untouched, so JSON can keep carrying intents and configuration.
+ *
+ * Mirrors com.lumina.engine.StatePacket - keep both in sync and bump the version
+ * on any layout change.
+ */
+
+namespace lumina {
+
+constexpr uint32_t kStatePacketVersion = 1;
+
+enum StatePacketDirty : uint32_t {
+    kDirtyDimensions  = 1u << 0,  // width, height
+    kDirtyRenderMode  = 1u << 1,
+    kDirtyProcessing  = 1u << 2,  // processingState
+    kDirtyTouch       = 1u << 3,  // touchState, touchPressure, touchPosition, touchDelta
+    kDirtyEffects     = 1u << 4,  // activeEffectCount, effects[]
+    kDirtyAll         = 0x1Fu
+};
+
+struct PacketEffect {
+    uint32_t type;
+    float intensity;
+    float param1;
+    float param2;
+    float tintColor[4];
+    float center[2];
+    float scale[2];
+};
+
+struct LUMINA_ALIGN(16) StatePacket {
+    uint32_t version;
+    uint32_t dirtyMask;
+    uint32_t renderMode;
+    uint32_t processingState;
+    uint32_t width;
+    uint32_t height;
+    uint32_t touchState;
+    float touchPressure;
+    float touchPosition[2];
+    float touchDelta[2];
+    uint32_t activeEffectCount;
+    uint32_t _padding[3];
+    PacketEffect effects[4];
+};
+
+static_assert(sizeof(PacketEffect) == 48, "PacketEffect must be 48 bytes");
+static_assert(offsetof(StatePacket, touchPosition) == 32, "StatePacket layout changed");
+static_assert(offsetof(StatePacket, effects) == 64, "StatePacket layout changed");
+static_assert(sizeof(StatePacket) == 256, "StatePacket must be 256 bytes");
+
+/**
+ * Applies a packet to `state`, clamping enums and counts like the JSON path.
+ * Returns false (leaving `state` unchanged) for short buffers or unknown versions.
+ */
+bool applyStatePacket(const void* data, size_t size, LuminaState& state);
+
+/** One packed effect into `dst`, clamping the type; shared with the command stream. */
+void applyPacketEffect(const PacketEffect& src, EffectParams& dst);
+
+} // namespace lumina
+
+#endif // LUMINA_STATE_PACKET_H
@@ -0,0 +1,116 @@
+#ifndef LUMINA_STATE_SNAPSHOT_H
+#define LUMINA_STATE_SNAPSHOT_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+/**
+ * Lumina Virtual Studio - Lock-free snapshot publication
+ *
+ * Single-producer / single-consumer triple buffer. The producer fills back(),
+ * then publish() swaps it with the shared middle slot; the consumer's acquire()
+ * swaps the middle slot with its front slot only when something new has been
+ * published. Neither side ever blocks or sees a half-written value, and the
+ * consumer may modify its front slot in place until the next acquire().
+ *
+ * Multiple producers must serialise among themselves (the engine uses a mutex
+ * that the render thread never takes).
+ *
+ * SeqLock covers the opposite shape: one writer, any number of readers, for small
+ * trivially copyable values such as FrameTiming. Readers retry instead of blocking.
+ */
+
+namespace lumina {
+
+template <typename T>
+class TripleBuffer {
+public:
+    TripleBuffer() = default;
+    explicit TripleBuffer(const T& initial) { reset(initial); }
+
+    TripleBuffer(const TripleBuffer&) = delete;
+    TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+    // Not thread-safe; call while neither side is running.
+    void reset(const T& value) {
+        slots_.fill(value);
+        back_ = 0;
+        middle_.store(1, std::memory_order_relaxed);
+        front_ = 2;
+    }
+
+    // Producer side.
+    T& back() { return slots_[back_]; }
+    void publish() {
+        back_ = middle_.exchange(static_cast<uint8_t>(back_ | kFresh), std::memory_order_acq_rel) & kIndexMask;
+    }
+    void publish(const T& value) {
+        slots_[back_] = value;
+        publish();
+    }
+
+    // Consumer side: returns the newest published value.
+    T& acquire() {
+        if (middle_.load(std::memory_order_relaxed) & kFresh) {
+            front_ = middle_.exchange(front_, std::memory_order_acq_rel) & kIndexMask;
+        }
+        return slots_[front_];
+    }
+    T& front() { return slots_[front_]; }
+    bool hasFresh() const { return (middle_.load(std::memory_order_acquire) & kFresh) != 0; }
+
+private:
+    static constexpr uint8_t kIndexMask = 0x3;
+    static constexpr uint8_t kFresh = 0x4;
+
+    std::array<T, 3> slots_{};
+    uint8_t back_ = 0;                 // producer-owned
+    std::atomic<uint8_t> middle_{1};   // index | kFresh
+    uint8_t front_ = 2;                // consumer-owned
+};
+
+template <typename T>
+class SeqLock {
+    static_assert(std::is_trivially_copyable_v<T>, "SeqLock payloads are copied word by word");
+
+public:
+    // Single writer.
+    void store(const T& value) {
+        uint32_t words[kWords] = {};
+        std::memcpy(words, &value, sizeof(T));
+        const uint32_t seq = seq_.load(std::memory_order_relaxed);
+        seq_.store(seq + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        for (size_t i = 0; i < kWords; ++i) words_[i].store(words[i], std::memory_order_relaxed);
+        seq_.store(seq + 2, std::memory_order_release);
+    }
+
+    T load() const {
+        uint32_t words[kWords];
+        uint32_t before = 0;
+        uint32_t after = 0;
+        do {
+            before = seq_.load(std::memory_order_acquire);
+            for (size_t i = 0; i < kWords; ++i) words[i] = words_[i].load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = seq_.load(std::memory_order_relaxed);
+        } while ((before & 1u) != 0 || before != after);
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        return value;
+    }
+
+private:
+    static constexpr size_t kWords = (sizeof(T) + sizeof(uint32_t) - 1) / sizeof(uint32_t);
+
+    std::atomic<uint32_t> seq_{0};
+    std::array<std::atomic<uint32_t>, kWords> words_{};
+};
+
+} // namespace lumina
+
+#endif // LUMINA_STATE_SNAPSHOT_H
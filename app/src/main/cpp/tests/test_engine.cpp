@@ -1,5 +1,1315 @@
 #include <gtest/gtest.h>
+#include <algorithm>
+
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "analysis_frame.h"
+#include "blur_pyramid.h"
+#include "command_stream.h"
+#include "effect_graph.h"
+#include "frame_pool.h"
+#include "frame_stats.h"
+#include "glass_panels.h"
+#include "gpu_layout.h"
+#include "gpu_memory.h"
+#include "input_release.h"
+#include "json_parser.h"
+#include "pixel_convert.h"
+#include "recording.h"
+#include "redraw_tracker.h"
+#include "render_scale.h"
+#include "state_json.h"
+#include "state_snapshot.h"
+#include "shader_cache.h"
+#include "shared_state.h"
+#include "state_packet.h"
+#include "video_source.h"
+
+using lumina::EffectType;
+
+namespace {
+
+// One YUV_420_888 frame in a caller-chosen layout (0 NV12, 1 NV21, 2 I420) with
+// padded rows, filled from per-pixel luma and per-chroma-sample U/V functions.
+struct YuvFrame {
+    std::vector<uint8_t> luma;
+    std::vector<uint8_t> chroma;
+    lumina::YuvPlanes planes;
+
+    template <typename LumaFn, typename ChromaFn>
+    YuvFrame(uint32_t width, uint32_t height, int layout, LumaFn lumaAt, ChromaFn chromaAt) {
+        const uint32_t cw = (width + 1) / 2, ch = (height + 1) / 2;
+        planes.width = width;
+        planes.height = height;
+        planes.yRowStride = width + 5;
+        planes.uvPixelStride = layout == 2 ? 1 : 2;
+        planes.uvRowStride = cw * planes.uvPixelStride + 3;
+        luma.assign(static_cast<size_t>(planes.yRowStride) * height, 0);
+        const size_t planeBytes = static_cast<size_t>(planes.uvRowStride) * ch;
+        chroma.assign(layout == 2 ? planeBytes * 2 : planeBytes + 1, 0);
+        for (uint32_t y = 0; y < height; ++y) {
+            for (uint32_t x = 0; x < width; ++x) luma[y * planes.yRowStride + x] = lumaAt(x, y);
+        }
+        uint8_t* u = chroma.data() + (layout == 1 ? 1 : 0);
+        uint8_t* v = layout == 2 ? chroma.data() + planeBytes : chroma.data() + (layout == 1 ? 0 : 1);
+        for (uint32_t y = 0; y < ch; ++y) {
+            for (uint32_t x = 0; x < cw; ++x) {
+                const size_t i = static_cast<size_t>(y) * planes.uvRowStride + static_cast<size_t>(x) * planes.uvPixelStride;
+                const auto [cu, cv] = chromaAt(x, y);
+                u[i] = cu;
+                v[i] = cv;
+            }
+        }
+        planes.y = luma.data();
+        planes.u = u;
+        planes.v = v;
+    }
+};
+
+std::vector<uint8_t> convertYuv(const lumina::YuvPlanes& planes, uint32_t downscale) {
+    const uint32_t width = lumina::downscaledExtent(planes.width, downscale);
+    const uint32_t height = lumina::downscaledExtent(planes.height, downscale);
+    std::vector<uint8_t> rgba(static_cast<size_t>(width) * height * 4, 0);
+    EXPECT_TRUE(lumina::convertYuvToRgba(planes, rgba.data(), static_cast<size_t>(width) * 4, downscale));
+    return rgba;
+}
+
+lumina::LuminaState stateWith(std::initializer_list<EffectType> types) {
+    lumina::LuminaState state;
+    for (EffectType type : types) {
+        state.effects[state.activeEffectCount++].type = type;
+    }
+    return state;
+}
+
+} // namespace
 
 TEST(EngineTest, BasicAssertion) {
     EXPECT_EQ(1 + 1, 2);
 }
+
+TEST(EffectGraphTest, NoEffectsYieldsSinglePlainPass) {
+    const auto graph = lumina::buildEffectGraph(lumina::LuminaState{});
+    ASSERT_EQ(graph.passCount, 1u);
+    EXPECT_EQ(graph.passes[0].head, EffectType::NONE);
+    EXPECT_EQ(graph.passes[0].opCount, 0u);
+}
+
+TEST(EffectGraphTest, PointwiseEffectsFuseIntoOnePass) {
+    const auto graph = lumina::buildEffectGraph(
+        stateWith({EffectType::COLOR_GRADE, EffectType::VIGNETTE, EffectType::NOISE}));
+    ASSERT_EQ(graph.passCount, 1u);
+    EXPECT_EQ(graph.passes[0].opCount, 3u);
+    EXPECT_EQ(graph.passes[0].ops[0], 0u);
+    EXPECT_EQ(graph.passes[0].ops[2], 2u);
+}
+
+TEST(EffectGraphTest, SamplingEffectStartsNewPass) {
+    const auto graph = lumina::buildEffectGraph(
+        stateWith({EffectType::VIGNETTE, EffectType::BLUR, EffectType::NOISE}));
+    ASSERT_EQ(graph.passCount, 2u);
+    EXPECT_EQ(graph.passes[0].opCount, 1u);
+    EXPECT_EQ(graph.passes[1].head, EffectType::BLUR);
+    EXPECT_EQ(graph.passes[1].headSlot, 1u);
+    ASSERT_EQ(graph.passes[1].opCount, 1u);
+    EXPECT_EQ(graph.passes[1].ops[0], 2u);
+}
+
+TEST(EffectGraphTest, UnfusedSamplingKeepsPointwiseSeparate) {
+    lumina::EffectGraphOptions options;
+    options.fuseIntoSampling = false;
+    const auto graph = lumina::buildEffectGraph(
+        stateWith({EffectType::SHARPEN, EffectType::NOISE, EffectType::VIGNETTE}), options);
+    ASSERT_EQ(graph.passCount, 2u);
+    EXPECT_EQ(graph.passes[0].head, EffectType::SHARPEN);
+    EXPECT_EQ(graph.passes[0].opCount, 0u);
+    EXPECT_EQ(graph.passes[1].head, EffectType::NONE);
+    EXPECT_EQ(graph.passes[1].opCount, 2u);
+}
+
+TEST(EffectGraphTest, PlainFetchFirstResolvesInputBeforeSampling) {
+    lumina::EffectGraphOptions options;
+    options.plainFetchFirst = true;
+    const auto graph = lumina::buildEffectGraph(
+        stateWith({EffectType::CHROMATIC_ABERRATION, EffectType::SHARPEN,
+                   EffectType::BLUR, EffectType::CHROMATIC_ABERRATION}), options);
+    ASSERT_EQ(graph.passCount, lumina::kMaxEffectPasses);
+    EXPECT_EQ(graph.passes[0].head, EffectType::NONE);
+    EXPECT_EQ(graph.passes[4].head, EffectType::CHROMATIC_ABERRATION);
+}
+
+TEST(EffectGraphTest, SkipsNoneAndClampsCount) {
+    auto state = stateWith({EffectType::NONE, EffectType::BLOOM});
+    state.activeEffectCount = 9;
+    const auto graph = lumina::buildEffectGraph(state);
+    ASSERT_EQ(graph.passCount, 1u);
+    ASSERT_EQ(graph.passes[0].opCount, 1u);
+    EXPECT_EQ(graph.passes[0].ops[0], 1u);
+}
+
+TEST(EffectVariantTest, KeyIgnoresParametersButNotShape) {
+    auto state = stateWith({EffectType::BLOOM, EffectType::NOISE});
+    const auto graph = lumina::buildEffectGraph(state);
+    const auto key = [&](const lumina::LuminaState& s, lumina::RenderMode mode, uint32_t format) {
+        return lumina::effectVariantKey(graph.passes[0], s.effects, mode, lumina::kVariantLastPass, format);
+    };
+    const uint64_t base = key(state, lumina::RenderMode::PASSTHROUGH, 37);
+
+    auto tweaked = state;
+    tweaked.effects[0].intensity = 0.25f;
+    tweaked.effects[1].param1 = 3.0f;
+    EXPECT_EQ(key(tweaked, lumina::RenderMode::PASSTHROUGH, 37), base);
+
+    auto reordered = stateWith({EffectType::NOISE, EffectType::BLOOM});
+    EXPECT_NE(key(reordered, lumina::RenderMode::PASSTHROUGH, 37), base);
+    EXPECT_NE(key(state, lumina::RenderMode::STYLIZED, 37), base);
+    EXPECT_NE(key(state, lumina::RenderMode::PASSTHROUGH, 44), base);
+    EXPECT_NE(lumina::effectVariantKey(graph.passes[0], state.effects, lumina::RenderMode::PASSTHROUGH, 0, 37), base);
+    EXPECT_NE(lumina::effectVariantKey(graph.passes[0], state.effects, lumina::RenderMode::PASSTHROUGH,
+                                       lumina::kVariantLastPass | lumina::kVariantSubpass, 37), base);
+    EXPECT_EQ(lumina::effectVariantKey(graph.passes[0], state.effects, lumina::RenderMode::PASSTHROUGH,
+                                       lumina::kVariantLastPass, 37, 0), base);
+    for (uint32_t turns = 1; turns < 4; ++turns) {
+        EXPECT_NE(lumina::effectVariantKey(graph.passes[0], state.effects, lumina::RenderMode::PASSTHROUGH,
+                                           lumina::kVariantLastPass, 37, turns), base);
+    }
+}
+
+TEST(EffectGraphTest, PointwiseTailOnlyAfterAnotherPass) {
+    lumina::EffectGraphOptions fixedShaders;
+    fixedShaders.fuseIntoSampling = false;
+
+    EXPECT_FALSE(lumina::hasPointwiseTail(lumina::buildEffectGraph(stateWith({EffectType::BLOOM}), fixedShaders)));
+    EXPECT_FALSE(lumina::hasPointwiseTail(lumina::buildEffectGraph(stateWith({EffectType::BLOOM, EffectType::BLUR}), fixedShaders)));
+    EXPECT_TRUE(lumina::hasPointwiseTail(lumina::buildEffectGraph(stateWith({EffectType::BLUR, EffectType::VIGNETTE}), fixedShaders)));
+    // Fused into the sampling pass, nothing is left to merge.
+    EXPECT_FALSE(lumina::hasPointwiseTail(lumina::buildEffectGraph(stateWith({EffectType::BLUR, EffectType::VIGNETTE}))));
+}
+
+TEST(EffectGraphTest, BlurAndBloomOwnOnePyramidPerPass) {
+    const auto graph = lumina::buildEffectGraph(
+        stateWith({EffectType::BLUR, EffectType::BLOOM, EffectType::BLOOM, EffectType::NOISE}));
+    ASSERT_EQ(graph.passCount, 3u);
+    EXPECT_EQ(graph.passes[0].pyramidSlot, 0u);
+    // The first bloom cannot share the blur's pyramid, the second not the first's.
+    EXPECT_EQ(graph.passes[1].head, EffectType::NONE);
+    EXPECT_EQ(graph.passes[1].pyramidSlot, 1u);
+    EXPECT_EQ(graph.passes[2].pyramidSlot, 2u);
+    ASSERT_EQ(graph.passes[2].opCount, 2u);
+    EXPECT_EQ(graph.passes[2].ops[1], 3u);
+
+    const auto plain = lumina::buildEffectGraph(stateWith({EffectType::VIGNETTE, EffectType::BLOOM}));
+    ASSERT_EQ(plain.passCount, 1u);
+    EXPECT_EQ(plain.passes[0].pyramidSlot, 1u);
+    lumina::EffectGraphOptions fixedShaders;
+    fixedShaders.fuseIntoSampling = false;
+    EXPECT_FALSE(lumina::hasPointwiseTail(
+        lumina::buildEffectGraph(stateWith({EffectType::SHARPEN, EffectType::BLOOM}), fixedShaders)));
+}
+
+TEST(EffectGraphTest, PlainFetchFirstKeepsPyramidsOffTheInput) {
+    lumina::EffectGraphOptions options;
+    options.plainFetchFirst = true;
+    const auto graph = lumina::buildEffectGraph(stateWith({EffectType::BLOOM, EffectType::VIGNETTE}), options);
+    ASSERT_EQ(graph.passCount, 2u);
+    EXPECT_EQ(graph.passes[0].pyramidSlot, lumina::kNoPyramid);
+    EXPECT_EQ(graph.passes[0].opCount, 0u);
+    EXPECT_EQ(graph.passes[1].pyramidSlot, 0u);
+    EXPECT_EQ(graph.passes[1].opCount, 2u);
+
+    // Pointwise ops already in the plain pass stay there.
+    const auto late = lumina::buildEffectGraph(stateWith({EffectType::VIGNETTE, EffectType::BLOOM}), options);
+    ASSERT_EQ(late.passCount, 2u);
+    EXPECT_EQ(late.passes[0].opCount, 1u);
+    EXPECT_EQ(late.passes[1].pyramidSlot, 1u);
+}
+
+TEST(EffectGraphTest, WarmupStatesCoverEveryEffectAlone) {
+    const auto states = lumina::warmupStates();
+    ASSERT_EQ(states.size(), static_cast<size_t>(EffectType::SHARPEN) + 1);
+    EXPECT_EQ(states[0].activeEffectCount, 0u);
+
+    std::vector<uint64_t> keys;
+    for (size_t i = 0; i < states.size(); ++i) {
+        EXPECT_EQ(states[i].renderMode, lumina::RenderMode::PASSTHROUGH);
+        if (i > 0) {
+            ASSERT_EQ(states[i].activeEffectCount, 1u);
+            EXPECT_EQ(states[i].effects[0].type, static_cast<EffectType>(i));
+        }
+        const auto graph = lumina::buildEffectGraph(states[i]);
+        ASSERT_GE(graph.passCount, 1u);
+        const auto& last = graph.passes[graph.passCount - 1];
+        keys.push_back(lumina::effectVariantKey(last, states[i].effects, states[i].renderMode,
+                                                lumina::kVariantLastPass, 0));
+    }
+    // Every state warms a surface pass no other state does.
+    std::sort(keys.begin(), keys.end());
+    EXPECT_EQ(std::unique(keys.begin(), keys.end()), keys.end());
+}
+
+TEST(BlurPyramidTest, LevelsGrowWithRadiusAndOffsetCoversTheRest) {
+    EXPECT_EQ(lumina::planBlur(0.0f, 1920, 1080).levels, 0u);
+    uint32_t previous = 0;
+    for (float radius : {1.0f, 6.0f, 20.0f, 50.0f, 150.0f}) {
+        const auto plan = lumina::planBlur(radius, 1920, 1080);
+        ASSERT_GT(plan.levels, 0u);
+        EXPECT_GE(plan.levels, previous);
+        previous = plan.levels;
+        EXPECT_GE(plan.offset, 0.25f);
+        EXPECT_LE(plan.offset, 1.5f);
+        if (radius >= 4.0f) {
+            EXPECT_NEAR(plan.offset * std::ldexp(1.0f, static_cast<int>(plan.levels) + 1), radius, 1e-3f);
+        }
+    }
+
+    const auto plan = lumina::planBlur(20.0f, 1920, 1081);
+    ASSERT_EQ(plan.levels, 3u);
+    EXPECT_EQ(plan.widths[0], 960u);
+    EXPECT_EQ(plan.heights[0], 541u);
+    EXPECT_EQ(plan.heights[2], 136u);
+}
+
+TEST(BlurPyramidTest, SmallInputsCapLevelsAndRadiusFallsBackToStyle) {
+    const auto plan = lumina::planBlur(500.0f, 16, 16);
+    EXPECT_EQ(plan.levels, 3u);  // 8, 4, 2
+    EXPECT_EQ(plan.offset, 1.5f);
+    EXPECT_EQ(lumina::planBlur(10.0f, 2, 2).levels, 0u);
+
+    lumina::GlassmorphicParams style;
+    lumina::EffectParams blur;
+    blur.type = EffectType::BLUR;
+    EXPECT_EQ(lumina::effectBlurRadius(blur, style), style.blurRadius);
+    blur.param1 = 7.0f;
+    EXPECT_EQ(lumina::effectBlurRadius(blur, style), 7.0f);
+
+    lumina::EffectParams bloom;
+    bloom.type = EffectType::BLOOM;
+    EXPECT_EQ(lumina::effectBlurRadius(bloom, style), lumina::kDefaultBloomRadius);
+    EXPECT_EQ(lumina::bloomThreshold(bloom), lumina::kDefaultBloomThreshold);
+    bloom.type = EffectType::VIGNETTE;
+    EXPECT_EQ(lumina::effectBlurRadius(bloom, style), 0.0f);
+
+    lumina::EffectPass pass;
+    EXPECT_NE(lumina::pyramidVariantKey(lumina::PyramidStage::Down, 0, 37),
+              lumina::effectVariantKey(pass, lumina::LuminaState{}.effects, lumina::RenderMode::PASSTHROUGH, 0, 37));
+    EXPECT_NE(lumina::pyramidVariantKey(lumina::PyramidStage::Down, 0, 37),
+              lumina::pyramidVariantKey(lumina::PyramidStage::Up, 0, 37));
+}
+
+TEST(GlassPanelsTest, LayoutClampsEdgesAndDropsEmptyPanels) {
+    const float nan = std::nanf("");
+    const std::vector<float> values = {
+        -0.5f, 0.1f, 0.5f, 1.5f, 0.02f,   // clamped to the surface
+        0.4f, 0.4f, 0.4f, 0.6f, 0.0f,     // zero width
+        0.1f, nan, 0.2f, 0.3f, 0.0f,      // not finite
+        0.6f, 0.7f, 0.9f, 0.8f, -1.0f,    // negative radius
+        0.1f, 0.1f,                       // incomplete
+    };
+    const auto layout = lumina::makeGlassLayout(values.data(), values.size());
+    ASSERT_EQ(layout.count, 2u);
+    EXPECT_EQ(layout.panels[0].left, 0.0f);
+    EXPECT_EQ(layout.panels[0].bottom, 1.0f);
+    EXPECT_EQ(layout.panels[0].cornerRadius, 0.02f);
+    EXPECT_EQ(layout.panels[1].left, 0.6f);
+    EXPECT_EQ(layout.panels[1].cornerRadius, 0.0f);
+
+    std::vector<float> many;
+    for (uint32_t i = 0; i < lumina::kMaxGlassPanels + 4; ++i) {
+        many.insert(many.end(), {0.0f, 0.0f, 0.5f, 0.5f, 0.0f});
+    }
+    EXPECT_EQ(lumina::makeGlassLayout(many.data(), many.size()).count, lumina::kMaxGlassPanels);
+    EXPECT_EQ(lumina::makeGlassLayout(nullptr, 10).count, 0u);
+}
+
+TEST(GlassPanelsTest, ScissorFollowsPreRotationAndCoversWholePixels) {
+    lumina::GlassPanel panel;
+    panel.left = 0.1f;
+    panel.top = 0.2f;
+    panel.right = 0.5f;
+    panel.bottom = 0.3f;
+
+    // Display 1000x2000, framebuffer 1000x2000 unrotated.
+    auto rect = lumina::glassScissor(panel, 0, 1000, 2000);
+    EXPECT_EQ(rect.x, 100);
+    EXPECT_EQ(rect.y, 400);
+    EXPECT_EQ(rect.width, 400u);
+    EXPECT_EQ(rect.height, 200u);
+
+    // Same display on a 2000x1000 native framebuffer turned clockwise once.
+    rect = lumina::glassScissor(panel, 1, 2000, 1000);
+    EXPECT_EQ(rect.x, 1400);
+    EXPECT_EQ(rect.y, 100);
+    EXPECT_EQ(rect.width, 200u);
+    EXPECT_EQ(rect.height, 400u);
+
+    rect = lumina::glassScissor(panel, 2, 1000, 2000);
+    EXPECT_EQ(rect.x, 500);
+    EXPECT_EQ(rect.y, 1400);
+
+    rect = lumina::glassScissor(panel, 3, 2000, 1000);
+    EXPECT_EQ(rect.x, 400);
+    EXPECT_EQ(rect.y, 500);
+    EXPECT_EQ(rect.width, 200u);
+    EXPECT_EQ(rect.height, 400u);
+
+    panel.left = 0.1005f;
+    panel.right = 0.1015f;
+    rect = lumina::glassScissor(panel, 0, 1000, 2000);
+    EXPECT_EQ(rect.x, 100);
+    EXPECT_EQ(rect.width, 2u);
+}
+
+TEST(GlassPanelsTest, CornerRadiusFitsThePanelAndKeyIsItsOwn) {
+    lumina::GlassPanel panel;
+    panel.right = 0.5f;
+    panel.bottom = 0.01f;
+    panel.cornerRadius = 0.02f;
+    EXPECT_FLOAT_EQ(lumina::glassCornerRadius(panel, 1000, 2000), 10.0f);
+    panel.bottom = 0.5f;
+    EXPECT_FLOAT_EQ(lumina::glassCornerRadius(panel, 1000, 2000), 20.0f);
+
+    const uint64_t glass = lumina::glassVariantKey(1, 37);
+    EXPECT_NE(glass, lumina::glassVariantKey(0, 37));
+    for (auto stage : {lumina::PyramidStage::Down, lumina::PyramidStage::Prefilter, lumina::PyramidStage::Up}) {
+        for (uint32_t flags = 0; flags < 8; ++flags) {
+            EXPECT_NE(glass, lumina::pyramidVariantKey(stage, flags, 37));
+        }
+    }
+    lumina::EffectPass pass;
+    EXPECT_NE(glass, lumina::effectVariantKey(pass, lumina::LuminaState{}.effects,
+                                              lumina::RenderMode::PASSTHROUGH, 0, 37));
+}
+
+TEST(ShaderCacheTest, RoundTripsPayloadForSameDriver) {
+    const std::string path = ::testing::TempDir() + "lumina_cache_roundtrip.bin";
+    const std::vector<uint8_t> blob = {1, 2, 3, 4, 5, 250};
+    ASSERT_TRUE(lumina::writeCacheFile(path, "vk:driver-a", blob.data(), blob.size()));
+
+    std::vector<uint8_t> loaded;
+    EXPECT_TRUE(lumina::readCacheFile(path, "vk:driver-a", loaded));
+    EXPECT_EQ(loaded, blob);
+
+    EXPECT_FALSE(lumina::readCacheFile(path, "vk:driver-b", loaded));
+    EXPECT_TRUE(loaded.empty());
+    std::remove(path.c_str());
+}
+
+TEST(ShaderCacheTest, RejectsCorruptedPayload) {
+    const std::string path = ::testing::TempDir() + "lumina_cache_corrupt.bin";
+    const std::vector<uint8_t> blob(64, 7);
+    ASSERT_TRUE(lumina::writeCacheFile(path, "gl:driver", blob.data(), blob.size()));
+
+    FILE* f = std::fopen(path.c_str(), "r+b");
+    ASSERT_NE(f, nullptr);
+    std::fseek(f, -1, SEEK_END);
+    std::fputc(8, f);
+    std::fclose(f);
+
+    std::vector<uint8_t> loaded;
+    EXPECT_FALSE(lumina::readCacheFile(path, "gl:driver", loaded));
+    EXPECT_FALSE(lumina::readCacheFile(::testing::TempDir() + "lumina_cache_missing.bin", "gl:driver", loaded));
+    std::remove(path.c_str());
+}
+
+TEST(StatePacketTest, AppliesOnlyDirtyGroups) {
+    lumina::LuminaState state;
+    state.renderMode = lumina::RenderMode::STYLIZED;
+    const uint32_t startId = state.stateId;
+
+    lumina::StatePacket packet{};
+    packet.version = lumina::kStatePacketVersion;
+    packet.dirtyMask = lumina::kDirtyTouch | lumina::kDirtyEffects;
+    packet.renderMode = 0; // not dirty, must be ignored
+    packet.touchState = 2;
+    packet.touchPosition[0] = 0.25f;
+    packet.touchPosition[1] = 0.75f;
+    packet.activeEffectCount = 9; // clamped to capacity
+    packet.effects[0].type = static_cast<uint32_t>(EffectType::VIGNETTE);
+    packet.effects[0].intensity = 0.5f;
+    packet.effects[1].type = 42; // clamped to the last known type
+
+    ASSERT_TRUE(lumina::applyStatePacket(&packet, sizeof(packet), state));
+    EXPECT_EQ(state.renderMode, lumina::RenderMode::STYLIZED);
+    EXPECT_EQ(state.touchState, 2u);
+    EXPECT_FLOAT_EQ(state.touchPosition.y, 0.75f);
+    EXPECT_EQ(state.activeEffectCount, 4u);
+    EXPECT_EQ(state.effects[0].type, EffectType::VIGNETTE);
+    EXPECT_FLOAT_EQ(state.effects[0].intensity, 0.5f);
+    EXPECT_EQ(state.effects[1].type, EffectType::SHARPEN);
+    EXPECT_EQ(state.stateId, startId + 1);
+}
+
+TEST(StatePacketTest, RejectsShortOrForeignPackets) {
+    lumina::LuminaState state;
+    lumina::StatePacket packet{};
+    packet.version = lumina::kStatePacketVersion;
+    packet.dirtyMask = lumina::kDirtyAll;
+    EXPECT_FALSE(lumina::applyStatePacket(&packet, sizeof(packet) - 1, state));
+    packet.version = lumina::kStatePacketVersion + 1;
+    EXPECT_FALSE(lumina::applyStatePacket(&packet, sizeof(packet), state));
+    EXPECT_EQ(state.stateId, 0u);
+}
+
+TEST(StateJsonTest, AppliesKnownFieldsAndClampsCounts) {
+    lumina::json::JsonDocument doc;
+    lumina::LuminaState state;
+    const uint32_t startId = state.stateId;
+    ASSERT_TRUE(lumina::applyStateJson(doc, R"({
+        "width": 1280, "height": 720, "renderMode": 9, "unknown": [1, 2],
+        "activeEffectCount": 3,
+        "effects": [{"type": 4, "intensity": 0.5, "center": {"x": 0.25, "y": 0.75}}]
+    })", state));
+    EXPECT_EQ(state.width, 1280u);
+    EXPECT_EQ(state.height, 720u);
+    EXPECT_EQ(state.renderMode, static_cast<lumina::RenderMode>(4));
+    EXPECT_EQ(state.activeEffectCount, 1u); // only one effect was supplied
+    EXPECT_EQ(state.effects[0].type, EffectType::VIGNETTE);
+    EXPECT_FLOAT_EQ(state.effects[0].center.y, 0.75f);
+    EXPECT_EQ(state.stateId, startId + 1);
+
+    EXPECT_FALSE(lumina::applyStateJson(doc, "[1, 2]", state));
+    EXPECT_FALSE(lumina::applyStateJson(doc, "{\"width\": ", state));
+    EXPECT_EQ(state.width, 1280u);
+    EXPECT_EQ(state.stateId, startId + 1);
+}
+
+TEST(JsonDocumentTest, FlatNodesAnswerNestedLookups) {
+    const std::string text =
+        R"({"width": 640, "effects": [{"type": 4, "center": {"x": 0.25}}, 7, null],)"
+        R"( "name": "tab\tand \u00e9", "on": true})";
+    lumina::json::JsonDocument doc;
+    ASSERT_TRUE(doc.parse(text));
+    const auto root = doc.root();
+    ASSERT_TRUE(root.isObject());
+    EXPECT_EQ(root.size(), 4u);
+    EXPECT_DOUBLE_EQ(root.number("width", 0), 640.0);
+    EXPECT_TRUE(root["on"].asBool(false));
+    EXPECT_EQ(root["name"].asString(), "tab\tand \xc3\xa9");
+    EXPECT_FALSE(root["missing"]);
+
+    const auto effects = root["effects"];
+    ASSERT_TRUE(effects.isArray());
+    EXPECT_EQ(effects.size(), 3u);
+    uint32_t seen = 0;
+    effects.forEachElement([&](uint32_t i, lumina::json::JsonRef value) {
+        if (i == 0) {
+            EXPECT_FLOAT_EQ(lumina::json::readVec2(value["center"], lumina::Vec2(0, 9)).y, 9.0f);
+        } else if (i == 1) {
+            EXPECT_DOUBLE_EQ(value.asNumber(0), 7.0);
+        }
+        ++seen;
+    });
+    EXPECT_EQ(seen, 3u);
+}
+
+TEST(JsonDocumentTest, RejectsMalformedInputAndReusesStorage) {
+    lumina::json::JsonDocument doc;
+    EXPECT_FALSE(doc.parse(R"({"a": [1, 2})"));
+    EXPECT_FALSE(doc.parse(R"({"a" 1})"));
+    EXPECT_FALSE(doc.parse("-"));
+    EXPECT_FALSE(doc.root());
+    ASSERT_TRUE(doc.parse(R"({"a": -1.5e2})"));
+    EXPECT_DOUBLE_EQ(doc.root().number("a", 0), -150.0);
+}
+
+TEST(JsonSaxTest, StreamsEventsInDocumentOrder) {
+    struct Recorder : lumina::json::JsonHandler {
+        std::string events;
+        bool onKey(std::string_view k) override { events += "k:" + std::string(k) + " "; return true; }
+        bool onNumber(double) override { events += "n "; return true; }
+        bool onStartArray() override { events += "[ "; return true; }
+        bool onEndArray() override { events += "] "; return true; }
+        bool onStartObject() override { events += "{ "; return true; }
+        bool onEndObject() override { events += "} "; return true; }
+    } recorder;
+    lumina::json::SaxParser parser;
+    ASSERT_TRUE(parser.parse(R"({"a": [1, 2], "b": {}})", recorder));
+    EXPECT_EQ(recorder.events, "{ k:a [ n n ] k:b { } } ");
+}
+
+TEST(StateSnapshotTest, TripleBufferHandsOverOnlyCompleteSnapshots) {
+    struct Payload { uint32_t a = 0; uint32_t b = 0; };
+    lumina::TripleBuffer<Payload> buffer(Payload{});
+    EXPECT_FALSE(buffer.hasFresh());
+
+    constexpr uint32_t kCount = 200000;
+    std::thread producer([&] {
+        for (uint32_t i = 1; i <= kCount; ++i) {
+            Payload& back = buffer.back();
+            back.a = i;
+            back.b = i * 3;
+            buffer.publish();
+        }
+    });
+    uint32_t last = 0;
+    while (last < kCount) {
+        const Payload& front = buffer.acquire();
+        ASSERT_EQ(front.b, front.a * 3);
+        ASSERT_GE(front.a, last);
+        last = front.a;
+    }
+    producer.join();
+}
+
+TEST(StateSnapshotTest, SeqLockReadersNeverSeeTornTiming) {
+    lumina::SeqLock<lumina::FrameTiming> timing;
+    std::atomic<bool> done{false};
+    std::thread writer([&] {
+        lumina::FrameTiming t;
+        for (uint64_t i = 1; i <= 100000; ++i) {
+            t.frameCount = i;
+            t.totalTime = static_cast<float>(i);
+            timing.store(t);
+        }
+        done = true;
+    });
+    while (!done) {
+        const lumina::FrameTiming t = timing.load();
+        ASSERT_FLOAT_EQ(t.totalTime, static_cast<float>(t.frameCount));
+    }
+    writer.join();
+    EXPECT_EQ(timing.load().frameCount, 100000u);
+}
+
+TEST(FrameStatsTest, RollingHistogramReportsNearestRankPercentiles) {
+    lumina::RollingHistogram histogram;
+    EXPECT_EQ(histogram.percentiles().samples, 0u);
+    for (int i = 100; i >= 1; --i) histogram.add(static_cast<float>(i));
+    lumina::Percentiles p = histogram.percentiles();
+    EXPECT_EQ(p.samples, 100u);
+    EXPECT_FLOAT_EQ(p.p50, 51.0f);
+    EXPECT_FLOAT_EQ(p.p95, 96.0f);
+    EXPECT_FLOAT_EQ(p.p99, 100.0f);
+    EXPECT_FLOAT_EQ(histogram.last(), 1.0f);
+
+    // Only the newest kStatsWindow samples count.
+    for (size_t i = 0; i < lumina::kStatsWindow; ++i) histogram.add(2.0f);
+    p = histogram.percentiles();
+    EXPECT_EQ(p.samples, lumina::kStatsWindow);
+    EXPECT_FLOAT_EQ(p.p50, 2.0f);
+    EXPECT_FLOAT_EQ(p.p99, 2.0f);
+}
+
+TEST(FrameStatsTest, GpuPassesFeedFrameTotalAndJson) {
+    lumina::FrameStats stats;
+    const float passes[] = {1.0f, 2.5f};
+    stats.recordGpuPasses(passes, 2);
+    stats.record(lumina::FrameStage::CpuFrame, 4.0f);
+    EXPECT_FLOAT_EQ(stats.last(lumina::FrameStage::GpuFrame), 3.5f);
+    EXPECT_FLOAT_EQ(stats.passPercentiles(1).p50, 2.5f);
+    EXPECT_EQ(stats.passPercentiles(lumina::kMaxEffectPasses).samples, 0u);
+    { lumina::ScopedStageTimer timer(&stats, lumina::FrameStage::Ingest); }
+    EXPECT_EQ(stats.percentiles(lumina::FrameStage::Ingest).samples, 1u);
+
+    const std::string json = stats.toJson();
+    EXPECT_NE(json.find(R"("cpuFrame":{"p50":4.000)"), std::string::npos);
+    EXPECT_NE(json.find(R"("gpuFrame":{"p50":3.500)"), std::string::npos);
+    EXPECT_NE(json.find(R"("passes":[{"p50":1.000)"), std::string::npos);
+    EXPECT_EQ(json.back(), '}');
+
+    stats.reset();
+    EXPECT_NE(stats.toJson().find(R"("passes":[]})"), std::string::npos);
+}
+
+TEST(FrameStatsTest, GpuMemoryIsReportedAsAGauge) {
+    lumina::FrameStats stats;
+    lumina::GpuMemoryUsage usage;
+    usage.used[static_cast<size_t>(lumina::GpuMemoryCategory::Targets)] = 4096;
+    usage.used[static_cast<size_t>(lumina::GpuMemoryCategory::Staging)] = 512;
+    usage.reserved = lumina::kGpuMemoryBlockSize;
+    usage.allocations = 1;
+    usage.blocks = 1;
+    stats.recordGpuMemory(usage);
+    stats.reset();
+
+    EXPECT_EQ(stats.gpuMemory().reserved, lumina::kGpuMemoryBlockSize);
+    const std::string json = stats.toJson();
+    EXPECT_NE(json.find(R"("gpuMemory":{"textures":0,"targets":4096,"staging":512,"readback":0,"uniforms":0,)"
+                        R"("reserved":33554432,"allocations":1,"blocks":1})"),
+              std::string::npos);
+}
+
+TEST(PixelConvertTest, YuvToRgbaMatchesBt601AcrossLayouts) {
+    struct Sample { uint8_t y, u, v, r, g, b; };
+    const Sample kSamples[] = {
+        {16, 128, 128, 0, 0, 0},        // black
+        {235, 128, 128, 255, 255, 255}, // white
+        {81, 90, 240, 255, 0, 0},       // red
+        {145, 54, 34, 0, 255, 0},       // green
+        {41, 240, 110, 0, 0, 255},      // blue
+    };
+    for (const Sample& s : kSamples) {
+        // Odd width and 40+ pixels per row cover both the vector body and the scalar tail.
+        const YuvFrame frame(41, 6, 0, [&](uint32_t, uint32_t) { return s.y; },
+                             [&](uint32_t, uint32_t) { return std::pair<uint8_t, uint8_t>(s.u, s.v); });
+        const std::vector<uint8_t> rgba = convertYuv(frame.planes, 1);
+        for (size_t i = 0; i < rgba.size(); i += 4) {
+            ASSERT_NEAR(rgba[i + 0], s.r, 3) << "pixel " << i / 4;
+            ASSERT_NEAR(rgba[i + 1], s.g, 3) << "pixel " << i / 4;
+            ASSERT_NEAR(rgba[i + 2], s.b, 3) << "pixel " << i / 4;
+            ASSERT_EQ(rgba[i + 3], 255);
+        }
+    }
+
+    // NV12, NV21 and I420 holding the same samples convert identically, at every factor.
+    auto lumaAt = [](uint32_t x, uint32_t y) { return static_cast<uint8_t>(16 + (x * 7 + y * 13) % 220); };
+    auto chromaAt = [](uint32_t x, uint32_t y) {
+        return std::pair<uint8_t, uint8_t>(static_cast<uint8_t>(40 + (x * 11 + y) % 180),
+                                           static_cast<uint8_t>(200 - (x + y * 5) % 160));
+    };
+    const YuvFrame nv12(70, 18, 0, lumaAt, chromaAt);
+    const YuvFrame nv21(70, 18, 1, lumaAt, chromaAt);
+    const YuvFrame i420(70, 18, 2, lumaAt, chromaAt);
+    for (uint32_t factor : {1u, 2u, 4u}) {
+        const std::vector<uint8_t> reference = convertYuv(nv12.planes, factor);
+        EXPECT_EQ(convertYuv(nv21.planes, factor), reference) << "factor " << factor;
+        EXPECT_EQ(convertYuv(i420.planes, factor), reference) << "factor " << factor;
+    }
+}
+
+TEST(PixelConvertTest, DownscaleBoxAveragesLuma) {
+    // Luma alternates 16/235 both ways, so every 2x2 and 4x4 box averages to mid-grey.
+    const YuvFrame frame(66, 12, 0, [](uint32_t x, uint32_t y) { return static_cast<uint8_t>((x + y) % 2 ? 235 : 16); },
+                         [](uint32_t, uint32_t) { return std::pair<uint8_t, uint8_t>(128, 128); });
+    const std::vector<uint8_t> full = convertYuv(frame.planes, 1);
+    EXPECT_EQ(full[0], 0);
+    EXPECT_GE(full[4], 253);
+    for (uint32_t factor : {2u, 4u}) {
+        const std::vector<uint8_t> rgba = convertYuv(frame.planes, factor);
+        ASSERT_EQ(rgba.size(), static_cast<size_t>(66 / factor) * (12 / factor) * 4);
+        for (size_t i = 0; i < rgba.size(); i += 4) {
+            ASSERT_NEAR(rgba[i + 0], 127, 1) << "factor " << factor << " pixel " << i / 4;
+            ASSERT_NEAR(rgba[i + 1], 127, 1) << "factor " << factor << " pixel " << i / 4;
+            ASSERT_NEAR(rgba[i + 2], 127, 1) << "factor " << factor << " pixel " << i / 4;
+        }
+    }
+
+    std::vector<uint8_t> dst(66 * 12 * 4);
+    EXPECT_FALSE(lumina::convertYuvToRgba(frame.planes, dst.data(), 66 * 4, 3));
+    EXPECT_FALSE(lumina::convertYuvToRgba(frame.planes, dst.data(), 65 * 4, 1));
+    lumina::YuvPlanes tiny = frame.planes;
+    tiny.width = 3;
+    EXPECT_FALSE(lumina::convertYuvToRgba(tiny, dst.data(), 66 * 4, 4));
+}
+
+TEST(FramePoolTest, SlotsCycleThroughAcquireAndRelease) {
+    lumina::FramePool pool;
+    EXPECT_EQ(pool.acquire(), -1);
+    EXPECT_FALSE(pool.configure(0, 1024));
+    EXPECT_FALSE(pool.configure(lumina::FramePool::kMaxSlots + 1, 1024));
+    ASSERT_TRUE(pool.configure(2, 1000));
+    EXPECT_EQ(pool.slotBytes() % lumina::FramePool::kSlotAlignment, 0u);
+    EXPECT_GE(pool.slotBytes(), 1000u);
+
+    const int a = pool.acquire();
+    const int b = pool.acquire();
+    ASSERT_GE(a, 0);
+    ASSERT_GE(b, 0);
+    EXPECT_NE(a, b);
+    EXPECT_EQ(pool.acquire(), -1);
+    EXPECT_EQ(pool.acquiredCount(), 2u);
+    EXPECT_EQ(reinterpret_cast<uintptr_t>(pool.data(a)) % lumina::FramePool::kSlotAlignment, 0u);
+
+    // Memory cannot move while a producer may still be writing into it.
+    EXPECT_FALSE(pool.configure(2, 4096));
+
+    EXPECT_TRUE(pool.release(a));
+    EXPECT_FALSE(pool.release(a));
+    EXPECT_EQ(pool.data(a), nullptr);
+    const int c = pool.acquire();
+    EXPECT_EQ(c, a);
+    EXPECT_NE(pool.data(c), nullptr);
+
+    EXPECT_TRUE(pool.release(b));
+    EXPECT_TRUE(pool.release(c));
+    EXPECT_TRUE(pool.configure(3, 4096));
+    EXPECT_EQ(pool.slotCount(), 3u);
+    EXPECT_EQ(pool.acquiredCount(), 0u);
+}
+
+TEST(FramePoolTest, RetiredSlotsWaitForTheirUpload) {
+    lumina::FramePool pool;
+    ASSERT_TRUE(pool.configure(2, 1024));
+    const int a = pool.acquire();
+    const int b = pool.acquire();
+    ASSERT_GE(a, 0);
+    ASSERT_GE(b, 0);
+
+    EXPECT_FALSE(pool.retire(a, 0));
+    EXPECT_TRUE(pool.retire(a, 5));
+    EXPECT_TRUE(pool.retire(b, 6));
+    // Retired slots belong to the upload now, not the producer.
+    EXPECT_FALSE(pool.retire(a, 7));
+    EXPECT_FALSE(pool.release(a));
+    EXPECT_EQ(pool.data(a), nullptr);
+    EXPECT_EQ(pool.retiredCount(), 2u);
+    EXPECT_EQ(pool.acquire(), -1);
+    EXPECT_FALSE(pool.configure(2, 4096));
+
+    EXPECT_EQ(pool.collect(4), 0u);
+    EXPECT_EQ(pool.collect(5), 1u);
+    EXPECT_EQ(pool.acquire(), a);
+    EXPECT_EQ(pool.retiredCount(), 1u);
+
+    // A renderer that is gone has nothing left to read the slot.
+    EXPECT_EQ(pool.collect(UINT64_MAX), 1u);
+    EXPECT_EQ(pool.retiredCount(), 0u);
+    EXPECT_EQ(pool.acquiredCount(), 1u);
+    EXPECT_TRUE(pool.release(a));
+}
+
+TEST(AnalysisFrameTest, ConfigPacksRowsIntoWholeTexels) {
+    lumina::AnalysisConfig rgb{256, 144, lumina::AnalysisFormat::RGB};
+    lumina::AnalysisConfig gray{320, 240, lumina::AnalysisFormat::GRAY};
+    EXPECT_TRUE(lumina::isValidAnalysisConfig(rgb));
+    EXPECT_TRUE(lumina::isValidAnalysisConfig(gray));
+    EXPECT_TRUE(lumina::isValidAnalysisConfig(lumina::AnalysisConfig{}));
+    EXPECT_FALSE(lumina::isValidAnalysisConfig({254, 144, lumina::AnalysisFormat::RGB}));
+    EXPECT_FALSE(lumina::isValidAnalysisConfig({256, 0, lumina::AnalysisFormat::RGB}));
+    EXPECT_FALSE(lumina::isValidAnalysisConfig({lumina::kMaxAnalysisExtent + 4, 16, lumina::AnalysisFormat::GRAY}));
+
+    EXPECT_EQ(lumina::analysisFrameBytes(rgb), 256u * 144u * 3u);
+    EXPECT_EQ(lumina::analysisTargetWidth(rgb) * 4u, 256u * 3u);
+    EXPECT_EQ(lumina::analysisFrameBytes(gray), 320u * 240u);
+    EXPECT_EQ(lumina::analysisTargetWidth(gray) * 4u, 320u);
+}
+
+TEST(AnalysisFrameTest, ReadersSeeEachPublishedFrameOnce) {
+    lumina::AnalysisFrameExchange exchange;
+    const lumina::AnalysisConfig config{8, 4, lumina::AnalysisFormat::GRAY};
+    std::vector<uint8_t> out(lumina::analysisFrameBytes(config));
+    lumina::AnalysisFrameInfo info;
+    EXPECT_EQ(exchange.readLatest(out.data(), out.size(), &info), 0u);
+    EXPECT_EQ(info.frameNumber, 0u);
+
+    for (uint64_t frame = 1; frame <= 2; ++frame) {
+        uint8_t* pixels = exchange.beginFrame(config);
+        std::fill(pixels, pixels + lumina::analysisFrameBytes(config), static_cast<uint8_t>(frame));
+        exchange.publish(frame, static_cast<int64_t>(frame) * 1000);
+    }
+
+    // Only the newest frame is handed out, and only once.
+    ASSERT_EQ(exchange.readLatest(out.data(), out.size(), &info), out.size());
+    EXPECT_EQ(info.frameNumber, 2u);
+    EXPECT_EQ(info.timestampNs, 2000);
+    EXPECT_EQ(out.front(), 2);
+    EXPECT_EQ(out.back(), 2);
+    EXPECT_EQ(exchange.readLatest(out.data(), out.size(), &info), 0u);
+
+    // A too small buffer leaves the frame unread but still reports its size.
+    const lumina::AnalysisConfig larger{16, 8, lumina::AnalysisFormat::RGB};
+    exchange.beginFrame(larger);
+    exchange.publish(1, 3000);
+    EXPECT_EQ(exchange.readLatest(out.data(), out.size(), &info), 0u);
+    EXPECT_EQ(info.config, larger);
+    out.resize(lumina::analysisFrameBytes(info.config));
+    EXPECT_EQ(exchange.readLatest(out.data(), out.size(), &info), out.size());
+    EXPECT_EQ(info.frameNumber, 1u);
+}
+
+TEST(RecordingTest, ConfigNeedsEvenSizesAndSaneRates) {
+    lumina::RecordingConfig config;
+    config.width = 1920;
+    config.height = 1080;
+    EXPECT_TRUE(lumina::isValidRecordingConfig(config));
+
+    lumina::RecordingConfig odd = config;
+    odd.height = 1081;
+    EXPECT_FALSE(lumina::isValidRecordingConfig(odd));
+    lumina::RecordingConfig tiny = config;
+    tiny.width = 32;
+    EXPECT_FALSE(lumina::isValidRecordingConfig(tiny));
+    lumina::RecordingConfig noRate = config;
+    noRate.frameRate = 0;
+    EXPECT_FALSE(lumina::isValidRecordingConfig(noRate));
+
+    EXPECT_EQ(lumina::defaultRecordingBitRate(1920, 1080, 30), 12441600);
+    EXPECT_EQ(lumina::defaultRecordingBitRate(64, 64, 1), 500000);  // floor
+}
+
+TEST(RecordingTest, ClockSkipsFramesThatDoNotAdvance) {
+    lumina::RecordingClock clock;
+    int64_t timestamp = 0;
+    ASSERT_TRUE(clock.next(1000, &timestamp));
+    EXPECT_EQ(timestamp, 1000);
+    EXPECT_FALSE(clock.next(1000, &timestamp));  // repeated vsync
+    EXPECT_FALSE(clock.next(900, &timestamp));
+    ASSERT_TRUE(clock.next(2000, &timestamp));
+    EXPECT_EQ(timestamp, 2000);
+
+    clock.reset();
+    EXPECT_TRUE(clock.next(500, &timestamp));
+}
+
+TEST(RecordingTest, ExportProgressFractionIsClampedAndCompleteOnSuccess) {
+    lumina::ExportProgress progress;
+    EXPECT_FLOAT_EQ(progress.fraction(), 0.0f);  // duration unknown
+    progress.durationUs = 60000000;
+    progress.positionUs = 15000000;
+    EXPECT_FLOAT_EQ(progress.fraction(), 0.25f);
+    progress.positionUs = 61000000;  // last frame runs past the container duration
+    EXPECT_FLOAT_EQ(progress.fraction(), 1.0f);
+    progress.positionUs = 59966666;
+    progress.succeeded = true;
+    EXPECT_FLOAT_EQ(progress.fraction(), 1.0f);
+}
+
+TEST(VideoSourceTest, QueueDropsLateFramesAndBlocksTheProducerWhenFull) {
+    lumina::DecodeQueue queue(2);
+    const uint64_t generation = queue.generation();
+    int images[4] = {};
+    ASSERT_TRUE(queue.push({&images[0], 0}, generation));
+    ASSERT_TRUE(queue.push({&images[1], 33000}, generation));
+
+    std::atomic<bool> pushed{false};
+    std::thread producer([&] {
+        pushed = queue.push({&images[2], 66000}, generation);
+    });
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    EXPECT_FALSE(pushed.load());  // decode-ahead is bounded
+
+    lumina::DecodedFrame frame;
+    std::vector<lumina::DecodedFrame> dropped;
+    EXPECT_FALSE(queue.popDue(-1, &frame, &dropped));
+    // At 40 ms the 0 ms frame was never shown: only the newest due frame comes out.
+    ASSERT_TRUE(queue.popDue(40000, &frame, &dropped));
+    EXPECT_EQ(frame.image, &images[1]);
+    ASSERT_EQ(dropped.size(), 1u);
+    EXPECT_EQ(dropped[0].image, &images[0]);
+    producer.join();
+    EXPECT_TRUE(pushed.load());
+    EXPECT_EQ(queue.size(), 1u);
+
+    queue.setEndOfStream(generation);
+    EXPECT_FALSE(queue.finished());
+    ASSERT_TRUE(queue.popNext(&frame, std::chrono::milliseconds(0)));
+    EXPECT_EQ(frame.ptsUs, 66000);
+    EXPECT_TRUE(queue.finished());
+    EXPECT_FALSE(queue.popNext(&frame, std::chrono::milliseconds(50)));  // end of stream, no wait
+}
+
+TEST(VideoSourceTest, FlushStartsANewGenerationAndReleasesABlockedProducer) {
+    lumina::DecodeQueue queue(1);
+    const uint64_t before = queue.generation();
+    int images[3] = {};
+    ASSERT_TRUE(queue.push({&images[0], 0}, before));
+
+    std::atomic<bool> pushed{true};
+    std::thread producer([&] {
+        pushed = queue.push({&images[1], 33000}, before);
+    });
+    std::vector<lumina::DecodedFrame> dropped;
+    const uint64_t after = queue.flush(&dropped);
+    producer.join();
+    EXPECT_FALSE(pushed.load());  // stale frames never reach the new generation
+    EXPECT_NE(after, before);
+    ASSERT_EQ(dropped.size(), 1u);
+    EXPECT_EQ(queue.size(), 0u);
+
+    EXPECT_TRUE(queue.waitForSpace(after));
+    EXPECT_TRUE(queue.push({&images[2], 500000}, after));
+    queue.close();
+    EXPECT_FALSE(queue.waitForSpace(after));
+    EXPECT_FALSE(queue.push({&images[0], 533000}, after));
+}
+
+TEST(VideoSourceTest, PlaybackClockFollowsFrameTimesFromTheFirstFrameAfterPlay) {
+    lumina::PlaybackClock clock;
+    EXPECT_EQ(clock.mediaTimeUs(5000000000), 0);  // paused
+
+    clock.setPlaying(true);
+    EXPECT_EQ(clock.mediaTimeUs(6000000000), 0);  // anchors here, not at the call
+    EXPECT_EQ(clock.mediaTimeUs(6016666666), 16666);
+    EXPECT_EQ(clock.mediaTimeUs(6100000000), 100000);
+
+    clock.setPlaying(false);
+    EXPECT_EQ(clock.mediaTimeUs(7000000000), 100000);
+    clock.setPlaying(true);
+    EXPECT_EQ(clock.mediaTimeUs(8000000000), 100000);
+    EXPECT_EQ(clock.mediaTimeUs(8050000000), 150000);
+
+    clock.seek(2000000);
+    EXPECT_EQ(clock.positionUs(), 2000000);
+    EXPECT_TRUE(clock.playing());
+    EXPECT_EQ(clock.mediaTimeUs(9000000000), 2000000);
+    EXPECT_EQ(clock.mediaTimeUs(9010000000), 2010000);
+}
+
+TEST(RenderScaleTest, StepsDownUnderLoadAndBackUpWhenThereIsRoom) {
+    lumina::RenderScaleConfig config;
+    config.settleFrames = 4;
+    lumina::RenderScaleController controller(config);
+
+    // 15 ms of a 16.7 ms budget: over the 80% target, one step per settle window.
+    int changes = 0;
+    for (int i = 0; i < 4; ++i) changes += controller.update(15.0f, 16.7f, -1.0f) ? 1 : 0;
+    EXPECT_EQ(changes, 1);
+    EXPECT_FLOAT_EQ(controller.scale(), 0.875f);
+    for (int i = 0; i < 100; ++i) controller.update(15.0f, 16.7f, -1.0f);
+    EXPECT_FLOAT_EQ(controller.scale(), config.minScale);
+
+    // A light load predicts room at the next step up (once the smoothed load has
+    // caught up); an almost-full one does not.
+    bool raised = false;
+    for (int i = 0; i < 60 && !raised; ++i) raised = controller.update(4.0f, 16.7f, -1.0f);
+    EXPECT_TRUE(raised);
+    EXPECT_FLOAT_EQ(controller.scale(), 0.625f);
+    for (int i = 0; i < 40; ++i) controller.update(9.5f, 16.7f, -1.0f);
+    EXPECT_FLOAT_EQ(controller.scale(), 0.625f);
+}
+
+TEST(RenderScaleTest, ThermalHeadroomCapsScaleImmediately) {
+    lumina::RenderScaleController controller;
+    EXPECT_FALSE(controller.update(2.0f, 16.7f, 0.5f));
+    EXPECT_FLOAT_EQ(controller.scale(), 1.0f);
+
+    EXPECT_TRUE(controller.update(2.0f, 16.7f, 0.85f));
+    EXPECT_FLOAT_EQ(controller.scale(), 0.75f);
+    EXPECT_TRUE(controller.update(2.0f, 16.7f, 1.2f));
+    EXPECT_FLOAT_EQ(controller.scale(), 0.5f);
+
+    // Unknown headroom lifts the cap; the scale then recovers step by step.
+    for (int i = 0; i < 30; ++i) controller.update(2.0f, 16.7f, std::nanf(""));
+    EXPECT_FLOAT_EQ(controller.scale(), 0.625f);
+    controller.reset();
+    EXPECT_FLOAT_EQ(controller.scale(), 1.0f);
+}
+
+TEST(RenderScaleTest, ScaledExtentIsEvenAndBounded) {
+    EXPECT_EQ(lumina::scaledExtent(1081, 1.0f), 1081u);
+    EXPECT_EQ(lumina::scaledExtent(1080, 0.75f), 810u);
+    EXPECT_EQ(lumina::scaledExtent(1081, 0.5f), 540u);
+    EXPECT_EQ(lumina::scaledExtent(3, 0.1f), 2u);
+    EXPECT_EQ(lumina::scaledExtent(1, 0.5f), 1u);
+}
+
+TEST(RedrawTrackerTest, RedrawsOnlyWhenStateInputOrTimeMoves) {
+    lumina::RedrawTracker tracker;
+    EXPECT_TRUE(tracker.needsRedraw(0, 0, false));  // nothing presented yet
+    tracker.presented(7, 3);
+    EXPECT_FALSE(tracker.needsRedraw(7, 3, false));
+    EXPECT_TRUE(tracker.needsRedraw(8, 3, false));
+    EXPECT_TRUE(tracker.needsRedraw(7, 4, false));
+    EXPECT_TRUE(tracker.needsRedraw(7, 3, true));
+
+    tracker.invalidate();
+    EXPECT_TRUE(tracker.needsRedraw(7, 3, false));
+    tracker.presented(7, 3);
+    EXPECT_FALSE(tracker.needsRedraw(7, 3, false));
+}
+
+TEST(RedrawTrackerTest, NoiseAndStylizedModeAnimateWithTime) {
+    lumina::LuminaState state;
+    state.activeEffectCount = 2;
+    state.effects[0].type = EffectType::VIGNETTE;
+    state.effects[0].intensity = 1.0f;
+    state.effects[1].type = EffectType::BLUR;
+    state.effects[1].intensity = 1.0f;
+    EXPECT_FALSE(lumina::usesFrameTime(state));
+
+    state.effects[2].type = EffectType::NOISE;  // inactive
+    state.effects[2].intensity = 1.0f;
+    EXPECT_FALSE(lumina::usesFrameTime(state));
+    state.activeEffectCount = 3;
+    EXPECT_TRUE(lumina::usesFrameTime(state));
+    state.effects[2].intensity = 0.0f;
+    EXPECT_FALSE(lumina::usesFrameTime(state));
+
+    state.renderMode = lumina::RenderMode::STYLIZED;
+    EXPECT_TRUE(lumina::usesFrameTime(state));
+}
+
+namespace {
+
+struct alignas(256) SharedRegion {
+    uint8_t bytes[lumina::kSharedStateSize + 256];
+};
+
+} // namespace
+
+TEST(SharedStateTest, ReadersSeeTheNewestPublishedState) {
+    auto region = std::make_unique<SharedRegion>();
+    lumina::SharedStateBlock writer;
+    ASSERT_FALSE(writer.create(region->bytes + 4, lumina::kSharedStateSize));  // misaligned
+    ASSERT_FALSE(writer.create(region->bytes, lumina::kSharedStateSize - 1));
+    ASSERT_TRUE(writer.create(region->bytes, sizeof(region->bytes)));
+
+    lumina::SharedStateBlock reader;
+    ASSERT_TRUE(reader.open(region->bytes, lumina::kSharedStateSize));
+    lumina::LuminaState out;
+    EXPECT_FALSE(reader.readLatest(out));  // nothing published yet
+
+    lumina::LuminaState state;
+    for (uint32_t i = 1; i <= 5; ++i) {
+        state.stateId = i;
+        state.setDimensions(640 * i, 480);
+        writer.publish(state);
+    }
+    ASSERT_TRUE(reader.readLatest(out));
+    EXPECT_EQ(out.stateId, 5u);
+    EXPECT_EQ(out.width, 3200u);
+    EXPECT_EQ(reader.publishSeq(), 5u);
+
+    // Kotlin and Python find everything through the header.
+    uint32_t words[8];
+    std::memcpy(words, region->bytes, sizeof(words));
+    EXPECT_EQ(words[0], lumina::kSharedStateMagic);
+    EXPECT_EQ(words[3], lumina::kSharedIntentOffset);
+    EXPECT_EQ(words[4], lumina::kSharedSlotsOffset);
+    EXPECT_EQ(words[6], lumina::kSharedStateSlots);
+
+    words[1] = lumina::kSharedStateVersion + 1;
+    std::memcpy(region->bytes, words, sizeof(words));
+    lumina::SharedStateBlock stale;
+    EXPECT_FALSE(stale.open(region->bytes, lumina::kSharedStateSize));
+}
+
+TEST(SharedStateTest, CommittedIntentsAreSanitized) {
+    auto region = std::make_unique<SharedRegion>();
+    lumina::SharedStateBlock block;
+    ASSERT_TRUE(block.create(region->bytes, lumina::kSharedStateSize));
+
+    // Written in place the way the orchestrator does, unterminated and out of range.
+    lumina::AIIntent* current = block.currentIntent();
+    std::strcpy(current->action, "add_effect");
+    std::strcpy(current->target, "bloom");
+    std::memset(current->parameters, 'x', sizeof(current->parameters));
+    current->confidence = 1.7f;
+    current->timestamp = 42;
+    block.pendingIntent()->confidence = std::nanf("");
+
+    lumina::LuminaState state;
+    block.applyIntents(state);
+    EXPECT_STREQ(state.currentIntent.action, "add_effect");
+    EXPECT_STREQ(state.currentIntent.target, "bloom");
+    EXPECT_EQ(std::strlen(state.currentIntent.parameters), lumina::AIIntent::MAX_PARAMS_LENGTH - 1);
+    EXPECT_FLOAT_EQ(state.currentIntent.confidence, 1.0f);
+    EXPECT_EQ(state.currentIntent.timestamp, 42u);
+    EXPECT_FLOAT_EQ(state.pendingIntent.confidence, 0.0f);
+    EXPECT_EQ(block.intentSeq(), 1u);
+}
+
+TEST(SharedStateTest, ReaderNeverSeesATornSnapshot) {
+    auto region = std::make_unique<SharedRegion>();
+    lumina::SharedStateBlock writer;
+    ASSERT_TRUE(writer.create(region->bytes, lumina::kSharedStateSize));
+    lumina::SharedStateBlock reader;
+    ASSERT_TRUE(reader.open(region->bytes, lumina::kSharedStateSize));
+
+    std::atomic<bool> reading{false};
+    std::atomic<bool> done{false};
+    std::thread producer([&] {
+        while (!reading) std::this_thread::yield();
+        lumina::LuminaState state;
+        for (uint32_t i = 1; i <= 20000; ++i) {
+            state.stateId = i;
+            state.width = i;
+            state.pendingIntent.timestamp = i;
+            writer.publish(state);
+        }
+        done = true;
+    });
+
+    uint32_t last = 0;
+    lumina::LuminaState out;
+    reading = true;
+    while (!done) {
+        if (!reader.readLatest(out)) continue;
+        ASSERT_EQ(out.width, out.stateId);
+        ASSERT_EQ(out.pendingIntent.timestamp, out.stateId);
+        ASSERT_GE(out.stateId, last);
+        last = out.stateId;
+    }
+    producer.join();
+    ASSERT_TRUE(reader.readLatest(out));
+    EXPECT_EQ(out.stateId, 20000u);
+}
+
+namespace {
+
+// Appends one record the way com.lumina.engine.CommandBuffer does.
+template <typename T>
+void appendCommand(std::vector<uint8_t>& stream, lumina::CommandType type, const T* payload, uint32_t size = sizeof(T)) {
+    const lumina::CommandHeader header{static_cast<uint32_t>(type), size};
+    const auto* h = reinterpret_cast<const uint8_t*>(&header);
+    stream.insert(stream.end(), h, h + sizeof(header));
+    const auto* p = reinterpret_cast<const uint8_t*>(payload);
+    if (payload) stream.insert(stream.end(), p, p + size);
+}
+
+std::vector<uint8_t> commandStream() {
+    std::vector<uint8_t> stream(sizeof(uint32_t));
+    const uint32_t version = lumina::kCommandStreamVersion;
+    std::memcpy(stream.data(), &version, sizeof(version));
+    return stream;
+}
+
+} // namespace
+
+TEST(CommandStreamTest, AppliesCommandsInOrder) {
+    std::vector<uint8_t> stream = commandStream();
+    const uint32_t mode = 9;  // clamped to NORMAL_MAP
+    appendCommand(stream, lumina::CommandType::SetRenderMode, &mode);
+    for (float x : {0.1f, 0.2f, 0.3f}) {
+        const lumina::CommandTouch touch{2, 0.5f, {x, 0.4f}, {0.01f, 0.0f}};
+        appendCommand(stream, lumina::CommandType::SetTouch, &touch);
+    }
+    lumina::CommandEffect effect{};
+    effect.index = 1;
+    effect.effect.type = static_cast<uint32_t>(EffectType::VIGNETTE);
+    effect.effect.intensity = 0.75f;
+    appendCommand(stream, lumina::CommandType::SetEffect, &effect);
+    const uint32_t count = 2;
+    appendCommand(stream, lumina::CommandType::SetEffectCount, &count);
+    appendCommand<uint8_t>(stream, lumina::CommandType::ReadTiming, nullptr, 0);
+
+    lumina::LuminaState state;
+    state.activeEffectCount = 4;
+    state.effects[3].type = EffectType::NOISE;
+    const uint32_t stateId = state.stateId;
+    const lumina::CommandOutcome outcome = lumina::applyCommands(stream.data(), stream.size(), state);
+
+    ASSERT_TRUE(outcome.valid);
+    EXPECT_EQ(outcome.applied, 7u);
+    EXPECT_EQ(outcome.rejected, 0u);
+    EXPECT_TRUE(outcome.stateChanged);
+    EXPECT_TRUE(outcome.timingRequested);
+    EXPECT_FALSE(outcome.frameRequested);
+    EXPECT_EQ(state.renderMode, lumina::RenderMode::NORMAL_MAP);
+    EXPECT_FLOAT_EQ(state.touchPosition.x, 0.3f);  // last touch wins
+    EXPECT_EQ(state.touchState, 2u);
+    EXPECT_EQ(state.effects[1].type, EffectType::VIGNETTE);
+    EXPECT_FLOAT_EQ(state.effects[1].intensity, 0.75f);
+    EXPECT_EQ(state.activeEffectCount, 2u);
+    EXPECT_EQ(state.effects[3].type, EffectType::NONE);
+    EXPECT_EQ(state.stateId, stateId);  // the engine bumps it once per submit
+}
+
+TEST(CommandStreamTest, SkipsBadRecordsAndRejectsBrokenStreams) {
+    std::vector<uint8_t> stream = commandStream();
+    const uint32_t value = 3;
+    appendCommand(stream, static_cast<lumina::CommandType>(99), &value);
+    lumina::CommandEffect effect{};
+    effect.index = 4;  // out of range
+    appendCommand(stream, lumina::CommandType::SetEffect, &effect);
+    appendCommand(stream, lumina::CommandType::SetProcessing, &value);
+
+    lumina::LuminaState state;
+    lumina::CommandOutcome outcome = lumina::applyCommands(stream.data(), stream.size(), state);
+    ASSERT_TRUE(outcome.valid);
+    EXPECT_EQ(outcome.applied, 1u);
+    EXPECT_EQ(outcome.rejected, 2u);
+    EXPECT_EQ(state.processingState, lumina::ProcessingState::ERROR);
+
+    // Truncated last record: nothing applies.
+    lumina::LuminaState untouched;
+    const uint32_t mode = 1;
+    appendCommand(stream, lumina::CommandType::SetRenderMode, &mode);
+    outcome = lumina::applyCommands(stream.data(), stream.size() - 1, untouched);
+    EXPECT_FALSE(outcome.valid);
+    EXPECT_EQ(untouched.processingState, lumina::ProcessingState::IDLE);
+
+    stream[0] = 2;  // foreign version
+    EXPECT_FALSE(lumina::applyCommands(stream.data(), stream.size(), untouched).valid);
+}
+
+TEST(GpuMemoryTest, SuballocatesAlignedRangesAndMergesOnRelease) {
+    lumina::BlockSuballocator block(1024);
+    const auto a = block.allocate(100, 1);
+    const auto b = block.allocate(200, 256);
+    const auto c = block.allocate(300, 64);
+    ASSERT_TRUE(a && b && c);
+    EXPECT_EQ(*a, 0u);
+    EXPECT_EQ(*b, 256u);  // the padding in front stays free
+    EXPECT_EQ(*c, 512u);
+    EXPECT_EQ(block.used(), 600u);
+    EXPECT_EQ(*block.allocate(100, 4), 100u);  // first fit lands in the padding
+
+    EXPECT_FALSE(block.allocate(1024, 1));
+    EXPECT_FALSE(block.allocate(16, 3));  // not a power of two
+    EXPECT_FALSE(block.allocate(0, 1));
+
+    EXPECT_TRUE(block.release(*b));
+    EXPECT_FALSE(block.release(*b));
+    EXPECT_FALSE(block.release(7));
+    EXPECT_TRUE(block.release(*c));
+    EXPECT_TRUE(block.release(*a));
+    EXPECT_FALSE(block.empty());
+    EXPECT_TRUE(block.release(100));
+    EXPECT_TRUE(block.empty());
+    EXPECT_EQ(block.used(), 0u);
+    EXPECT_EQ(block.freeRangeCount(), 1u);
+    EXPECT_EQ(*block.allocate(1024, 1024), 0u);
+}
+
+TEST(GpuLayoutTest, ChecksMirrorsAgainstReflectedBlocks) {
+    // effect_chain.frag's Effect as glslc lays it out under std140.
+    constexpr lumina::BlockLayout<7> effect{"Effect", 64, {{
+        {"type", 0, 4, 0},
+        {"intensity", 4, 4, 0},
+        {"param1", 8, 4, 0},
+        {"param2", 12, 4, 0},
+        {"tintColor", 16, 16, 0},
+        {"center", 32, 16, 0},
+        {"scale", 48, 16, 0},
+    }}};
+    LUMINA_ASSERT_BLOCK_MEMBER(effect, lumina::EffectParams, type);
+    LUMINA_ASSERT_BLOCK_MEMBER(effect, lumina::EffectParams, tintColor);
+    LUMINA_ASSERT_BLOCK_MEMBER(effect, lumina::EffectParams, scale);
+    LUMINA_ASSERT_BLOCK_SIZE(effect, lumina::EffectParams);
+
+    ASSERT_NE(effect.find("center"), nullptr);
+    EXPECT_EQ(effect.find("center")->offset, offsetof(lumina::EffectParams, center));
+    EXPECT_EQ(effect.find("padding"), nullptr);
+    EXPECT_TRUE(effect.matches("param2", 12, sizeof(float)));
+    EXPECT_FALSE(effect.matches("param2", 8, sizeof(float)));
+    EXPECT_FALSE(effect.matches("tintColor", 16, 12));  // a vec3 would not cover ColorRGBA
+    EXPECT_FALSE(effect.matches("missing", 0, 4));
+}
+
+TEST(InputReleaseTest, HandsBuffersBackOnceTheFramesThatReadThemFinish) {
+    lumina::InputReleaseTracker holds;
+    const uint64_t first = holds.attach();
+    EXPECT_EQ(first, 1u);
+    holds.sampled(10);
+    holds.sampled(11);
+    holds.collect(20);
+    EXPECT_EQ(holds.released(), 0u);  // still the input
+
+    const uint64_t second = holds.attach();
+    EXPECT_EQ(second, 2u);
+    holds.collect(11);
+    EXPECT_EQ(holds.released(), 0u);  // frame 11 may still be reading the first
+    holds.collect(12);
+    EXPECT_EQ(holds.released(), first);
+
+    const uint64_t third = holds.attach();  // the second was never drawn
+    holds.collect(0);
+    EXPECT_EQ(holds.released(), second);
+
+    holds.sampled(12);
+    holds.detach();  // a CPU upload took over
+    EXPECT_EQ(holds.pending(), 1u);
+    holds.sampled(13);  // draws of the owned input hold nothing
+    holds.collect(13);
+    EXPECT_EQ(holds.released(), third);
+    EXPECT_EQ(holds.pending(), 0u);
+
+    const uint64_t fourth = holds.attach();
+    holds.sampled(14);
+    holds.attach();
+    holds.sampled(15);
+    holds.releaseAll();
+    EXPECT_GT(holds.released(), fourth);
+    EXPECT_EQ(holds.pending(), 0u);
+    EXPECT_EQ(holds.attach(), holds.released() + 1);  // tokens keep counting up
+}
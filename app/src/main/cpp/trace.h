@@ -0,0 +1,65 @@
+#ifndef LUMINA_TRACE_H
+#define LUMINA_TRACE_H
+
+#include <cstdint>
+
+/**
+ * Lumina Virtual Studio - Trace markers
+ *
+ * Thin wrapper over the NDK ATrace API so engine stages show up as named slices
+ * and counter tracks in Perfetto / systrace captures. Everything compiles away
+ * unless LUMINA_ENABLE_TRACING is defined (Debug builds, or Release with the
+ * LUMINA_TRACING CMake option), so instrumented hot paths cost nothing in shipping
+ * builds. With tracing compiled in, markers are still skipped unless a capture is
+ * running.
+ *
+ *   LUMINA_TRACE_SCOPE("Vulkan::acquire");          // slice for the enclosing scope
+ *   LUMINA_TRACE_COUNTER("Lumina upload bytes", n); // sample on a counter track
+ *
+ * Names must be string literals (or otherwise outlive the capture).
+ */
+
+#if defined(LUMINA_ENABLE_TRACING)
+
+#include <android/trace.h>
+
+namespace lumina {
+
+class ScopedTrace {
+public:
+    explicit ScopedTrace(const char* name) : active_(ATrace_isEnabled()) {
+        if (active_) ATrace_beginSection(name);
+    }
+    ~ScopedTrace() {
+        if (active_) ATrace_endSection();
+    }
+
+    ScopedTrace(const ScopedTrace&) = delete;
+    ScopedTrace& operator=(const ScopedTrace&) = delete;
+
+private:
+    bool active_;
+};
+
+inline void traceCounter(const char* name, int64_t value) {
+    if (ATrace_isEnabled()) ATrace_setCounter(name, value);
+}
+
+} // namespace lumina
+
+#define LUMINA_TRACE_CONCAT_INNER(a, b) a##b
+#define LUMINA_TRACE_CONCAT(a, b) LUMINA_TRACE_CONCAT_INNER(a, b)
+#define LUMINA_TRACE_SCOPE(name) ::lumina::ScopedTrace LUMINA_TRACE_CONCAT(luminaTrace_, __LINE__)(name)
+#define LUMINA_TRACE_COUNTER(name, value) ::lumina::traceCounter(name, static_cast<int64_t>(value))
+#define LUMINA_TRACE_ENABLED 1
+
+#else
+
+// Arguments are not evaluated, so counter expressions may be arbitrarily expensive.
+#define LUMINA_TRACE_SCOPE(name) static_cast<void>(0)
+#define LUMINA_TRACE_COUNTER(name, value) static_cast<void>(0)
+#define LUMINA_TRACE_ENABLED 0
+
+#endif
+
+#endif // LUMINA_TRACE_H
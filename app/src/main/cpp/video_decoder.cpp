@@ -0,0 +1,317 @@
+#include "video_decoder.h"
+
+#include <android/log.h>
+#include <media/NdkMediaFormat.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cstring>
+
+#define LOG_TAG "LuminaDecoder"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+constexpr int64_t kDequeueTimeoutUs = 10000;
+// The codec's output reaches the reader within a frame or two; past this the image is
+// treated as lost rather than stalling the decode thread.
+constexpr int kImageRetries = 50;
+constexpr auto kImageWait = std::chrono::milliseconds(2);
+
+int64_t fileLength(int fd, int64_t offset) {
+    struct stat st {};
+    if (fstat(fd, &st) != 0 || st.st_size <= offset) return -1;
+    return static_cast<int64_t>(st.st_size) - offset;
+}
+
+} // namespace
+
+VideoDecoder::~VideoDecoder() {
+    close();
+}
+
+bool VideoDecoder::open(int fd, int64_t offset, int64_t length) {
+    if (codec_ || fd_ >= 0) {
+        LOGW("Decoder already open");
+        return false;
+    }
+    fd_ = dup(fd);
+    if (fd_ < 0) {
+        LOGE("Cannot duplicate the video descriptor");
+        return false;
+    }
+    if (length < 0) length = fileLength(fd_, offset);
+
+    extractor_ = AMediaExtractor_new();
+    if (length <= 0 || AMediaExtractor_setDataSourceFd(extractor_, fd_, offset, length) != AMEDIA_OK) {
+        LOGE("Cannot read the video source");
+        releaseAll();
+        return false;
+    }
+
+    AMediaFormat* format = nullptr;
+    const char* mime = nullptr;
+    const size_t tracks = AMediaExtractor_getTrackCount(extractor_);
+    for (size_t i = 0; i < tracks; ++i) {
+        AMediaFormat* candidate = AMediaExtractor_getTrackFormat(extractor_, i);
+        const char* candidateMime = nullptr;
+        if (AMediaFormat_getString(candidate, AMEDIAFORMAT_KEY_MIME, &candidateMime) &&
+            strncmp(candidateMime, "video/", 6) == 0) {
+            AMediaExtractor_selectTrack(extractor_, i);
+            format = candidate;
+            mime = candidateMime;
+            break;
+        }
+        AMediaFormat_delete(candidate);
+    }
+    if (!format) {
+        LOGE("No video track");
+        releaseAll();
+        return false;
+    }
+
+    info_ = {};
+    AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_WIDTH, &info_.width);
+    AMediaFormat_getInt32(format, AMEDIAFORMAT_KEY_HEIGHT, &info_.height);
+    AMediaFormat_getInt64(format, AMEDIAFORMAT_KEY_DURATION, &info_.durationUs);
+
+    // The reader owns every buffer the codec renders into: decode-ahead frames, frames
+    // the renderers still sample and one the codec is writing.
+    constexpr int32_t kMaxImages = static_cast<int32_t>(kDecodeAhead + kHeldFrames + 1);
+    ANativeWindow* window = nullptr;
+    if (info_.width <= 0 || info_.height <= 0 ||
+        AImageReader_newWithUsage(info_.width, info_.height, AIMAGE_FORMAT_PRIVATE,
+                                  AHARDWAREBUFFER_USAGE_GPU_SAMPLED_IMAGE, kMaxImages, &reader_) != AMEDIA_OK ||
+        AImageReader_getWindow(reader_, &window) != AMEDIA_OK) {
+        LOGE("Cannot create a %dx%d image reader", info_.width, info_.height);
+        AMediaFormat_delete(format);
+        releaseAll();
+        return false;
+    }
+    AImageReader_ImageListener listener{this, &VideoDecoder::onImageAvailable};
+    AImageReader_setImageListener(reader_, &listener);
+
+    codec_ = AMediaCodec_createDecoderByType(mime);
+    media_status_t status = codec_
+        ? AMediaCodec_configure(codec_, format, window, nullptr, 0)
+        : AMEDIA_ERROR_UNSUPPORTED;
+    if (status == AMEDIA_OK) status = AMediaCodec_start(codec_);
+    if (status != AMEDIA_OK) {
+        LOGE("Failed to start a %s decoder for %dx%d: %d", mime, info_.width, info_.height, status);
+        AMediaFormat_delete(format);
+        releaseAll();
+        return false;
+    }
+    LOGI("Decoding %s %dx%d, %lld us", mime, info_.width, info_.height,
+         static_cast<long long>(info_.durationUs));
+    // `mime` points into the format, so it goes last.
+    AMediaFormat_delete(format);
+
+    quit_ = false;
+    awaitingSeek_ = true;   // show the first frame whatever its timestamp
+    thread_ = std::thread(&VideoDecoder::decodeLoop, this);
+    return true;
+}
+
+void VideoDecoder::close() {
+    if (thread_.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(controlMutex_);
+            quit_ = true;
+        }
+        control_.notify_all();
+        imageAvailable_.notify_all();
+        queue_.close();
+        thread_.join();
+    }
+    releaseAll();
+}
+
+void VideoDecoder::seek(int64_t timeUs) {
+    if (!codec_) return;
+    std::vector<lumina::DecodedFrame> dropped;
+    {
+        // The decode thread picks up the target and the new generation together, so no
+        // pre-seek frame lands in the new generation.
+        std::lock_guard<std::mutex> lock(controlMutex_);
+        queue_.flush(&dropped);
+        seekTarget_ = timeUs < 0 ? 0 : timeUs;
+    }
+    control_.notify_all();
+    release(dropped);
+    awaitingSeek_ = true;
+}
+
+AHardwareBuffer* VideoDecoder::frameAt(int64_t mediaTimeUs, int64_t* ptsUs) {
+    std::vector<lumina::DecodedFrame> dropped;
+    lumina::DecodedFrame frame;
+    const bool next = awaitingSeek_
+        ? queue_.popNext(&frame, std::chrono::milliseconds(0))
+        : queue_.popDue(mediaTimeUs, &frame, &dropped);
+    release(dropped);
+    if (next) {
+        awaitingSeek_ = false;
+        return show(frame, ptsUs);
+    }
+    if (!held_[0]) return nullptr;
+    if (ptsUs) *ptsUs = currentPtsUs_;
+    AHardwareBuffer* buffer = nullptr;
+    AImage_getHardwareBuffer(held_[0], &buffer);
+    return buffer;
+}
+
+AHardwareBuffer* VideoDecoder::nextFrame(std::chrono::milliseconds timeout, int64_t* ptsUs) {
+    lumina::DecodedFrame frame;
+    if (!queue_.popNext(&frame, timeout)) return nullptr;
+    awaitingSeek_ = false;
+    return show(frame, ptsUs);
+}
+
+AHardwareBuffer* VideoDecoder::show(const lumina::DecodedFrame& frame, int64_t* ptsUs) {
+    // Retire the oldest held frame: enough frames have been submitted since that the
+    // GPU is done with it.
+    if (held_.back()) AImage_delete(held_.back());
+    for (size_t i = held_.size() - 1; i > 0; --i) held_[i] = held_[i - 1];
+    held_[0] = static_cast<AImage*>(frame.image);
+    currentPtsUs_ = frame.ptsUs;
+    if (ptsUs) *ptsUs = frame.ptsUs;
+
+    AHardwareBuffer* buffer = nullptr;
+    if (AImage_getHardwareBuffer(held_[0], &buffer) != AMEDIA_OK) {
+        LOGW("Decoded frame has no hardware buffer");
+        return nullptr;
+    }
+    return buffer;
+}
+
+void VideoDecoder::onImageAvailable(void* context, AImageReader*) {
+    auto* self = static_cast<VideoDecoder*>(context);
+    std::lock_guard<std::mutex> lock(self->imageMutex_);
+    self->imageAvailable_.notify_all();
+}
+
+AImage* VideoDecoder::acquireImage() {
+    std::unique_lock<std::mutex> lock(imageMutex_);
+    for (int attempt = 0; attempt < kImageRetries && !quit_; ++attempt) {
+        AImage* image = nullptr;
+        if (AImageReader_acquireNextImage(reader_, &image) == AMEDIA_OK) return image;
+        imageAvailable_.wait_for(lock, kImageWait);
+    }
+    return nullptr;
+}
+
+bool VideoDecoder::feedInput() {
+    const ssize_t index = AMediaCodec_dequeueInputBuffer(codec_, 0);
+    if (index < 0) return true;
+    size_t capacity = 0;
+    uint8_t* data = AMediaCodec_getInputBuffer(codec_, static_cast<size_t>(index), &capacity);
+    const ssize_t size = data ? AMediaExtractor_readSampleData(extractor_, data, capacity) : -1;
+    if (size < 0) {
+        AMediaCodec_queueInputBuffer(codec_, static_cast<size_t>(index), 0, 0, 0,
+                                     AMEDIACODEC_BUFFER_FLAG_END_OF_STREAM);
+        return false;
+    }
+    AMediaCodec_queueInputBuffer(codec_, static_cast<size_t>(index), 0, static_cast<size_t>(size),
+                                 static_cast<uint64_t>(AMediaExtractor_getSampleTime(extractor_)), 0);
+    AMediaExtractor_advance(extractor_);
+    return true;
+}
+
+void VideoDecoder::decodeLoop() {
+    uint64_t generation = queue_.generation();
+    int64_t skipUntilUs = -1;
+    bool inputDone = false;
+    bool outputDone = false;
+
+    while (!quit_) {
+        int64_t target = -1;
+        {
+            // Taken with the generation the seek flushed to (see seek()).
+            std::lock_guard<std::mutex> lock(controlMutex_);
+            target = seekTarget_.exchange(-1);
+            if (target >= 0) generation = queue_.generation();
+        }
+        if (target >= 0) {
+            AMediaExtractor_seekTo(extractor_, target, AMEDIAEXTRACTOR_SEEK_PREVIOUS_SYNC);
+            AMediaCodec_flush(codec_);
+            skipUntilUs = target;
+            inputDone = outputDone = false;
+        }
+        if (outputDone) {
+            // Idle at end of stream until the next seek or close.
+            std::unique_lock<std::mutex> lock(controlMutex_);
+            control_.wait(lock, [&] { return quit_ || seekTarget_ >= 0; });
+            continue;
+        }
+        if (!inputDone) inputDone = !feedInput();
+
+        AMediaCodecBufferInfo info{};
+        const ssize_t index = AMediaCodec_dequeueOutputBuffer(codec_, &info, kDequeueTimeoutUs);
+        if (index == AMEDIACODEC_INFO_TRY_AGAIN_LATER || index == AMEDIACODEC_INFO_OUTPUT_FORMAT_CHANGED ||
+            index == AMEDIACODEC_INFO_OUTPUT_BUFFERS_CHANGED) {
+            continue;
+        }
+        if (index < 0) {
+            LOGE("AMediaCodec_dequeueOutputBuffer failed: %zd", index);
+            queue_.setEndOfStream(generation);
+            outputDone = true;
+            continue;
+        }
+
+        bool render = info.size > 0 && info.presentationTimeUs >= skipUntilUs;
+        // Back-pressure: keep the codec's buffer until the queue has room, so decoding
+        // never runs more than kDecodeAhead frames ahead. A seek meanwhile drops it.
+        if (render && !queue_.waitForSpace(generation)) render = false;
+        AMediaCodec_releaseOutputBuffer(codec_, static_cast<size_t>(index), render);
+        if (render) {
+            if (AImage* image = acquireImage()) {
+                int64_t timestampNs = 0;
+                AImage_getTimestamp(image, &timestampNs);
+                if (!queue_.push({image, timestampNs / 1000}, generation)) AImage_delete(image);
+            } else if (!quit_) {
+                LOGW("Decoded frame at %lld us never reached the reader",
+                     static_cast<long long>(info.presentationTimeUs));
+            }
+        }
+        if (info.flags & AMEDIACODEC_BUFFER_FLAG_END_OF_STREAM) {
+            queue_.setEndOfStream(generation);
+            outputDone = true;
+        }
+    }
+}
+
+void VideoDecoder::release(std::vector<lumina::DecodedFrame>& frames) {
+    for (const lumina::DecodedFrame& frame : frames) AImage_delete(static_cast<AImage*>(frame.image));
+    frames.clear();
+}
+
+void VideoDecoder::releaseAll() {
+    std::vector<lumina::DecodedFrame> queued;
+    queue_.flush(&queued);
+    release(queued);
+    for (AImage*& image : held_) {
+        if (image) AImage_delete(image);
+        image = nullptr;
+    }
+    currentPtsUs_ = -1;
+    if (codec_) {
+        AMediaCodec_stop(codec_);
+        AMediaCodec_delete(codec_);
+        codec_ = nullptr;
+    }
+    // Images must be gone before their reader.
+    if (reader_) {
+        AImageReader_delete(reader_);
+        reader_ = nullptr;
+    }
+    if (extractor_) {
+        AMediaExtractor_delete(extractor_);
+        extractor_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        ::close(fd_);
+        fd_ = -1;
+    }
+}
@@ -0,0 +1,105 @@
+#ifndef LUMINA_VIDEO_DECODER_H
+#define LUMINA_VIDEO_DECODER_H
+
+#include <android/hardware_buffer.h>
+#include <media/NdkImageReader.h>
+#include <media/NdkMediaCodec.h>
+#include <media/NdkMediaExtractor.h>
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+#include "video_source.h"
+
+/**
+ * Lumina Virtual Studio - Hardware video decoder
+ *
+ * AMediaExtractor feeds an AMediaCodec whose output surface belongs to an AImageReader,
+ * so decoded frames arrive as AHardwareBuffers that the renderers sample in place of the
+ * camera (EGLImage on GLES, external-memory import on Vulkan). Nothing crosses JNI and
+ * no pixel is copied on the CPU.
+ *
+ * A decode thread keeps up to kDecodeAhead frames queued ahead of the consumer. The
+ * consumer is the render thread: frameAt() for playback against a clock, nextFrame()
+ * for offline rendering as fast as the codec and GPU allow.
+ */
+
+class VideoDecoder {
+public:
+    struct Info {
+        int32_t width = 0;
+        int32_t height = 0;
+        int64_t durationUs = 0;
+    };
+
+    VideoDecoder() = default;
+    ~VideoDecoder();
+
+    VideoDecoder(const VideoDecoder&) = delete;
+    VideoDecoder& operator=(const VideoDecoder&) = delete;
+
+    // Opens the first video track of `fd` (duplicated; the caller keeps its own) and
+    // starts decoding from the beginning. `length` < 0 means to the end of the file.
+    // A decoder plays one clip: open a new one for the next.
+    bool open(int fd, int64_t offset, int64_t length);
+    void close();
+    bool isOpen() const { return codec_ != nullptr; }
+
+    const Info& info() const { return info_; }
+
+    // Drops the queued frames and restarts decoding at the sync frame before `timeUs`,
+    // skipping output until `timeUs`. The current frame stays on screen until then.
+    void seek(int64_t timeUs);
+
+    // Render thread. Newest frame due at `mediaTimeUs`, or the first frame after a seek
+    // whatever its time; otherwise the current one. Null before any frame decoded.
+    AHardwareBuffer* frameAt(int64_t mediaTimeUs, int64_t* ptsUs = nullptr);
+
+    // Render thread. The next frame in decode order, waiting up to `timeout`; null on
+    // timeout or at the end of the stream.
+    AHardwareBuffer* nextFrame(std::chrono::milliseconds timeout, int64_t* ptsUs = nullptr);
+
+    // End of stream reached and every frame handed out.
+    bool finished() const { return queue_.finished(); }
+
+private:
+    static constexpr size_t kDecodeAhead = 4;
+    // Frames already handed to the renderers that are kept alive until the GPU has
+    // finished sampling them: the current one plus one per frame in flight.
+    static constexpr size_t kHeldFrames = 3;
+
+    static void onImageAvailable(void* context, AImageReader* reader);
+
+    void decodeLoop();
+    bool feedInput();
+    AImage* acquireImage();
+    AHardwareBuffer* show(const lumina::DecodedFrame& frame, int64_t* ptsUs);
+    void release(std::vector<lumina::DecodedFrame>& frames);
+    void releaseAll();
+
+    int fd_ = -1;
+    AMediaExtractor* extractor_ = nullptr;
+    AMediaCodec* codec_ = nullptr;
+    AImageReader* reader_ = nullptr;
+    Info info_;
+
+    lumina::DecodeQueue queue_{kDecodeAhead};
+    std::thread thread_;
+    std::atomic<bool> quit_{false};
+    std::atomic<int64_t> seekTarget_{-1};
+    std::mutex controlMutex_;           // wakes the decode thread idling at end of stream
+    std::condition_variable control_;
+    std::mutex imageMutex_;             // pairs with the reader's image listener
+    std::condition_variable imageAvailable_;
+
+    // Consumer side; seek(), frameAt(), nextFrame() and close() are serialized by the caller.
+    std::array<AImage*, kHeldFrames> held_{};  // held_[0] is the current frame
+    int64_t currentPtsUs_ = -1;
+    bool awaitingSeek_ = false;
+};
+
+#endif // LUMINA_VIDEO_DECODER_H
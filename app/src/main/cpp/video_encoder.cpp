@@ -0,0 +1,182 @@
+#include "video_encoder.h"
+
+#include <android/log.h>
+#include <fcntl.h>
+#include <media/NdkMediaFormat.h>
+#include <unistd.h>
+
+#define LOG_TAG "LuminaEncoder"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+constexpr const char* kMimeType = "video/avc";
+constexpr int32_t kColorFormatSurface = 0x7F000789;  // MediaCodecInfo.CodecCapabilities.COLOR_FormatSurface
+constexpr int64_t kDequeueTimeoutUs = 10000;
+// After end of stream the codec flushes within a few frames; give up after ~2 s
+// rather than hang stop() on a wedged codec.
+constexpr int kEndOfStreamRetries = 200;
+
+} // namespace
+
+VideoEncoder::~VideoEncoder() {
+    stop();
+}
+
+bool VideoEncoder::start(const std::string& path, const lumina::RecordingConfig& config) {
+    if (codec_) {
+        LOGW("Encoder already running");
+        return false;
+    }
+    if (!lumina::isValidRecordingConfig(config)) {
+        LOGE("Invalid recording config %dx%d @ %d fps", config.width, config.height, config.frameRate);
+        return false;
+    }
+
+    const int32_t bitRate = config.bitRate > 0
+        ? config.bitRate
+        : lumina::defaultRecordingBitRate(config.width, config.height, config.frameRate);
+
+    AMediaFormat* format = AMediaFormat_new();
+    AMediaFormat_setString(format, AMEDIAFORMAT_KEY_MIME, kMimeType);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_WIDTH, config.width);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_HEIGHT, config.height);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_COLOR_FORMAT, kColorFormatSurface);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_BIT_RATE, bitRate);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_FRAME_RATE, config.frameRate);
+    AMediaFormat_setInt32(format, AMEDIAFORMAT_KEY_I_FRAME_INTERVAL, config.keyFrameInterval);
+
+    codec_ = AMediaCodec_createEncoderByType(kMimeType);
+    media_status_t status = codec_
+        ? AMediaCodec_configure(codec_, format, nullptr, nullptr, AMEDIACODEC_CONFIGURE_FLAG_ENCODE)
+        : AMEDIA_ERROR_UNSUPPORTED;
+    AMediaFormat_delete(format);
+    if (status != AMEDIA_OK) {
+        LOGE("Failed to configure %s encoder for %dx%d: %d", kMimeType, config.width, config.height, status);
+        release();
+        return false;
+    }
+
+    if (AMediaCodec_createInputSurface(codec_, &window_) != AMEDIA_OK || !window_) {
+        LOGE("AMediaCodec_createInputSurface failed");
+        release();
+        return false;
+    }
+
+    // MPEG-4 finalization seeks back into the file, so it needs read/write access.
+    fd_ = open(path.c_str(), O_CREAT | O_TRUNC | O_RDWR | O_CLOEXEC, 0644);
+    if (fd_ < 0) {
+        LOGE("Cannot open %s for recording", path.c_str());
+        release();
+        return false;
+    }
+    muxer_ = AMediaMuxer_new(fd_, AMEDIAMUXER_OUTPUT_FORMAT_MPEG_4);
+    if (!muxer_ || AMediaCodec_start(codec_) != AMEDIA_OK) {
+        LOGE("Failed to start the encoder for %s", path.c_str());
+        release();
+        return false;
+    }
+
+    track_ = -1;
+    muxerStarted_ = false;
+    failed_ = false;
+    firstTimestampUs_ = -1;
+    framesWritten_ = 0;
+    endOfStream_ = false;
+    drainThread_ = std::thread(&VideoEncoder::drainLoop, this);
+
+    LOGI("Recording %dx%d @ %d fps, %d bit/s to %s", config.width, config.height, config.frameRate, bitRate,
+         path.c_str());
+    return true;
+}
+
+bool VideoEncoder::stop() {
+    if (!codec_) return false;
+
+    if (drainThread_.joinable()) {
+        if (AMediaCodec_signalEndOfInputStream(codec_) != AMEDIA_OK) {
+            LOGW("AMediaCodec_signalEndOfInputStream failed");
+        }
+        endOfStream_ = true;
+        drainThread_.join();
+    }
+
+    bool ok = muxerStarted_ && framesWritten_ > 0 && !failed_;
+    if (muxerStarted_ && AMediaMuxer_stop(muxer_) != AMEDIA_OK) {
+        LOGE("AMediaMuxer_stop failed");
+        ok = false;
+    }
+    LOGI("Recording finished: %lld frames", static_cast<long long>(framesWritten_));
+    release();
+    return ok;
+}
+
+void VideoEncoder::drainLoop() {
+    int idle = 0;
+    while (true) {
+        AMediaCodecBufferInfo info{};
+        const ssize_t index = AMediaCodec_dequeueOutputBuffer(codec_, &info, kDequeueTimeoutUs);
+        if (index == AMEDIACODEC_INFO_TRY_AGAIN_LATER) {
+            if (endOfStream_.load() && ++idle > kEndOfStreamRetries) {
+                LOGW("Encoder did not flush; finishing without end of stream");
+                break;
+            }
+            continue;
+        }
+        if (index == AMEDIACODEC_INFO_OUTPUT_FORMAT_CHANGED) {
+            // Arrives once, before the first frame, carrying the codec config (SPS/PPS).
+            AMediaFormat* format = AMediaCodec_getOutputFormat(codec_);
+            if (!muxerStarted_) {
+                track_ = AMediaMuxer_addTrack(muxer_, format);
+                muxerStarted_ = track_ >= 0 && AMediaMuxer_start(muxer_) == AMEDIA_OK;
+                if (!muxerStarted_) {
+                    LOGE("Failed to start the muxer");
+                    failed_ = true;
+                }
+            }
+            AMediaFormat_delete(format);
+            continue;
+        }
+        if (index == AMEDIACODEC_INFO_OUTPUT_BUFFERS_CHANGED) continue;
+        if (index < 0) {
+            LOGE("AMediaCodec_dequeueOutputBuffer failed: %zd", index);
+            failed_ = true;
+            break;
+        }
+
+        size_t capacity = 0;
+        uint8_t* data = AMediaCodec_getOutputBuffer(codec_, static_cast<size_t>(index), &capacity);
+        const bool codecConfig = (info.flags & AMEDIACODEC_BUFFER_FLAG_CODEC_CONFIG) != 0;
+        if (data && !codecConfig && info.size > 0 && muxerStarted_) {
+            if (firstTimestampUs_ < 0) firstTimestampUs_ = info.presentationTimeUs;
+            info.presentationTimeUs -= firstTimestampUs_;
+            if (AMediaMuxer_writeSampleData(muxer_, static_cast<size_t>(track_), data, &info) == AMEDIA_OK) {
+                ++framesWritten_;
+            }
+        }
+        AMediaCodec_releaseOutputBuffer(codec_, static_cast<size_t>(index), false);
+        if (info.flags & AMEDIACODEC_BUFFER_FLAG_END_OF_STREAM) break;
+    }
+}
+
+void VideoEncoder::release() {
+    if (muxer_) {
+        AMediaMuxer_delete(muxer_);
+        muxer_ = nullptr;
+    }
+    if (codec_) {
+        AMediaCodec_stop(codec_);
+        AMediaCodec_delete(codec_);
+        codec_ = nullptr;
+    }
+    if (window_) {
+        ANativeWindow_release(window_);
+        window_ = nullptr;
+    }
+    if (fd_ >= 0) {
+        close(fd_);
+        fd_ = -1;
+    }
+}
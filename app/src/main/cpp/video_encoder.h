@@ -0,0 +1,65 @@
+#ifndef LUMINA_VIDEO_ENCODER_H
+#define LUMINA_VIDEO_ENCODER_H
+
+#include <android/native_window.h>
+#include <media/NdkMediaCodec.h>
+#include <media/NdkMediaMuxer.h>
+
+#include <atomic>
+#include <string>
+#include <thread>
+
+#include "recording.h"
+
+/**
+ * Lumina Virtual Studio - Hardware video encoder
+ *
+ * An H.264 AMediaCodec fed through its input surface, with its output written to an
+ * MP4 by AMediaMuxer on a drain thread. The engine renders into inputWindow() like
+ * any other window, so recorded frames never leave GPU memory before the encoder
+ * reads them: no readback, no extra copies.
+ *
+ * Frame timestamps come from the producer (eglPresentationTimeANDROID or the
+ * swapchain's present time); the file starts at the first encoded frame.
+ */
+
+class VideoEncoder {
+public:
+    VideoEncoder() = default;
+    ~VideoEncoder();
+
+    VideoEncoder(const VideoEncoder&) = delete;
+    VideoEncoder& operator=(const VideoEncoder&) = delete;
+
+    // Creates the codec, its input surface and the output file, then starts draining.
+    bool start(const std::string& path, const lumina::RecordingConfig& config);
+
+    // Signals end of stream, waits for the encoder to flush and finalizes the file.
+    // Stop rendering into inputWindow() first. Returns false if the file is unusable.
+    bool stop();
+
+    bool isRunning() const { return codec_ != nullptr; }
+
+    // Owned by the encoder and valid until stop(); producers take their own reference.
+    ANativeWindow* inputWindow() const { return window_; }
+
+private:
+    void drainLoop();
+    void release();
+
+    AMediaCodec* codec_ = nullptr;
+    AMediaMuxer* muxer_ = nullptr;
+    ANativeWindow* window_ = nullptr;
+    int fd_ = -1;
+    std::thread drainThread_;
+    std::atomic<bool> endOfStream_{false};  // stop() has signalled the codec
+
+    // Drain thread only until it has been joined.
+    ssize_t track_ = -1;
+    bool muxerStarted_ = false;
+    bool failed_ = false;
+    int64_t firstTimestampUs_ = -1;
+    int64_t framesWritten_ = 0;
+};
+
+#endif // LUMINA_VIDEO_ENCODER_H
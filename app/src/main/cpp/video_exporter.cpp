@@ -0,0 +1,229 @@
+#include "video_exporter.h"
+
+#include <android/log.h>
+
+#include <cstring>
+
+#include "trace.h"
+
+#define LOG_TAG "LuminaExport"
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+namespace {
+
+constexpr auto kFrameWait = std::chrono::milliseconds(100);
+// A decoder that produces nothing for this long with frames still to come is wedged.
+constexpr int kMaxFrameWaits = 50;
+constexpr GLuint64 kFenceTimeoutNs = 2000000000ull;
+
+} // namespace
+
+VideoExporter::~VideoExporter() {
+    cancel();
+    if (window_) ANativeWindow_release(window_);
+}
+
+bool VideoExporter::start(int fd, int64_t offset, int64_t length, const lumina::LuminaState& state,
+                          const std::string& path, const lumina::RecordingConfig& config) {
+    if (thread_.joinable()) return false;
+    auto encoder = std::make_unique<VideoEncoder>();
+    if (!encoder->start(path, config)) return false;
+    ANativeWindow* window = encoder->inputWindow();
+    ANativeWindow_acquire(window);
+    encoder_ = std::move(encoder);
+    if (!start(fd, offset, length, state, window)) {
+        encoder_->stop();
+        encoder_.reset();
+        return false;
+    }
+    return true;
+}
+
+bool VideoExporter::start(int fd, int64_t offset, int64_t length, const lumina::LuminaState& state,
+                          ANativeWindow* window) {
+    if (thread_.joinable() || !window) {
+        if (window) ANativeWindow_release(window);
+        return false;
+    }
+    if (window_) ANativeWindow_release(window_);
+    window_ = window;
+    if (!decoder_.open(fd, offset, length)) return false;
+
+    state_ = state;
+    durationUs_ = decoder_.info().durationUs;
+    cancel_ = false;
+    succeeded_ = false;
+    framesRendered_ = 0;
+    positionUs_ = 0;
+    running_ = true;
+    thread_ = std::thread(&VideoExporter::run, this);
+    return true;
+}
+
+void VideoExporter::cancel() {
+    cancel_ = true;
+    if (thread_.joinable()) thread_.join();
+}
+
+lumina::ExportProgress VideoExporter::progress() const {
+    lumina::ExportProgress progress;
+    progress.framesRendered = framesRendered_.load();
+    progress.positionUs = positionUs_.load();
+    progress.durationUs = durationUs_;
+    progress.running = running_.load();
+    progress.succeeded = succeeded_.load();
+    return progress;
+}
+
+void VideoExporter::run() {
+    LUMINA_TRACE_SCOPE("Lumina::export");
+    bool ok = setUpGl();
+    lumina::RecordingClock clock;
+    int waits = 0;
+    size_t fenceSlot = 0;
+
+    while (ok && !cancel_) {
+        // Bound the frames queued on the GPU before taking a new decoded frame, which
+        // hands an older one back to the codec.
+        GLsync& fence = fences_[fenceSlot];
+        if (fence) {
+            LUMINA_TRACE_SCOPE("Lumina::exportWaitGpu");
+            glClientWaitSync(fence, GL_SYNC_FLUSH_COMMANDS_BIT, kFenceTimeoutNs);
+            glDeleteSync(fence);
+            fence = nullptr;
+        }
+
+        int64_t ptsUs = 0;
+        AHardwareBuffer* buffer = decoder_.nextFrame(kFrameWait, &ptsUs);
+        if (!buffer) {
+            if (decoder_.finished()) break;
+            if (++waits > kMaxFrameWaits) {
+                LOGE("Decoder stalled at %lld us", static_cast<long long>(positionUs_.load()));
+                ok = false;
+            }
+            continue;
+        }
+        waits = 0;
+
+        int64_t timestampNs = 0;
+        if (!clock.next(ptsUs * 1000, &timestampNs)) continue;
+        ok = renderFrame(buffer, ptsUs, timestampNs);
+        fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+        fenceSlot = (fenceSlot + 1) % fences_.size();
+    }
+
+    const bool completed = ok && !cancel_;
+    tearDownGl();
+    decoder_.close();
+    // The encoder finalizes the file only after nothing renders into its surface.
+    bool written = true;
+    if (encoder_) {
+        written = encoder_->stop();
+        encoder_.reset();
+    }
+    LOGI("Export %s after %lld frames", completed && written ? "finished" : cancel_ ? "cancelled" : "failed",
+         static_cast<long long>(framesRendered_.load()));
+    succeeded_ = completed && written;
+    running_ = false;
+}
+
+bool VideoExporter::renderFrame(AHardwareBuffer* buffer, int64_t ptsUs, int64_t timestampNs) {
+    LUMINA_TRACE_SCOPE("Lumina::exportFrame");
+    // Time-dependent effects follow the clip, not the wall clock.
+    const float seconds = static_cast<float>(ptsUs) / 1e6f;
+    state_.timing.deltaTime = seconds - state_.timing.totalTime;
+    state_.timing.totalTime = seconds;
+
+    if (!renderer_->setInputHardwareBuffer(buffer)) return false;
+    glBindFramebuffer(GL_FRAMEBUFFER, 0);
+    if (!renderer_->render(state_)) {
+        LOGE("Render failed at %lld us", static_cast<long long>(ptsUs));
+        return false;
+    }
+    presentationTime_(display_, surface_, static_cast<EGLnsecsANDROID>(timestampNs));
+    if (!eglSwapBuffers(display_, surface_)) {
+        LOGE("eglSwapBuffers (export) failed: 0x%x", eglGetError());
+        return false;
+    }
+    framesRendered_.fetch_add(1);
+    positionUs_ = ptsUs;
+    return true;
+}
+
+bool VideoExporter::setUpGl() {
+    display_ = eglGetDisplay(EGL_DEFAULT_DISPLAY);
+    if (display_ == EGL_NO_DISPLAY || !eglInitialize(display_, nullptr, nullptr)) {
+        LOGE("eglInitialize (export) failed: 0x%x", eglGetError());
+        return false;
+    }
+    const char* extensions = eglQueryString(display_, EGL_EXTENSIONS);
+    if (extensions && std::strstr(extensions, "EGL_ANDROID_presentation_time")) {
+        presentationTime_ = reinterpret_cast<PFNEGLPRESENTATIONTIMEANDROIDPROC>(
+            eglGetProcAddress("eglPresentationTimeANDROID"));
+    }
+    if (!presentationTime_) {
+        // Without it every frame would be stamped with its render time.
+        LOGE("EGL_ANDROID_presentation_time is required for export");
+        return false;
+    }
+
+    const EGLint attribs[] = {
+        EGL_RENDERABLE_TYPE, EGL_OPENGL_ES3_BIT,
+        EGL_SURFACE_TYPE, EGL_WINDOW_BIT,
+        EGL_RED_SIZE, 8,
+        EGL_GREEN_SIZE, 8,
+        EGL_BLUE_SIZE, 8,
+        EGL_ALPHA_SIZE, 8,
+        EGL_RECORDABLE_ANDROID, EGL_TRUE,
+        EGL_NONE
+    };
+    EGLConfig config = nullptr;
+    EGLint numConfigs = 0;
+    if (!eglChooseConfig(display_, attribs, &config, 1, &numConfigs) || numConfigs < 1) {
+        LOGE("No recordable EGL config for export");
+        return false;
+    }
+    const EGLint contextAttribs[] = { EGL_CONTEXT_CLIENT_VERSION, 3, EGL_NONE };
+    context_ = eglCreateContext(display_, config, EGL_NO_CONTEXT, contextAttribs);
+    surface_ = context_ != EGL_NO_CONTEXT ? eglCreateWindowSurface(display_, config, window_, nullptr)
+                                          : EGL_NO_SURFACE;
+    if (surface_ == EGL_NO_SURFACE || !eglMakeCurrent(display_, surface_, surface_, context_)) {
+        LOGE("Cannot render into the export surface: 0x%x", eglGetError());
+        return false;
+    }
+    // The output is a queue for the encoder, not a display.
+    eglSwapInterval(display_, 0);
+
+    EGLint width = 0;
+    EGLint height = 0;
+    eglQuerySurface(display_, surface_, EGL_WIDTH, &width);
+    eglQuerySurface(display_, surface_, EGL_HEIGHT, &height);
+    renderer_ = std::make_unique<GLRenderer>();
+    renderer_->initialize();
+    renderer_->onSurfaceSize(width, height);
+    LOGI("Exporting %lld us of video at %dx%d", static_cast<long long>(durationUs_), width, height);
+    return true;
+}
+
+void VideoExporter::tearDownGl() {
+    if (context_ != EGL_NO_CONTEXT && surface_ != EGL_NO_SURFACE) {
+        eglMakeCurrent(display_, surface_, surface_, context_);
+        for (GLsync& fence : fences_) {
+            if (fence) glDeleteSync(fence);
+            fence = nullptr;
+        }
+        if (renderer_) renderer_->destroy();
+    }
+    renderer_.reset();
+    if (display_ != EGL_NO_DISPLAY) {
+        eglMakeCurrent(display_, EGL_NO_SURFACE, EGL_NO_SURFACE, EGL_NO_CONTEXT);
+        if (surface_ != EGL_NO_SURFACE) eglDestroySurface(display_, surface_);
+        if (context_ != EGL_NO_CONTEXT) eglDestroyContext(display_, context_);
+        // The display is shared with the preview; it is not ours to terminate.
+    }
+    surface_ = EGL_NO_SURFACE;
+    context_ = EGL_NO_CONTEXT;
+    display_ = EGL_NO_DISPLAY;
+}
@@ -0,0 +1,89 @@
+#ifndef LUMINA_VIDEO_EXPORTER_H
+#define LUMINA_VIDEO_EXPORTER_H
+
+#include <EGL/egl.h>
+#include <EGL/eglext.h>
+#include <GLES3/gl3.h>
+#include <android/native_window.h>
+
+#include <array>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+
+#include "engine_structs.h"
+#include "recording.h"
+#include "renderer_gles.h"
+#include "video_decoder.h"
+#include "video_encoder.h"
+
+/**
+ * Lumina Virtual Studio - Offline export
+ *
+ * Renders a whole clip through a fixed effect state on a thread of its own, with its
+ * own decoder and GL context, drawing straight into the output window: the input
+ * surface of the native encoder, or a caller's surface (its own MediaCodec, or an
+ * ImageReader for per-frame callbacks). Nothing waits for vsync: the render loop is
+ * paced only by decode-ahead, GPU fences (kFramesInFlight frames queued) and the
+ * encoder handing buffers back, so a minute of video takes as long as the slowest of
+ * the three needs. Each frame carries its media timestamp via eglPresentationTimeANDROID.
+ *
+ * The live preview keeps running on the engine's render thread and either backend.
+ */
+
+class VideoExporter {
+public:
+    VideoExporter() = default;
+    ~VideoExporter();
+
+    VideoExporter(const VideoExporter&) = delete;
+    VideoExporter& operator=(const VideoExporter&) = delete;
+
+    // Exports the clip in `fd` (see VideoDecoder::open) as H.264 into an MP4 at `path`.
+    // One export per exporter; progress() stays readable after it ends.
+    bool start(int fd, int64_t offset, int64_t length, const lumina::LuminaState& state,
+               const std::string& path, const lumina::RecordingConfig& config);
+
+    // Same into `window`, sized by the window; takes over the reference.
+    bool start(int fd, int64_t offset, int64_t length, const lumina::LuminaState& state,
+               ANativeWindow* window);
+
+    // Stops after the frame in progress and waits; a file keeps what was rendered.
+    void cancel();
+
+    lumina::ExportProgress progress() const;
+
+private:
+    // The decoder recycles a frame once kHeldFrames newer ones were taken, so the GPU
+    // may run at most kHeldFrames - 1 frames behind.
+    static constexpr size_t kFramesInFlight = 2;
+
+    void run();
+    bool setUpGl();
+    void tearDownGl();
+    bool renderFrame(AHardwareBuffer* buffer, int64_t ptsUs, int64_t timestampNs);
+
+    VideoDecoder decoder_;
+    std::unique_ptr<VideoEncoder> encoder_;   // for file exports
+    ANativeWindow* window_ = nullptr;         // output; referenced
+    lumina::LuminaState state_;
+    int64_t durationUs_ = 0;
+
+    std::thread thread_;
+    std::atomic<bool> cancel_{false};
+    std::atomic<bool> running_{false};
+    std::atomic<bool> succeeded_{false};
+    std::atomic<int64_t> framesRendered_{0};
+    std::atomic<int64_t> positionUs_{0};
+
+    // Export thread only.
+    EGLDisplay display_ = EGL_NO_DISPLAY;
+    EGLContext context_ = EGL_NO_CONTEXT;
+    EGLSurface surface_ = EGL_NO_SURFACE;
+    PFNEGLPRESENTATIONTIMEANDROIDPROC presentationTime_ = nullptr;
+    std::unique_ptr<GLRenderer> renderer_;
+    std::array<GLsync, kFramesInFlight> fences_{};
+};
+
+#endif // LUMINA_VIDEO_EXPORTER_H
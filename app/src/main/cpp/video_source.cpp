@@ -0,0 +1,114 @@
+#include "video_source.h"
+
+namespace lumina {
+
+namespace {
+
+// Producer waits are untimed in effect; the slices only bound each condition wait.
+constexpr auto kWaitSlice = std::chrono::milliseconds(100);
+
+} // namespace
+
+bool DecodeQueue::waitForSpaceLocked(std::unique_lock<std::mutex>& lock, uint64_t generation) {
+    const auto ready = [&] { return closed_ || generation != generation_ || frames_.size() < capacity_; };
+    while (!changed_.wait_for(lock, kWaitSlice, ready)) {}
+    return !closed_ && generation == generation_;
+}
+
+bool DecodeQueue::waitForSpace(uint64_t generation) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    return waitForSpaceLocked(lock, generation);
+}
+
+bool DecodeQueue::push(const DecodedFrame& frame, uint64_t generation) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!waitForSpaceLocked(lock, generation)) return false;
+    frames_.push_back(frame);
+    changed_.notify_all();
+    return true;
+}
+
+void DecodeQueue::setEndOfStream(uint64_t generation) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (generation != generation_) return;
+    endOfStream_ = true;
+    changed_.notify_all();
+}
+
+bool DecodeQueue::popDue(int64_t mediaTimeUs, DecodedFrame* frame, std::vector<DecodedFrame>* dropped) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (frames_.empty() || frames_.front().ptsUs > mediaTimeUs) return false;
+    while (frames_.size() > 1 && frames_[1].ptsUs <= mediaTimeUs) {
+        if (dropped) dropped->push_back(frames_.front());
+        frames_.pop_front();
+    }
+    *frame = frames_.front();
+    frames_.pop_front();
+    changed_.notify_all();
+    return true;
+}
+
+bool DecodeQueue::popNext(DecodedFrame* frame, std::chrono::milliseconds timeout) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!changed_.wait_for(lock, timeout, [&] { return !frames_.empty() || endOfStream_ || closed_; }) ||
+        frames_.empty()) {
+        return false;
+    }
+    *frame = frames_.front();
+    frames_.pop_front();
+    changed_.notify_all();
+    return true;
+}
+
+uint64_t DecodeQueue::flush(std::vector<DecodedFrame>* dropped) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (dropped) dropped->insert(dropped->end(), frames_.begin(), frames_.end());
+    frames_.clear();
+    endOfStream_ = false;
+    ++generation_;
+    changed_.notify_all();
+    return generation_;
+}
+
+void DecodeQueue::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    closed_ = true;
+    changed_.notify_all();
+}
+
+uint64_t DecodeQueue::generation() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return generation_;
+}
+
+size_t DecodeQueue::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return frames_.size();
+}
+
+bool DecodeQueue::finished() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return endOfStream_ && frames_.empty();
+}
+
+void PlaybackClock::seek(int64_t mediaTimeUs) {
+    positionUs_ = anchorMediaUs_ = mediaTimeUs;
+    anchorFrameNs_ = -1;
+}
+
+void PlaybackClock::setPlaying(bool playing) {
+    if (playing == playing_) return;
+    playing_ = playing;
+    // Resume from (or hold) wherever the last frame was.
+    anchorMediaUs_ = positionUs_;
+    anchorFrameNs_ = -1;
+}
+
+int64_t PlaybackClock::mediaTimeUs(int64_t frameTimeNs) {
+    if (!playing_) return positionUs_;
+    if (anchorFrameNs_ < 0 || frameTimeNs < anchorFrameNs_) anchorFrameNs_ = frameTimeNs;
+    positionUs_ = anchorMediaUs_ + (frameTimeNs - anchorFrameNs_) / 1000;
+    return positionUs_;
+}
+
+} // namespace lumina
@@ -0,0 +1,116 @@
+#ifndef LUMINA_VIDEO_SOURCE_H
+#define LUMINA_VIDEO_SOURCE_H
+
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <vector>
+
+/**
+ * Lumina Virtual Studio - Video input source
+ *
+ * Besides the live camera, the renderers can take their input from a clip decoded
+ * natively (video_decoder.h) into hardware buffers. This header holds the platform-free
+ * parts of that path: the bounded queue between the decode thread and the render
+ * thread, and the clock that maps display frames to media time.
+ */
+
+namespace lumina {
+
+enum class SourceMode : uint32_t {
+    CAMERA = 0,
+    VIDEO = 1,
+};
+
+struct VideoSourceInfo {
+    int32_t width = 0;
+    int32_t height = 0;
+    int64_t durationUs = 0;
+    int64_t positionUs = 0;
+    bool playing = false;
+    bool ended = false;   // every frame has been shown
+};
+
+struct DecodedFrame {
+    void* image = nullptr;  // opaque to the queue (an AImage on device)
+    int64_t ptsUs = 0;
+};
+
+/**
+ * Decode-ahead queue. The producer blocks while `capacity` frames are waiting, which
+ * bounds how far decoding runs ahead and how many decoder buffers are held. flush()
+ * (on seek) starts a new generation: frames of an older generation are refused, and a
+ * producer blocked on a full queue is released. Frames removed from the queue without
+ * being handed to the consumer go to the caller's `dropped` list for releasing.
+ */
+class DecodeQueue {
+public:
+    explicit DecodeQueue(size_t capacity) : capacity_(capacity ? capacity : 1) {}
+
+    // Producer. Both return false once `generation` is stale or the queue is closed;
+    // a refused frame remains the caller's.
+    bool waitForSpace(uint64_t generation);
+    bool push(const DecodedFrame& frame, uint64_t generation);
+    void setEndOfStream(uint64_t generation);
+
+    /**
+     * Consumer, real time: the newest frame presented at or before `mediaTimeUs`. Older
+     * due frames were never shown and are appended to `dropped`. False when none is due.
+     */
+    bool popDue(int64_t mediaTimeUs, DecodedFrame* frame, std::vector<DecodedFrame>* dropped);
+
+    /** Consumer, offline: the next frame in order, waiting up to `timeout` for it. */
+    bool popNext(DecodedFrame* frame, std::chrono::milliseconds timeout);
+
+    /** Empties the queue into `dropped` and returns the new generation. */
+    uint64_t flush(std::vector<DecodedFrame>* dropped);
+
+    /** Wakes and refuses producers from now on; queued frames stay for flush(). */
+    void close();
+
+    uint64_t generation() const;
+    size_t size() const;
+    // End of stream reached in the current generation and every frame handed out.
+    bool finished() const;
+
+private:
+    bool waitForSpaceLocked(std::unique_lock<std::mutex>& lock, uint64_t generation);
+
+    const size_t capacity_;
+    mutable std::mutex mutex_;
+    std::condition_variable changed_;
+    std::deque<DecodedFrame> frames_;
+    uint64_t generation_ = 0;
+    bool endOfStream_ = false;
+    bool closed_ = false;
+};
+
+/**
+ * Media time for each display frame. While playing, time advances with the frame
+ * times passed to mediaTimeUs(), starting from the first frame after play or seek, so
+ * a stall before that frame does not skip video. Not thread-safe.
+ */
+class PlaybackClock {
+public:
+    void seek(int64_t mediaTimeUs);
+    void setPlaying(bool playing);
+    bool playing() const { return playing_; }
+
+    int64_t mediaTimeUs(int64_t frameTimeNs);
+
+    // Last value returned by mediaTimeUs(), or the seek target since.
+    int64_t positionUs() const { return positionUs_; }
+
+private:
+    bool playing_ = false;
+    int64_t positionUs_ = 0;
+    int64_t anchorMediaUs_ = 0;
+    int64_t anchorFrameNs_ = -1;  // -1: anchor at the next frame
+};
+
+} // namespace lumina
+
+#endif // LUMINA_VIDEO_SOURCE_H
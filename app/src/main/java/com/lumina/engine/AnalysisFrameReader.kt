@@ -0,0 +1,74 @@
+package com.lumina.engine
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Downsampled camera frames rendered by the native engine for on-device ML
+ * (analysis_frame.h), enabled with [INativeEngine.setAnalysisOutput].
+ *
+ * The GPU produces them a frame or two behind the display and native code keeps only
+ * the newest one, so a slow consumer sees fewer frames rather than older ones. Pixels
+ * are copied into one direct buffer owned by the reader, which only reallocates when
+ * the frame size grows: a returned [Frame] is valid until the next [read].
+ */
+class AnalysisFrameReader(private val backend: Backend) {
+    /** The JNI surface of the reader; faked in unit tests. */
+    interface Backend {
+        /**
+         * Copies the newest unread frame into [buffer] and returns its size, or 0 when
+         * there is none or it does not fit. Either way [info] describes the newest frame
+         * as [INFO_WIDTH] .. [INFO_TIMESTAMP].
+         */
+        fun read(buffer: ByteBuffer?, info: LongArray): Int
+    }
+
+    /** Tightly packed rows, top first: RGB (3 bytes per pixel) or luma (1 byte). */
+    class Frame internal constructor(
+        val width: Int,
+        val height: Int,
+        val grayscale: Boolean,
+        val frameNumber: Long,
+        val timestampNanos: Long,
+        val pixels: ByteBuffer
+    )
+
+    companion object {
+        const val INFO_WIDTH = 0
+        const val INFO_HEIGHT = 1
+        const val INFO_FORMAT = 2      // lumina::AnalysisFormat: 0 RGB, 1 GRAY
+        const val INFO_FRAME_NUMBER = 3
+        const val INFO_TIMESTAMP = 4
+        const val INFO_SIZE = 5
+
+        const val FORMAT_GRAY = 1L
+    }
+
+    private val info = LongArray(INFO_SIZE)
+    private var buffer: ByteBuffer? = null
+
+    /** Returns the newest frame not read yet, or null when there is none. */
+    @Synchronized
+    fun read(): Frame? {
+        var size = backend.read(buffer, info)
+        if (size == 0) {
+            val bytesPerPixel = if (info[INFO_FORMAT] == FORMAT_GRAY) 1 else 3
+            val needed = info[INFO_WIDTH] * info[INFO_HEIGHT] * bytesPerPixel
+            if (needed <= (buffer?.capacity() ?: 0)) return null
+            buffer = ByteBuffer.allocateDirect(needed.toInt()).order(ByteOrder.nativeOrder())
+            size = backend.read(buffer, info)
+            if (size == 0) return null
+        }
+        val pixels = buffer ?: return null
+        pixels.clear()
+        pixels.limit(size)
+        return Frame(
+            width = info[INFO_WIDTH].toInt(),
+            height = info[INFO_HEIGHT].toInt(),
+            grayscale = info[INFO_FORMAT] == FORMAT_GRAY,
+            frameNumber = info[INFO_FRAME_NUMBER],
+            timestampNanos = info[INFO_TIMESTAMP],
+            pixels = pixels
+        )
+    }
+}
@@ -1,24 +1,67 @@
 package com.lumina.engine
 
+import android.graphics.ImageFormat
+import android.hardware.HardwareBuffer
+import androidx.annotation.OptIn
+import androidx.camera.core.ExperimentalGetImage
 import androidx.camera.core.ImageAnalysis
 import androidx.camera.core.ImageProxy
 import java.nio.ByteBuffer
 import java.nio.ByteOrder
-import com.lumina.engine.DirectBufferPool
 
 /**
- * Optimized analyzer that reuses a single DirectByteBuffer to avoid
- * garbage collection stutter during high-speed frame processing.
+ * Optimized analyzer that reuses its frame memory to avoid garbage collection stutter
+ * during high-speed frame processing.
+ *
+ * When [onHardwareBuffer] is provided, the frame's HardwareBuffer is offered first so the
+ * renderer can import it without a CPU copy; the ByteBuffer path is used if it declines.
+ * An imported frame stays open until [releasedHardwareBuffers] reports its token, since
+ * closing it returns the buffer to the camera while the GPU may still be sampling it. At
+ * most [MAX_HELD_IMAGES] are held so the camera, bound with [IMAGE_QUEUE_DEPTH], always
+ * has one to deliver; frames beyond that take the copy paths.
+ *
+ * YUV_420_888 frames go to [onYuvFrame] with their planes untouched, so native code can
+ * convert them straight into GPU staging memory. The RGBA copy below would only forward
+ * the luma plane, so a YUV frame the callback declines is dropped.
+ *
+ * Other frames are copied into one of [framePool]'s native slots and submitted from
+ * there, so the copy is never overwritten while the upload reads it; a frame that finds
+ * every slot out is dropped. Without a pool the copy goes to [onFrameCaptured] in a
+ * single reused direct buffer.
  */
 class CachingImageAnalyzer(
+    private val onHardwareBuffer: ((HardwareBuffer) -> Long)? = null,
+    private val releasedHardwareBuffers: () -> Long = { Long.MAX_VALUE },
+    private val onYuvFrame: ((ImageProxy) -> Boolean)? = null,
+    private val framePool: FrameSlotPool? = null,
     private val onFrameCaptured: (ByteBuffer, Int, Int) -> Unit
 ) : ImageAnalysis.Analyzer {
 
+    companion object {
+        /** Analysis queue depth the camera must be bound with for images to be held. */
+        const val IMAGE_QUEUE_DEPTH = 4
+        const val MAX_HELD_IMAGES = IMAGE_QUEUE_DEPTH - 1
+    }
+
     // Persistent buffer to avoid allocation every frame
     private var cachedBuffer: ByteBuffer? = null
 
+    // Imported frames the renderer may still sample, oldest first, with their tokens
+    private val heldImages = ArrayDeque<Pair<Long, ImageProxy>>()
+
     override fun analyze(image: ImageProxy) {
+        var held = false
         try {
+            closeReleasedImages()
+            if (tryHardwareBuffer(image)) {
+                held = true
+                return
+            }
+            if (onYuvFrame != null && image.format == ImageFormat.YUV_420_888) {
+                onYuvFrame.invoke(image)
+                return
+            }
+
             val plane = image.planes[0]
             val source = plane.buffer
             val width = image.width
@@ -27,10 +70,21 @@ class CachingImageAnalyzer(
             // CameraX guarantees the plane buffer covers the image for RGBA_8888
             val requiredSize = source.remaining()
 
+            if (framePool != null) {
+                val slot = framePool.acquire(requiredSize) ?: return
+                try {
+                    slot.buffer.put(source)
+                } catch (e: Exception) {
+                    framePool.release(slot)
+                    throw e
+                }
+                framePool.submit(slot, width, height)
+                return
+            }
+
             // Allocate only if needed (first run or resolution change)
             if (cachedBuffer == null || cachedBuffer!!.capacity() < requiredSize) {
-                // Prefer pool allocation; fall back to direct if necessary
-                cachedBuffer = DirectBufferPool.getDirectBuffer(requiredSize)
+                cachedBuffer = ByteBuffer.allocateDirect(requiredSize).order(ByteOrder.nativeOrder())
             }
 
             // Clear previous data and reuse the buffer
@@ -47,8 +101,37 @@ class CachingImageAnalyzer(
         } catch (e: Exception) {
             e.printStackTrace()
         } finally {
-            // Critical: close the frame so CameraX produces the next one
-            image.close()
+            // Critical: close the frame so CameraX produces the next one; a held frame is
+            // closed once the renderer is done with it
+            if (!held) image.close()
         }
     }
+
+    /** Closes every held frame; call once this analyzer is detached from the camera. */
+    fun releaseHeldImages() {
+        synchronized(heldImages) {
+            while (heldImages.isNotEmpty()) heldImages.removeFirst().second.close()
+        }
+    }
+
+    private fun closeReleasedImages() {
+        val released = releasedHardwareBuffers()
+        synchronized(heldImages) {
+            while (heldImages.isNotEmpty() && heldImages.first().first <= released) {
+                heldImages.removeFirst().second.close()
+            }
+        }
+    }
+
+    @OptIn(ExperimentalGetImage::class)
+    private fun tryHardwareBuffer(image: ImageProxy): Boolean {
+        val callback = onHardwareBuffer ?: return false
+        if (synchronized(heldImages) { heldImages.size } >= MAX_HELD_IMAGES) return false
+        val hardwareBuffer = image.image?.hardwareBuffer ?: return false
+        // Native code holds its own reference; release the Java wrapper right away.
+        val token = hardwareBuffer.use { callback(it) }
+        if (token == 0L) return false
+        synchronized(heldImages) { heldImages.addLast(token to image) }
+        return true
+    }
 }
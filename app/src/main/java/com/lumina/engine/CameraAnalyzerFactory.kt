@@ -2,14 +2,28 @@ package com.lumina.engine
 
 import androidx.camera.core.ImageAnalysis
 import androidx.camera.core.ImageProxy
-import java.nio.ByteBuffer
-import java.nio.ByteOrder
-import com.lumina.engine.DirectBufferPool
 
-// Small helper to create a reusable analyzer for camera frames that copies to a direct buffer
+// Small helper to create a reusable analyzer for camera frames; RGBA copies go through
+// the engine's frame slots when it has them
 fun createCameraAnalyzer(nativeEngine: INativeEngine): ImageAnalysis.Analyzer {
-    return CachingImageAnalyzer { buffer, width, height ->
+    return CachingImageAnalyzer(
+        onHardwareBuffer = { hardwareBuffer -> nativeEngine.uploadCameraFrame(hardwareBuffer) },
+        releasedHardwareBuffers = { nativeEngine.releasedCameraFrames() },
+        onYuvFrame = { image -> nativeEngine.uploadCameraFrameYuv(image) },
+        framePool = nativeEngine.frameSlotPool()
+    ) { buffer, width, height ->
         // Buffer is already sliced in the analyzer; we can forward directly
         nativeEngine.uploadCameraFrame(buffer, width, height)
     }
 }
+
+/** Forwards an ImageProxy's YUV_420_888 planes, as delivered by CameraX, to [INativeEngine.uploadCameraFrameYuv]. */
+fun INativeEngine.uploadCameraFrameYuv(image: ImageProxy, downscale: Int = 1): Boolean {
+    val planes = image.planes
+    if (planes.size < 3) return false
+    return uploadCameraFrameYuv(
+        planes[0].buffer, planes[1].buffer, planes[2].buffer,
+        planes[0].rowStride, planes[1].rowStride, planes[1].pixelStride,
+        image.width, image.height, downscale
+    )
+}
@@ -41,6 +41,7 @@ class CameraController(private val context: Context) {
     private var preview: Preview? = null
     private var imageCapture: ImageCapture? = null
     private var imageAnalysis: androidx.camera.core.ImageAnalysis? = null
+    private var activeAnalyzer: androidx.camera.core.ImageAnalysis.Analyzer? = null
     private var videoCapture: VideoCapture<Recorder>? = null
     private var activeRecording: Recording? = null
     private var cameraSelector: CameraSelector = CameraSelector.DEFAULT_BACK_CAMERA
@@ -92,8 +93,13 @@ class CameraController(private val context: Context) {
         if (analyzer != null) {
             if (imageAnalysis == null) {
                 imageAnalysis = androidx.camera.core.ImageAnalysis.Builder()
-                    .setBackpressureStrategy(androidx.camera.core.ImageAnalysis.STRATEGY_KEEP_ONLY_LATEST)
-                    .setOutputImageFormat(androidx.camera.core.ImageAnalysis.OUTPUT_IMAGE_FORMAT_RGBA_8888)
+                    // Zero-copy frames stay open while the GPU samples them. KEEP_ONLY_LATEST
+                    // delivers nothing until the current image closes, so queue a few instead.
+                    .setBackpressureStrategy(androidx.camera.core.ImageAnalysis.STRATEGY_BLOCK_PRODUCER)
+                    .setImageQueueDepth(CachingImageAnalyzer.IMAGE_QUEUE_DEPTH)
+                    // Native YUV: analyzers convert on the CPU straight into GPU staging memory
+                    // instead of CameraX producing an intermediate RGBA copy.
+                    .setOutputImageFormat(androidx.camera.core.ImageAnalysis.OUTPUT_IMAGE_FORMAT_YUV_420_888)
                     .build()
                 imageAnalysis?.setAnalyzer(ContextCompat.getMainExecutor(context), analyzer)
                 useCases.add(imageAnalysis!!)
@@ -109,6 +115,7 @@ class CameraController(private val context: Context) {
             // No analyzer requested: clear existing analyzer if present
             imageAnalysis?.clearAnalyzer()
         }
+        replaceAnalyzer(analyzer)
 
         return try {
             provider.unbindAll()
@@ -223,10 +230,18 @@ class CameraController(private val context: Context) {
         activeRecording?.stop()
         activeRecording = null
         imageAnalysis?.clearAnalyzer()
+        replaceAnalyzer(null)
         val provider = cameraProviderFuture.get()
         provider.unbindAll()
     }
 
+    // Frames a detached analyzer still holds would count against the analysis queue.
+    private fun replaceAnalyzer(next: androidx.camera.core.ImageAnalysis.Analyzer?) {
+        val previous = activeAnalyzer
+        activeAnalyzer = next
+        if (previous !== next) (previous as? CachingImageAnalyzer)?.releaseHeldImages()
+    }
+
     /** Returns true if device camera has a flash unit available */
     fun hasFlashUnit(): Boolean {
         return camera?.cameraInfo?.hasFlashUnit() ?: false
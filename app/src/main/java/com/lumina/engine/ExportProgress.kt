@@ -0,0 +1,44 @@
+package com.lumina.engine
+
+/**
+ * State of the offline export begun with [INativeEngine.startExport] (recording.h).
+ * Frames are rendered as fast as the decoder, GPU and encoder allow, so [positionUs]
+ * usually runs well ahead of real time.
+ */
+data class ExportProgress(
+    val framesRendered: Long,
+    val positionUs: Long,
+    val durationUs: Long,
+    val running: Boolean,
+    /** Every frame was rendered and, for files, the MP4 was finalized. */
+    val succeeded: Boolean
+) {
+    /** Share of the clip rendered, 0..1. */
+    val fraction: Float
+        get() = when {
+            succeeded -> 1f
+            durationUs <= 0 -> 0f
+            else -> (positionUs.toFloat() / durationUs).coerceIn(0f, 1f)
+        }
+
+    companion object {
+        const val INFO_FRAMES = 0
+        const val INFO_POSITION = 1
+        const val INFO_DURATION = 2
+        const val INFO_RUNNING = 3
+        const val INFO_SUCCEEDED = 4
+        const val INFO_SIZE = 5
+
+        /** Decodes the array filled by the native engine. */
+        fun fromInfo(info: LongArray): ExportProgress {
+            require(info.size >= INFO_SIZE) { "Export info needs $INFO_SIZE entries, got ${info.size}" }
+            return ExportProgress(
+                framesRendered = info[INFO_FRAMES],
+                positionUs = info[INFO_POSITION],
+                durationUs = info[INFO_DURATION],
+                running = info[INFO_RUNNING] != 0L,
+                succeeded = info[INFO_SUCCEEDED] != 0L
+            )
+        }
+    }
+}
@@ -0,0 +1,81 @@
+package com.lumina.engine
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Camera frame slots allocated and owned by the native engine (frame_pool.h).
+ *
+ * Each slot is wrapped in a direct ByteBuffer once and reused, so steady-state ingest
+ * allocates nothing on the Java heap. A slot belongs to its producer from [acquire]
+ * until [submit] (or [release]), and native code only returns it to the pool once
+ * the GPU upload that read it has executed, so a frame can never be overwritten
+ * mid-read and the producer runs at most [slotCount] frames ahead of the uploads. When
+ * every slot is out [acquire] returns null and the frame should be dropped.
+ *
+ * For RGBA producers: the camera analyzer's fallback when a frame is neither imported
+ * nor YUV_420_888 (which native code converts into staging without this copy), and
+ * frame sources outside CameraX. [VideoEditor] borrows a slot as its sample buffer.
+ */
+class FrameSlotPool(
+    private val backend: Backend,
+    val slotCount: Int = DEFAULT_SLOT_COUNT
+) {
+    /** The JNI surface of the pool; faked in unit tests. */
+    interface Backend {
+        fun configure(slotCount: Int, slotBytes: Int): Boolean
+        fun acquire(): Int
+        fun buffer(index: Int): ByteBuffer?
+        fun submit(index: Int, size: Int, width: Int, height: Int)
+        fun release(index: Int)
+    }
+
+    class Slot internal constructor(val index: Int, val buffer: ByteBuffer)
+
+    companion object {
+        const val DEFAULT_SLOT_COUNT = 3
+        private const val SIZE_GRANULARITY = 64 * 1024
+    }
+
+    private val slots = arrayOfNulls<Slot>(slotCount)
+    private var slotBytes = 0
+
+    /**
+     * Returns a cleared slot of at least [minSize] bytes, or null when none is free.
+     * Growing the slots reallocates native memory, which is only possible while every
+     * slot is back in the pool; until then requests for larger frames return null.
+     */
+    @Synchronized
+    fun acquire(minSize: Int): Slot? {
+        if (minSize <= 0) return null
+        if (minSize > slotBytes) {
+            val bytes = (minSize + SIZE_GRANULARITY - 1) / SIZE_GRANULARITY * SIZE_GRANULARITY
+            if (!backend.configure(slotCount, bytes)) return null
+            // Old wrappers point at freed memory now.
+            slots.fill(null)
+            slotBytes = bytes
+        }
+
+        val index = backend.acquire()
+        if (index !in slots.indices) return null
+        val slot = slots[index] ?: backend.buffer(index)?.let { buffer ->
+            Slot(index, buffer.order(ByteOrder.nativeOrder())).also { slots[index] = it }
+        }
+        if (slot == null) {
+            backend.release(index)
+            return null
+        }
+        slot.buffer.clear()
+        return slot
+    }
+
+    /** Hands a filled slot (bytes [0, position)) to native code, which releases it once the upload has executed. */
+    fun submit(slot: Slot, width: Int, height: Int) {
+        backend.submit(slot.index, slot.buffer.position(), width, height)
+    }
+
+    /** Returns a slot without uploading it, e.g. when filling it failed. */
+    fun release(slot: Slot) {
+        backend.release(slot.index)
+    }
+}
@@ -1,8 +1,133 @@
 package com.lumina.engine
 
+import android.content.res.AssetFileDescriptor
+import android.hardware.HardwareBuffer
+import android.view.Surface
 import java.nio.ByteBuffer
 
 interface INativeEngine {
     fun getVideoTextureId(): Int
     fun uploadCameraFrame(buffer: ByteBuffer, width: Int, height: Int)
+
+    /**
+     * Zero-copy upload of a camera HardwareBuffer, which the renderer samples in place.
+     * Returns a token for the frame, or 0 when the active renderer cannot import it, in
+     * which case callers should fall back to the ByteBuffer overload. The Image the buffer
+     * came from must stay open until [releasedCameraFrames] reaches the token: closing it
+     * lets the camera refill a buffer the GPU may still be reading.
+     */
+    fun uploadCameraFrame(hardwareBuffer: HardwareBuffer): Long = 0L
+
+    /**
+     * Newest [uploadCameraFrame] token whose buffer the renderer is done with; every earlier
+     * token is done as well. Cheap enough to poll once per frame.
+     */
+    fun releasedCameraFrames(): Long = Long.MAX_VALUE
+
+    /**
+     * Native-owned frame slots for producers of RGBA frames, or null when the engine has
+     * none; callers then fall back to [uploadCameraFrame]. Camera frames arrive as
+     * YUV_420_888 and go through [uploadCameraFrameYuv] instead.
+     */
+    fun frameSlotPool(): FrameSlotPool? = null
+
+    /**
+     * Uploads a YUV_420_888 frame straight from its plane buffers (which must be direct);
+     * native code converts it to RGBA, downscaled by [downscale] (1, 2 or 4), directly
+     * into the renderer's staging memory. Returns false when the active renderer has no
+     * CPU upload path or rejects the planes.
+     */
+    fun uploadCameraFrameYuv(
+        yPlane: ByteBuffer,
+        uPlane: ByteBuffer,
+        vPlane: ByteBuffer,
+        yRowStride: Int,
+        uvRowStride: Int,
+        uvPixelStride: Int,
+        width: Int,
+        height: Int,
+        downscale: Int = 1
+    ): Boolean = false
+
+    /**
+     * Renders a [width] x [height] copy of the camera input (RGB, or luma when
+     * [grayscale]) for ML consumers, read with [analysisFrames]. [width] must be a
+     * multiple of 4, at most 1024 on either axis; 0 turns the branch off.
+     */
+    fun setAnalysisOutput(width: Int, height: Int, grayscale: Boolean = false): Boolean = false
+
+    /** Reader for frames requested with [setAnalysisOutput], or null when unsupported. */
+    fun analysisFrames(): AnalysisFrameReader? = null
+
+    /**
+     * Records what the engine renders, effects included, as H.264 into an MP4 at [path].
+     * Frames go from GPU memory straight into a native MediaCodec input surface and are
+     * muxed natively, with no readback. [width] and [height] must be even, 64..4096;
+     * a [bitRate] of 0 picks one from the size and [frameRate].
+     */
+    fun startRecording(path: String, width: Int, height: Int, frameRate: Int = 30, bitRate: Int = 0): Boolean = false
+
+    /** Finalizes the file begun by [startRecording]; false when nothing usable was written. */
+    fun stopRecording(): Boolean = false
+
+    /**
+     * Also renders every frame into [surface], e.g. from `MediaCodec.createInputSurface()`,
+     * stamped with its presentation time. Null detaches; refused while [startRecording]
+     * is active.
+     */
+    fun setEncoderSurface(surface: Surface?): Boolean = false
+
+    /**
+     * Decodes the clip in [file] natively and renders it in place of the camera, frames
+     * going from the hardware decoder to the GPU without passing through Kotlin. It opens
+     * paused on its first frame. The engine keeps its own descriptor, so [file] may be
+     * closed once this returns.
+     */
+    fun openVideo(file: AssetFileDescriptor): Boolean = false
+
+    /** Returns to the camera. */
+    fun closeVideo() {}
+
+    fun setVideoPlaying(playing: Boolean) {}
+
+    /** Shows the frame at [timeUs] as soon as it is decoded, playing or paused. */
+    fun seekVideo(timeUs: Long) {}
+
+    /** The open clip and its position, or null while the camera is the source. */
+    fun videoSource(): VideoSourceInfo? = null
+
+    /**
+     * Renders every frame of the clip in [file] through the current effects into an MP4
+     * at [path], in the background and unthrottled: the time taken depends on decoder,
+     * GPU and encoder throughput, not the display. The preview keeps running. Size and
+     * rates follow [startRecording]. Poll [exportProgress] for completion.
+     */
+    fun startExport(
+        file: AssetFileDescriptor,
+        path: String,
+        width: Int,
+        height: Int,
+        frameRate: Int = 30,
+        bitRate: Int = 0
+    ): Boolean = false
+
+    /**
+     * Same, but frames go to [surface] stamped with their media time: a caller's own
+     * MediaCodec input surface, or an ImageReader's for per-frame callbacks.
+     */
+    fun startExport(file: AssetFileDescriptor, surface: Surface): Boolean = false
+
+    /** Stops the running export; a file keeps the frames rendered so far. */
+    fun cancelExport() {}
+
+    /** The current or last export, or null when there has been none. */
+    fun exportProgress(): ExportProgress? = null
+
+    /**
+     * Where the UI's glass panels sit over the engine surface, five floats per panel:
+     * left, top, right and bottom as fractions of the surface, origin top-left, then the
+     * corner radius as a fraction of its width. The engine blurs the frame behind each
+     * one; an empty array clears them. Recordings and exports never include the panels.
+     */
+    fun setGlassPanels(panels: FloatArray) {}
 }
@@ -9,6 +9,7 @@ import kotlinx.coroutines.flow.StateFlow
 import kotlinx.coroutines.flow.asStateFlow
 import kotlinx.coroutines.launch
 import kotlinx.coroutines.withContext
+import kotlinx.coroutines.yield
 import com.lumina.engine.settings.InMemorySettingsRepository
 import com.lumina.engine.settings.SettingsDataSource
 import com.lumina.engine.settings.SettingsRepository
@@ -37,6 +38,19 @@ class LuminaViewModel(
     val dynamicTheme: StateFlow<Boolean> = _dynamicTheme.asStateFlow()
 
     var nativeBridge: NativeBridge? = null
+
+    // Reused for every binary state push; only touched from the main thread.
+    private val statePacket = StatePacket.allocate()
+
+    // Commands queued on the main thread and submitted once per main-loop turn, so a
+    // burst of touch moves costs one JNI call. pendingDirty names the packet groups to
+    // resend if the bridge cannot take commands.
+    private val commands = CommandBuffer()
+    private var pendingDirty = 0
+    private var flushScheduled = false
+
+    // Timing polls run on IO threads and use a buffer of their own.
+    private val timingCommands = CommandBuffer(capacity = 64)
     var pythonOrchestrator: PythonOrchestrator? = null
 
     init {
@@ -73,7 +87,7 @@ class LuminaViewModel(
                     )
                 }
 
-                nativeBridge?.updateState(_luminaState.value.toJson())
+                pushIntent(intent)
                 _statusMessage.value = "Applied: ${intent.action}"
             } catch (e: Exception) {
                 _statusMessage.value = "Error: ${e.message}"
@@ -105,6 +119,7 @@ class LuminaViewModel(
             newEffects[activeEffectCount] = effect
             copy(effects = newEffects, activeEffectCount = activeEffectCount + 1)
         }
+        pushState(StatePacket.DIRTY_EFFECTS)
     }
 
     fun clearEffects() {
@@ -114,6 +129,70 @@ class LuminaViewModel(
                 activeEffectCount = 0
             )
         }
+        pushState(StatePacket.DIRTY_EFFECTS)
+    }
+
+    fun updateTouch(position: Vec2, delta: Vec2, pressure: Float, touchState: TouchState) {
+        updateState {
+            copy(touchPosition = position, touchDelta = delta, touchPressure = pressure, touchState = touchState)
+        }
+        queueCommands(StatePacket.DIRTY_TOUCH) { setTouch(position, delta, pressure, touchState) }
+    }
+
+    private inline fun queueCommands(dirtyMask: Int, queue: CommandBuffer.() -> Boolean) {
+        if (nativeBridge == null) return
+        if (!commands.queue()) {
+            flushCommands()
+            commands.queue()
+        }
+        pendingDirty = pendingDirty or dirtyMask
+        if (flushScheduled) return
+        flushScheduled = true
+        viewModelScope.launch {
+            // Let the rest of this turn's input queue up behind the first command.
+            yield()
+            flushScheduled = false
+            flushCommands()
+        }
+    }
+
+    private fun flushCommands() {
+        val dirty = pendingDirty
+        pendingDirty = 0
+        if (commands.isEmpty) return
+        val bridge = nativeBridge
+        if (bridge == null || !bridge.submitCommands(commands)) {
+            commands.clear()
+            if (bridge != null) pushState(dirty)
+        }
+    }
+
+    /** Sends the hot fields as a binary packet, falling back to JSON for bridges without it. */
+    private fun pushState(dirtyMask: Int) {
+        val bridge = nativeBridge ?: return
+        val state = _luminaState.value
+        if (!bridge.updateStateBinary(StatePacket.encode(state, dirtyMask, statePacket))) {
+            bridge.updateState(state.toJson())
+        }
+    }
+
+    /**
+     * Hands [intent] to the engine through the shared state block, where the orchestrator
+     * may already have written it, falling back to the full JSON state without a block.
+     */
+    private fun pushIntent(intent: AIIntent) {
+        val bridge = nativeBridge ?: return
+        val shared = bridge.sharedState()
+        if (shared != null && SharedStateLayout.isValid(shared)) {
+            if (pythonOrchestrator?.writesSharedIntents != true) {
+                SharedStateLayout.writeIntent(shared, SharedStateLayout.CURRENT_INTENT, intent)
+            }
+            if (bridge.commitSharedIntents()) {
+                pushState(StatePacket.DIRTY_PROCESSING)
+                return
+            }
+        }
+        bridge.updateState(_luminaState.value.toJson())
     }
 
     fun updateUIStyle(params: GlassmorphicParams) {
@@ -141,20 +220,73 @@ class LuminaViewModel(
     fun refreshTiming() {
         nativeBridge?.let { bridge ->
             viewModelScope.launch(Dispatchers.IO) {
-                runCatching { bridge.getFrameTiming() }
+                runCatching { readTiming(bridge) }
                     .onSuccess { timing ->
                         updateState { copy(timing = timing) }
                     }
             }
         }
     }
+
+    /** Frame timing through the command stream's result buffer, or the JSON getter without it. */
+    private fun readTiming(bridge: NativeBridge): FrameTiming {
+        val timing = synchronized(timingCommands) {
+            timingCommands.clear()
+            timingCommands.readTiming()
+            if (bridge.submitCommands(timingCommands)) timingCommands.timing() else null
+        }
+        return timing ?: bridge.getFrameTiming()
+    }
 }
 
 interface NativeBridge {
     fun initialize(): Boolean
+
+    /**
+     * Starts the engine without blocking the caller; [onReady] receives the outcome,
+     * possibly on another thread. The default runs [initialize] inline.
+     */
+    fun initializeAsync(onReady: (Boolean) -> Unit) = onReady(initialize())
     fun updateState(jsonState: String)
+
+    /** Applies a [StatePacket]; returns false when unsupported so callers fall back to JSON. */
+    fun updateStateBinary(packet: java.nio.ByteBuffer): Boolean = false
     fun setRenderMode(mode: Int)
+
+    /**
+     * Submits the commands queued in [commands] with one native call and clears the queue
+     * either way; results land in [CommandBuffer.results]. False when unsupported or
+     * rejected, so callers fall back to the per-call methods.
+     */
+    fun submitCommands(commands: CommandBuffer): Boolean = false
+
+    /**
+     * The shared state block (SharedStateLayout) mapped in this process, or null when
+     * unavailable. Intents written into its records reach the engine on [commitSharedIntents].
+     */
+    fun sharedState(): java.nio.ByteBuffer? = null
+
+    /** A new descriptor for the block, for another mapping (the orchestrator's); -1 without one. */
+    fun sharedStateFd(): Int = -1
+
+    /** Applies the block's intent records to the native state; false without a block. */
+    fun commitSharedIntents(): Boolean = false
+
+    /** Paces native rendering to [fps] (e.g. 30/60/90/120); 0 follows the display. */
+    fun setTargetFrameRate(fps: Int) {}
+
+    /** Lets multi-pass effects render below surface size under GPU or thermal load (default on). */
+    fun setAdaptiveResolution(enabled: Boolean) {}
+
+    /**
+     * True when the next vsync will draw: new state, a new camera or video frame, or
+     * time-animated effects (noise, stylized mode). Idle frames are skipped natively.
+     */
+    fun isFrameDirty(): Boolean = true
     fun getFrameTiming(): FrameTiming
+
+    /** Rolling p50/p95/p99 stage and per-pass GPU timings in ms as JSON; "{}" when unavailable. */
+    fun getFrameStatsJson(): String = "{}"
     fun getVideoTextureId(): Int
     fun uploadCameraFrame(buffer: java.nio.ByteBuffer, width: Int, height: Int)
     fun shutdown()
@@ -163,5 +295,15 @@ interface NativeBridge {
 interface PythonOrchestrator {
     fun initialize(assetsPath: String): Boolean
     fun parseIntent(userInput: String): AIIntent
+
+    /**
+     * Maps the shared state block from [fd] (taken over) so [parseIntent] writes its result
+     * into the current intent record of [block], this process's mapping, and reads it back
+     * from there. Returns false when unsupported.
+     */
+    fun attachSharedState(block: java.nio.ByteBuffer, fd: Int): Boolean = false
+
+    /** True while [parseIntent] writes its result into the shared state block. */
+    val writesSharedIntents: Boolean get() = false
     fun shutdown()
 }
@@ -5,6 +5,8 @@ import android.content.Intent
 import android.net.Uri
 import android.os.Build
 import android.os.Bundle
+import android.os.Handler
+import android.os.Looper
 import android.provider.Settings
 import android.util.Log
 import androidx.activity.ComponentActivity
@@ -32,6 +34,7 @@ class MainActivity : ComponentActivity() {
     private lateinit var nativeEngine: NativeEngine
     private lateinit var pythonBridge: PythonBridge
     private lateinit var cameraController: CameraController
+    private val mainHandler = Handler(Looper.getMainLooper())
 
     private val requiredPermissions: Array<String> by lazy {
         val mediaPerms = if (Build.VERSION.SDK_INT >= Build.VERSION_CODES.TIRAMISU) {
@@ -77,13 +80,17 @@ class MainActivity : ComponentActivity() {
 
         cameraController = CameraController(this)
 
-        // Initialize native engine
+        // Native engine: device and pipeline creation run on the engine's render thread
+        // while the orchestrator starts here, so neither blocks the other.
         nativeEngine = NativeEngine()
-        val nativeInitialized = nativeEngine.initialize()
-        Log.i(TAG, "Native engine initialized: $nativeInitialized")
+        pythonBridge = PythonBridge()
+        nativeEngine.initializeAsync { ready ->
+            Log.i(TAG, "Native engine initialized: $ready")
+            // Posted, so it runs after onCreate() has initialized the orchestrator.
+            if (ready) mainHandler.post { if (!isDestroyed) shareStateWithOrchestrator() }
+        }
 
         // Initialize Python orchestrator
-        pythonBridge = PythonBridge()
         val pythonInitialized = pythonBridge.initialize(filesDir.absolutePath)
         Log.i(TAG, "Python orchestrator initialized: $pythonInitialized")
 
@@ -102,6 +109,16 @@ class MainActivity : ComponentActivity() {
         }
     }
 
+    // Intents then travel through the shared state block instead of JSON.
+    private fun shareStateWithOrchestrator() {
+        nativeEngine.sharedState()?.let { block ->
+            val fd = nativeEngine.sharedStateFd()
+            if (fd >= 0) {
+                Log.i(TAG, "Orchestrator shares state: ${pythonBridge.attachSharedState(block, fd)}")
+            }
+        }
+    }
+
     override fun onPause() {
         super.onPause()
         cameraController.shutdown()
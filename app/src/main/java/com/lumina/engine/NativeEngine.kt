@@ -1,9 +1,17 @@
 package com.lumina.engine
 
+import android.content.res.AssetFileDescriptor
 import android.content.res.AssetManager
+import android.hardware.HardwareBuffer
+import android.os.SharedMemory
+import android.system.ErrnoException
 import android.util.Log
 import android.view.Surface
 import com.google.gson.Gson
+import kotlinx.coroutines.flow.MutableStateFlow
+import kotlinx.coroutines.flow.StateFlow
+import kotlinx.coroutines.flow.asStateFlow
+import java.io.File
 import java.util.concurrent.atomic.AtomicBoolean
 
 /**
@@ -24,20 +32,102 @@ class NativeEngine : NativeBridge, INativeEngine {
         }
     }
 
+    /** Receives the outcome of nativeInitAsync, on the native render thread. */
+    private fun interface ReadyListener {
+        fun onEngineReady(ready: Boolean)
+    }
+
     private val isInitialized = AtomicBoolean(false)
+    private val isStarting = AtomicBoolean(false)
     private val gson = Gson()
 
+    private val _ready = MutableStateFlow(false)
+    /** True while the engine can render, i.e. once [initialize] or [initializeAsync] succeeded. */
+    val ready: StateFlow<Boolean> = _ready.asStateFlow()
+
+    // Shared state block (SharedStateLayout). The engine maps its own duplicate and drops
+    // it on shutdown; this mapping stays for the life of the object so buffers handed
+    // out by sharedState() never dangle, and a later initialize() attaches it again.
+    private var sharedMemory: SharedMemory? = null
+    private var sharedBuffer: java.nio.ByteBuffer? = null
+
+    // Slot memory lives in the native engine singleton and survives shutdown(), so the
+    // cached ByteBuffer wrappers never dangle.
+    private val framePool = FrameSlotPool(object : FrameSlotPool.Backend {
+        override fun configure(slotCount: Int, slotBytes: Int) = nativeConfigureFramePool(slotCount, slotBytes)
+        override fun acquire() = nativeAcquireFrameSlot()
+        override fun buffer(index: Int) = nativeGetFrameSlotBuffer(index)
+        override fun submit(index: Int, size: Int, width: Int, height: Int) =
+            nativeSubmitFrameSlot(index, size, width, height)
+        override fun release(index: Int) = nativeReleaseFrameSlot(index)
+    })
+
+    private val analysisReader = AnalysisFrameReader(object : AnalysisFrameReader.Backend {
+        override fun read(buffer: java.nio.ByteBuffer?, info: LongArray) =
+            if (isInitialized.get()) nativeReadAnalysisFrame(buffer, info) else 0
+    })
+
     // Native methods
-    private external fun nativeInit(assetManager: AssetManager): Boolean
+    private external fun nativeInit(assetManager: AssetManager, shaderCacheDir: String): Boolean
+    private external fun nativeInitAsync(assetManager: AssetManager, shaderCacheDir: String, listener: ReadyListener): Boolean
     private external fun nativeShutdown()
     private external fun nativeUpdateState(jsonState: String): Boolean
+    private external fun nativeUpdateStateBinary(packet: java.nio.ByteBuffer, size: Int): Boolean
     private external fun nativeSetRenderMode(mode: Int)
+    private external fun nativeSubmitCommands(
+        commands: java.nio.ByteBuffer,
+        size: Int,
+        results: java.nio.ByteBuffer
+    ): Boolean
+    private external fun nativeAttachSharedState(sharedMemory: SharedMemory): Boolean
+    private external fun nativeDetachSharedState()
+    private external fun nativeCommitSharedIntents(): Boolean
+    private external fun nativeDupSharedStateFd(): Int
     private external fun nativeSetSurface(surface: Surface?)
     private external fun nativeRenderFrame()
+    private external fun nativeIsFrameDirty(): Boolean
+    private external fun nativeSetTargetFrameRate(fps: Int)
+    private external fun nativeSetAdaptiveResolution(enabled: Boolean)
     private external fun nativeGetFrameTimingJson(): String
+    private external fun nativeGetFrameStatsJson(): String
     private external fun nativeGetVersion(): String
     private external fun nativeGetVideoTextureId(): Int
     private external fun nativeUploadCameraFrame(buffer: java.nio.ByteBuffer, width: Int, height: Int)
+    private external fun nativeUploadCameraHardwareBuffer(buffer: HardwareBuffer): Long
+    private external fun nativeReleasedCameraFrames(): Long
+    private external fun nativeConfigureFramePool(slotCount: Int, slotBytes: Int): Boolean
+    private external fun nativeAcquireFrameSlot(): Int
+    private external fun nativeGetFrameSlotBuffer(index: Int): java.nio.ByteBuffer?
+    private external fun nativeSubmitFrameSlot(index: Int, size: Int, width: Int, height: Int)
+    private external fun nativeReleaseFrameSlot(index: Int)
+    private external fun nativeSetAnalysisOutput(width: Int, height: Int, grayscale: Boolean): Boolean
+    private external fun nativeReadAnalysisFrame(buffer: java.nio.ByteBuffer?, info: LongArray): Int
+    private external fun nativeStartRecording(path: String, width: Int, height: Int, frameRate: Int, bitRate: Int): Boolean
+    private external fun nativeStopRecording(): Boolean
+    private external fun nativeSetEncoderSurface(surface: Surface?): Boolean
+    private external fun nativeOpenVideo(fd: Int, offset: Long, length: Long): Boolean
+    private external fun nativeCloseVideo()
+    private external fun nativeSetVideoPlaying(playing: Boolean)
+    private external fun nativeSeekVideo(timeUs: Long)
+    private external fun nativeGetVideoInfo(info: LongArray): Boolean
+    private external fun nativeStartExport(
+        fd: Int, offset: Long, length: Long, path: String, width: Int, height: Int, frameRate: Int, bitRate: Int
+    ): Boolean
+    private external fun nativeStartExportToSurface(fd: Int, offset: Long, length: Long, surface: Surface): Boolean
+    private external fun nativeCancelExport()
+    private external fun nativeGetExportProgress(info: LongArray): Boolean
+    private external fun nativeSetGlassPanels(panels: FloatArray)
+    private external fun nativeUploadCameraYuv(
+        yPlane: java.nio.ByteBuffer,
+        uPlane: java.nio.ByteBuffer,
+        vPlane: java.nio.ByteBuffer,
+        yRowStride: Int,
+        uvRowStride: Int,
+        uvPixelStride: Int,
+        width: Int,
+        height: Int,
+        downscale: Int
+    ): Boolean
 
     override fun initialize(): Boolean {
         if (isInitialized.get()) {
@@ -49,13 +139,8 @@ class NativeEngine : NativeBridge, INativeEngine {
             if (isInitialized.get()) return true
 
             return try {
-                val assetManager = LuminaApplication.instance.assets
-                val initialized = nativeInit(assetManager)
-                isInitialized.set(initialized)
-                if (initialized) {
-                    Log.i(TAG, "Engine initialized, version: ${nativeGetVersion()}")
-                }
-                initialized
+                val app = LuminaApplication.instance
+                onInitialized(nativeInit(app.assets, shaderCacheDir(app).absolutePath))
             } catch (e: Exception) {
                 Log.e(TAG, "Failed to initialize engine: ${e.message}")
                 false
@@ -63,6 +148,50 @@ class NativeEngine : NativeBridge, INativeEngine {
         }
     }
 
+    /**
+     * Returns at once; instance, device and pipeline creation run on the native render
+     * thread, which calls [onReady] with the outcome. Until then every call is dropped
+     * as before [initialize], except [setSurface], which attaches once the device is up.
+     */
+    override fun initializeAsync(onReady: (Boolean) -> Unit) {
+        if (isInitialized.get()) {
+            onReady(true)
+            return
+        }
+
+        val started = synchronized(this) {
+            try {
+                val app = LuminaApplication.instance
+                isStarting.set(true)
+                nativeInitAsync(app.assets, shaderCacheDir(app).absolutePath) { ready ->
+                    onReady(onInitialized(ready))
+                }
+            } catch (e: Exception) {
+                Log.e(TAG, "Failed to start engine: ${e.message}")
+                false
+            }
+        }
+        if (!started) {
+            isStarting.set(false)
+            onReady(false)
+        }
+    }
+
+    // Persisted pipeline caches / program binaries; the native side validates them per driver.
+    private fun shaderCacheDir(app: LuminaApplication) = File(app.filesDir, "shader_cache").apply { mkdirs() }
+
+    // Both start-up paths end here; no lock, since it may run on the render thread
+    // while initialize() holds the monitor waiting for it.
+    private fun onInitialized(ready: Boolean): Boolean {
+        isStarting.set(false)
+        if (ready && !isInitialized.getAndSet(true)) {
+            Log.i(TAG, "Engine initialized, version: ${nativeGetVersion()}")
+            attachSharedState()
+        }
+        _ready.value = isInitialized.get()
+        return ready
+    }
+
     override fun updateState(jsonState: String) {
         if (!isInitialized.get()) {
             Log.w(TAG, "Cannot update state - not initialized")
@@ -71,6 +200,23 @@ class NativeEngine : NativeBridge, INativeEngine {
         nativeUpdateState(jsonState)
     }
 
+    override fun updateStateBinary(packet: java.nio.ByteBuffer): Boolean {
+        if (!isInitialized.get()) return false
+        return nativeUpdateStateBinary(packet, StatePacket.SIZE)
+    }
+
+    override fun submitCommands(commands: CommandBuffer): Boolean {
+        if (!isInitialized.get()) {
+            commands.clear()
+            return false
+        }
+        if (commands.isEmpty) return true
+        commands.clearResults()
+        val submitted = nativeSubmitCommands(commands.commands, commands.size, commands.results)
+        commands.clear()
+        return submitted
+    }
+
     override fun setRenderMode(mode: Int) {
         if (!isInitialized.get()) return
         nativeSetRenderMode(mode)
@@ -88,23 +234,71 @@ class NativeEngine : NativeBridge, INativeEngine {
         }
     }
 
+    override fun getFrameStatsJson(): String {
+        return if (isInitialized.get()) nativeGetFrameStatsJson() else "{}"
+    }
+
     override fun shutdown() {
         if (!isInitialized.getAndSet(false)) return
 
         Log.i(TAG, "Shutting down engine")
+        _ready.value = false
         nativeShutdown()
     }
 
+    private fun attachSharedState() {
+        try {
+            val memory = sharedMemory ?: SharedMemory.create("lumina-state", SharedStateLayout.SIZE).also {
+                sharedBuffer = it.mapReadWrite()
+                sharedMemory = it
+            }
+            if (!nativeAttachSharedState(memory)) {
+                Log.w(TAG, "Engine did not attach the shared state block")
+            }
+        } catch (e: ErrnoException) {
+            // Everything still works over JSON and packets without the block.
+            Log.w(TAG, "Shared state block unavailable: ${e.message}")
+        }
+    }
+
+    override fun sharedState(): java.nio.ByteBuffer? {
+        val buffer = sharedBuffer ?: return null
+        return if (isInitialized.get()) buffer.duplicate().order(java.nio.ByteOrder.nativeOrder()) else null
+    }
+
+    override fun sharedStateFd(): Int {
+        return if (isInitialized.get() && sharedBuffer != null) nativeDupSharedStateFd() else -1
+    }
+
+    override fun commitSharedIntents(): Boolean {
+        return isInitialized.get() && sharedBuffer != null && nativeCommitSharedIntents()
+    }
+
     fun setSurface(surface: Surface?) {
-        if (!isInitialized.get()) return
+        if (!isInitialized.get() && !isStarting.get()) return
         nativeSetSurface(surface)
     }
 
+    /** Requests one extra frame; the native render thread paces frames on its own. */
     fun renderFrame() {
         if (!isInitialized.get()) return
         nativeRenderFrame()
     }
 
+    override fun isFrameDirty(): Boolean {
+        return isInitialized.get() && nativeIsFrameDirty()
+    }
+
+    override fun setTargetFrameRate(fps: Int) {
+        if (!isInitialized.get()) return
+        nativeSetTargetFrameRate(fps)
+    }
+
+    override fun setAdaptiveResolution(enabled: Boolean) {
+        if (!isInitialized.get()) return
+        nativeSetAdaptiveResolution(enabled)
+    }
+
     fun getVersion(): String {
         return if (isInitialized.get()) nativeGetVersion() else "N/A"
     }
@@ -117,4 +311,117 @@ class NativeEngine : NativeBridge, INativeEngine {
         if (!isInitialized.get()) return
         nativeUploadCameraFrame(buffer, width, height)
     }
+
+    override fun uploadCameraFrame(hardwareBuffer: HardwareBuffer): Long {
+        if (!isInitialized.get()) return 0L
+        return nativeUploadCameraHardwareBuffer(hardwareBuffer)
+    }
+
+    // Not gated on isInitialized: shutdown hands every buffer back, and images held from
+    // before it still need to hear so.
+    override fun releasedCameraFrames(): Long = nativeReleasedCameraFrames()
+
+    override fun frameSlotPool(): FrameSlotPool = framePool
+
+    override fun uploadCameraFrameYuv(
+        yPlane: java.nio.ByteBuffer,
+        uPlane: java.nio.ByteBuffer,
+        vPlane: java.nio.ByteBuffer,
+        yRowStride: Int,
+        uvRowStride: Int,
+        uvPixelStride: Int,
+        width: Int,
+        height: Int,
+        downscale: Int
+    ): Boolean {
+        if (!isInitialized.get()) return false
+        return nativeUploadCameraYuv(
+            yPlane, uPlane, vPlane, yRowStride, uvRowStride, uvPixelStride, width, height, downscale
+        )
+    }
+
+    override fun setAnalysisOutput(width: Int, height: Int, grayscale: Boolean): Boolean {
+        if (!isInitialized.get()) return false
+        return nativeSetAnalysisOutput(width, height, grayscale)
+    }
+
+    override fun analysisFrames(): AnalysisFrameReader = analysisReader
+
+    override fun startRecording(path: String, width: Int, height: Int, frameRate: Int, bitRate: Int): Boolean {
+        if (!isInitialized.get()) return false
+        return nativeStartRecording(path, width, height, frameRate, bitRate)
+    }
+
+    override fun stopRecording(): Boolean {
+        if (!isInitialized.get()) return false
+        return nativeStopRecording()
+    }
+
+    override fun setEncoderSurface(surface: Surface?): Boolean {
+        if (!isInitialized.get()) return false
+        return nativeSetEncoderSurface(surface)
+    }
+
+    override fun openVideo(file: AssetFileDescriptor): Boolean {
+        if (!isInitialized.get()) return false
+        // declaredLength is UNKNOWN_LENGTH (-1) for whole files; native code reads to the end.
+        return nativeOpenVideo(file.parcelFileDescriptor.fd, file.startOffset, file.declaredLength)
+    }
+
+    override fun closeVideo() {
+        if (!isInitialized.get()) return
+        nativeCloseVideo()
+    }
+
+    override fun setVideoPlaying(playing: Boolean) {
+        if (!isInitialized.get()) return
+        nativeSetVideoPlaying(playing)
+    }
+
+    override fun seekVideo(timeUs: Long) {
+        if (!isInitialized.get()) return
+        nativeSeekVideo(timeUs)
+    }
+
+    override fun videoSource(): VideoSourceInfo? {
+        if (!isInitialized.get()) return null
+        val info = LongArray(VideoSourceInfo.INFO_SIZE)
+        return if (nativeGetVideoInfo(info)) VideoSourceInfo.fromInfo(info) else null
+    }
+
+    override fun startExport(
+        file: AssetFileDescriptor,
+        path: String,
+        width: Int,
+        height: Int,
+        frameRate: Int,
+        bitRate: Int
+    ): Boolean {
+        if (!isInitialized.get()) return false
+        return nativeStartExport(
+            file.parcelFileDescriptor.fd, file.startOffset, file.declaredLength,
+            path, width, height, frameRate, bitRate
+        )
+    }
+
+    override fun startExport(file: AssetFileDescriptor, surface: Surface): Boolean {
+        if (!isInitialized.get()) return false
+        return nativeStartExportToSurface(file.parcelFileDescriptor.fd, file.startOffset, file.declaredLength, surface)
+    }
+
+    override fun cancelExport() {
+        if (!isInitialized.get()) return
+        nativeCancelExport()
+    }
+
+    override fun exportProgress(): ExportProgress? {
+        if (!isInitialized.get()) return null
+        val info = LongArray(ExportProgress.INFO_SIZE)
+        return if (nativeGetExportProgress(info)) ExportProgress.fromInfo(info) else null
+    }
+
+    override fun setGlassPanels(panels: FloatArray) {
+        if (!isInitialized.get()) return
+        nativeSetGlassPanels(panels)
+    }
 }
@@ -1,5 +1,6 @@
 package com.lumina.engine
 
+import android.os.ParcelFileDescriptor
 import android.util.Log
 import com.chaquo.python.PyObject
 import com.chaquo.python.Python
@@ -18,6 +19,12 @@ class PythonBridge : PythonOrchestrator {
     private var isInitialized = false
     private val gson = Gson()
 
+    // The orchestrator's intent lands here in place of a JSON result once attached.
+    private var sharedBlock: java.nio.ByteBuffer? = null
+
+    override val writesSharedIntents: Boolean
+        get() = sharedBlock != null
+
     override fun initialize(assetsPath: String): Boolean {
         if (isInitialized) {
             Log.w(TAG, "Python orchestrator already initialized")
@@ -53,6 +60,21 @@ class PythonBridge : PythonOrchestrator {
             initialize(filesDir)
         }
 
+        val block = sharedBlock ?: return parseIntentJson(userInput)
+        return try {
+            // Written in place by the orchestrator; no JSON on either side.
+            orchestratorModule?.callAttr("parse_intent_shared", userInput)
+            SharedStateLayout.readIntent(block, SharedStateLayout.CURRENT_INTENT)
+        } catch (e: Exception) {
+            Log.e(TAG, "Error parsing intent: ${e.message}")
+            // The block must hold whatever is returned, as writesSharedIntents promises.
+            errorIntent(userInput, e).also {
+                SharedStateLayout.writeIntent(block, SharedStateLayout.CURRENT_INTENT, it)
+            }
+        }
+    }
+
+    private fun parseIntentJson(userInput: String): AIIntent {
         return try {
             val result = orchestratorModule?.callAttr("parse_intent", userInput)
             val json = result?.toString() ?: "{}"
@@ -62,16 +84,38 @@ class PythonBridge : PythonOrchestrator {
             gson.fromJson(json, AIIntent::class.java)
         } catch (e: Exception) {
             Log.e(TAG, "Error parsing intent: ${e.message}")
-            AIIntent(
-                action = "error",
-                target = userInput,
-                parameters = """{"error": "${e.message}"}""",
-                confidence = 0f,
-                timestamp = System.currentTimeMillis()
-            )
+            errorIntent(userInput, e)
         }
     }
 
+    override fun attachSharedState(block: java.nio.ByteBuffer, fd: Int): Boolean {
+        val module = orchestratorModule
+        if (!isInitialized || module == null || !SharedStateLayout.isValid(block)) {
+            ParcelFileDescriptor.adoptFd(fd).close()
+            return false
+        }
+        return try {
+            // Python maps its own view and closes the descriptor either way.
+            val attached = module.callAttr("attach_shared_state", fd)?.toBoolean() ?: false
+            if (attached) {
+                sharedBlock = block
+                Log.i(TAG, "Orchestrator writes intents into the shared state block")
+            }
+            attached
+        } catch (e: Exception) {
+            Log.e(TAG, "Error attaching shared state: ${e.message}")
+            false
+        }
+    }
+
+    private fun errorIntent(userInput: String, e: Exception) = AIIntent(
+        action = "error",
+        target = userInput,
+        parameters = """{"error": "${e.message}"}""",
+        confidence = 0f,
+        timestamp = System.currentTimeMillis()
+    )
+
     override fun shutdown() {
         if (!isInitialized) return
 
@@ -83,6 +127,7 @@ class PythonBridge : PythonOrchestrator {
         }
 
         orchestratorModule = null
+        sharedBlock = null
         isInitialized = false
     }
 
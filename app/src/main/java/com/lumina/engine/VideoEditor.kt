@@ -15,9 +15,22 @@ import kotlinx.coroutines.suspendCancellableCoroutine
 import kotlin.coroutines.resume
 
 /**
- * Lightweight video trimming utility using MediaExtractor/MediaMuxer.
+ * Lightweight video trimming utility using MediaExtractor/MediaMuxer, plus the file
+ * handling for clips recorded by the engine ([INativeEngine.startRecording]).
+ *
+ * A trim reads its samples into a slot borrowed from [framePool] when one is free,
+ * and into a buffer of its own otherwise.
  */
-class VideoEditor(private val context: Context) {
+class VideoEditor(
+    private val context: Context,
+    private val framePool: FrameSlotPool? = null
+) {
+
+    /** A new file in the app's movies directory for [INativeEngine.startRecording]. */
+    fun newRecordingFile(): File = newOutputFile("lumina_rec")
+
+    /** Makes a finished recording visible to the media store and returns its Uri. */
+    suspend fun publishRecording(file: File): Uri = withContext(Dispatchers.IO) { scan(file) }
 
     suspend fun trimVideo(
         inputUri: Uri,
@@ -28,11 +41,11 @@ class VideoEditor(private val context: Context) {
             return@withContext Result.failure(IllegalArgumentException("End must be greater than start"))
         }
 
-        val outputDir = context.getExternalFilesDir(Environment.DIRECTORY_MOVIES) ?: context.filesDir
-        val outputFile = File(outputDir, "lumina_trim_${System.currentTimeMillis()}.mp4")
+        val outputFile = newOutputFile("lumina_trim")
 
         val extractor = MediaExtractor()
         var muxer: MediaMuxer? = null
+        var slot: FrameSlotPool.Slot? = null
 
         try {
             extractor.setDataSource(context, inputUri, null)
@@ -59,7 +72,9 @@ class VideoEditor(private val context: Context) {
                 runCatching { extractor.getTrackFormat(track).getInteger(MediaFormat.KEY_MAX_INPUT_SIZE) }.getOrNull()
             }.maxOrNull()?.coerceAtLeast(64 * 1024) ?: 256 * 1024
 
-            val buffer = DirectBufferPool.getDirectBuffer(maxBufferSize)
+            // Handed back unsubmitted below: nothing is uploaded from it.
+            slot = framePool?.acquire(maxBufferSize)
+            val buffer = slot?.buffer ?: ByteBuffer.allocateDirect(maxBufferSize)
             val info = MediaCodec.BufferInfo()
 
             val startUs = startMs * 1000
@@ -94,22 +109,31 @@ class VideoEditor(private val context: Context) {
 
             muxer.stop()
 
-            val scannedUri = suspendCancellableCoroutine<Uri?> { cont ->
-                android.media.MediaScannerConnection.scanFile(
-                    context,
-                    arrayOf(outputFile.absolutePath),
-                    arrayOf("video/mp4")
-                ) { _, uri ->
-                    if (cont.isActive) cont.resume(uri)
-                }
-            }
-
-            return@withContext Result.success(scannedUri ?: Uri.fromFile(outputFile))
+            return@withContext Result.success(scan(outputFile))
         } catch (e: Exception) {
             return@withContext Result.failure(e)
         } finally {
             runCatching { extractor.release() }
             runCatching { muxer?.release() }
+            slot?.let { framePool?.release(it) }
+        }
+    }
+
+    private fun newOutputFile(prefix: String): File {
+        val outputDir = context.getExternalFilesDir(Environment.DIRECTORY_MOVIES) ?: context.filesDir
+        return File(outputDir, "${prefix}_${System.currentTimeMillis()}.mp4")
+    }
+
+    private suspend fun scan(file: File): Uri {
+        val scannedUri = suspendCancellableCoroutine<Uri?> { cont ->
+            android.media.MediaScannerConnection.scanFile(
+                context,
+                arrayOf(file.absolutePath),
+                arrayOf("video/mp4")
+            ) { _, uri ->
+                if (cont.isActive) cont.resume(uri)
+            }
         }
+        return scannedUri ?: Uri.fromFile(file)
     }
 }
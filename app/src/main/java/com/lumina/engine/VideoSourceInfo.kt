@@ -0,0 +1,38 @@
+package com.lumina.engine
+
+/**
+ * A clip opened with [INativeEngine.openVideo] and decoded natively in place of the
+ * camera (video_source.h). Times are in microseconds of media time.
+ */
+data class VideoSourceInfo(
+    val width: Int,
+    val height: Int,
+    val durationUs: Long,
+    val positionUs: Long,
+    val playing: Boolean,
+    /** Every frame has been shown; [INativeEngine.setVideoPlaying] starts over. */
+    val ended: Boolean
+) {
+    companion object {
+        const val INFO_WIDTH = 0
+        const val INFO_HEIGHT = 1
+        const val INFO_DURATION = 2
+        const val INFO_POSITION = 3
+        const val INFO_PLAYING = 4
+        const val INFO_ENDED = 5
+        const val INFO_SIZE = 6
+
+        /** Decodes the array filled by the native engine. */
+        fun fromInfo(info: LongArray): VideoSourceInfo {
+            require(info.size >= INFO_SIZE) { "Video info needs $INFO_SIZE entries, got ${info.size}" }
+            return VideoSourceInfo(
+                width = info[INFO_WIDTH].toInt(),
+                height = info[INFO_HEIGHT].toInt(),
+                durationUs = info[INFO_DURATION],
+                positionUs = info[INFO_POSITION],
+                playing = info[INFO_PLAYING] != 0L,
+                ended = info[INFO_ENDED] != 0L
+            )
+        }
+    }
+}
@@ -0,0 +1,143 @@
+package com.lumina.engine
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Typed engine commands queued into a direct buffer and sent with one
+ * NativeBridge.submitCommands call, plus the preallocated buffer results come back in.
+ *
+ * Mirrors lumina::CommandType / CommandResults in command_stream.h (native byte order,
+ * 4-byte aligned records); keep both in sync. Not thread-safe; queue and submit from
+ * one thread. Touch moves queued before a submit collapse into one record.
+ */
+class CommandBuffer(capacity: Int = DEFAULT_CAPACITY) {
+
+	companion object {
+		const val VERSION = 1
+		const val DEFAULT_CAPACITY = 1024
+		const val RESULTS_SIZE = 64
+
+		const val SET_RENDER_MODE = 1
+		const val SET_PROCESSING = 2
+		const val SET_DIMENSIONS = 3
+		const val SET_TOUCH = 4
+		const val SET_EFFECT = 5
+		const val SET_EFFECT_COUNT = 6
+		const val REQUEST_FRAME = 7
+		const val READ_TIMING = 8
+
+		private const val HEADER_SIZE = 8
+		private const val RESULT_TIMING = 1
+		private const val TIMING_OFFSET = 16
+		private const val MAX_EFFECTS = 4
+	}
+
+	val commands: ByteBuffer = ByteBuffer.allocateDirect(capacity).order(ByteOrder.nativeOrder())
+	val results: ByteBuffer = ByteBuffer.allocateDirect(RESULTS_SIZE).order(ByteOrder.nativeOrder())
+
+	/** Bytes to submit: the version word and every record queued since [clear]. */
+	var size = 4
+		private set
+
+	private var touchRecord = -1
+
+	init {
+		commands.putInt(0, VERSION)
+	}
+
+	val isEmpty: Boolean get() = size == 4
+
+	fun setRenderMode(mode: RenderMode) = putWord(SET_RENDER_MODE, mode.value)
+
+	fun setProcessing(state: ProcessingState) = putWord(SET_PROCESSING, state.value)
+
+	fun setDimensions(width: Int, height: Int): Boolean {
+		val at = begin(SET_DIMENSIONS, 8) ?: return false
+		commands.putInt(at, width)
+		commands.putInt(at + 4, height)
+		return true
+	}
+
+	fun setTouch(position: Vec2, delta: Vec2, pressure: Float, touchState: TouchState): Boolean {
+		val at = if (touchRecord >= 0) touchRecord else begin(SET_TOUCH, 24) ?: return false
+		touchRecord = at
+		commands.putInt(at, touchState.value)
+		commands.putFloat(at + 4, pressure)
+		commands.putFloat(at + 8, position.x)
+		commands.putFloat(at + 12, position.y)
+		commands.putFloat(at + 16, delta.x)
+		commands.putFloat(at + 20, delta.y)
+		return true
+	}
+
+	fun setEffect(index: Int, effect: EffectParams): Boolean {
+		require(index in 0 until MAX_EFFECTS) { "Effect index $index out of range" }
+		val at = begin(SET_EFFECT, 52) ?: return false
+		commands.putInt(at, index)
+		commands.putInt(at + 4, effect.type.value)
+		commands.putFloat(at + 8, effect.intensity)
+		commands.putFloat(at + 12, effect.param1)
+		commands.putFloat(at + 16, effect.param2)
+		commands.putFloat(at + 20, effect.tintColor.r)
+		commands.putFloat(at + 24, effect.tintColor.g)
+		commands.putFloat(at + 28, effect.tintColor.b)
+		commands.putFloat(at + 32, effect.tintColor.a)
+		commands.putFloat(at + 36, effect.center.x)
+		commands.putFloat(at + 40, effect.center.y)
+		commands.putFloat(at + 44, effect.scale.x)
+		commands.putFloat(at + 48, effect.scale.y)
+		return true
+	}
+
+	fun setEffectCount(count: Int) = putWord(SET_EFFECT_COUNT, count.coerceIn(0, MAX_EFFECTS))
+
+	fun requestFrame() = begin(REQUEST_FRAME, 0) != null
+
+	/** Asks the engine to fill [timing] in the results of the next submit. */
+	fun readTiming() = begin(READ_TIMING, 0) != null
+
+	/** Drops every queued record; call after each submit. */
+	fun clear() {
+		size = 4
+		touchRecord = -1
+	}
+
+	/** Records the engine applied / skipped in the last submit. */
+	val applied: Int get() = results.getInt(4)
+	val rejected: Int get() = results.getInt(8)
+
+	/** Frame timing from the last submit, or null when it did not include [readTiming]. */
+	fun timing(): FrameTiming? {
+		if (results.getInt(0) != VERSION || (results.getInt(12) and RESULT_TIMING) == 0) return null
+		return FrameTiming(
+			deltaTime = results.getFloat(TIMING_OFFSET),
+			totalTime = results.getFloat(TIMING_OFFSET + 4),
+			frameCount = results.getLong(TIMING_OFFSET + 8),
+			fps = results.getFloat(TIMING_OFFSET + 16),
+			gpuTime = results.getFloat(TIMING_OFFSET + 20),
+			cpuTime = results.getFloat(TIMING_OFFSET + 24)
+		)
+	}
+
+	/** Resets the result header so a failed submit is not mistaken for the previous one. */
+	fun clearResults() {
+		for (i in 0 until 16 step 4) results.putInt(i, 0)
+	}
+
+	private fun putWord(type: Int, value: Int): Boolean {
+		val at = begin(type, 4) ?: return false
+		commands.putInt(at, value)
+		return true
+	}
+
+	// Appends a header; returns where the payload goes, or null (nothing written) when full.
+	private fun begin(type: Int, payloadSize: Int): Int? {
+		if (size + HEADER_SIZE + payloadSize > commands.capacity()) return null
+		commands.putInt(size, type)
+		commands.putInt(size + 4, payloadSize)
+		val payload = size + HEADER_SIZE
+		size = payload + payloadSize
+		return payload
+	}
+}
@@ -0,0 +1,142 @@
+package com.lumina.engine
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Kotlin view of the shared state block mapped by every layer (NativeEngine.sharedState).
+ *
+ * Mirrors lumina::SharedStateBlock in shared_state.h and python/shared_state.py: a header,
+ * the current / pending intent records the orchestrator writes in place, and a ring of
+ * LuminaState snapshots the engine publishes. Keep offsets and VERSION in sync.
+ */
+object SharedStateLayout {
+	const val MAGIC = 0x4D48534C // "LSHM"
+	const val VERSION = 1
+	const val SIZE = 9216
+
+	const val CURRENT_INTENT = 64
+	const val PENDING_INTENT = 784
+
+	private const val PUBLISH_SEQ = 32
+	private const val INTENT_SEQ = 36
+	private const val SLOTS_OFFSET = 1536
+	private const val SLOT_STRIDE = 2560
+	private const val SLOT_COUNT = 3
+	private const val STATE_OFFSET = 256
+
+	// AIIntent record
+	private const val ACTION_LENGTH = 64
+	private const val TARGET_OFFSET = 64
+	private const val TARGET_LENGTH = 128
+	private const val PARAMS_OFFSET = 192
+	private const val PARAMS_LENGTH = 512
+	private const val CONFIDENCE_OFFSET = 704
+	private const val TIMESTAMP_OFFSET = 708
+
+	// LuminaState fields read back
+	private const val STATE_ID = 4
+	private const val PROCESSING_STATE = 8
+	private const val RENDER_MODE = 16
+	private const val WIDTH = 20
+	private const val HEIGHT = 24
+	private const val ACTIVE_EFFECT_COUNT = 464
+	private const val STATE_CURRENT_INTENT = 544
+
+	private const val MAX_READ_ATTEMPTS = 4
+
+	/** The fields of the newest published LuminaState that Kotlin reads back. */
+	data class Snapshot(
+		val stateId: Int,
+		val processingState: ProcessingState,
+		val renderMode: RenderMode,
+		val width: Int,
+		val height: Int,
+		val activeEffectCount: Int,
+		val currentIntent: AIIntent
+	)
+
+	/** True once the engine has laid out [buffer] with this layout version. */
+	fun isValid(buffer: ByteBuffer): Boolean {
+		if (buffer.capacity() < SIZE) return false
+		buffer.order(ByteOrder.nativeOrder())
+		return buffer.getInt(0) == MAGIC && buffer.getInt(4) == VERSION && buffer.getInt(8) == SIZE
+	}
+
+	/**
+	 * Writes [intent] into the record at [record] ([CURRENT_INTENT] or [PENDING_INTENT]).
+	 * Strings are truncated to whole UTF-8 characters; the engine reads them on commit.
+	 */
+	fun writeIntent(buffer: ByteBuffer, record: Int, intent: AIIntent) {
+		require(record == CURRENT_INTENT || record == PENDING_INTENT) { "Unknown intent record $record" }
+		buffer.order(ByteOrder.nativeOrder())
+		putString(buffer, record, ACTION_LENGTH, intent.action)
+		putString(buffer, record + TARGET_OFFSET, TARGET_LENGTH, intent.target)
+		putString(buffer, record + PARAMS_OFFSET, PARAMS_LENGTH, intent.parameters)
+		buffer.putFloat(record + CONFIDENCE_OFFSET, intent.confidence)
+		buffer.putInt(record + TIMESTAMP_OFFSET, intent.timestamp.toInt())
+	}
+
+	/** Reads the record at [record] back, e.g. the intent the orchestrator just wrote. */
+	fun readIntent(buffer: ByteBuffer, record: Int): AIIntent {
+		buffer.order(ByteOrder.nativeOrder())
+		return AIIntent(
+			action = getString(buffer, record, ACTION_LENGTH),
+			target = getString(buffer, record + TARGET_OFFSET, TARGET_LENGTH),
+			parameters = getString(buffer, record + PARAMS_OFFSET, PARAMS_LENGTH),
+			confidence = buffer.getFloat(record + CONFIDENCE_OFFSET),
+			timestamp = buffer.getInt(record + TIMESTAMP_OFFSET).toLong() and 0xFFFFFFFFL
+		)
+	}
+
+	/** Intent commits the engine has applied so far. */
+	fun intentSeq(buffer: ByteBuffer): Int = buffer.order(ByteOrder.nativeOrder()).getInt(INTENT_SEQ)
+
+	/**
+	 * Newest published state, or null before the first publish or when the engine kept
+	 * overwriting the slot while it was read.
+	 */
+	fun readLatest(buffer: ByteBuffer): Snapshot? {
+		if (!isValid(buffer)) return null
+		repeat(MAX_READ_ATTEMPTS) {
+			val published = buffer.getInt(PUBLISH_SEQ)
+			if (published == 0) return null
+			val slot = SLOTS_OFFSET + Integer.remainderUnsigned(published - 1, SLOT_COUNT) * SLOT_STRIDE
+			val before = buffer.getInt(slot)
+			if ((before and 1) != 0) return@repeat
+			val state = slot + STATE_OFFSET
+			val snapshot = Snapshot(
+				stateId = buffer.getInt(state + STATE_ID),
+				processingState = ProcessingState.values().getOrElse(buffer.getInt(state + PROCESSING_STATE)) { ProcessingState.IDLE },
+				renderMode = RenderMode.values().getOrElse(buffer.getInt(state + RENDER_MODE)) { RenderMode.PASSTHROUGH },
+				width = buffer.getInt(state + WIDTH),
+				height = buffer.getInt(state + HEIGHT),
+				activeEffectCount = buffer.getInt(state + ACTIVE_EFFECT_COUNT),
+				currentIntent = readIntent(buffer, state + STATE_CURRENT_INTENT)
+			)
+			if (buffer.getInt(slot) == before) return snapshot
+		}
+		return null
+	}
+
+	private fun putString(buffer: ByteBuffer, offset: Int, length: Int, value: String) {
+		val bytes = truncateUtf8(value, length - 1)
+		for (i in 0 until length) buffer.put(offset + i, if (i < bytes.size) bytes[i] else 0.toByte())
+	}
+
+	private fun getString(buffer: ByteBuffer, offset: Int, length: Int): String {
+		var end = 0
+		while (end < length && buffer.get(offset + end) != 0.toByte()) end++
+		val bytes = ByteArray(end) { buffer.get(offset + it) }
+		return String(bytes, Charsets.UTF_8)
+	}
+
+	private fun truncateUtf8(value: String, maxBytes: Int): ByteArray {
+		val bytes = value.toByteArray(Charsets.UTF_8)
+		if (bytes.size <= maxBytes) return bytes
+		var end = maxBytes
+		// Back off continuation bytes (10xxxxxx) so no character is cut in half.
+		while (end > 0 && (bytes[end].toInt() and 0xC0) == 0x80) end--
+		return bytes.copyOf(end)
+	}
+}
@@ -0,0 +1,66 @@
+package com.lumina.engine
+
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+
+/**
+ * Binary encoding of the hot LuminaState fields for NativeEngine.updateStateBinary.
+ *
+ * Mirrors lumina::StatePacket in state_packet.h (256 bytes, native byte order). Only the
+ * groups set in the dirty mask are applied natively; keep offsets and VERSION in sync.
+ */
+object StatePacket {
+	const val VERSION = 1
+	const val SIZE = 256
+
+	const val DIRTY_DIMENSIONS = 1 shl 0
+	const val DIRTY_RENDER_MODE = 1 shl 1
+	const val DIRTY_PROCESSING = 1 shl 2
+	const val DIRTY_TOUCH = 1 shl 3
+	const val DIRTY_EFFECTS = 1 shl 4
+	const val DIRTY_ALL = 0x1F
+
+	private const val EFFECTS_OFFSET = 64
+	private const val EFFECT_STRIDE = 48
+	private const val MAX_EFFECTS = 4
+
+	fun allocate(): ByteBuffer = ByteBuffer.allocateDirect(SIZE).order(ByteOrder.nativeOrder())
+
+	/** Writes [state] into [buffer] (from [allocate]) and returns it ready to send. */
+	fun encode(state: LuminaState, dirtyMask: Int, buffer: ByteBuffer): ByteBuffer {
+		require(buffer.isDirect && buffer.capacity() >= SIZE) { "StatePacket needs a direct buffer of $SIZE bytes" }
+		buffer.order(ByteOrder.nativeOrder())
+		buffer.putInt(0, VERSION)
+		buffer.putInt(4, dirtyMask)
+		buffer.putInt(8, state.renderMode.value)
+		buffer.putInt(12, state.processingState.value)
+		buffer.putInt(16, state.width)
+		buffer.putInt(20, state.height)
+		buffer.putInt(24, state.touchState.value)
+		buffer.putFloat(28, state.touchPressure)
+		buffer.putFloat(32, state.touchPosition.x)
+		buffer.putFloat(36, state.touchPosition.y)
+		buffer.putFloat(40, state.touchDelta.x)
+		buffer.putFloat(44, state.touchDelta.y)
+		buffer.putInt(48, state.activeEffectCount.coerceIn(0, MAX_EFFECTS))
+
+		for (i in 0 until MAX_EFFECTS) {
+			val effect = state.effects.getOrNull(i) ?: EffectParams()
+			val base = EFFECTS_OFFSET + i * EFFECT_STRIDE
+			buffer.putInt(base, effect.type.value)
+			buffer.putFloat(base + 4, effect.intensity)
+			buffer.putFloat(base + 8, effect.param1)
+			buffer.putFloat(base + 12, effect.param2)
+			buffer.putFloat(base + 16, effect.tintColor.r)
+			buffer.putFloat(base + 20, effect.tintColor.g)
+			buffer.putFloat(base + 24, effect.tintColor.b)
+			buffer.putFloat(base + 28, effect.tintColor.a)
+			buffer.putFloat(base + 32, effect.center.x)
+			buffer.putFloat(base + 36, effect.center.y)
+			buffer.putFloat(base + 40, effect.scale.x)
+			buffer.putFloat(base + 44, effect.scale.y)
+		}
+		buffer.clear()
+		return buffer
+	}
+}
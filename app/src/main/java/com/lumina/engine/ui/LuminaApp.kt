@@ -6,6 +6,7 @@ import androidx.compose.foundation.background
 import androidx.compose.foundation.layout.*
 import androidx.compose.material3.*
 import androidx.compose.runtime.Composable
+import androidx.compose.runtime.CompositionLocalProvider
 import androidx.compose.runtime.LaunchedEffect
 import androidx.compose.runtime.collectAsState
 import androidx.compose.runtime.getValue
@@ -36,11 +37,13 @@ import com.lumina.engine.VideoEditor
 import com.lumina.engine.CameraController
 import com.lumina.engine.LuminaViewModel
 import com.lumina.engine.ui.components.CameraPreviewArea
+import com.lumina.engine.ui.components.GlassPanelRegistry
 import com.lumina.engine.ui.components.GlassyContainer
 import com.lumina.engine.ui.components.GlassyInputBar
 import com.lumina.engine.ui.components.GlassyRenderModeSelector
 import com.lumina.engine.ui.components.GlassyStatusIndicator
 import com.lumina.engine.ui.components.IntentSummaryCard
+import com.lumina.engine.ui.components.LocalGlassPanels
 import com.lumina.engine.ui.components.QuickActionButton
 import com.lumina.engine.ui.components.VideoEditorCard
 import com.lumina.engine.ui.components.ErrorBanner
@@ -96,86 +99,96 @@ fun LuminaApp(
 
     val modelDownloader = remember { ModelDownloader(context) }
 
-    Scaffold(
-        snackbarHost = { SnackbarHost(hostState = snackbarHostState) }
-    ) { padding ->
-        Box(
-            modifier = Modifier
-                .fillMaxSize()
-                .background(Color.Black)
-                .padding(padding)
-                .systemBarsPadding()
-        ) {
-            // Full-screen camera preview with minimalist UI overlays
-            CameraPreviewArea(
-                cameraController = cameraController,
-                nativeEngine = nativeBridge as? NativeEngine,
-                onMessage = { msg, isError ->
-                    scope.launch {
-                        snackbarHostState.showSnackbar(
-                            message = msg,
-                            withDismissAction = true,
-                            duration = if (isError) SnackbarDuration.Long else SnackbarDuration.Short
-                        )
-                    }
-                },
-                onVideoSaved = { uriString ->
-                    lastVideoUri = uriString
-                    trimStatus = "Video ready to edit"
-                }
-                ,
-                onRequestModelDownload = {
-                    scope.launch { modelDownloader.ensureModelAvailable() }
-                }
-            )
+    // The engine starts asynchronously; camera wiring needs its texture and upload paths.
+    val nativeEngine = nativeBridge as? NativeEngine
+    val engineReady = nativeEngine?.ready?.collectAsState()?.value ?: false
+    val readyEngine = nativeEngine?.takeIf { engineReady }
 
-            // The ModelDownloader sits above the preview so we can start it
-            val modelState by modelDownloader.state.collectAsState(initial = com.lumina.engine.ModelDownloader.DownloadState.Idle)
+    // Frosted panels report where they sit so the engine blurs the frame behind them.
+    val glassPanels = remember(readyEngine) { readyEngine?.let { GlassPanelRegistry(it::setGlassPanels) } }
 
-            // Start the model download on first compose
-            LaunchedEffect(modelDownloader) {
-                modelDownloader.ensureModelAvailable()
-            }
+    CompositionLocalProvider(LocalGlassPanels provides glassPanels) {
+        Scaffold(
+            snackbarHost = { SnackbarHost(hostState = snackbarHostState) }
+        ) { padding ->
+            Box(
+                modifier = Modifier
+                    .fillMaxSize()
+                    .background(Color.Black)
+                    .padding(padding)
+                    .systemBarsPadding()
+            ) {
+                // Full-screen camera preview with minimalist UI overlays
+                CameraPreviewArea(
+                    cameraController = cameraController,
+                    nativeEngine = readyEngine,
+                    onMessage = { msg, isError ->
+                        scope.launch {
+                            snackbarHostState.showSnackbar(
+                                message = msg,
+                                withDismissAction = true,
+                                duration = if (isError) SnackbarDuration.Long else SnackbarDuration.Short
+                            )
+                        }
+                    },
+                    onVideoSaved = { uriString ->
+                        lastVideoUri = uriString
+                        trimStatus = "Video ready to edit"
+                    }
+                    ,
+                    onRequestModelDownload = {
+                        scope.launch { modelDownloader.ensureModelAvailable() }
+                    }
+                )
 
-            // Show a subtle model download indicator at top
-            when (modelState) {
-                is com.lumina.engine.ModelDownloader.DownloadState.Checking -> {
-                    LinearProgressIndicator(
-                        modifier = Modifier
-                            .align(Alignment.TopCenter)
-                            .fillMaxWidth(),
-                        color = Color(0xFF66D9FF)
-                    )
+                // The ModelDownloader sits above the preview so we can start it
+                val modelState by modelDownloader.state.collectAsState(initial = com.lumina.engine.ModelDownloader.DownloadState.Idle)
+
+                // Start the model download on first compose
+                LaunchedEffect(modelDownloader) {
+                    modelDownloader.ensureModelAvailable()
                 }
-                is com.lumina.engine.ModelDownloader.DownloadState.Downloading -> {
-                    val progress = (modelState as com.lumina.engine.ModelDownloader.DownloadState.Downloading).progress
-                    Column(modifier = Modifier.align(Alignment.TopCenter).padding(top = 8.dp)) {
+
+                // Show a subtle model download indicator at top
+                when (modelState) {
+                    is com.lumina.engine.ModelDownloader.DownloadState.Checking -> {
+                        LinearProgressIndicator(
+                            modifier = Modifier
+                                .align(Alignment.TopCenter)
+                                .fillMaxWidth(),
+                            color = Color(0xFF66D9FF)
+                        )
+                    }
+                    is com.lumina.engine.ModelDownloader.DownloadState.Downloading -> {
+                        val progress = (modelState as com.lumina.engine.ModelDownloader.DownloadState.Downloading).progress
+                        Column(modifier = Modifier.align(Alignment.TopCenter).padding(top = 8.dp)) {
+                            Text(
+                                text = "Downloading model... ${(progress * 100).toInt()}%",
+                                color = Color.White.copy(alpha = 0.9f)
+                            )
+                            LinearProgressIndicator(
+                                progress = progress,
+                                modifier = Modifier.fillMaxWidth(0.6f).height(6.dp)
+                            )
+                        }
+                    }
+                    is com.lumina.engine.ModelDownloader.DownloadState.Error -> {
+                        val message = (modelState as com.lumina.engine.ModelDownloader.DownloadState.Error).message
                         Text(
-                            text = "Downloading model... ${(progress * 100).toInt()}%",
-                            color = Color.White.copy(alpha = 0.9f)
+                            text = "Model download failed: $message",
+                            color = Color.Red,
+                            modifier = Modifier.align(Alignment.TopCenter).padding(8.dp)
                         )
-                        LinearProgressIndicator(
-                            progress = progress,
-                            modifier = Modifier.fillMaxWidth(0.6f).height(6.dp)
+                    }
+                    is com.lumina.engine.ModelDownloader.DownloadState.Completed -> {
+                        Text(
+                            text = "AI model ready",
+                            color = Color.White.copy(alpha = 0.8f),
+                            modifier = Modifier.align(Alignment.TopCenter).padding(8.dp)
                         )
                     }
+                    else -> Unit
                 }
-                is com.lumina.engine.ModelDownloader.DownloadState.Error -> {
-                    val message = (modelState as com.lumina.engine.ModelDownloader.DownloadState.Error).message
-                    Text(
-                        text = "Model download failed: $message",
-                        color = Color.Red,
-                        modifier = Modifier.align(Alignment.TopCenter).padding(8.dp)
-                    )
-                }
-                is com.lumina.engine.ModelDownloader.DownloadState.Completed -> {
-                    Text(
-                        text = "AI model ready",
-                        color = Color.White.copy(alpha = 0.8f),
-                        modifier = Modifier.align(Alignment.TopCenter).padding(8.dp)
-                    )
-                }
-                else -> Unit
             }
         }
     }
@@ -15,7 +15,6 @@ import androidx.compose.material.icons.filled.Send
 import androidx.compose.material.icons.filled.Stop
 import androidx.compose.material3.*
 import androidx.compose.runtime.*
-// ByteBuffer imports removed; buffer pool centralized in DirectBufferPool
 import androidx.compose.ui.Alignment
 import androidx.compose.ui.Modifier
 import androidx.compose.ui.draw.clip
@@ -31,6 +30,7 @@ import com.lumina.engine.CameraController
 import com.lumina.engine.CachingImageAnalyzer // [ADD THIS IMPORT]
 import com.lumina.engine.INativeEngine
 import com.lumina.engine.createCameraAnalyzer
+import com.lumina.engine.uploadCameraFrameYuv
 
 
 @OptIn(ExperimentalMaterial3Api::class)
@@ -65,7 +65,11 @@ fun CameraPreviewArea(
     // This ensures the cached buffer is not lost when the UI recomposes.
     val vulkanAnalyzer = remember(nativeEngine) {
         if (nativeEngine != null) {
-            CachingImageAnalyzer { buffer, width, height ->
+            CachingImageAnalyzer(
+                onHardwareBuffer = { hardwareBuffer -> nativeEngine.uploadCameraFrame(hardwareBuffer) },
+                releasedHardwareBuffers = { nativeEngine.releasedCameraFrames() },
+                onYuvFrame = { image -> nativeEngine.uploadCameraFrameYuv(image) }
+            ) { buffer, width, height ->
                 nativeEngine.uploadCameraFrame(buffer, width, height)
             }
         } else null
@@ -97,7 +101,7 @@ fun CameraPreviewArea(
         }
     }
 
-    LaunchedEffect(activeSurface) {
+    LaunchedEffect(activeSurface, nativeEngine) {
         // Determine if we need to feed frames manually (Vulkan mode)
         // If activeSurface is NULL (Vulkan) and we have a native engine, we attach the persistent analyzer.
         val useAnalyzer = (activeSurface == null && nativeEngine != null)
@@ -111,7 +115,7 @@ fun CameraPreviewArea(
             }
     }
 
-    DisposableEffect(lifecycleOwner, activeSurface) {
+    DisposableEffect(lifecycleOwner, activeSurface, nativeEngine) {
         val observer = androidx.lifecycle.LifecycleEventObserver { _, event ->
                     when (event) {
                     androidx.lifecycle.Lifecycle.Event.ON_RESUME -> {
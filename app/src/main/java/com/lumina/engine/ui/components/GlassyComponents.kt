@@ -11,14 +11,20 @@ import androidx.compose.material.icons.filled.Send
 import androidx.compose.material.icons.filled.Warning
 import androidx.compose.material3.*
 import androidx.compose.runtime.Composable
+import androidx.compose.runtime.DisposableEffect
 import androidx.compose.runtime.getValue
+import androidx.compose.runtime.remember
+import androidx.compose.runtime.staticCompositionLocalOf
 import androidx.compose.ui.Alignment
 import androidx.compose.ui.Modifier
-import androidx.compose.ui.draw.blur
 import androidx.compose.ui.draw.clip
 import androidx.compose.ui.draw.scale
 import androidx.compose.ui.graphics.Brush
 import androidx.compose.ui.graphics.Color
+import androidx.compose.ui.layout.boundsInRoot
+import androidx.compose.ui.layout.findRootCoordinates
+import androidx.compose.ui.layout.onGloballyPositioned
+import androidx.compose.ui.platform.LocalDensity
 import androidx.compose.ui.text.TextStyle
 import androidx.compose.ui.unit.Dp
 import androidx.compose.ui.unit.dp
@@ -28,14 +34,64 @@ import com.lumina.engine.GlassmorphicParams
 import com.lumina.engine.ProcessingState
 import com.lumina.engine.RenderMode
 
+/**
+ * Where every [GlassyContainer] on screen sits, passed on to the engine (see
+ * INativeEngine.setGlassPanels) so it blurs the frame behind each panel on the GPU.
+ * Bounds are fractions of the window, which the engine surface fills.
+ */
+class GlassPanelRegistry(private val onChanged: (FloatArray) -> Unit) {
+    private val panels = LinkedHashMap<Any, FloatArray>()
+
+    fun update(key: Any, panel: FloatArray) {
+        if (panels[key]?.contentEquals(panel) == true) return
+        panels[key] = panel
+        publish()
+    }
+
+    fun remove(key: Any) {
+        if (panels.remove(key) != null) publish()
+    }
+
+    private fun publish() {
+        onChanged(panels.values.fold(FloatArray(0)) { all, panel -> all + panel })
+    }
+}
+
+/** The registry glass panels report to; null leaves them to Compose alone. */
+val LocalGlassPanels = staticCompositionLocalOf<GlassPanelRegistry?> { null }
+
 @Composable
 fun GlassyContainer(
     modifier: Modifier = Modifier,
     params: GlassmorphicParams = GlassmorphicParams(),
     content: @Composable BoxScope.() -> Unit
 ) {
+    val glassPanels = LocalGlassPanels.current
+    val density = LocalDensity.current
+    val panelKey = remember { Any() }
+    DisposableEffect(glassPanels) {
+        onDispose { glassPanels?.remove(panelKey) }
+    }
+
     Box(
         modifier = modifier
+            .onGloballyPositioned { coordinates ->
+                val registry = glassPanels ?: return@onGloballyPositioned
+                val root = coordinates.findRootCoordinates().size
+                if (root.width == 0 || root.height == 0) return@onGloballyPositioned
+                val bounds = coordinates.boundsInRoot()
+                val radius = with(density) { params.cornerRadius.dp.toPx() }
+                registry.update(
+                    panelKey,
+                    floatArrayOf(
+                        bounds.left / root.width,
+                        bounds.top / root.height,
+                        bounds.right / root.width,
+                        bounds.bottom / root.height,
+                        radius / root.width
+                    )
+                )
+            }
             .clip(RoundedCornerShape(params.cornerRadius.dp))
             .background(
                 brush = Brush.linearGradient(
@@ -55,7 +111,6 @@ fun GlassyContainer(
                 ),
                 shape = RoundedCornerShape(params.cornerRadius.dp)
             )
-            .blur(radius = 0.5.dp)
     ) {
         content()
     }
@@ -25,6 +25,7 @@ from pipeline import (
 )
 from classifiers import rule_based_classify
 from config import OrchestratorConfig
+from shared_state import SharedStateBlock
 
 # Shared model filename for consistency with Kotlin downloader
 MODEL_FILENAME = "qwen3-1.7b-instruct-q4_k_m.gguf"
@@ -304,6 +305,9 @@ User: "Show depth"
 # Global orchestrator instance for JNI access
 _orchestrator: Optional[LuminaOrchestrator] = None
 
+# Shared state block mapped from the engine, once Kotlin attaches it
+_shared_state: Optional[SharedStateBlock] = None
+
 
 def initialize(assets_path: str) -> bool:
     """Initialize the orchestrator (called from Kotlin)"""
@@ -323,9 +327,42 @@ def parse_intent(user_input: str) -> str:
     return intent.to_json()
 
 
+def attach_shared_state(fd: int) -> bool:
+    """Map the engine's shared state block from `fd`, which is closed (called from Kotlin)"""
+    global _shared_state
+    detach_shared_state()
+    try:
+        _shared_state = SharedStateBlock.from_fd(fd)
+    except (OSError, ValueError) as exc:
+        print(f"Shared state block unavailable: {exc}")
+        return False
+    return True
+
+
+def detach_shared_state():
+    global _shared_state
+    if _shared_state is not None:
+        _shared_state.close()
+        _shared_state = None
+
+
+def parse_intent_shared(user_input: str) -> bool:
+    """Parse intent into the shared block's current intent record (called from Kotlin)"""
+    global _orchestrator
+    if _shared_state is None:
+        raise RuntimeError("shared state block not attached")
+    if _orchestrator is None:
+        _orchestrator = LuminaOrchestrator()
+        _orchestrator.initialize()
+
+    _shared_state.write_intent(_orchestrator.parse_intent(user_input))
+    return True
+
+
 def shutdown():
     """Shutdown the orchestrator (called from Kotlin)"""
     global _orchestrator
+    detach_shared_state()
     if _orchestrator:
         _orchestrator.shutdown()
         _orchestrator = None
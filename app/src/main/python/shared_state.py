@@ -0,0 +1,131 @@
+"""Python view of the shared state block (shared_state.h).
+
+The engine lays the block out in SharedMemory; the orchestrator maps the same pages
+with mmap and writes its intents straight into the current / pending records, which
+the engine applies when Kotlin commits them. The newest LuminaState snapshot can be
+read back the same way. Mirrors lumina::SharedStateBlock and the Kotlin
+SharedStateLayout - keep offsets and VERSION in sync.
+"""
+import mmap
+import os
+import struct
+from typing import Any, Dict, Optional
+
+from intent_types import AIIntent, clamp_confidence
+
+MAGIC = 0x4D48534C  # "LSHM"
+VERSION = 1
+SIZE = 9216
+
+CURRENT_INTENT = 64
+PENDING_INTENT = 784
+
+_PUBLISH_SEQ = 32
+_INTENT_SEQ = 36
+_SLOTS_OFFSET = 1536
+_SLOT_STRIDE = 2560
+_SLOT_COUNT = 3
+_STATE_OFFSET = 256
+_MAX_READ_ATTEMPTS = 4
+
+# AIIntent record: action[64], target[128], parameters[512], confidence, timestamp
+_INTENT = struct.Struct("=64s128s512sfI")
+_WORD = struct.Struct("=I")
+# LuminaState: version, stateId, processingState, flags, renderMode, width, height
+_STATE_HEAD = struct.Struct("=7I")
+_ACTIVE_EFFECT_COUNT = 464
+_STATE_CURRENT_INTENT = 544
+
+
+def _encode(value: str, size: int) -> bytes:
+    """UTF-8 bytes of `value` cut to whole characters below `size` (room for the NUL)."""
+    data = value.encode("utf-8")[: size - 1]
+    return data.decode("utf-8", errors="ignore").encode("utf-8")
+
+
+def _decode(raw: bytes) -> str:
+    return raw.split(b"\0", 1)[0].decode("utf-8", errors="replace")
+
+
+class SharedStateBlock:
+    """A mapped block: an mmap of the engine's descriptor, or any writable buffer in tests."""
+
+    def __init__(self, buffer: Any):
+        self._buffer = buffer
+        self._view = memoryview(buffer)
+        if len(self._view) < SIZE:
+            raise ValueError("shared state block needs %d bytes" % SIZE)
+        magic, version, size = struct.unpack_from("=3I", self._view, 0)
+        if magic != MAGIC or version != VERSION or size != SIZE:
+            raise ValueError("shared state block layout mismatch")
+
+    @classmethod
+    def from_fd(cls, fd: int) -> "SharedStateBlock":
+        """Maps the block behind `fd`, which is closed either way; mmap keeps its own."""
+        try:
+            return cls(mmap.mmap(fd, SIZE))
+        finally:
+            os.close(fd)
+
+    def write_intent(self, intent: AIIntent, record: int = CURRENT_INTENT) -> None:
+        if record not in (CURRENT_INTENT, PENDING_INTENT):
+            raise ValueError("unknown intent record %d" % record)
+        _INTENT.pack_into(
+            self._view,
+            record,
+            _encode(intent.action, 64),
+            _encode(intent.target, 128),
+            _encode(intent.parameters, 512),
+            clamp_confidence(intent.confidence),
+            int(intent.timestamp) & 0xFFFFFFFF,
+        )
+
+    def read_intent(self, record: int = CURRENT_INTENT) -> AIIntent:
+        return self._intent_at(record)
+
+    def intent_seq(self) -> int:
+        return _WORD.unpack_from(self._view, _INTENT_SEQ)[0]
+
+    def read_latest(self) -> Optional[Dict[str, Any]]:
+        """Fields of the newest published LuminaState, or None before the first publish
+        or when the engine kept rewriting the slot during the copy."""
+        for _ in range(_MAX_READ_ATTEMPTS):
+            published = _WORD.unpack_from(self._view, _PUBLISH_SEQ)[0]
+            if published == 0:
+                return None
+            slot = _SLOTS_OFFSET + ((published - 1) % _SLOT_COUNT) * _SLOT_STRIDE
+            before = _WORD.unpack_from(self._view, slot)[0]
+            if before & 1:
+                continue
+            state = slot + _STATE_OFFSET
+            _, state_id, processing, _, render_mode, width, height = _STATE_HEAD.unpack_from(self._view, state)
+            snapshot = {
+                "stateId": state_id,
+                "processingState": processing,
+                "renderMode": render_mode,
+                "width": width,
+                "height": height,
+                "activeEffectCount": _WORD.unpack_from(self._view, state + _ACTIVE_EFFECT_COUNT)[0],
+                "currentIntent": self._intent_at(state + _STATE_CURRENT_INTENT),
+            }
+            if _WORD.unpack_from(self._view, slot)[0] == before:
+                return snapshot
+        return None
+
+    def close(self) -> None:
+        self._view.release()
+        if isinstance(self._buffer, mmap.mmap):
+            self._buffer.close()
+
+    def _intent_at(self, offset: int) -> AIIntent:
+        action, target, parameters, confidence, timestamp = _INTENT.unpack_from(self._view, offset)
+        return AIIntent(
+            action=_decode(action),
+            target=_decode(target),
+            parameters=_decode(parameters),
+            confidence=confidence,
+            timestamp=timestamp,
+        )
+
+
+__all__ = ["SharedStateBlock", "CURRENT_INTENT", "PENDING_INTENT", "SIZE", "VERSION", "MAGIC"]
@@ -0,0 +1,70 @@
+package com.lumina.engine
+
+import com.google.common.truth.Truth.assertThat
+import org.junit.Test
+import java.nio.ByteBuffer
+
+/**
+ * Buffer sizing of AnalysisFrameReader against an in-memory stand-in for lumina::AnalysisFrameExchange
+ */
+class AnalysisFrameReaderTest {
+
+    private class FakeBackend : AnalysisFrameReader.Backend {
+        var width = 0
+        var height = 0
+        var gray = false
+        var frameNumber = 0L
+        var unread = false
+        val capacities = mutableListOf<Int>()
+
+        fun publish(width: Int, height: Int, gray: Boolean) {
+            this.width = width
+            this.height = height
+            this.gray = gray
+            frameNumber++
+            unread = true
+        }
+
+        override fun read(buffer: ByteBuffer?, info: LongArray): Int {
+            capacities += buffer?.capacity() ?: 0
+            info[AnalysisFrameReader.INFO_WIDTH] = width.toLong()
+            info[AnalysisFrameReader.INFO_HEIGHT] = height.toLong()
+            info[AnalysisFrameReader.INFO_FORMAT] = if (gray) 1L else 0L
+            info[AnalysisFrameReader.INFO_FRAME_NUMBER] = frameNumber
+            info[AnalysisFrameReader.INFO_TIMESTAMP] = frameNumber * 1000
+            val size = width * height * (if (gray) 1 else 3)
+            if (!unread || buffer == null || buffer.capacity() < size) return 0
+            unread = false
+            return size
+        }
+    }
+
+    @Test
+    fun `frames reuse one buffer until they grow`() {
+        val backend = FakeBackend()
+        val reader = AnalysisFrameReader(backend)
+        assertThat(reader.read()).isNull()
+
+        backend.publish(16, 8, gray = false)
+        val first = reader.read()!!
+        assertThat(first.pixels.remaining()).isEqualTo(16 * 8 * 3)
+        assertThat(first.grayscale).isFalse()
+        assertThat(first.frameNumber).isEqualTo(1)
+        // Nothing new: no reallocation, no frame.
+        assertThat(reader.read()).isNull()
+
+        backend.publish(16, 8, gray = true)
+        val second = reader.read()!!
+        assertThat(second.grayscale).isTrue()
+        assertThat(second.pixels).isSameInstanceAs(first.pixels)
+        assertThat(second.pixels.remaining()).isEqualTo(16 * 8)
+        assertThat(second.timestampNanos).isEqualTo(2000)
+
+        backend.publish(32, 16, gray = false)
+        val third = reader.read()!!
+        assertThat(third.pixels).isNotSameInstanceAs(first.pixels)
+        assertThat(third.width).isEqualTo(32)
+        val small = 16 * 8 * 3
+        assertThat(backend.capacities).containsExactly(0, 0, small, small, small, small, 32 * 16 * 3).inOrder()
+    }
+}
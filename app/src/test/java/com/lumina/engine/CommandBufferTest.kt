@@ -0,0 +1,75 @@
+package com.lumina.engine
+
+import com.google.common.truth.Truth.assertThat
+import org.junit.Test
+
+/**
+ * Layout checks for the command stream mirrored by lumina::CommandType / CommandResults
+ */
+class CommandBufferTest {
+
+    @Test
+    fun `records follow the version word with type and payload size`() {
+        val buffer = CommandBuffer()
+        assertThat(buffer.isEmpty).isTrue()
+        buffer.setRenderMode(RenderMode.SEGMENTED)
+        buffer.readTiming()
+
+        val commands = buffer.commands
+        assertThat(commands.getInt(0)).isEqualTo(CommandBuffer.VERSION)
+        assertThat(commands.getInt(4)).isEqualTo(CommandBuffer.SET_RENDER_MODE)
+        assertThat(commands.getInt(8)).isEqualTo(4)
+        assertThat(commands.getInt(12)).isEqualTo(RenderMode.SEGMENTED.value)
+        assertThat(commands.getInt(16)).isEqualTo(CommandBuffer.READ_TIMING)
+        assertThat(commands.getInt(20)).isEqualTo(0)
+        assertThat(buffer.size).isEqualTo(24)
+    }
+
+    @Test
+    fun `touch moves collapse into one record`() {
+        val buffer = CommandBuffer()
+        buffer.setTouch(Vec2(0.1f, 0.2f), Vec2(), 1f, TouchState.DOWN)
+        buffer.setEffectCount(1)
+        buffer.setTouch(Vec2(0.3f, 0.4f), Vec2(0.2f, 0.2f), 0.5f, TouchState.MOVE)
+
+        assertThat(buffer.size).isEqualTo(4 + (8 + 24) + (8 + 4))
+        assertThat(buffer.commands.getInt(12)).isEqualTo(TouchState.MOVE.value)
+        assertThat(buffer.commands.getFloat(20)).isEqualTo(0.3f)
+
+        buffer.clear()
+        buffer.setTouch(Vec2(), Vec2(), 0f, TouchState.UP)
+        assertThat(buffer.size).isEqualTo(4 + 8 + 24)
+    }
+
+    @Test
+    fun `a full buffer refuses records without writing them`() {
+        val buffer = CommandBuffer(capacity = 4 + 8 + 52)
+        assertThat(buffer.setEffect(0, EffectParams(type = EffectType.BLOOM))).isTrue()
+        assertThat(buffer.setEffectCount(1)).isFalse()
+        assertThat(buffer.size).isEqualTo(64)
+        assertThat(buffer.commands.getInt(16)).isEqualTo(EffectType.BLOOM.value)
+    }
+
+    @Test
+    fun `timing is read only when the engine filled it`() {
+        val buffer = CommandBuffer()
+        assertThat(buffer.timing()).isNull()
+
+        val results = buffer.results
+        results.putInt(0, CommandBuffer.VERSION)
+        results.putInt(4, 1)
+        results.putInt(12, 1)
+        results.putFloat(16, 0.016f)
+        results.putLong(24, 120L)
+        results.putFloat(32, 60f)
+
+        assertThat(buffer.applied).isEqualTo(1)
+        val timing = buffer.timing()
+        assertThat(timing?.deltaTime).isEqualTo(0.016f)
+        assertThat(timing?.frameCount).isEqualTo(120L)
+        assertThat(timing?.fps).isEqualTo(60f)
+
+        buffer.clearResults()
+        assertThat(buffer.timing()).isNull()
+    }
+}
@@ -0,0 +1,26 @@
+package com.lumina.engine
+
+import com.google.common.truth.Truth.assertThat
+import org.junit.Test
+
+class ExportProgressTest {
+
+    @Test
+    fun `fromInfo reads the native layout`() {
+        val info = LongArray(ExportProgress.INFO_SIZE)
+        info[ExportProgress.INFO_FRAMES] = 900
+        info[ExportProgress.INFO_POSITION] = 30_000_000
+        info[ExportProgress.INFO_DURATION] = 60_000_000
+        info[ExportProgress.INFO_RUNNING] = 1
+
+        val progress = ExportProgress.fromInfo(info)
+        assertThat(progress).isEqualTo(ExportProgress(900, 30_000_000, 60_000_000, running = true, succeeded = false))
+        assertThat(progress.fraction).isEqualTo(0.5f)
+    }
+
+    @Test
+    fun `fraction is complete only on success`() {
+        assertThat(ExportProgress(10, 59_000_000, 60_000_000, running = false, succeeded = true).fraction).isEqualTo(1f)
+        assertThat(ExportProgress(10, 5, 0, running = true, succeeded = false).fraction).isEqualTo(0f)
+    }
+}
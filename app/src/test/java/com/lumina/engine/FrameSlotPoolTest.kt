@@ -0,0 +1,81 @@
+package com.lumina.engine
+
+import com.google.common.truth.Truth.assertThat
+import org.junit.Test
+import java.nio.ByteBuffer
+
+/**
+ * Acquire/submit handshake of FrameSlotPool against an in-memory stand-in for lumina::FramePool
+ */
+class FrameSlotPoolTest {
+
+    private class FakeBackend : FrameSlotPool.Backend {
+        var buffers = emptyList<ByteBuffer>()
+        val acquired = mutableSetOf<Int>()
+        val submitted = mutableListOf<Triple<Int, Int, Int>>()
+        var configureCalls = 0
+
+        override fun configure(slotCount: Int, slotBytes: Int): Boolean {
+            if (acquired.isNotEmpty()) return false
+            configureCalls++
+            buffers = List(slotCount) { ByteBuffer.allocateDirect(slotBytes) }
+            return true
+        }
+
+        override fun acquire(): Int {
+            val index = buffers.indices.firstOrNull { it !in acquired } ?: return -1
+            acquired += index
+            return index
+        }
+
+        override fun buffer(index: Int): ByteBuffer? = buffers.getOrNull(index)
+
+        override fun submit(index: Int, size: Int, width: Int, height: Int) {
+            submitted += Triple(index, size, width * height)
+            acquired -= index
+        }
+
+        override fun release(index: Int) {
+            acquired -= index
+        }
+    }
+
+    @Test
+    fun `slots are reused and returned only through submit or release`() {
+        val backend = FakeBackend()
+        val pool = FrameSlotPool(backend, slotCount = 2)
+
+        val first = pool.acquire(1024)!!
+        val second = pool.acquire(1024)!!
+        assertThat(first.index).isNotEqualTo(second.index)
+        // Both slots are in flight: the next frame is dropped instead of overwriting one.
+        assertThat(pool.acquire(1024)).isNull()
+
+        first.buffer.put(ByteArray(100))
+        pool.submit(first, 5, 20)
+        assertThat(backend.submitted).containsExactly(Triple(first.index, 100, 100))
+
+        val again = pool.acquire(512)!!
+        assertThat(again).isSameInstanceAs(first)
+        assertThat(again.buffer.position()).isEqualTo(0)
+        pool.release(again)
+        pool.release(second)
+        assertThat(backend.acquired).isEmpty()
+        assertThat(backend.configureCalls).isEqualTo(1)
+    }
+
+    @Test
+    fun `growing reallocates only once every slot is back`() {
+        val backend = FakeBackend()
+        val pool = FrameSlotPool(backend, slotCount = 2)
+
+        val small = pool.acquire(1024)!!
+        assertThat(pool.acquire(1 shl 20)).isNull()
+
+        pool.release(small)
+        val large = pool.acquire(1 shl 20)!!
+        assertThat(large.buffer.capacity()).isAtLeast(1 shl 20)
+        assertThat(large).isNotSameInstanceAs(small)
+        assertThat(backend.configureCalls).isEqualTo(2)
+    }
+}
@@ -33,6 +33,26 @@ class NativeBridgeContractTest {
         assertThat(mockBridge.initialize()).isFalse()
     }
 
+    @Test
+    fun `NativeBridge initializeAsync defaults to initialize`() {
+        var started = false
+        val bridge = object : NativeBridge {
+            override fun initialize() = true.also { started = true }
+            override fun updateState(jsonState: String) {}
+            override fun setRenderMode(mode: Int) {}
+            override fun getFrameTiming() = FrameTiming()
+            override fun getVideoTextureId() = 0
+            override fun uploadCameraFrame(buffer: java.nio.ByteBuffer, width: Int, height: Int) {}
+            override fun shutdown() {}
+        }
+
+        var outcome: Boolean? = null
+        bridge.initializeAsync { outcome = it }
+
+        assertThat(started).isTrue()
+        assertThat(outcome).isTrue()
+    }
+
     @Test
     fun `NativeBridge updateState accepts JSON string`() {
         val state = LuminaState()
@@ -0,0 +1,80 @@
+package com.lumina.engine
+
+import com.google.common.truth.Truth.assertThat
+import java.nio.ByteBuffer
+import java.nio.ByteOrder
+import org.junit.Test
+
+/**
+ * Layout checks for the shared state block mirrored by lumina::SharedStateBlock
+ */
+class SharedStateLayoutTest {
+
+    private fun laidOutBlock(): ByteBuffer {
+        val buffer = ByteBuffer.allocateDirect(SharedStateLayout.SIZE).order(ByteOrder.nativeOrder())
+        buffer.putInt(0, SharedStateLayout.MAGIC)
+        buffer.putInt(4, SharedStateLayout.VERSION)
+        buffer.putInt(8, SharedStateLayout.SIZE)
+        return buffer
+    }
+
+    @Test
+    fun `isValid rejects blocks from another layout version`() {
+        val buffer = laidOutBlock()
+        assertThat(SharedStateLayout.isValid(buffer)).isTrue()
+        buffer.putInt(4, SharedStateLayout.VERSION + 1)
+        assertThat(SharedStateLayout.isValid(buffer)).isFalse()
+        assertThat(SharedStateLayout.isValid(ByteBuffer.allocateDirect(64))).isFalse()
+    }
+
+    @Test
+    fun `writeIntent places fields at native offsets`() {
+        val buffer = laidOutBlock()
+        val intent = AIIntent(action = "add_effect", target = "bloom", confidence = 0.85f, timestamp = 42L)
+        SharedStateLayout.writeIntent(buffer, SharedStateLayout.PENDING_INTENT, intent)
+
+        val record = SharedStateLayout.PENDING_INTENT
+        assertThat(buffer.get(record)).isEqualTo('a'.code.toByte())
+        assertThat(buffer.get(record + 10)).isEqualTo(0.toByte())
+        assertThat(buffer.get(record + 64)).isEqualTo('b'.code.toByte())
+        assertThat(buffer.getFloat(record + 704)).isEqualTo(0.85f)
+        assertThat(buffer.getInt(record + 708)).isEqualTo(42)
+        assertThat(SharedStateLayout.readIntent(buffer, record)).isEqualTo(intent)
+    }
+
+    @Test
+    fun `writeIntent truncates on character boundaries`() {
+        val buffer = laidOutBlock()
+        SharedStateLayout.writeIntent(buffer, SharedStateLayout.CURRENT_INTENT, AIIntent(action = "é".repeat(40)))
+
+        val action = SharedStateLayout.readIntent(buffer, SharedStateLayout.CURRENT_INTENT).action
+        assertThat(action).isEqualTo("é".repeat(31))
+    }
+
+    @Test
+    fun `readLatest follows the publish sequence`() {
+        val buffer = laidOutBlock()
+        assertThat(SharedStateLayout.readLatest(buffer)).isNull()
+
+        // Fourth publish wraps around to slot 0
+        val slot = 1536
+        val state = slot + 256
+        buffer.putInt(slot, 8)
+        buffer.putInt(state + 4, 17)
+        buffer.putInt(state + 16, RenderMode.DEPTH_MAP.value)
+        buffer.putInt(state + 20, 1920)
+        buffer.putInt(state + 464, 2)
+        buffer.put(state + 544, 'r'.code.toByte())
+        buffer.putInt(32, 4)
+
+        val snapshot = SharedStateLayout.readLatest(buffer)
+        assertThat(snapshot?.stateId).isEqualTo(17)
+        assertThat(snapshot?.renderMode).isEqualTo(RenderMode.DEPTH_MAP)
+        assertThat(snapshot?.width).isEqualTo(1920)
+        assertThat(snapshot?.activeEffectCount).isEqualTo(2)
+        assertThat(snapshot?.currentIntent?.action).isEqualTo("r")
+
+        buffer.putInt(slot, 9) // being rewritten
+        assertThat(SharedStateLayout.readLatest(buffer)).isNull()
+    }
+}
@@ -0,0 +1,48 @@
+package com.lumina.engine
+
+import com.google.common.truth.Truth.assertThat
+import org.junit.Test
+
+/**
+ * Layout checks for the binary packet mirrored by lumina::StatePacket
+ */
+class StatePacketTest {
+
+    @Test
+    fun `encode writes header and touch fields at native offsets`() {
+        val state = LuminaState(
+            renderMode = RenderMode.STYLIZED,
+            width = 1280,
+            height = 720,
+            touchPosition = Vec2(0.25f, 0.75f),
+            touchState = TouchState.MOVE
+        )
+        val buffer = StatePacket.encode(state, StatePacket.DIRTY_TOUCH, StatePacket.allocate())
+
+        assertThat(buffer.getInt(0)).isEqualTo(StatePacket.VERSION)
+        assertThat(buffer.getInt(4)).isEqualTo(StatePacket.DIRTY_TOUCH)
+        assertThat(buffer.getInt(8)).isEqualTo(RenderMode.STYLIZED.value)
+        assertThat(buffer.getInt(16)).isEqualTo(1280)
+        assertThat(buffer.getInt(24)).isEqualTo(TouchState.MOVE.value)
+        assertThat(buffer.getFloat(36)).isEqualTo(0.75f)
+    }
+
+    @Test
+    fun `encode packs effects with a 48 byte stride`() {
+        val effects = listOf(
+            EffectParams(type = EffectType.BLUR, intensity = 0.5f),
+            EffectParams(type = EffectType.VIGNETTE, scale = Vec2(2f, 3f)),
+            EffectParams(),
+            EffectParams()
+        )
+        val state = LuminaState(effects = effects, activeEffectCount = 2)
+        val buffer = StatePacket.encode(state, StatePacket.DIRTY_EFFECTS, StatePacket.allocate())
+
+        assertThat(buffer.getInt(48)).isEqualTo(2)
+        assertThat(buffer.getInt(64)).isEqualTo(EffectType.BLUR.value)
+        assertThat(buffer.getFloat(68)).isEqualTo(0.5f)
+        assertThat(buffer.getInt(64 + 48)).isEqualTo(EffectType.VIGNETTE.value)
+        assertThat(buffer.getFloat(64 + 48 + 44)).isEqualTo(3f)
+        assertThat(buffer.remaining()).isEqualTo(StatePacket.SIZE)
+    }
+}
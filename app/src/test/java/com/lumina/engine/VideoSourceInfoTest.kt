@@ -0,0 +1,26 @@
+package com.lumina.engine
+
+import com.google.common.truth.Truth.assertThat
+import org.junit.Test
+
+class VideoSourceInfoTest {
+
+    @Test
+    fun `fromInfo reads the native layout`() {
+        val info = LongArray(VideoSourceInfo.INFO_SIZE)
+        info[VideoSourceInfo.INFO_WIDTH] = 3840
+        info[VideoSourceInfo.INFO_HEIGHT] = 2160
+        info[VideoSourceInfo.INFO_DURATION] = 12_000_000
+        info[VideoSourceInfo.INFO_POSITION] = 4_500_000
+        info[VideoSourceInfo.INFO_PLAYING] = 1
+        info[VideoSourceInfo.INFO_ENDED] = 0
+
+        assertThat(VideoSourceInfo.fromInfo(info))
+            .isEqualTo(VideoSourceInfo(3840, 2160, 12_000_000, 4_500_000, playing = true, ended = false))
+    }
+
+    @Test(expected = IllegalArgumentException::class)
+    fun `fromInfo rejects a short array`() {
+        VideoSourceInfo.fromInfo(LongArray(VideoSourceInfo.INFO_SIZE - 1))
+    }
+}
@@ -30,6 +30,10 @@ from config import OrchestratorConfig  # type: ignore
 from intent_types import clamp_confidence  # type: ignore
 from classifiers import normalize_llm_result, merge_classifications, unknown_classification  # type: ignore
 from pipeline import classify_intent, extract_parameters, validate_intent, finalize_intent  # type: ignore
+import orchestrator as orchestrator_module  # type: ignore
+import shared_state  # type: ignore
+import struct
+import tempfile
 import cgi as cgi_shim  # type: ignore
 
 
@@ -985,5 +989,79 @@ class TestEdgeCases(unittest.TestCase):
         self.assertEqual(lower.target, upper.target)
 
 
+
+def _laid_out_block() -> bytearray:
+    """A block as SharedStateBlock::create() leaves it, with a little room to spare."""
+    data = bytearray(shared_state.SIZE + 64)
+    struct.pack_into("=3I", data, 0, shared_state.MAGIC, shared_state.VERSION, shared_state.SIZE)
+    return data
+
+
+class TestSharedState(unittest.TestCase):
+    """Tests for the shared state block layout mirrored from shared_state.h"""
+
+    def test_rejects_foreign_layouts(self):
+        data = _laid_out_block()
+        struct.pack_into("=I", data, 4, shared_state.VERSION + 1)
+        with self.assertRaises(ValueError):
+            shared_state.SharedStateBlock(data)
+        with self.assertRaises(ValueError):
+            shared_state.SharedStateBlock(bytearray(64))
+
+    def test_intent_round_trips_in_place(self):
+        block = shared_state.SharedStateBlock(_laid_out_block())
+        intent = AIIntent(action="add_effect", target="bloom", parameters='{"intensity": 0.7}',
+                          confidence=1.5, timestamp=(1 << 40) + 5)
+        block.write_intent(intent)
+
+        read = block.read_intent()
+        self.assertEqual(read.action, "add_effect")
+        self.assertEqual(read.parameters, '{"intensity": 0.7}')
+        self.assertEqual(read.confidence, 1.0)
+        self.assertEqual(read.timestamp, 5)
+        self.assertEqual(block.read_intent(shared_state.PENDING_INTENT).action, "")
+
+    def test_long_strings_are_cut_on_character_boundaries(self):
+        block = shared_state.SharedStateBlock(_laid_out_block())
+        block.write_intent(AIIntent(action="é" * 40))
+        action = block.read_intent().action
+        self.assertEqual(action, "é" * 31)  # 62 bytes, below the 64 byte field
+
+    def test_read_latest_follows_publish_sequence(self):
+        data = _laid_out_block()
+        block = shared_state.SharedStateBlock(data)
+        self.assertIsNone(block.read_latest())
+
+        # Second publish lands in slot 1: seq even, stateId 9, 1280x720
+        slot = 1536 + 2560
+        struct.pack_into("=I", data, slot, 2)
+        struct.pack_into("=7I", data, slot + 256, 1, 9, 2, 0, 1, 1280, 720)
+        struct.pack_into("=64s", data, slot + 256 + 544, b"reset")
+        struct.pack_into("=I", data, 32, 2)
+        latest = block.read_latest()
+        self.assertEqual(latest["stateId"], 9)
+        self.assertEqual(latest["width"], 1280)
+        self.assertEqual(latest["currentIntent"].action, "reset")
+
+        struct.pack_into("=I", data, slot, 3)  # mid-write
+        self.assertIsNone(block.read_latest())
+
+    def test_parse_intent_shared_writes_through_mapping(self):
+        with tempfile.TemporaryFile() as backing:
+            backing.write(bytes(_laid_out_block()[: shared_state.SIZE]))
+            backing.flush()
+            self.assertTrue(orchestrator_module.attach_shared_state(os.dup(backing.fileno())))
+            try:
+                self.assertTrue(orchestrator_module.parse_intent_shared("add blur"))
+                backing.seek(0)
+                view = shared_state.SharedStateBlock(bytearray(backing.read()))
+                self.assertEqual(view.read_intent().action, "add_effect")
+                self.assertEqual(view.read_intent().target, "blur")
+            finally:
+                orchestrator_module.shutdown()
+        with self.assertRaises(RuntimeError):
+            orchestrator_module.parse_intent_shared("add blur")
+
+
 if __name__ == '__main__':
     unittest.main()